@@ -0,0 +1,59 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+// Benchmarks of array allocations of a single thread.
+
+#include "benchmark.hpp"
+
+namespace
+{
+    // allocates count arrays and then deallocates them in the order given by Order
+    template <class Order, class Factory>
+    void array_benchmark(benchmark::State& state)
+    {
+        auto count      = static_cast<std::size_t>(state.range(0));
+        auto node_size  = static_cast<std::size_t>(state.range(1));
+        auto array_size = static_cast<std::size_t>(state.range(2));
+
+        auto               alloc = Factory::make(count * array_size, node_size);
+        auto               order = Order::get(count);
+        std::vector<void*> ptrs;
+        ptrs.reserve(count);
+        for (auto _ : state)
+        {
+            iteration_scope<typename Factory::type> scope(alloc);
+            using traits = memory::allocator_traits<
+                typename std::decay<decltype(scope.get())>::type>;
+
+            ptrs.clear();
+            for (std::size_t i = 0u; i != count; ++i)
+                ptrs.push_back(traits::allocate_array(scope.get(), array_size, node_size, 1u));
+            benchmark::ClobberMemory();
+
+            for (auto i : order)
+                traits::deallocate_array(scope.get(), ptrs[i], array_size, node_size, 1u);
+        }
+        set_throughput(state, count, node_size * array_size);
+    }
+
+    void array_arguments(benchmark::internal::Benchmark* b)
+    {
+        b->ArgNames({"count", "size", "array"})->ArgsProduct({{256, 512}, {1, 4, 8}, {1, 4, 8}});
+        add_percentiles(b);
+    }
+} // namespace
+
+// small_node_pool and the memory_pool_collection with it do not support arrays
+#define FOONATHAN_MEMORY_ARRAY_BENCHMARK(Order)                                                   \
+    BENCHMARK_TEMPLATE(array_benchmark, Order, heap)->Apply(array_arguments);                     \
+    BENCHMARK_TEMPLATE(array_benchmark, Order, new_)->Apply(array_arguments);                     \
+    BENCHMARK_TEMPLATE(array_benchmark, Order, node_pool)->Apply(array_arguments);                \
+    BENCHMARK_TEMPLATE(array_benchmark, Order, array_pool)->Apply(array_arguments);               \
+    BENCHMARK_TEMPLATE(array_benchmark, Order, bitmap_pool)->Apply(array_arguments);              \
+    BENCHMARK_TEMPLATE(array_benchmark, Order, stack)->Apply(array_arguments);                    \
+    BENCHMARK_TEMPLATE(array_benchmark, Order, iteration)->Apply(array_arguments);                \
+    BENCHMARK_TEMPLATE(array_benchmark, Order, temporary)->Apply(array_arguments)
+
+FOONATHAN_MEMORY_ARRAY_BENCHMARK(in_order);
+FOONATHAN_MEMORY_ARRAY_BENCHMARK(reversed);
+FOONATHAN_MEMORY_ARRAY_BENCHMARK(shuffled);
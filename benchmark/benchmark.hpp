@@ -0,0 +1,423 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_BENCHMARK_BENCHMARK_HPP_INCLUDED
+#define FOONATHAN_MEMORY_BENCHMARK_BENCHMARK_HPP_INCLUDED
+
+// Allocator factories and scenarios shared by all benchmarks.
+// Run with --benchmark_repetitions=N to get the percentiles
+// and with --benchmark_format=json or --benchmark_out=<file> for machine-readable results.
+
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/perf_event.h>)
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define FOONATHAN_MEMORY_BENCHMARK_PERF_EVENT 1
+#endif
+#endif
+
+#include "allocator_traits.hpp"
+#include "heap_allocator.hpp"
+#include "iteration_allocator.hpp"
+#include "memory_pool.hpp"
+#include "memory_pool_collection.hpp"
+#include "memory_stack.hpp"
+#include "new_allocator.hpp"
+#include "segregator.hpp"
+#include "temporary_allocator.hpp"
+
+namespace memory = foonathan::memory;
+
+//=== statistics ===//
+template <std::size_t Percent>
+double percentile(const std::vector<double>& samples)
+{
+    if (samples.empty())
+        return 0.0;
+
+    auto sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+    auto index = (sorted.size() - 1u) * Percent / 100u;
+    return sorted[index];
+}
+
+// adds percentiles to the statistics computed over the repetitions
+inline void add_percentiles(benchmark::internal::Benchmark* b)
+{
+    b->ComputeStatistics("p50", percentile<50>)
+        ->ComputeStatistics("p90", percentile<90>)
+        ->ComputeStatistics("p99", percentile<99>);
+}
+
+// reports allocations per second and bytes per second
+inline void set_throughput(benchmark::State& state, std::size_t count, std::size_t size)
+{
+    auto items = static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(count);
+    state.SetItemsProcessed(items);
+    state.SetBytesProcessed(items * static_cast<std::int64_t>(size));
+}
+
+//=== hardware counters ===//
+// counts the cache misses of the calling thread with perf_event_open(),
+// nothing is reported if it is not available, e.g. because of the perf_event_paranoid setting
+class cache_miss_counter
+{
+public:
+    cache_miss_counter() noexcept
+    {
+#if defined(FOONATHAN_MEMORY_BENCHMARK_PERF_EVENT)
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size           = sizeof(attr);
+        attr.type           = PERF_TYPE_HARDWARE;
+        attr.config         = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled       = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        fd_ = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~cache_miss_counter() noexcept
+    {
+#if defined(FOONATHAN_MEMORY_BENCHMARK_PERF_EVENT)
+        if (fd_ >= 0)
+            close(fd_);
+#endif
+    }
+
+    cache_miss_counter(const cache_miss_counter&)            = delete;
+    cache_miss_counter& operator=(const cache_miss_counter&) = delete;
+
+    void start() noexcept
+    {
+#if defined(FOONATHAN_MEMORY_BENCHMARK_PERF_EVENT)
+        if (fd_ >= 0)
+        {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    void stop() noexcept
+    {
+#if defined(FOONATHAN_MEMORY_BENCHMARK_PERF_EVENT)
+        if (fd_ >= 0)
+        {
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            std::uint64_t value = 0u;
+            if (read(fd_, &value, sizeof(value)) == ssize_t(sizeof(value)))
+                misses_ = value;
+        }
+#endif
+    }
+
+    // adds the cache misses per iteration to the counters of the benchmark
+    void report(benchmark::State& state) const
+    {
+#if defined(FOONATHAN_MEMORY_BENCHMARK_PERF_EVENT)
+        if (fd_ >= 0)
+            state.counters["cache_misses"] =
+                benchmark::Counter(double(misses_), benchmark::Counter::kAvgIterations);
+#else
+        (void)state;
+#endif
+    }
+
+private:
+#if defined(FOONATHAN_MEMORY_BENCHMARK_PERF_EVENT)
+    int           fd_     = -1;
+    std::uint64_t misses_ = 0u;
+#endif
+};
+
+//=== allocator factories ===//
+// each factory creates an allocator able to hold count nodes of the given size
+// memory_stack::min_block_size() and the like are not used,
+// as they would need to know the debug fences and alignment buffers
+constexpr std::size_t extra_memory = 1024u;
+
+struct heap
+{
+    using type = memory::heap_allocator;
+
+    static type make(std::size_t, std::size_t)
+    {
+        return {};
+    }
+};
+
+struct new_
+{
+    using type = memory::new_allocator;
+
+    static type make(std::size_t, std::size_t)
+    {
+        return {};
+    }
+};
+
+template <class PoolType>
+struct pool
+{
+    using type = memory::memory_pool<PoolType>;
+
+    static type make(std::size_t count, std::size_t size)
+    {
+        auto node_size = std::max(size, type::min_node_size);
+        return type(node_size, type::min_block_size(node_size, count) + extra_memory);
+    }
+};
+
+using small_pool  = pool<memory::small_node_pool>;
+using node_pool   = pool<memory::node_pool>;
+using array_pool  = pool<memory::array_pool>;
+using bitmap_pool = pool<memory::bitmap_array_pool>;
+
+struct stack
+{
+    using type = memory::memory_stack<>;
+
+    static type make(std::size_t count, std::size_t size)
+    {
+        return type(count * size + extra_memory);
+    }
+};
+
+struct collection
+{
+    using type = memory::memory_pool_collection<memory::node_pool, memory::identity_buckets>;
+
+    static type make(std::size_t count, std::size_t size)
+    {
+        return type(std::max(size, memory::detail::max_alignment),
+                    8u * (count * std::max(size, sizeof(void*)) + extra_memory));
+    }
+};
+
+// small nodes are taken from a pool, bigger ones from the heap
+struct segregator
+{
+    static constexpr std::size_t max_pool_size = 16u;
+
+    using type = memory::binary_segregator<
+        memory::threshold_segregatable<memory::memory_pool<memory::node_pool>>,
+        memory::heap_allocator>;
+
+    static type make(std::size_t count, std::size_t)
+    {
+        using pool_type = memory::memory_pool<memory::node_pool>;
+        return type(memory::threshold(max_pool_size,
+                                      pool_type(max_pool_size,
+                                                pool_type::min_block_size(max_pool_size, count)
+                                                    + extra_memory)),
+                    memory::heap_allocator{});
+    }
+};
+
+struct iteration
+{
+    using type = memory::iteration_allocator<2u>;
+
+    static type make(std::size_t count, std::size_t size)
+    {
+        return type(2u * (count * size + extra_memory));
+    }
+};
+
+// uses the temporary_stack of the thread
+struct temporary
+{
+    struct type
+    {
+    };
+
+    static type make(std::size_t, std::size_t)
+    {
+        return {};
+    }
+};
+
+//=== iteration scope ===//
+// gives access to the allocator used in one iteration of a scenario
+// and frees the memory of allocators that do not support real deallocation at the end
+template <class Allocator>
+class iteration_scope
+{
+public:
+    explicit iteration_scope(Allocator& alloc) noexcept : alloc_(alloc) {}
+
+    Allocator& get() noexcept
+    {
+        return alloc_;
+    }
+
+private:
+    Allocator& alloc_;
+};
+
+template <class BlockAllocator>
+class iteration_scope<memory::memory_stack<BlockAllocator>>
+{
+public:
+    explicit iteration_scope(memory::memory_stack<BlockAllocator>& stack) noexcept
+    : unwind_(stack)
+    {
+    }
+
+    memory::memory_stack<BlockAllocator>& get() noexcept
+    {
+        return unwind_.get_stack();
+    }
+
+private:
+    memory::memory_stack_raii_unwind<memory::memory_stack<BlockAllocator>> unwind_;
+};
+
+template <std::size_t N, class BlockAllocator>
+class iteration_scope<memory::iteration_allocator<N, BlockAllocator>>
+{
+public:
+    explicit iteration_scope(memory::iteration_allocator<N, BlockAllocator>& alloc) noexcept
+    : alloc_(alloc)
+    {
+    }
+
+    ~iteration_scope() noexcept
+    {
+        alloc_.next_iteration();
+    }
+
+    memory::iteration_allocator<N, BlockAllocator>& get() noexcept
+    {
+        return alloc_;
+    }
+
+private:
+    memory::iteration_allocator<N, BlockAllocator>& alloc_;
+};
+
+template <>
+class iteration_scope<temporary::type>
+{
+public:
+    explicit iteration_scope(temporary::type&) {}
+
+    memory::temporary_allocator& get() noexcept
+    {
+        return alloc_;
+    }
+
+private:
+    memory::temporary_allocator alloc_;
+};
+
+//=== scenarios ===//
+// the order in which the nodes are deallocated is computed outside of the measurement
+// with the same seed each time, so every allocator gets the same order
+struct in_order
+{
+    static std::vector<std::size_t> get(std::size_t count)
+    {
+        std::vector<std::size_t> order(count);
+        for (std::size_t i = 0u; i != count; ++i)
+            order[i] = i;
+        return order;
+    }
+};
+
+struct reversed
+{
+    static std::vector<std::size_t> get(std::size_t count)
+    {
+        auto order = in_order::get(count);
+        std::reverse(order.begin(), order.end());
+        return order;
+    }
+};
+
+struct shuffled
+{
+    static std::vector<std::size_t> get(std::size_t count)
+    {
+        auto order = in_order::get(count);
+        std::shuffle(order.begin(), order.end(), std::mt19937{});
+        return order;
+    }
+};
+
+// allocates and deallocates count nodes, one after the other
+struct single
+{
+    using order = in_order;
+
+    template <class RawAllocator>
+    static void run(RawAllocator& alloc, std::vector<void*>&,
+                    const std::vector<std::size_t>& order, std::size_t size)
+    {
+        using traits = memory::allocator_traits<RawAllocator>;
+        for (std::size_t i = 0u; i != order.size(); ++i)
+        {
+            auto ptr = traits::allocate_node(alloc, size, 1u);
+            benchmark::DoNotOptimize(ptr);
+            traits::deallocate_node(alloc, ptr, size, 1u);
+        }
+    }
+};
+
+// allocates count nodes and then deallocates them in the given order
+template <class Order>
+struct basic_bulk
+{
+    using order = Order;
+
+    template <class RawAllocator>
+    static void run(RawAllocator& alloc, std::vector<void*>& ptrs,
+                    const std::vector<std::size_t>& order, std::size_t size)
+    {
+        using traits = memory::allocator_traits<RawAllocator>;
+
+        ptrs.clear();
+        for (std::size_t i = 0u; i != order.size(); ++i)
+            ptrs.push_back(traits::allocate_node(alloc, size, 1u));
+        benchmark::ClobberMemory();
+
+        for (auto i : order)
+            traits::deallocate_node(alloc, ptrs[i], size, 1u);
+    }
+};
+
+using bulk          = basic_bulk<in_order>;
+using bulk_reversed = basic_bulk<reversed>;
+using butterfly     = basic_bulk<shuffled>;
+
+// runs a node scenario, range(0) is the number of nodes and range(1) their size
+template <class Scenario, class Factory>
+void node_benchmark(benchmark::State& state)
+{
+    auto count = static_cast<std::size_t>(state.range(0));
+    auto size  = static_cast<std::size_t>(state.range(1));
+
+    auto               alloc = Factory::make(count, size);
+    auto               order = Scenario::order::get(count);
+    std::vector<void*> ptrs;
+    ptrs.reserve(count);
+    for (auto _ : state)
+    {
+        iteration_scope<typename Factory::type> scope(alloc);
+        Scenario::run(scope.get(), ptrs, order, size);
+    }
+    set_throughput(state, count, size);
+}
+
+#endif // FOONATHAN_MEMORY_BENCHMARK_BENCHMARK_HPP_INCLUDED
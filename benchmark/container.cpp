@@ -0,0 +1,400 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+// Benchmarks of the container aliases using std_allocator.
+
+#include "benchmark.hpp"
+
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+#include "container.hpp"
+#include "flat_hash_map.hpp"
+#include "flat_map.hpp"
+#include "smart_ptr.hpp"
+
+namespace
+{
+    struct vector
+    {
+        template <class RawAllocator>
+        using type = memory::vector<int, RawAllocator>;
+
+        // nodes are arrays of different sizes
+        static constexpr std::size_t node_size = sizeof(int);
+
+        template <class Container>
+        static void insert(Container& c, int i)
+        {
+            c.push_back(i);
+        }
+    };
+
+    struct list
+    {
+        template <class RawAllocator>
+        using type = memory::list<int, RawAllocator>;
+
+        static constexpr std::size_t node_size = memory::list_node_size<int>::value;
+
+        template <class Container>
+        static void insert(Container& c, int i)
+        {
+            c.push_back(i);
+        }
+    };
+
+    struct set
+    {
+        template <class RawAllocator>
+        using type = memory::set<int, RawAllocator>;
+
+        static constexpr std::size_t node_size = memory::set_node_size<int>::value;
+
+        template <class Container>
+        static void insert(Container& c, int i)
+        {
+            c.insert(i);
+        }
+    };
+
+    struct unordered_set
+    {
+        template <class RawAllocator>
+        using type = memory::unordered_set<int, RawAllocator>;
+
+        static constexpr std::size_t node_size = memory::unordered_set_node_size<int>::value;
+
+        template <class Container>
+        static void insert(Container& c, int i)
+        {
+            c.insert(i);
+        }
+    };
+
+    // inserts count elements into a container, range(0) is the number of elements
+    template <class Container, class Factory>
+    void container_benchmark(benchmark::State& state)
+    {
+        auto count = static_cast<std::size_t>(state.range(0));
+
+        // vector reallocations need up to twice the memory
+        auto alloc = Factory::make(2u * count, Container::node_size);
+        for (auto _ : state)
+        {
+            iteration_scope<typename Factory::type> scope(alloc);
+            using allocator_type = typename std::decay<decltype(scope.get())>::type;
+
+            typename Container::template type<allocator_type> c(scope.get());
+            for (std::size_t i = 0u; i != count; ++i)
+                Container::insert(c, static_cast<int>(i));
+            benchmark::DoNotOptimize(c);
+        }
+        set_throughput(state, count, Container::node_size);
+    }
+
+    void container_arguments(benchmark::internal::Benchmark* b)
+    {
+        b->ArgName("count")->Arg(256)->Arg(4096);
+        add_percentiles(b);
+    }
+
+    //=== workloads ===//
+    // each workload inserts the keys, looks all of them up, erases half of them
+    // and inserts them again, std_type uses the default std::allocator for comparison
+    struct map_workload
+    {
+        template <class RawAllocator>
+        using type = memory::map<int, int, RawAllocator>;
+        using std_type = std::map<int, int>;
+
+        static constexpr std::size_t node_size =
+            memory::map_node_size<std::pair<const int, int>>::value;
+
+        template <class Container>
+        static void run(Container& c, const std::vector<int>& keys)
+        {
+            for (auto key : keys)
+                c.emplace(key, key);
+            for (auto key : keys)
+                benchmark::DoNotOptimize(c.find(key));
+            for (auto key : keys)
+                if (key % 2 == 0)
+                    c.erase(key);
+            for (auto key : keys)
+                if (key % 2 == 0)
+                    c.emplace(key, key);
+        }
+    };
+
+    struct unordered_map_workload
+    {
+        template <class RawAllocator>
+        using type = memory::unordered_map<int, int, RawAllocator>;
+        using std_type = std::unordered_map<int, int>;
+
+        static constexpr std::size_t node_size =
+            memory::unordered_map_node_size<std::pair<const int, int>>::value;
+
+        template <class Container>
+        static void run(Container& c, const std::vector<int>& keys)
+        {
+            map_workload::run(c, keys);
+        }
+    };
+
+    // the contiguous containers have no std counterpart, so no std_type
+    struct flat_map_workload
+    {
+        template <class RawAllocator>
+        using type = memory::flat_map<int, int, RawAllocator>;
+
+        // nodes are arrays of different sizes
+        static constexpr std::size_t node_size = sizeof(std::pair<int, int>);
+
+        template <class Container>
+        static void run(Container& c, const std::vector<int>& keys)
+        {
+            map_workload::run(c, keys);
+        }
+    };
+
+    struct flat_hash_map_workload
+    {
+        template <class RawAllocator>
+        using type = memory::flat_hash_map<int, int, RawAllocator>;
+
+        // the slots and a byte of the hash each
+        static constexpr std::size_t node_size = sizeof(std::pair<int, int>) + 1u;
+
+        template <class Container>
+        static void run(Container& c, const std::vector<int>& keys)
+        {
+            map_workload::run(c, keys);
+        }
+    };
+
+    // the lookup is a traversal and every other element is erased
+    struct list_workload
+    {
+        template <class RawAllocator>
+        using type = memory::list<int, RawAllocator>;
+        using std_type = std::list<int>;
+
+        static constexpr std::size_t node_size = memory::list_node_size<int>::value;
+
+        template <class Container>
+        static void run(Container& c, const std::vector<int>& keys)
+        {
+            for (auto key : keys)
+                c.push_back(key);
+            auto sum = 0ll;
+            for (auto value : c)
+                sum += value;
+            benchmark::DoNotOptimize(sum);
+            for (auto iter = c.begin(); iter != c.end();)
+            {
+                iter = c.erase(iter);
+                if (iter != c.end())
+                    ++iter;
+            }
+            for (auto key : keys)
+                if (key % 2 == 0)
+                    c.push_front(key);
+        }
+    };
+
+    // the lookups are random accesses and the erasure removes all even keys at once
+    struct vector_workload
+    {
+        template <class RawAllocator>
+        using type = memory::vector<int, RawAllocator>;
+        using std_type = std::vector<int>;
+
+        // nodes are arrays of different sizes
+        static constexpr std::size_t node_size = sizeof(int);
+
+        template <class Container>
+        static void run(Container& c, const std::vector<int>& keys)
+        {
+            for (auto key : keys)
+                c.push_back(key);
+            auto sum = 0ll;
+            for (auto key : keys)
+                sum += c[static_cast<std::size_t>(key)];
+            benchmark::DoNotOptimize(sum);
+            c.erase(std::remove_if(c.begin(), c.end(), [](int value) { return value % 2 == 0; }),
+                    c.end());
+            for (auto key : keys)
+                if (key % 2 == 0)
+                    c.push_back(key);
+        }
+    };
+
+    // creates a shared pointer for each key and releases half of them
+    struct shared_ptr_workload
+    {
+        template <class RawAllocator>
+        class type
+        {
+        public:
+            explicit type(RawAllocator& alloc) : alloc_(&alloc) {}
+
+            std::shared_ptr<int> make(int value)
+            {
+                return memory::allocate_shared<int>(*alloc_, value);
+            }
+
+            std::vector<std::shared_ptr<int>> ptrs;
+
+        private:
+            RawAllocator* alloc_;
+        };
+
+        struct std_type
+        {
+            std::shared_ptr<int> make(int value)
+            {
+                return std::make_shared<int>(value);
+            }
+
+            std::vector<std::shared_ptr<int>> ptrs;
+        };
+
+        // the biggest node size, a stateful allocator stores a pointer in the control block
+        static constexpr std::size_t node_size =
+            memory::allocate_shared_node_size<int, memory::memory_pool<>>::value;
+
+        template <class Container>
+        static void run(Container& c, const std::vector<int>& keys)
+        {
+            c.ptrs.reserve(keys.size());
+            for (auto key : keys)
+                c.ptrs.push_back(c.make(key));
+            auto sum = 0ll;
+            for (auto key : keys)
+                sum += *c.ptrs[static_cast<std::size_t>(key)];
+            benchmark::DoNotOptimize(sum);
+            for (auto& ptr : c.ptrs)
+                if (*ptr % 2 == 0)
+                    ptr.reset();
+            for (auto& ptr : c.ptrs)
+                if (!ptr)
+                    ptr = c.make(0);
+        }
+    };
+
+    // uses the default std::allocator of each container
+    struct std_default
+    {
+        struct type
+        {
+        };
+
+        static type make(std::size_t, std::size_t)
+        {
+            return {};
+        }
+    };
+
+    template <class Workload, class RawAllocator>
+    void run_workload(RawAllocator& alloc, const std::vector<int>& keys)
+    {
+        typename Workload::template type<RawAllocator> c(alloc);
+        Workload::run(c, keys);
+        benchmark::DoNotOptimize(c);
+    }
+
+    template <class Workload>
+    void run_workload(std_default::type&, const std::vector<int>& keys)
+    {
+        typename Workload::std_type c;
+        Workload::run(c, keys);
+        benchmark::DoNotOptimize(c);
+    }
+
+    // runs a workload on count shuffled keys, range(0) is the number of keys
+    // the cache misses are reported if the hardware counter is available
+    template <class Workload, class Factory>
+    void workload_benchmark(benchmark::State& state)
+    {
+        auto count = static_cast<std::size_t>(state.range(0));
+
+        std::vector<int> keys(count);
+        for (std::size_t i = 0u; i != count; ++i)
+            keys[i] = static_cast<int>(i);
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(count));
+
+        // the reinserted keys need up to a third more memory
+        auto               alloc = Factory::make(3u * count, Workload::node_size);
+        cache_miss_counter misses;
+        misses.start();
+        for (auto _ : state)
+        {
+            iteration_scope<typename Factory::type> scope(alloc);
+            run_workload<Workload>(scope.get(), keys);
+        }
+        misses.stop();
+        misses.report(state);
+        set_throughput(state, count, Workload::node_size);
+    }
+} // namespace
+
+// the pools are only used for node-based containers, their node size is fixed
+#define FOONATHAN_MEMORY_CONTAINER_BENCHMARK(Container, Factory)                                  \
+    BENCHMARK_TEMPLATE(container_benchmark, Container, Factory)->Apply(container_arguments)
+
+FOONATHAN_MEMORY_CONTAINER_BENCHMARK(vector, heap);
+FOONATHAN_MEMORY_CONTAINER_BENCHMARK(vector, stack);
+FOONATHAN_MEMORY_CONTAINER_BENCHMARK(vector, temporary);
+
+FOONATHAN_MEMORY_CONTAINER_BENCHMARK(list, heap);
+FOONATHAN_MEMORY_CONTAINER_BENCHMARK(list, node_pool);
+FOONATHAN_MEMORY_CONTAINER_BENCHMARK(list, stack);
+FOONATHAN_MEMORY_CONTAINER_BENCHMARK(list, collection);
+
+FOONATHAN_MEMORY_CONTAINER_BENCHMARK(set, heap);
+FOONATHAN_MEMORY_CONTAINER_BENCHMARK(set, node_pool);
+FOONATHAN_MEMORY_CONTAINER_BENCHMARK(set, stack);
+FOONATHAN_MEMORY_CONTAINER_BENCHMARK(set, collection);
+
+FOONATHAN_MEMORY_CONTAINER_BENCHMARK(unordered_set, heap);
+FOONATHAN_MEMORY_CONTAINER_BENCHMARK(unordered_set, stack);
+
+// the bucket arrays of unordered_map and the arrays of vector and the flat containers
+// need a heap or stack
+#define FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(Workload, Factory)                                    \
+    BENCHMARK_TEMPLATE(workload_benchmark, Workload, Factory)->Apply(container_arguments)
+
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(map_workload, std_default);
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(map_workload, heap);
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(map_workload, node_pool);
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(map_workload, collection);
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(map_workload, stack);
+
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(unordered_map_workload, std_default);
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(unordered_map_workload, heap);
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(unordered_map_workload, stack);
+
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(flat_map_workload, heap);
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(flat_map_workload, stack);
+
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(flat_hash_map_workload, heap);
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(flat_hash_map_workload, stack);
+
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(list_workload, std_default);
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(list_workload, heap);
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(list_workload, node_pool);
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(list_workload, collection);
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(list_workload, stack);
+
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(vector_workload, std_default);
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(vector_workload, heap);
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(vector_workload, stack);
+
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(shared_ptr_workload, std_default);
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(shared_ptr_workload, heap);
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(shared_ptr_workload, node_pool);
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(shared_ptr_workload, collection);
+FOONATHAN_MEMORY_WORKLOAD_BENCHMARK(shared_ptr_workload, stack);
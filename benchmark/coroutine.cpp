@@ -0,0 +1,132 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+// Benchmarks of coroutine frames allocated by coroutine_frame_allocator against operator new.
+
+#include "benchmark.hpp"
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+
+#include <coroutine>
+
+#include "coroutine_allocator.hpp"
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+// false positive for the placement operator new of coroutine_frame_allocator
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace
+{
+    // the frames of the coroutines below are a lot smaller
+    constexpr std::size_t max_frame_size = 256u;
+
+    // frames are allocated by the global operator new
+    struct global_new
+    {
+        template <class RawAllocator>
+        struct promise
+        {
+        };
+    };
+
+    struct frame_allocator
+    {
+        template <class RawAllocator>
+        using promise = memory::coroutine_frame_allocator<RawAllocator>;
+    };
+
+    struct any_frame_allocator
+    {
+        template <class RawAllocator>
+        using promise = memory::coroutine_frame_allocator<>;
+    };
+
+    template <class Base>
+    struct task
+    {
+        struct promise_type : Base
+        {
+            task get_return_object() noexcept
+            {
+                return {std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            std::suspend_always initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            std::suspend_always final_suspend() noexcept
+            {
+                return {};
+            }
+
+            void return_value(std::size_t v) noexcept
+            {
+                value = v;
+            }
+
+            void unhandled_exception() noexcept {}
+
+            std::size_t value = 0u;
+        };
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    // a short-lived coroutine like the handler of a request
+    template <class Base, class RawAllocator>
+    task<Base> handle_request(std::allocator_arg_t, RawAllocator&, std::size_t request)
+    {
+        co_return request * 2u;
+    }
+
+    // creates range(0) coroutines, then runs and destroys them,
+    // so that many frames are alive at the same time
+    template <class Promise, class Factory>
+    void coroutine_benchmark(benchmark::State& state)
+    {
+        using allocator_type = typename Factory::type;
+        using base           = typename Promise::template promise<allocator_type>;
+        using handle_type    = std::coroutine_handle<typename task<base>::promise_type>;
+
+        auto count = static_cast<std::size_t>(state.range(0));
+        auto alloc = Factory::make(count, max_frame_size);
+
+        std::vector<handle_type> handles;
+        handles.reserve(count);
+        for (auto _ : state)
+        {
+            iteration_scope<allocator_type> scope(alloc);
+            for (std::size_t i = 0u; i != count; ++i)
+                handles.push_back(handle_request<base>(std::allocator_arg, scope.get(), i).handle);
+            for (auto handle : handles)
+            {
+                handle.resume();
+                benchmark::DoNotOptimize(handle.promise().value);
+                handle.destroy();
+            }
+            handles.clear();
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations())
+                                * static_cast<std::int64_t>(count));
+    }
+
+    void coroutine_arguments(benchmark::internal::Benchmark* b)
+    {
+        b->ArgNames({"count"})->Arg(256)->Arg(4096);
+        add_percentiles(b);
+    }
+} // namespace
+
+BENCHMARK_TEMPLATE(coroutine_benchmark, global_new, heap)->Apply(coroutine_arguments);
+BENCHMARK_TEMPLATE(coroutine_benchmark, frame_allocator, collection)->Apply(coroutine_arguments);
+BENCHMARK_TEMPLATE(coroutine_benchmark, frame_allocator, stack)->Apply(coroutine_arguments);
+BENCHMARK_TEMPLATE(coroutine_benchmark, any_frame_allocator, collection)
+    ->Apply(coroutine_arguments);
+BENCHMARK_TEMPLATE(coroutine_benchmark, any_frame_allocator, stack)->Apply(coroutine_arguments);
+
+#endif
+#endif
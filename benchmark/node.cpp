@@ -0,0 +1,44 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+// Benchmarks of node allocations of a single thread.
+
+#include "benchmark.hpp"
+
+namespace
+{
+    void node_arguments(benchmark::internal::Benchmark* b)
+    {
+        b->ArgNames({"count", "size"})->ArgsProduct({{256, 1024}, {1, 8, 64, 256}});
+        add_percentiles(b);
+    }
+
+    // enough nodes that a pool does not fit into the cache,
+    // after the first butterfly iteration its free list is scattered as after churn
+    void large_node_arguments(benchmark::internal::Benchmark* b)
+    {
+        b->ArgNames({"count", "size"})->ArgsProduct({{1 << 16}, {8, 64}});
+        add_percentiles(b);
+    }
+} // namespace
+
+#define FOONATHAN_MEMORY_NODE_BENCHMARK(Scenario)                                                 \
+    BENCHMARK_TEMPLATE(node_benchmark, Scenario, heap)->Apply(node_arguments);                    \
+    BENCHMARK_TEMPLATE(node_benchmark, Scenario, new_)->Apply(node_arguments);                    \
+    BENCHMARK_TEMPLATE(node_benchmark, Scenario, small_pool)->Apply(node_arguments);              \
+    BENCHMARK_TEMPLATE(node_benchmark, Scenario, node_pool)->Apply(node_arguments);               \
+    BENCHMARK_TEMPLATE(node_benchmark, Scenario, array_pool)->Apply(node_arguments);              \
+    BENCHMARK_TEMPLATE(node_benchmark, Scenario, stack)->Apply(node_arguments);                   \
+    BENCHMARK_TEMPLATE(node_benchmark, Scenario, collection)->Apply(node_arguments);              \
+    BENCHMARK_TEMPLATE(node_benchmark, Scenario, segregator)->Apply(node_arguments);              \
+    BENCHMARK_TEMPLATE(node_benchmark, Scenario, iteration)->Apply(node_arguments);               \
+    BENCHMARK_TEMPLATE(node_benchmark, Scenario, temporary)->Apply(node_arguments)
+
+FOONATHAN_MEMORY_NODE_BENCHMARK(single);
+FOONATHAN_MEMORY_NODE_BENCHMARK(bulk);
+FOONATHAN_MEMORY_NODE_BENCHMARK(bulk_reversed);
+FOONATHAN_MEMORY_NODE_BENCHMARK(butterfly);
+
+BENCHMARK_TEMPLATE(node_benchmark, bulk, node_pool)->Apply(large_node_arguments);
+BENCHMARK_TEMPLATE(node_benchmark, butterfly, node_pool)->Apply(large_node_arguments);
+BENCHMARK_TEMPLATE(node_benchmark, butterfly, array_pool)->Apply(large_node_arguments);
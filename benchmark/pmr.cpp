@@ -0,0 +1,142 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+// Benchmarks of the memory resources against the ones of the standard library.
+
+#include "benchmark.hpp"
+
+#include <memory>
+
+#include "memory_resources.hpp"
+
+namespace
+{
+    // allocates through the virtual interface of a memory resource it owns,
+    // monotonic resources free all memory at the end of each iteration
+    template <class Resource, bool Monotonic>
+    class resource_allocator
+    {
+    public:
+        using is_stateful = std::true_type;
+
+        template <typename... Args>
+        explicit resource_allocator(Args&&... args)
+        : resource_(new Resource(std::forward<Args>(args)...))
+        {
+        }
+
+        void* allocate_node(std::size_t size, std::size_t alignment)
+        {
+            return get().allocate(size, alignment);
+        }
+
+        void deallocate_node(void* node, std::size_t size, std::size_t alignment) noexcept
+        {
+            get().deallocate(node, size, alignment);
+        }
+
+        void release() noexcept
+        {
+            resource_->release();
+        }
+
+    private:
+        memory::memory_resource& get() noexcept
+        {
+            return *resource_;
+        }
+
+        std::unique_ptr<Resource> resource_;
+    };
+
+    constexpr std::size_t max_pool_size = 256u;
+
+    struct pool_resource
+    {
+        using type = resource_allocator<memory::pool_resource<>, false>;
+
+        static type make(std::size_t count, std::size_t size)
+        {
+            return type(max_pool_size, 4u * count * std::max(size, sizeof(void*)) + extra_memory);
+        }
+    };
+
+    struct monotonic_resource
+    {
+        using type = resource_allocator<memory::monotonic_resource<>, true>;
+
+        static type make(std::size_t count, std::size_t size)
+        {
+            return type(2u * count * std::max(size, sizeof(void*)) + extra_memory);
+        }
+    };
+
+#if defined(__cpp_lib_memory_resource)
+    struct std_pool_resource
+    {
+        using type = resource_allocator<std::pmr::unsynchronized_pool_resource, false>;
+
+        static type make(std::size_t, std::size_t)
+        {
+            std::pmr::pool_options options;
+            options.largest_required_pool_block = max_pool_size;
+            return type(options);
+        }
+    };
+
+    struct std_monotonic_resource
+    {
+        using type = resource_allocator<std::pmr::monotonic_buffer_resource, true>;
+
+        static type make(std::size_t count, std::size_t size)
+        {
+            return type(2u * count * std::max(size, sizeof(void*)) + extra_memory);
+        }
+    };
+#endif
+
+    void resource_arguments(benchmark::internal::Benchmark* b)
+    {
+        b->ArgNames({"count", "size"})->ArgsProduct({{256, 1024}, {8, 64, 256}});
+        add_percentiles(b);
+    }
+} // namespace
+
+template <class Resource>
+class iteration_scope<resource_allocator<Resource, true>>
+{
+public:
+    explicit iteration_scope(resource_allocator<Resource, true>& alloc) noexcept : alloc_(alloc)
+    {
+    }
+
+    ~iteration_scope() noexcept
+    {
+        alloc_.release();
+    }
+
+    resource_allocator<Resource, true>& get() noexcept
+    {
+        return alloc_;
+    }
+
+private:
+    resource_allocator<Resource, true>& alloc_;
+};
+
+#define FOONATHAN_MEMORY_RESOURCE_BENCHMARK(Scenario, Resource)                                    \
+    BENCHMARK_TEMPLATE(node_benchmark, Scenario, Resource)->Apply(resource_arguments)
+
+FOONATHAN_MEMORY_RESOURCE_BENCHMARK(single, pool_resource);
+FOONATHAN_MEMORY_RESOURCE_BENCHMARK(bulk, pool_resource);
+FOONATHAN_MEMORY_RESOURCE_BENCHMARK(butterfly, pool_resource);
+FOONATHAN_MEMORY_RESOURCE_BENCHMARK(single, monotonic_resource);
+FOONATHAN_MEMORY_RESOURCE_BENCHMARK(bulk, monotonic_resource);
+
+#if defined(__cpp_lib_memory_resource)
+FOONATHAN_MEMORY_RESOURCE_BENCHMARK(single, std_pool_resource);
+FOONATHAN_MEMORY_RESOURCE_BENCHMARK(bulk, std_pool_resource);
+FOONATHAN_MEMORY_RESOURCE_BENCHMARK(butterfly, std_pool_resource);
+FOONATHAN_MEMORY_RESOURCE_BENCHMARK(single, std_monotonic_resource);
+FOONATHAN_MEMORY_RESOURCE_BENCHMARK(bulk, std_monotonic_resource);
+#endif
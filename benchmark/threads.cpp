@@ -0,0 +1,108 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+// Benchmarks of node allocations of multiple threads sharing one allocator.
+
+#include "benchmark.hpp"
+
+#include <memory>
+#include <mutex>
+
+#include "allocator_storage.hpp"
+#include "thread_cached_pool.hpp"
+
+namespace
+{
+    // the shared allocator is created on the heap, as the synchronized ones cannot be moved
+    struct shared_heap
+    {
+        using type = memory::heap_allocator;
+
+        static std::unique_ptr<type> make(std::size_t, std::size_t)
+        {
+            return std::unique_ptr<type>(new type());
+        }
+    };
+
+    template <class Mutex>
+    struct locked_pool
+    {
+        using type =
+            memory::thread_safe_allocator<memory::memory_pool<memory::node_pool>, Mutex>;
+
+        static std::unique_ptr<type> make(std::size_t count, std::size_t size)
+        {
+            return std::unique_ptr<type>(new type(node_pool::make(count, size)));
+        }
+    };
+
+    struct concurrent_pool
+    {
+        using type = memory::memory_pool<memory::concurrent_node_pool>;
+
+        static std::unique_ptr<type> make(std::size_t count, std::size_t size)
+        {
+            auto node_size = std::max(size, type::min_node_size);
+            return std::unique_ptr<type>(
+                new type(node_size, type::min_block_size(node_size, count) + extra_memory));
+        }
+    };
+
+    struct cached_pool
+    {
+        using type = memory::thread_cached_pool<memory::node_pool>;
+
+        static std::unique_ptr<type> make(std::size_t count, std::size_t size)
+        {
+            auto node_size = std::max(size, memory::memory_pool<>::min_node_size);
+            return std::unique_ptr<type>(
+                new type(node_size, type::min_block_size(node_size, count) + extra_memory));
+        }
+    };
+
+    // runs a node scenario on each thread with an allocator shared between the threads,
+    // range(0) is the number of nodes per thread and range(1) their size
+    template <class Scenario, class Factory>
+    void thread_benchmark(benchmark::State& state)
+    {
+        static std::unique_ptr<typename Factory::type> alloc;
+
+        auto count = static_cast<std::size_t>(state.range(0));
+        auto size  = static_cast<std::size_t>(state.range(1));
+        if (state.thread_index() == 0)
+            alloc = Factory::make(count * static_cast<std::size_t>(state.threads()), size);
+
+        auto               order = Scenario::order::get(count);
+        std::vector<void*> ptrs;
+        ptrs.reserve(count);
+        // the threads start and stop the loop together
+        for (auto _ : state)
+            Scenario::run(*alloc, ptrs, order, size);
+        set_throughput(state, count, size);
+
+        if (state.thread_index() == 0)
+            alloc.reset();
+    }
+
+    void thread_arguments(benchmark::internal::Benchmark* b)
+    {
+        b->ArgNames({"count", "size"})->ArgsProduct({{256, 1024}, {8, 64}});
+        b->ThreadRange(1, 8)->UseRealTime();
+        add_percentiles(b);
+    }
+} // namespace
+
+#define FOONATHAN_MEMORY_THREAD_BENCHMARK(Scenario)                                               \
+    BENCHMARK_TEMPLATE(thread_benchmark, Scenario, shared_heap)->Apply(thread_arguments);         \
+    BENCHMARK_TEMPLATE(thread_benchmark, Scenario, locked_pool<std::mutex>)                       \
+        ->Apply(thread_arguments);                                                                \
+    BENCHMARK_TEMPLATE(thread_benchmark, Scenario, locked_pool<memory::spin_mutex>)               \
+        ->Apply(thread_arguments);                                                                \
+    BENCHMARK_TEMPLATE(thread_benchmark, Scenario, locked_pool<memory::adaptive_mutex>)           \
+        ->Apply(thread_arguments);                                                                \
+    BENCHMARK_TEMPLATE(thread_benchmark, Scenario, concurrent_pool)->Apply(thread_arguments);     \
+    BENCHMARK_TEMPLATE(thread_benchmark, Scenario, cached_pool)->Apply(thread_arguments)
+
+FOONATHAN_MEMORY_THREAD_BENCHMARK(single);
+FOONATHAN_MEMORY_THREAD_BENCHMARK(bulk);
+FOONATHAN_MEMORY_THREAD_BENCHMARK(butterfly);
@@ -3,10 +3,14 @@ include(CheckCXXSourceCompiles)
 function(check_cxx_atomic_compiles varname)
 	check_cxx_source_compiles("
 	#include <atomic>
+	#include <cstdint>
+	struct tagged { void* ptr; std::uintptr_t tag; };
 	std::atomic<bool> x;
+	std::atomic<tagged> t;
 	int main() {
 		bool y = false;
-		return !x.compare_exchange_strong(y, true);
+		tagged z = t.load();
+		return !x.compare_exchange_strong(y, true) || !t.compare_exchange_strong(z, tagged{nullptr, 1u});
 	}" ${varname})
 endfunction()
 function(check_working_cxx_atomic varname)
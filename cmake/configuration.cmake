@@ -17,6 +17,7 @@ set(build_tools 1)
 option(FOONATHAN_MEMORY_BUILD_EXAMPLES "whether or not to build the examples" ${build_examples_tests})
 option(FOONATHAN_MEMORY_BUILD_TESTS "whether or not to build the tests" ${build_examples_tests})
 option(FOONATHAN_MEMORY_BUILD_TOOLS "whether or not to build the tools" ${build_tools})
+option(FOONATHAN_MEMORY_BUILD_BENCHMARKS "whether or not to build the benchmarks" OFF)
 
 # debug options, pre-set by build type
 if("${CMAKE_BUILD_TYPE}" STREQUAL "Debug")
@@ -54,12 +55,21 @@ else()
     option(FOONATHAN_MEMORY_DEBUG_DOUBLE_DEALLOC_CHECK
             "whether or not the (sometimes expensive) check for double deallocation is active" OFF)
 endif()
+option(FOONATHAN_MEMORY_DEBUG_POISON
+        "whether or not memory not handed out by the allocators is poisoned for AddressSanitizer and Valgrind" OFF)
+option(FOONATHAN_MEMORY_TRACEPOINTS
+        "whether or not the slow paths of the allocators have USDT probes for perf, bpftrace and SystemTap" OFF)
 
 # other options
 option(FOONATHAN_MEMORY_CHECK_ALLOCATION_SIZE
         "whether or not the size of the allocation will be checked" ON)
 set(FOONATHAN_MEMORY_DEFAULT_ALLOCATOR heap_allocator CACHE STRING
     "the default implementation allocator for higher-level ones")
+set(FOONATHAN_MEMORY_HEAP_BACKEND system CACHE STRING
+    "the allocator used by heap_allocator, one of system, jemalloc, mimalloc or tcmalloc")
+set_property(CACHE FOONATHAN_MEMORY_HEAP_BACKEND PROPERTY STRINGS system jemalloc mimalloc tcmalloc)
+option(FOONATHAN_MEMORY_BUILTIN_NODE_SIZES
+    "whether or not the container node sizes are computed from the standard library node types if supported" ON)
 option(FOONATHAN_MEMORY_EXTERN_TEMPLATE
     "whether or not common template instantiations are already provided by the library" ON)
 set(FOONATHAN_MEMORY_TEMPORARY_STACK_MODE 2 CACHE STRING
@@ -193,3 +193,23 @@ struct ${container}_node_size
     # The only variable that will be substituted is NODE_SIZE_CONTENTS
     configure_file("${_THIS_MODULE_DIR}/container_node_sizes_impl.hpp.in" ${outfile})
 endfunction()
+
+# This function will check whether the node sizes can be computed
+# from the node types of the standard library at compile-time,
+# so they don't need to be generated by get_container_node_sizes().
+#
+# See container_node_sizes_builtin.hpp for the supported standard libraries.
+function(has_builtin_container_node_sizes result_var)
+    try_compile(builtin_result ${CMAKE_CURRENT_BINARY_DIR} ${_THIS_MODULE_DIR}/has_builtin_node_sizes.cpp
+	COMPILE_DEFINITIONS "-I${_THIS_MODULE_DIR}/../include"
+	OUTPUT_VARIABLE builtin_output
+	CXX_STANDARD 11
+	CXX_STANDARD_REQUIRED TRUE
+	)
+    _gcns_debug_message("builtin node sizes: |${builtin_result}| |${builtin_output}|")
+
+    if(builtin_result)
+	message(STATUS "Getting container node sizes - builtin")
+    endif()
+    set(${result_var} ${builtin_result} PARENT_SCOPE)
+endfunction()
@@ -0,0 +1,26 @@
+#include <cstddef>
+#include <forward_list>
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+
+// This will only compile if container_node_sizes_builtin.hpp supports the standard library.
+#define FOONATHAN_MEMORY_BUILTIN_NODE_SIZES 1
+
+namespace foonathan
+{
+    namespace memory
+    {
+#include <foonathan/memory/detail/container_node_sizes_builtin.hpp>
+
+        static_assert(FOONATHAN_MEMORY_IMPL_BUILTIN_NODE_SIZES, "standard library not supported");
+        static_assert(list_node_size<int>::value > sizeof(int), "invalid node size");
+        static_assert(shared_ptr_stateful_node_size<int>::value > sizeof(int), "invalid node size");
+    } // namespace memory
+} // namespace foonathan
+
+int main() {}
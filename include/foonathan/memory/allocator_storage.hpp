@@ -224,6 +224,123 @@ namespace foonathan
             }
             /// @}
 
+            /// \effects Calls the function with the \ref lifetime_hint on the stored allocator,
+            /// the hint is ignored if its traits do not provide this overload.
+            /// The \c Mutex will be locked during the operation.
+            void* allocate_node(std::size_t size, std::size_t alignment, lifetime_hint hint)
+            {
+                std::lock_guard<actual_mutex> lock(*this);
+                auto&&                        alloc = get_allocator();
+                return detail::allocate_node_hinted<traits>(traits_detail::full_concept{}, alloc,
+                                                            size, alignment, hint);
+            }
+
+            /// \effects Calls the function on the stored allocator with a size and alignment known at compile-time,
+            /// if its traits provide <tt>allocate_node<Size, Alignment>()</tt> like the one of \ref memory_stack,
+            /// otherwise the usual one.
+            /// The \c Mutex will be locked during the operation.
+            template <std::size_t Size, std::size_t Alignment>
+            void* allocate_node()
+            {
+                std::lock_guard<actual_mutex> lock(*this);
+                auto&&                        alloc = get_allocator();
+                return detail::allocate_static_node<Size, Alignment, traits>(
+                    traits_detail::full_concept{}, alloc);
+            }
+
+            /// @{
+            /// \effects Calls the batch function on the stored allocator,
+            /// or the single node function for each node, if its traits do not provide one.
+            /// The \c Mutex will be locked only once for the whole batch.
+            void allocate_node_batch(void** nodes, std::size_t count, std::size_t size,
+                                     std::size_t alignment)
+            {
+                std::lock_guard<actual_mutex> lock(*this);
+                auto&&                        alloc = get_allocator();
+                detail::allocate_node_batch<traits>(traits_detail::full_concept{}, alloc, nodes,
+                                                    count, size, alignment);
+            }
+
+            void deallocate_node_batch(void* const* nodes, std::size_t count, std::size_t size,
+                                       std::size_t alignment) noexcept
+            {
+                std::lock_guard<actual_mutex> lock(*this);
+                auto&&                        alloc = get_allocator();
+                detail::deallocate_node_batch<traits>(traits_detail::full_concept{}, alloc, nodes,
+                                                      count, size, alignment);
+            }
+            /// @}
+
+            /// @{
+            /// \effects Calls the size-returning allocation function on the stored allocator,
+            /// or the regular one, if its traits do not provide it.
+            /// The \c Mutex will be locked during the operation.
+            /// \returns The memory and its usable size, which must be passed to the deallocation function.
+            allocation_result allocate_node_at_least(std::size_t size, std::size_t alignment)
+            {
+                std::lock_guard<actual_mutex> lock(*this);
+                auto&&                        alloc = get_allocator();
+                return detail::allocate_node_at_least<traits>(traits_detail::full_concept{}, alloc,
+                                                              size, alignment);
+            }
+
+            allocation_result allocate_array_at_least(std::size_t count, std::size_t size,
+                                                      std::size_t alignment)
+            {
+                std::lock_guard<actual_mutex> lock(*this);
+                auto&&                        alloc = get_allocator();
+                return detail::allocate_array_at_least<traits>(traits_detail::full_concept{}, alloc,
+                                                               count, size, alignment);
+            }
+            /// @}
+
+            /// @{
+            /// \effects Calls the zeroing allocation function on the stored allocator,
+            /// or the regular one followed by \c std::memset(), if its traits do not provide it.
+            /// The \c Mutex will be locked during the operation.
+            /// \returns The memory, all bytes of it are zero.
+            void* allocate_node_zeroed(std::size_t size, std::size_t alignment)
+            {
+                std::lock_guard<actual_mutex> lock(*this);
+                auto&&                        alloc = get_allocator();
+                return detail::allocate_node_zeroed<traits>(traits_detail::full_concept{}, alloc,
+                                                            size, alignment);
+            }
+
+            void* allocate_array_zeroed(std::size_t count, std::size_t size, std::size_t alignment)
+            {
+                std::lock_guard<actual_mutex> lock(*this);
+                auto&&                        alloc = get_allocator();
+                return detail::allocate_array_zeroed<traits>(traits_detail::full_concept{}, alloc,
+                                                             count, size, alignment);
+            }
+            /// @}
+
+            /// @{
+            /// \effects Calls the function on the stored allocator to change the size of memory in place.
+            /// The \c Mutex will be locked during the operation.
+            /// \returns The result of the function,
+            /// or `false` if its traits do not provide it.
+            bool try_expand_node(void* node, std::size_t old_size, std::size_t new_size,
+                                 std::size_t alignment) noexcept
+            {
+                std::lock_guard<actual_mutex> lock(*this);
+                auto&&                        alloc = get_allocator();
+                return detail::try_expand_node<traits>(traits_detail::full_concept{}, alloc, node,
+                                                       old_size, new_size, alignment);
+            }
+
+            bool try_expand_array(void* array, std::size_t old_count, std::size_t new_count,
+                                  std::size_t size, std::size_t alignment) noexcept
+            {
+                std::lock_guard<actual_mutex> lock(*this);
+                auto&&                        alloc = get_allocator();
+                return detail::try_expand_array<traits>(traits_detail::full_concept{}, alloc,
+                                                        array, old_count, new_count, size,
+                                                        alignment);
+            }
+            /// @}
+
             /// @{
             /// \effects Calls the function on the stored composable allocator.
             /// The \c Mutex will be locked during the operation.
@@ -270,6 +387,37 @@ namespace foonathan
             }
             /// @}
 
+            /// @{
+            /// \effects Calls the batch function on the stored composable allocator,
+            /// or the single node function for each node, if its traits do not provide one.
+            /// The \c Mutex will be locked only once for the whole batch.
+            /// \requires The allocator must be composable,
+            /// i.e. \ref is_composable() must return `true`.
+            FOONATHAN_ENABLE_IF(composable::value)
+            bool try_allocate_node_batch(void** nodes, std::size_t count, std::size_t size,
+                                         std::size_t alignment) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(is_composable());
+                std::lock_guard<actual_mutex> lock(*this);
+                auto&&                        alloc = get_allocator();
+                return detail::try_allocate_node_batch<
+                    composable_traits>(traits_detail::full_concept{}, alloc, nodes, count, size,
+                                       alignment);
+            }
+
+            FOONATHAN_ENABLE_IF(composable::value)
+            bool try_deallocate_node_batch(void* const* nodes, std::size_t count, std::size_t size,
+                                           std::size_t alignment) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(is_composable());
+                std::lock_guard<actual_mutex> lock(*this);
+                auto&&                        alloc = get_allocator();
+                return detail::try_deallocate_node_batch<
+                    composable_traits>(traits_detail::full_concept{}, alloc, nodes, count, size,
+                                       alignment);
+            }
+            /// @}
+
             /// @{
             /// \effects Forwards to the \c StoragePolicy.
             /// \returns Returns a reference to the stored allocator.
@@ -626,7 +774,7 @@ namespace foonathan
 
                 void* allocate_node(std::size_t size, std::size_t alignment)
                 {
-                    return allocate_impl(1, size, alignment);
+                    return allocate_node_(*this, size, alignment);
                 }
 
                 void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
@@ -636,7 +784,7 @@ namespace foonathan
 
                 void deallocate_node(void* node, std::size_t size, std::size_t alignment) noexcept
                 {
-                    deallocate_impl(node, 1, size, alignment);
+                    deallocate_node_(*this, node, size, alignment);
                 }
 
                 void deallocate_array(void* array, std::size_t count, std::size_t size,
@@ -682,22 +830,45 @@ namespace foonathan
 
                 std::size_t max_node_size() const
                 {
-                    return max(query::node_size);
+                    return has_limits() ? max_node_size_ : max(query::node_size);
                 }
 
                 std::size_t max_array_size() const
                 {
-                    return max(query::array_size);
+                    return has_limits() ? max_array_size_ : max(query::array_size);
                 }
 
                 std::size_t max_alignment() const
                 {
-                    return max(query::alignment);
+                    return has_limits() ? max_alignment_ : max(query::alignment);
                 }
 
                 virtual bool is_composable() const noexcept = 0;
 
             protected:
+                // the node functions are called directly without going through the vtable
+                using allocate_node_fn   = void* (*)(base_allocator&, std::size_t, std::size_t);
+                using deallocate_node_fn = void (*)(base_allocator&, void*, std::size_t,
+                                                    std::size_t);
+
+                base_allocator(allocate_node_fn allocate, deallocate_node_fn deallocate) noexcept
+                : allocate_node_(allocate),
+                  deallocate_node_(deallocate),
+                  max_node_size_(0u),
+                  max_array_size_(0u),
+                  max_alignment_(0u)
+                {
+                }
+
+                // only for allocators whose limits cannot change
+                void set_limits(std::size_t node_size, std::size_t array_size,
+                                std::size_t alignment) noexcept
+                {
+                    max_node_size_  = node_size;
+                    max_array_size_ = array_size;
+                    max_alignment_  = alignment;
+                }
+
                 enum class query
                 {
                     node_size,
@@ -706,6 +877,16 @@ namespace foonathan
                 };
 
                 virtual std::size_t max(query q) const = 0;
+
+            private:
+                bool has_limits() const noexcept
+                {
+                    return max_alignment_ != 0u;
+                }
+
+                allocate_node_fn   allocate_node_;
+                deallocate_node_fn deallocate_node_;
+                std::size_t        max_node_size_, max_array_size_, max_alignment_;
             };
 
         public:
@@ -802,6 +983,8 @@ namespace foonathan
             {
                 using traits     = allocator_traits<RawAllocator>;
                 using composable = is_composable_allocator<typename traits::allocator_type>;
+                // the limits of a stateless allocator do not change
+                using constant_limits = std::integral_constant<bool, !traits::is_stateful::value>;
                 using storage    = detail::reference_storage_impl<
                     typename allocator_traits<RawAllocator>::allocator_type,
                     decltype(detail::reference_type(typename allocator_traits<
@@ -810,10 +993,18 @@ namespace foonathan
 
             public:
                 // non stateful
-                basic_allocator(const RawAllocator& alloc) noexcept : storage(alloc) {}
+                basic_allocator(const RawAllocator& alloc) noexcept
+                : base_allocator(&allocate_node_direct, &deallocate_node_direct), storage(alloc)
+                {
+                    cache_limits(constant_limits{});
+                }
 
                 // stateful
-                basic_allocator(RawAllocator& alloc) noexcept : storage(alloc) {}
+                basic_allocator(RawAllocator& alloc) noexcept
+                : base_allocator(&allocate_node_direct, &deallocate_node_direct), storage(alloc)
+                {
+                    cache_limits(constant_limits{});
+                }
 
             private:
                 typename traits::allocator_type& get() const noexcept
@@ -821,6 +1012,41 @@ namespace foonathan
                     return storage::get_allocator();
                 }
 
+                static void* allocate_node_direct(base_allocator& base, std::size_t size,
+                                                  std::size_t alignment)
+                {
+                    return traits::allocate_node(static_cast<basic_allocator&>(base).get(), size,
+                                                 alignment);
+                }
+
+                static void deallocate_node_direct(base_allocator& base, void* node,
+                                                   std::size_t size, std::size_t alignment) noexcept
+                {
+                    traits::deallocate_node(static_cast<basic_allocator&>(base).get(), node, size,
+                                            alignment);
+                }
+
+                void cache_limits(std::true_type) noexcept
+                {
+                    auto&& alloc = get();
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+                    try
+                    {
+                        set_limits(traits::max_node_size(alloc), traits::max_array_size(alloc),
+                                   traits::max_alignment(alloc));
+                    }
+                    catch (...)
+                    {
+                        // not cached, so it will throw again once queried
+                    }
+#else
+                    set_limits(traits::max_node_size(alloc), traits::max_array_size(alloc),
+                               traits::max_alignment(alloc));
+#endif
+                }
+
+                void cache_limits(std::false_type) noexcept {}
+
                 void clone(void* storage) const noexcept override
                 {
                     ::new (storage) basic_allocator(get());
@@ -8,6 +8,7 @@
 /// The default specialization of the \ref foonathan::memory::allocator_traits.
 
 #include <cstddef>
+#include <cstring>
 #include <type_traits>
 
 #include "detail/align.hpp"
@@ -22,6 +23,30 @@ namespace foonathan
 {
     namespace memory
     {
+        /// The result of the size-returning allocation functions like \c allocate_node_at_least() of the \ref allocator_traits.
+        /// \ingroup core
+        struct allocation_result
+        {
+            /// The allocated memory.
+            void* memory;
+            /// The usable size of the memory,
+            /// in bytes for a \concept{concept_node,node} and as number of elements for an \concept{concept_array,array}.
+            /// It is at least as big as the requested size.
+            std::size_t size;
+        };
+
+        /// The expected lifetime of a \concept{concept_node,node},
+        /// passed as a hint to the \c allocate_node() overload of the \ref allocator_traits.
+        /// An allocator can use it to keep memory of different lifetimes apart, like \ref lifetime_router,
+        /// all others ignore it.
+        /// \ingroup core
+        enum class lifetime_hint
+        {
+            short_lived, ///< Deallocated soon, like temporary buffers.
+            long_lived,  ///< Deallocated eventually, but after most other nodes.
+            permanent,   ///< Not deallocated before the allocator itself is destroyed.
+        };
+
         namespace detail
         {
             template <class Allocator>
@@ -48,6 +73,74 @@ namespace foonathan
                 using valid = std::integral_constant<bool, !custom_construct::value
                                                                && !custom_destroy::value>;
             };
+
+            // allocates each node of a batch on its own using Traits
+            // if an allocation throws, the nodes allocated so far are deallocated again
+            template <class Traits, class State>
+            void allocate_each_node(State& state, void** nodes, std::size_t count,
+                                    std::size_t size, std::size_t alignment)
+            {
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+                std::size_t i = 0u;
+                try
+                {
+                    for (; i != count; ++i)
+                        nodes[i] = Traits::allocate_node(state, size, alignment);
+                }
+                catch (...)
+                {
+                    while (i != 0u)
+                        Traits::deallocate_node(state, nodes[--i], size, alignment);
+                    throw;
+                }
+#else
+                for (std::size_t i = 0u; i != count; ++i)
+                    nodes[i] = Traits::allocate_node(state, size, alignment);
+#endif
+            }
+
+            template <class Traits, class State>
+            void deallocate_each_node(State& state, void* const* nodes, std::size_t count,
+                                      std::size_t size, std::size_t alignment) noexcept
+            {
+                for (std::size_t i = 0u; i != count; ++i)
+                    Traits::deallocate_node(state, nodes[i], size, alignment);
+            }
+
+            // same as above, but uses the composable Traits
+            // if an allocation fails, the nodes allocated so far are deallocated again
+            template <class Traits, class State>
+            bool try_allocate_each_node(State& state, void** nodes, std::size_t count,
+                                        std::size_t size, std::size_t alignment) noexcept
+            {
+                for (std::size_t i = 0u; i != count; ++i)
+                {
+                    nodes[i] = Traits::try_allocate_node(state, size, alignment);
+                    if (!nodes[i])
+                    {
+                        while (i != 0u)
+                            Traits::try_deallocate_node(state, nodes[--i], size, alignment);
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            // either all or none of the nodes belong to the allocator,
+            // so only the first one needs to be checked
+            template <class Traits, class State>
+            bool try_deallocate_each_node(State& state, void* const* nodes, std::size_t count,
+                                          std::size_t size, std::size_t alignment) noexcept
+            {
+                for (std::size_t i = 0u; i != count; ++i)
+                    if (!Traits::try_deallocate_node(state, nodes[i], size, alignment))
+                    {
+                        FOONATHAN_MEMORY_ASSERT_MSG(i == 0u, "only some nodes of the batch belong "
+                                                             "to the allocator");
+                        return false;
+                    }
+                return true;
+            }
         } // namespace detail
 
         /// Traits class that checks whether or not a standard \c Allocator can be used as \concept{concept_rawallocator,RawAllocator}.
@@ -68,6 +161,9 @@ namespace foonathan
         {
         };
 
+        template <class Allocator>
+        class allocator_traits;
+
         namespace traits_detail // use seperate namespace to avoid name clashes
         {
             // full_concept has the best conversion rank, error the lowest
@@ -164,6 +260,16 @@ namespace foonathan
             auto is_stateful(min_concept) ->
                 typename is_stateful_impl<Allocator, std::is_empty<Allocator>::value>::type;
 
+            //=== is_deallocation_noop ===//
+            // first try to access Allocator::is_deallocation_noop,
+            // then assume that the deallocation does something
+            template <class Allocator>
+            auto is_deallocation_noop(full_concept)
+                -> decltype(typename Allocator::is_deallocation_noop{});
+
+            template <class Allocator>
+            std::false_type is_deallocation_noop(min_concept);
+
             //=== allocate_node() ===//
             // first try Allocator::allocate_node
             // then assume std_allocator and call Allocator::allocate
@@ -281,11 +387,181 @@ namespace foonathan
             {
                 return detail::max_alignment;
             }
+
+            //=== allocate_node_batch() ===//
+            // first try Allocator::allocate_node_batch
+            // then allocate each node on its own
+            template <class Allocator>
+            auto allocate_node_batch(full_concept, Allocator& alloc, void** nodes,
+                                     std::size_t count, std::size_t size, std::size_t alignment)
+                -> FOONATHAN_AUTO_RETURN_TYPE(alloc.allocate_node_batch(nodes, count, size,
+                                                                        alignment),
+                                              void)
+
+                    template <class Allocator>
+                    void allocate_node_batch(min_concept, Allocator& alloc, void** nodes,
+                                             std::size_t count, std::size_t size,
+                                             std::size_t alignment)
+            {
+                detail::allocate_each_node<allocator_traits<Allocator>>(alloc, nodes, count, size,
+                                                                         alignment);
+            }
+
+            //=== deallocate_node_batch() ===//
+            // first try Allocator::deallocate_node_batch
+            // then deallocate each node on its own
+            template <class Allocator>
+            auto deallocate_node_batch(full_concept, Allocator& alloc, void* const* nodes,
+                                       std::size_t count, std::size_t size,
+                                       std::size_t alignment) noexcept
+                -> FOONATHAN_AUTO_RETURN_TYPE(alloc.deallocate_node_batch(nodes, count, size,
+                                                                          alignment),
+                                              void)
+
+                    template <class Allocator>
+                    void deallocate_node_batch(min_concept, Allocator& alloc, void* const* nodes,
+                                               std::size_t count, std::size_t size,
+                                               std::size_t alignment) noexcept
+            {
+                detail::deallocate_each_node<allocator_traits<Allocator>>(alloc, nodes, count,
+                                                                           size, alignment);
+            }
+
+            //=== allocate_node_at_least() ===//
+            // first try Allocator::allocate_node_at_least
+            // then allocate exactly the requested size
+            template <class Allocator>
+            auto allocate_node_at_least(full_concept, Allocator& alloc, std::size_t size,
+                                        std::size_t alignment)
+                -> FOONATHAN_AUTO_RETURN_TYPE(alloc.allocate_node_at_least(size, alignment),
+                                              allocation_result)
+
+                    template <class Allocator>
+                    allocation_result allocate_node_at_least(min_concept, Allocator& alloc,
+                                                             std::size_t size,
+                                                             std::size_t alignment)
+            {
+                return {allocate_node(full_concept{}, alloc, size, alignment), size};
+            }
+
+            //=== allocate_array_at_least() ===//
+            // first try Allocator::allocate_array_at_least
+            // then allocate exactly the requested count
+            template <class Allocator>
+            auto allocate_array_at_least(full_concept, Allocator& alloc, std::size_t count,
+                                         std::size_t size, std::size_t alignment)
+                -> FOONATHAN_AUTO_RETURN_TYPE(alloc.allocate_array_at_least(count, size,
+                                                                            alignment),
+                                              allocation_result)
+
+                    template <class Allocator>
+                    allocation_result allocate_array_at_least(min_concept, Allocator& alloc,
+                                                              std::size_t count, std::size_t size,
+                                                              std::size_t alignment)
+            {
+                return {allocate_array(full_concept{}, alloc, count, size, alignment), count};
+            }
+
+            //=== allocate_node_zeroed() ===//
+            // first try Allocator::allocate_node_zeroed
+            // then allocate normally and clear the memory
+            template <class Allocator>
+            auto allocate_node_zeroed(full_concept, Allocator& alloc, std::size_t size,
+                                      std::size_t alignment)
+                -> FOONATHAN_AUTO_RETURN_TYPE(alloc.allocate_node_zeroed(size, alignment), void*)
+
+                    template <class Allocator>
+                    void* allocate_node_zeroed(min_concept, Allocator& alloc, std::size_t size,
+                                               std::size_t alignment)
+            {
+                auto memory = allocate_node(full_concept{}, alloc, size, alignment);
+                std::memset(memory, 0, size);
+                return memory;
+            }
+
+            //=== allocate_node() with lifetime_hint ===//
+            // first try Allocator::allocate_node with the hint
+            // then ignore the hint
+            template <class Allocator>
+            auto allocate_node(full_concept, Allocator& alloc, std::size_t size,
+                               std::size_t alignment, lifetime_hint hint)
+                -> FOONATHAN_AUTO_RETURN_TYPE(alloc.allocate_node(size, alignment, hint), void*)
+
+                    template <class Allocator>
+                    void* allocate_node(min_concept, Allocator& alloc, std::size_t size,
+                                        std::size_t alignment, lifetime_hint)
+            {
+                return allocate_node(full_concept{}, alloc, size, alignment);
+            }
+
+            //=== allocate_array_zeroed() ===//
+            // first try Allocator::allocate_array_zeroed
+            // then allocate normally and clear the memory
+            template <class Allocator>
+            auto allocate_array_zeroed(full_concept, Allocator& alloc, std::size_t count,
+                                       std::size_t size, std::size_t alignment)
+                -> FOONATHAN_AUTO_RETURN_TYPE(alloc.allocate_array_zeroed(count, size, alignment),
+                                              void*)
+
+                    template <class Allocator>
+                    void* allocate_array_zeroed(min_concept, Allocator& alloc, std::size_t count,
+                                                std::size_t size, std::size_t alignment)
+            {
+                auto memory = allocate_array(full_concept{}, alloc, count, size, alignment);
+                std::memset(memory, 0, count * size);
+                return memory;
+            }
+
+            //=== try_expand_node() ===//
+            // first try Allocator::try_expand_node
+            // then fail, memory cannot be expanded in general
+            template <class Allocator>
+            auto try_expand_node(full_concept, Allocator& alloc, void* node, std::size_t old_size,
+                                 std::size_t new_size, std::size_t alignment) noexcept
+                -> FOONATHAN_AUTO_RETURN_TYPE(alloc.try_expand_node(node, old_size, new_size,
+                                                                    alignment),
+                                              bool)
+
+                    template <class Allocator>
+                    bool try_expand_node(min_concept, Allocator&, void*, std::size_t, std::size_t,
+                                         std::size_t) noexcept
+            {
+                return false;
+            }
+
+            //=== try_expand_array() ===//
+            // first try Allocator::try_expand_array
+            // then fail, memory cannot be expanded in general
+            template <class Allocator>
+            auto try_expand_array(full_concept, Allocator& alloc, void* array,
+                                  std::size_t old_count, std::size_t new_count, std::size_t size,
+                                  std::size_t alignment) noexcept
+                -> FOONATHAN_AUTO_RETURN_TYPE(alloc.try_expand_array(array, old_count, new_count,
+                                                                     size, alignment),
+                                              bool)
+
+                    template <class Allocator>
+                    bool try_expand_array(min_concept, Allocator&, void*, std::size_t,
+                                          std::size_t, std::size_t, std::size_t) noexcept
+            {
+                return false;
+            }
         } // namespace traits_detail
 
         /// The default specialization of the allocator_traits for a \concept{concept_rawallocator,RawAllocator}.
         /// See the last link for the requirements on types that do not specialize this class and the interface documentation.
-        /// Any specialization must provide the same interface.
+        /// Any specialization must provide the same interface,
+        /// except for \c allocate_node_batch() and \c deallocate_node_batch() which are optional:
+        /// \ref allocator_storage and thus \ref allocator_reference fall back to a loop over the single node functions.
+        /// The same goes for \c try_expand_node() and \c try_expand_array(),
+        /// without them memory is never expanded in place,
+        /// and for \c allocate_node_at_least() and \c allocate_array_at_least(),
+        /// without them exactly the requested size is allocated.
+        /// The memory returned by them must be deallocated passing the returned size.
+        /// Without \c allocate_node_zeroed() and \c allocate_array_zeroed(),
+        /// the memory is allocated normally and cleared with \c std::memset().
+        /// Without the \c allocate_node() overload taking a \ref lifetime_hint, the hint is ignored.
+        /// The \c is_deallocation_noop typedef is optional as well, see \ref is_deallocation_noop.
         /// \ingroup core
         template <class Allocator>
         class allocator_traits
@@ -294,6 +570,8 @@ namespace foonathan
             using allocator_type = traits_detail::allocator_type<Allocator>;
             using is_stateful =
                 decltype(traits_detail::is_stateful<Allocator>(traits_detail::full_concept{}));
+            using is_deallocation_noop = decltype(
+                traits_detail::is_deallocation_noop<Allocator>(traits_detail::full_concept{}));
 
             static void* allocate_node(allocator_type& state, std::size_t size,
                                        std::size_t alignment)
@@ -359,6 +637,99 @@ namespace foonathan
                 return traits_detail::max_alignment(traits_detail::full_concept{}, state);
             }
 
+            static void allocate_node_batch(allocator_type& state, void** nodes, std::size_t count,
+                                            std::size_t size, std::size_t alignment)
+            {
+                static_assert(allocator_is_raw_allocator<Allocator>::value,
+                              "Allocator cannot be used as RawAllocator because it provides custom "
+                              "construct()/destroy()");
+                traits_detail::allocate_node_batch(traits_detail::full_concept{}, state, nodes,
+                                                   count, size, alignment);
+            }
+
+            static void deallocate_node_batch(allocator_type& state, void* const* nodes,
+                                              std::size_t count, std::size_t size,
+                                              std::size_t alignment) noexcept
+            {
+                static_assert(allocator_is_raw_allocator<Allocator>::value,
+                              "Allocator cannot be used as RawAllocator because it provides custom "
+                              "construct()/destroy()");
+                traits_detail::deallocate_node_batch(traits_detail::full_concept{}, state, nodes,
+                                                     count, size, alignment);
+            }
+
+            static allocation_result allocate_node_at_least(allocator_type& state, std::size_t size,
+                                                            std::size_t alignment)
+            {
+                static_assert(allocator_is_raw_allocator<Allocator>::value,
+                              "Allocator cannot be used as RawAllocator because it provides custom "
+                              "construct()/destroy()");
+                return traits_detail::allocate_node_at_least(traits_detail::full_concept{}, state,
+                                                             size, alignment);
+            }
+
+            static allocation_result allocate_array_at_least(allocator_type& state,
+                                                             std::size_t count, std::size_t size,
+                                                             std::size_t alignment)
+            {
+                static_assert(allocator_is_raw_allocator<Allocator>::value,
+                              "Allocator cannot be used as RawAllocator because it provides custom "
+                              "construct()/destroy()");
+                return traits_detail::allocate_array_at_least(traits_detail::full_concept{}, state,
+                                                              count, size, alignment);
+            }
+
+            static void* allocate_node_zeroed(allocator_type& state, std::size_t size,
+                                              std::size_t alignment)
+            {
+                static_assert(allocator_is_raw_allocator<Allocator>::value,
+                              "Allocator cannot be used as RawAllocator because it provides custom "
+                              "construct()/destroy()");
+                return traits_detail::allocate_node_zeroed(traits_detail::full_concept{}, state,
+                                                           size, alignment);
+            }
+
+            static void* allocate_array_zeroed(allocator_type& state, std::size_t count,
+                                               std::size_t size, std::size_t alignment)
+            {
+                static_assert(allocator_is_raw_allocator<Allocator>::value,
+                              "Allocator cannot be used as RawAllocator because it provides custom "
+                              "construct()/destroy()");
+                return traits_detail::allocate_array_zeroed(traits_detail::full_concept{}, state,
+                                                            count, size, alignment);
+            }
+
+            static void* allocate_node(allocator_type& state, std::size_t size,
+                                       std::size_t alignment, lifetime_hint hint)
+            {
+                static_assert(allocator_is_raw_allocator<Allocator>::value,
+                              "Allocator cannot be used as RawAllocator because it provides custom "
+                              "construct()/destroy()");
+                return traits_detail::allocate_node(traits_detail::full_concept{}, state, size,
+                                                    alignment, hint);
+            }
+
+            static bool try_expand_node(allocator_type& state, void* node, std::size_t old_size,
+                                        std::size_t new_size, std::size_t alignment) noexcept
+            {
+                static_assert(allocator_is_raw_allocator<Allocator>::value,
+                              "Allocator cannot be used as RawAllocator because it provides custom "
+                              "construct()/destroy()");
+                return traits_detail::try_expand_node(traits_detail::full_concept{}, state, node,
+                                                      old_size, new_size, alignment);
+            }
+
+            static bool try_expand_array(allocator_type& state, void* array, std::size_t old_count,
+                                         std::size_t new_count, std::size_t size,
+                                         std::size_t alignment) noexcept
+            {
+                static_assert(allocator_is_raw_allocator<Allocator>::value,
+                              "Allocator cannot be used as RawAllocator because it provides custom "
+                              "construct()/destroy()");
+                return traits_detail::try_expand_array(traits_detail::full_concept{}, state, array,
+                                                       old_count, new_count, size, alignment);
+            }
+
 #if !defined(DOXYGEN)
             using foonathan_memory_default_traits = std::true_type;
 #endif
@@ -418,6 +789,197 @@ namespace foonathan
         {
         };
 
+        namespace detail
+        {
+            template <class Traits>
+            auto is_deallocation_noop(int) -> decltype(typename Traits::is_deallocation_noop{});
+
+            template <class Traits>
+            std::false_type is_deallocation_noop(short);
+        } // namespace detail
+
+        /// Traits that check whether the deallocation functions of a \concept{concept_rawallocator,RawAllocator} do nothing,
+        /// so memory does not need to be deallocated before the allocator releases all of it at once,
+        /// like a \ref memory_stack when it is unwound or destroyed.
+        /// This is the case if the \ref allocator_traits define \c is_deallocation_noop as \c std::true_type,
+        /// the default specialization takes the typedef of the same name from the allocator, if there is one.
+        /// \ingroup core
+        template <class RawAllocator>
+        struct is_deallocation_noop
+        : decltype(detail::is_deallocation_noop<allocator_traits<RawAllocator>>(0))
+        {
+        };
+
+        namespace detail
+        {
+            // calls Traits::allocate_node_batch() if the specialization provides it,
+            // allocates each node on its own otherwise
+            template <class Traits, class State>
+            auto allocate_node_batch(traits_detail::full_concept, State& state, void** nodes,
+                                     std::size_t count, std::size_t size, std::size_t alignment)
+                -> FOONATHAN_AUTO_RETURN_TYPE(Traits::allocate_node_batch(state, nodes, count,
+                                                                          size, alignment),
+                                              void)
+
+                    template <class Traits, class State>
+                    void allocate_node_batch(traits_detail::min_concept, State& state,
+                                             void** nodes, std::size_t count, std::size_t size,
+                                             std::size_t alignment)
+            {
+                allocate_each_node<Traits>(state, nodes, count, size, alignment);
+            }
+
+            template <class Traits, class State>
+            auto deallocate_node_batch(traits_detail::full_concept, State& state,
+                                       void* const* nodes, std::size_t count, std::size_t size,
+                                       std::size_t alignment) noexcept
+                -> FOONATHAN_AUTO_RETURN_TYPE(Traits::deallocate_node_batch(state, nodes, count,
+                                                                            size, alignment),
+                                              void)
+
+                    template <class Traits, class State>
+                    void deallocate_node_batch(traits_detail::min_concept, State& state,
+                                               void* const* nodes, std::size_t count,
+                                               std::size_t size, std::size_t alignment) noexcept
+            {
+                deallocate_each_node<Traits>(state, nodes, count, size, alignment);
+            }
+
+            // calls Traits::allocate_node_at_least() if the specialization provides it,
+            // allocates exactly the requested size otherwise
+            template <class Traits, class State>
+            auto allocate_node_at_least(traits_detail::full_concept, State& state,
+                                        std::size_t size, std::size_t alignment)
+                -> FOONATHAN_AUTO_RETURN_TYPE(Traits::allocate_node_at_least(state, size,
+                                                                             alignment),
+                                              allocation_result)
+
+                    template <class Traits, class State>
+                    allocation_result allocate_node_at_least(traits_detail::min_concept,
+                                                             State& state, std::size_t size,
+                                                             std::size_t alignment)
+            {
+                return {Traits::allocate_node(state, size, alignment), size};
+            }
+
+            template <class Traits, class State>
+            auto allocate_array_at_least(traits_detail::full_concept, State& state,
+                                         std::size_t count, std::size_t size,
+                                         std::size_t alignment)
+                -> FOONATHAN_AUTO_RETURN_TYPE(Traits::allocate_array_at_least(state, count, size,
+                                                                              alignment),
+                                              allocation_result)
+
+                    template <class Traits, class State>
+                    allocation_result allocate_array_at_least(traits_detail::min_concept,
+                                                              State& state, std::size_t count,
+                                                              std::size_t size,
+                                                              std::size_t alignment)
+            {
+                return {Traits::allocate_array(state, count, size, alignment), count};
+            }
+
+            // calls Traits::allocate_node<Size, Alignment>() if the specialization provides it,
+            // passes them to the usual allocate_node() otherwise
+            template <std::size_t Size, std::size_t Alignment, class Traits, class State>
+            auto allocate_static_node(traits_detail::full_concept, State& state)
+                -> FOONATHAN_AUTO_RETURN_TYPE((Traits::template allocate_node<Size, Alignment>(
+                                                  state)),
+                                              void*)
+
+                    template <std::size_t Size, std::size_t Alignment, class Traits, class State>
+                    void* allocate_static_node(traits_detail::min_concept, State& state)
+            {
+                return Traits::allocate_node(state, Size, Alignment);
+            }
+
+            // calls Traits::allocate_node_zeroed() if the specialization provides it,
+            // allocates normally and clears the memory otherwise
+            template <class Traits, class State>
+            auto allocate_node_zeroed(traits_detail::full_concept, State& state, std::size_t size,
+                                      std::size_t alignment)
+                -> FOONATHAN_AUTO_RETURN_TYPE(Traits::allocate_node_zeroed(state, size, alignment),
+                                              void*)
+
+                    template <class Traits, class State>
+                    void* allocate_node_zeroed(traits_detail::min_concept, State& state,
+                                               std::size_t size, std::size_t alignment)
+            {
+                auto memory = Traits::allocate_node(state, size, alignment);
+                std::memset(memory, 0, size);
+                return memory;
+            }
+
+            template <class Traits, class State>
+            auto allocate_array_zeroed(traits_detail::full_concept, State& state,
+                                       std::size_t count, std::size_t size, std::size_t alignment)
+                -> FOONATHAN_AUTO_RETURN_TYPE(Traits::allocate_array_zeroed(state, count, size,
+                                                                            alignment),
+                                              void*)
+
+                    template <class Traits, class State>
+                    void* allocate_array_zeroed(traits_detail::min_concept, State& state,
+                                                std::size_t count, std::size_t size,
+                                                std::size_t alignment)
+            {
+                auto memory = Traits::allocate_array(state, count, size, alignment);
+                std::memset(memory, 0, count * size);
+                return memory;
+            }
+
+            // calls Traits::allocate_node() with the lifetime_hint if the specialization has it,
+            // ignores the hint otherwise
+            template <class Traits, class State>
+            auto allocate_node_hinted(traits_detail::full_concept, State& state, std::size_t size,
+                                      std::size_t alignment, lifetime_hint hint)
+                -> FOONATHAN_AUTO_RETURN_TYPE(Traits::allocate_node(state, size, alignment, hint),
+                                              void*)
+
+                    template <class Traits, class State>
+                    void* allocate_node_hinted(traits_detail::min_concept, State& state,
+                                               std::size_t size, std::size_t alignment,
+                                               lifetime_hint)
+            {
+                return Traits::allocate_node(state, size, alignment);
+            }
+
+            // calls Traits::try_expand_node() if the specialization provides it,
+            // fails otherwise
+            template <class Traits, class State>
+            auto try_expand_node(traits_detail::full_concept, State& state, void* node,
+                                 std::size_t old_size, std::size_t new_size,
+                                 std::size_t alignment) noexcept
+                -> FOONATHAN_AUTO_RETURN_TYPE(Traits::try_expand_node(state, node, old_size,
+                                                                      new_size, alignment),
+                                              bool)
+
+                    template <class Traits, class State>
+                    bool try_expand_node(traits_detail::min_concept, State&, void*, std::size_t,
+                                         std::size_t, std::size_t) noexcept
+            {
+                return false;
+            }
+
+            template <class Traits, class State>
+            auto try_expand_array(traits_detail::full_concept, State& state, void* array,
+                                  std::size_t old_count, std::size_t new_count, std::size_t size,
+                                  std::size_t alignment) noexcept
+                -> FOONATHAN_AUTO_RETURN_TYPE(Traits::try_expand_array(state, array, old_count,
+                                                                       new_count, size,
+                                                                       alignment),
+                                              bool)
+
+                    template <class Traits, class State>
+                    bool try_expand_array(traits_detail::min_concept, State&, void*, std::size_t,
+                                          std::size_t, std::size_t, std::size_t) noexcept
+            {
+                return false;
+            }
+        } // namespace detail
+
+        template <class Allocator>
+        class composable_allocator_traits;
+
         namespace traits_detail
         {
             //=== try_allocate_node() ===//
@@ -489,11 +1051,52 @@ namespace foonathan
             {
                 return try_deallocate_node(full_concept{}, alloc, ptr, count * size, alignment);
             }
+
+            //=== try_allocate_node_batch() ===//
+            // first try Allocator::try_allocate_node_batch
+            // then try to allocate each node on its own
+            template <class Allocator>
+            auto try_allocate_node_batch(full_concept, Allocator& alloc, void** nodes,
+                                         std::size_t count, std::size_t size,
+                                         std::size_t alignment) noexcept
+                -> FOONATHAN_AUTO_RETURN_TYPE(alloc.try_allocate_node_batch(nodes, count, size,
+                                                                            alignment),
+                                              bool)
+
+                    template <class Allocator>
+                    bool try_allocate_node_batch(min_concept, Allocator& alloc, void** nodes,
+                                                 std::size_t count, std::size_t size,
+                                                 std::size_t alignment) noexcept
+            {
+                return detail::try_allocate_each_node<composable_allocator_traits<Allocator>>(
+                    alloc, nodes, count, size, alignment);
+            }
+
+            //=== try_deallocate_node_batch() ===//
+            // first try Allocator::try_deallocate_node_batch
+            // then try to deallocate each node on its own
+            template <class Allocator>
+            auto try_deallocate_node_batch(full_concept, Allocator& alloc, void* const* nodes,
+                                           std::size_t count, std::size_t size,
+                                           std::size_t alignment) noexcept
+                -> FOONATHAN_AUTO_RETURN_TYPE(alloc.try_deallocate_node_batch(nodes, count, size,
+                                                                              alignment),
+                                              bool)
+
+                    template <class Allocator>
+                    bool try_deallocate_node_batch(min_concept, Allocator& alloc,
+                                                   void* const* nodes, std::size_t count,
+                                                   std::size_t size, std::size_t alignment) noexcept
+            {
+                return detail::try_deallocate_each_node<composable_allocator_traits<Allocator>>(
+                    alloc, nodes, count, size, alignment);
+            }
         } // namespace traits_detail
 
         /// The default specialization of the composable_allocator_traits for a \concept{concept_composableallocator,ComposableAllocator}.
         /// See the last link for the requirements on types that do not specialize this class and the interface documentation.
-        /// Any specialization must provide the same interface.
+        /// Any specialization must provide the same interface,
+        /// except for \c try_allocate_node_batch() and \c try_deallocate_node_batch() which are optional.
         /// \ingroup core
         template <class Allocator>
         class composable_allocator_traits
@@ -537,6 +1140,27 @@ namespace foonathan
                                                            array, count, size, alignment);
             }
 
+            static bool try_allocate_node_batch(allocator_type& state, void** nodes,
+                                                std::size_t count, std::size_t size,
+                                                std::size_t alignment) noexcept
+            {
+                static_assert(is_raw_allocator<Allocator>::value,
+                              "ComposableAllocator must be RawAllocator");
+                return traits_detail::try_allocate_node_batch(traits_detail::full_concept{}, state,
+                                                              nodes, count, size, alignment);
+            }
+
+            static bool try_deallocate_node_batch(allocator_type& state, void* const* nodes,
+                                                  std::size_t count, std::size_t size,
+                                                  std::size_t alignment) noexcept
+            {
+                static_assert(is_raw_allocator<Allocator>::value,
+                              "ComposableAllocator must be RawAllocator");
+                return traits_detail::try_deallocate_node_batch(traits_detail::full_concept{},
+                                                                state, nodes, count, size,
+                                                                alignment);
+            }
+
 #if !defined(DOXYGEN)
             using foonathan_memory_default_traits = std::true_type;
 #endif
@@ -595,6 +1219,44 @@ namespace foonathan
                                                  std::declval<T&>()))>
         {
         };
+
+        namespace detail
+        {
+            // calls Traits::try_allocate_node_batch() if the specialization provides it,
+            // tries to allocate each node on its own otherwise
+            template <class Traits, class State>
+            auto try_allocate_node_batch(traits_detail::full_concept, State& state, void** nodes,
+                                         std::size_t count, std::size_t size,
+                                         std::size_t alignment) noexcept
+                -> FOONATHAN_AUTO_RETURN_TYPE(Traits::try_allocate_node_batch(state, nodes, count,
+                                                                              size, alignment),
+                                              bool)
+
+                    template <class Traits, class State>
+                    bool try_allocate_node_batch(traits_detail::min_concept, State& state,
+                                                 void** nodes, std::size_t count,
+                                                 std::size_t size, std::size_t alignment) noexcept
+            {
+                return try_allocate_each_node<Traits>(state, nodes, count, size, alignment);
+            }
+
+            template <class Traits, class State>
+            auto try_deallocate_node_batch(traits_detail::full_concept, State& state,
+                                           void* const* nodes, std::size_t count,
+                                           std::size_t size, std::size_t alignment) noexcept
+                -> FOONATHAN_AUTO_RETURN_TYPE(Traits::try_deallocate_node_batch(state, nodes,
+                                                                                count, size,
+                                                                                alignment),
+                                              bool)
+
+                    template <class Traits, class State>
+                    bool try_deallocate_node_batch(traits_detail::min_concept, State& state,
+                                                   void* const* nodes, std::size_t count,
+                                                   std::size_t size, std::size_t alignment) noexcept
+            {
+                return try_deallocate_each_node<Traits>(state, nodes, count, size, alignment);
+            }
+        } // namespace detail
     } // namespace memory
 } // namespace foonathan
 
@@ -0,0 +1,243 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_BUDDY_ALLOCATOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_BUDDY_ALLOCATOR_HPP_INCLUDED
+
+/// \file
+/// Class template \ref foonathan::memory::buddy_allocator.
+
+#include <type_traits>
+
+#include "detail/buddy_system.hpp"
+#include "detail/debug_helpers.hpp"
+#include "detail/assert.hpp"
+#include "config.hpp"
+#include "default_allocator.hpp"
+#include "error.hpp"
+#include "memory_arena.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// A stateful \concept{concept_rawallocator,RawAllocator} that manages the blocks of a \ref memory_arena as buddy systems.
+        /// Every \concept{concept_node,node} has a power of two multiple of the minimum node size,
+        /// a bigger free node is split in halves until it fits and a deallocated node is merged with its buddy,
+        /// the other half of its parent, as long as that one is free as well.
+        /// Both take O(log n) time with a free list per size and a bitmap of the free nodes,
+        /// which is stored at the end of each block and not in the nodes.<br>
+        /// Unlike \ref memory_stack it can deallocate in any order and unlike a \ref memory_pool with \ref array_pool
+        /// it merges free memory without searching the free list,
+        /// so it suits variable sized arrays and buffers that are freed in random order.
+        /// The rounding to a power of two wastes less than half of each node,
+        /// and free memory is always available as nodes of the biggest possible size.
+        /// \note The block of a deallocated node is found with a linear search,
+        /// which is fast as a growing \concept{concept_blockallocator,BlockAllocator} allocates only few blocks.
+        /// \ingroup allocator
+        template <class BlockOrRawAllocator = default_allocator>
+        class buddy_allocator
+        {
+        public:
+            using allocator_type = make_block_allocator_t<BlockOrRawAllocator>;
+            using is_stateful    = std::true_type;
+
+            /// \effects Creates it by giving the minimum size of each \concept{concept_node,node},
+            /// the initial block size for the arena and other constructor arguments for the \concept{concept_blockallocator,BlockAllocator}.
+            /// The minimum node size is rounded up to a power of two and at least two pointers.
+            /// It will allocate an initial memory block with the given size from the \concept{concept_blockallocator,BlockAllocator}.
+            /// \requires \c block_size must be big enough for a node of the minimum size and the bitmap.
+            template <typename... Args>
+            buddy_allocator(std::size_t min_node_size, std::size_t block_size, Args&&... args)
+            : arena_(block_size, detail::forward<Args>(args)...), list_(min_node_size)
+            {
+                allocate_block();
+            }
+
+            /// \effects Destroys it by returning all memory blocks to the \concept{concept_blockallocator,BlockAllocator}.
+            ~buddy_allocator() noexcept
+            {
+#if FOONATHAN_MEMORY_DEBUG_LEAK_CHECK
+                auto leaked = list_.managed() - list_.capacity();
+                if (leaked != 0u)
+                    detail::debug_handle_memory_leak(info(), static_cast<std::ptrdiff_t>(leaked));
+#endif
+            }
+
+            /// @{
+            /// \effects Moving it transfers ownership over the blocks,
+            /// i.e. the moved from allocator is completely empty and the new one has all its memory.
+            buddy_allocator(buddy_allocator&& other) noexcept
+            : arena_(detail::move(other.arena_)), list_(detail::move(other.list_))
+            {
+            }
+
+            buddy_allocator& operator=(buddy_allocator&& other) noexcept
+            {
+                arena_ = detail::move(other.arena_);
+                list_  = detail::move(other.list_);
+                return *this;
+            }
+            /// @}
+
+            /// \effects A \concept{concept_rawallocator,RawAllocator} allocation function.
+            /// It splits the smallest free node that is big enough for the size and the alignment.
+            /// If there is none, a new memory block with \ref next_capacity() bytes of nodes is allocated from the arena.
+            /// \returns A \concept{concept_node,node} of at least the given size, rounded up to a power of two.
+            /// \throws Anything thrown by the \concept{concept_blockallocator,BlockAllocator} if a growth is needed,
+            /// or \ref bad_node_size or \ref bad_alignment if the node does not fit into a new block.
+            void* allocate_node(std::size_t size, std::size_t alignment)
+            {
+                FOONATHAN_MEMORY_ASSERT(detail::is_valid_alignment(alignment));
+                detail::check_allocation_size<bad_node_size>(
+                    size, [&] { return max_node_size(); }, info());
+                detail::check_allocation_size<bad_alignment>(
+                    alignment, [&] { return max_alignment(); }, info());
+
+                auto node = list_.allocate(node_size(size, alignment));
+                if (FOONATHAN_MEMORY_UNLIKELY(!node))
+                {
+                    allocate_block();
+                    node = list_.allocate(node_size(size, alignment));
+                    FOONATHAN_MEMORY_ASSERT(node);
+                }
+                return node;
+            }
+
+            /// \effects A \concept{concept_rawallocator,RawAllocator} allocation function for an \concept{concept_array,array},
+            /// it allocates a node for the whole array like \ref allocate_node().
+            /// \throws The same as \ref allocate_node() but \ref bad_array_size if the array does not fit into a new block.
+            void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_array_size>(
+                    count * size, [&] { return max_node_size(); }, info());
+                return allocate_node(count * size, alignment);
+            }
+
+            /// \effects A \concept{concept_composableallocator,ComposableAllocator} allocation function.
+            /// \returns The same as \ref allocate_node() or \c nullptr if there is no free node,
+            /// it never allocates a new memory block.
+            void* try_allocate_node(std::size_t size, std::size_t alignment) noexcept
+            {
+                if (alignment > max_alignment())
+                    return nullptr;
+                return list_.allocate(node_size(size, alignment));
+            }
+
+            /// \effects A \concept{concept_rawallocator,RawAllocator} deallocation function.
+            /// It merges the node with its buddies as long as they are free.
+            /// \requires \c node must have been allocated by this allocator with the same size and alignment.
+            void deallocate_node(void* node, std::size_t size, std::size_t alignment) noexcept
+            {
+                list_.deallocate(node, node_size(size, alignment));
+            }
+
+            /// \effects A \concept{concept_rawallocator,RawAllocator} deallocation function for an \concept{concept_array,array}.
+            void deallocate_array(void* array, std::size_t count, std::size_t size,
+                                  std::size_t alignment) noexcept
+            {
+                deallocate_node(array, count * size, alignment);
+            }
+
+            /// \effects A \concept{concept_composableallocator,ComposableAllocator} deallocation function.
+            /// \returns Whether or not the node is in a block of this allocator and thus deallocated.
+            bool try_deallocate_node(void* node, std::size_t size, std::size_t alignment) noexcept
+            {
+                if (!list_.owns(node))
+                    return false;
+                deallocate_node(node, size, alignment);
+                return true;
+            }
+
+            /// \returns The size of the biggest node of the next memory block,
+            /// or of a free node if that one is bigger.
+            std::size_t max_node_size() const noexcept
+            {
+                auto next = list_.max_node_size(next_block_size());
+                auto free = list_.max_free_size();
+                return next < free ? free : next;
+            }
+
+            /// \returns The biggest size of an \concept{concept_array,array}, the same as \ref max_node_size().
+            std::size_t max_array_size() const noexcept
+            {
+                return max_node_size();
+            }
+
+            /// \returns The maximum alignment, the one of the memory blocks.
+            /// Bigger nodes are aligned for their size relative to the beginning of a block.
+            std::size_t max_alignment() const noexcept
+            {
+                return detail::max_alignment;
+            }
+
+            /// \returns The size of the smallest \concept{concept_node,node}.
+            std::size_t min_node_size() const noexcept
+            {
+                return list_.node_size();
+            }
+
+            /// \returns The number of bytes in the free nodes.
+            /// \note A node allocation may still lead to a growth if no single free node is big enough.
+            std::size_t capacity_left() const noexcept
+            {
+                return list_.capacity();
+            }
+
+            /// \returns The number of bytes in the nodes of the next memory block after the arena grows.
+            /// \ref capacity_left() will increase by this amount.
+            std::size_t next_capacity() const noexcept
+            {
+                return list_.usable_size(next_block_size());
+            }
+
+            /// \returns A reference to the \concept{concept_blockallocator,BlockAllocator} used for managing the arena.
+            /// \requires It is undefined behavior to move this allocator out into another object.
+            allocator_type& get_allocator() noexcept
+            {
+                return arena_.get_allocator();
+            }
+
+            /// \returns If `ptr` is in memory owned by the underlying arena.
+            bool owns(const void* ptr) const noexcept
+            {
+                return arena_.owns(ptr);
+            }
+
+        private:
+            allocator_info info() const noexcept
+            {
+                return {FOONATHAN_MEMORY_LOG_PREFIX "::buddy_allocator", this};
+            }
+
+            // nodes are aligned for their size, as all blocks are aligned for the maximum alignment
+            static std::size_t node_size(std::size_t size, std::size_t alignment) noexcept
+            {
+                return size < alignment ? alignment : size;
+            }
+
+            // the size of the next block that can be used for nodes
+            std::size_t next_block_size() const noexcept
+            {
+                auto offset =
+                    detail::align_offset(detail::memory_block_stack::implementation_offset(),
+                                         detail::max_alignment);
+                auto size   = arena_.next_block_size();
+                return size < offset ? 0u : size - offset;
+            }
+
+            void allocate_block()
+            {
+                auto mem    = arena_.allocate_block();
+                auto offset = detail::align_offset(mem.memory, detail::max_alignment);
+                FOONATHAN_MEMORY_ASSERT(offset < mem.size);
+                list_.insert(static_cast<char*>(mem.memory) + offset, mem.size - offset);
+            }
+
+            memory_arena<allocator_type, false> arena_;
+            detail::buddy_system                list_;
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_BUDDY_ALLOCATOR_HPP_INCLUDED
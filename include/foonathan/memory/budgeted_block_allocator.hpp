@@ -0,0 +1,270 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_BUDGETED_BLOCK_ALLOCATOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_BUDGETED_BLOCK_ALLOCATOR_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::budgeted_block_allocator and \ref foonathan::memory::memory_budget.
+
+#include <atomic>
+#include <cstddef>
+
+#include "detail/utility.hpp"
+#include "config.hpp"
+#include "error.hpp"
+#include "memory_arena.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// The limits of a \ref memory_budget.
+        /// \ingroup adapter
+        enum class budget_limit
+        {
+            /// The soft limit, when it is exceeded the charge still succeeds.
+            soft,
+            /// The hard limit, it is never exceeded and the charge fails instead.
+            hard,
+        };
+
+        /// A limit on the memory of a tenant, a service or the process,
+        /// that is charged by \ref budgeted_block_allocator objects for each memory block.
+        /// Budgets form a hierarchy: everything charged to a budget is charged to its parent as well,
+        /// and a charge fails if it would exceed the hard limit of the budget or of one of its parents.
+        ///
+        /// To keep charging cheap, each thread charges one of several shards,
+        /// which reserves memory from the budget in steps of the granularity and keeps the rest as slack for the next charges,
+        /// so most charges and releases are a single uncontended atomic operation,
+        /// and the parents are only touched when a shard reserves or returns a step.
+        /// The limits are compared against the reserved memory, which includes the slack,
+        /// but if a charge would exceed the hard limit the slack of all shards is returned first.
+        /// The slack of child budgets, at most twice the granularity per shard, is not returned,
+        /// so use a granularity of \c 0 for children of a budget with a tight hard limit.
+        /// \note The object must outlive all allocators charging it and all of its child budgets.
+        /// \ingroup adapter
+        class memory_budget
+        {
+        public:
+            /// The type of the limit handler.
+            /// It is called when a charge exceeds the soft limit for the first time since the usage was below it,
+            /// and whenever a charge fails because of the hard limit,
+            /// with the budget, the limit, the number of bytes reserved including the charge and the user data.
+            /// \requiredbe It must not throw and must not charge the budget or its parents.
+            /// It can signal the application to shed load.
+            using limit_handler = void (*)(const memory_budget& budget, budget_limit limit,
+                                           std::size_t amount, void* user_data);
+
+            /// The value of a limit that is never reached.
+            static constexpr std::size_t unlimited = std::size_t(-1);
+
+            /// The default granularity in which the shards reserve memory.
+            static constexpr std::size_t default_granularity = 64u * 1024u;
+
+            /// \effects Creates a budget with the given limits,
+            /// the optional parent budget and the granularity in which its shards reserve memory.
+            /// A granularity of \c 0 charges the budget directly without any slack.
+            /// A soft limit that is not less than the hard limit is never exceeded.
+            explicit memory_budget(std::size_t    soft_limit  = unlimited,
+                                   std::size_t    hard_limit  = unlimited,
+                                   memory_budget* parent      = nullptr,
+                                   std::size_t    granularity = default_granularity) noexcept;
+
+            /// \effects Returns everything reserved to the parent.
+            /// \requires Nothing may be charged anymore.
+            ~memory_budget() noexcept;
+
+            memory_budget(const memory_budget&)            = delete;
+            memory_budget& operator=(const memory_budget&) = delete;
+
+            /// \effects Sets the handler called when a limit is exceeded with the user data passed to it,
+            /// a \c nullptr removes it.
+            /// \note It must not be called while the budget is charged by other threads.
+            void set_limit_handler(limit_handler handler, void* user_data = nullptr) noexcept
+            {
+                handler_   = handler;
+                user_data_ = user_data;
+            }
+
+            /// \effects Charges the given number of bytes to the budget and its parents,
+            /// unless that would exceed one of their hard limits.
+            /// \returns Whether or not the charge succeeded.
+            bool try_charge(std::size_t size) noexcept;
+
+            /// \effects Releases the given number of bytes charged earlier.
+            void release(std::size_t size) noexcept;
+
+            /// \effects Returns the slack of all shards to the budget and its parents.
+            void trim() noexcept;
+
+            /// \returns The number of bytes currently charged, without the slack of its shards,
+            /// but including everything reserved by child budgets.
+            /// \note Charges of other threads at the same time may or may not be included.
+            std::size_t usage() const noexcept;
+
+            /// \returns The number of bytes reserved from the budget, i.e. the usage and the slack of the shards,
+            /// and those reserved by child budgets.
+            std::size_t reserved() const noexcept
+            {
+                return reserved_.load(std::memory_order_relaxed);
+            }
+
+            /// \returns The soft limit.
+            std::size_t soft_limit() const noexcept
+            {
+                return soft_limit_;
+            }
+
+            /// \returns The hard limit.
+            std::size_t hard_limit() const noexcept
+            {
+                return hard_limit_;
+            }
+
+            /// \returns The parent budget or \c nullptr.
+            memory_budget* parent() const noexcept
+            {
+                return parent_;
+            }
+
+        private:
+            static constexpr std::size_t shard_count = 16u;
+
+            struct alignas(64) shard
+            {
+                std::atomic<std::size_t> slack;
+            };
+
+            // reserves the bytes from the budget and its parents,
+            // on failure the slack is returned and the handlers are called if requested
+            bool reserve(std::size_t size, bool drain_on_failure) noexcept;
+            // returns the bytes to the budget and its parents
+            void unreserve(std::size_t size) noexcept;
+            // returns the slack of all shards
+            void drain() noexcept;
+
+            shard                    shards_[shard_count];
+            std::atomic<std::size_t> reserved_;
+            std::atomic<bool>        above_soft_limit_;
+            std::size_t              soft_limit_, hard_limit_, granularity_;
+            memory_budget*           parent_;
+            limit_handler            handler_;
+            void*                    user_data_;
+        };
+
+        /// A \concept{concept_blockallocator,BlockAllocator} adapter that charges the size of each block to a \ref memory_budget.
+        /// As the budget is charged per block and not per node, it does not add anything to the allocation functions of the arena,
+        /// and the limit is enforced for all allocators sharing the budget hierarchy.
+        /// \note The budget must outlive the allocator.
+        /// \ingroup adapter
+        template <class BlockAllocator = growing_block_allocator<>>
+        class budgeted_block_allocator : FOONATHAN_EBO(BlockAllocator)
+        {
+        public:
+            using allocator_type = BlockAllocator;
+
+            /// \effects Creates it by giving it the block size, the budget
+            /// and forwarding the other arguments to the \concept{concept_blockallocator,BlockAllocator}.
+            /// \throws Anything thrown by the constructor of the \concept{concept_blockallocator,BlockAllocator}.
+            template <typename... Args>
+            explicit budgeted_block_allocator(std::size_t block_size, memory_budget& budget,
+                                              Args&&... args)
+            : allocator_type(block_size, detail::forward<Args>(args)...), budget_(&budget)
+            {
+            }
+
+            /// \effects Charges the size of the next block to the budget
+            /// and allocates it from the \concept{concept_blockallocator,BlockAllocator}.
+            /// \returns The new block.
+            /// \throws \ref out_of_memory if the budget cannot be charged,
+            /// or anything thrown by the \concept{concept_blockallocator,BlockAllocator}, then nothing is charged.
+            memory_block allocate_block()
+            {
+                auto size = allocator_type::next_block_size();
+                if (!budget_->try_charge(size))
+                    FOONATHAN_THROW(out_of_memory(info(), size));
+
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+                memory_block block;
+                try
+                {
+                    block = allocator_type::allocate_block();
+                }
+                catch (...)
+                {
+                    budget_->release(size);
+                    throw;
+                }
+#else
+                auto block = allocator_type::allocate_block();
+#endif
+
+                // the block allocator might not return a block of the announced size
+                if (block.size < size)
+                    budget_->release(size - block.size);
+                else if (block.size > size && !budget_->try_charge(block.size - size))
+                {
+                    allocator_type::deallocate_block(block);
+                    budget_->release(size);
+                    FOONATHAN_THROW(out_of_memory(info(), block.size));
+                }
+                return block;
+            }
+
+            /// \effects Deallocates the block and releases its size from the budget.
+            void deallocate_block(memory_block block) noexcept
+            {
+                allocator_type::deallocate_block(block);
+                budget_->release(block.size);
+            }
+
+            /// \returns The size of the next block of the \concept{concept_blockallocator,BlockAllocator}.
+            std::size_t next_block_size() const noexcept
+            {
+                return allocator_type::next_block_size();
+            }
+
+            /// \returns The alignment of the blocks of the \concept{concept_blockallocator,BlockAllocator}.
+            std::size_t block_alignment() const noexcept
+            {
+                return detail::block_alignment(0, get_allocator());
+            }
+
+            /// \returns Whether or not the \concept{concept_blockallocator,BlockAllocator} reports the last block as zeroed.
+            bool last_block_zeroed() const noexcept
+            {
+                return detail::last_block_zeroed(0, get_allocator());
+            }
+
+            /// @{
+            /// \returns A reference to the \concept{concept_blockallocator,BlockAllocator}.
+            allocator_type& get_allocator() noexcept
+            {
+                return *this;
+            }
+
+            const allocator_type& get_allocator() const noexcept
+            {
+                return *this;
+            }
+            /// @}
+
+            /// \returns A reference to the budget.
+            memory_budget& get_budget() const noexcept
+            {
+                return *budget_;
+            }
+
+        private:
+            allocator_info info() const noexcept
+            {
+                return {FOONATHAN_MEMORY_LOG_PREFIX "::budgeted_block_allocator", this};
+            }
+
+            memory_budget* budget_;
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_BUDGETED_BLOCK_ALLOCATOR_HPP_INCLUDED
@@ -0,0 +1,111 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_CACHED_BLOCK_ALLOCATOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_CACHED_BLOCK_ALLOCATOR_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::cached_block_allocator and related functions.
+
+#include <cstddef>
+
+#include "config.hpp"
+#include "memory_arena.hpp"
+
+#if !FOONATHAN_HOSTED_IMPLEMENTATION
+#error "cached_block_allocator requires a hosted implementation"
+#endif
+
+namespace foonathan
+{
+    namespace memory
+    {
+        namespace detail
+        {
+            // the blocks of the process-wide cache, each size is twice the previous one
+            constexpr std::size_t cached_block_min_size = 4096u;
+            constexpr std::size_t cached_block_classes  = 9u;
+            constexpr std::size_t cached_block_max_size = cached_block_min_size
+                                                          << (cached_block_classes - 1u);
+
+            // rounds the size up to the size of a cached block if it is not too big
+            std::size_t cached_block_size(std::size_t size) noexcept;
+
+            // takes a block from the cache of the calling thread or the process,
+            // allocates one with heap_alloc() if both are empty, returns nullptr on failure
+            void* allocate_cached_block(std::size_t size) noexcept;
+
+            // puts a block into the cache of the calling thread,
+            // if it is full, half of it is moved to the cache of the process
+            void deallocate_cached_block(void* memory, std::size_t size) noexcept;
+        } // namespace detail
+
+        /// \effects Sets the maximal total size of the blocks kept in the process-wide cache of the \ref cached_block_allocator,
+        /// blocks exceeding it are returned to the heap.
+        /// By default, it is \c 64MiB.
+        /// \note This does not include the blocks cached by the threads, at most four of each size per thread.
+        /// This function is thread-safe.
+        /// \ingroup allocator
+        void set_block_cache_limit(std::size_t max_bytes) noexcept;
+
+        /// \returns The total size of the blocks currently kept in the process-wide cache of the \ref cached_block_allocator.
+        /// \note This function is thread-safe.
+        /// \ingroup allocator
+        std::size_t block_cache_size() noexcept;
+
+        /// \effects Returns all blocks of the process-wide cache of the \ref cached_block_allocator
+        /// and the ones of the calling thread to the heap.
+        /// \note This function is thread-safe, a \ref reclamation_service calls it in each pass.
+        /// \ingroup allocator
+        void trim_block_cache() noexcept;
+
+        /// A \concept{concept_blockallocator,BlockAllocator} that takes its blocks from a cache shared by the whole process.
+        /// The block sizes are rounded up to a power of two starting at \c 4KiB,
+        /// blocks up to \c 1MiB are not freed but put into the cache when deallocated,
+        /// where any other \ref cached_block_allocator can take them from.
+        /// Each thread has a small cache of blocks of each size in front of the one of the process,
+        /// so constructing and destroying a \ref memory_arena, e.g. of a \ref memory_stack for each request,
+        /// usually just takes a block from and puts it back into the cache of the thread without any locking.
+        /// Like the \ref growing_block_allocator, the size of the next block doubles after each allocation.
+        /// Blocks that are not cached are allocated with \ref heap_alloc(), larger blocks as well.
+        /// \note As the allocator itself only stores the size of the next block,
+        /// blocks allocated by one object can be deallocated by another one.
+        /// \ingroup allocator
+        class cached_block_allocator
+        {
+        public:
+            /// \effects Creates it giving it the initial block size, it is rounded up to the next cached size.
+            /// \requires \c block_size must be greater than 0.
+            explicit cached_block_allocator(std::size_t block_size) noexcept
+            : block_size_(detail::cached_block_size(block_size))
+            {
+            }
+
+            /// \effects Takes a block of the next block size from a cache,
+            /// or allocates a new one, and doubles the block size for the next allocation.
+            /// \returns The new \ref memory_block.
+            /// \throws \ref out_of_memory if a new block could not be allocated.
+            memory_block allocate_block();
+
+            /// \effects Puts the block into the cache of the calling thread or deallocates it, if it is too big.
+            /// \requires \c block must be previously returned by a call to \ref allocate_block() of any object.
+            void deallocate_block(memory_block block) noexcept;
+
+            /// \returns The size of the memory block returned by the next call to \ref allocate_block().
+            std::size_t next_block_size() const noexcept
+            {
+                return block_size_;
+            }
+
+        private:
+            std::size_t block_size_;
+        };
+
+#if FOONATHAN_MEMORY_EXTERN_TEMPLATE
+        extern template class memory_arena<cached_block_allocator, true>;
+        extern template class memory_arena<cached_block_allocator, false>;
+#endif
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_CACHED_BLOCK_ALLOCATOR_HPP_INCLUDED
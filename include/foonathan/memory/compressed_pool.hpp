@@ -0,0 +1,515 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_COMPRESSED_POOL_HPP_INCLUDED
+#define FOONATHAN_MEMORY_COMPRESSED_POOL_HPP_INCLUDED
+
+/// \file
+/// Class template \ref foonathan::memory::compressed_node_pool and its 32bit fancy pointer.
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "detail/align.hpp"
+#include "detail/assert.hpp"
+#include "detail/debug_helpers.hpp"
+#include "detail/free_list.hpp"
+#include "detail/utility.hpp"
+#include "config.hpp"
+#include "error.hpp"
+#include "virtual_memory.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// The handle of a node of a \ref compressed_node_pool, \c 0 is the null handle.
+        /// \ingroup allocator
+        using compressed_handle = std::uint32_t;
+
+        /// The granularity of the offsets stored in a \ref compressed_handle,
+        /// a pool can thus span \c 32GiB.
+        /// \ingroup allocator
+        constexpr std::size_t compressed_handle_granularity = 8u;
+
+        /// A stateful \concept{concept_rawallocator,RawAllocator} that allocates nodes of a fixed size
+        /// that can be referred to by a 32bit \ref compressed_handle instead of a pointer.
+        /// All nodes live in one \ref virtual_buffer that is reserved for the maximum number of nodes,
+        /// and committed as the pool grows, so the nodes never move.
+        /// A handle is the offset of a node in the buffer, so converting between handles and pointers
+        /// is a single addition or subtraction.
+        /// The buffer is found via the \c Tag type, there can only be one pool for each \c Tag at a time;
+        /// this allows the \ref compressed_ptr to be only as big as the handle.
+        /// \note Like the \ref memory_pool, it is not thread-safe.
+        /// \ingroup allocator
+        template <class Tag>
+        class compressed_node_pool
+        {
+        public:
+            using is_stateful = std::true_type;
+
+            /// \effects Creates it giving it the size of the nodes and the maximum number of nodes,
+            /// the size is rounded up to a multiple of the \ref compressed_handle_granularity.
+            /// The virtual memory for all nodes is reserved, but none is committed yet.
+            /// It also becomes the pool of the \c Tag.
+            /// \requires There must be no other pool for the \c Tag,
+            /// \c node_size and \c max_nodes must be non-zero
+            /// and all nodes together must not be bigger than \c 32GiB.
+            /// \throws \ref out_of_memory if the virtual memory cannot be reserved.
+            compressed_node_pool(std::size_t node_size, std::size_t max_nodes)
+            : buffer_(round_up(node_size) * max_nodes),
+              list_(round_up(node_size)),
+              no_nodes_(0u),
+              max_nodes_(max_nodes)
+            {
+                FOONATHAN_MEMORY_ASSERT(node_size != 0u);
+                FOONATHAN_MEMORY_ASSERT_MSG(list_.node_size() * max_nodes
+                                                <= max_handle * compressed_handle_granularity,
+                                            "nodes cannot be addressed by 32bit handles");
+                FOONATHAN_MEMORY_ASSERT_MSG(!instance_, "there already is a pool for the tag");
+                instance_ = this;
+                base_     = static_cast<char*>(buffer_.data());
+            }
+
+            /// \effects Releases the memory of all nodes,
+            /// afterwards there is no pool for the \c Tag.
+            ~compressed_node_pool() noexcept
+            {
+                // the free list poisons the free nodes, the buffer gives the memory back as it is
+                detail::debug_unpoison(base_, no_nodes_ * node_size());
+                instance_ = nullptr;
+                base_     = nullptr;
+            }
+
+            /// \note As the pool of the \c Tag is global, it can neither be copied nor moved.
+            compressed_node_pool(const compressed_node_pool&)            = delete;
+            compressed_node_pool& operator=(const compressed_node_pool&) = delete;
+
+            /// \effects Allocates a single node, committing more memory if necessary.
+            /// \returns The node.
+            /// \throws \ref out_of_fixed_memory if the maximum number of nodes are in use,
+            /// or \ref out_of_memory if the memory cannot be committed.
+            void* allocate_node()
+            {
+                if (list_.empty())
+                    grow();
+                return list_.allocate();
+            }
+
+            /// \effects Deallocates a single node.
+            /// \requires \c node must have been returned by \ref allocate_node().
+            void deallocate_node(void* node) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(owns(node));
+                list_.deallocate(node);
+            }
+
+            /// \effects Allocates a single node.
+            /// \returns The handle of the node.
+            /// \throws Anything thrown by \ref allocate_node().
+            compressed_handle allocate_handle()
+            {
+                return get_handle(allocate_node());
+            }
+
+            /// \effects Deallocates the node with the given handle.
+            /// \requires \c handle must have been returned by \ref allocate_handle().
+            void deallocate_handle(compressed_handle handle) noexcept
+            {
+                deallocate_node(get_pointer(handle));
+            }
+
+            /// @{
+            /// \effects Allocates a single node.
+            /// \returns The node.
+            /// \throws Anything thrown by \ref allocate_node(),
+            /// or \ref bad_node_size or \ref bad_alignment if the memory does not fit into a node.
+            /// \note Arrays are only supported if they fit into a single node.
+            void* allocate_node(std::size_t size, std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_node_size>(size, node_size(), info());
+                detail::check_allocation_size<bad_alignment>(alignment, max_alignment(), info());
+                return allocate_node();
+            }
+
+            void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_array_size>(count * size, node_size(), info());
+                return allocate_node(count * size, alignment);
+            }
+            /// @}
+
+            /// @{
+            /// \effects Deallocates a single node.
+            void deallocate_node(void* ptr, std::size_t, std::size_t) noexcept
+            {
+                deallocate_node(ptr);
+            }
+
+            void deallocate_array(void* ptr, std::size_t, std::size_t, std::size_t) noexcept
+            {
+                deallocate_node(ptr);
+            }
+            /// @}
+
+            /// @{
+            /// \returns The size of a node.
+            std::size_t max_node_size() const noexcept
+            {
+                return node_size();
+            }
+
+            std::size_t max_array_size() const noexcept
+            {
+                return node_size();
+            }
+            /// @}
+
+            /// \returns The alignment of all nodes,
+            /// the biggest power of two the node size is a multiple of, at most \c alignof(std::max_align_t).
+            std::size_t max_alignment() const noexcept
+            {
+                auto alignment = node_size() & (~node_size() + 1u);
+                return alignment < detail::max_alignment ? alignment : detail::max_alignment;
+            }
+
+            /// \returns The pointer to the node with the given handle, or \c nullptr for the null handle.
+            /// \requires There must be a pool for the \c Tag.
+            static void* get_pointer(compressed_handle handle) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(base_);
+                return handle == 0u ? nullptr
+                                    : base_ + (handle - 1u) * compressed_handle_granularity;
+            }
+
+            /// \returns The handle of the memory, or the null handle for \c nullptr.
+            /// \requires The memory must be part of a node of the pool for the \c Tag
+            /// and aligned to the \ref compressed_handle_granularity.
+            static compressed_handle get_handle(const void* memory) noexcept
+            {
+                if (!memory)
+                    return 0u;
+                FOONATHAN_MEMORY_ASSERT(instance_ && instance_->owns(memory));
+                auto offset = std::size_t(static_cast<const char*>(memory) - base_);
+                FOONATHAN_MEMORY_ASSERT(offset % compressed_handle_granularity == 0u);
+                return compressed_handle(offset / compressed_handle_granularity + 1u);
+            }
+
+            /// \returns The pool of the \c Tag, or \c nullptr if there is none.
+            static compressed_node_pool* instance() noexcept
+            {
+                return instance_;
+            }
+
+            /// \returns Whether or not the memory is inside the buffer of the pool.
+            bool owns(const void* memory) const noexcept
+            {
+                auto ptr = static_cast<const char*>(memory);
+                return base_ <= ptr && ptr < base_ + list_.node_size() * no_nodes_;
+            }
+
+            /// \returns The size of each node.
+            std::size_t node_size() const noexcept
+            {
+                return list_.node_size();
+            }
+
+            /// \returns The number of nodes that can be allocated before the maximum is reached.
+            std::size_t capacity_left() const noexcept
+            {
+                return list_.capacity() + (max_nodes_ - no_nodes_);
+            }
+
+            /// \returns The maximum number of nodes.
+            std::size_t max_nodes() const noexcept
+            {
+                return max_nodes_;
+            }
+
+        private:
+            static constexpr std::size_t max_handle   = std::size_t(compressed_handle(-1));
+            static constexpr std::size_t min_grow_size = 64u * 1024u;
+
+            static std::size_t round_up(std::size_t node_size) noexcept
+            {
+                auto rest = node_size % compressed_handle_granularity;
+                return rest == 0u ? node_size : node_size + compressed_handle_granularity - rest;
+            }
+
+            allocator_info info() const noexcept
+            {
+                return {FOONATHAN_MEMORY_LOG_PREFIX "::compressed_node_pool", this};
+            }
+
+            void grow()
+            {
+                if (no_nodes_ == max_nodes_)
+                    FOONATHAN_THROW(out_of_fixed_memory(info(), node_size()));
+
+                // grows geometrically, but at least by a few pages
+                auto min_nodes = min_grow_size / node_size() + 1u;
+                auto new_nodes = no_nodes_ < min_nodes ? min_nodes : no_nodes_;
+                if (new_nodes > max_nodes_ - no_nodes_)
+                    new_nodes = max_nodes_ - no_nodes_;
+
+                buffer_.commit((no_nodes_ + new_nodes) * node_size());
+                list_.insert(base_ + no_nodes_ * node_size(), new_nodes * node_size());
+                no_nodes_ += new_nodes;
+            }
+
+            virtual_buffer           buffer_;
+            detail::free_memory_list list_;
+            std::size_t              no_nodes_, max_nodes_;
+
+            static compressed_node_pool* instance_;
+            static char*                 base_;
+        };
+
+        template <class Tag>
+        constexpr std::size_t compressed_node_pool<Tag>::max_handle;
+
+        template <class Tag>
+        constexpr std::size_t compressed_node_pool<Tag>::min_grow_size;
+
+        template <class Tag>
+        compressed_node_pool<Tag>* compressed_node_pool<Tag>::instance_ = nullptr;
+
+        template <class Tag>
+        char* compressed_node_pool<Tag>::base_ = nullptr;
+
+        /// A fancy pointer to an object in the \ref compressed_node_pool of the \c Tag,
+        /// it only stores a 32bit \ref compressed_handle.
+        /// It can be used for the links of node-based data structures like trees, tries or graphs,
+        /// halving their size on 64bit targets,
+        /// and as the \c pointer type of the \ref compressed_allocator.
+        /// \note Unlike a raw pointer, it can only point to memory of the pool
+        /// and it does not support pointer arithmetic.
+        /// \ingroup allocator
+        template <typename T, class Tag>
+        class compressed_ptr
+        {
+            using pool = compressed_node_pool<Tag>;
+
+        public:
+            using element_type    = T;
+            using difference_type = std::ptrdiff_t;
+
+            //=== constructors ===//
+            /// @{
+            /// \effects Creates a null pointer.
+            compressed_ptr() noexcept : handle_(0u) {}
+
+            compressed_ptr(std::nullptr_t) noexcept : handle_(0u) {}
+            /// @}
+
+            /// \effects Creates it from a raw pointer.
+            /// \requires The pointer must be \c nullptr or point into the pool of the \c Tag,
+            /// see \ref compressed_node_pool::get_handle().
+            explicit compressed_ptr(T* ptr) noexcept : handle_(pool::get_handle(ptr)) {}
+
+            /// \effects Creates it from a pointer to a different type whose raw pointer converts implicitly.
+            template <typename U, FOONATHAN_REQUIRES((std::is_convertible<U*, T*>::value))>
+            compressed_ptr(const compressed_ptr<U, Tag>& other) noexcept
+            : compressed_ptr(static_cast<T*>(other.get()))
+            {
+            }
+
+            /// \effects Creates it from a pointer to a different type whose raw pointer can be \c static_cast,
+            /// e.g. from a pointer to \c void.
+            template <typename U,
+                      FOONATHAN_REQUIRES((!std::is_convertible<U*, T*>::value
+                                          && (std::is_constructible<T*, U*>::value
+                                              || std::is_void<U>::value)))>
+            explicit compressed_ptr(const compressed_ptr<U, Tag>& other) noexcept
+            : compressed_ptr(static_cast<T*>(other.get()))
+            {
+            }
+
+            /// \returns A pointer from the handle.
+            static compressed_ptr from_handle(compressed_handle handle) noexcept
+            {
+                compressed_ptr result;
+                result.handle_ = handle;
+                return result;
+            }
+
+            /// \returns A pointer to the object, as required by \c std::pointer_traits.
+            template <typename U = T>
+            static compressed_ptr pointer_to(U& obj) noexcept
+            {
+                return compressed_ptr(&obj);
+            }
+
+            //=== access ===//
+            /// \returns The handle it stores.
+            compressed_handle handle() const noexcept
+            {
+                return handle_;
+            }
+
+            /// \returns The raw pointer.
+            T* get() const noexcept
+            {
+                return static_cast<T*>(pool::get_pointer(handle_));
+            }
+
+            /// \returns A reference to the object.
+            /// \requires It must not be null.
+            template <typename U = T>
+            U& operator*() const noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(handle_ != 0u);
+                return *get();
+            }
+
+            /// \returns The raw pointer.
+            T* operator->() const noexcept
+            {
+                return get();
+            }
+
+            /// \returns Whether or not it is not null.
+            explicit operator bool() const noexcept
+            {
+                return handle_ != 0u;
+            }
+
+            //=== comparison ===//
+            /// @{
+            /// \returns The result of comparing the handles, which matches the order of the raw pointers.
+            friend bool operator==(const compressed_ptr& a, const compressed_ptr& b) noexcept
+            {
+                return a.handle_ == b.handle_;
+            }
+
+            friend bool operator!=(const compressed_ptr& a, const compressed_ptr& b) noexcept
+            {
+                return a.handle_ != b.handle_;
+            }
+
+            friend bool operator<(const compressed_ptr& a, const compressed_ptr& b) noexcept
+            {
+                return a.handle_ < b.handle_;
+            }
+            /// @}
+
+            /// @{
+            /// \returns Whether or not the pointer is null.
+            friend bool operator==(const compressed_ptr& a, std::nullptr_t) noexcept
+            {
+                return a.handle_ == 0u;
+            }
+
+            friend bool operator==(std::nullptr_t, const compressed_ptr& a) noexcept
+            {
+                return a.handle_ == 0u;
+            }
+
+            friend bool operator!=(const compressed_ptr& a, std::nullptr_t) noexcept
+            {
+                return a.handle_ != 0u;
+            }
+
+            friend bool operator!=(std::nullptr_t, const compressed_ptr& a) noexcept
+            {
+                return a.handle_ != 0u;
+            }
+            /// @}
+
+        private:
+            compressed_handle handle_;
+        };
+
+        /// A stateless \c Allocator that allocates from the \ref compressed_node_pool of the \c Tag
+        /// and uses a \ref compressed_ptr as its \c pointer type,
+        /// so node-based containers store only 32bit pointers if their implementation supports fancy pointers.
+        /// \note The containers of libstdc++ do not support fancy pointers for their nodes,
+        /// but for example the ones of Boost.Container do.
+        /// \requires The pool of the \c Tag must exist while memory is allocated or deallocated,
+        /// and its nodes must be big enough for the nodes of the container.
+        /// \ingroup adapter
+        template <typename T, class Tag>
+        class compressed_allocator
+        {
+            using pool = compressed_node_pool<Tag>;
+
+        public:
+            //=== typedefs ===//
+            using value_type         = T;
+            using pointer            = compressed_ptr<T, Tag>;
+            using const_pointer      = compressed_ptr<const T, Tag>;
+            using void_pointer       = compressed_ptr<void, Tag>;
+            using const_void_pointer = compressed_ptr<const void, Tag>;
+            using size_type          = std::size_t;
+            using difference_type    = std::ptrdiff_t;
+
+            using propagate_on_container_swap            = std::true_type;
+            using propagate_on_container_move_assignment = std::true_type;
+            using propagate_on_container_copy_assignment = std::true_type;
+            using is_always_equal                        = std::true_type;
+
+            template <typename U>
+            struct rebind
+            {
+                using other = compressed_allocator<U, Tag>;
+            };
+
+            //=== constructor ===//
+            compressed_allocator() noexcept = default;
+
+            /// \effects Creates it from an allocator for a different type, as required by the \c Allocator concept.
+            template <typename U>
+            compressed_allocator(const compressed_allocator<U, Tag>&) noexcept
+            {
+            }
+
+            //=== allocation/deallocation ===//
+            /// \effects Allocates a node from the pool of the \c Tag.
+            /// \returns A pointer to memory suitable for \c n objects of type \c T.
+            /// \throws Anything thrown by the pool, e.g. if the objects do not fit in a node.
+            pointer allocate(size_type n)
+            {
+                FOONATHAN_MEMORY_ASSERT(pool::instance());
+                return pointer(
+                    static_cast<T*>(pool::instance()->allocate_array(n, sizeof(T), alignof(T))));
+            }
+
+            /// \effects Deallocates the node.
+            /// \requires The pointer must come from a previous call to \ref allocate().
+            void deallocate(pointer p, size_type) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(pool::instance());
+                pool::instance()->deallocate_node(p.get());
+            }
+
+            //=== getter ===//
+            /// \returns The maximum number of objects that fit into a node.
+            size_type max_size() const noexcept
+            {
+                auto p = pool::instance();
+                return p ? p->node_size() / sizeof(T) : 0u;
+            }
+        };
+
+        /// @{
+        /// \returns \c true, all allocators for the same \c Tag use the same pool.
+        /// \relatesalso compressed_allocator
+        template <typename T, typename U, class Tag>
+        bool operator==(const compressed_allocator<T, Tag>&,
+                        const compressed_allocator<U, Tag>&) noexcept
+        {
+            return true;
+        }
+
+        template <typename T, typename U, class Tag>
+        bool operator!=(const compressed_allocator<T, Tag>&,
+                        const compressed_allocator<U, Tag>&) noexcept
+        {
+            return false;
+        }
+        /// @}
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_COMPRESSED_POOL_HPP_INCLUDED
@@ -0,0 +1,432 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_CONCURRENT_MEMORY_STACK_HPP_INCLUDED
+#define FOONATHAN_MEMORY_CONCURRENT_MEMORY_STACK_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::concurrent_memory_stack and its \ref foonathan::memory::allocator_traits specialization.
+
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+
+#include "detail/assert.hpp"
+#include "detail/memory_stack.hpp"
+#include "config.hpp"
+#include "error.hpp"
+#include "memory_arena.hpp"
+#include "memory_stack.hpp"
+#include "thread_cached_pool.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+#if !defined(DOXYGEN)
+        template <class BlockOrRawAllocator, class Mutex>
+        class concurrent_memory_stack;
+#endif
+
+        namespace detail
+        {
+            class concurrent_stack_marker
+            {
+                std::size_t index;
+
+                explicit concurrent_stack_marker(std::size_t i) noexcept : index(i) {}
+
+                friend bool operator==(const concurrent_stack_marker& lhs,
+                                       const concurrent_stack_marker& rhs) noexcept
+                {
+                    return lhs.index == rhs.index;
+                }
+
+                friend bool operator!=(const concurrent_stack_marker& lhs,
+                                       const concurrent_stack_marker& rhs) noexcept
+                {
+                    return lhs.index != rhs.index;
+                }
+
+                friend bool operator<(const concurrent_stack_marker& lhs,
+                                      const concurrent_stack_marker& rhs) noexcept
+                {
+                    return lhs.index < rhs.index;
+                }
+
+                friend bool operator>(const concurrent_stack_marker& lhs,
+                                      const concurrent_stack_marker& rhs) noexcept
+                {
+                    return rhs < lhs;
+                }
+
+                friend bool operator<=(const concurrent_stack_marker& lhs,
+                                       const concurrent_stack_marker& rhs) noexcept
+                {
+                    return !(rhs < lhs);
+                }
+
+                friend bool operator>=(const concurrent_stack_marker& lhs,
+                                       const concurrent_stack_marker& rhs) noexcept
+                {
+                    return !(lhs < rhs);
+                }
+
+                template <class Impl, class Mutex>
+                friend class memory::concurrent_memory_stack;
+            };
+        } // namespace detail
+
+        /// A stateful \concept{concept_rawallocator,RawAllocator} that provides stack-like (LIFO) allocations
+        /// for multiple threads at once.
+        /// Each thread claims whole blocks from a shared \ref memory_arena and bump-allocates from its current block,
+        /// so only claiming a block locks the \c Mutex.
+        /// Unlike a \ref memory_stack there is no per-allocation unwinding,
+        /// but \ref unwind() to a marker returns the blocks of all threads claimed since the marker at once,
+        /// which makes it suitable for per-request scratch memory shared by multiple threads.
+        /// \note The block of a thread is kept if it exits, its memory is released by the next \ref unwind().
+        /// \ingroup allocator
+        template <class BlockOrRawAllocator = default_allocator, class Mutex = std::mutex>
+        class concurrent_memory_stack
+        {
+        public:
+            using allocator_type = make_block_allocator_t<BlockOrRawAllocator>;
+            using mutex          = Mutex;
+
+            /// \returns The minimum block size required for a stack containing the given amount of memory.
+            /// \requires `byte_size` must be a positive number.
+            /// \note Due to debug fence sizes, the actual amount of usable memory can vary.
+            static constexpr std::size_t min_block_size(std::size_t byte_size) noexcept
+            {
+                return detail::memory_block_stack::implementation_offset() + byte_size;
+            }
+
+            /// \effects Creates it with a given initial block size and and other constructor arguments for the \concept{concept_blockallocator,BlockAllocator}.
+            /// Unlike \ref memory_stack, it does not allocate a block yet,
+            /// each thread claims its first block on its first allocation.
+            template <typename... Args>
+            explicit concurrent_memory_stack(std::size_t block_size, Args&&... args)
+            : arena_(block_size, detail::forward<Args>(args)...), generation_(0u)
+            {
+            }
+
+            /// \effects Destroys the stack and all blocks.
+            /// \requires No other thread may use it anymore.
+            ~concurrent_memory_stack() noexcept
+            {
+                detail::release_thread_caches(this);
+            }
+
+            /// \note The per-thread states point to the object, so it can neither be copied nor moved.
+            concurrent_memory_stack(const concurrent_memory_stack&)            = delete;
+            concurrent_memory_stack& operator=(const concurrent_memory_stack&) = delete;
+
+            /// \effects Allocates a memory block of given size and alignment from the current block of the calling thread.
+            /// If there is not enough space left, the thread claims a new block from the shared arena,
+            /// which is allocated by the \concept{concept_blockallocator,BlockAllocator} or taken from its cache.
+            /// \returns A \concept{concept_node,node} with given size and alignment.
+            /// \throws Anything thrown by the \concept{concept_blockallocator,BlockAllocator} on growth,
+            /// \ref out_of_memory if the per-thread state cannot be allocated,
+            /// or \ref bad_allocation_size if \c size is too big.
+            /// \requires \c size and \c alignment must be valid.
+            void* allocate(std::size_t size, std::size_t alignment)
+            {
+                auto cache = get_cache();
+                if (!cache)
+                    FOONATHAN_THROW(out_of_memory(info(), sizeof(detail::thread_cache)
+                                                              + cache_slots * sizeof(void*)));
+
+                auto stack  = current_stack(*cache);
+                auto fence  = detail::debug_fence_size;
+                auto offset = detail::align_offset(stack.top() + fence, alignment);
+                if (!stack.top()
+                    || fence + offset + size + fence > std::size_t(block_end(*cache) - stack.top()))
+                {
+                    auto block = claim_block(*cache);
+                    stack      = detail::fixed_memory_stack(block.memory);
+
+                    // new alignment required for over-aligned types
+                    offset = detail::align_offset(stack.top() + fence, alignment);
+
+                    auto needed = fence + offset + size + fence;
+                    detail::check_allocation_size<bad_allocation_size>(needed, block.size, info());
+                }
+
+                auto memory = stack.allocate_unchecked(size, offset);
+                set_top(*cache, stack);
+                return memory;
+            }
+
+            /// \effects Allocates a memory block of given size and alignment from the current block of the calling thread,
+            /// similar to \ref allocate().
+            /// But it does not claim a new block.
+            /// \returns A \concept{concept_node,node} with given size and alignment
+            /// or `nullptr` if there wasn't enough memory available.
+            void* try_allocate(std::size_t size, std::size_t alignment) noexcept
+            {
+                auto cache = get_cache();
+                if (!cache)
+                    return nullptr;
+
+                auto stack  = current_stack(*cache);
+                auto memory = stack.allocate(block_end(*cache), size, alignment);
+                if (memory)
+                    set_top(*cache, stack);
+                return memory;
+            }
+
+            /// The marker type that is used for unwinding.
+            /// It remembers the number of blocks claimed by all threads so far,
+            /// and has all the comparision operators defined for two markers on the same stack.
+            using marker = FOONATHAN_IMPL_DEFINED(detail::concurrent_stack_marker);
+
+            /// \effects Makes each thread claim a new block on its next allocation,
+            /// so all memory allocated afterwards is released when unwinding to the result.
+            /// It can be called while other threads allocate, but then it is unspecified
+            /// whether their allocations at the same time belong to the marker.
+            /// \returns A marker to the current top of the stack.
+            marker top() noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                generation_.fetch_add(1u, std::memory_order_release);
+                return marker(arena_.size());
+            }
+
+            /// \effects Unwinds the stack of all threads to a marker position,
+            /// i.e. returns all blocks claimed since the marker was obtained to the cache of the arena.
+            /// Each thread will claim a new block on its next allocation.
+            /// \requires The marker must have been obtained by \ref top() on the same object
+            /// and the stack must not be unwound to an older marker in the mean time.
+            /// No other thread may allocate at the same time and all their allocations since the marker must not be used anymore,
+            /// e.g. by calling it after joining the threads or waiting for them on a barrier.
+            void unwind(marker m) noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                FOONATHAN_MEMORY_ASSERT_MSG(m.index <= arena_.size(), "invalid stack pointer");
+                while (arena_.size() > m.index)
+                    arena_.deallocate_block();
+                generation_.fetch_add(1u, std::memory_order_release);
+            }
+
+            /// \effects \ref unwind() does not actually do any deallocation of blocks on the \concept{concept_blockallocator,BlockAllocator},
+            /// unused memory is stored in a cache for later reuse.
+            /// This function clears that cache.
+            void shrink_to_fit() noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                arena_.shrink_to_fit();
+            }
+
+            /// \effects Limits the cache of unused blocks, similar to \ref memory_stack::set_cache_limits().
+            void set_cache_limits(const arena_cache_limits& limits) noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                arena_.set_cache_limits(limits);
+            }
+
+            /// \returns The amount of memory remaining in the current block of the calling thread.
+            std::size_t capacity_left() noexcept
+            {
+                auto cache = get_cache();
+                if (!cache)
+                    return 0u;
+                auto stack = current_stack(*cache);
+                return stack.top() ? std::size_t(block_end(*cache) - stack.top()) : 0u;
+            }
+
+            /// \returns The size of the next memory block claimed by a thread.
+            std::size_t next_capacity() const noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                return arena_.next_block_size();
+            }
+
+            /// \returns Whether or not `ptr` is in a block claimed by any thread.
+            bool owns(const void* ptr) const noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                return arena_.owns(ptr);
+            }
+
+            /// \returns A reference to the \concept{concept_blockallocator,BlockAllocator} used for managing the arena.
+            /// \requires It is undefined behavior to move this allocator out into another object.
+            allocator_type& get_allocator() noexcept
+            {
+                return arena_.get_allocator();
+            }
+
+        private:
+            // the per-thread state reuses the cache of thread_cached_pool:
+            // the slots store the top and end of the current block
+            // and count is the generation of the block plus one, zero if there is none
+            static constexpr std::size_t cache_slots = 2u;
+
+            allocator_info info() const noexcept
+            {
+                return {FOONATHAN_MEMORY_LOG_PREFIX "::concurrent_memory_stack", this};
+            }
+
+            detail::thread_cache* get_cache() noexcept
+            {
+                // one per thread and instantiation, the common case is a single object per thread
+                static thread_local detail::thread_cache* last = nullptr;
+                if (!last || last->owner.load(std::memory_order_relaxed) != this)
+                    last = detail::get_thread_cache(this, cache_slots, &on_thread_exit);
+                return last;
+            }
+
+            detail::fixed_memory_stack current_stack(detail::thread_cache& cache) const noexcept
+            {
+                if (cache.count != generation_.load(std::memory_order_acquire) + 1u)
+                    // block belongs to an older generation, if any
+                    cache.count = 0u;
+                return detail::fixed_memory_stack(cache.count == 0u ? nullptr : cache.nodes()[0]);
+            }
+
+            const char* block_end(detail::thread_cache& cache) const noexcept
+            {
+                return static_cast<const char*>(cache.nodes()[1]);
+            }
+
+            void set_top(detail::thread_cache&             cache,
+                         const detail::fixed_memory_stack& stack) noexcept
+            {
+                cache.nodes()[0] = stack.top();
+            }
+
+            memory_block claim_block(detail::thread_cache& cache)
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                auto                   block = arena_.allocate_block();
+                cache.nodes()[0]             = block.memory;
+                cache.nodes()[1]             = static_cast<char*>(block.memory) + block.size;
+                cache.count = generation_.load(std::memory_order_relaxed) + 1u;
+                return block;
+            }
+
+            static void on_thread_exit(void*, detail::thread_cache&) noexcept
+            {
+                // the block stays in the arena until it is unwound
+            }
+
+            memory_arena<allocator_type> arena_;
+            mutable Mutex                mutex_;
+            std::atomic<std::size_t>     generation_;
+
+            friend allocator_traits<concurrent_memory_stack>;
+            friend composable_allocator_traits<concurrent_memory_stack>;
+        };
+
+        template <class BlockOrRawAllocator, class Mutex>
+        constexpr std::size_t concurrent_memory_stack<BlockOrRawAllocator, Mutex>::cache_slots;
+
+#if FOONATHAN_MEMORY_EXTERN_TEMPLATE
+        extern template class concurrent_memory_stack<>;
+        extern template class memory_stack_raii_unwind<concurrent_memory_stack<>>;
+#endif
+
+        /// Specialization of the \ref allocator_traits for \ref concurrent_memory_stack classes.
+        /// \ingroup allocator
+        template <class BlockOrRawAllocator, class Mutex>
+        class allocator_traits<concurrent_memory_stack<BlockOrRawAllocator, Mutex>>
+        {
+        public:
+            using allocator_type       = concurrent_memory_stack<BlockOrRawAllocator, Mutex>;
+            using is_stateful          = std::true_type;
+            using is_deallocation_noop = std::true_type;
+
+            /// \returns The result of \ref concurrent_memory_stack::allocate().
+            static void* allocate_node(allocator_type& state, std::size_t size,
+                                       std::size_t alignment)
+            {
+                return state.allocate(size, alignment);
+            }
+
+            /// \returns The result of \ref concurrent_memory_stack::allocate().
+            static void* allocate_array(allocator_type& state, std::size_t count, std::size_t size,
+                                        std::size_t alignment)
+            {
+                return allocate_node(state, count * size, alignment);
+            }
+
+            /// @{
+            /// \effects Does nothing.
+            /// Actual deallocation can only be done via \ref concurrent_memory_stack::unwind().
+            static void deallocate_node(allocator_type&, void*, std::size_t, std::size_t) noexcept
+            {
+            }
+
+            static void deallocate_array(allocator_type&, void*, std::size_t, std::size_t,
+                                         std::size_t) noexcept
+            {
+            }
+            /// @}
+
+            /// @{
+            /// \returns The maximum size which is \ref concurrent_memory_stack::next_capacity().
+            static std::size_t max_node_size(const allocator_type& state) noexcept
+            {
+                return state.next_capacity();
+            }
+
+            static std::size_t max_array_size(const allocator_type& state) noexcept
+            {
+                return max_node_size(state);
+            }
+            /// @}
+
+            /// \returns The maximum possible value since there is no alignment restriction
+            /// (except indirectly through \ref concurrent_memory_stack::next_capacity()).
+            static std::size_t max_alignment(const allocator_type&) noexcept
+            {
+                return std::size_t(-1);
+            }
+        };
+
+        /// Specialization of the \ref composable_allocator_traits for \ref concurrent_memory_stack classes.
+        /// \ingroup allocator
+        template <class BlockOrRawAllocator, class Mutex>
+        class composable_allocator_traits<concurrent_memory_stack<BlockOrRawAllocator, Mutex>>
+        {
+        public:
+            using allocator_type = concurrent_memory_stack<BlockOrRawAllocator, Mutex>;
+
+            /// \returns The result of \ref concurrent_memory_stack::try_allocate().
+            static void* try_allocate_node(allocator_type& state, std::size_t size,
+                                           std::size_t alignment) noexcept
+            {
+                return state.try_allocate(size, alignment);
+            }
+
+            /// \returns The result of \ref concurrent_memory_stack::try_allocate().
+            static void* try_allocate_array(allocator_type& state, std::size_t count,
+                                            std::size_t size, std::size_t alignment) noexcept
+            {
+                return state.try_allocate(count * size, alignment);
+            }
+
+            /// @{
+            /// \effects Does nothing.
+            /// \returns Whether the memory will be deallocated by \ref concurrent_memory_stack::unwind().
+            static bool try_deallocate_node(allocator_type& state, void* ptr, std::size_t,
+                                            std::size_t) noexcept
+            {
+                return state.owns(ptr);
+            }
+
+            static bool try_deallocate_array(allocator_type& state, void* ptr, std::size_t count,
+                                             std::size_t size, std::size_t alignment) noexcept
+            {
+                return try_deallocate_node(state, ptr, count * size, alignment);
+            }
+            /// @}
+        };
+
+#if FOONATHAN_MEMORY_EXTERN_TEMPLATE
+        extern template class allocator_traits<concurrent_memory_stack<>>;
+        extern template class composable_allocator_traits<concurrent_memory_stack<>>;
+#endif
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_CONCURRENT_MEMORY_STACK_HPP_INCLUDED
@@ -33,6 +33,25 @@
 #define FOONATHAN_THROW(Ex) ((Ex), std::abort())
 #endif
 
+// branch prediction hints for the allocation fast paths
+#if defined(__GNUC__) || defined(__clang__)
+#define FOONATHAN_MEMORY_LIKELY(Cond) __builtin_expect(!!(Cond), 1)
+#define FOONATHAN_MEMORY_UNLIKELY(Cond) __builtin_expect(!!(Cond), 0)
+#else
+#define FOONATHAN_MEMORY_LIKELY(Cond) (Cond)
+#define FOONATHAN_MEMORY_UNLIKELY(Cond) (Cond)
+#endif
+
+// marks functions only called on error paths,
+// so they are not inlined into the allocation functions and are placed away from them
+#if defined(__GNUC__) || defined(__clang__)
+#define FOONATHAN_MEMORY_COLD __attribute__((cold, noinline))
+#elif defined(_MSC_VER)
+#define FOONATHAN_MEMORY_COLD __declspec(noinline)
+#else
+#define FOONATHAN_MEMORY_COLD
+#endif
+
 // hosted implementation
 #ifndef FOONATHAN_HOSTED_IMPLEMENTATION
 #if !_MSC_VER && !__STDC_HOSTED__
@@ -100,6 +119,13 @@
 /// \ingroup core
 #define FOONATHAN_MEMORY_CHECK_ALLOCATION_SIZE 1
 
+/// The allocator used by \ref foonathan::memory::heap_alloc() and \ref foonathan::memory::heap_dealloc().
+/// Set to `0` to use the allocation functions of the system, `1` for jemalloc,
+/// `2` for mimalloc and `3` for tcmalloc.
+/// The latter use the sized deallocation functions of the allocator.
+/// \ingroup allocator
+#define FOONATHAN_MEMORY_HEAP_BACKEND 0
+
 /// Whether or not internal assertions in the library are enabled.
 /// \ingroup core
 #define FOONATHAN_MEMORY_DEBUG_ASSERT 1
@@ -126,6 +152,24 @@
 /// \ingroup core
 #define FOONATHAN_MEMORY_DEBUG_DOUBLE_DEALLOC_CHECK 1
 
+/// Whether or not memory that is owned by an allocator but not handed out is poisoned,
+/// so that AddressSanitizer or Valgrind report accesses to it, e.g. after it has been deallocated.
+/// It only has an effect if the library is compiled with AddressSanitizer or the Valgrind headers are available.
+/// \note It is supported by \ref foonathan::memory::memory_stack and the allocators based on it,
+/// like \ref foonathan::memory::temporary_allocator, and by the \ref foonathan::memory::node_pool free list.
+/// \ingroup core
+#define FOONATHAN_MEMORY_DEBUG_POISON 1
+
+/// Whether or not the slow paths of the allocators have static tracepoints,
+/// i.e. USDT probes of the provider \c foonathan_memory that tools like perf, bpftrace or SystemTap can attach to.
+/// There are probes for the allocation and deallocation of blocks by a \ref foonathan::memory::memory_arena,
+/// hits and misses of its cache, \ref foonathan::memory::memory_arena::shrink_to_fit(),
+/// refills and flushes of the magazines of a \ref foonathan::memory::thread_cached_pool
+/// and the construction of a \ref foonathan::memory::out_of_memory.
+/// It only has an effect on platforms providing <tt>sys/sdt.h</tt>, without it the probes compile to nothing.
+/// \ingroup core
+#define FOONATHAN_MEMORY_TRACEPOINTS 0
+
 /// Whether or not everything is in namespace <tt>foonathan::memory</tt>.
 /// If \c false, a namespace alias <tt>namespace memory = foonathan::memory</tt> is automatically inserted into each header,
 /// allowing to qualify everything with <tt>foonathan::</tt>.
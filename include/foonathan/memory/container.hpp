@@ -20,6 +20,7 @@
 #include <forward_list>
 #include <list>
 #include <map>
+#include <memory>
 #include <queue>
 #include <scoped_allocator>
 #include <set>
@@ -29,6 +30,9 @@
 #include <unordered_set>
 #include <vector>
 
+#include "default_allocator.hpp"
+#include "memory_pool.hpp"
+#include "segregator.hpp"
 #include "std_allocator.hpp"
 #include "threading.hpp"
 
@@ -238,6 +242,91 @@ namespace foonathan
         }
         /// @}
 
+        /// A wrapper around a container whose destructor is skipped if that does not change anything,
+        /// i.e. if deallocation of its \concept{concept_rawallocator,RawAllocator} is a no-op
+        /// as determined by \ref is_deallocation_noop and its elements are trivially destructible.
+        /// Destroying a node based container like a \c std::map otherwise needs to visit every node,
+        /// only to hand it to a deallocation function that does nothing;
+        /// with a \ref memory_stack for example the memory is released by \ref memory_stack::unwind()
+        /// or the destructor of the stack instead.
+        /// In all other cases it destroys the container normally.
+        /// \requires \c Container must use a \ref std_allocator.
+        /// \ingroup adapter
+        template <class Container>
+        class arena_container
+        {
+        public:
+            using container_type = Container;
+            using allocator_type = typename Container::allocator_type::allocator_type;
+
+            /// Whether or not the destructor of the container is skipped.
+            using skips_destruction = std::integral_constant<
+                bool, is_deallocation_noop<allocator_type>::value
+                          && std::is_trivially_destructible<typename Container::value_type>::value>;
+
+            /// \effects Creates the container forwarding the arguments to its constructor.
+            template <typename... Args>
+            explicit arena_container(Args&&... args)
+            : container_(detail::forward<Args>(args)...)
+            {
+            }
+
+            /// \effects Destroys the container, unless \ref skips_destruction is \c true.
+            ~arena_container() noexcept
+            {
+                destroy(skips_destruction{});
+            }
+
+            arena_container(const arena_container&)            = delete;
+            arena_container& operator=(const arena_container&) = delete;
+
+            /// @{
+            /// \returns A reference to the container.
+            container_type& get() noexcept
+            {
+                return container_;
+            }
+
+            const container_type& get() const noexcept
+            {
+                return container_;
+            }
+
+            container_type& operator*() noexcept
+            {
+                return container_;
+            }
+
+            const container_type& operator*() const noexcept
+            {
+                return container_;
+            }
+
+            container_type* operator->() noexcept
+            {
+                return &container_;
+            }
+
+            const container_type* operator->() const noexcept
+            {
+                return &container_;
+            }
+            /// @}
+
+        private:
+            void destroy(std::true_type) noexcept {}
+
+            void destroy(std::false_type) noexcept
+            {
+                container_.~container_type();
+            }
+
+            union
+            {
+                container_type container_;
+            };
+        };
+
 #if !defined(DOXYGEN)
 
 #include "detail/container_node_sizes.hpp"
@@ -276,7 +365,8 @@ namespace foonathan
 
         /// Contains the node size of a node based STL container with a specific type.
         ///
-        /// This trait is auto-generated and may not be available depending on the build configuration,
+        /// This trait is computed from the node types of the standard library if it is supported (currently libstdc++),
+        /// otherwise it is auto-generated and may not be available depending on the build configuration,
         /// especially when doing cross compilation.
         template <typename T>
         struct forward_list_node_size : std::integral_constant<std::size_t, implementation_defined>
@@ -316,7 +406,8 @@ namespace foonathan
 
         /// Contains the node size of a node based STL container with a specific type.
         ///
-        /// This trait is auto-generated and may not be available depending on the build configuration,
+        /// This trait is computed from the node types of the standard library if it is supported (currently libstdc++),
+        /// otherwise it is auto-generated and may not be available depending on the build configuration,
         /// especially when doing cross compilation.
         ///
         /// \notes `T` is always the `value_type` of the container, e.g. `std::pair<const Key, Value>`.
@@ -360,6 +451,300 @@ namespace foonathan
         struct allocate_shared_node_size : shared_ptr_node_size<T, std_allocator<T, RawAllocator>>
         {
         };
+
+        /// \exclude
+        namespace detail
+        {
+            template <class Container>
+            struct container_node_size
+            {
+                static_assert(sizeof(Container) != sizeof(Container),
+                              "unsupported container type");
+            };
+
+            template <typename T, class Allocator>
+            struct container_node_size<std::forward_list<T, Allocator>>
+            : forward_list_node_size<T>
+            {
+            };
+
+            template <typename T, class Allocator>
+            struct container_node_size<std::list<T, Allocator>> : list_node_size<T>
+            {
+            };
+
+            template <typename T, class Compare, class Allocator>
+            struct container_node_size<std::set<T, Compare, Allocator>> : set_node_size<T>
+            {
+            };
+
+            template <typename T, class Compare, class Allocator>
+            struct container_node_size<std::multiset<T, Compare, Allocator>>
+            : multiset_node_size<T>
+            {
+            };
+
+            template <typename T, class Hash, class KeyEqual, class Allocator>
+            struct container_node_size<std::unordered_set<T, Hash, KeyEqual, Allocator>>
+            : unordered_set_node_size<T>
+            {
+            };
+
+            template <typename T, class Hash, class KeyEqual, class Allocator>
+            struct container_node_size<std::unordered_multiset<T, Hash, KeyEqual, Allocator>>
+            : unordered_multiset_node_size<T>
+            {
+            };
+
+            template <typename Key, typename Value, class Compare, class Allocator>
+            struct container_node_size<std::map<Key, Value, Compare, Allocator>>
+            : map_node_size<std::pair<const Key, Value>>
+            {
+            };
+
+            template <typename Key, typename Value, class Compare, class Allocator>
+            struct container_node_size<std::multimap<Key, Value, Compare, Allocator>>
+            : multimap_node_size<std::pair<const Key, Value>>
+            {
+            };
+
+            template <typename Key, typename Value, class Hash, class KeyEqual, class Allocator>
+            struct container_node_size<std::unordered_map<Key, Value, Hash, KeyEqual, Allocator>>
+            : unordered_map_node_size<std::pair<const Key, Value>>
+            {
+            };
+
+            template <typename Key, typename Value, class Hash, class KeyEqual, class Allocator>
+            struct container_node_size<
+                std::unordered_multimap<Key, Value, Hash, KeyEqual, Allocator>>
+            : unordered_multimap_node_size<std::pair<const Key, Value>>
+            {
+            };
+        } // namespace detail
+
+        /// The node size of a node based STL container,
+        /// i.e. the matching trait like \ref list_node_size for its value type.
+        /// The allocator of the container does not matter.
+        /// \ingroup adapter
+        template <class Container>
+        struct container_node_size : detail::container_node_size<Container>
+        {
+        };
+
+        /// A \ref binary_segregator that allocates nodes from a \ref memory_pool
+        /// and arrays from the `ArrayAllocator`, a \concept{concept_rawallocator,RawAllocator}.
+        /// It is constructed with the same arguments as the \ref memory_pool,
+        /// so it can be used as the pool of a \ref container_node_pool for unordered containers,
+        /// e.g. `container_node_pool<unordered_map<int, int, pooled_node_segregator<>>>`:
+        /// the nodes are allocated from the pool and the bucket arrays from the `ArrayAllocator`,
+        /// instead of failing with an exception in a \ref node_pool.
+        /// \ingroup adapter
+        template <class PoolType = node_pool, class ArrayAllocator = default_allocator,
+                  class BlockOrRawAllocator = default_allocator>
+        class pooled_node_segregator
+        : public binary_segregator<node_segregatable<memory_pool<PoolType, BlockOrRawAllocator>>,
+                                   ArrayAllocator>
+        {
+            using segregator =
+                binary_segregator<node_segregatable<memory_pool<PoolType, BlockOrRawAllocator>>,
+                                  ArrayAllocator>;
+
+        public:
+            using pool_type = memory_pool<PoolType, BlockOrRawAllocator>;
+
+            /// \returns The minimum block size of the \ref memory_pool for the given number of nodes.
+            static constexpr std::size_t min_block_size(std::size_t node_size,
+                                                        std::size_t number_of_nodes) noexcept
+            {
+                return pool_type::min_block_size(node_size, number_of_nodes);
+            }
+
+            /// \effects Creates the \ref memory_pool by forwarding the arguments,
+            /// it is used for all nodes up to the `node_size`,
+            /// and default constructs the `ArrayAllocator`.
+            template <typename... Args>
+            pooled_node_segregator(std::size_t node_size, std::size_t block_size, Args&&... args)
+            : segregator(node_threshold(node_size, pool_type(node_size, block_size,
+                                                             detail::forward<Args>(args)...)))
+            {
+            }
+
+            /// @{
+            /// \returns A reference to the \ref memory_pool used for the nodes.
+            pool_type& get_node_pool() noexcept
+            {
+                return this->get_segregatable_allocator();
+            }
+
+            const pool_type& get_node_pool() const noexcept
+            {
+                return this->get_segregatable_allocator();
+            }
+            /// @}
+
+            /// @{
+            /// \returns A reference to the `ArrayAllocator` used for the arrays.
+            typename segregator::fallback_allocator_type& get_array_allocator() noexcept
+            {
+                return this->get_fallback_allocator();
+            }
+
+            const typename segregator::fallback_allocator_type& get_array_allocator() const noexcept
+            {
+                return this->get_fallback_allocator();
+            }
+            /// @}
+        };
+
+        /// A pool whose nodes are exactly big enough for the nodes of the node based STL container \c Container,
+        /// as given by \ref container_node_size.
+        /// \c Container must use a \ref std_allocator of the pool type, e.g. `list<int, memory_pool<>>`,
+        /// so getting the node size wrong cannot send the allocations of the container to a slower path.
+        /// Unordered containers also allocate their bucket arrays from the pool,
+        /// so it must support array allocations, e.g. a \ref memory_pool with \ref array_pool,
+        /// or use a \ref pooled_node_segregator to allocate them elsewhere.
+        /// \requires The pool must live as long as all containers created from it.
+        /// \ingroup adapter
+        template <class Container>
+        class container_node_pool
+        {
+        public:
+            using container_type = Container;
+            using allocator_type = typename container_type::allocator_type::allocator_type;
+
+            /// The node size of the pool required for one node of the container.
+            static constexpr std::size_t node_size = container_node_size<Container>::value;
+
+            /// \returns The minimum block size required for the given number of nodes.
+            static constexpr std::size_t min_block_size(std::size_t number_of_nodes) noexcept
+            {
+                return allocator_type::min_block_size(node_size, number_of_nodes);
+            }
+
+            /// \effects Creates it by creating the pool with the \ref node_size
+            /// and the given block size and other arguments.
+            template <typename... Args>
+            explicit container_node_pool(std::size_t block_size, Args&&... args)
+            : pool_(node_size, block_size, detail::forward<Args>(args)...)
+            {
+            }
+
+            container_node_pool(const container_node_pool&)            = delete;
+            container_node_pool& operator=(const container_node_pool&) = delete;
+
+            /// \returns An empty container that uses the pool for its allocations.
+            container_type make_container()
+            {
+                return container_type(typename container_type::allocator_type(pool_));
+            }
+
+            /// @{
+            /// \returns A reference to the pool used for the allocation.
+            allocator_type& get_allocator() noexcept
+            {
+                return pool_;
+            }
+
+            const allocator_type& get_allocator() const noexcept
+            {
+                return pool_;
+            }
+            /// @}
+
+        private:
+            allocator_type pool_;
+        };
+
+        template <class Container>
+        constexpr std::size_t container_node_pool<Container>::node_size;
+
+        /// \returns An empty \ref list that uses the \ref container_node_pool for its allocations.
+        /// \ingroup adapter
+        template <typename T, class RawAllocator>
+        list<T, RawAllocator> make_pooled_list(container_node_pool<list<T, RawAllocator>>& pool)
+        {
+            return pool.make_container();
+        }
+
+        /// \returns An empty \ref forward_list that uses the \ref container_node_pool for its allocations.
+        /// \ingroup adapter
+        template <typename T, class RawAllocator>
+        forward_list<T, RawAllocator> make_pooled_forward_list(
+            container_node_pool<forward_list<T, RawAllocator>>& pool)
+        {
+            return pool.make_container();
+        }
+
+        /// \returns An empty \ref set that uses the \ref container_node_pool for its allocations.
+        /// \ingroup adapter
+        template <typename T, class RawAllocator>
+        set<T, RawAllocator> make_pooled_set(container_node_pool<set<T, RawAllocator>>& pool)
+        {
+            return pool.make_container();
+        }
+
+        /// \returns An empty \ref multiset that uses the \ref container_node_pool for its allocations.
+        /// \ingroup adapter
+        template <typename T, class RawAllocator>
+        multiset<T, RawAllocator> make_pooled_multiset(
+            container_node_pool<multiset<T, RawAllocator>>& pool)
+        {
+            return pool.make_container();
+        }
+
+        /// \returns An empty \ref map that uses the \ref container_node_pool for its allocations.
+        /// \ingroup adapter
+        template <typename Key, typename Value, class RawAllocator>
+        map<Key, Value, RawAllocator> make_pooled_map(
+            container_node_pool<map<Key, Value, RawAllocator>>& pool)
+        {
+            return pool.make_container();
+        }
+
+        /// \returns An empty \ref multimap that uses the \ref container_node_pool for its allocations.
+        /// \ingroup adapter
+        template <typename Key, typename Value, class RawAllocator>
+        multimap<Key, Value, RawAllocator> make_pooled_multimap(
+            container_node_pool<multimap<Key, Value, RawAllocator>>& pool)
+        {
+            return pool.make_container();
+        }
+
+        /// \returns An empty \ref unordered_set that uses the \ref container_node_pool for its allocations.
+        /// \ingroup adapter
+        template <typename T, class RawAllocator>
+        unordered_set<T, RawAllocator> make_pooled_unordered_set(
+            container_node_pool<unordered_set<T, RawAllocator>>& pool)
+        {
+            return pool.make_container();
+        }
+
+        /// \returns An empty \ref unordered_multiset that uses the \ref container_node_pool for its allocations.
+        /// \ingroup adapter
+        template <typename T, class RawAllocator>
+        unordered_multiset<T, RawAllocator> make_pooled_unordered_multiset(
+            container_node_pool<unordered_multiset<T, RawAllocator>>& pool)
+        {
+            return pool.make_container();
+        }
+
+        /// \returns An empty \ref unordered_map that uses the \ref container_node_pool for its allocations.
+        /// \ingroup adapter
+        template <typename Key, typename Value, class RawAllocator>
+        unordered_map<Key, Value, RawAllocator> make_pooled_unordered_map(
+            container_node_pool<unordered_map<Key, Value, RawAllocator>>& pool)
+        {
+            return pool.make_container();
+        }
+
+        /// \returns An empty \ref unordered_multimap that uses the \ref container_node_pool for its allocations.
+        /// \ingroup adapter
+        template <typename Key, typename Value, class RawAllocator>
+        unordered_multimap<Key, Value, RawAllocator> make_pooled_unordered_multimap(
+            container_node_pool<unordered_multimap<Key, Value, RawAllocator>>& pool)
+        {
+            return pool.make_container();
+        }
 #endif
     } // namespace memory
 } // namespace foonathan
@@ -0,0 +1,146 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_COROUTINE_ALLOCATOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_COROUTINE_ALLOCATOR_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::coroutine_frame_allocator.
+
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#include "detail/align.hpp"
+#include "detail/utility.hpp"
+#include "allocator_storage.hpp"
+#include "config.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// A base class for the promise type of a coroutine that allocates the coroutine frame
+        /// from a \concept{concept_rawallocator,RawAllocator} instead of the global <tt>operator new</tt>.
+        ///
+        /// The allocator is passed to the coroutine as an argument preceded by \c std::allocator_arg,
+        /// as the first two parameters of a free coroutine
+        /// or the first two parameters after the object parameter of a member coroutine:
+        /// \code
+        /// task handle(std::allocator_arg_t, memory::memory_stack<>& stack, request req);
+        /// ...
+        /// auto t = handle(std::allocator_arg, stack, req);
+        /// \endcode
+        /// The allocator is used through an \ref allocator_reference, stored at the end of the frame,
+        /// so it must outlive the coroutine; with the default type-erased \ref any_allocator,
+        /// any \concept{concept_rawallocator,RawAllocator} can be passed.
+        /// If the allocator is stateless, nothing is stored and coroutines without allocator argument use a default-constructed one,
+        /// otherwise they trigger a \c static_assert.
+        /// \note The frames are allocated as nodes with an alignment of \c alignof(std::max_align_t),
+        /// so they can come from a \ref memory_pool_collection or a \ref memory_stack.
+        /// \note Some versions of GCC wrongly report \c -Wmismatched-new-delete for coroutines
+        /// with a placement allocation function like this one.
+        /// \ingroup adapter
+        template <class RawAllocator = any_allocator>
+        class coroutine_frame_allocator
+        {
+            using reference = allocator_reference<RawAllocator>;
+
+        public:
+            /// \effects Allocates the frame of a free coroutine from the given allocator
+            /// and stores a reference to it.
+            /// \returns The memory for the frame.
+            /// \throws Anything thrown by the allocation function.
+            template <class Allocator, typename... Args>
+            static void* operator new(std::size_t size, std::allocator_arg_t, Allocator& alloc,
+                                      const Args&...)
+            {
+                return allocate_frame(size, reference(alloc));
+            }
+
+            /// \effects Allocates the frame of a member coroutine from the given allocator
+            /// and stores a reference to it.
+            /// \returns The memory for the frame.
+            /// \throws Anything thrown by the allocation function.
+            template <class Class, class Allocator, typename... Args>
+            static void* operator new(std::size_t size, const Class&, std::allocator_arg_t,
+                                      Allocator& alloc, const Args&...)
+            {
+                return allocate_frame(size, reference(alloc));
+            }
+
+            /// \effects Allocates the frame of a coroutine without allocator argument
+            /// from a default-constructed allocator.
+            /// \returns The memory for the frame.
+            /// \throws Anything thrown by the allocation function.
+            /// \requires The allocator must be stateless.
+            static void* operator new(std::size_t size)
+            {
+                static_assert(!stores_reference::value,
+                              "coroutine must take std::allocator_arg and the allocator");
+                return allocate_frame(size, default_reference());
+            }
+
+            /// \effects Deallocates the frame through the allocator stored in it.
+            static void operator delete(void* frame, std::size_t size) noexcept
+            {
+                auto ref = take_reference(frame, size, stores_reference{});
+                ref.deallocate_node(frame, frame_size(size), detail::max_alignment);
+            }
+
+            /// \returns The number of bytes allocated for a coroutine frame of the given size,
+            /// including the stored reference to the allocator.
+            static constexpr std::size_t frame_size(std::size_t size) noexcept
+            {
+                return stores_reference::value ? reference_offset(size) + sizeof(reference) : size;
+            }
+
+        private:
+            using stores_reference = std::integral_constant<bool, !std::is_empty<reference>::value>;
+
+            static constexpr std::size_t reference_offset(std::size_t size) noexcept
+            {
+                return (size + alignof(reference) - 1u) / alignof(reference) * alignof(reference);
+            }
+
+            static void* allocate_frame(std::size_t size, reference ref)
+            {
+                auto frame = ref.allocate_node(frame_size(size), detail::max_alignment);
+                store_reference(frame, size, detail::move(ref), stores_reference{});
+                return frame;
+            }
+
+            static void store_reference(void* frame, std::size_t size, reference&& ref,
+                                        std::true_type) noexcept
+            {
+                ::new (static_cast<char*>(frame) + reference_offset(size))
+                    reference(detail::move(ref));
+            }
+
+            static void store_reference(void*, std::size_t, reference&&, std::false_type) noexcept
+            {
+            }
+
+            static reference take_reference(void* frame, std::size_t size, std::true_type) noexcept
+            {
+                auto stored = reinterpret_cast<reference*>(static_cast<char*>(frame)
+                                                           + reference_offset(size));
+                auto ref    = detail::move(*stored);
+                stored->~reference();
+                return ref;
+            }
+
+            static reference take_reference(void*, std::size_t, std::false_type) noexcept
+            {
+                return default_reference();
+            }
+
+            static reference default_reference() noexcept
+            {
+                return reference(typename reference::allocator_type());
+            }
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_COROUTINE_ALLOCATOR_HPP_INCLUDED
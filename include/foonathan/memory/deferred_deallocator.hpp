@@ -0,0 +1,318 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_DEFERRED_DEALLOCATOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_DEFERRED_DEALLOCATOR_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::deferred_deallocator.
+
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+#include "detail/assert.hpp"
+#include "detail/utility.hpp"
+#include "allocator_traits.hpp"
+#include "config.hpp"
+#include "heap_allocator.hpp"
+#include "thread_cached_pool.hpp"
+#include "threading.hpp"
+
+#if !FOONATHAN_HOSTED_IMPLEMENTATION
+#error "deferred_deallocator requires a hosted implementation"
+#endif
+
+namespace foonathan
+{
+    namespace memory
+    {
+        namespace detail
+        {
+            // a deallocation that has not been done yet, a count of zero means it is a node
+            struct deferred_deallocation
+            {
+                void*       memory;
+                std::size_t count, size, alignment;
+            };
+        } // namespace detail
+
+        /// A \concept{concept_rawallocator,RawAllocator} adapter that moves the deallocations off the calling threads.
+        /// Allocations are forwarded to the \c RawAllocator while holding a \c Mutex, like a \ref thread_safe_allocator.
+        /// Deallocations are only recorded in a buffer of the calling thread;
+        /// once it holds \c BatchSize of them, the batch is handed to a background thread,
+        /// which does all deallocations of the batches it has received while holding the \c Mutex only once.
+        /// This keeps lock acquisitions and the work of the deallocations off latency-critical threads,
+        /// e.g. when destroying a big container.
+        /// \note The memory only becomes available again for allocations after the background thread has processed the batch,
+        /// use \ref flush() or \ref drain() to hand over a partial batch.
+        /// The buffer of a thread is handed over when the thread exits.
+        /// \ingroup adapter
+        template <class RawAllocator, class Mutex = std::mutex, std::size_t BatchSize = 256u>
+        class deferred_deallocator
+        {
+            static_assert(BatchSize > 0u, "batch must be able to store at least one deallocation");
+
+            using traits     = allocator_traits<RawAllocator>;
+            using mutex_type = detail::mutex_for<RawAllocator, Mutex>;
+            using entry      = detail::deferred_deallocation;
+
+            struct batch
+            {
+                batch*      next;
+                std::size_t count;
+                entry       entries[BatchSize];
+            };
+
+        public:
+            using allocator_type = typename traits::allocator_type;
+            using mutex          = Mutex;
+            using is_stateful    = std::true_type;
+
+            static constexpr std::size_t batch_size = BatchSize;
+
+            /// \effects Creates it from the allocator and starts the background thread.
+            /// \throws Anything thrown by the constructor of \c std::thread.
+            explicit deferred_deallocator(allocator_type alloc = allocator_type())
+            : alloc_(detail::move(alloc)), queue_(nullptr), pending_(0u), stop_(false)
+            {
+                // started last, after all members are initialized
+                thread_ = std::thread([this] { run(); });
+            }
+
+            /// \effects Hands over the buffers of all threads, waits for the background thread to process them
+            /// and stops it.
+            /// \requires No other thread may use it anymore.
+            ~deferred_deallocator() noexcept
+            {
+                detail::flush_thread_caches(this);
+                {
+                    std::lock_guard<std::mutex> lock(queue_mutex_);
+                    stop_ = true;
+                }
+                wakeup_.notify_one();
+                thread_.join();
+            }
+
+            /// \note The buffers of the threads point to the object, so it can neither be copied nor moved.
+            deferred_deallocator(const deferred_deallocator&)            = delete;
+            deferred_deallocator& operator=(const deferred_deallocator&) = delete;
+
+            /// @{
+            /// \effects Allocates memory from the allocator while holding the mutex.
+            /// \returns The result of the allocator.
+            /// \throws Anything thrown by the allocator.
+            void* allocate_node(std::size_t size, std::size_t alignment)
+            {
+                std::lock_guard<mutex_type> lock(mutex_);
+                return traits::allocate_node(alloc_, size, alignment);
+            }
+
+            void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+            {
+                std::lock_guard<mutex_type> lock(mutex_);
+                return traits::allocate_array(alloc_, count, size, alignment);
+            }
+            /// @}
+
+            /// @{
+            /// \effects Records the deallocation in the buffer of the calling thread,
+            /// if the buffer is full, it is handed to the background thread.
+            /// If the buffer or a batch cannot be allocated, the memory is deallocated immediately.
+            void deallocate_node(void* ptr, std::size_t size, std::size_t alignment) noexcept
+            {
+                defer({ptr, 0u, size, alignment});
+            }
+
+            void deallocate_array(void* ptr, std::size_t count, std::size_t size,
+                                  std::size_t alignment) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(count != 0u);
+                defer({ptr, count, size, alignment});
+            }
+            /// @}
+
+            /// @{
+            /// \returns The maximum sizes and alignment of the allocator.
+            std::size_t max_node_size() const
+            {
+                std::lock_guard<mutex_type> lock(mutex_);
+                return traits::max_node_size(alloc_);
+            }
+
+            std::size_t max_array_size() const
+            {
+                std::lock_guard<mutex_type> lock(mutex_);
+                return traits::max_array_size(alloc_);
+            }
+
+            std::size_t max_alignment() const
+            {
+                std::lock_guard<mutex_type> lock(mutex_);
+                return traits::max_alignment(alloc_);
+            }
+            /// @}
+
+            /// \effects Hands the buffer of the calling thread to the background thread, even if it is not full.
+            void flush() noexcept
+            {
+                if (auto cache = get_cache())
+                    submit(*cache);
+            }
+
+            /// \effects Hands the buffer of the calling thread to the background thread
+            /// and waits until it has processed all batches handed to it so far.
+            /// \note Buffers of other threads are not handed over.
+            void drain() noexcept
+            {
+                flush();
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                done_.wait(lock, [&] { return pending_ == 0u; });
+            }
+
+            /// \returns The number of batches handed to the background thread that it has not processed yet.
+            std::size_t pending_batches() const noexcept
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex_);
+                return pending_;
+            }
+
+        private:
+            // the buffer of a thread is a thread cache storing entries instead of nodes
+            static constexpr std::size_t buffer_capacity =
+                BatchSize * ((sizeof(entry) + sizeof(void*) - 1u) / sizeof(void*));
+
+            static entry* entries(detail::thread_cache& cache) noexcept
+            {
+                return reinterpret_cast<entry*>(cache.nodes());
+            }
+
+            detail::thread_cache* get_cache() noexcept
+            {
+                static thread_local detail::thread_cache* last = nullptr;
+                if (!last || last->owner.load(std::memory_order_relaxed) != this)
+                    last = detail::get_thread_cache(this, buffer_capacity, &submit_cache);
+                return last;
+            }
+
+            void defer(const entry& e) noexcept
+            {
+                auto cache = get_cache();
+                if (!cache)
+                {
+                    deallocate_now(&e, 1u);
+                    return;
+                }
+
+                entries(*cache)[cache->count++] = e;
+                if (cache->count == BatchSize)
+                    submit(*cache);
+            }
+
+            void submit(detail::thread_cache& cache) noexcept
+            {
+                if (cache.count == 0u)
+                    return;
+
+                auto memory = heap_alloc(sizeof(batch));
+                if (!memory)
+                {
+                    deallocate_now(entries(cache), cache.count);
+                    cache.count = 0u;
+                    return;
+                }
+
+                auto b   = ::new (memory) batch;
+                b->count = cache.count;
+                for (std::size_t i = 0u; i != cache.count; ++i)
+                    b->entries[i] = entries(cache)[i];
+                cache.count = 0u;
+
+                {
+                    std::lock_guard<std::mutex> lock(queue_mutex_);
+                    b->next = queue_;
+                    queue_  = b;
+                    ++pending_;
+                }
+                wakeup_.notify_one();
+            }
+
+            static void submit_cache(void* owner, detail::thread_cache& cache) noexcept
+            {
+                static_cast<deferred_deallocator*>(owner)->submit(cache);
+            }
+
+            void deallocate(const entry* e, std::size_t n) noexcept
+            {
+                for (auto end = e + n; e != end; ++e)
+                    if (e->count == 0u)
+                        traits::deallocate_node(alloc_, e->memory, e->size, e->alignment);
+                    else
+                        traits::deallocate_array(alloc_, e->memory, e->count, e->size,
+                                                 e->alignment);
+            }
+
+            void deallocate_now(const entry* e, std::size_t n) noexcept
+            {
+                std::lock_guard<mutex_type> lock(mutex_);
+                deallocate(e, n);
+            }
+
+            void run() noexcept
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                while (true)
+                {
+                    wakeup_.wait(lock, [&] { return stop_ || queue_; });
+                    if (!queue_)
+                        break; // stopped and nothing left
+
+                    auto list = queue_;
+                    queue_    = nullptr;
+                    lock.unlock();
+
+                    std::size_t no_batches = 0u;
+                    {
+                        // one lock acquisition for all batches received so far
+                        std::lock_guard<mutex_type> alloc_lock(mutex_);
+                        for (auto b = list; b; b = b->next, ++no_batches)
+                            deallocate(b->entries, b->count);
+                    }
+                    while (list)
+                    {
+                        auto next = list->next;
+                        list->~batch();
+                        heap_dealloc(list, sizeof(batch));
+                        list = next;
+                    }
+
+                    lock.lock();
+                    pending_ -= no_batches;
+                    if (pending_ == 0u)
+                        done_.notify_all();
+                }
+            }
+
+            allocator_type     alloc_;
+            mutable mutex_type mutex_;
+
+            // guards the queue of batches and the state of the background thread
+            mutable std::mutex      queue_mutex_;
+            std::condition_variable wakeup_, done_;
+            batch*                  queue_;
+            std::size_t             pending_;
+            bool                    stop_;
+            std::thread             thread_;
+        };
+
+        template <class RawAllocator, class Mutex, std::size_t BatchSize>
+        constexpr std::size_t deferred_deallocator<RawAllocator, Mutex, BatchSize>::batch_size;
+
+        template <class RawAllocator, class Mutex, std::size_t BatchSize>
+        constexpr std::size_t deferred_deallocator<RawAllocator, Mutex, BatchSize>::buffer_capacity;
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_DEFERRED_DEALLOCATOR_HPP_INCLUDED
@@ -34,6 +34,16 @@ namespace foonathan
                 return align_offset(reinterpret_cast<std::uintptr_t>(ptr), alignment);
             }
 
+            // same as align_offset() but for an alignment known at compile-time,
+            // without the assertion and the branch, so it folds to zero for an alignment of one
+            template <std::size_t Alignment>
+            std::size_t align_offset(const void* ptr) noexcept
+            {
+                static_assert(is_valid_alignment(Alignment), "invalid alignment");
+                auto misaligned = reinterpret_cast<std::uintptr_t>(ptr) & (Alignment - 1u);
+                return std::size_t((Alignment - misaligned) & (Alignment - 1u));
+            }
+
             // whether or not the pointer is aligned for given alignment
             // alignment must be valid
             bool is_aligned(void* ptr, std::size_t alignment) noexcept;
@@ -42,8 +52,15 @@ namespace foonathan
             constexpr std::size_t max_alignment = alignof(std::max_align_t);
             static_assert(is_valid_alignment(max_alignment), "ehm..?");
 
+            // maximum alignment of the low-level allocators that support over-aligned memory,
+            // the size of a page on common platforms
+            constexpr std::size_t max_extended_alignment = 4096u;
+
             // returns the minimum alignment required for a node of given size
             std::size_t alignment_for(std::size_t size) noexcept;
+
+            // assumed size of a cache line, the common value on x86 and ARM
+            constexpr std::size_t cache_line_size = 64u;
         } // namespace detail
     }     // namespace memory
 } // namespace foonathan
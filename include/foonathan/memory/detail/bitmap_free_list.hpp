@@ -0,0 +1,166 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_DETAIL_BITMAP_FREE_LIST_HPP_INCLUDED
+#define FOONATHAN_MEMORY_DETAIL_BITMAP_FREE_LIST_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../config.hpp"
+#include "align.hpp"
+#include "utility.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        namespace detail
+        {
+            // header of each memory block inserted into the list
+            // it is followed by the bitmap with one bit per node, set if the node is free,
+            // and then by the nodes themselves
+            struct bitmap_block
+            {
+                bitmap_block* next;
+                char*         nodes;
+                std::size_t   no_nodes;
+                std::size_t   capacity;   // number of free nodes
+                std::size_t   first_free; // no bitmap word before it has a free node
+
+                std::uint64_t* bitmap() noexcept
+                {
+                    return reinterpret_cast<std::uint64_t*>(this + 1);
+                }
+            };
+
+            // stores free nodes for a memory pool in a bitmap per inserted memory block
+            // node allocations take the free node with the lowest address of a block,
+            // array allocations search a run of free nodes with word-level bit operations
+            // instead of walking a free list, so they do not get slower with fragmentation
+            // the bitmap is not stored in the nodes, so nodes can have any size
+            // debug: fills memory
+            class bitmap_free_memory_list
+            {
+            public:
+                // minimum element size
+                static constexpr std::size_t min_element_size = 1u;
+                // alignment
+                static constexpr std::size_t min_element_alignment = 1u;
+
+                // minimal size of the block that needs to be inserted
+                static constexpr std::size_t min_block_size(std::size_t node_size,
+                                                            std::size_t number_of_nodes)
+                {
+                    return header_size(number_of_nodes, max_alignment)
+                           + node_size * number_of_nodes;
+                }
+
+                //=== constructor ===//
+                bitmap_free_memory_list(std::size_t node_size) noexcept;
+
+                // calls other constructor plus insert
+                bitmap_free_memory_list(std::size_t node_size, void* mem,
+                                        std::size_t size) noexcept;
+
+                bitmap_free_memory_list(bitmap_free_memory_list&& other) noexcept;
+                ~bitmap_free_memory_list() noexcept = default;
+
+                bitmap_free_memory_list& operator=(bitmap_free_memory_list&& other) noexcept;
+
+                friend void swap(bitmap_free_memory_list& a, bitmap_free_memory_list& b) noexcept;
+
+                //=== insert/allocation/deallocation ===//
+                // inserts a new memory block,
+                // the beginning of the memory is used for the header and the bitmap
+                // does not own memory!
+                // mem must be aligned for maximum alignment
+                void insert(void* mem, std::size_t size) noexcept;
+
+                // returns the usable size
+                // i.e. how many memory will be actually inserted and usable on a call to insert()
+                std::size_t usable_size(std::size_t size) const noexcept
+                {
+                    return no_nodes(size) * node_size_;
+                }
+
+                // returns a single node from the list
+                // pre: !empty()
+                void* allocate() noexcept;
+
+                // returns a memory block big enough for n bytes
+                // returns nullptr if no block has enough consecutive free nodes
+                void* allocate(std::size_t n) noexcept;
+
+                // deallocates a single node
+                void deallocate(void* ptr) noexcept;
+
+                // deallocates multiple nodes with n bytes total
+                // they must have been allocated by allocate(n)
+                void deallocate(void* ptr, std::size_t n) noexcept;
+
+                // removes the block of the last deallocation if all of its nodes are free
+                // and another block still has free nodes, so that a single block is not
+                // inserted and removed over and over at the boundary
+                // returns the memory passed to insert() or nullptr if nothing is removed
+                void* remove_empty_block() noexcept;
+
+                //=== getter ===//
+                std::size_t node_size() const noexcept
+                {
+                    return node_size_;
+                }
+
+                // alignment of all nodes
+                std::size_t alignment() const noexcept;
+
+                // number of nodes remaining
+                std::size_t capacity() const noexcept
+                {
+                    return capacity_;
+                }
+
+                bool empty() const noexcept
+                {
+                    return capacity_ == 0u;
+                }
+
+            private:
+                static constexpr std::size_t bits_per_word = 64u;
+
+                // size of the header and the bitmap, rounded up to the alignment of the nodes
+                static constexpr std::size_t header_size(std::size_t no_nodes,
+                                                         std::size_t alignment) noexcept
+                {
+                    return (sizeof(bitmap_block)
+                            + (no_nodes + bits_per_word - 1u) / bits_per_word
+                                  * sizeof(std::uint64_t)
+                            + alignment - 1u)
+                           / alignment * alignment;
+                }
+
+                // number of nodes of a block of the given size
+                std::size_t no_nodes(std::size_t size) const noexcept;
+
+                // finds the block of the node,
+                // linear in the number of blocks, but they are few with a growing block size
+                bitmap_block* find_block(char* node) noexcept;
+
+                bitmap_block *first_, *alloc_block_, *dealloc_block_;
+                std::size_t   node_size_, capacity_;
+            };
+
+            void swap(bitmap_free_memory_list& a, bitmap_free_memory_list& b) noexcept;
+
+            // same as bitmap_free_memory_list,
+            // but tells memory_pool to return each block that becomes empty to its arena
+            class releasing_bitmap_free_memory_list : public bitmap_free_memory_list
+            {
+            public:
+                using bitmap_free_memory_list::bitmap_free_memory_list;
+            };
+        } // namespace detail
+    }     // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_DETAIL_BITMAP_FREE_LIST_HPP_INCLUDED
@@ -0,0 +1,141 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_DETAIL_BUDDY_SYSTEM_HPP_INCLUDED
+#define FOONATHAN_MEMORY_DETAIL_BUDDY_SYSTEM_HPP_INCLUDED
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+
+#include "../config.hpp"
+#include "align.hpp"
+#include "utility.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        namespace detail
+        {
+            // descriptor of each memory block inserted into a buddy system
+            // it is placed at the end of the block and followed by the bitmap,
+            // which has one bit per possible node of every order, set if the node is free
+            struct buddy_block
+            {
+                static constexpr std::size_t max_orders = sizeof(std::size_t) * CHAR_BIT;
+
+                buddy_block* next;
+                char*        begin;
+                std::size_t  size;                   // multiple of the minimum node size
+                std::size_t  bit_offset[max_orders]; // index of the first bit of each order
+
+                std::uint64_t* bitmap() noexcept
+                {
+                    return reinterpret_cast<std::uint64_t*>(this + 1);
+                }
+            };
+
+            // manages the memory of inserted blocks as buddy systems
+            // nodes are a power of two multiple of the minimum node size,
+            // a free node is split in halves until it has the requested size
+            // and a deallocated node is merged with its buddy as long as the buddy is free,
+            // both in O(log n) with one free list per order
+            // the free bits are kept in the block descriptor and not in the nodes,
+            // the nodes only store the links of the free lists
+            // a block whose size is not a power of two is split into one buddy system
+            // per set bit of its size, largest first
+            // debug: fills memory
+            class buddy_system
+            {
+            public:
+                static constexpr std::size_t max_orders = buddy_block::max_orders;
+
+                // minimum node size, room for the links of the free lists
+                static constexpr std::size_t min_element_size = 2u * sizeof(void*);
+
+                //=== constructor ===//
+                // node_size is rounded up to a power of two
+                explicit buddy_system(std::size_t node_size) noexcept;
+
+                buddy_system(buddy_system&& other) noexcept;
+                ~buddy_system() noexcept = default;
+
+                buddy_system& operator=(buddy_system&& other) noexcept;
+
+                friend void swap(buddy_system& a, buddy_system& b) noexcept;
+
+                //=== insert/allocation/deallocation ===//
+                // inserts a new memory block,
+                // the end of the memory is used for the descriptor and the bitmap
+                // does not own memory!
+                // mem must be aligned for maximum alignment
+                void insert(void* mem, std::size_t size) noexcept;
+
+                // returns the number of bytes that are managed on a call to insert()
+                std::size_t usable_size(std::size_t size) const noexcept;
+
+                // returns the size of the biggest node of a block of the given size
+                std::size_t max_node_size(std::size_t size) const noexcept;
+
+                // returns a node of at least n bytes, aligned for the lowest set bit of its size
+                // returns nullptr if there is no free node big enough
+                void* allocate(std::size_t n) noexcept;
+
+                // deallocates a node, it must have been allocated by allocate(n)
+                void deallocate(void* ptr, std::size_t n) noexcept;
+
+                // whether or not the memory is in a block of the list
+                bool owns(const void* ptr) const noexcept;
+
+                //=== getter ===//
+                // the size of the smallest node
+                std::size_t node_size() const noexcept
+                {
+                    return std::size_t(1u) << log2_node_size_;
+                }
+
+                // the size of the biggest free node
+                std::size_t max_free_size() const noexcept;
+
+                // number of bytes in free nodes
+                std::size_t capacity() const noexcept
+                {
+                    return capacity_;
+                }
+
+                // number of bytes in all nodes of all blocks
+                std::size_t managed() const noexcept
+                {
+                    return managed_;
+                }
+
+            private:
+                struct free_node
+                {
+                    free_node *prev, *next;
+                };
+
+                // the order of the smallest node that has at least n bytes
+                std::size_t order_of(std::size_t n) const noexcept;
+
+                // finds the block of the node,
+                // linear in the number of blocks, but they are few with a growing block size
+                buddy_block* find_block(const char* node) const noexcept;
+
+                void push(buddy_block* block, char* node, std::size_t order) noexcept;
+                void erase(buddy_block* block, char* node, std::size_t order) noexcept;
+
+                free_node*    free_[max_orders];
+                buddy_block*  first_;
+                std::size_t   log2_node_size_;
+                std::size_t   capacity_, managed_;
+                std::size_t   non_empty_; // bit i is set if free_[i] is not empty
+            };
+
+            void swap(buddy_system& a, buddy_system& b) noexcept;
+        } // namespace detail
+    }     // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_DETAIL_BUDDY_SYSTEM_HPP_INCLUDED
@@ -4,6 +4,10 @@
 #ifndef FOONATHAN_MEMORY_DETAIL_CONTAINER_NODE_SIZES_HPP_INCLUDED
 #define FOONATHAN_MEMORY_DETAIL_CONTAINER_NODE_SIZES_HPP_INCLUDED
 
+#include "container_node_sizes_builtin.hpp"
+
+#if !FOONATHAN_MEMORY_IMPL_BUILTIN_NODE_SIZES
 #include "container_node_sizes_impl.hpp"
+#endif
 
 #endif //FOONATHAN_MEMORY_DETAIL_CONTAINER_NODE_SIZES_HPP_INCLUDED
@@ -0,0 +1,99 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_DETAIL_CONTAINER_NODE_SIZES_BUILTIN_HPP_INCLUDED
+#define FOONATHAN_MEMORY_DETAIL_CONTAINER_NODE_SIZES_BUILTIN_HPP_INCLUDED
+
+// node sizes computed directly from the node types of the standard library,
+// so they do not need to be generated by get_container_node_sizes.cmake
+// included inside namespace foonathan::memory after the container headers
+
+#if FOONATHAN_MEMORY_BUILTIN_NODE_SIZES && defined(__GLIBCXX__)
+#define FOONATHAN_MEMORY_IMPL_BUILTIN_NODE_SIZES 1
+#else
+#define FOONATHAN_MEMORY_IMPL_BUILTIN_NODE_SIZES 0
+#endif
+
+#if FOONATHAN_MEMORY_IMPL_BUILTIN_NODE_SIZES
+namespace detail
+{
+    // only the size of the allocator is relevant for the control block
+    template <typename T, class State>
+    struct node_size_allocator : State
+    {
+        using value_type = T;
+    };
+
+    struct stateless_node_size_state
+    {
+    };
+
+    // same layout as an allocator_reference of a stateful allocator
+    struct stateful_node_size_state
+    {
+        void* alloc;
+    };
+
+    template <typename T, class State>
+    using shared_ptr_node =
+        std::_Sp_counted_ptr_inplace<T, node_size_allocator<T, State>,
+                                     __gnu_cxx::__default_lock_policy>;
+} // namespace detail
+
+template <typename T>
+struct forward_list_node_size
+: std::integral_constant<std::size_t, sizeof(std::_Fwd_list_node<T>)>
+{};
+
+template <typename T>
+struct list_node_size : std::integral_constant<std::size_t, sizeof(std::_List_node<T>)>
+{};
+
+template <typename T>
+struct set_node_size : std::integral_constant<std::size_t, sizeof(std::_Rb_tree_node<T>)>
+{};
+
+template <typename T>
+struct multiset_node_size : set_node_size<T>
+{};
+
+// assumes a cached hash code, which is the bigger node
+template <typename T>
+struct unordered_set_node_size
+: std::integral_constant<std::size_t, sizeof(std::__detail::_Hash_node<T, true>)>
+{};
+
+template <typename T>
+struct unordered_multiset_node_size : unordered_set_node_size<T>
+{};
+
+template <typename T>
+struct map_node_size : set_node_size<T>
+{};
+
+template <typename T>
+struct multimap_node_size : set_node_size<T>
+{};
+
+template <typename T>
+struct unordered_map_node_size : unordered_set_node_size<T>
+{};
+
+template <typename T>
+struct unordered_multimap_node_size : unordered_set_node_size<T>
+{};
+
+template <typename T>
+struct shared_ptr_stateless_node_size
+: std::integral_constant<std::size_t,
+                         sizeof(detail::shared_ptr_node<T, detail::stateless_node_size_state>)>
+{};
+
+template <typename T>
+struct shared_ptr_stateful_node_size
+: std::integral_constant<std::size_t,
+                         sizeof(detail::shared_ptr_node<T, detail::stateful_node_size_state>)>
+{};
+#endif
+
+#endif // FOONATHAN_MEMORY_DETAIL_CONTAINER_NODE_SIZES_BUILTIN_HPP_INCLUDED
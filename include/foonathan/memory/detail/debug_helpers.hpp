@@ -62,6 +62,27 @@ namespace foonathan
             inline void debug_fill_internal(void*, std::size_t, bool) noexcept {}
 #endif
 
+#if FOONATHAN_MEMORY_DEBUG_POISON
+            // marks memory as inaccessible for AddressSanitizer and Valgrind
+            void debug_poison(const void* memory, std::size_t size) noexcept;
+
+            // marks memory as accessible again, its content is undefined
+            void debug_unpoison(const void* memory, std::size_t size) noexcept;
+
+            // returns whether or not the byte is poisoned
+            // always false without AddressSanitizer, Valgrind cannot be queried without reporting
+            bool debug_is_poisoned(const void* memory) noexcept;
+#else
+            inline void debug_poison(const void*, std::size_t) noexcept {}
+
+            inline void debug_unpoison(const void*, std::size_t) noexcept {}
+
+            inline bool debug_is_poisoned(const void*) noexcept
+            {
+                return false;
+            }
+#endif
+
             void debug_handle_invalid_ptr(const allocator_info& info, void* ptr);
 
             // validates given ptr by evaluating the Functor
@@ -155,6 +176,42 @@ namespace foonathan
                 std::ptrdiff_t allocated_;
             };
 
+            // number of cache lines a sharded_leak_counter spreads its updates over
+            constexpr std::size_t leak_counter_shard_count = 16u;
+
+            // returns the index of the shard used by the current thread
+            // threads are assigned round-robin on their first call
+            std::size_t leak_counter_shard() noexcept;
+
+            // counts allocated bytes without contention between threads:
+            // each thread updates only its own shard and the total is computed on request
+            // must have static storage duration, so the shards are zero-initialized
+            class sharded_leak_counter
+            {
+            public:
+                void add(std::ptrdiff_t amount) noexcept
+                {
+                    shards_[leak_counter_shard()].value.fetch_add(amount,
+                                                                  std::memory_order_relaxed);
+                }
+
+                std::ptrdiff_t total() const noexcept
+                {
+                    std::ptrdiff_t result = 0;
+                    for (auto& shard : shards_)
+                        result += shard.value.load(std::memory_order_relaxed);
+                    return result;
+                }
+
+            private:
+                struct alignas(64) shard
+                {
+                    std::atomic<std::ptrdiff_t> value;
+                };
+
+                shard shards_[leak_counter_shard_count];
+            };
+
             // does leak checking on a global basis
             // call macro FOONATHAN_MEMORY_GLOBAL_LEAK_CHECKER(handler, var_name) in the header
             // when last counter gets destroyed, leak is detected
@@ -172,8 +229,12 @@ namespace foonathan
                     ~counter()
                     {
                         --no_counter_objects_;
-                        if (no_counter_objects_ == 0u && allocated_ != 0u)
-                            this->operator()(allocated_);
+                        if (no_counter_objects_ == 0u)
+                        {
+                            auto leaked = allocated_.total();
+                            if (leaked != 0)
+                                this->operator()(leaked);
+                        }
                     }
                 };
 
@@ -188,24 +249,24 @@ namespace foonathan
 
                 void on_allocate(std::size_t size) noexcept
                 {
-                    allocated_ += std::ptrdiff_t(size);
+                    allocated_.add(std::ptrdiff_t(size));
                 }
 
                 void on_deallocate(std::size_t size) noexcept
                 {
-                    allocated_ -= std::ptrdiff_t(size);
+                    allocated_.add(-std::ptrdiff_t(size));
                 }
 
             private:
-                static std::atomic<std::size_t>    no_counter_objects_;
-                static std::atomic<std::ptrdiff_t> allocated_;
+                static std::atomic<std::size_t> no_counter_objects_;
+                static sharded_leak_counter     allocated_;
             };
 
             template <class Handler>
             std::atomic<std::size_t> global_leak_checker_impl<Handler>::no_counter_objects_(0u);
 
             template <class Handler>
-            std::atomic<std::ptrdiff_t> global_leak_checker_impl<Handler>::allocated_(0);
+            sharded_leak_counter global_leak_checker_impl<Handler>::allocated_;
 
 #if FOONATHAN_MEMORY_DEBUG_LEAK_CHECK
             template <class Handler>
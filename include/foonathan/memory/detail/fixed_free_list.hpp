@@ -0,0 +1,277 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_DETAIL_FIXED_FREE_LIST_HPP_INCLUDED
+#define FOONATHAN_MEMORY_DETAIL_FIXED_FREE_LIST_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstring>
+
+#include "align.hpp"
+#include "assert.hpp"
+#include "debug_helpers.hpp"
+#include "utility.hpp"
+#include "../config.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        namespace detail
+        {
+            // the default alignment for a node size, like alignment_for() but a constant expression
+            constexpr std::size_t fixed_alignment_for(std::size_t size) noexcept
+            {
+                return (size & (0u - size)) < max_alignment ? size & (0u - size) : max_alignment;
+            }
+
+            // same as free_memory_list but the node size and the alignment are template parameters,
+            // so all divisions and multiplications by the node size are done with constants
+            // and the list does not need to store it
+            // it does not support arrays
+            template <std::size_t NodeSize, std::size_t Alignment>
+            class fixed_free_memory_list
+            {
+                static_assert(NodeSize != 0u, "node size must not be zero");
+                static_assert(Alignment != 0u && (Alignment & (Alignment - 1u)) == 0u,
+                              "alignment must be a power of two");
+
+            public:
+                // minimum element size
+                static constexpr std::size_t min_element_size = sizeof(char*);
+                // alignment
+                static constexpr std::size_t min_element_alignment = alignof(char*);
+
+                // the actual node size, big enough for a pointer and a multiple of the alignment
+                static constexpr std::size_t fixed_node_size =
+                    ((NodeSize < min_element_size ? min_element_size : NodeSize) + Alignment
+                     - 1u)
+                    & ~(Alignment - 1u);
+
+                // minimal size of the block that needs to be inserted
+                static constexpr std::size_t min_block_size(std::size_t,
+                                                            std::size_t number_of_nodes)
+                {
+                    return fixed_node_size * number_of_nodes;
+                }
+
+                //=== constructor ===//
+                // the node size is only checked, it must not be bigger than the fixed one
+                fixed_free_memory_list(std::size_t node_size = NodeSize) noexcept
+                : first_(nullptr),
+                  untouched_(nullptr),
+                  untouched_end_(nullptr),
+                  capacity_(0u),
+                  untouched_zeroed_(false)
+                {
+                    FOONATHAN_MEMORY_ASSERT_MSG(node_size <= fixed_node_size,
+                                                "node size bigger than the fixed one");
+                }
+
+                fixed_free_memory_list(fixed_free_memory_list&& other) noexcept
+                : first_(other.first_),
+                  untouched_(other.untouched_),
+                  untouched_end_(other.untouched_end_),
+                  capacity_(other.capacity_),
+                  untouched_zeroed_(other.untouched_zeroed_)
+                {
+                    other.first_         = nullptr;
+                    other.untouched_     = nullptr;
+                    other.untouched_end_ = nullptr;
+                    other.capacity_      = 0u;
+                }
+
+                ~fixed_free_memory_list() noexcept = default;
+
+                fixed_free_memory_list& operator=(fixed_free_memory_list&& other) noexcept
+                {
+                    fixed_free_memory_list tmp(detail::move(other));
+                    swap(*this, tmp);
+                    return *this;
+                }
+
+                friend void swap(fixed_free_memory_list& a, fixed_free_memory_list& b) noexcept
+                {
+                    detail::adl_swap(a.first_, b.first_);
+                    detail::adl_swap(a.untouched_, b.untouched_);
+                    detail::adl_swap(a.untouched_end_, b.untouched_end_);
+                    detail::adl_swap(a.capacity_, b.capacity_);
+                    detail::adl_swap(a.untouched_zeroed_, b.untouched_zeroed_);
+                }
+
+                //=== insert/allocation/deallocation ===//
+                // inserts a new memory block, it becomes the untouched region
+                // the remaining nodes of the previous one are linked
+                // does not own memory!
+                // mem must be aligned for alignment()
+                // pre: size >= fixed_node_size
+                void insert(void* mem, std::size_t size, bool zeroed = false) noexcept
+                {
+                    FOONATHAN_MEMORY_ASSERT(mem);
+                    FOONATHAN_MEMORY_ASSERT(is_aligned(mem, Alignment));
+                    // the memory may still be poisoned by a previous owner
+                    detail::debug_unpoison(mem, size);
+                    detail::debug_fill_internal(mem, size, false);
+
+                    auto no_nodes = size / fixed_node_size;
+                    FOONATHAN_MEMORY_ASSERT(no_nodes > 0);
+
+                    // only one untouched region is kept, the old one is usually empty
+                    if (untouched_ != untouched_end_)
+                    {
+                        auto old_size = static_cast<std::size_t>(untouched_end_ - untouched_);
+                        capacity_ -= old_size / fixed_node_size;
+                        link(untouched_, old_size);
+                    }
+
+                    untouched_        = static_cast<char*>(mem);
+                    untouched_end_    = untouched_ + no_nodes * fixed_node_size;
+                    untouched_zeroed_ = zeroed;
+                    detail::debug_poison(untouched_, no_nodes * fixed_node_size);
+                    capacity_ += no_nodes;
+                }
+
+                // returns the usable size
+                // i.e. how many memory will be actually inserted and usable on a call to insert()
+                std::size_t usable_size(std::size_t size) const noexcept
+                {
+                    return size / fixed_node_size * fixed_node_size;
+                }
+
+                // returns a single block from the list, or from the untouched region if it is empty
+                // pre: !empty()
+                void* allocate() noexcept
+                {
+                    FOONATHAN_MEMORY_ASSERT(!empty());
+                    --capacity_;
+
+                    char* mem;
+                    if (first_)
+                    {
+                        mem    = first_;
+                        first_ = get_next(first_);
+                    }
+                    else
+                    {
+                        mem = untouched_;
+                        untouched_ += fixed_node_size;
+                    }
+                    detail::debug_unpoison(mem, fixed_node_size);
+                    return detail::debug_fill_new(mem, fixed_node_size, 0);
+                }
+
+                // returns a single block like allocate() whose bytes are all zero
+                // pre: !empty()
+                void* allocate_zeroed() noexcept
+                {
+                    auto zeroed = first_ == nullptr && untouched_zeroed_;
+                    auto mem    = allocate();
+                    if (!zeroed)
+                        std::memset(mem, 0, fixed_node_size);
+                    return mem;
+                }
+
+                // always returns nullptr, because array allocations are not supported
+                void* allocate(std::size_t) noexcept
+                {
+                    return nullptr;
+                }
+
+                // deallocates a single block
+                void deallocate(void* ptr) noexcept
+                {
+                    ++capacity_;
+
+                    auto node = static_cast<char*>(detail::debug_fill_free(ptr, fixed_node_size, 0));
+                    set_next(node, first_);
+                    detail::debug_poison(node + sizeof(char*), fixed_node_size - sizeof(char*));
+                    first_ = node;
+                }
+
+                // links the nodes of the memory
+                void deallocate(void* ptr, std::size_t n) noexcept
+                {
+                    if (n <= fixed_node_size)
+                        deallocate(ptr);
+                    else
+                        link(static_cast<char*>(detail::debug_fill_free(ptr, n, 0)), n);
+                }
+
+                //=== getter ===//
+                std::size_t node_size() const noexcept
+                {
+                    return fixed_node_size;
+                }
+
+                // alignment of all nodes
+                std::size_t alignment() const noexcept
+                {
+                    return Alignment;
+                }
+
+                // number of nodes remaining
+                std::size_t capacity() const noexcept
+                {
+                    return capacity_;
+                }
+
+                // number of nodes remaining that have never been allocated
+                std::size_t untouched_capacity() const noexcept
+                {
+                    return static_cast<std::size_t>(untouched_end_ - untouched_) / fixed_node_size;
+                }
+
+                bool empty() const noexcept
+                {
+                    return first_ == nullptr && untouched_ == untouched_end_;
+                }
+
+            private:
+                static char* get_next(const char* node) noexcept
+                {
+                    char* next;
+                    std::memcpy(&next, node, sizeof(char*));
+                    return next;
+                }
+
+                static void set_next(char* node, char* next) noexcept
+                {
+                    detail::debug_unpoison(node, sizeof(char*));
+                    std::memcpy(node, &next, sizeof(char*));
+                }
+
+                // puts all nodes of the memory onto the list
+                void link(char* mem, std::size_t size) noexcept
+                {
+                    auto no_nodes = size / fixed_node_size;
+                    FOONATHAN_MEMORY_ASSERT(no_nodes > 0);
+
+                    auto cur = mem;
+                    for (std::size_t i = 0u; i != no_nodes - 1u; ++i, cur += fixed_node_size)
+                        set_next(cur, cur + fixed_node_size);
+                    set_next(cur, first_);
+                    first_ = mem;
+
+                    capacity_ += no_nodes;
+                }
+
+                char*       first_;
+                char *      untouched_, *untouched_end_;
+                std::size_t capacity_;
+                bool        untouched_zeroed_;
+            };
+
+            template <std::size_t NodeSize, std::size_t Alignment>
+            constexpr std::size_t fixed_free_memory_list<NodeSize, Alignment>::min_element_size;
+
+            template <std::size_t NodeSize, std::size_t Alignment>
+            constexpr std::size_t
+                fixed_free_memory_list<NodeSize, Alignment>::min_element_alignment;
+
+            template <std::size_t NodeSize, std::size_t Alignment>
+            constexpr std::size_t fixed_free_memory_list<NodeSize, Alignment>::fixed_node_size;
+        } // namespace detail
+    }     // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_DETAIL_FIXED_FREE_LIST_HPP_INCLUDED
@@ -4,8 +4,10 @@
 #ifndef FOONATHAN_MEMORY_DETAILL_FREE_LIST_HPP_INCLUDED
 #define FOONATHAN_MEMORY_DETAILL_FREE_LIST_HPP_INCLUDED
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <type_traits>
 
 #include "align.hpp"
 #include "utility.hpp"
@@ -17,8 +19,16 @@ namespace foonathan
     {
         namespace detail
         {
+            // called with the free nodes of a list, no_nodes consecutive nodes starting at node
+            using free_node_visitor = void (*)(void* context, char* node, std::size_t no_nodes);
+            // returns whether the free node is to be removed from a list
+            using free_node_filter = bool (*)(void* context, char* node);
+
             // stores free blocks for a memory pool
             // memory blocks are fragmented and stored in a list
+            // the nodes of the last inserted block are only linked once they are deallocated,
+            // until then they are taken from the untouched end of the block,
+            // so its pages are not faulted in before they are used
             // debug: fills memory and uses a bigger node_size for fence memory
             class free_memory_list
             {
@@ -50,11 +60,13 @@ namespace foonathan
                 friend void swap(free_memory_list& a, free_memory_list& b) noexcept;
 
                 //=== insert/allocation/deallocation ===//
-                // inserts a new memory block, by splitting it up and setting the links
+                // inserts a new memory block, it becomes the untouched region
+                // the remaining nodes of the previous one are linked
+                // zeroed tells whether all bytes of the block are zero
                 // does not own memory!
                 // mem must be aligned for alignment()
                 // pre: size != 0
-                void insert(void* mem, std::size_t size) noexcept;
+                void insert(void* mem, std::size_t size, bool zeroed = false) noexcept;
 
                 // returns the usable size
                 // i.e. how many memory will be actually inserted and usable on a call to insert()
@@ -64,10 +76,15 @@ namespace foonathan
                     return (size / node_size_) * node_size_;
                 }
 
-                // returns a single block from the list
+                // returns a single block from the list, or from the untouched region if it is empty
                 // pre: !empty()
                 void* allocate() noexcept;
 
+                // returns a single block like allocate() whose bytes are all zero
+                // nodes of a zeroed untouched region are not cleared again
+                // pre: !empty()
+                void* allocate_zeroed() noexcept;
+
                 // returns a memory block big enough for n bytes
                 // might fail even if capacity is sufficient
                 void* allocate(std::size_t n) noexcept;
@@ -78,6 +95,17 @@ namespace foonathan
                 // deallocates multiple blocks with n bytes total
                 void deallocate(void* ptr, std::size_t n) noexcept;
 
+                //=== bulk operations ===//
+                // calls f once for every linked node and once for the whole untouched region,
+                // without writing to any node
+                void visit(free_node_visitor f, void* context) const noexcept;
+
+                // removes all free nodes for which f returns true in a single pass,
+                // only the nodes before removed ones are relinked
+                // the untouched region is removed as a whole if f returns true for its first node,
+                // so it must be part of a single block
+                void remove_if(free_node_filter f, void* context) noexcept;
+
                 //=== getter ===//
                 std::size_t node_size() const noexcept
                 {
@@ -93,20 +121,91 @@ namespace foonathan
                     return capacity_;
                 }
 
+                // number of nodes remaining that have never been allocated
+                std::size_t untouched_capacity() const noexcept
+                {
+                    return static_cast<std::size_t>(untouched_end_ - untouched_) / node_size_;
+                }
+
                 bool empty() const noexcept
                 {
-                    return first_ == nullptr;
+                    return first_ == nullptr && untouched_ == untouched_end_;
                 }
 
             private:
                 void insert_impl(void* mem, std::size_t size) noexcept;
 
                 char*       first_;
+                char *      untouched_, *untouched_end_;
                 std::size_t node_size_, capacity_;
+                bool        untouched_zeroed_;
             };
 
             void swap(free_memory_list& a, free_memory_list& b) noexcept;
 
+            // free_memory_list whose nodes never straddle a cache line
+            // node sizes are rounded up to a power of two dividing the cache line
+            // or a multiple of it and each inserted block starts at a cache line boundary
+            class cache_aligned_free_memory_list : public free_memory_list
+            {
+            public:
+                // returns the actual node size for a requested one
+                static constexpr std::size_t aligned_node_size(std::size_t node_size) noexcept
+                {
+                    return node_size > cache_line_size ?
+                               (node_size + cache_line_size - 1u) / cache_line_size
+                                   * cache_line_size :
+                               round_up_to_power_of_two(node_size < min_element_size ?
+                                                            min_element_size :
+                                                            node_size);
+                }
+
+                // minimal size of the block that needs to be inserted
+                // including the maximal offset to align the first node
+                static constexpr std::size_t min_block_size(std::size_t node_size,
+                                                            std::size_t number_of_nodes)
+                {
+                    return aligned_node_size(node_size) * number_of_nodes + cache_line_size
+                           - min_element_alignment;
+                }
+
+                cache_aligned_free_memory_list(std::size_t node_size) noexcept
+                : free_memory_list(aligned_node_size(node_size))
+                {
+                }
+
+                // inserts the nodes starting at the first cache line boundary
+                void insert(void* mem, std::size_t size, bool zeroed = false) noexcept;
+
+                // returns the usable size, assuming the worst case offset
+                std::size_t usable_size(std::size_t size) const noexcept
+                {
+                    auto offset = cache_line_size - min_element_alignment;
+                    return size < offset ? 0u : free_memory_list::usable_size(size - offset);
+                }
+
+                // returns the usable size when inserting the memory at mem
+                std::size_t usable_size(const void* mem, std::size_t size) const noexcept
+                {
+                    auto offset =
+                        align_offset(reinterpret_cast<std::uintptr_t>(mem), cache_line_size);
+                    return size < offset ? 0u : free_memory_list::usable_size(size - offset);
+                }
+
+                // alignment of all nodes
+                std::size_t alignment() const noexcept
+                {
+                    return node_size() < cache_line_size ? node_size() : cache_line_size;
+                }
+
+            private:
+                static constexpr std::size_t round_up_to_power_of_two(std::size_t size,
+                                                                      std::size_t power = 1u)
+                {
+                    return power >= size ? power : round_up_to_power_of_two(size, power * 2u);
+                }
+            };
+
             // same as above but keeps the nodes ordered
             // this allows array allocations, that is, consecutive nodes
             // debug: fills memory and uses a bigger node_size for fence memory
@@ -178,6 +277,14 @@ namespace foonathan
                 // deallocates multiple blocks with n bytes total
                 void deallocate(void* ptr, std::size_t n) noexcept;
 
+                //=== bulk operations ===//
+                // calls f once for every node, without writing to any node
+                void visit(free_node_visitor f, void* context) noexcept;
+
+                // removes all free nodes for which f returns true in a single pass,
+                // only the nodes around removed ones are relinked
+                void remove_if(free_node_filter f, void* context) noexcept;
+
                 //=== getter ===//
                 std::size_t node_size() const noexcept
                 {
@@ -198,27 +305,250 @@ namespace foonathan
                     return capacity_ == 0u;
                 }
 
+            protected:
+                // a free node and the one before it in the list
+                struct hint
+                {
+                    char *prev, *node;
+                };
+
+                // the address space is split into regions that are mapped onto the hints,
+                // each hint stores the most recently inserted node of one of its regions
+                // that needed a search, so lists that are only used at the front and back have none
+                static constexpr std::size_t hint_count = 64u;
+
+                // uses the given hint_count hints to bound the search on insertion,
+                // they are not moved or swapped with the list
+                void set_hints(hint* hints) noexcept;
+
             private:
                 // returns previous pointer
                 char* insert_impl(void* mem, std::size_t size) noexcept;
 
+                // searches the position in the list where memory needs to be inserted,
+                // starting from the closest hint if there is one
+                void search_pos(char* memory, char*& prev, char*& next) noexcept;
+
+                // the hint of the given region if it has one
+                hint* find_hint(std::uintptr_t region) noexcept
+                {
+                    auto& h = hints_[region % hint_count];
+                    if (h.node && reinterpret_cast<std::uintptr_t>(h.node) >> hint_shift_ == region)
+                        return &h;
+                    return nullptr;
+                }
+
+                hint& get_hint(char* node) noexcept
+                {
+                    return hints_[(reinterpret_cast<std::uintptr_t>(node) >> hint_shift_)
+                                  % hint_count];
+                }
+
+                // updates the hints after the nodes [first, last] were inserted
+                // between prev and next and creates one for first if requested
+                void insert_hints(char* prev, char* first, char* last, char* next,
+                                  bool create) noexcept;
+                // updates the hints after the nodes [first, last] were removed
+                // from between prev and next
+                // pre: no_hints_ != 0
+                void remove_hints(char* prev, char* first, char* last, char* next) noexcept;
+                void reset_hints() noexcept;
+
                 char* begin_node() noexcept;
                 char* end_node() noexcept;
 
                 std::uintptr_t begin_proxy_, end_proxy_;
                 std::size_t    node_size_, capacity_;
                 char *         last_dealloc_, *last_dealloc_prev_;
+                hint*          hints_;
+                std::size_t    hint_shift_, no_hints_;
             };
 
             void swap(ordered_free_memory_list& a, ordered_free_memory_list& b) noexcept;
 
+            // same as above but stores hints to free nodes spread over the address space,
+            // so deallocations in random order only search the nodes close to a hint
+            // instead of the entire list
+            // it is bigger by the hints, so it is only used for array pools
+            class indexed_free_memory_list : public ordered_free_memory_list
+            {
+            public:
+                //=== constructor ===//
+                indexed_free_memory_list(std::size_t node_size) noexcept
+                : ordered_free_memory_list(node_size)
+                {
+                    set_hints(storage_);
+                }
+
+                indexed_free_memory_list(std::size_t node_size, void* mem,
+                                         std::size_t size) noexcept
+                : indexed_free_memory_list(node_size)
+                {
+                    insert(mem, size);
+                }
+
+                indexed_free_memory_list(indexed_free_memory_list&& other) noexcept
+                : ordered_free_memory_list(detail::move(other))
+                {
+                    set_hints(storage_);
+                }
+
+                ~indexed_free_memory_list() noexcept = default;
+
+                indexed_free_memory_list& operator=(indexed_free_memory_list&& other) noexcept
+                {
+                    ordered_free_memory_list::operator=(detail::move(other));
+                    return *this;
+                }
+
+            private:
+                hint storage_[hint_count];
+            };
+
+#if defined(__x86_64__) || defined(_M_X64)
+// user space addresses only use the lower 47 bits,
+// so the tag fits into the upper bits of the pointer
+#define FOONATHAN_MEMORY_IMPL_PACKED_TAG 1
+#else
+#define FOONATHAN_MEMORY_IMPL_PACKED_TAG 0
+#endif
+
+            // same as free_memory_list but allocation and deallocation are lock-free
+            // it is a Treiber stack using a tagged pointer to prevent the ABA problem
+            // on x86-64 the tag is packed into the upper bits of the pointer, which is lock-free,
+            // elsewhere the pointer and the tag are a double-width atomic,
+            // which falls back to a lock in the standard library if there is no double-width CAS
+            // does not support arrays, allocate(n) returns nullptr for n > node_size()
+            // capacity() is only exact if no other thread modifies the list concurrently
+            // debug: fills memory and uses a bigger node_size for fence memory
+            class concurrent_free_memory_list
+            {
+            public:
+                // minimum element size
+                static constexpr auto min_element_size = sizeof(char*);
+                // alignment
+                static constexpr auto min_element_alignment = alignof(char*);
+
+                // minimal size of the block that needs to be inserted
+                static constexpr std::size_t min_block_size(std::size_t node_size,
+                                                            std::size_t number_of_nodes)
+                {
+                    return (node_size < min_element_size ? min_element_size : node_size)
+                           * number_of_nodes;
+                }
+
+                //=== constructor ===//
+                concurrent_free_memory_list(std::size_t node_size) noexcept;
+
+                // calls other constructor plus insert
+                concurrent_free_memory_list(std::size_t node_size, void* mem,
+                                            std::size_t size) noexcept;
+
+                // not thread safe
+                concurrent_free_memory_list(concurrent_free_memory_list&& other) noexcept;
+                ~concurrent_free_memory_list() noexcept = default;
+
+                concurrent_free_memory_list& operator=(
+                    concurrent_free_memory_list&& other) noexcept;
+
+                friend void swap(concurrent_free_memory_list& a,
+                                 concurrent_free_memory_list& b) noexcept;
+
+                //=== insert/allocation/deallocation ===//
+                // inserts a new memory block, by splitting it up and setting the links
+                // the nodes are linked first and then pushed at once
+                // does not own memory!
+                // mem must be aligned for alignment()
+                // pre: size != 0
+                void insert(void* mem, std::size_t size) noexcept;
+
+                // returns the usable size
+                // i.e. how many memory will be actually inserted and usable on a call to insert()
+                std::size_t usable_size(std::size_t size) const noexcept
+                {
+                    // Round down to next multiple of node size.
+                    return (size / node_size_) * node_size_;
+                }
+
+                // returns a single block from the list
+                // returns nullptr if the list is empty
+                void* allocate() noexcept;
+
+                // returns a single block if n <= node_size(), nullptr otherwise
+                void* allocate(std::size_t n) noexcept;
+
+                // deallocates a single block
+                void deallocate(void* ptr) noexcept;
+
+                // deallocates multiple blocks with n bytes total
+                void deallocate(void* ptr, std::size_t n) noexcept;
+
+                //=== getter ===//
+                std::size_t node_size() const noexcept
+                {
+                    return node_size_;
+                }
+
+                // alignment of all nodes
+                std::size_t alignment() const noexcept;
+
+                // number of nodes remaining
+                std::size_t capacity() const noexcept
+                {
+                    return capacity_.load(std::memory_order_relaxed);
+                }
+
+                bool empty() const noexcept;
+
+                // whether or not the operations need no lock, always true with the packed tag
+                bool is_lock_free() const noexcept
+                {
+                    return first_.is_lock_free();
+                }
+
+            private:
+#if FOONATHAN_MEMORY_IMPL_PACKED_TAG
+                using tagged_ptr = std::uintptr_t;
+#else
+                struct tagged_ptr
+                {
+                    char*          ptr;
+                    std::uintptr_t tag;
+                };
+#endif
+
+                static char* get_ptr(tagged_ptr tagged) noexcept;
+
+                // the pointer tagged with the next tag of old
+                static tagged_ptr next_tagged(tagged_ptr old, char* ptr) noexcept;
+
+                void push(char* first, char* last, std::size_t no_nodes) noexcept;
+
+                // written by all threads, the alignment gives the list its own cache line
+                alignas(cache_line_size) std::atomic<tagged_ptr> first_;
+                std::atomic<std::size_t>                         capacity_;
+                std::size_t                                      node_size_;
+            };
+
+            void swap(concurrent_free_memory_list& a, concurrent_free_memory_list& b) noexcept;
+
+            template <class FreeList>
+            struct is_concurrent_free_list : std::false_type
+            {
+            };
+
+            template <>
+            struct is_concurrent_free_list<concurrent_free_memory_list> : std::true_type
+            {
+            };
+
 #if FOONATHAN_MEMORY_DEBUG_DOUBLE_DEALLOC_CHECK
             // use ordered version to allow pointer check
             using node_free_memory_list  = ordered_free_memory_list;
-            using array_free_memory_list = ordered_free_memory_list;
+            using array_free_memory_list = indexed_free_memory_list;
 #else
             using node_free_memory_list  = free_memory_list;
-            using array_free_memory_list = ordered_free_memory_list;
+            using array_free_memory_list = indexed_free_memory_list;
 #endif
         } // namespace detail
     }     // namespace memory
@@ -36,18 +36,24 @@ namespace foonathan
                     array_ = static_cast<FreeList*>(
                         stack.allocate(end, no_elements_ * sizeof(FreeList), alignof(FreeList)));
                     FOONATHAN_MEMORY_ASSERT_MSG(array_, "insufficient memory for free lists");
+                    inserted_ = static_cast<std::size_t*>(
+                        stack.allocate(end, no_elements_ * sizeof(std::size_t),
+                                       alignof(std::size_t)));
+                    FOONATHAN_MEMORY_ASSERT_MSG(inserted_, "insufficient memory for free lists");
                     for (std::size_t i = 0u; i != no_elements_; ++i)
                     {
                         auto node_size = AccessPolicy::size_from_index(i + min_size_index);
                         ::new (static_cast<void*>(array_ + i)) FreeList(node_size);
+                        inserted_[i] = 0u;
                     }
                 }
 
                 // move constructor, does not actually move the elements, just the pointer
                 free_list_array(free_list_array&& other) noexcept
-                : array_(other.array_), no_elements_(other.no_elements_)
+                : array_(other.array_), inserted_(other.inserted_), no_elements_(other.no_elements_)
                 {
                     other.array_       = nullptr;
+                    other.inserted_    = nullptr;
                     other.no_elements_ = 0u;
                 }
 
@@ -57,9 +63,11 @@ namespace foonathan
                 free_list_array& operator=(free_list_array&& other) noexcept
                 {
                     array_       = other.array_;
+                    inserted_    = other.inserted_;
                     no_elements_ = other.no_elements_;
 
                     other.array_       = nullptr;
+                    other.inserted_    = nullptr;
                     other.no_elements_ = 0u;
                     return *this;
                 }
@@ -73,6 +81,19 @@ namespace foonathan
                     return array_[i - min_size_index];
                 }
 
+                // access free list with given index
+                FreeList& at(std::size_t i) const noexcept
+                {
+                    return array_[i];
+                }
+
+                // the usable size of all memory inserted into the given free list
+                // it is not updated by the free list itself
+                std::size_t& inserted_size(const FreeList& list) const noexcept
+                {
+                    return inserted_[std::size_t(&list - array_)];
+                }
+
                 // number of free lists
                 std::size_t size() const noexcept
                 {
@@ -88,14 +109,130 @@ namespace foonathan
             private:
                 static const std::size_t min_size_index;
 
-                FreeList*   array_;
-                std::size_t no_elements_;
+                FreeList*    array_;
+                std::size_t* inserted_;
+                std::size_t  no_elements_;
             };
 
             template <class FL, class AP>
             const std::size_t free_list_array<FL, AP>::min_size_index =
                 AP::index_from_size(FL::min_element_size);
 
+            // an array of pointers to free_memory_list types that are only created on first use
+            // indexed via size like free_list_array, AccessPolicy does necessary conversions
+            // the memory for the pointers and the lists themselves is provided by the caller
+            // requires trivial destructible FreeList type
+            template <class FreeList, class AccessPolicy>
+            class lazy_free_list_array
+            {
+            public:
+                // supports up to given maximum node size, but does not create anything yet
+                explicit lazy_free_list_array(std::size_t max_node_size) noexcept
+                : array_(nullptr),
+                  no_elements_(AccessPolicy::index_from_size(max_node_size) - min_size_index + 1)
+                {
+                }
+
+                // move constructor, does not actually move the elements, just the pointer
+                lazy_free_list_array(lazy_free_list_array&& other) noexcept
+                : array_(other.array_), no_elements_(other.no_elements_)
+                {
+                    other.array_       = nullptr;
+                    other.no_elements_ = 0u;
+                }
+
+                // destructor, does nothing, list must be trivially destructible!
+                ~lazy_free_list_array() noexcept = default;
+
+                lazy_free_list_array& operator=(lazy_free_list_array&& other) noexcept
+                {
+                    array_       = other.array_;
+                    no_elements_ = other.no_elements_;
+
+                    other.array_       = nullptr;
+                    other.no_elements_ = 0u;
+                    return *this;
+                }
+
+                // whether or not the pointers have been created
+                bool has_table() const noexcept
+                {
+                    return array_ != nullptr;
+                }
+
+                // size of the memory needed for the pointers
+                std::size_t table_size() const noexcept
+                {
+                    return no_elements_ * sizeof(FreeList*);
+                }
+
+                // creates the pointers in the given memory of table_size(), all null
+                void create_table(void* memory) noexcept
+                {
+                    FOONATHAN_MEMORY_ASSERT(!has_table()
+                                            && is_aligned(memory, alignof(FreeList*)));
+                    array_ = static_cast<FreeList**>(memory);
+                    for (std::size_t i = 0u; i != no_elements_; ++i)
+                        array_[i] = nullptr;
+                }
+
+                // access free list for given size, nullptr if it has not been created yet
+                FreeList* get(std::size_t node_size) const noexcept
+                {
+                    return array_ ? array_[index(node_size)] : nullptr;
+                }
+
+                // creates the free list for given size in the given memory of sizeof(FreeList)
+                // requires: has_table() and that the list has not been created yet
+                FreeList& create(std::size_t node_size, void* memory) noexcept
+                {
+                    FOONATHAN_MEMORY_ASSERT(has_table() && !get(node_size)
+                                            && is_aligned(memory, alignof(FreeList)));
+                    auto i         = index(node_size);
+                    auto list_size = AccessPolicy::size_from_index(i + min_size_index);
+                    array_[i]      = ::new (memory) FreeList(list_size);
+                    return *array_[i];
+                }
+
+                // number of free lists
+                std::size_t size() const noexcept
+                {
+                    return no_elements_;
+                }
+
+                // number of free lists that have been created
+                std::size_t no_created() const noexcept
+                {
+                    auto result = std::size_t(0);
+                    for (std::size_t i = 0u; array_ && i != no_elements_; ++i)
+                        if (array_[i])
+                            ++result;
+                    return result;
+                }
+
+                // maximum supported node size
+                std::size_t max_node_size() const noexcept
+                {
+                    return AccessPolicy::size_from_index(no_elements_ + min_size_index - 1);
+                }
+
+            private:
+                static std::size_t index(std::size_t node_size) noexcept
+                {
+                    auto i = AccessPolicy::index_from_size(node_size);
+                    return (i < min_size_index ? min_size_index : i) - min_size_index;
+                }
+
+                static const std::size_t min_size_index;
+
+                FreeList**  array_;
+                std::size_t no_elements_;
+            };
+
+            template <class FL, class AP>
+            const std::size_t lazy_free_list_array<FL, AP>::min_size_index =
+                AP::index_from_size(FL::min_element_size);
+
             // AccessPolicy that maps size to indices 1:1
             // creates a free list for each size!
             struct identity_access_policy
@@ -118,6 +255,16 @@ namespace foonathan
                 static std::size_t index_from_size(std::size_t size) noexcept;
                 static std::size_t size_from_index(std::size_t index) noexcept;
             };
+
+            // AccessPolicy that maps sizes to geometrically spaced size classes
+            // each power of two is split into four classes, i.e. 40, 48, 56, 64 for (32, 64],
+            // sizes up to four get their own class
+            // this creates more nodes than log2 but never wastes more than a quarter of the size
+            struct geometric_access_policy
+            {
+                static std::size_t index_from_size(std::size_t size) noexcept;
+                static std::size_t size_from_index(std::size_t index) noexcept;
+            };
         } // namespace detail
     }     // namespace memory
 } // namespace foonathan
@@ -32,6 +32,7 @@ namespace foonathan
             // static void* allocate(std::size_t size, std::size_t alignment);
             // static void deallocate(void *memory, std::size_t size, std::size_t alignment);
             // static std::size_t max_node_size();
+            // static std::size_t max_alignment();
             template <class Functor>
             class lowlevel_allocator : global_leak_checker<lowlevel_allocator_leak_handler<Functor>>
             {
@@ -49,22 +50,24 @@ namespace foonathan
 
                 void* allocate_node(std::size_t size, std::size_t alignment)
                 {
-                    auto actual_size = size + (debug_fence_size ? 2 * max_alignment : 0u);
+                    auto fence       = fence_size(alignment);
+                    auto actual_size = size + 2 * fence;
 
                     auto memory = Functor::allocate(actual_size, alignment);
-                    if (!memory)
-                        FOONATHAN_THROW(out_of_memory(Functor::info(), actual_size));
+                    if (FOONATHAN_MEMORY_UNLIKELY(!memory))
+                        throw_out_of_memory(Functor::info(), actual_size);
 
                     this->on_allocate(actual_size);
 
-                    return debug_fill_new(memory, size, max_alignment);
+                    return debug_fill_new(memory, size, fence);
                 }
 
                 void deallocate_node(void* node, std::size_t size, std::size_t alignment) noexcept
                 {
-                    auto actual_size = size + (debug_fence_size ? 2 * max_alignment : 0u);
+                    auto fence       = fence_size(alignment);
+                    auto actual_size = size + 2 * fence;
 
-                    auto memory = debug_fill_free(node, size, max_alignment);
+                    auto memory = debug_fill_free(node, size, fence);
                     Functor::deallocate(memory, actual_size, alignment);
 
                     this->on_deallocate(actual_size);
@@ -74,6 +77,20 @@ namespace foonathan
                 {
                     return Functor::max_node_size();
                 }
+
+                std::size_t max_alignment() const noexcept
+                {
+                    return Functor::max_alignment();
+                }
+
+            private:
+                // the fences must keep over-aligned memory aligned
+                static std::size_t fence_size(std::size_t alignment) noexcept
+                {
+                    if (!debug_fence_size)
+                        return 0u;
+                    return alignment > detail::max_alignment ? alignment : detail::max_alignment;
+                }
             };
 
 #define FOONATHAN_MEMORY_LL_ALLOCATOR_LEAK_CHECKER(functor, var_name)                              \
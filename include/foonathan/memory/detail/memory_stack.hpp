@@ -4,7 +4,9 @@
 #ifndef FOONATHAN_MEMORY_DETAIL_MEMORY_STACK_HPP_INCLUDED
 #define FOONATHAN_MEMORY_DETAIL_MEMORY_STACK_HPP_INCLUDED
 
+#include <atomic>
 #include <cstddef>
+#include <cstring>
 
 #include "../config.hpp"
 #include "align.hpp"
@@ -44,16 +46,19 @@ namespace foonathan
                 }
 
                 // bumps the top pointer without filling it
+                // debug: unpoisons the memory
                 void bump(std::size_t offset) noexcept
                 {
+                    detail::debug_unpoison(cur_, offset);
                     cur_ += offset;
                 }
 
                 // bumps the top pointer by offset and fills
                 void bump(std::size_t offset, debug_magic m) noexcept
                 {
+                    detail::debug_unpoison(cur_, offset);
                     detail::debug_fill(cur_, offset, m);
-                    bump(offset);
+                    cur_ += offset;
                 }
 
                 // same as bump(offset, m) but returns old value
@@ -61,8 +66,7 @@ namespace foonathan
                                   debug_magic m = debug_magic::new_memory) noexcept
                 {
                     auto memory = cur_;
-                    detail::debug_fill(memory, offset, m);
-                    cur_ += offset;
+                    bump(offset, m);
                     return memory;
                 }
 
@@ -82,6 +86,22 @@ namespace foonathan
                     return allocate_unchecked(size, offset, fence_size);
                 }
 
+                // same as allocate() but for a size and alignment known at compile-time,
+                // so the fences and the offset for an alignment of one are constant
+                template <std::size_t Size, std::size_t Alignment,
+                          std::size_t FenceSize = debug_fence_size>
+                void* allocate(const char* end) noexcept
+                {
+                    if (cur_ == nullptr)
+                        return nullptr;
+
+                    auto offset = align_offset<Alignment>(cur_ + FenceSize);
+                    if (FenceSize + offset + Size + FenceSize > std::size_t(end - cur_))
+                        return nullptr;
+
+                    return allocate_unchecked(Size, offset, FenceSize);
+                }
+
                 // same as allocate() but does not check the size
                 // note: pass it the align OFFSET, not the alignment
                 void* allocate_unchecked(std::size_t size, std::size_t align_offset,
@@ -94,6 +114,30 @@ namespace foonathan
                     return mem;
                 }
 
+                // changes the size of the last allocation in place, returns false if insufficient
+                // or if memory with old_size is not the last allocation
+                // debug: marks grown memory as new_memory and shrunk memory as freed, moves fence
+                bool try_resize(const char* end, void* memory, std::size_t old_size,
+                                std::size_t new_size,
+                                std::size_t fence_size = debug_fence_size) noexcept
+                {
+                    auto mem = static_cast<char*>(memory);
+                    if (cur_ == nullptr || mem + old_size + fence_size != cur_)
+                        return false;
+                    else if (new_size > old_size && new_size - old_size > std::size_t(end - cur_))
+                        return false;
+
+                    if (new_size >= old_size)
+                    {
+                        cur_ = mem + old_size;
+                        bump(new_size - old_size, debug_magic::new_memory);
+                    }
+                    else
+                        unwind(mem + new_size);
+                    bump(fence_size, debug_magic::fence_memory);
+                    return true;
+                }
+
                 // unwindws the stack to a certain older position
                 // debug: marks memory from new top to old top as freed
                 // doesn't check for invalid pointer
@@ -112,6 +156,79 @@ namespace foonathan
             private:
                 char* cur_;
             };
+
+            // clears the memory just allocated from a stack that is below zeroed,
+            // everything between the top and zeroed might have been used before,
+            // everything above both has never been touched and is still zero
+            inline void clear_used_memory(void* memory, std::size_t size,
+                                          const char* zeroed) noexcept
+            {
+                auto mem  = static_cast<char*>(memory);
+                auto used = mem < zeroed ? std::size_t(zeroed - mem) : std::size_t(0u);
+                std::memset(mem, 0, used < size ? used : size);
+            }
+
+            // fixed_memory_stack whose allocation can be used by multiple threads at once
+            // only allocation is lock-free, everything else must not run concurrently
+            class atomic_fixed_memory_stack
+            {
+            public:
+                atomic_fixed_memory_stack() noexcept : atomic_fixed_memory_stack(nullptr) {}
+
+                // gives it the current pointer, the end pointer must be maintained seperataly
+                explicit atomic_fixed_memory_stack(void* memory) noexcept
+                : cur_(static_cast<char*>(memory))
+                {
+                }
+
+                // allocates memory by atomically advancing the stack, nullptr if insufficient
+                // debug: mark memory as new_memory, put fence in front and back
+                void* allocate(const char* end, std::size_t size, std::size_t alignment,
+                               std::size_t fence_size = debug_fence_size) noexcept
+                {
+                    auto        cur = cur_.load(std::memory_order_relaxed);
+                    char*       memory;
+                    std::size_t offset;
+                    do
+                    {
+                        if (cur == nullptr)
+                            return nullptr;
+
+                        auto remaining = std::size_t(end - cur);
+                        offset         = align_offset(cur + fence_size, alignment);
+                        if (fence_size + offset + size + fence_size > remaining)
+                            return nullptr;
+                        memory = cur + fence_size + offset;
+                    } while (!cur_.compare_exchange_weak(cur, memory + size + fence_size,
+                                                         std::memory_order_relaxed));
+
+                    // memory between cur and the new top is owned by this thread now
+                    detail::debug_fill(cur, fence_size, debug_magic::fence_memory);
+                    detail::debug_fill(cur + fence_size, offset, debug_magic::alignment_memory);
+                    detail::debug_fill(memory, size, debug_magic::new_memory);
+                    detail::debug_fill(memory + size, fence_size, debug_magic::fence_memory);
+                    return memory;
+                }
+
+                // unwindws the stack to a certain older position
+                // debug: marks memory from new top to old top as freed
+                // doesn't check for invalid pointer
+                void unwind(char* top) noexcept
+                {
+                    auto cur = cur_.load(std::memory_order_relaxed);
+                    debug_fill(top, std::size_t(cur - top), debug_magic::freed_memory);
+                    cur_.store(top, std::memory_order_relaxed);
+                }
+
+                // returns the current top
+                char* top() const noexcept
+                {
+                    return cur_.load(std::memory_order_relaxed);
+                }
+
+            private:
+                std::atomic<char*> cur_;
+            };
         } // namespace detail
     }     // namespace memory
 } // namespace foonathan
@@ -5,7 +5,8 @@
 #define FOONATHAN_MEMORY_DETAIL_SMALL_FREE_LIST_HPP_INCLUDED
 
 #include <cstddef>
-#include <climits>
+#include <cstdint>
+#include <limits>
 
 #include "../config.hpp"
 #include "utility.hpp"
@@ -17,44 +18,73 @@ namespace foonathan
     {
         namespace detail
         {
+            // IndexType is the type used to store node indices inside a chunk,
+            // it limits the number of nodes in a chunk
+            template <typename IndexType>
             struct chunk_base
             {
                 chunk_base* prev = this;
                 chunk_base* next = this;
 
-                unsigned char first_free = 0; // first free node for the linked list
-                unsigned char capacity   = 0; // total number of free nodes available
-                unsigned char no_nodes   = 0; // total number of nodes in memory
+                IndexType first_free = 0; // first free node for the linked list
+                IndexType capacity   = 0; // total number of free nodes available
+                IndexType no_nodes   = 0; // total number of nodes in memory
 
                 chunk_base() noexcept = default;
 
-                chunk_base(unsigned char no) noexcept : capacity(no), no_nodes(no) {}
+                chunk_base(IndexType no) noexcept : capacity(no), no_nodes(no) {}
             };
 
-            constexpr std::size_t chunk_memory_offset =
-                sizeof(chunk_base) % detail::max_alignment == 0 ?
-                    sizeof(chunk_base) :
-                    (sizeof(chunk_base) / detail::max_alignment + 1) * detail::max_alignment;
-            constexpr std::size_t chunk_max_nodes = UCHAR_MAX;
+            // header of each memory block inserted into the list
+            // the chunks are stored directly after it with the same distance to each other
+            // so the chunk of a node can be computed without searching through all chunks
+            struct chunk_block
+            {
+                chunk_block*   next = nullptr;
+                unsigned char* end  = nullptr; // end of the last chunk
+            };
+
+            constexpr std::size_t round_up_to_max_alignment(std::size_t size) noexcept
+            {
+                return size % detail::max_alignment == 0 ?
+                           size :
+                           (size / detail::max_alignment + 1) * detail::max_alignment;
+            }
 
+            constexpr std::size_t chunk_block_offset =
+                round_up_to_max_alignment(sizeof(chunk_block));
+
+            template <typename IndexType>
             struct chunk;
 
+            template <typename IndexType>
+            class basic_small_free_memory_list;
+
+            template <typename IndexType>
+            void swap(basic_small_free_memory_list<IndexType>& a,
+                      basic_small_free_memory_list<IndexType>& b) noexcept;
+
             // the same as free_memory_list but optimized for small node sizes
             // it is slower and does not support arrays
             // but has very small overhead
+            // the memory is divided into chunks of at most chunk_max_nodes nodes,
+            // a free node stores the index of the next free node of its chunk
             // debug: allocate() and deallocate() mark memory as new and freed, respectively
             // node_size is increased via two times fence size and fence is put in front and after
-            class small_free_memory_list
+            template <typename IndexType>
+            class basic_small_free_memory_list
             {
-                static constexpr std::size_t chunk_count(std::size_t number_of_nodes)
-                {
-                    return number_of_nodes / chunk_max_nodes
-                           + (number_of_nodes % chunk_max_nodes == 0 ? 0 : 1);
-                }
+                using chunk_type = chunk<IndexType>;
+                using chunk_base = detail::chunk_base<IndexType>;
 
             public:
+                static constexpr std::size_t chunk_memory_offset =
+                    round_up_to_max_alignment(sizeof(chunk_base));
+                static constexpr std::size_t chunk_max_nodes =
+                    std::numeric_limits<IndexType>::max();
+
                 // minimum element size
-                static constexpr std::size_t min_element_size = 1;
+                static constexpr std::size_t min_element_size = sizeof(IndexType);
                 // alignment
                 static constexpr std::size_t min_element_alignment = 1;
 
@@ -62,31 +92,40 @@ namespace foonathan
                 static constexpr std::size_t min_block_size(std::size_t node_size,
                                                             std::size_t number_of_nodes)
                 {
-                    return chunk_count(number_of_nodes)
-                           * (chunk_memory_offset + chunk_max_nodes * node_size);
+                    return chunk_block_offset
+                           + number_of_nodes / chunk_max_nodes * chunk_stride(node_size)
+                           + (number_of_nodes % chunk_max_nodes == 0 ?
+                                  0 :
+                                  chunk_memory_offset
+                                      + number_of_nodes % chunk_max_nodes
+                                            * actual_node_size(node_size));
                 }
 
                 //=== constructor ===//
-                small_free_memory_list(std::size_t node_size) noexcept;
+                basic_small_free_memory_list(std::size_t node_size) noexcept;
 
                 // does not own memory!
-                small_free_memory_list(std::size_t node_size, void* mem, std::size_t size) noexcept;
+                basic_small_free_memory_list(std::size_t node_size, void* mem,
+                                             std::size_t size) noexcept;
 
-                small_free_memory_list(small_free_memory_list&& other) noexcept;
+                basic_small_free_memory_list(basic_small_free_memory_list&& other) noexcept;
 
-                ~small_free_memory_list() noexcept = default;
+                ~basic_small_free_memory_list() noexcept = default;
 
-                small_free_memory_list& operator=(small_free_memory_list&& other) noexcept
+                basic_small_free_memory_list& operator=(
+                    basic_small_free_memory_list&& other) noexcept
                 {
-                    small_free_memory_list tmp(detail::move(other));
+                    basic_small_free_memory_list tmp(detail::move(other));
                     swap(*this, tmp);
                     return *this;
                 }
 
-                friend void swap(small_free_memory_list& a, small_free_memory_list& b) noexcept;
+                friend void swap<>(basic_small_free_memory_list& a,
+                                   basic_small_free_memory_list& b) noexcept;
 
                 //=== insert/alloc/dealloc ===//
                 // inserts new memory of given size into the free list
+                // the beginning of the memory is used for a chunk_block header
                 // mem must be aligned for maximum alignment
                 void insert(void* mem, std::size_t size) noexcept;
 
@@ -144,18 +183,51 @@ namespace foonathan
                 }
 
             private:
-                chunk* find_chunk_impl(std::size_t n = 1) noexcept;
-                chunk* find_chunk_impl(unsigned char* node, chunk_base* first,
-                                       chunk_base* last) noexcept;
-                chunk* find_chunk_impl(unsigned char* node) noexcept;
-
-                chunk_base  base_;
-                std::size_t node_size_, capacity_;
-                chunk_base *alloc_chunk_, *dealloc_chunk_;
+                static constexpr std::size_t actual_node_size(std::size_t node_size) noexcept
+                {
+                    return node_size < min_element_size ? min_element_size : node_size;
+                }
+
+                // distance between two full chunks, chunk headers are pointer aligned
+                static constexpr std::size_t chunk_stride(std::size_t node_size) noexcept
+                {
+                    return (chunk_memory_offset + chunk_max_nodes * actual_node_size(node_size)
+                            + alignof(chunk_base) - 1u)
+                           / alignof(chunk_base) * alignof(chunk_base);
+                }
+
+                chunk_type* find_chunk_impl(std::size_t n = 1) noexcept;
+                // finds the block of the node and computes the chunk from it
+                // linear in the number of blocks, but constant in the number of chunks:
+                // the blocks come from an arbitrary BlockAllocator and are not aligned,
+                // so their header cannot be reached by masking the node address,
+                // and a free node only has room for the index of the next one, not for its chunk
+                // the last chunk and the most recently used blocks are checked first,
+                // and a growing arena has only few blocks
+                chunk_type* find_chunk_impl(unsigned char* node) noexcept;
+
+                chunk_base   base_;
+                std::size_t  node_size_, capacity_;
+                chunk_base * alloc_chunk_, *dealloc_chunk_;
+                chunk_block* blocks_;
             };
 
-            // for some reason, this is required in order to define it
-            void swap(small_free_memory_list& a, small_free_memory_list& b) noexcept;
+            template <typename IndexType>
+            constexpr std::size_t basic_small_free_memory_list<IndexType>::chunk_memory_offset;
+            template <typename IndexType>
+            constexpr std::size_t basic_small_free_memory_list<IndexType>::chunk_max_nodes;
+            template <typename IndexType>
+            constexpr std::size_t basic_small_free_memory_list<IndexType>::min_element_size;
+            template <typename IndexType>
+            constexpr std::size_t basic_small_free_memory_list<IndexType>::min_element_alignment;
+
+            extern template class basic_small_free_memory_list<unsigned char>;
+            extern template class basic_small_free_memory_list<std::uint_least16_t>;
+
+            // up to 255 nodes per chunk, one byte minimum node size
+            using small_free_memory_list = basic_small_free_memory_list<unsigned char>;
+            // up to 65535 nodes per chunk, two byte minimum node size
+            using wide_small_free_memory_list = basic_small_free_memory_list<std::uint_least16_t>;
         } // namespace detail
     }     // namespace memory
 } // namespace foonathan
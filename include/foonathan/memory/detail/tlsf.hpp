@@ -0,0 +1,358 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_DETAIL_TLSF_HPP_INCLUDED
+#define FOONATHAN_MEMORY_DETAIL_TLSF_HPP_INCLUDED
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "../config.hpp"
+#include "align.hpp"
+#include "assert.hpp"
+#include "ilog2.hpp"
+#include "utility.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        namespace detail
+        {
+            // header of every physical block of a tlsf_free_list
+            // it is followed by the memory of the node,
+            // which stores the links of the free list while the block is free
+            struct tlsf_block
+            {
+                static constexpr std::size_t free_flag = 1u;
+
+                tlsf_block* prev_phys; // nullptr for the first block of a region
+                std::size_t size;      // including the header, lowest bit is the free flag
+
+                struct links
+                {
+                    tlsf_block *prev, *next;
+                };
+
+                std::size_t block_size() const noexcept
+                {
+                    return size & ~free_flag;
+                }
+
+                bool is_free() const noexcept
+                {
+                    return (size & free_flag) != 0u;
+                }
+
+                // the sentinel at the end of a region has size zero
+                tlsf_block* next_phys() noexcept
+                {
+                    return reinterpret_cast<tlsf_block*>(reinterpret_cast<char*>(this)
+                                                         + block_size());
+                }
+
+                char* memory() noexcept
+                {
+                    return reinterpret_cast<char*>(this + 1);
+                }
+
+                links& free_links() noexcept
+                {
+                    return *reinterpret_cast<links*>(memory());
+                }
+            };
+
+            // two-level segregated fit free lists over the blocks of inserted regions
+            // the first level is the power of two of a block size,
+            // the second level splits each power of two linearly into 2^SecondLevelLog2 lists,
+            // a bitmap per level gives the first non-empty list that is big enough in O(1),
+            // and free blocks are merged with their physical neighbors on deallocation in O(1)
+            // sizes below 2^(SecondLevelLog2 + log2(granularity)) are all in the first first level
+            template <std::size_t FirstLevelCount, std::size_t SecondLevelLog2>
+            class tlsf_free_list
+            {
+                static constexpr std::size_t second_level_count = std::size_t(1u)
+                                                                  << SecondLevelLog2;
+                static constexpr std::size_t bits = sizeof(std::size_t) * CHAR_BIT;
+
+                static_assert(FirstLevelCount > 0u && FirstLevelCount <= bits,
+                              "first level bitmap must fit into std::size_t");
+                static_assert(second_level_count <= bits,
+                              "second level bitmap must fit into std::size_t");
+
+            public:
+                // the size and alignment of all nodes is a multiple of it
+                static constexpr std::size_t granularity = sizeof(tlsf_block);
+                static constexpr std::size_t header_size  = sizeof(tlsf_block);
+                // a free block must have room for the links
+                static constexpr std::size_t min_block_size =
+                    header_size + sizeof(tlsf_block::links);
+
+                //=== constructor ===//
+                tlsf_free_list() noexcept : first_level_(0u), capacity_(0u), managed_(0u)
+                {
+                    for (auto& map : second_level_)
+                        map = 0u;
+                    for (auto& level : heads_)
+                        for (auto& head : level)
+                            head = nullptr;
+                }
+
+                tlsf_free_list(tlsf_free_list&& other) noexcept : tlsf_free_list()
+                {
+                    swap(*this, other);
+                }
+
+                ~tlsf_free_list() noexcept = default;
+
+                tlsf_free_list& operator=(tlsf_free_list&& other) noexcept
+                {
+                    tlsf_free_list tmp(detail::move(other));
+                    swap(*this, tmp);
+                    return *this;
+                }
+
+                friend void swap(tlsf_free_list& a, tlsf_free_list& b) noexcept
+                {
+                    detail::adl_swap(a.first_level_, b.first_level_);
+                    for (std::size_t i = 0u; i != FirstLevelCount; ++i)
+                    {
+                        detail::adl_swap(a.second_level_[i], b.second_level_[i]);
+                        for (std::size_t j = 0u; j != second_level_count; ++j)
+                            detail::adl_swap(a.heads_[i][j], b.heads_[i][j]);
+                    }
+                    detail::adl_swap(a.capacity_, b.capacity_);
+                    detail::adl_swap(a.managed_, b.managed_);
+                }
+
+                //=== insert/allocation/deallocation ===//
+                // inserts a new memory region as a single free block followed by a sentinel
+                // does not own memory!
+                // mem must be aligned for the granularity
+                void insert(void* mem, std::size_t size) noexcept
+                {
+                    FOONATHAN_MEMORY_ASSERT(is_aligned(mem, granularity));
+                    auto usable = usable_size(size);
+                    FOONATHAN_MEMORY_ASSERT(usable >= min_block_size);
+
+                    auto block       = ::new (mem) tlsf_block;
+                    block->prev_phys = nullptr;
+                    block->size      = usable;
+
+                    auto sentinel       = block->next_phys();
+                    sentinel->prev_phys = block;
+                    sentinel->size      = 0u;
+
+                    managed_ += usable;
+                    push(block);
+                }
+
+                // the size of the single free block of a region of the given size
+                static constexpr std::size_t usable_size(std::size_t size) noexcept
+                {
+                    return size < header_size + min_block_size ?
+                               0u :
+                               (size - header_size) / granularity * granularity;
+                }
+
+                // the total size of the block of a node of the given size
+                static std::size_t block_size(std::size_t n) noexcept
+                {
+                    auto size = header_size + (n + granularity - 1u) / granularity * granularity;
+                    return size < min_block_size ? min_block_size : size;
+                }
+
+                // the biggest node that can be allocated from a free block of the given size,
+                // some bigger nodes may not get a block in the first level searched for them
+                static std::size_t max_node_size(std::size_t block_size) noexcept
+                {
+                    if (block_size < min_block_size)
+                        return 0u;
+                    // rounded down to the start of the second level list
+                    auto log2  = ilog2(block_size);
+                    auto round = log2 < SecondLevelLog2 ? 0u : log2 - SecondLevelLog2;
+                    return (block_size >> round << round) - header_size;
+                }
+
+                // returns a node of at least n bytes or nullptr if there is no free block
+                void* allocate(std::size_t n) noexcept
+                {
+                    if (n > ~std::size_t(0u) / 2u)
+                        return nullptr;
+                    auto size  = block_size(n);
+                    auto block = find(size);
+                    if (!block)
+                        return nullptr;
+                    erase(block);
+
+                    // the rest becomes a free block on its own
+                    if (block->block_size() - size >= min_block_size)
+                    {
+                        auto rest       = reinterpret_cast<tlsf_block*>(
+                            reinterpret_cast<char*>(block) + size);
+                        rest->prev_phys = block;
+                        rest->size      = block->block_size() - size;
+                        rest->next_phys()->prev_phys = rest;
+                        block->size                  = size;
+                        push(rest);
+                    }
+                    else
+                        block->size = block->block_size();
+
+                    return block->memory();
+                }
+
+                // deallocates a node and merges it with the free blocks before and after it
+                void deallocate(void* ptr) noexcept
+                {
+                    auto block = header_of(ptr);
+
+                    auto next = block->next_phys();
+                    if (next->is_free())
+                    {
+                        erase(next);
+                        block->size += next->block_size();
+                        block->next_phys()->prev_phys = block;
+                    }
+
+                    auto prev = block->prev_phys;
+                    if (prev && prev->is_free())
+                    {
+                        erase(prev);
+                        prev->size += block->block_size();
+                        prev->next_phys()->prev_phys = prev;
+                        block = prev;
+                    }
+
+                    push(block);
+                }
+
+                static tlsf_block* header_of(void* ptr) noexcept
+                {
+                    return reinterpret_cast<tlsf_block*>(ptr) - 1;
+                }
+
+                //=== getter ===//
+                // number of bytes in free blocks, including their headers
+                std::size_t capacity() const noexcept
+                {
+                    return capacity_;
+                }
+
+                // number of bytes in all blocks
+                std::size_t managed() const noexcept
+                {
+                    return managed_;
+                }
+
+            private:
+                // the first and second level index of a block size
+                static void mapping(std::size_t size, std::size_t& fl, std::size_t& sl) noexcept
+                {
+                    auto shift = SecondLevelLog2 + ilog2(granularity);
+                    if (size < (std::size_t(1u) << shift))
+                    {
+                        fl = 0u;
+                        sl = size / granularity;
+                    }
+                    else
+                    {
+                        auto log2 = ilog2(size);
+                        fl        = log2 - shift + 1u;
+                        sl        = (size >> (log2 - SecondLevelLog2)) ^ second_level_count;
+                    }
+                }
+
+                // a free block of at least the given size or nullptr
+                // the size is rounded up to the next list, so every block in it is big enough
+                tlsf_block* find(std::size_t size) const noexcept
+                {
+                    auto log2 = ilog2(size);
+                    if (log2 >= SecondLevelLog2)
+                        size += (std::size_t(1u) << (log2 - SecondLevelLog2)) - 1u;
+
+                    std::size_t fl, sl;
+                    mapping(size, fl, sl);
+                    if (fl >= FirstLevelCount)
+                        return nullptr;
+
+                    auto sl_map = second_level_[fl] & (~std::size_t(0u) << sl);
+                    if (sl_map == 0u)
+                    {
+                        auto fl_map =
+                            fl + 1u == bits ? 0u : first_level_ & (~std::size_t(0u) << (fl + 1u));
+                        if (fl_map == 0u)
+                            return nullptr;
+                        fl     = lowest_bit(fl_map);
+                        sl_map = second_level_[fl];
+                    }
+                    return heads_[fl][lowest_bit(sl_map)];
+                }
+
+                void push(tlsf_block* block) noexcept
+                {
+                    std::size_t fl, sl;
+                    mapping(block->block_size(), fl, sl);
+                    FOONATHAN_MEMORY_ASSERT(fl < FirstLevelCount);
+
+                    auto& links = block->free_links();
+                    links.prev  = nullptr;
+                    links.next  = heads_[fl][sl];
+                    if (links.next)
+                        links.next->free_links().prev = block;
+                    heads_[fl][sl] = block;
+
+                    first_level_ |= std::size_t(1u) << fl;
+                    second_level_[fl] |= std::size_t(1u) << sl;
+                    block->size |= tlsf_block::free_flag;
+                    capacity_ += block->block_size();
+                }
+
+                void erase(tlsf_block* block) noexcept
+                {
+                    std::size_t fl, sl;
+                    mapping(block->block_size(), fl, sl);
+
+                    auto& links = block->free_links();
+                    if (links.prev)
+                        links.prev->free_links().next = links.next;
+                    else
+                        heads_[fl][sl] = links.next;
+                    if (links.next)
+                        links.next->free_links().prev = links.prev;
+
+                    if (!heads_[fl][sl])
+                    {
+                        second_level_[fl] &= ~(std::size_t(1u) << sl);
+                        if (second_level_[fl] == 0u)
+                            first_level_ &= ~(std::size_t(1u) << fl);
+                    }
+                    block->size &= ~tlsf_block::free_flag;
+                    capacity_ -= block->block_size();
+                }
+
+                static std::size_t lowest_bit(std::size_t bits) noexcept
+                {
+                    return ilog2(bits & (~bits + 1u));
+                }
+
+                std::size_t first_level_;
+                std::size_t second_level_[FirstLevelCount];
+                tlsf_block* heads_[FirstLevelCount][second_level_count];
+                std::size_t capacity_, managed_;
+            };
+
+            template <std::size_t FirstLevelCount, std::size_t SecondLevelLog2>
+            constexpr std::size_t tlsf_free_list<FirstLevelCount, SecondLevelLog2>::granularity;
+            template <std::size_t FirstLevelCount, std::size_t SecondLevelLog2>
+            constexpr std::size_t tlsf_free_list<FirstLevelCount, SecondLevelLog2>::header_size;
+            template <std::size_t FirstLevelCount, std::size_t SecondLevelLog2>
+            constexpr std::size_t
+                tlsf_free_list<FirstLevelCount, SecondLevelLog2>::min_block_size;
+        } // namespace detail
+    }     // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_DETAIL_TLSF_HPP_INCLUDED
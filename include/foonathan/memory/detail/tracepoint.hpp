@@ -0,0 +1,30 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_DETAIL_TRACEPOINT_HPP_INCLUDED
+#define FOONATHAN_MEMORY_DETAIL_TRACEPOINT_HPP_INCLUDED
+
+#include "../config.hpp"
+
+// static tracepoints on the slow paths of the allocators,
+// they are USDT probes of the provider foonathan_memory that tools like perf, bpftrace or SystemTap can attach to
+// a probe is a single nop instruction with its arguments kept in registers or memory,
+// and without the option, or if <sys/sdt.h> is not available, the macros expand to nothing
+#if FOONATHAN_MEMORY_TRACEPOINTS && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define FOONATHAN_MEMORY_IMPL_USDT 1
+#endif
+#endif
+
+#if defined(FOONATHAN_MEMORY_IMPL_USDT)
+#define FOONATHAN_MEMORY_TRACE1(Name, A) DTRACE_PROBE1(foonathan_memory, Name, A)
+#define FOONATHAN_MEMORY_TRACE2(Name, A, B) DTRACE_PROBE2(foonathan_memory, Name, A, B)
+#define FOONATHAN_MEMORY_TRACE3(Name, A, B, C) DTRACE_PROBE3(foonathan_memory, Name, A, B, C)
+#else
+#define FOONATHAN_MEMORY_TRACE1(Name, A)
+#define FOONATHAN_MEMORY_TRACE2(Name, A, B)
+#define FOONATHAN_MEMORY_TRACE3(Name, A, B, C)
+#endif
+
+#endif // FOONATHAN_MEMORY_DETAIL_TRACEPOINT_HPP_INCLUDED
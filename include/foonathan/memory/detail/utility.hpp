@@ -110,6 +110,43 @@ namespace foonathan
             struct is_instantiation_of<Template, Template<Args...>> : std::true_type
             {
             };
+
+            // std::index_sequence is C++14
+            template <std::size_t... I>
+            struct index_sequence
+            {
+                using type = index_sequence;
+            };
+
+            template <class A, class B>
+            struct concat_index_sequence;
+
+            template <std::size_t... A, std::size_t... B>
+            struct concat_index_sequence<index_sequence<A...>, index_sequence<B...>>
+            : index_sequence<A..., (sizeof...(A) + B)...>
+            {
+            };
+
+            // logarithmic instantiation depth, so it works for long sequences as well
+            template <std::size_t N>
+            struct make_index_sequence_impl
+            : concat_index_sequence<typename make_index_sequence_impl<N / 2>::type,
+                                    typename make_index_sequence_impl<N - N / 2>::type>
+            {
+            };
+
+            template <>
+            struct make_index_sequence_impl<0> : index_sequence<>
+            {
+            };
+
+            template <>
+            struct make_index_sequence_impl<1> : index_sequence<0>
+            {
+            };
+
+            template <std::size_t N>
+            using make_index_sequence = typename make_index_sequence_impl<N>::type;
         } // namespace detail
     }     // namespace memory
 } // namespace foonathan
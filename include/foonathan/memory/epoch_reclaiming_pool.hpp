@@ -0,0 +1,518 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_EPOCH_RECLAIMING_POOL_HPP_INCLUDED
+#define FOONATHAN_MEMORY_EPOCH_RECLAIMING_POOL_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::epoch_reclaiming_pool.
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+#include "detail/assert.hpp"
+#include "detail/utility.hpp"
+#include "config.hpp"
+#include "error.hpp"
+#include "heap_allocator.hpp"
+#include "memory_pool.hpp"
+
+#if !FOONATHAN_HOSTED_IMPLEMENTATION
+#error "epoch_reclaiming_pool requires a hosted implementation"
+#endif
+
+namespace foonathan
+{
+    namespace memory
+    {
+        namespace detail
+        {
+            // a chunk of pointers to retired nodes,
+            // the nodes themselves must not be written to as other threads may still read them
+            struct epoch_chunk
+            {
+                static constexpr std::size_t capacity = 62u;
+
+                epoch_chunk* next;
+                std::size_t  size;
+                void*        nodes[capacity];
+            };
+
+            // retired nodes tagged with the epoch they were retired in
+            struct epoch_bag
+            {
+                epoch_chunk*  first = nullptr;
+                std::uint64_t epoch = 0u;
+
+                // appends the chunks of other, leaving it empty
+                void splice(epoch_bag& other) noexcept
+                {
+                    if (!other.first)
+                        return;
+                    auto last = other.first;
+                    while (last->next)
+                        last = last->next;
+                    last->next  = first;
+                    first       = other.first;
+                    other.first = nullptr;
+                }
+            };
+
+            // the state of one participant, never freed before the pool
+            struct epoch_record
+            {
+                // (epoch << 1) | 1 while pinned, 0 otherwise
+                std::atomic<std::uint64_t> state;
+                epoch_record*              next;
+                std::size_t                pins;
+                // nodes retired since the last collection
+                epoch_chunk* current;
+                // indexed by epoch % 3
+                epoch_bag sealed[3];
+                // reclaimed chunks that can be reused
+                epoch_chunk* spare;
+                std::size_t  no_spare;
+                // only changed under the mutex of the pool,
+                // the sealed bags of an unused record are guarded by it as well
+                bool in_use;
+
+                epoch_record() noexcept
+                : state(0u), next(nullptr), pins(0u), current(nullptr), spare(nullptr), no_spare(0u),
+                  in_use(true)
+                {
+                }
+            };
+        } // namespace detail
+
+        /// A \ref memory_pool of type \ref node_pool for lock-free data structures
+        /// that defers the deallocation of nodes until no thread can access them anymore.
+        /// It uses epoch-based reclamation:
+        /// each thread accessing the data structure has a \ref participant
+        /// and calls \ref participant::pin() before it reads any node.
+        /// Nodes that were removed from the data structure are given to \ref participant::retire(),
+        /// which only stores them in a buffer of the calling thread, without any atomic operation.
+        /// Once the buffer is full, it is tagged with the current global epoch
+        /// and the epoch is advanced if all pinned threads have observed it.
+        /// The nodes of a buffer are returned to the free list in bulk under a single lock
+        /// once the epoch has advanced twice since it was tagged;
+        /// by then, all threads that might still hold a pointer to one of them have left their critical section.
+        /// \note Allocation from the shared pool is protected by a \c Mutex.
+        /// \note A thread that stays pinned blocks the reclamation of all nodes retired since,
+        /// they are kept in additional buffers allocated with \ref heap_alloc().
+        /// \ingroup allocator
+        template <class BlockOrRawAllocator = default_allocator, class Mutex = std::mutex>
+        class epoch_reclaiming_pool
+        {
+            using pool = memory_pool<node_pool, BlockOrRawAllocator>;
+
+        public:
+            using allocator_type = typename pool::allocator_type;
+            using mutex          = Mutex;
+
+            static constexpr std::size_t min_node_size = pool::min_node_size;
+
+            /// The number of nodes a \ref participant retires before it collects them automatically.
+            static constexpr std::size_t collect_threshold = detail::epoch_chunk::capacity;
+
+            class participant;
+
+            /// A RAII class that keeps a \ref participant pinned, see \ref participant::pin().
+            class guard
+            {
+            public:
+                guard(guard&& other) noexcept : record_(other.record_)
+                {
+                    other.record_ = nullptr;
+                }
+
+                /// \effects Unpins the participant, unless it is still pinned by another guard.
+                ~guard() noexcept
+                {
+                    if (record_ && --record_->pins == 0u)
+                        record_->state.store(0u, std::memory_order_release);
+                }
+
+                guard& operator=(guard&&) = delete;
+
+            private:
+                explicit guard(detail::epoch_record& record) noexcept : record_(&record) {}
+
+                detail::epoch_record* record_;
+
+                friend participant;
+            };
+
+            /// The handle of a thread taking part in the reclamation.
+            /// It must only be used by a single thread at a time.
+            class participant
+            {
+            public:
+                /// \effects Registers a new participant, reusing the state of a destroyed one if possible.
+                /// \throws \ref out_of_memory if the memory for the state could not be allocated.
+                explicit participant(epoch_reclaiming_pool& pool)
+                : pool_(&pool), record_(pool.acquire_record())
+                {
+                }
+
+                /// \effects Tags the retired nodes with the current epoch and unregisters it,
+                /// the nodes are reclaimed by another participant then.
+                /// \requires It must not be pinned.
+                ~participant() noexcept
+                {
+                    FOONATHAN_MEMORY_ASSERT(record_->pins == 0u);
+                    pool_->seal(*record_);
+                    pool_->release_record(*record_);
+                }
+
+                participant(const participant&)            = delete;
+                participant& operator=(const participant&) = delete;
+
+                /// \effects Pins the participant to the current epoch,
+                /// nodes retired from now on will not be deallocated until the returned guard is destroyed.
+                /// Pinning again while it is pinned is allowed and cheap.
+                /// \returns The guard that unpins it again.
+                guard pin() noexcept
+                {
+                    if (record_->pins++ == 0u)
+                    {
+                        auto epoch = pool_->epoch_.load(std::memory_order_relaxed);
+                        record_->state.store((epoch << 1u) | 1u, std::memory_order_relaxed);
+                        // the following reads of the data structure must not happen before the store
+                        std::atomic_thread_fence(std::memory_order_seq_cst);
+                    }
+                    return guard(*record_);
+                }
+
+                /// \returns Whether or not it is pinned.
+                bool is_pinned() const noexcept
+                {
+                    return record_->pins != 0u;
+                }
+
+                /// \effects Retires a node, it will be deallocated once no pinned thread can access it anymore.
+                /// If \ref collect_threshold nodes have been retired since the last collection, calls \ref collect() first.
+                /// The memory of the node is not touched until then.
+                /// \throws Anything thrown by \ref collect(), the node is not retired then.
+                /// \requires \c node must have been allocated from the pool and no longer be reachable
+                /// by a thread that pins itself after this call.
+                void retire(void* node)
+                {
+                    auto chunk = record_->current;
+                    if (!chunk || chunk->size == detail::epoch_chunk::capacity)
+                    {
+                        collect();
+                        chunk = record_->current;
+                    }
+                    chunk->nodes[chunk->size++] = node;
+                }
+
+                /// \effects Tags the retired nodes with the current epoch, tries to advance it,
+                /// and deallocates all nodes retired at least two epochs ago,
+                /// including the ones of destroyed participants.
+                /// \throws \ref out_of_memory if a new buffer for retired nodes is needed but could not be allocated.
+                void collect()
+                {
+                    pool_->seal(*record_);
+                    pool_->try_advance();
+                    pool_->reclaim(*record_);
+                    if (!record_->current)
+                        record_->current = pool_->allocate_chunk(*record_);
+                }
+
+                /// \returns The number of nodes retired by it that are not deallocated yet.
+                std::size_t retired() const noexcept
+                {
+                    auto result = count(record_->current);
+                    for (auto& bag : record_->sealed)
+                        result += count(bag.first);
+                    return result;
+                }
+
+            private:
+                static std::size_t count(const detail::epoch_chunk* chunk) noexcept
+                {
+                    std::size_t result = 0u;
+                    for (; chunk; chunk = chunk->next)
+                        result += chunk->size;
+                    return result;
+                }
+
+                epoch_reclaiming_pool* pool_;
+                detail::epoch_record*  record_;
+            };
+
+            /// \returns The minimum block size required for certain number of \concept{concept_node,node}.
+            static constexpr std::size_t min_block_size(std::size_t node_size,
+                                                        std::size_t number_of_nodes) noexcept
+            {
+                return pool::min_block_size(node_size, number_of_nodes);
+            }
+
+            /// \effects Creates it by creating the \ref memory_pool with the same arguments.
+            template <typename... Args>
+            epoch_reclaiming_pool(std::size_t node_size, std::size_t block_size, Args&&... args)
+            : pool_(node_size, block_size, detail::forward<Args>(args)...),
+              epoch_(0u),
+              records_(nullptr)
+            {
+            }
+
+            /// \effects Deallocates all retired nodes and destroys the pool.
+            /// \requires All participants must have been destroyed.
+            ~epoch_reclaiming_pool() noexcept
+            {
+                auto record = records_.load(std::memory_order_relaxed);
+                while (record)
+                {
+                    FOONATHAN_MEMORY_ASSERT(!record->in_use);
+                    if (record->current)
+                        deallocate(record->current, record->spare);
+                    for (auto& bag : record->sealed)
+                        deallocate(bag.first, record->spare);
+                    for (auto chunk = record->spare; chunk;)
+                    {
+                        auto next = chunk->next;
+                        heap_dealloc(chunk, sizeof(detail::epoch_chunk));
+                        chunk = next;
+                    }
+
+                    auto next = record->next;
+                    record->~epoch_record();
+                    heap_dealloc(record, sizeof(detail::epoch_record));
+                    record = next;
+                }
+            }
+
+            /// \note The participants point to the object, so it can neither be copied nor moved.
+            epoch_reclaiming_pool(const epoch_reclaiming_pool&)            = delete;
+            epoch_reclaiming_pool& operator=(const epoch_reclaiming_pool&) = delete;
+
+            /// \effects Allocates a single \concept{concept_node,node} from the pool.
+            /// \returns A node of size \ref node_size() suitable aligned.
+            /// \throws Anything thrown by \ref memory_pool::allocate_node().
+            void* allocate_node()
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                return pool_.allocate_node();
+            }
+
+            /// \effects Allocates a single \concept{concept_node,node} similar to \ref allocate_node(),
+            /// but the pool will not grow.
+            /// \returns A suitable aligned node of size \ref node_size() or `nullptr`.
+            void* try_allocate_node() noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                return pool_.try_allocate_node();
+            }
+
+            /// \effects Deallocates a node immediately,
+            /// e.g. if it was never reachable by other threads.
+            /// \requires \c ptr must be a result from a previous call to \ref allocate_node().
+            void deallocate_node(void* ptr) noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                pool_.deallocate_node(ptr);
+            }
+
+            /// \effects Advances the global epoch, if all pinned participants have observed the current one.
+            /// \returns Whether or not the epoch was advanced.
+            bool try_advance() noexcept
+            {
+                auto epoch = epoch_.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                for (auto record = records_.load(std::memory_order_acquire); record;
+                     record      = record->next)
+                {
+                    auto state = record->state.load(std::memory_order_relaxed);
+                    if ((state & 1u) != 0u && (state >> 1u) != epoch)
+                        return false;
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                // fails if another thread has advanced it already
+                return epoch_.compare_exchange_strong(epoch, epoch + 1u,
+                                                      std::memory_order_release,
+                                                      std::memory_order_relaxed);
+            }
+
+            /// \returns The current global epoch.
+            std::uint64_t epoch() const noexcept
+            {
+                return epoch_.load(std::memory_order_acquire);
+            }
+
+            /// \returns The size of each \concept{concept_node,node} in the pool.
+            std::size_t node_size() const noexcept
+            {
+                return pool_.node_size();
+            }
+
+            /// \returns The total amount of bytes remaining on the free list of the pool.
+            /// \note This does not include the retired nodes.
+            std::size_t capacity_left() noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                return pool_.capacity_left();
+            }
+
+        private:
+            allocator_info info() const noexcept
+            {
+                return {FOONATHAN_MEMORY_LOG_PREFIX "::epoch_reclaiming_pool", this};
+            }
+
+            detail::epoch_record* acquire_record()
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                for (auto record = records_.load(std::memory_order_relaxed); record;
+                     record      = record->next)
+                    if (!record->in_use)
+                    {
+                        if (!record->current)
+                            record->current = allocate_chunk(*record);
+                        record->in_use = true;
+                        return record;
+                    }
+
+                auto memory = heap_alloc(sizeof(detail::epoch_record));
+                auto chunk  = memory ? heap_alloc(sizeof(detail::epoch_chunk)) : nullptr;
+                if (!chunk)
+                {
+                    if (memory)
+                        heap_dealloc(memory, sizeof(detail::epoch_record));
+                    FOONATHAN_THROW(out_of_memory(info(), sizeof(detail::epoch_record)
+                                                              + sizeof(detail::epoch_chunk)));
+                }
+                auto record     = ::new (memory) detail::epoch_record;
+                record->current = init_chunk(chunk);
+                record->next    = records_.load(std::memory_order_relaxed);
+                records_.store(record, std::memory_order_release);
+                return record;
+            }
+
+            void release_record(detail::epoch_record& record) noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                record.in_use = false;
+            }
+
+            detail::epoch_chunk* allocate_chunk(detail::epoch_record& record)
+            {
+                void* memory = record.spare;
+                if (memory)
+                {
+                    record.spare = record.spare->next;
+                    --record.no_spare;
+                }
+                else
+                {
+                    memory = heap_alloc(sizeof(detail::epoch_chunk));
+                    if (!memory)
+                        FOONATHAN_THROW(out_of_memory(info(), sizeof(detail::epoch_chunk)));
+                }
+                return init_chunk(memory);
+            }
+
+            static detail::epoch_chunk* init_chunk(void* memory) noexcept
+            {
+                auto chunk  = static_cast<detail::epoch_chunk*>(memory);
+                chunk->next = nullptr;
+                chunk->size = 0u;
+                return chunk;
+            }
+
+            // moves the current chunk into the bag of the current epoch
+            void seal(detail::epoch_record& record) noexcept
+            {
+                auto chunk = record.current;
+                if (!chunk || chunk->size == 0u)
+                    return;
+                // the nodes were unlinked before, so they must be tagged with an epoch at least as new
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                auto  epoch = epoch_.load(std::memory_order_relaxed);
+                auto& bag   = record.sealed[epoch % 3u];
+                if (bag.epoch != epoch)
+                {
+                    // it is at least three epochs old, so it is kept with the oldest bag
+                    FOONATHAN_MEMORY_ASSERT(!bag.first || bag.epoch + 2u <= epoch);
+                    record.sealed[(epoch + 1u) % 3u].splice(bag);
+                    bag.epoch = epoch;
+                }
+                chunk->next    = bag.first;
+                bag.first      = chunk;
+                record.current = nullptr;
+            }
+
+            // moves all chunks of bags at least two epochs old into result
+            void take_expired(detail::epoch_record& record, std::uint64_t epoch,
+                              detail::epoch_bag& result) noexcept
+            {
+                for (auto& bag : record.sealed)
+                    if (bag.epoch + 2u <= epoch)
+                        result.splice(bag);
+            }
+
+            void reclaim(detail::epoch_record& own) noexcept
+            {
+                auto epoch = epoch_.load(std::memory_order_acquire);
+
+                detail::epoch_bag expired;
+                take_expired(own, epoch, expired);
+
+                detail::epoch_chunk* chunks = nullptr;
+                {
+                    std::lock_guard<Mutex> lock(mutex_);
+                    for (auto record = records_.load(std::memory_order_relaxed); record;
+                         record      = record->next)
+                        if (!record->in_use)
+                            take_expired(*record, epoch, expired);
+                    deallocate(expired.first, chunks);
+                }
+
+                // keep a few chunks for reuse and free the rest
+                while (chunks)
+                {
+                    auto next = chunks->next;
+                    if (own.no_spare < 4u)
+                    {
+                        chunks->next = own.spare;
+                        own.spare    = chunks;
+                        ++own.no_spare;
+                    }
+                    else
+                        heap_dealloc(chunks, sizeof(detail::epoch_chunk));
+                    chunks = next;
+                }
+            }
+
+            // deallocates the nodes of the chunks and moves the chunks into the given list
+            void deallocate(detail::epoch_chunk* chunk, detail::epoch_chunk*& chunks) noexcept
+            {
+                while (chunk)
+                {
+                    for (auto i = 0u; i != chunk->size; ++i)
+                        pool_.deallocate_node(chunk->nodes[i]);
+
+                    auto next   = chunk->next;
+                    chunk->next = chunks;
+                    chunks      = chunk;
+                    chunk       = next;
+                }
+            }
+
+            pool                               pool_;
+            mutable Mutex                      mutex_;
+            std::atomic<std::uint64_t>         epoch_;
+            std::atomic<detail::epoch_record*> records_;
+        };
+
+        template <class BlockOrRawAllocator, class Mutex>
+        constexpr std::size_t epoch_reclaiming_pool<BlockOrRawAllocator, Mutex>::min_node_size;
+
+        template <class BlockOrRawAllocator, class Mutex>
+        constexpr std::size_t epoch_reclaiming_pool<BlockOrRawAllocator, Mutex>::collect_threshold;
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_EPOCH_RECLAIMING_POOL_HPP_INCLUDED
@@ -260,13 +260,28 @@ namespace foonathan
 
         namespace detail
         {
+            // the error paths are kept out of line,
+            // so the construction of the exceptions is not inlined into every allocation function
+            [[noreturn]] FOONATHAN_MEMORY_COLD void throw_out_of_memory(const allocator_info& info,
+                                                                        std::size_t amount);
+
+            [[noreturn]] FOONATHAN_MEMORY_COLD void throw_out_of_fixed_memory(
+                const allocator_info& info, std::size_t amount);
+
+            template <class Ex>
+            [[noreturn]] FOONATHAN_MEMORY_COLD void throw_bad_allocation_size(
+                const allocator_info& info, std::size_t passed, std::size_t supported)
+            {
+                FOONATHAN_THROW(Ex(info, passed, supported));
+            }
+
             template <class Ex, typename Func>
             void check_allocation_size(std::size_t passed, Func f, const allocator_info& info)
             {
 #if FOONATHAN_MEMORY_CHECK_ALLOCATION_SIZE
                 auto supported = f();
-                if (passed > supported)
-                    FOONATHAN_THROW(Ex(info, passed, supported));
+                if (FOONATHAN_MEMORY_UNLIKELY(passed > supported))
+                    throw_bad_allocation_size<Ex>(info, passed, supported);
 #else
                 (void)passed;
                 (void)f;
@@ -5,7 +5,7 @@
 #define FOONATHAN_MEMORY_FALLBACK_ALLOCATOR_HPP_INCLUDED
 
 /// \file
-//// Class template \ref foonathan::memory::fallback_allocator.
+/// Class templates \ref foonathan::memory::fallback_allocator and \ref foonathan::memory::adaptive_fallback_allocator.
 
 #include "detail/ebo_storage.hpp"
 #include "detail/utility.hpp"
@@ -205,6 +205,202 @@ namespace foonathan
             }
             /// @}
         };
+
+        /// The counters of an \ref adaptive_fallback_allocator as returned by its \c stats() function.
+        /// \ingroup adapter
+        struct fallback_stats
+        {
+            /// The number of allocations served by the default allocator.
+            std::size_t hits = 0u;
+
+            /// The number of allocations where the default allocator was tried and failed.
+            std::size_t misses = 0u;
+
+            /// The number of allocations that went straight to the fallback allocator.
+            std::size_t skips = 0u;
+
+            /// \returns The ratio of \ref hits to all allocations, or \c 0 if there were none.
+            double hit_ratio() const noexcept
+            {
+                auto total = hits + misses + skips;
+                return total == 0u ? 0. : double(hits) / double(total);
+            }
+        };
+
+        /// A \ref fallback_allocator that remembers when the default allocator is exhausted.
+        /// After an allocation of `Default` failed, the following ones of at least that size go straight to `Fallback`
+        /// instead of paying for another failed attempt each time, smaller ones still try `Default`.
+        /// `Default` is tried again after one of its nodes has been deallocated,
+        /// or after the given number of allocations were skipped, which catches other ways of freeing memory,
+        /// like unwinding a \ref memory_stack, and smaller nodes that still fit.
+        /// The \ref fallback_stats of the hits and misses help in tuning that interval and the size of `Default`.
+        /// \requires `Default` must be a composable \concept{concept_rawallocator,RawAllocator},
+        /// `Fallback` must be a \concept{concept_rawallocator,RawAllocator}.
+        /// \ingroup adapter
+        template <class Default, class Fallback>
+        class adaptive_fallback_allocator : fallback_allocator<Default, Fallback>
+        {
+            using base                      = fallback_allocator<Default, Fallback>;
+            using default_composable_traits = composable_allocator_traits<Default>;
+            using fallback_traits           = allocator_traits<Fallback>;
+
+        public:
+            using typename base::default_allocator_type;
+            using typename base::fallback_allocator_type;
+
+            using is_stateful = std::true_type;
+
+            /// \effects Constructs the allocator by passing in the two allocators it has
+            /// and the number of allocations that are skipped before `Default` is tried again,
+            /// \c 0 means it is only tried again after a deallocation.
+            explicit adaptive_fallback_allocator(default_allocator_type&&  default_alloc,
+                                                 fallback_allocator_type&& fallback_alloc = {},
+                                                 std::size_t               probe_interval = 64u)
+            : base(detail::move(default_alloc), detail::move(fallback_alloc)),
+              probe_interval_(probe_interval),
+              skipped_(0u),
+              failed_size_(no_failure())
+            {
+            }
+
+            /// @{
+            /// \effects Calls the compositioning allocation function on the `default_allocator_type`,
+            /// unless it is exhausted for that size, and uses the `fallback_allocator_type` if that fails.
+            void* allocate_node(std::size_t size, std::size_t alignment)
+            {
+                if (probe(size))
+                {
+                    auto ptr = default_composable_traits::try_allocate_node(get_default_allocator(),
+                                                                            size, alignment);
+                    if (record(ptr, size))
+                        return ptr;
+                }
+                return fallback_traits::allocate_node(get_fallback_allocator(), size, alignment);
+            }
+
+            void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+            {
+                if (probe(count * size))
+                {
+                    auto ptr =
+                        default_composable_traits::try_allocate_array(get_default_allocator(),
+                                                                      count, size, alignment);
+                    if (record(ptr, count * size))
+                        return ptr;
+                }
+                return fallback_traits::allocate_array(get_fallback_allocator(), count, size,
+                                                       alignment);
+            }
+            /// @}
+
+            /// @{
+            /// \effects Calls the compositioning deallocation function on the `default_allocator_type`,
+            /// so it is tried again on the next allocation if that succeeds,
+            /// and uses the `fallback_allocator_type` if that fails.
+            void deallocate_node(void* ptr, std::size_t size, std::size_t alignment) noexcept
+            {
+                if (default_composable_traits::try_deallocate_node(get_default_allocator(), ptr,
+                                                                   size, alignment))
+                    failed_size_ = no_failure();
+                else
+                    fallback_traits::deallocate_node(get_fallback_allocator(), ptr, size,
+                                                     alignment);
+            }
+
+            void deallocate_array(void* ptr, std::size_t count, std::size_t size,
+                                  std::size_t alignment) noexcept
+            {
+                if (default_composable_traits::try_deallocate_array(get_default_allocator(), ptr,
+                                                                    count, size, alignment))
+                    failed_size_ = no_failure();
+                else
+                    fallback_traits::deallocate_array(get_fallback_allocator(), ptr, count, size,
+                                                      alignment);
+            }
+            /// @}
+
+            using base::max_node_size;
+            using base::max_array_size;
+            using base::max_alignment;
+
+            using base::get_default_allocator;
+            using base::get_fallback_allocator;
+
+            /// \returns Whether or not an allocation from `Default` failed
+            /// and it has not been tried again.
+            bool is_exhausted() const noexcept
+            {
+                return failed_size_ != no_failure();
+            }
+
+            /// \returns The smallest size of a failed allocation from `Default`,
+            /// allocations of at least that size skip it,
+            /// or the maximum value of \c std::size_t if it is not exhausted.
+            std::size_t exhausted_size() const noexcept
+            {
+                return failed_size_;
+            }
+
+            /// \returns The number of allocations that are skipped before `Default` is tried again.
+            std::size_t probe_interval() const noexcept
+            {
+                return probe_interval_;
+            }
+
+            /// \returns The hits and misses since construction or the last \ref reset_stats().
+            const fallback_stats& stats() const noexcept
+            {
+                return stats_;
+            }
+
+            /// \effects Sets all counters of \ref stats() to zero.
+            void reset_stats() noexcept
+            {
+                stats_ = fallback_stats();
+            }
+
+        private:
+            static constexpr std::size_t no_failure() noexcept
+            {
+                return std::size_t(-1);
+            }
+
+            // whether or not Default is to be tried for that size
+            bool probe(std::size_t size) noexcept
+            {
+                if (size < failed_size_)
+                    return true;
+                if (probe_interval_ != 0u && ++skipped_ >= probe_interval_)
+                {
+                    skipped_ = 0u;
+                    return true;
+                }
+                ++stats_.skips;
+                return false;
+            }
+
+            bool record(void* ptr, std::size_t size) noexcept
+            {
+                if (ptr == nullptr)
+                {
+                    // only the smallest failed size is remembered, as all bigger ones fail as well
+                    if (size < failed_size_)
+                        failed_size_ = size;
+                    skipped_ = 0u;
+                    ++stats_.misses;
+                    return false;
+                }
+                // a successful probe means there is room again
+                if (size >= failed_size_)
+                    failed_size_ = no_failure();
+                ++stats_.hits;
+                return true;
+            }
+
+            fallback_stats stats_;
+            std::size_t    probe_interval_, skipped_;
+            std::size_t    failed_size_; // the smallest size Default failed to allocate
+        };
     } // namespace memory
 } // namespace foonathan
 
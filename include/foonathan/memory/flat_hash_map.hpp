@@ -0,0 +1,560 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_FLAT_HASH_MAP_HPP_INCLUDED
+#define FOONATHAN_MEMORY_FLAT_HASH_MAP_HPP_INCLUDED
+
+/// \file
+/// Class template \ref foonathan::memory::flat_hash_map.
+
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "detail/assert.hpp"
+#include "detail/utility.hpp"
+#include "allocator_storage.hpp"
+#include "config.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        namespace detail
+        {
+            template <typename Value, bool Const>
+            class flat_hash_iterator
+            {
+            public:
+                using value_type = Value;
+                using reference = typename std::conditional<Const, const Value&, Value&>::type;
+                using pointer   = typename std::conditional<Const, const Value*, Value*>::type;
+                using difference_type   = std::ptrdiff_t;
+                using iterator_category = std::forward_iterator_tag;
+
+                flat_hash_iterator() noexcept : ctrl_(nullptr), end_(nullptr), slot_(nullptr) {}
+
+                flat_hash_iterator(const unsigned char* ctrl, const unsigned char* end,
+                                   pointer slot) noexcept
+                : ctrl_(ctrl), end_(end), slot_(slot)
+                {
+                    skip_empty();
+                }
+
+                // conversion from non-const to const
+                template <bool C, typename = typename std::enable_if<Const && !C>::type>
+                flat_hash_iterator(const flat_hash_iterator<Value, C>& other) noexcept
+                : ctrl_(other.ctrl_), end_(other.end_), slot_(other.slot_)
+                {
+                }
+
+                reference operator*() const noexcept
+                {
+                    return *slot_;
+                }
+
+                pointer operator->() const noexcept
+                {
+                    return slot_;
+                }
+
+                flat_hash_iterator& operator++() noexcept
+                {
+                    ++ctrl_;
+                    ++slot_;
+                    skip_empty();
+                    return *this;
+                }
+
+                flat_hash_iterator operator++(int) noexcept
+                {
+                    auto tmp = *this;
+                    ++*this;
+                    return tmp;
+                }
+
+                friend bool operator==(const flat_hash_iterator& a,
+                                       const flat_hash_iterator& b) noexcept
+                {
+                    return a.slot_ == b.slot_;
+                }
+
+                friend bool operator!=(const flat_hash_iterator& a,
+                                       const flat_hash_iterator& b) noexcept
+                {
+                    return a.slot_ != b.slot_;
+                }
+
+            private:
+                void skip_empty() noexcept
+                {
+                    while (ctrl_ != end_ && *ctrl_ == 0u)
+                    {
+                        ++ctrl_;
+                        ++slot_;
+                    }
+                }
+
+                const unsigned char* ctrl_;
+                const unsigned char* end_;
+                pointer              slot_;
+
+                template <typename, bool>
+                friend class flat_hash_iterator;
+            };
+        } // namespace detail
+
+        /// An unordered map of unique keys and their values that uses open addressing,
+        /// i.e. the elements are stored directly in one contiguous array of slots instead of a node per element like \ref unordered_map.
+        /// A lookup hashes the key and probes the following slots linearly,
+        /// comparing a byte of the hash stored next to the slots before the key, until it reaches an empty slot,
+        /// so it usually touches only one or two cache lines.
+        /// The table has a power of two slots, and it is rehashed into twice the slots once it is more than seven eighths full.
+        /// Erasing shifts the following elements back instead of leaving tombstones, so lookups never slow down over time.
+        /// The slots and the hash bytes are one allocation of the \concept{concept_rawallocator,RawAllocator}.
+        /// \note Unlike \c std::unordered_map, the \c value_type is <tt>std::pair<Key, T></tt> without \c const,
+        /// as the elements are moved in the array, but the keys must not be modified through an iterator.
+        /// Insertions and erasures invalidate all iterators and references,
+        /// which is why \ref erase() does not return an iterator.
+        /// \requires \c Key and \c T must be nothrow move constructible,
+        /// and the hash function must not throw for keys that are already in the map, as they are rehashed when the table grows.
+        /// \ingroup adapter
+        template <typename Key, typename T, class RawAllocator, class Hash = std::hash<Key>,
+                  class KeyEqual = std::equal_to<Key>>
+        class flat_hash_map
+        : FOONATHAN_EBO(allocator_reference<RawAllocator>, Hash, KeyEqual)
+        {
+            using allocator_ref = allocator_reference<RawAllocator>;
+
+        public:
+            using key_type       = Key;
+            using mapped_type    = T;
+            using value_type     = std::pair<Key, T>;
+            using hasher         = Hash;
+            using key_equal      = KeyEqual;
+            using allocator_type = typename allocator_ref::allocator_type;
+            using iterator       = detail::flat_hash_iterator<value_type, false>;
+            using const_iterator = detail::flat_hash_iterator<value_type, true>;
+
+            static_assert(std::is_nothrow_move_constructible<value_type>::value,
+                          "the elements are moved on rehash and erase");
+
+            //=== constructors/destructor ===//
+            /// \effects Creates an empty map that will use the given allocator, hash function and key comparison.
+            /// It does not allocate any memory.
+            explicit flat_hash_map(allocator_ref alloc, const Hash& hash = Hash(),
+                                   const KeyEqual& equal = KeyEqual())
+            : allocator_ref(detail::move(alloc)),
+              Hash(hash),
+              KeyEqual(equal),
+              slots_(nullptr),
+              ctrl_(nullptr),
+              size_(0u),
+              capacity_(0u)
+            {
+            }
+
+            /// \effects Move constructs the map by taking over the memory of \c other,
+            /// which will be empty afterwards.
+            flat_hash_map(flat_hash_map&& other) noexcept
+            : allocator_ref(detail::move(static_cast<allocator_ref&>(other))),
+              Hash(detail::move(static_cast<Hash&>(other))),
+              KeyEqual(detail::move(static_cast<KeyEqual&>(other))),
+              slots_(other.slots_),
+              ctrl_(other.ctrl_),
+              size_(other.size_),
+              capacity_(other.capacity_)
+            {
+                other.slots_    = nullptr;
+                other.ctrl_     = nullptr;
+                other.size_     = 0u;
+                other.capacity_ = 0u;
+            }
+
+            /// \effects Destroys all elements and deallocates the memory.
+            ~flat_hash_map() noexcept
+            {
+                clear();
+                deallocate(slots_, capacity_);
+            }
+
+            /// \effects Move assigns the map by taking over the memory of \c other,
+            /// which will be empty afterwards.
+            flat_hash_map& operator=(flat_hash_map&& other) noexcept
+            {
+                flat_hash_map tmp(detail::move(other));
+                swap(*this, tmp);
+                return *this;
+            }
+
+            flat_hash_map(const flat_hash_map&)            = delete;
+            flat_hash_map& operator=(const flat_hash_map&) = delete;
+
+            /// \effects Swaps the elements, the allocators and the function objects of both maps.
+            friend void swap(flat_hash_map& a, flat_hash_map& b) noexcept
+            {
+                detail::adl_swap(static_cast<allocator_ref&>(a), static_cast<allocator_ref&>(b));
+                detail::adl_swap(static_cast<Hash&>(a), static_cast<Hash&>(b));
+                detail::adl_swap(static_cast<KeyEqual&>(a), static_cast<KeyEqual&>(b));
+                detail::adl_swap(a.slots_, b.slots_);
+                detail::adl_swap(a.ctrl_, b.ctrl_);
+                detail::adl_swap(a.size_, b.size_);
+                detail::adl_swap(a.capacity_, b.capacity_);
+            }
+
+            //=== modifiers ===//
+            /// @{
+            /// \effects Inserts the key and value unless the key is already in the map.
+            /// \returns An iterator to the element with the key and whether or not it was inserted.
+            /// \throws Anything thrown by the allocation, the hash function or the operations of \c Key and \c T.
+            /// If an exception is thrown, the map is unchanged.
+            std::pair<iterator, bool> insert(const value_type& value)
+            {
+                return emplace_key(value.first, value);
+            }
+
+            std::pair<iterator, bool> insert(value_type&& value)
+            {
+                return emplace_key(value.first, detail::move(value));
+            }
+            /// @}
+
+            /// \effects Creates an element by forwarding the arguments to the constructor of the \c value_type
+            /// and inserts it unless its key is already in the map.
+            /// \returns An iterator to the element with the key and whether or not it was inserted.
+            /// \throws Anything thrown by the allocation, the hash function or the operations of \c Key and \c T.
+            /// If an exception is thrown, the map is unchanged.
+            template <typename... Args>
+            std::pair<iterator, bool> emplace(Args&&... args)
+            {
+                return insert(value_type(detail::forward<Args>(args)...));
+            }
+
+            /// \effects Inserts the key with a value created by forwarding the arguments to its constructor,
+            /// unless the key is already in the map, then nothing is created.
+            /// \returns An iterator to the element with the key and whether or not it was inserted.
+            /// \throws Anything thrown by the allocation, the hash function or the operations of \c Key and \c T.
+            /// If an exception is thrown, the map is unchanged.
+            template <typename... Args>
+            std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+            {
+                return emplace_key(key, std::piecewise_construct, std::forward_as_tuple(key),
+                                   std::forward_as_tuple(detail::forward<Args>(args)...));
+            }
+
+            /// \returns A reference to the value of the key,
+            /// which is inserted with a value-initialized value if it is not in the map.
+            /// \throws Anything thrown by the allocation, the hash function or the operations of \c Key and \c T.
+            T& operator[](const Key& key)
+            {
+                return try_emplace(key).first->second;
+            }
+
+            /// \effects Erases the element with the key, if there is one.
+            /// \returns The number of erased elements, i.e. \c 0 or \c 1.
+            /// \throws Anything thrown by the hash function or the comparison of the key.
+            std::size_t erase(const Key& key)
+            {
+                auto index = find_index(key);
+                if (index == capacity_)
+                    return 0u;
+                erase_index(index);
+                return 1u;
+            }
+
+            /// \effects Erases the element.
+            /// \requires \c pos must be a valid, dereferenceable iterator of the map.
+            void erase(const_iterator pos)
+            {
+                auto index = static_cast<std::size_t>(pos.operator->() - slots_);
+                FOONATHAN_MEMORY_ASSERT(index < capacity_ && ctrl_[index] != 0u);
+                erase_index(index);
+            }
+
+            /// \effects Erases all elements.
+            /// The memory is not deallocated.
+            void clear() noexcept
+            {
+                if (size_ == 0u)
+                    return;
+                for (std::size_t i = 0u; i != capacity_; ++i)
+                    if (ctrl_[i] != 0u)
+                        slots_[i].~value_type();
+                std::memset(ctrl_, 0, capacity_);
+                size_ = 0u;
+            }
+
+            /// \effects Ensures that the map can hold at least \c count elements without rehashing.
+            /// \throws Anything thrown by the allocation or the hash function.
+            void reserve(std::size_t count)
+            {
+                auto new_capacity = capacity_ == 0u ? min_capacity : capacity_;
+                while (exceeds_load(count, new_capacity))
+                    new_capacity *= 2u;
+                if (new_capacity != capacity_)
+                    rehash(new_capacity);
+            }
+
+            //=== lookup ===//
+            /// @{
+            /// \returns An iterator to the element with the key or \ref end().
+            iterator find(const Key& key)
+            {
+                auto index = find_index(key);
+                return index == capacity_ ? end() : iterator_at(index);
+            }
+
+            const_iterator find(const Key& key) const
+            {
+                auto index = find_index(key);
+                return index == capacity_ ? end() : iterator_at(index);
+            }
+            /// @}
+
+            /// \returns Whether or not the key is in the map.
+            bool contains(const Key& key) const
+            {
+                return find_index(key) != capacity_;
+            }
+
+            /// \returns The number of elements with the key, i.e. \c 0 or \c 1.
+            std::size_t count(const Key& key) const
+            {
+                return contains(key) ? 1u : 0u;
+            }
+
+            //=== accessors ===//
+            /// @{
+            /// \returns An iterator to the first element.
+            iterator begin() noexcept
+            {
+                return iterator(ctrl_, ctrl_ + capacity_, slots_);
+            }
+
+            const_iterator begin() const noexcept
+            {
+                return const_iterator(ctrl_, ctrl_ + capacity_, slots_);
+            }
+            /// @}
+
+            /// @{
+            /// \returns An iterator one past the last element.
+            iterator end() noexcept
+            {
+                return iterator(ctrl_ + capacity_, ctrl_ + capacity_, slots_ + capacity_);
+            }
+
+            const_iterator end() const noexcept
+            {
+                return const_iterator(ctrl_ + capacity_, ctrl_ + capacity_, slots_ + capacity_);
+            }
+            /// @}
+
+            /// \returns The number of elements.
+            std::size_t size() const noexcept
+            {
+                return size_;
+            }
+
+            /// \returns Whether or not there are no elements.
+            bool empty() const noexcept
+            {
+                return size_ == 0u;
+            }
+
+            /// \returns The number of slots, the map can hold seven eighths of it without rehashing.
+            std::size_t capacity() const noexcept
+            {
+                return capacity_;
+            }
+
+            /// \returns The hash function.
+            const Hash& hash_function() const noexcept
+            {
+                return *this;
+            }
+
+            /// \returns The comparison of the keys.
+            const KeyEqual& key_eq() const noexcept
+            {
+                return *this;
+            }
+
+            /// @{
+            /// \returns A reference to the allocator.
+            auto get_allocator() noexcept
+                -> decltype(std::declval<allocator_ref>().get_allocator())
+            {
+                return allocator_ref::get_allocator();
+            }
+
+            auto get_allocator() const noexcept
+                -> decltype(std::declval<const allocator_ref>().get_allocator())
+            {
+                return allocator_ref::get_allocator();
+            }
+            /// @}
+
+        private:
+            static constexpr std::size_t min_capacity = 8u;
+
+            static bool exceeds_load(std::size_t count, std::size_t capacity) noexcept
+            {
+                return count > capacity - capacity / 8u;
+            }
+
+            //=== hashing ===//
+            std::size_t hash(const Key& key) const
+            {
+                // spread the bits, std::hash is often the identity
+                auto h = static_cast<std::size_t>(hash_function()(key));
+                h *= static_cast<std::size_t>(0x9E3779B97F4A7C15ull);
+                return h ^ (h >> (sizeof(std::size_t) * 4u));
+            }
+
+            // the slot the key is placed in, if it is not taken
+            std::size_t home(std::size_t h) const noexcept
+            {
+                return h & (capacity_ - 1u);
+            }
+
+            // the byte stored for a full slot, always non-zero
+            static unsigned char tag(std::size_t h) noexcept
+            {
+                return static_cast<unsigned char>(0x80u | (h >> (sizeof(std::size_t) * 8u - 7u)));
+            }
+
+            //=== slots ===//
+            // returns capacity_ if it is not found
+            std::size_t find_index(const Key& key) const
+            {
+                if (size_ == 0u)
+                    return capacity_;
+
+                auto h = hash(key);
+                auto t = tag(h);
+                for (auto i = home(h);; i = (i + 1u) & (capacity_ - 1u))
+                {
+                    if (ctrl_[i] == 0u)
+                        return capacity_;
+                    else if (ctrl_[i] == t && key_eq()(slots_[i].first, key))
+                        return i;
+                }
+            }
+
+            // returns the first empty slot starting at the home of the hash
+            std::size_t free_index(std::size_t h) const noexcept
+            {
+                auto i = home(h);
+                while (ctrl_[i] != 0u)
+                    i = (i + 1u) & (capacity_ - 1u);
+                return i;
+            }
+
+            template <typename... Args>
+            std::pair<iterator, bool> emplace_key(const Key& key, Args&&... args)
+            {
+                auto index = find_index(key);
+                if (index != capacity_)
+                    return {iterator_at(index), false};
+
+                // the key might be moved from by the construction, so hash it first
+                auto h = hash(key);
+                if (capacity_ == 0u || exceeds_load(size_ + 1u, capacity_))
+                    rehash(capacity_ == 0u ? min_capacity : 2u * capacity_);
+
+                index = free_index(h);
+                ::new (static_cast<void*>(slots_ + index))
+                    value_type(detail::forward<Args>(args)...);
+                ctrl_[index] = tag(h);
+                ++size_;
+                return {iterator_at(index), true};
+            }
+
+            void erase_index(std::size_t hole)
+            {
+                slots_[hole].~value_type();
+                ctrl_[hole] = 0u;
+                --size_;
+
+                // shift back the following elements whose probe sequence passes the hole
+                auto mask = capacity_ - 1u;
+                for (auto i = (hole + 1u) & mask; ctrl_[i] != 0u; i = (i + 1u) & mask)
+                {
+                    auto h = home(hash(slots_[i].first));
+                    if (((i - h) & mask) < ((i - hole) & mask))
+                        continue;
+
+                    ::new (static_cast<void*>(slots_ + hole)) value_type(detail::move(slots_[i]));
+                    slots_[i].~value_type();
+                    ctrl_[hole] = ctrl_[i];
+                    ctrl_[i]    = 0u;
+                    hole        = i;
+                }
+            }
+
+            void rehash(std::size_t new_capacity)
+            {
+                FOONATHAN_MEMORY_ASSERT(new_capacity != 0u
+                                        && (new_capacity & (new_capacity - 1u)) == 0u);
+                auto new_slots = static_cast<value_type*>(
+                    allocator_ref::allocate_node(allocation_size(new_capacity),
+                                                 alignof(value_type)));
+                auto new_ctrl = reinterpret_cast<unsigned char*>(new_slots + new_capacity);
+                std::memset(new_ctrl, 0, new_capacity);
+
+                auto old_slots = slots_, old_capacity = capacity_;
+                auto old_ctrl = ctrl_;
+                slots_    = new_slots;
+                ctrl_     = new_ctrl;
+                capacity_ = new_capacity;
+                for (std::size_t i = 0u; i != old_capacity; ++i)
+                    if (old_ctrl[i] != 0u)
+                    {
+                        auto h     = hash(old_slots[i].first);
+                        auto index = free_index(h);
+                        ::new (static_cast<void*>(slots_ + index))
+                            value_type(detail::move(old_slots[i]));
+                        old_slots[i].~value_type();
+                        ctrl_[index] = old_ctrl[i];
+                    }
+                deallocate(old_slots, old_capacity);
+            }
+
+            iterator iterator_at(std::size_t index) noexcept
+            {
+                return iterator(ctrl_ + index, ctrl_ + capacity_, slots_ + index);
+            }
+
+            const_iterator iterator_at(std::size_t index) const noexcept
+            {
+                return const_iterator(ctrl_ + index, ctrl_ + capacity_, slots_ + index);
+            }
+
+            static std::size_t allocation_size(std::size_t capacity) noexcept
+            {
+                return capacity * sizeof(value_type) + capacity;
+            }
+
+            void deallocate(value_type* slots, std::size_t capacity) noexcept
+            {
+                if (slots)
+                    allocator_ref::deallocate_node(slots, allocation_size(capacity),
+                                                   alignof(value_type));
+            }
+
+            value_type*    slots_;
+            unsigned char* ctrl_;
+            std::size_t    size_, capacity_;
+        };
+
+        template <typename Key, typename T, class RawAllocator, class Hash, class KeyEqual>
+        constexpr std::size_t flat_hash_map<Key, T, RawAllocator, Hash, KeyEqual>::min_capacity;
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_FLAT_HASH_MAP_HPP_INCLUDED
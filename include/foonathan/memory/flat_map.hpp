@@ -0,0 +1,462 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_FLAT_MAP_HPP_INCLUDED
+#define FOONATHAN_MEMORY_FLAT_MAP_HPP_INCLUDED
+
+/// \file
+/// Class templates \ref foonathan::memory::flat_set and \ref foonathan::memory::flat_map.
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "detail/utility.hpp"
+#include "config.hpp"
+#include "vector_buffer.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// A set of unique elements that are stored sorted in one contiguous array,
+        /// similar to \c boost::container::flat_set.
+        /// Lookups are binary searches over contiguous memory, so they need far fewer cache lines than the node based \ref set,
+        /// but insertions and erasures in the middle move the following elements.
+        /// The array is a \ref vector_buffer, so it is allocated through the \concept{concept_rawallocator,RawAllocator}
+        /// and grows in place if the allocator supports it, like \ref memory_stack.
+        /// \note Insertions and erasures invalidate all iterators and references.
+        /// Their exception safety is only basic if the move operations of \c T throw.
+        /// \ingroup adapter
+        template <typename T, class RawAllocator, class Compare = std::less<T>>
+        class flat_set : FOONATHAN_EBO(Compare)
+        {
+            using buffer_type = vector_buffer<T, RawAllocator>;
+
+        public:
+            using value_type     = T;
+            using key_type       = T;
+            using key_compare    = Compare;
+            using allocator_type = typename buffer_type::allocator_type;
+            // elements must not be modified, it would break the order
+            using iterator       = const T*;
+            using const_iterator = const T*;
+
+            /// \effects Creates an empty set that will use the given allocator and comparison.
+            /// It does not allocate any memory.
+            explicit flat_set(allocator_reference<RawAllocator> alloc,
+                              const Compare&                    comp = Compare())
+            : Compare(comp), buffer_(detail::move(alloc))
+            {
+            }
+
+            //=== modifiers ===//
+            /// @{
+            /// \effects Inserts the element unless an equivalent one is already in the set.
+            /// \returns An iterator to the element with the key and whether or not it was inserted.
+            /// \throws Anything thrown by the allocation or the operations of \c T.
+            std::pair<iterator, bool> insert(const T& value)
+            {
+                return insert_impl(value);
+            }
+
+            std::pair<iterator, bool> insert(T&& value)
+            {
+                return insert_impl(detail::move(value));
+            }
+            /// @}
+
+            /// \effects Creates an element by forwarding the arguments to its constructor
+            /// and inserts it unless an equivalent one is already in the set.
+            /// \returns An iterator to the element with the key and whether or not it was inserted.
+            /// \throws Anything thrown by the allocation or the operations of \c T.
+            template <typename... Args>
+            std::pair<iterator, bool> emplace(Args&&... args)
+            {
+                return insert_impl(T(detail::forward<Args>(args)...));
+            }
+
+            /// \effects Erases the element.
+            /// \returns An iterator to the following element.
+            /// \requires \c pos must be a valid iterator of the set.
+            iterator erase(const_iterator pos)
+            {
+                return buffer_.erase(pos);
+            }
+
+            /// \effects Erases the element equivalent to the key, if there is one.
+            /// \returns The number of erased elements, i.e. \c 0 or \c 1.
+            std::size_t erase(const T& key)
+            {
+                auto iter = find(key);
+                if (iter == end())
+                    return 0u;
+                buffer_.erase(iter);
+                return 1u;
+            }
+
+            /// \effects Erases all elements.
+            /// The memory is not deallocated.
+            void clear() noexcept
+            {
+                buffer_.clear();
+            }
+
+            /// \effects Ensures that the set can hold at least \c new_capacity elements without growing.
+            /// \throws Anything thrown by the allocation or the move constructor of \c T.
+            void reserve(std::size_t new_capacity)
+            {
+                buffer_.reserve(new_capacity);
+            }
+
+            //=== lookup ===//
+            /// \returns An iterator to the element equivalent to the key or \ref end().
+            iterator find(const T& key) const
+            {
+                auto iter = lower_bound(key);
+                return iter != end() && !key_comp()(key, *iter) ? iter : end();
+            }
+
+            /// \returns Whether or not an element equivalent to the key is in the set.
+            bool contains(const T& key) const
+            {
+                return find(key) != end();
+            }
+
+            /// \returns The number of elements equivalent to the key, i.e. \c 0 or \c 1.
+            std::size_t count(const T& key) const
+            {
+                return contains(key) ? 1u : 0u;
+            }
+
+            /// \returns An iterator to the first element that is not less than the key.
+            iterator lower_bound(const T& key) const
+            {
+                return std::lower_bound(begin(), end(), key, key_comp());
+            }
+
+            /// \returns An iterator to the first element that is greater than the key.
+            iterator upper_bound(const T& key) const
+            {
+                return std::upper_bound(begin(), end(), key, key_comp());
+            }
+
+            //=== accessors ===//
+            /// \returns An iterator to the first element.
+            iterator begin() const noexcept
+            {
+                return buffer_.begin();
+            }
+
+            /// \returns An iterator one past the last element.
+            iterator end() const noexcept
+            {
+                return buffer_.end();
+            }
+
+            /// \returns The number of elements.
+            std::size_t size() const noexcept
+            {
+                return buffer_.size();
+            }
+
+            /// \returns Whether or not there are no elements.
+            bool empty() const noexcept
+            {
+                return buffer_.empty();
+            }
+
+            /// \returns The number of elements that fit into the array without growing it.
+            std::size_t capacity() const noexcept
+            {
+                return buffer_.capacity();
+            }
+
+            /// \returns The comparison object.
+            const Compare& key_comp() const noexcept
+            {
+                return *this;
+            }
+
+            /// @{
+            /// \returns A reference to the allocator.
+            auto get_allocator() noexcept -> decltype(std::declval<buffer_type&>().get_allocator())
+            {
+                return buffer_.get_allocator();
+            }
+
+            auto get_allocator() const noexcept
+                -> decltype(std::declval<const buffer_type&>().get_allocator())
+            {
+                return buffer_.get_allocator();
+            }
+            /// @}
+
+        private:
+            template <typename U>
+            std::pair<iterator, bool> insert_impl(U&& value)
+            {
+                auto iter = lower_bound(value);
+                if (iter != end() && !key_comp()(value, *iter))
+                    return {iter, false};
+                return {buffer_.emplace(iter, detail::forward<U>(value)), true};
+            }
+
+            buffer_type buffer_;
+        };
+
+        /// A map of unique keys and their values that are stored sorted by key in one contiguous array,
+        /// similar to \c boost::container::flat_map.
+        /// Lookups are binary searches over contiguous memory, so they need far fewer cache lines than the node based \ref map,
+        /// but insertions and erasures in the middle move the following elements.
+        /// The array is a \ref vector_buffer, so it is allocated through the \concept{concept_rawallocator,RawAllocator}
+        /// and grows in place if the allocator supports it, like \ref memory_stack.
+        /// \note Unlike \c std::map, the \c value_type is <tt>std::pair<Key, T></tt> without \c const,
+        /// as the elements are moved in the array, but the keys must not be modified through an iterator.
+        /// \note Insertions and erasures invalidate all iterators and references.
+        /// Their exception safety is only basic if the move operations of \c Key or \c T throw.
+        /// \ingroup adapter
+        template <typename Key, typename T, class RawAllocator, class Compare = std::less<Key>>
+        class flat_map : FOONATHAN_EBO(Compare)
+        {
+            using buffer_type = vector_buffer<std::pair<Key, T>, RawAllocator>;
+
+        public:
+            using key_type       = Key;
+            using mapped_type    = T;
+            using value_type     = std::pair<Key, T>;
+            using key_compare    = Compare;
+            using allocator_type = typename buffer_type::allocator_type;
+            using iterator       = value_type*;
+            using const_iterator = const value_type*;
+
+            /// \effects Creates an empty map that will use the given allocator and comparison.
+            /// It does not allocate any memory.
+            explicit flat_map(allocator_reference<RawAllocator> alloc,
+                              const Compare&                    comp = Compare())
+            : Compare(comp), buffer_(detail::move(alloc))
+            {
+            }
+
+            //=== modifiers ===//
+            /// @{
+            /// \effects Inserts the key and value unless the key is already in the map.
+            /// \returns An iterator to the element with the key and whether or not it was inserted.
+            /// \throws Anything thrown by the allocation or the operations of \c Key and \c T.
+            std::pair<iterator, bool> insert(const value_type& value)
+            {
+                auto iter = lower_bound(value.first);
+                if (iter != end() && !key_comp()(value.first, iter->first))
+                    return {iter, false};
+                return {buffer_.emplace(iter, value), true};
+            }
+
+            std::pair<iterator, bool> insert(value_type&& value)
+            {
+                auto iter = lower_bound(value.first);
+                if (iter != end() && !key_comp()(value.first, iter->first))
+                    return {iter, false};
+                return {buffer_.emplace(iter, detail::move(value)), true};
+            }
+            /// @}
+
+            /// \effects Creates an element by forwarding the arguments to the constructor of the \c value_type
+            /// and inserts it unless its key is already in the map.
+            /// \returns An iterator to the element with the key and whether or not it was inserted.
+            /// \throws Anything thrown by the allocation or the operations of \c Key and \c T.
+            template <typename... Args>
+            std::pair<iterator, bool> emplace(Args&&... args)
+            {
+                return insert(value_type(detail::forward<Args>(args)...));
+            }
+
+            /// \effects Inserts the key with a value created by forwarding the arguments to its constructor,
+            /// unless the key is already in the map, then nothing is created.
+            /// \returns An iterator to the element with the key and whether or not it was inserted.
+            /// \throws Anything thrown by the allocation or the operations of \c Key and \c T.
+            template <typename... Args>
+            std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+            {
+                auto iter = lower_bound(key);
+                if (iter != end() && !key_comp()(key, iter->first))
+                    return {iter, false};
+                return {buffer_.emplace(iter, std::piecewise_construct, std::forward_as_tuple(key),
+                                        std::forward_as_tuple(detail::forward<Args>(args)...)),
+                        true};
+            }
+
+            /// \returns A reference to the value of the key,
+            /// which is inserted with a value-initialized value if it is not in the map.
+            /// \throws Anything thrown by the allocation or the operations of \c Key and \c T.
+            T& operator[](const Key& key)
+            {
+                return try_emplace(key).first->second;
+            }
+
+            /// \effects Erases the element.
+            /// \returns An iterator to the following element.
+            /// \requires \c pos must be a valid iterator of the map.
+            iterator erase(const_iterator pos)
+            {
+                return buffer_.erase(pos);
+            }
+
+            /// \effects Erases the element with the key, if there is one.
+            /// \returns The number of erased elements, i.e. \c 0 or \c 1.
+            std::size_t erase(const Key& key)
+            {
+                auto iter = find(key);
+                if (iter == end())
+                    return 0u;
+                buffer_.erase(iter);
+                return 1u;
+            }
+
+            /// \effects Erases all elements.
+            /// The memory is not deallocated.
+            void clear() noexcept
+            {
+                buffer_.clear();
+            }
+
+            /// \effects Ensures that the map can hold at least \c new_capacity elements without growing.
+            /// \throws Anything thrown by the allocation or the move constructors of \c Key and \c T.
+            void reserve(std::size_t new_capacity)
+            {
+                buffer_.reserve(new_capacity);
+            }
+
+            //=== lookup ===//
+            /// @{
+            /// \returns An iterator to the element with the key or \ref end().
+            iterator find(const Key& key)
+            {
+                auto iter = lower_bound(key);
+                return iter != end() && !key_comp()(key, iter->first) ? iter : end();
+            }
+
+            const_iterator find(const Key& key) const
+            {
+                auto iter = lower_bound(key);
+                return iter != end() && !key_comp()(key, iter->first) ? iter : end();
+            }
+            /// @}
+
+            /// \returns Whether or not the key is in the map.
+            bool contains(const Key& key) const
+            {
+                return find(key) != end();
+            }
+
+            /// \returns The number of elements with the key, i.e. \c 0 or \c 1.
+            std::size_t count(const Key& key) const
+            {
+                return contains(key) ? 1u : 0u;
+            }
+
+            /// @{
+            /// \returns An iterator to the first element whose key is not less than the key.
+            iterator lower_bound(const Key& key)
+            {
+                const auto& self = *this;
+                return begin() + (self.lower_bound(key) - self.begin());
+            }
+
+            const_iterator lower_bound(const Key& key) const
+            {
+                auto& comp = key_comp();
+                return std::lower_bound(begin(), end(), key,
+                                        [&](const value_type& value, const Key& k)
+                                        { return comp(value.first, k); });
+            }
+            /// @}
+
+            /// @{
+            /// \returns An iterator to the first element whose key is greater than the key.
+            iterator upper_bound(const Key& key)
+            {
+                const auto& self = *this;
+                return begin() + (self.upper_bound(key) - self.begin());
+            }
+
+            const_iterator upper_bound(const Key& key) const
+            {
+                auto& comp = key_comp();
+                return std::upper_bound(begin(), end(), key,
+                                        [&](const Key& k, const value_type& value)
+                                        { return comp(k, value.first); });
+            }
+            /// @}
+
+            //=== accessors ===//
+            /// @{
+            /// \returns An iterator to the first element.
+            iterator begin() noexcept
+            {
+                return buffer_.begin();
+            }
+
+            const_iterator begin() const noexcept
+            {
+                return buffer_.begin();
+            }
+            /// @}
+
+            /// @{
+            /// \returns An iterator one past the last element.
+            iterator end() noexcept
+            {
+                return buffer_.end();
+            }
+
+            const_iterator end() const noexcept
+            {
+                return buffer_.end();
+            }
+            /// @}
+
+            /// \returns The number of elements.
+            std::size_t size() const noexcept
+            {
+                return buffer_.size();
+            }
+
+            /// \returns Whether or not there are no elements.
+            bool empty() const noexcept
+            {
+                return buffer_.empty();
+            }
+
+            /// \returns The number of elements that fit into the array without growing it.
+            std::size_t capacity() const noexcept
+            {
+                return buffer_.capacity();
+            }
+
+            /// \returns The comparison object of the keys.
+            const Compare& key_comp() const noexcept
+            {
+                return *this;
+            }
+
+            /// @{
+            /// \returns A reference to the allocator.
+            auto get_allocator() noexcept -> decltype(std::declval<buffer_type&>().get_allocator())
+            {
+                return buffer_.get_allocator();
+            }
+
+            auto get_allocator() const noexcept
+                -> decltype(std::declval<const buffer_type&>().get_allocator())
+            {
+                return buffer_.get_allocator();
+            }
+            /// @}
+
+        private:
+            buffer_type buffer_;
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_FLAT_MAP_HPP_INCLUDED
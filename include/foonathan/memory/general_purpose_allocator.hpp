@@ -0,0 +1,196 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_GENERAL_PURPOSE_ALLOCATOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_GENERAL_PURPOSE_ALLOCATOR_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::general_purpose_allocator.
+
+#include <type_traits>
+
+#include "detail/align.hpp"
+#include "config.hpp"
+#include "default_allocator.hpp"
+#include "error.hpp"
+#include "memory_pool_collection.hpp"
+#include "segregator.hpp"
+#include "virtual_memory.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// A stateful \concept{concept_rawallocator,RawAllocator} for allocations of any size,
+        /// assembled from a \ref segregator of three allocators:
+        /// * sizes up to \ref small_max_size use a \ref memory_pool_collection with \ref identity_buckets,
+        /// * sizes up to \ref medium_max_size use a \ref slab_pool_collection with \ref geometric_buckets,
+        /// so each size class takes its runs of nodes from whole slabs of constant size,
+        /// * bigger sizes are mapped directly by the \ref virtual_memory_allocator and returned page by page.
+        ///
+        /// Arrays are allocated like a node of their total size.
+        /// An alignment bigger than the size is handled by rounding the size up,
+        /// an alignment bigger than \c alignof(std::max_align_t) is only supported by the \ref virtual_memory_allocator.
+        /// \note Like the pools it is made of, it is not thread-safe.
+        /// \ingroup allocator
+        template <class RawAllocator = default_allocator>
+        class general_purpose_allocator
+        {
+        public:
+            using small_allocator = memory_pool_collection<node_pool, identity_buckets,
+                                                           growing_block_allocator<RawAllocator>>;
+            // the slabs must not grow, every size class takes at least one
+            using medium_allocator =
+                slab_pool_collection<node_pool, geometric_buckets,
+                                     growing_block_allocator<RawAllocator, 1, 1>>;
+            using large_allocator  = virtual_memory_allocator;
+
+            using is_stateful = std::true_type;
+
+            /// The maximum size of an allocation served by the \ref small_allocator.
+            static constexpr std::size_t small_max_size = 256u;
+            /// The maximum size of an allocation served by the \ref medium_allocator.
+            static constexpr std::size_t medium_max_size = 16u * 1024u;
+
+            /// \effects Creates it with the size of the blocks of the \ref small_allocator
+            /// and of the slabs of the \ref medium_allocator,
+            /// the first block of the \ref small_allocator is allocated immediately.
+            /// \requires \c block_size must be big enough for all the free lists of the \ref small_allocator
+            /// and \c slab_size for a medium allocation of \ref medium_max_size.
+            explicit general_purpose_allocator(std::size_t block_size = 64u * 1024u,
+                                               std::size_t slab_size  = 256u * 1024u)
+            : segregator_(
+                make_segregator(threshold(small_max_size,
+                                          small_allocator(small_max_size, block_size)),
+                                threshold(medium_max_size,
+                                          medium_allocator(medium_max_size, slab_size)),
+                                large_allocator()))
+            {
+            }
+
+            /// @{
+            /// \effects Allocates memory from the allocator responsible for the size.
+            /// \returns The memory.
+            /// \throws Anything thrown by the allocators or \ref bad_alignment
+            /// if the alignment is bigger than the page size.
+            void* allocate_node(std::size_t size, std::size_t alignment)
+            {
+                check_alignment(alignment);
+                return traits::allocate_node(segregator_, adjust(size, alignment), alignment);
+            }
+
+            void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+            {
+                return allocate_node(count * size, alignment);
+            }
+            /// @}
+
+            /// @{
+            /// \effects Deallocates memory, the \ref large_allocator returns the pages immediately.
+            /// \requires The memory must have been allocated with the same size and alignment.
+            void deallocate_node(void* ptr, std::size_t size, std::size_t alignment) noexcept
+            {
+                traits::deallocate_node(segregator_, ptr, adjust(size, alignment), alignment);
+            }
+
+            void deallocate_array(void* ptr, std::size_t count, std::size_t size,
+                                  std::size_t alignment) noexcept
+            {
+                deallocate_node(ptr, count * size, alignment);
+            }
+            /// @}
+
+            /// @{
+            /// \returns The maximum values of the \ref large_allocator.
+            std::size_t max_node_size() const
+            {
+                return allocator_traits<large_allocator>::max_node_size(get_large_allocator());
+            }
+
+            std::size_t max_array_size() const
+            {
+                return max_node_size();
+            }
+
+            std::size_t max_alignment() const
+            {
+                return allocator_traits<large_allocator>::max_alignment(get_large_allocator());
+            }
+            /// @}
+
+            /// @{
+            /// \returns A reference to the allocator it uses for the respective sizes.
+            small_allocator& get_small_allocator() noexcept
+            {
+                return get_segregatable_allocator<0>(segregator_);
+            }
+
+            const small_allocator& get_small_allocator() const noexcept
+            {
+                return get_segregatable_allocator<0>(segregator_);
+            }
+
+            medium_allocator& get_medium_allocator() noexcept
+            {
+                return get_segregatable_allocator<1>(segregator_);
+            }
+
+            const medium_allocator& get_medium_allocator() const noexcept
+            {
+                return get_segregatable_allocator<1>(segregator_);
+            }
+
+            large_allocator& get_large_allocator() noexcept
+            {
+                return get_fallback_allocator(segregator_);
+            }
+
+            const large_allocator& get_large_allocator() const noexcept
+            {
+                return get_fallback_allocator(segregator_);
+            }
+            /// @}
+
+        private:
+            using segregator_type =
+                segregator<threshold_segregatable<small_allocator>,
+                           threshold_segregatable<medium_allocator>, large_allocator>;
+            using traits = allocator_traits<segregator_type>;
+
+            allocator_info info() const noexcept
+            {
+                return {FOONATHAN_MEMORY_LOG_PREFIX "::general_purpose_allocator", this};
+            }
+
+            void check_alignment(std::size_t alignment) const
+            {
+                detail::check_allocation_size<bad_alignment>(
+                    alignment, [&] { return max_alignment(); }, info());
+            }
+
+            // the pools align nodes according to their size,
+            // so a multiple of the alignment keeps all nodes of a pool aligned
+            static std::size_t adjust(std::size_t size, std::size_t alignment) noexcept
+            {
+                if (alignment > detail::max_alignment)
+                    // only the virtual memory allocator aligns on page boundaries
+                    return size > medium_max_size ? size : medium_max_size + 1u;
+                return size < alignment ? alignment : (size + alignment - 1u) & ~(alignment - 1u);
+            }
+
+            segregator_type segregator_;
+        };
+
+        template <class RawAllocator>
+        constexpr std::size_t general_purpose_allocator<RawAllocator>::small_max_size;
+
+        template <class RawAllocator>
+        constexpr std::size_t general_purpose_allocator<RawAllocator>::medium_max_size;
+
+#if FOONATHAN_MEMORY_EXTERN_TEMPLATE
+        extern template class general_purpose_allocator<>;
+#endif
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_GENERAL_PURPOSE_ALLOCATOR_HPP_INCLUDED
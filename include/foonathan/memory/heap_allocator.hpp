@@ -27,7 +27,8 @@ namespace foonathan
         /// The size parameter will not be zero.
         /// It shall return a \c nullptr if no memory is available.
         /// It must be thread safe.
-        /// \defaultbe On a hosted implementation this function uses OS specific facilities, \c std::malloc is used as fallback.
+        /// \defaultbe On a hosted implementation this function uses the allocator selected by \ref FOONATHAN_MEMORY_HEAP_BACKEND,
+        /// or OS specific facilities if it is \c 0, \c std::malloc is used as fallback.
         /// \ingroup allocator
         void* heap_alloc(std::size_t size) noexcept;
 
@@ -38,7 +39,8 @@ namespace foonathan
         /// It shall free the memory.
         /// The pointer will not be zero.
         /// It must be thread safe.
-        /// \defaultbe On a hosted implementation this function uses OS specific facilities, \c std::free is used as fallback.
+        /// \defaultbe On a hosted implementation this function uses the sized deallocation function of the allocator selected by \ref FOONATHAN_MEMORY_HEAP_BACKEND,
+        /// or OS specific facilities if it is \c 0, \c std::free is used as fallback.
         /// \ingroup allocator
         void heap_dealloc(void* ptr, std::size_t size) noexcept;
 
@@ -59,6 +61,11 @@ namespace foonathan
                 }
 
                 static std::size_t max_node_size() noexcept;
+
+                static std::size_t max_alignment() noexcept
+                {
+                    return detail::max_alignment;
+                }
             };
 
             FOONATHAN_MEMORY_LL_ALLOCATOR_LEAK_CHECKER(heap_allocator_impl,
@@ -0,0 +1,262 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_IO_BUFFER_POOL_HPP_INCLUDED
+#define FOONATHAN_MEMORY_IO_BUFFER_POOL_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::io_buffer_pool.
+
+#include <type_traits>
+
+#include "detail/assert.hpp"
+#include "detail/free_list.hpp"
+#include "detail/utility.hpp"
+#include "config.hpp"
+#include "error.hpp"
+#include "memory_arena.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// A stateful \concept{concept_rawallocator,RawAllocator} that hands out fixed-size buffers for direct I/O,
+        /// e.g. with \c O_DIRECT or registered \c io_uring buffers.
+        /// All buffers live in one region of virtual memory that is committed up front and never moves,
+        /// it can thus be registered once, see \ref region().
+        /// Each buffer is aligned to the given alignment, usually the logical block size of the device,
+        /// and its size is a multiple of it, so there is no per-buffer alignment waste.
+        /// Like an \ref array_pool, the free buffers are kept ordered,
+        /// so multiple buffers can be allocated as one contiguous array for vectored or bigger requests.
+        /// Requests for the \concept{concept_rawallocator,RawAllocator} interface are rounded up to whole buffers.
+        /// \note It is not thread-safe.
+        /// \ingroup allocator
+        class io_buffer_pool
+        {
+        public:
+            using is_stateful = std::true_type;
+
+            /// \effects Creates it with \c no_buffers buffers of the given size and alignment,
+            /// the size is rounded up to a multiple of the alignment.
+            /// The region for all buffers is reserved and committed immediately.
+            /// \requires \c buffer_size and \c no_buffers must be non-zero,
+            /// \c alignment must be a power of two.
+            /// \throws \ref out_of_memory if the region cannot be reserved or committed.
+            io_buffer_pool(std::size_t buffer_size, std::size_t no_buffers,
+                           std::size_t alignment = 4096u);
+
+            /// \effects Releases the region.
+            /// \requires All buffers must have been deallocated, if they are still referenced by a device.
+            ~io_buffer_pool() noexcept;
+
+            /// @{
+            /// \effects Moves the pool, the region and the buffers do not move.
+            io_buffer_pool(io_buffer_pool&& other) noexcept
+            : list_(detail::move(other.list_)),
+              reserved_(other.reserved_),
+              reserved_size_(other.reserved_size_),
+              region_(other.region_),
+              alignment_(other.alignment_)
+            {
+                other.reserved_ = nullptr;
+                other.region_   = memory_block();
+            }
+
+            io_buffer_pool& operator=(io_buffer_pool&& other) noexcept
+            {
+                io_buffer_pool tmp(detail::move(other));
+                swap(*this, tmp);
+                return *this;
+            }
+            /// @}
+
+            /// \effects Swaps the regions and buffers of both pools.
+            friend void swap(io_buffer_pool& a, io_buffer_pool& b) noexcept
+            {
+                detail::adl_swap(a.list_, b.list_);
+                detail::adl_swap(a.reserved_, b.reserved_);
+                detail::adl_swap(a.reserved_size_, b.reserved_size_);
+                detail::adl_swap(a.region_, b.region_);
+                detail::adl_swap(a.alignment_, b.alignment_);
+            }
+
+            /// \effects Allocates a single buffer.
+            /// \returns The buffer.
+            /// \throws \ref out_of_fixed_memory if all buffers are in use.
+            void* allocate_buffer()
+            {
+                auto buffer = try_allocate_buffer();
+                if (!buffer)
+                    FOONATHAN_THROW(out_of_fixed_memory(info(), buffer_size()));
+                return buffer;
+            }
+
+            /// \effects Allocates a single buffer.
+            /// \returns The buffer or \c nullptr if all buffers are in use.
+            void* try_allocate_buffer() noexcept
+            {
+                return list_.empty() ? nullptr : list_.allocate();
+            }
+
+            /// \effects Allocates \c n adjacent buffers.
+            /// \returns The first buffer.
+            /// \throws \ref out_of_fixed_memory if there are not \c n adjacent free buffers.
+            void* allocate_buffers(std::size_t n)
+            {
+                auto buffers = try_allocate_buffers(n);
+                if (!buffers)
+                    FOONATHAN_THROW(out_of_fixed_memory(info(), n * buffer_size()));
+                return buffers;
+            }
+
+            /// \effects Allocates \c n adjacent buffers.
+            /// \returns The first buffer or \c nullptr if there are not \c n adjacent free buffers.
+            void* try_allocate_buffers(std::size_t n) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(n != 0u);
+                if (n > list_.capacity())
+                    return nullptr;
+                return list_.allocate(n * buffer_size());
+            }
+
+            /// \effects Deallocates a single buffer.
+            /// \requires \c buffer must have been returned by \ref allocate_buffer() or \ref try_allocate_buffer().
+            void deallocate_buffer(void* buffer) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(owns(buffer));
+                list_.deallocate(buffer);
+            }
+
+            /// \effects Deallocates \c n adjacent buffers.
+            /// \requires \c buffers must have been returned by \ref allocate_buffers() with the same \c n.
+            void deallocate_buffers(void* buffers, std::size_t n) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(owns(buffers));
+                list_.deallocate(buffers, n * buffer_size());
+            }
+
+            /// @{
+            /// \effects Allocates enough adjacent buffers for the given size.
+            /// \returns The first buffer.
+            /// \throws \ref out_of_fixed_memory if there are not enough adjacent free buffers,
+            /// or \ref bad_alignment if the alignment is bigger than the one of the buffers.
+            void* allocate_node(std::size_t size, std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_alignment>(alignment, alignment_, info());
+                return allocate_buffers(buffers_for(size));
+            }
+
+            void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+            {
+                return allocate_node(count * size, alignment);
+            }
+            /// @}
+
+            /// @{
+            /// \effects Deallocates the buffers of the allocation.
+            void deallocate_node(void* ptr, std::size_t size, std::size_t) noexcept
+            {
+                deallocate_buffers(ptr, buffers_for(size));
+            }
+
+            void deallocate_array(void* ptr, std::size_t count, std::size_t size,
+                                  std::size_t alignment) noexcept
+            {
+                deallocate_node(ptr, count * size, alignment);
+            }
+            /// @}
+
+            /// \returns The size of all buffers together.
+            std::size_t max_node_size() const noexcept
+            {
+                return region_.size;
+            }
+
+            /// \returns The size of all buffers together.
+            std::size_t max_array_size() const noexcept
+            {
+                return region_.size;
+            }
+
+            /// \returns The alignment of the buffers.
+            std::size_t max_alignment() const noexcept
+            {
+                return alignment_;
+            }
+
+            /// \returns The region containing all buffers, e.g. to register it as a single fixed buffer with \c io_uring.
+            memory_block region() const noexcept
+            {
+                return region_;
+            }
+
+            /// \returns The buffer with the given index, e.g. to register each buffer separately.
+            /// \requires \c i must be less than \ref buffer_count().
+            void* buffer_at(std::size_t i) const noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(i < buffer_count());
+                return static_cast<char*>(region_.memory) + i * buffer_size();
+            }
+
+            /// \returns The index of the buffer, i.e. the inverse of \ref buffer_at().
+            /// \requires \c buffer must be a buffer of the pool.
+            std::size_t index_of(const void* buffer) const noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(owns(buffer));
+                return std::size_t(static_cast<const char*>(buffer)
+                                   - static_cast<const char*>(region_.memory))
+                       / buffer_size();
+            }
+
+            /// \returns Whether or not the memory is inside the region.
+            bool owns(const void* memory) const noexcept
+            {
+                return region_.contains(memory);
+            }
+
+            /// \returns The size of each buffer, a multiple of the alignment.
+            std::size_t buffer_size() const noexcept
+            {
+                return list_.node_size();
+            }
+
+            /// \returns The alignment of each buffer.
+            std::size_t buffer_alignment() const noexcept
+            {
+                return alignment_;
+            }
+
+            /// \returns The total number of buffers.
+            std::size_t buffer_count() const noexcept
+            {
+                return region_.size / buffer_size();
+            }
+
+            /// \returns The number of free buffers.
+            std::size_t capacity_left() const noexcept
+            {
+                return list_.capacity();
+            }
+
+        private:
+            allocator_info info() const noexcept
+            {
+                return {FOONATHAN_MEMORY_LOG_PREFIX "::io_buffer_pool", this};
+            }
+
+            std::size_t buffers_for(std::size_t size) const noexcept
+            {
+                auto n = (size + buffer_size() - 1u) / buffer_size();
+                return n == 0u ? 1u : n;
+            }
+
+            detail::ordered_free_memory_list list_;
+            void*                            reserved_;
+            std::size_t                      reserved_size_;
+            memory_block                     region_;
+            std::size_t                      alignment_;
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_IO_BUFFER_POOL_HPP_INCLUDED
@@ -5,7 +5,9 @@
 #define FOONATHAN_MEMORY_ITERATION_ALLOCATOR_HPP_INCLUDED
 
 /// \file
-/// Class template \ref foonathan::memory::iteration_allocator.
+/// Class template \ref foonathan::memory::iteration_allocator and \ref foonathan::memory::concurrent_iteration_allocator.
+
+#include <atomic>
 
 #include "detail/debug_helpers.hpp"
 #include "detail/memory_stack.hpp"
@@ -100,7 +102,7 @@ namespace foonathan
                 auto offset = detail::align_offset(stack.top() + fence, alignment);
                 if (!stack.top()
                     || (fence + offset + size + fence > std::size_t(block_end(cur_) - stack.top())))
-                    FOONATHAN_THROW(out_of_fixed_memory(info(), size));
+                    detail::throw_out_of_fixed_memory(info(), size);
                 return stack.allocate_unchecked(size, offset);
             }
 
@@ -114,6 +116,17 @@ namespace foonathan
                 return stack.allocate(block_end(cur_), size, alignment);
             }
 
+            /// \effects Changes the size of the memory block returned by the last allocation in place,
+            /// similar to \ref memory_stack::try_expand().
+            /// \returns `true` if the size has been changed,
+            /// `false` if the current stack does not have enough memory left
+            /// or the memory block wasn't returned by the last allocation.
+            /// \requires \c memory must have been allocated in the current iteration with the size \c old_size.
+            bool try_expand(void* memory, std::size_t old_size, std::size_t new_size) noexcept
+            {
+                return stacks_[cur_].try_resize(block_end(cur_), memory, old_size, new_size);
+            }
+
             /// \effects Goes to the next internal stack.
             /// This will clear the stack whose \ref max_iterations() lifetime has reached,
             /// and use it for all allocations in this iteration.
@@ -159,6 +172,22 @@ namespace foonathan
                 return capacity_left(cur_iteration());
             }
 
+            /// \returns The memory usage of the allocator,
+            /// the memory remaining in each stack counts as \c unused_bytes.
+            memory_stats stats() const noexcept
+            {
+                memory_stats result;
+                result.reserved_bytes = result.committed_bytes = block_.size;
+                result.blocks                                  = 1u;
+                for (std::size_t i = 0u; i != N; ++i)
+                {
+                    result.used_bytes += std::size_t(stacks_[i].top() - block_start(i));
+                    result.unused_bytes += capacity_left(i);
+                }
+                result.wasted_bytes = block_.size - result.used_bytes - result.unused_bytes;
+                return result;
+            }
+
         private:
             allocator_info info() const noexcept
             {
@@ -204,8 +233,9 @@ namespace foonathan
         class allocator_traits<iteration_allocator<N, BlockAllocator>>
         {
         public:
-            using allocator_type = iteration_allocator<N, BlockAllocator>;
-            using is_stateful    = std::true_type;
+            using allocator_type       = iteration_allocator<N, BlockAllocator>;
+            using is_stateful          = std::true_type;
+            using is_deallocation_noop = std::true_type;
 
             /// \returns The result of \ref iteration_allocator::allocate().
             static void* allocate_node(allocator_type& state, std::size_t size,
@@ -234,6 +264,22 @@ namespace foonathan
             }
             /// @}
 
+            /// @{
+            /// \returns The result of \ref iteration_allocator::try_expand().
+            static bool try_expand_node(allocator_type& state, void* node, std::size_t old_size,
+                                        std::size_t new_size, std::size_t) noexcept
+            {
+                return state.try_expand(node, old_size, new_size);
+            }
+
+            static bool try_expand_array(allocator_type& state, void* array, std::size_t old_count,
+                                         std::size_t new_count, std::size_t size,
+                                         std::size_t) noexcept
+            {
+                return state.try_expand(array, old_count * size, new_count * size);
+            }
+            /// @}
+
             /// @{
             /// \returns The maximum size which is \ref iteration_allocator::capacity_left().
             static std::size_t max_node_size(const allocator_type& state) noexcept
@@ -298,6 +344,256 @@ namespace foonathan
         extern template class allocator_traits<iteration_allocator<2>>;
         extern template class composable_allocator_traits<iteration_allocator<2>>;
 #endif
+
+        /// A variant of \ref iteration_allocator that can be used by multiple threads at once,
+        /// e.g. by the workers of a job system building a frame while the previous one is still used.
+        /// It divides the memory of an iteration into slices of a fixed size,
+        /// each thread bump-allocates from its own slice through a \ref local_allocator,
+        /// so the only shared state it touches is an atomic counter whenever it needs a new slice,
+        /// which is taken lock-free.
+        /// Calling \ref next_iteration() when all threads are done with the current one
+        /// switches to the next stack which is a constant time operation.
+        /// \ingroup allocator
+        template <std::size_t N, class BlockOrRawAllocator = default_allocator>
+        class concurrent_iteration_allocator
+        : FOONATHAN_EBO(detail::iteration_block_allocator<BlockOrRawAllocator>)
+        {
+        public:
+            using allocator_type = detail::iteration_block_allocator<BlockOrRawAllocator>;
+
+            /// A stateful \concept{concept_rawallocator,RawAllocator} that allocates from a \ref concurrent_iteration_allocator
+            /// and must only be used by one thread at a time, usually one object per worker thread.
+            /// It takes a new slice of memory once its current one is exhausted
+            /// or the iteration has changed.
+            /// \note The \ref concurrent_iteration_allocator must outlive it.
+            class local_allocator
+            {
+            public:
+                using is_stateful = std::true_type;
+
+                /// \effects Creates it for the given allocator without taking a slice yet.
+                explicit local_allocator(concurrent_iteration_allocator& alloc) noexcept
+                : alloc_(&alloc), end_(nullptr), iteration_(0u)
+                {
+                }
+
+                /// @{
+                /// \effects Allocates memory from the current slice,
+                /// if it does not have enough memory left, takes a new one.
+                /// An allocation bigger than the slice size gets its own slice.
+                /// \returns The allocated memory, valid for \ref max_iterations() iterations.
+                /// \throws \ref out_of_fixed_memory if the current iteration does not have enough memory left.
+                /// \requires It must not be called concurrently with \ref next_iteration().
+                void* allocate_node(std::size_t size, std::size_t alignment)
+                {
+                    if (auto memory = try_allocate_node(size, alignment))
+                        return memory;
+                    FOONATHAN_THROW(out_of_fixed_memory(alloc_->info(), size));
+                }
+
+                void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+                {
+                    return allocate_node(count * size, alignment);
+                }
+                /// @}
+
+                /// @{
+                /// \effects Allocates memory similar to \ref allocate_node().
+                /// \returns The allocated memory or `nullptr` if the current iteration does not have enough memory left.
+                void* try_allocate_node(std::size_t size, std::size_t alignment) noexcept
+                {
+                    check_iteration();
+                    if (auto memory = stack_.allocate(end_, size, alignment))
+                        return memory;
+                    else if (!take_slice(size, alignment))
+                        return nullptr;
+                    return stack_.allocate(end_, size, alignment);
+                }
+
+                void* try_allocate_array(std::size_t count, std::size_t size,
+                                         std::size_t alignment) noexcept
+                {
+                    return try_allocate_node(count * size, alignment);
+                }
+                /// @}
+
+                /// @{
+                /// \effects Does nothing, the memory is released after \ref max_iterations() iterations.
+                void deallocate_node(void*, std::size_t, std::size_t) noexcept {}
+
+                void deallocate_array(void*, std::size_t, std::size_t, std::size_t) noexcept {}
+                /// @}
+
+                /// @{
+                /// \effects Changes the size of the memory returned by the last allocation in place,
+                /// within the current slice.
+                /// \returns Whether or not the size has been changed.
+                bool try_expand_node(void* node, std::size_t old_size, std::size_t new_size,
+                                     std::size_t) noexcept
+                {
+                    check_iteration();
+                    return stack_.try_resize(end_, node, old_size, new_size);
+                }
+
+                bool try_expand_array(void* array, std::size_t old_count, std::size_t new_count,
+                                      std::size_t size, std::size_t alignment) noexcept
+                {
+                    return try_expand_node(array, old_count * size, new_count * size, alignment);
+                }
+                /// @}
+
+                /// \returns A reference to the \ref concurrent_iteration_allocator.
+                concurrent_iteration_allocator& get_allocator() const noexcept
+                {
+                    return *alloc_;
+                }
+
+            private:
+                void check_iteration() noexcept
+                {
+                    if (iteration_ != alloc_->iteration_.load(std::memory_order_acquire))
+                    {
+                        // slice belongs to an older iteration
+                        stack_ = detail::fixed_memory_stack();
+                        end_   = nullptr;
+                    }
+                }
+
+                bool take_slice(std::size_t size, std::size_t alignment) noexcept
+                {
+                    auto needed = 2 * detail::debug_fence_size + alignment + size;
+                    auto slice  = alloc_->take_slice(needed, iteration_);
+                    if (!slice.memory)
+                        return false;
+                    stack_ = detail::fixed_memory_stack(slice.memory);
+                    end_   = static_cast<char*>(slice.memory) + slice.size;
+                    return true;
+                }
+
+                concurrent_iteration_allocator* alloc_;
+                detail::fixed_memory_stack      stack_;
+                const char*                     end_;
+                std::size_t                     iteration_;
+            };
+
+            /// \effects Creates it with a given initial block size, the size of the slices handed out to each \ref local_allocator,
+            /// and other constructor arguments for the \concept{concept_blockallocator,BlockAllocator}.
+            /// It will allocate the first (and only) block and evenly divide it on all the stacks it uses.
+            /// \requires \c slice_size must not be \c 0.
+            template <typename... Args>
+            concurrent_iteration_allocator(std::size_t block_size, std::size_t slice_size,
+                                           Args&&... args)
+            : allocator_type(block_size, detail::forward<Args>(args)...),
+              slice_size_(slice_size),
+              used_(0u),
+              iteration_(0u)
+            {
+                FOONATHAN_MEMORY_ASSERT(slice_size_ > 0u);
+                block_ = get_allocator().allocate_block();
+            }
+
+            ~concurrent_iteration_allocator() noexcept
+            {
+                get_allocator().deallocate_block(block_);
+            }
+
+            concurrent_iteration_allocator(concurrent_iteration_allocator&&)            = delete;
+            concurrent_iteration_allocator& operator=(concurrent_iteration_allocator&&) = delete;
+
+            /// \effects Goes to the next internal stack,
+            /// releasing the memory of the stack whose \ref max_iterations() lifetime has reached.
+            /// Each \ref local_allocator will take a slice of it on its next allocation.
+            /// \requires No \ref local_allocator may allocate at the same time
+            /// and all previous allocations must happen before it, e.g. by calling it after a barrier all threads have reached.
+            void next_iteration() noexcept
+            {
+                used_.store(0u, std::memory_order_relaxed);
+                iteration_.store(iteration_.load(std::memory_order_relaxed) + 1u,
+                                 std::memory_order_release);
+            }
+
+            /// \returns The number of iteration each allocation will live.
+            /// This is the template parameter `N`.
+            static std::size_t max_iterations() noexcept
+            {
+                return N;
+            }
+
+            /// \returns The index of the current iteration.
+            /// This is modulo \ref max_iterations().
+            std::size_t cur_iteration() const noexcept
+            {
+                return iteration_.load(std::memory_order_acquire) % N;
+            }
+
+            /// \returns The size of the slices handed out to each \ref local_allocator.
+            std::size_t slice_size() const noexcept
+            {
+                return slice_size_;
+            }
+
+            /// \returns The amount of memory of the current iteration that has not been handed out as slices yet.
+            /// \note As other threads may take slices at the same time, the result may already be outdated.
+            std::size_t capacity_left() const noexcept
+            {
+                return stack_size() - used_.load(std::memory_order_relaxed);
+            }
+
+            /// \returns A reference to the \concept{concept_blockallocator,BlockAllocator} used for managing the memory.
+            allocator_type& get_allocator() noexcept
+            {
+                return *this;
+            }
+
+        private:
+            allocator_info info() const noexcept
+            {
+                return {FOONATHAN_MEMORY_LOG_PREFIX "::concurrent_iteration_allocator", this};
+            }
+
+            std::size_t stack_size() const noexcept
+            {
+                return block_.size / N;
+            }
+
+            // returns a slice of at least the given size of the current stack,
+            // or an empty block if there is not enough memory left
+            memory_block take_slice(std::size_t min_size, std::size_t& iteration) noexcept
+            {
+                iteration = iteration_.load(std::memory_order_acquire);
+
+                auto offset = used_.load(std::memory_order_relaxed);
+                auto size   = std::size_t(0u);
+                do
+                {
+                    auto left = stack_size() - offset;
+                    if (left < min_size)
+                        return {};
+                    size = min_size > slice_size_ ? min_size : slice_size_;
+                    if (left < size)
+                        size = left; // last slice is smaller
+                } while (!used_.compare_exchange_weak(offset, offset + size,
+                                                      std::memory_order_relaxed));
+
+                auto stack = static_cast<char*>(block_.memory) + (iteration % N) * stack_size();
+                return {stack + offset, size};
+            }
+
+            memory_block             block_;
+            std::size_t              slice_size_;
+            std::atomic<std::size_t> used_;
+            std::atomic<std::size_t> iteration_;
+        };
+
+        /// An alias for \ref concurrent_iteration_allocator for two iterations.
+        /// \ingroup allocator
+        template <class BlockOrRawAllocator = default_allocator>
+        FOONATHAN_ALIAS_TEMPLATE(concurrent_double_frame_allocator,
+                                 concurrent_iteration_allocator<2, BlockOrRawAllocator>);
+
+#if FOONATHAN_MEMORY_EXTERN_TEMPLATE
+        extern template class concurrent_iteration_allocator<2>;
+#endif
     } // namespace memory
 } // namespace foonathan
 
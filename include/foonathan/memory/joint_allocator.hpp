@@ -199,7 +199,7 @@ namespace foonathan
         /// you need to write them yourself.
         ///
         /// You can only access the object through the pointer,
-        /// use \ref joint_allocator or \ref joint_array as members of `T`,
+        /// use \ref joint_allocator, \ref joint_array or \ref joint_vector as members of `T`,
         /// to enable the memory sharing.
         /// If you are using \ref joint_allocator inside STL containers,
         /// make sure that you do not call their regular copy/move constructors,
@@ -525,8 +525,8 @@ namespace foonathan
             {
                 FOONATHAN_MEMORY_ASSERT(stack_);
                 auto mem = stack_->allocate(size, alignment);
-                if (!mem)
-                    FOONATHAN_THROW(out_of_fixed_memory(info(), size));
+                if (FOONATHAN_MEMORY_UNLIKELY(!mem))
+                    detail::throw_out_of_fixed_memory(info(), size);
                 return mem;
             }
 
@@ -920,6 +920,357 @@ namespace foonathan
             value_type* ptr_;
             std::size_t size_;
         };
+
+        /// A dynamic array using joint memory that can grow.
+        ///
+        /// Unlike \ref joint_array, it does not have a fixed size.
+        /// As long as it is the last allocation of the joint memory,
+        /// it grows in place by bumping the joint memory without moving the elements.
+        /// Only if the remaining joint memory is exhausted,
+        /// the elements are moved into external storage allocated by the \concept{concept_rawallocator,RawAllocator},
+        /// which is stored in an \ref allocator_reference.
+        /// \ingroup allocator
+        template <typename T, class RawAllocator = default_allocator>
+        class joint_vector : FOONATHAN_EBO(allocator_reference<RawAllocator>)
+        {
+        public:
+            using value_type     = T;
+            using allocator_type = typename allocator_reference<RawAllocator>::allocator_type;
+            using iterator       = value_type*;
+            using const_iterator = const value_type*;
+
+            //=== constructors ===//
+            /// @{
+            /// \effects Creates an empty vector using the specified joint memory
+            /// and the \concept{concept_rawallocator,RawAllocator} for the external storage.
+            /// It does not reserve any memory.
+            template <typename JointType>
+            joint_vector(joint_type<JointType>& j, allocator_type& alloc) noexcept
+            : allocator_reference<RawAllocator>(alloc),
+              stack_(&detail::get_stack(j)),
+              ptr_(nullptr),
+              size_(0u),
+              capacity_(0u),
+              joint_(true)
+            {
+            }
+
+            template <typename JointType>
+            explicit joint_vector(joint_type<JointType>& j,
+                                  const allocator_type& alloc = allocator_type()) noexcept
+            : allocator_reference<RawAllocator>(alloc),
+              stack_(&detail::get_stack(j)),
+              ptr_(nullptr),
+              size_(0u),
+              capacity_(0u),
+              joint_(true)
+            {
+            }
+            /// @}
+
+            joint_vector(const joint_vector&) = delete;
+            joint_vector(joint_vector&&)      = delete;
+
+            /// \effects Destroys all objects and releases the external storage, if there is any.
+            /// The joint memory is given back if it is the last allocation of it.
+            ~joint_vector() noexcept
+            {
+                clear();
+                release_storage();
+            }
+
+            joint_vector& operator=(const joint_vector&) = delete;
+            joint_vector& operator=(joint_vector&&)      = delete;
+
+            //=== modifiers ===//
+            /// \effects Creates a new object at the end by forwarding the arguments to its constructor,
+            /// growing the storage if necessary.
+            /// \returns A reference to the new object.
+            /// \throws Anything thrown by the allocation or `T`s constructor.
+            /// If an exception is thrown, the vector is unchanged.
+            template <typename... Args>
+            value_type& emplace_back(Args&&... args)
+            {
+                // prefer the minimal growth over leaving the joint memory
+                if (size_ != capacity_ || expand(next_capacity(size_ + 1u)) || expand(size_ + 1u))
+                    ::new (static_cast<void*>(ptr_ + size_)) T(detail::forward<Args>(args)...);
+                else
+                {
+                    // the arguments may refer to an element that is moved
+                    T tmp(detail::forward<Args>(args)...);
+                    relocate(next_capacity(size_ + 1u));
+                    ::new (static_cast<void*>(ptr_ + size_)) T(detail::move(tmp));
+                }
+                return ptr_[size_++];
+            }
+
+            /// @{
+            /// \effects Same as `emplace_back(value)`.
+            void push_back(const value_type& value)
+            {
+                emplace_back(value);
+            }
+
+            void push_back(value_type&& value)
+            {
+                emplace_back(detail::move(value));
+            }
+            /// @}
+
+            /// \effects Destroys the last object.
+            /// \requires `!empty()`.
+            void pop_back() noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(size_ != 0u);
+                ptr_[--size_].~T();
+            }
+
+            /// \effects Destroys all objects, but keeps the storage.
+            void clear() noexcept
+            {
+                while (size_ != 0u)
+                    ptr_[--size_].~T();
+            }
+
+            /// \effects Ensures that the capacity is at least `new_capacity`,
+            /// growing in the joint memory if possible.
+            /// \throws Anything thrown by the allocation or `T`s move constructor.
+            void reserve(std::size_t new_capacity)
+            {
+                if (new_capacity > capacity_ && !expand(new_capacity))
+                    relocate(new_capacity);
+            }
+
+            //=== accessors ===//
+            /// @{
+            /// \returns A reference to the `i`th object.
+            /// \requires `i < size()`.
+            value_type& operator[](std::size_t i) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(i < size_);
+                return ptr_[i];
+            }
+
+            const value_type& operator[](std::size_t i) const noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(i < size_);
+                return ptr_[i];
+            }
+            /// @}
+
+            /// @{
+            /// \returns A reference to the first object.
+            /// \requires `!empty()`.
+            value_type& front() noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(size_ != 0u);
+                return ptr_[0];
+            }
+
+            const value_type& front() const noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(size_ != 0u);
+                return ptr_[0];
+            }
+            /// @}
+
+            /// @{
+            /// \returns A reference to the last object.
+            /// \requires `!empty()`.
+            value_type& back() noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(size_ != 0u);
+                return ptr_[size_ - 1u];
+            }
+
+            const value_type& back() const noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(size_ != 0u);
+                return ptr_[size_ - 1u];
+            }
+            /// @}
+
+            /// @{
+            /// \returns A pointer to the first object.
+            /// It points to contiguous memory and can be used to access the objects directly.
+            value_type* data() noexcept
+            {
+                return ptr_;
+            }
+
+            const value_type* data() const noexcept
+            {
+                return ptr_;
+            }
+            /// @}
+
+            /// @{
+            /// \returns A random access iterator to the first element.
+            iterator begin() noexcept
+            {
+                return ptr_;
+            }
+
+            const_iterator begin() const noexcept
+            {
+                return ptr_;
+            }
+            /// @}
+
+            /// @{
+            /// \returns A random access iterator one past the last element.
+            iterator end() noexcept
+            {
+                return ptr_ + size_;
+            }
+
+            const_iterator end() const noexcept
+            {
+                return ptr_ + size_;
+            }
+            /// @}
+
+            /// \returns The number of elements in the vector.
+            std::size_t size() const noexcept
+            {
+                return size_;
+            }
+
+            /// \returns The number of elements that fit into the current storage.
+            std::size_t capacity() const noexcept
+            {
+                return capacity_;
+            }
+
+            /// \returns `true` if the vector is empty, `false` otherwise.
+            bool empty() const noexcept
+            {
+                return size_ == 0u;
+            }
+
+            /// \returns `true` if the elements are stored in the joint memory,
+            /// `false` if they have been moved to external storage.
+            bool is_joint() const noexcept
+            {
+                return joint_;
+            }
+
+            /// \returns A reference to the allocator used for the external storage.
+            auto get_allocator() const noexcept
+                -> decltype(std::declval<allocator_reference<RawAllocator>>().get_allocator())
+            {
+                return this->allocator_reference<RawAllocator>::get_allocator();
+            }
+
+        private:
+            // moves the elements into new storage,
+            // destroys them and releases the new storage if an exception is thrown
+            class relocation
+            {
+            public:
+                relocation(joint_vector& vec, std::size_t capacity)
+                : vec_(&vec), ptr_(nullptr), capacity_(capacity), size_(0u)
+                {
+                    ptr_ = static_cast<T*>(
+                        vec_->allocate_array(capacity_, sizeof(T), alignof(T)));
+                }
+
+                ~relocation() noexcept
+                {
+                    if (!ptr_)
+                        return;
+                    while (size_ != 0u)
+                        ptr_[--size_].~T();
+                    vec_->deallocate_array(ptr_, capacity_, sizeof(T), alignof(T));
+                }
+
+                relocation(relocation&&)            = delete;
+                relocation& operator=(relocation&&) = delete;
+
+                void move(T& obj)
+                {
+                    // only move if it cannot throw, like std::move_if_noexcept()
+                    using type = typename std::conditional<
+                        std::is_nothrow_move_constructible<T>::value
+                            || !std::is_copy_constructible<T>::value,
+                        T&&, const T&>::type;
+                    ::new (static_cast<void*>(ptr_ + size_)) T(static_cast<type>(obj));
+                    ++size_;
+                }
+
+                T* release() noexcept
+                {
+                    auto res = ptr_;
+                    ptr_     = nullptr;
+                    return res;
+                }
+
+            private:
+                joint_vector* vec_;
+                T*            ptr_;
+                std::size_t   capacity_, size_;
+            };
+
+            std::size_t next_capacity(std::size_t min_capacity) const noexcept
+            {
+                return 2u * capacity_ < min_capacity ? min_capacity : 2u * capacity_;
+            }
+
+            char* end_of_storage() const noexcept
+            {
+                return static_cast<char*>(static_cast<void*>(ptr_ + capacity_));
+            }
+
+            // tries to grow to the given capacity in the joint memory
+            bool expand(std::size_t new_capacity) noexcept
+            {
+                if (!joint_)
+                    return false;
+                else if (!ptr_)
+                {
+                    ptr_ = static_cast<T*>(stack_->allocate(new_capacity * sizeof(T), alignof(T)));
+                    if (!ptr_)
+                        return false;
+                }
+                else if (end_of_storage() != stack_->top()
+                         || !stack_->bump((new_capacity - capacity_) * sizeof(T)))
+                    return false;
+
+                capacity_ = new_capacity;
+                return true;
+            }
+
+            void relocate(std::size_t new_capacity)
+            {
+                relocation r(*this, new_capacity);
+                for (std::size_t i = 0u; i != size_; ++i)
+                    r.move(ptr_[i]);
+
+                auto size = size_;
+                clear();
+                release_storage();
+
+                ptr_      = r.release();
+                size_     = size;
+                capacity_ = new_capacity;
+                joint_    = false;
+            }
+
+            void release_storage() noexcept
+            {
+                if (!ptr_)
+                    return;
+                else if (!joint_)
+                    this->deallocate_array(ptr_, capacity_, sizeof(T), alignof(T));
+                else if (end_of_storage() == stack_->top())
+                    stack_->unwind(ptr_);
+            }
+
+            detail::joint_stack* stack_;
+            value_type*          ptr_;
+            std::size_t          size_, capacity_;
+            bool                 joint_;
+        };
     } // namespace memory
 } // namespace foonathan
 
@@ -0,0 +1,324 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_LATENCY_TRACKING_HPP_INCLUDED
+#define FOONATHAN_MEMORY_LATENCY_TRACKING_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::latency_tracked_allocator and related classes and functions.
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define FOONATHAN_MEMORY_IMPL_RDTSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define FOONATHAN_MEMORY_IMPL_RDTSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+#define FOONATHAN_MEMORY_IMPL_CNTVCT 1
+#else
+#include <chrono>
+#endif
+
+#include "detail/utility.hpp"
+#include "allocator_traits.hpp"
+#include "config.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// The cheapest counter available to measure the latency of allocator calls.
+        /// It is the time stamp counter on x86 and the virtual counter on AArch64,
+        /// which are read in a few cycles, and \c std::chrono::steady_clock in nanoseconds otherwise.
+        /// \note The unit of the ticks depends on the platform, but it is constant on modern CPUs,
+        /// independent of frequency scaling.
+        /// The counter is not serializing, so the instructions around a measured call may overlap with it a little.
+        /// \ingroup adapter
+        struct latency_clock
+        {
+            /// Whether or not the ticks come from a counter of the CPU instead of \c std::chrono::steady_clock.
+#if defined(FOONATHAN_MEMORY_IMPL_RDTSC) || defined(FOONATHAN_MEMORY_IMPL_CNTVCT)
+            static constexpr bool is_cycle_counter = true;
+#else
+            static constexpr bool is_cycle_counter = false;
+#endif
+
+            /// \returns The current value of the counter.
+            static std::uint64_t now() noexcept
+            {
+#if defined(FOONATHAN_MEMORY_IMPL_RDTSC)
+                return static_cast<std::uint64_t>(__rdtsc());
+#elif defined(FOONATHAN_MEMORY_IMPL_CNTVCT)
+                std::uint64_t result;
+                asm volatile("mrs %0, cntvct_el0" : "=r"(result));
+                return result;
+#else
+                return static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count());
+#endif
+            }
+        };
+
+        /// The number of buckets of a \ref latency_histogram_snapshot.
+        /// \ingroup adapter
+        constexpr std::size_t latency_histogram_size = 496u;
+
+        /// The latencies of one kind of allocator call at a certain point in time as returned by \ref allocation_latency::snapshot().
+        /// Like an HDR histogram, each power of two of ticks is split into eight equally wide buckets,
+        /// so every latency is recorded with a relative error of at most 12.5%,
+        /// and latencies below 16 ticks exactly.
+        /// \ingroup adapter
+        struct latency_histogram_snapshot
+        {
+            /// The number of recorded calls.
+            std::uint64_t count;
+
+            /// The highest recorded latency in ticks.
+            std::uint64_t max;
+
+            /// The number of recorded calls per bucket.
+            std::uint64_t buckets[latency_histogram_size];
+
+            /// \returns The index of the bucket a latency of the given number of ticks is recorded in.
+            static std::size_t bucket_of(std::uint64_t ticks) noexcept;
+
+            /// \returns The highest latency in ticks that is recorded in the given bucket.
+            static std::uint64_t upper_bound(std::size_t bucket) noexcept;
+
+            /// \returns The latency in ticks that \c p percent of the recorded calls did not exceed,
+            /// e.g. \c 99.9 for the p99.9,
+            /// i.e. the upper bound of the bucket it falls into, but never more than \ref max.
+            /// If no calls were recorded, it returns \c 0.
+            /// \requires \c p must be in the range <tt>[0, 100]</tt>.
+            std::uint64_t percentile(double p) const noexcept;
+        };
+
+        /// The kinds of allocator calls recorded by \ref allocation_latency.
+        /// \ingroup adapter
+        enum class latency_operation
+        {
+            allocation,   ///< \c allocate_node() and \c allocate_array().
+            deallocation, ///< \c deallocate_node() and \c deallocate_array().
+        };
+
+        namespace detail
+        {
+            // returns true for every period-th call on the current thread, never if period is 0
+            bool latency_sample_next(std::size_t period) noexcept;
+        } // namespace detail
+
+        /// Latency histograms shared by one or more \ref latency_tracked_allocator objects.
+        /// Like \ref allocation_statistics, each thread records into its own set of counters,
+        /// so recording a call is only a few uncontended atomic additions,
+        /// and \ref snapshot() adds them up while the allocators keep running.
+        /// \note The object must outlive all allocators referring to it.
+        /// As it contains the histograms of multiple threads, it is rather big and should not be put on a small stack.
+        /// \ingroup adapter
+        class allocation_latency
+        {
+        public:
+            /// \effects Creates it with all histograms being empty.
+            allocation_latency() noexcept;
+
+            allocation_latency(const allocation_latency&)            = delete;
+            allocation_latency& operator=(const allocation_latency&) = delete;
+
+            /// \effects Records a call of the given kind that took the given number of ticks.
+            void record(latency_operation op, std::uint64_t ticks) noexcept;
+
+            /// \returns The current histogram of the given kind of calls.
+            /// \note Calls recorded by other threads at the same time may or may not be included.
+            latency_histogram_snapshot snapshot(latency_operation op) const noexcept;
+
+        private:
+            static constexpr std::size_t shard_count = 16u;
+
+            struct histogram
+            {
+                std::atomic<std::uint64_t> max;
+                std::atomic<std::uint64_t> buckets[latency_histogram_size];
+            };
+
+            struct alignas(64) shard
+            {
+                histogram histograms[2];
+            };
+
+            shard shards_[shard_count];
+        };
+
+        /// A \concept{concept_rawallocator,RawAllocator} adapter that measures the latency of the calls to another allocator.
+        /// It reads the \ref latency_clock before and after forwarding to the allocator
+        /// and records the difference in an \ref allocation_latency object,
+        /// which can be shared by multiple allocators.
+        /// Unlike the counts of a \ref statistics_tracker, the histograms show the rare slow calls,
+        /// e.g. those that allocate a new memory block.
+        /// To reduce the overhead, only every \ref sample_period()-th call of a thread is measured.
+        /// \note Calls that throw an exception are not recorded.
+        /// \ingroup adapter
+        template <class RawAllocator>
+        class latency_tracked_allocator
+        : FOONATHAN_EBO(allocator_traits<RawAllocator>::allocator_type)
+        {
+            using traits = allocator_traits<RawAllocator>;
+
+        public:
+            using allocator_type = typename allocator_traits<RawAllocator>::allocator_type;
+            using is_stateful    = std::true_type;
+
+            /// \effects Creates it passing it the latency histograms, the sample period and the allocator object.
+            /// A sample period of \c 1 measures all calls, \c 0 none.
+            explicit latency_tracked_allocator(allocation_latency& latency,
+                                               std::size_t         sample_period = 1u,
+                                               allocator_type&&    alloc         = {})
+            : allocator_type(detail::move(alloc)), latency_(&latency), sample_period_(sample_period)
+            {
+            }
+
+            /// @{
+            /// \effects Moves the \c latency_tracked_allocator object.
+            /// It simply moves the underlying allocator.
+            latency_tracked_allocator(latency_tracked_allocator&& other) noexcept
+            : allocator_type(detail::move(other)),
+              latency_(other.latency_),
+              sample_period_(other.sample_period_)
+            {
+            }
+
+            latency_tracked_allocator& operator=(latency_tracked_allocator&& other) noexcept
+            {
+                allocator_type::operator=(detail::move(other));
+                latency_       = other.latency_;
+                sample_period_ = other.sample_period_;
+                return *this;
+            }
+            /// @}
+
+            /// @{
+            /// \effects Forwards to the underlying allocator through the \ref allocator_traits,
+            /// recording the latency of the call if it is sampled.
+            /// \returns The result of the underlying allocator.
+            /// \throws Anything thrown by the underlying allocator.
+            void* allocate_node(std::size_t size, std::size_t alignment)
+            {
+                if (!detail::latency_sample_next(sample_period_))
+                    return traits::allocate_node(get_allocator(), size, alignment);
+
+                auto start  = latency_clock::now();
+                auto memory = traits::allocate_node(get_allocator(), size, alignment);
+                latency_->record(latency_operation::allocation, latency_clock::now() - start);
+                return memory;
+            }
+
+            void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+            {
+                if (!detail::latency_sample_next(sample_period_))
+                    return traits::allocate_array(get_allocator(), count, size, alignment);
+
+                auto start  = latency_clock::now();
+                auto memory = traits::allocate_array(get_allocator(), count, size, alignment);
+                latency_->record(latency_operation::allocation, latency_clock::now() - start);
+                return memory;
+            }
+            /// @}
+
+            /// @{
+            /// \effects Forwards to the underlying allocator through the \ref allocator_traits,
+            /// recording the latency of the call if it is sampled.
+            void deallocate_node(void* ptr, std::size_t size, std::size_t alignment) noexcept
+            {
+                if (!detail::latency_sample_next(sample_period_))
+                    return traits::deallocate_node(get_allocator(), ptr, size, alignment);
+
+                auto start = latency_clock::now();
+                traits::deallocate_node(get_allocator(), ptr, size, alignment);
+                latency_->record(latency_operation::deallocation, latency_clock::now() - start);
+            }
+
+            void deallocate_array(void* ptr, std::size_t count, std::size_t size,
+                                  std::size_t alignment) noexcept
+            {
+                if (!detail::latency_sample_next(sample_period_))
+                    return traits::deallocate_array(get_allocator(), ptr, count, size, alignment);
+
+                auto start = latency_clock::now();
+                traits::deallocate_array(get_allocator(), ptr, count, size, alignment);
+                latency_->record(latency_operation::deallocation, latency_clock::now() - start);
+            }
+            /// @}
+
+            /// @{
+            /// \returns The result of the corresponding function on the underlying allocator.
+            std::size_t max_node_size() const
+            {
+                return traits::max_node_size(get_allocator());
+            }
+
+            std::size_t max_array_size() const
+            {
+                return traits::max_array_size(get_allocator());
+            }
+
+            std::size_t max_alignment() const
+            {
+                return traits::max_alignment(get_allocator());
+            }
+            /// @}
+
+            /// @{
+            /// \returns A reference to the underlying allocator.
+            allocator_type& get_allocator() noexcept
+            {
+                return *this;
+            }
+
+            const allocator_type& get_allocator() const noexcept
+            {
+                return *this;
+            }
+            /// @}
+
+            /// \returns A reference to the latency histograms.
+            allocation_latency& get_latency() const noexcept
+            {
+                return *latency_;
+            }
+
+            /// \returns The number of calls per thread for each measured call.
+            std::size_t sample_period() const noexcept
+            {
+                return sample_period_;
+            }
+
+            /// \effects Sets the sample period to a new value.
+            void set_sample_period(std::size_t sample_period) noexcept
+            {
+                sample_period_ = sample_period;
+            }
+
+        private:
+            allocation_latency* latency_;
+            std::size_t         sample_period_;
+        };
+
+        /// \returns A new \ref latency_tracked_allocator created by forwarding the parameters to the constructor.
+        /// \relates latency_tracked_allocator
+        template <class RawAllocator>
+        auto make_latency_tracked_allocator(allocation_latency& latency, std::size_t sample_period,
+                                            RawAllocator&& allocator)
+            -> latency_tracked_allocator<typename std::decay<RawAllocator>::type>
+        {
+            return latency_tracked_allocator<
+                typename std::decay<RawAllocator>::type>{latency, sample_period,
+                                                         detail::forward<RawAllocator>(allocator)};
+        }
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_LATENCY_TRACKING_HPP_INCLUDED
@@ -0,0 +1,268 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_LIFETIME_ROUTER_HPP_INCLUDED
+#define FOONATHAN_MEMORY_LIFETIME_ROUTER_HPP_INCLUDED
+
+/// \file
+/// Class template \ref foonathan::memory::lifetime_router.
+
+#include "detail/ebo_storage.hpp"
+#include "detail/utility.hpp"
+#include "allocator_traits.hpp"
+#include "config.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// A \concept{concept_rawallocator,RawAllocator} that sends each allocation to one of three allocators
+        /// depending on its \ref lifetime_hint.
+        /// Keeping nodes of different lifetimes apart prevents a few long living nodes from pinning the memory of many short living ones,
+        /// e.g. a \ref memory_pool for \c ShortLived nodes can reuse them right away,
+        /// while a \ref memory_stack for \c Permanent nodes never needs to deallocate.
+        /// Allocations without a hint are short lived.
+        /// A deallocation without a hint first tries `ShortLived`, then `LongLived`, and uses `Permanent` if both fail.
+        /// \requires `ShortLived` and `LongLived` must be composable \concept{concept_rawallocator,RawAllocators},
+        /// `Permanent` must be a \concept{concept_rawallocator,RawAllocator}.
+        /// \ingroup adapter
+        template <class ShortLived, class LongLived, class Permanent>
+        class lifetime_router
+        : FOONATHAN_EBO(
+              detail::ebo_storage<0, typename allocator_traits<ShortLived>::allocator_type>),
+          FOONATHAN_EBO(
+              detail::ebo_storage<1, typename allocator_traits<LongLived>::allocator_type>),
+          FOONATHAN_EBO(
+              detail::ebo_storage<2, typename allocator_traits<Permanent>::allocator_type>)
+        {
+            using short_traits            = allocator_traits<ShortLived>;
+            using short_composable_traits = composable_allocator_traits<ShortLived>;
+            using long_traits             = allocator_traits<LongLived>;
+            using long_composable_traits  = composable_allocator_traits<LongLived>;
+            using permanent_traits        = allocator_traits<Permanent>;
+
+        public:
+            using short_lived_allocator_type = typename short_traits::allocator_type;
+            using long_lived_allocator_type  = typename long_traits::allocator_type;
+            using permanent_allocator_type   = typename permanent_traits::allocator_type;
+
+            using is_stateful =
+                std::integral_constant<bool, short_traits::is_stateful::value
+                                                 || long_traits::is_stateful::value
+                                                 || permanent_traits::is_stateful::value>;
+
+            /// \effects Default constructs all allocators.
+            /// \notes This function only participates in overload resolution, if no allocator is stateful.
+            FOONATHAN_ENABLE_IF(!is_stateful::value)
+            lifetime_router()
+            : detail::ebo_storage<0, short_lived_allocator_type>({}),
+              detail::ebo_storage<1, long_lived_allocator_type>({}),
+              detail::ebo_storage<2, permanent_allocator_type>({})
+            {
+            }
+
+            /// \effects Constructs the allocator by passing in the three allocators it has.
+            lifetime_router(short_lived_allocator_type&& short_lived,
+                            long_lived_allocator_type&&  long_lived,
+                            permanent_allocator_type&&   permanent)
+            : detail::ebo_storage<0, short_lived_allocator_type>(detail::move(short_lived)),
+              detail::ebo_storage<1, long_lived_allocator_type>(detail::move(long_lived)),
+              detail::ebo_storage<2, permanent_allocator_type>(detail::move(permanent))
+            {
+            }
+
+            /// @{
+            /// \effects Allocates from the allocator for the given \ref lifetime_hint.
+            void* allocate_node(std::size_t size, std::size_t alignment, lifetime_hint hint)
+            {
+                switch (hint)
+                {
+                case lifetime_hint::short_lived:
+                    break;
+                case lifetime_hint::long_lived:
+                    return long_traits::allocate_node(get_long_lived_allocator(), size, alignment);
+                case lifetime_hint::permanent:
+                    return permanent_traits::allocate_node(get_permanent_allocator(), size,
+                                                           alignment);
+                }
+                return short_traits::allocate_node(get_short_lived_allocator(), size, alignment);
+            }
+
+            void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment,
+                                 lifetime_hint hint)
+            {
+                switch (hint)
+                {
+                case lifetime_hint::short_lived:
+                    break;
+                case lifetime_hint::long_lived:
+                    return long_traits::allocate_array(get_long_lived_allocator(), count, size,
+                                                       alignment);
+                case lifetime_hint::permanent:
+                    return permanent_traits::allocate_array(get_permanent_allocator(), count, size,
+                                                            alignment);
+                }
+                return short_traits::allocate_array(get_short_lived_allocator(), count, size,
+                                                    alignment);
+            }
+            /// @}
+
+            /// @{
+            /// \effects Deallocates with the allocator for the given \ref lifetime_hint,
+            /// which must be the same one as during the allocation.
+            void deallocate_node(void* ptr, std::size_t size, std::size_t alignment,
+                                 lifetime_hint hint) noexcept
+            {
+                switch (hint)
+                {
+                case lifetime_hint::short_lived:
+                    break;
+                case lifetime_hint::long_lived:
+                    long_traits::deallocate_node(get_long_lived_allocator(), ptr, size, alignment);
+                    return;
+                case lifetime_hint::permanent:
+                    permanent_traits::deallocate_node(get_permanent_allocator(), ptr, size,
+                                                      alignment);
+                    return;
+                }
+                short_traits::deallocate_node(get_short_lived_allocator(), ptr, size, alignment);
+            }
+
+            void deallocate_array(void* ptr, std::size_t count, std::size_t size,
+                                  std::size_t alignment, lifetime_hint hint) noexcept
+            {
+                switch (hint)
+                {
+                case lifetime_hint::short_lived:
+                    break;
+                case lifetime_hint::long_lived:
+                    long_traits::deallocate_array(get_long_lived_allocator(), ptr, count, size,
+                                                  alignment);
+                    return;
+                case lifetime_hint::permanent:
+                    permanent_traits::deallocate_array(get_permanent_allocator(), ptr, count, size,
+                                                       alignment);
+                    return;
+                }
+                short_traits::deallocate_array(get_short_lived_allocator(), ptr, count, size,
+                                               alignment);
+            }
+            /// @}
+
+            /// @{
+            /// \effects Allocates a short lived node or array.
+            void* allocate_node(std::size_t size, std::size_t alignment)
+            {
+                return short_traits::allocate_node(get_short_lived_allocator(), size, alignment);
+            }
+
+            void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+            {
+                return short_traits::allocate_array(get_short_lived_allocator(), count, size,
+                                                    alignment);
+            }
+            /// @}
+
+            /// @{
+            /// \effects First calls the compositioning deallocation function on the `short_lived_allocator_type`,
+            /// then on the `long_lived_allocator_type`.
+            /// If both fail, uses the non-compositioning function of the `permanent_allocator_type`.
+            void deallocate_node(void* ptr, std::size_t size, std::size_t alignment) noexcept
+            {
+                if (short_composable_traits::try_deallocate_node(get_short_lived_allocator(), ptr,
+                                                                 size, alignment))
+                    return;
+                if (long_composable_traits::try_deallocate_node(get_long_lived_allocator(), ptr,
+                                                                size, alignment))
+                    return;
+                permanent_traits::deallocate_node(get_permanent_allocator(), ptr, size, alignment);
+            }
+
+            void deallocate_array(void* ptr, std::size_t count, std::size_t size,
+                                  std::size_t alignment) noexcept
+            {
+                if (short_composable_traits::try_deallocate_array(get_short_lived_allocator(), ptr,
+                                                                  count, size, alignment))
+                    return;
+                if (long_composable_traits::try_deallocate_array(get_long_lived_allocator(), ptr,
+                                                                 count, size, alignment))
+                    return;
+                permanent_traits::deallocate_array(get_permanent_allocator(), ptr, count, size,
+                                                   alignment);
+            }
+            /// @}
+
+            /// @{
+            /// \returns The maximum of the values from all three allocators.
+            std::size_t max_node_size() const
+            {
+                return max(short_traits::max_node_size(get_short_lived_allocator()),
+                           long_traits::max_node_size(get_long_lived_allocator()),
+                           permanent_traits::max_node_size(get_permanent_allocator()));
+            }
+
+            std::size_t max_array_size() const
+            {
+                return max(short_traits::max_array_size(get_short_lived_allocator()),
+                           long_traits::max_array_size(get_long_lived_allocator()),
+                           permanent_traits::max_array_size(get_permanent_allocator()));
+            }
+
+            std::size_t max_alignment() const
+            {
+                return max(short_traits::max_alignment(get_short_lived_allocator()),
+                           long_traits::max_alignment(get_long_lived_allocator()),
+                           permanent_traits::max_alignment(get_permanent_allocator()));
+            }
+            /// @}
+
+            /// @{
+            /// \returns A (`const`) reference to the allocator for short lived nodes.
+            short_lived_allocator_type& get_short_lived_allocator() noexcept
+            {
+                return detail::ebo_storage<0, short_lived_allocator_type>::get();
+            }
+
+            const short_lived_allocator_type& get_short_lived_allocator() const noexcept
+            {
+                return detail::ebo_storage<0, short_lived_allocator_type>::get();
+            }
+            /// @}
+
+            /// @{
+            /// \returns A (`const`) reference to the allocator for long lived nodes.
+            long_lived_allocator_type& get_long_lived_allocator() noexcept
+            {
+                return detail::ebo_storage<1, long_lived_allocator_type>::get();
+            }
+
+            const long_lived_allocator_type& get_long_lived_allocator() const noexcept
+            {
+                return detail::ebo_storage<1, long_lived_allocator_type>::get();
+            }
+            /// @}
+
+            /// @{
+            /// \returns A (`const`) reference to the allocator for permanent nodes.
+            permanent_allocator_type& get_permanent_allocator() noexcept
+            {
+                return detail::ebo_storage<2, permanent_allocator_type>::get();
+            }
+
+            const permanent_allocator_type& get_permanent_allocator() const noexcept
+            {
+                return detail::ebo_storage<2, permanent_allocator_type>::get();
+            }
+            /// @}
+
+        private:
+            static std::size_t max(std::size_t a, std::size_t b, std::size_t c) noexcept
+            {
+                auto ab = a > b ? a : b;
+                return ab > c ? ab : c;
+            }
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_LIFETIME_ROUTER_HPP_INCLUDED
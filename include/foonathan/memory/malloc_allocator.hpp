@@ -34,20 +34,16 @@ namespace foonathan
             {
                 static allocator_info info() noexcept;
 
-                static void* allocate(std::size_t size, std::size_t) noexcept
-                {
-                    return std::malloc(size);
-                }
+                static void* allocate(std::size_t size, std::size_t alignment) noexcept;
 
-                static void deallocate(void* ptr, std::size_t, std::size_t) noexcept
-                {
-                    std::free(ptr);
-                }
+                static void deallocate(void* ptr, std::size_t size, std::size_t alignment) noexcept;
 
                 static std::size_t max_node_size() noexcept
                 {
                     return std::allocator_traits<std::allocator<char>>::max_size({});
                 }
+
+                static std::size_t max_alignment() noexcept;
             };
 
             FOONATHAN_MEMORY_LL_ALLOCATOR_LEAK_CHECKER(malloc_allocator_impl,
@@ -55,6 +51,8 @@ namespace foonathan
         } // namespace detail
 
         /// A stateless \concept{concept_rawallocator,RawAllocator} that allocates memory using <tt>std::malloc()</tt>.
+        /// Over-aligned memory is allocated with <tt>posix_memalign()</tt> or <tt>_aligned_malloc()</tt>, if available,
+        /// and the sized deallocation functions of C23 are used if the C library provides them.
         /// It throws \ref out_of_memory when the allocation fails.
         /// \ingroup allocator
         using malloc_allocator =
@@ -7,10 +7,13 @@
 /// \file
 /// Class \ref foonathan::memory::memory_arena and related functionality regarding \concept{concept_blockallocator,BlockAllocators}.
 
+#include <cstring>
 #include <type_traits>
 
+#include "detail/align.hpp"
 #include "detail/debug_helpers.hpp"
 #include "detail/assert.hpp"
+#include "detail/tracepoint.hpp"
 #include "detail/utility.hpp"
 #include "allocator_traits.hpp"
 #include "config.hpp"
@@ -64,6 +67,58 @@ namespace foonathan
 
             template <typename T>
             std::false_type is_block_allocator_impl(short);
+
+            // alignment of all blocks of a BlockAllocator,
+            // it can promise more than the maximum alignment with a block_alignment() function
+            template <class BlockAllocator>
+            auto block_alignment(int, const BlockAllocator& alloc) noexcept
+                -> decltype(std::size_t(alloc.block_alignment()))
+            {
+                return alloc.block_alignment();
+            }
+
+            template <class BlockAllocator>
+            std::size_t block_alignment(short, const BlockAllocator&) noexcept
+            {
+                return max_alignment;
+            }
+
+            // whether the last block of a BlockAllocator is known to be zeroed,
+            // it can report it with a last_block_zeroed() function
+            template <class BlockAllocator>
+            auto last_block_zeroed(int, const BlockAllocator& alloc) noexcept
+                -> decltype(bool(alloc.last_block_zeroed()))
+            {
+                return alloc.last_block_zeroed();
+            }
+
+            template <class BlockAllocator>
+            bool last_block_zeroed(short, const BlockAllocator&) noexcept
+            {
+                return false;
+            }
+
+            // a BlockAllocator can allocate the memory of multiple blocks at once
+            // with an allocate_blocks() function
+            template <class BlockAllocator>
+            auto allocate_blocks(int, BlockAllocator& alloc, std::size_t n)
+                -> decltype(memory_block(alloc.allocate_blocks(n)))
+            {
+                return alloc.allocate_blocks(n);
+            }
+
+            template <class BlockAllocator>
+            memory_block allocate_blocks(short, BlockAllocator& alloc, std::size_t)
+            {
+                return alloc.allocate_block();
+            }
+
+            template <class BlockAllocator>
+            auto has_allocate_blocks(int)
+                -> decltype(std::declval<BlockAllocator&>().allocate_blocks(1u), std::true_type{});
+
+            template <class BlockAllocator>
+            std::false_type has_allocate_blocks(short);
         } // namespace detail
 
         /// Traits that check whether a type models concept \concept{concept_blockallocator,BlockAllocator}.
@@ -90,6 +145,69 @@ namespace foonathan
         constexpr bool uncached_arena = false;
         /// @}
 
+        /// The limits of the cache of a \ref memory_arena.
+        /// If deallocating a block makes the cache exceed one of them,
+        /// cached blocks are returned to the \concept{concept_blockallocator,BlockAllocator} until it is within them again.
+        /// \ingroup core
+        struct arena_cache_limits
+        {
+            /// The maximal number of cached blocks.
+            std::size_t max_blocks;
+
+            /// The maximal total size of the cached blocks in bytes.
+            std::size_t max_bytes;
+
+            /// \effects Creates it giving it the maximal number of blocks and bytes.
+            /// By default, the cache is not limited.
+            constexpr arena_cache_limits(std::size_t max_blocks = std::size_t(-1),
+                                         std::size_t max_bytes  = std::size_t(-1)) noexcept
+            : max_blocks(max_blocks), max_bytes(max_bytes)
+            {
+            }
+        };
+
+        /// The memory usage of an allocator as returned by its \c stats() function,
+        /// e.g. \ref memory_pool::stats() or \ref memory_stack::stats().
+        /// The memory of the blocks in use is split up such that
+        /// <tt>committed_bytes == used_bytes + free_listed_bytes + unused_bytes + wasted_bytes</tt>.
+        /// \ingroup core
+        struct memory_stats
+        {
+            /// The total size of the blocks owned, including the cached ones.
+            std::size_t reserved_bytes = 0u;
+
+            /// The total size of the blocks in use, i.e. without the cached ones.
+            std::size_t committed_bytes = 0u;
+
+            /// The size of the memory handed out, including the rounding to the node size.
+            std::size_t used_bytes = 0u;
+
+            /// The size of the memory on free lists that can be allocated again.
+            std::size_t free_listed_bytes = 0u;
+
+            /// The size of the memory in the blocks that has never been handed out yet.
+            std::size_t unused_bytes = 0u;
+
+            /// The size of the memory lost to bookkeeping, alignment and rounding.
+            std::size_t wasted_bytes = 0u;
+
+            /// The number of blocks in use.
+            std::size_t blocks = 0u;
+
+            /// The number of cached blocks.
+            std::size_t cached_blocks = 0u;
+        };
+
+        /// \effects Requests all \ref memory_arena objects of the process to purge their cache,
+        /// e.g. when the system is low on memory.
+        /// As an arena is not thread-safe, it cannot be trimmed by another thread directly.
+        /// Instead, each arena purges its cache the next time it allocates or deallocates a block,
+        /// so an arena that is no longer used keeps its cache until then.
+        /// Does nothing for arenas with caching disabled.
+        /// \note This function is thread-safe and can be called at any time.
+        /// \ingroup core
+        void trim_arena_caches() noexcept;
+
         namespace detail
         {
             // stores memory block in an intrusive linked list and allows LIFO access
@@ -140,6 +258,10 @@ namespace foonathan
                 // steals the top block from another stack
                 void steal_top(memory_block_stack& other) noexcept;
 
+                // moves the block whose inserted memory starts at memory to the top
+                // pre: the block is in the stack
+                void move_to_top(const void* memory) noexcept;
+
                 // returns the last pushed() inserted memory block
                 inserted_mb top() const noexcept
                 {
@@ -158,6 +280,18 @@ namespace foonathan
                 // O(n) size
                 std::size_t size() const noexcept;
 
+                // calls f with each inserted memory block, starting at the top
+                template <typename Func>
+                void for_each(Func f) const
+                {
+                    for (auto cur = head_; cur; cur = cur->prev)
+                    {
+                        auto mem = static_cast<void*>(cur);
+                        f(inserted_mb{static_cast<char*>(mem) + implementation_offset(),
+                                      cur->usable_size});
+                    }
+                }
+
             private:
                 struct node
                 {
@@ -173,10 +307,38 @@ namespace foonathan
             template <bool Cached>
             class memory_arena_cache;
 
+            // the number of calls to trim_arena_caches()
+            std::size_t arena_trim_epoch() noexcept;
+
             template <>
             class memory_arena_cache<cached_arena>
             {
             protected:
+                memory_arena_cache() noexcept
+                : cached_count_(0u), cached_bytes_(0u), trim_epoch_(arena_trim_epoch())
+                {
+                }
+
+                memory_arena_cache(memory_arena_cache&& other) noexcept
+                : cached_(detail::move(other.cached_)),
+                  limits_(other.limits_),
+                  cached_count_(other.cached_count_),
+                  cached_bytes_(other.cached_bytes_),
+                  trim_epoch_(other.trim_epoch_)
+                {
+                    other.cached_count_ = 0u;
+                    other.cached_bytes_ = 0u;
+                }
+
+                friend void swap(memory_arena_cache& a, memory_arena_cache& b) noexcept
+                {
+                    detail::adl_swap(a.cached_, b.cached_);
+                    detail::adl_swap(a.limits_, b.limits_);
+                    detail::adl_swap(a.cached_count_, b.cached_count_);
+                    detail::adl_swap(a.cached_bytes_, b.cached_bytes_);
+                    detail::adl_swap(a.trim_epoch_, b.trim_epoch_);
+                }
+
                 bool cache_empty() const noexcept
                 {
                     return cached_.empty();
@@ -184,7 +346,7 @@ namespace foonathan
 
                 std::size_t cache_size() const noexcept
                 {
-                    return cached_.size();
+                    return cached_count_;
                 }
 
                 std::size_t cached_block_size() const noexcept
@@ -192,18 +354,46 @@ namespace foonathan
                     return cached_.top().size;
                 }
 
-                bool take_from_cache(detail::memory_block_stack& used) noexcept
+                std::size_t cached_bytes() const noexcept
+                {
+                    return cached_bytes_;
+                }
+
+                const arena_cache_limits& cache_limits() const noexcept
                 {
+                    return limits_;
+                }
+
+                template <class BlockAllocator>
+                void set_cache_limits(BlockAllocator&           alloc,
+                                      const arena_cache_limits& limits) noexcept
+                {
+                    limits_ = limits;
+                    trim_cache(alloc);
+                }
+
+                template <class BlockAllocator>
+                bool take_from_cache(BlockAllocator&             alloc,
+                                     detail::memory_block_stack& used) noexcept
+                {
+                    check_trim(alloc);
                     if (cached_.empty())
                         return false;
+                    --cached_count_;
+                    cached_bytes_ -= allocated_size(cached_);
                     used.steal_top(cached_);
                     return true;
                 }
 
                 template <class BlockAllocator>
-                void do_deallocate_block(BlockAllocator&, detail::memory_block_stack& used) noexcept
+                void do_deallocate_block(BlockAllocator&             alloc,
+                                         detail::memory_block_stack& used) noexcept
                 {
+                    check_trim(alloc);
+                    ++cached_count_;
+                    cached_bytes_ += allocated_size(used);
                     cached_.steal_top(used);
+                    trim_cache(alloc);
                 }
 
                 template <class BlockAllocator>
@@ -217,10 +407,52 @@ namespace foonathan
                     // now dealloc everything
                     while (!to_dealloc.empty())
                         alloc.deallocate_block(to_dealloc.pop());
+                    cached_count_ = 0u;
+                    cached_bytes_ = 0u;
                 }
 
             private:
+                static std::size_t allocated_size(const detail::memory_block_stack& stack) noexcept
+                {
+                    return stack.top().size + detail::memory_block_stack::implementation_offset();
+                }
+
+                template <class BlockAllocator>
+                void check_trim(BlockAllocator& alloc) noexcept
+                {
+                    auto epoch = arena_trim_epoch();
+                    if (epoch != trim_epoch_)
+                    {
+                        trim_epoch_ = epoch;
+                        do_shrink_to_fit(alloc);
+                    }
+                }
+
+                // deallocates cached blocks until the cache is within the limits
+                // like do_shrink_to_fit() it starts with the most recently allocated block,
+                // as some BlockAllocators require deallocation in reversed order
+                template <class BlockAllocator>
+                void trim_cache(BlockAllocator& alloc) noexcept
+                {
+                    if (cached_count_ <= limits_.max_blocks && cached_bytes_ <= limits_.max_bytes)
+                        return;
+
+                    detail::memory_block_stack reversed;
+                    while (!cached_.empty())
+                        reversed.steal_top(cached_);
+                    while (cached_count_ > limits_.max_blocks || cached_bytes_ > limits_.max_bytes)
+                    {
+                        --cached_count_;
+                        cached_bytes_ -= allocated_size(reversed);
+                        alloc.deallocate_block(reversed.pop());
+                    }
+                    while (!reversed.empty())
+                        cached_.steal_top(reversed);
+                }
+
                 detail::memory_block_stack cached_;
+                arena_cache_limits         limits_;
+                std::size_t                cached_count_, cached_bytes_, trim_epoch_;
             };
 
             template <>
@@ -242,7 +474,23 @@ namespace foonathan
                     return 0u;
                 }
 
-                bool take_from_cache(detail::memory_block_stack&) noexcept
+                std::size_t cached_bytes() const noexcept
+                {
+                    return 0u;
+                }
+
+                arena_cache_limits cache_limits() const noexcept
+                {
+                    return {0u, 0u};
+                }
+
+                template <class BlockAllocator>
+                void set_cache_limits(BlockAllocator&, const arena_cache_limits&) noexcept
+                {
+                }
+
+                template <class BlockAllocator>
+                bool take_from_cache(BlockAllocator&, detail::memory_block_stack&) noexcept
                 {
                     return false;
                 }
@@ -298,7 +546,7 @@ namespace foonathan
             /// \throws Anything thrown by the constructor of the \c BlockAllocator.
             template <typename... Args>
             explicit memory_arena(std::size_t block_size, Args&&... args)
-            : allocator_type(block_size, detail::forward<Args>(args)...)
+            : allocator_type(block_size, detail::forward<Args>(args)...), last_zeroed_(false)
             {
                 FOONATHAN_MEMORY_ASSERT(block_size > min_block_size(0));
             }
@@ -310,7 +558,11 @@ namespace foonathan
                 shrink_to_fit();
                 // now deallocate everything
                 while (!used_.empty())
-                    allocator_type::deallocate_block(used_.pop());
+                {
+                    auto block = used_.pop();
+                    detail::debug_unpoison(block.memory, block.size);
+                    allocator_type::deallocate_block(block);
+                }
             }
 
             /// @{
@@ -321,7 +573,8 @@ namespace foonathan
             memory_arena(memory_arena&& other) noexcept
             : allocator_type(detail::move(other)),
               cache(detail::move(other)),
-              used_(detail::move(other.used_))
+              used_(detail::move(other.used_)),
+              last_zeroed_(other.last_zeroed_)
             {
             }
 
@@ -340,6 +593,7 @@ namespace foonathan
                 detail::adl_swap(static_cast<allocator_type&>(a), static_cast<allocator_type&>(b));
                 detail::adl_swap(static_cast<cache&>(a), static_cast<cache&>(b));
                 detail::adl_swap(a.used_, b.used_);
+                detail::adl_swap(a.last_zeroed_, b.last_zeroed_);
             }
 
             /// \effects Allocates a new memory block.
@@ -349,14 +603,74 @@ namespace foonathan
             /// \throws Anything thrown by the \concept{concept_blockallocator,BlockAllocator} allocation function.
             memory_block allocate_block()
             {
-                if (!this->take_from_cache(used_))
+                last_zeroed_ = false;
+                if (this->take_from_cache(get_allocator(), used_))
+                {
+                    FOONATHAN_MEMORY_TRACE2(arena_cache_hit, this, used_.top().size);
+                }
+                else
+                {
+                    FOONATHAN_MEMORY_TRACE1(arena_cache_miss, this);
                     used_.push(allocator_type::allocate_block());
+                    // debug filling writes to the block
+                    last_zeroed_ = !FOONATHAN_MEMORY_DEBUG_FILL
+                                   && detail::last_block_zeroed(0, get_allocator());
+                }
+
+                auto block = used_.top();
+                FOONATHAN_MEMORY_TRACE3(arena_block_acquire, this, block.memory, block.size);
+                detail::debug_fill_internal(block.memory, block.size, false);
+                return block;
+            }
+
+            /// \effects Allocates a new memory block for the memory of \c n blocks at once.
+            /// If the \concept{concept_blockallocator,BlockAllocator} has an \c allocate_blocks() function,
+            /// like \ref growing_block_allocator and \ref virtual_block_allocator,
+            /// and \c n is bigger than one, it returns a single block of \c n times its \c next_block_size() with one allocation,
+            /// ignoring the cache.
+            /// Otherwise, it is the same as \ref allocate_block() and the caller needs to allocate the rest.
+            /// \returns The new \ref memory_block, it is deallocated like any other block.
+            /// \throws Anything thrown by the \concept{concept_blockallocator,BlockAllocator} allocation function.
+            memory_block allocate_blocks(std::size_t n)
+            {
+                using native = decltype(detail::has_allocate_blocks<allocator_type>(0));
+                if (!native::value || n <= 1u)
+                    return allocate_block();
+
+                last_zeroed_ = false;
+                used_.push(detail::allocate_blocks(0, get_allocator(), n));
+                last_zeroed_ =
+                    !FOONATHAN_MEMORY_DEBUG_FILL && detail::last_block_zeroed(0, get_allocator());
 
                 auto block = used_.top();
+                FOONATHAN_MEMORY_TRACE3(arena_block_acquire, this, block.memory, block.size);
                 detail::debug_fill_internal(block.memory, block.size, false);
                 return block;
             }
 
+            /// \effects Allocates a new memory block like \ref allocate_block(),
+            /// but always from the \concept{concept_blockallocator,BlockAllocator} and without filling it with debug values.
+            /// It is meant to restore an arena from a \concept{concept_blockallocator,BlockAllocator}
+            /// whose blocks keep their contents, like \ref mmap_block_allocator.
+            /// \returns The new \ref memory_block.
+            /// \throws Anything thrown by the \concept{concept_blockallocator,BlockAllocator} allocation function.
+            /// \note The beginning of the block returned by the \concept{concept_blockallocator,BlockAllocator}
+            /// is still overwritten with the bookkeeping of the arena, which is not part of the returned block.
+            memory_block restore_block()
+            {
+                last_zeroed_ = false;
+                used_.push(allocator_type::allocate_block());
+                return used_.top();
+            }
+
+            /// \returns Whether or not all bytes of the block returned by the last call to \ref allocate_block() are zero.
+            /// This is only the case for a new block of a \concept{concept_blockallocator,BlockAllocator} reporting it
+            /// through a \c last_block_zeroed() function, not for cached blocks or if debug filling is enabled.
+            bool last_block_zeroed() const noexcept
+            {
+                return last_zeroed_;
+            }
+
             /// \returns The current memory block.
             /// This is the memory block that will be deallocated by the next call to \ref deallocate_block().
             memory_block current_block() const noexcept
@@ -367,28 +681,68 @@ namespace foonathan
             /// \effects Deallocates the current memory block.
             /// The current memory block is the block on top of the stack of blocks.
             /// If caching is enabled, it does not really deallocate it but puts it onto a cache for later use,
+            /// unless that would exceed the limits set by \ref set_cache_limits(),
             /// use \ref shrink_to_fit() to purge that cache.
             void deallocate_block() noexcept
             {
                 auto block = used_.top();
+                FOONATHAN_MEMORY_TRACE3(arena_block_release, this, block.memory, block.size);
+                // the allocator using the block might have poisoned parts of it
+                detail::debug_unpoison(block.memory, block.size);
                 detail::debug_fill_internal(block.memory, block.size, true);
                 this->do_deallocate_block(get_allocator(), used_);
             }
 
+            /// \effects Deallocates the given memory block like \ref deallocate_block(),
+            /// but it does not need to be the current memory block.
+            /// \requires \c block must have been returned by \ref allocate_block() and not deallocated since,
+            /// and the \concept{concept_blockallocator,BlockAllocator} must allow deallocating its blocks in any order,
+            /// which is not the case for \ref static_block_allocator and \ref virtual_block_allocator.
+            void deallocate_block(memory_block block) noexcept
+            {
+                used_.move_to_top(block.memory);
+                deallocate_block();
+            }
+
             /// \returns If `ptr` is in memory owned by the arena.
             bool owns(const void* ptr) const noexcept
             {
                 return used_.owns(ptr);
             }
 
+            /// \effects Calls \c f with each memory block in use, starting with the current memory block,
+            /// i.e. in reversed order of allocation.
+            /// \requires \c f must not allocate or deallocate blocks of the arena.
+            template <typename Func>
+            void for_each_block(Func f) const
+            {
+                used_.for_each(f);
+            }
+
             /// \effects Purges the cache of unused memory blocks by returning them.
             /// The memory blocks will be deallocated in reversed order of allocation.
             /// Does nothing if caching is disabled.
             void shrink_to_fit() noexcept
             {
+                FOONATHAN_MEMORY_TRACE2(arena_shrink_to_fit, this, this->cache_size());
                 this->do_shrink_to_fit(get_allocator());
             }
 
+            /// \effects Sets the limits of the cache and deallocates cached blocks until it is within them,
+            /// in the same order as \ref shrink_to_fit().
+            /// Does nothing if caching is disabled.
+            void set_cache_limits(const arena_cache_limits& limits) noexcept
+            {
+                cache::set_cache_limits(get_allocator(), limits);
+            }
+
+            /// \returns The limits of the cache,
+            /// which are zero if caching is disabled.
+            arena_cache_limits cache_limits() const noexcept
+            {
+                return cache::cache_limits();
+            }
+
             /// \returns The capacity of the arena, i.e. how many blocks are used and cached.
             std::size_t capacity() const noexcept
             {
@@ -408,6 +762,25 @@ namespace foonathan
                 return used_.size();
             }
 
+            /// \returns The memory usage of the arena.
+            /// The usable memory of the blocks in use counts as \c used_bytes,
+            /// the part of the blocks needed for the arena as \c wasted_bytes.
+            /// \note This walks all blocks in use.
+            memory_stats stats() const noexcept
+            {
+                memory_stats result;
+                used_.for_each([&](memory_block block) {
+                    ++result.blocks;
+                    result.used_bytes += block.size;
+                });
+                result.wasted_bytes =
+                    result.blocks * detail::memory_block_stack::implementation_offset();
+                result.committed_bytes = result.used_bytes + result.wasted_bytes;
+                result.reserved_bytes  = result.committed_bytes + this->cached_bytes();
+                result.cached_blocks   = cache_size();
+                return result;
+            }
+
             /// \returns The size of the next memory block,
             /// i.e. of the next call to \ref allocate_block().
             /// If there are blocks in the cache, returns size of the next one.
@@ -420,6 +793,7 @@ namespace foonathan
                            this->cached_block_size();
             }
 
+            /// @{
             /// \returns A reference of the \concept{concept_blockallocator,BlockAllocator} object.
             /// \requires It is undefined behavior to move this allocator out into another object.
             allocator_type& get_allocator() noexcept
@@ -427,8 +801,15 @@ namespace foonathan
                 return *this;
             }
 
+            const allocator_type& get_allocator() const noexcept
+            {
+                return *this;
+            }
+            /// @}
+
         private:
             detail::memory_block_stack used_;
+            bool                       last_zeroed_;
         };
 
 #if FOONATHAN_MEMORY_EXTERN_TEMPLATE
@@ -485,6 +866,20 @@ namespace foonathan
                                          detail::max_alignment);
             }
 
+            /// \effects Allocates the memory of \c n blocks of the size \ref next_block_size() as one block
+            /// with a single allocation and increases the block size like \ref allocate_block().
+            /// \returns The new \ref memory_block, it is deallocated as one block.
+            /// \throws Anything thrown by the \c allocate_array() function of the \concept{concept_rawallocator,RawAllocator}.
+            memory_block allocate_blocks(std::size_t n)
+            {
+                auto size   = n * block_size_;
+                auto memory =
+                    traits::allocate_array(get_allocator(), size, 1, detail::max_alignment);
+                memory_block block(memory, size);
+                block_size_ = grow_block_size(block_size_);
+                return block;
+            }
+
             /// \returns The size of the memory block returned by the next call to \ref allocate_block().
             std::size_t next_block_size() const noexcept
             {
@@ -552,7 +947,7 @@ namespace foonathan
                     block_size_ = 0u;
                     return block;
                 }
-                FOONATHAN_THROW(out_of_fixed_memory(info(), block_size_));
+                detail::throw_out_of_fixed_memory(info(), block_size_);
             }
 
             /// \effects Deallocates the previously allocated memory block.
@@ -593,6 +988,136 @@ namespace foonathan
         extern template class memory_arena<fixed_block_allocator<>, false>;
 #endif
 
+        /// The runtime growth policy of an \ref adaptive_block_allocator.
+        /// \ingroup adapter
+        struct block_growth_policy
+        {
+            /// The upper limit of the size of a memory block.
+            std::size_t max_block_size;
+
+            /// The factor by which the block size grows after each allocation,
+            /// as long as the blocks in use keep up with it.
+            float growth_factor;
+
+            /// \effects Creates it giving it the maximal block size and the growth factor.
+            /// By default, the block size is not limited and grows by a factor of \c 2.
+            /// \requires \c growth_factor must be at least \c 1.
+            constexpr block_growth_policy(std::size_t max_block_size = std::size_t(-1),
+                                          float       growth_factor  = 2.f) noexcept
+            : max_block_size(max_block_size), growth_factor(growth_factor)
+            {
+            }
+        };
+
+        /// A \concept{concept_blockallocator,BlockAllocator} that uses a given \concept{concept_rawallocator,RawAllocator} for allocating the blocks,
+        /// whose block size follows the amount of memory currently in use.
+        /// Like \ref growing_block_allocator, the size of the next memory block grows by the factor of the \ref block_growth_policy after each allocation,
+        /// but it never exceeds the total size of the blocks currently in use nor the maximal block size of the policy.
+        /// So the more blocks are needed in a short time, the faster the block size grows.
+        /// After \ref deallocate_block() the block size shrinks back to the size of the blocks still in use,
+        /// but never below the initial block size.
+        /// This keeps the higher level allocator close to its working set after a burst of allocations,
+        /// instead of allocating ever-larger blocks.
+        /// \note A \ref memory_arena with caching only deallocates blocks in \c shrink_to_fit() or its destructor.
+        /// \ingroup adapter
+        template <class RawAllocator = default_allocator>
+        class adaptive_block_allocator
+        : FOONATHAN_EBO(allocator_traits<RawAllocator>::allocator_type)
+        {
+            using traits = allocator_traits<RawAllocator>;
+
+        public:
+            using allocator_type = typename traits::allocator_type;
+
+            /// \effects Creates it by giving it the initial block size, the growth policy and the allocator object.
+            /// \requires \c block_size must be greater than 0 and not greater than the maximal block size of the policy,
+            /// and the growth factor of the policy must be at least \c 1.
+            explicit adaptive_block_allocator(
+                std::size_t block_size, block_growth_policy policy = {},
+                allocator_type alloc = allocator_type()) noexcept
+            : allocator_type(detail::move(alloc)),
+              policy_(policy),
+              min_block_size_(block_size),
+              block_size_(block_size),
+              used_size_(0u)
+            {
+                FOONATHAN_MEMORY_ASSERT(block_size > 0u && block_size <= policy.max_block_size);
+                FOONATHAN_MEMORY_ASSERT(policy.growth_factor >= 1.f);
+            }
+
+            /// \effects Allocates a new memory block and adjusts the block size for the next allocation.
+            /// \returns The new \ref memory_block.
+            /// \throws Anything thrown by the \c allocate_array() function of the \concept{concept_rawallocator,RawAllocator}.
+            memory_block allocate_block()
+            {
+                auto memory =
+                    traits::allocate_array(get_allocator(), block_size_, 1, detail::max_alignment);
+                memory_block block(memory, block_size_);
+                used_size_ += block_size_;
+
+                auto grown = float(block_size_) * policy_.growth_factor;
+                update_block_size(grown < float(policy_.max_block_size) ? std::size_t(grown)
+                                                                        : policy_.max_block_size);
+                return block;
+            }
+
+            /// \effects Deallocates a previously allocated memory block
+            /// and shrinks the block size to the size of the blocks still in use, if that is smaller.
+            /// \requires \c block must be previously returned by a call to \ref allocate_block().
+            void deallocate_block(memory_block block) noexcept
+            {
+                traits::deallocate_array(get_allocator(), block.memory, block.size, 1,
+                                         detail::max_alignment);
+                FOONATHAN_MEMORY_ASSERT(used_size_ >= block.size);
+                used_size_ -= block.size;
+                update_block_size(block_size_);
+            }
+
+            /// \returns The size of the memory block returned by the next call to \ref allocate_block().
+            std::size_t next_block_size() const noexcept
+            {
+                return block_size_;
+            }
+
+            /// \returns The total size of the memory blocks currently allocated.
+            std::size_t used_size() const noexcept
+            {
+                return used_size_;
+            }
+
+            /// \returns The growth policy.
+            const block_growth_policy& get_policy() const noexcept
+            {
+                return policy_;
+            }
+
+            /// \returns A reference to the used \concept{concept_rawallocator,RawAllocator} object.
+            allocator_type& get_allocator() noexcept
+            {
+                return *this;
+            }
+
+        private:
+            // clamps the size to [min_block_size_, min(used_size_, max_block_size)]
+            void update_block_size(std::size_t size) noexcept
+            {
+                if (size > used_size_)
+                    size = used_size_;
+                if (size > policy_.max_block_size)
+                    size = policy_.max_block_size;
+                block_size_ = size < min_block_size_ ? min_block_size_ : size;
+            }
+
+            block_growth_policy policy_;
+            std::size_t         min_block_size_, block_size_, used_size_;
+        };
+
+#if FOONATHAN_MEMORY_EXTERN_TEMPLATE
+        extern template class adaptive_block_allocator<>;
+        extern template class memory_arena<adaptive_block_allocator<>, true>;
+        extern template class memory_arena<adaptive_block_allocator<>, false>;
+#endif
+
         namespace detail
         {
             template <class RawAlloc>
@@ -650,6 +1175,108 @@ namespace foonathan
         }
         /// @}
 
+        /// A \concept{concept_blockallocator,BlockAllocator} adapter whose memory blocks have a given alignment,
+        /// e.g. that of a cache line or of SIMD registers.
+        /// It allocates bigger blocks from the \concept{concept_blockallocator,BlockAllocator} or \concept{concept_rawallocator,RawAllocator}
+        /// and returns the aligned part of them, the original block is stored after it.
+        /// A \ref memory_pool using it places the first node of each block at the next multiple of its node alignment,
+        /// which is the lowest set bit of the node size up to the block alignment,
+        /// so for example the nodes of a pool with 64 byte nodes are all 64 byte aligned without any padding between them.
+        /// \note The blocks of a \ref virtual_block_allocator are already page aligned, it does not need this adapter.
+        /// \ingroup adapter
+        template <class BlockOrRawAllocator = default_allocator>
+        class aligned_block_allocator : FOONATHAN_EBO(make_block_allocator_t<BlockOrRawAllocator>)
+        {
+        public:
+            using allocator_type = make_block_allocator_t<BlockOrRawAllocator>;
+
+            /// \effects Creates it by giving it the size and alignment of the memory blocks
+            /// and other arguments for the \concept{concept_blockallocator,BlockAllocator}.
+            /// Its initial block size is bigger by the alignment offset and the size of a \ref memory_block.
+            /// \requires \c alignment must be a power of two and \c block_size must be non-zero.
+            template <typename... Args>
+            aligned_block_allocator(std::size_t block_size, std::size_t alignment, Args&&... args)
+            : allocator_type(make_block_allocator<BlockOrRawAllocator>(block_size
+                                                                           + overhead(alignment),
+                                                                       detail::forward<Args>(
+                                                                           args)...)),
+              alignment_(alignment < detail::max_alignment ? detail::max_alignment : alignment)
+            {
+                FOONATHAN_MEMORY_ASSERT(detail::is_valid_alignment(alignment));
+            }
+
+            /// \effects Allocates a memory block from the \concept{concept_blockallocator,BlockAllocator}
+            /// and returns its part aligned for \ref block_alignment().
+            /// \returns The new \ref memory_block,
+            /// its size is the one of the allocated block minus the alignment offset and the size of a \ref memory_block.
+            /// \throws Anything thrown by the \concept{concept_blockallocator,BlockAllocator}.
+            memory_block allocate_block()
+            {
+                auto block = get_allocator().allocate_block();
+                FOONATHAN_MEMORY_ASSERT(block.size > overhead(alignment_));
+
+                auto offset = detail::align_offset(block.memory, alignment_);
+                FOONATHAN_MEMORY_ASSERT(offset <= overhead(alignment_) - sizeof(memory_block));
+                auto memory = static_cast<char*>(block.memory) + offset;
+                auto size   = block.size - overhead(alignment_);
+                std::memcpy(memory + size, &block, sizeof(memory_block));
+                return {memory, size};
+            }
+
+            /// \effects Deallocates a memory block returned by \ref allocate_block()
+            /// by giving the original block back to the \concept{concept_blockallocator,BlockAllocator}.
+            void deallocate_block(memory_block block) noexcept
+            {
+                memory_block original;
+                std::memcpy(&original, static_cast<char*>(block.memory) + block.size,
+                            sizeof(memory_block));
+                get_allocator().deallocate_block(original);
+            }
+
+            /// \returns The size of the memory block returned by the next call to \ref allocate_block().
+            std::size_t next_block_size() const noexcept
+            {
+                return get_allocator().next_block_size() - overhead(alignment_);
+            }
+
+            /// \returns The alignment of all memory blocks,
+            /// which is at least the maximum alignment.
+            std::size_t block_alignment() const noexcept
+            {
+                return alignment_;
+            }
+
+            /// \returns Whether or not the \concept{concept_blockallocator,BlockAllocator} reports the last block as zeroed,
+            /// the stored original block is not part of the returned one.
+            bool last_block_zeroed() const noexcept
+            {
+                return detail::last_block_zeroed(0, get_allocator());
+            }
+
+            /// @{
+            /// \returns A reference to the used \concept{concept_blockallocator,BlockAllocator} object.
+            allocator_type& get_allocator() noexcept
+            {
+                return *this;
+            }
+
+            const allocator_type& get_allocator() const noexcept
+            {
+                return *this;
+            }
+            /// @}
+
+        private:
+            // blocks of the underlying allocator only have the maximum alignment
+            static std::size_t overhead(std::size_t alignment) noexcept
+            {
+                return (alignment > detail::max_alignment ? alignment - detail::max_alignment : 0u)
+                       + sizeof(memory_block);
+            }
+
+            std::size_t alignment_;
+        };
+
         namespace literals
         {
             /// Syntax sugar to express sizes with unit prefixes.
@@ -10,6 +10,9 @@
 /// \file
 /// Class \ref foonathan::memory::memory_pool and its \ref foonathan::memory::allocator_traits specialization.
 
+#include <atomic>
+#include <cstring>
+#include <mutex>
 #include <type_traits>
 
 #include "detail/align.hpp"
@@ -17,6 +20,7 @@
 #include "detail/assert.hpp"
 #include "config.hpp"
 #include "error.hpp"
+#include "heap_allocator.hpp"
 #include "memory_arena.hpp"
 #include "memory_pool_type.hpp"
 
@@ -30,6 +34,78 @@ namespace foonathan
             {
                 void operator()(std::ptrdiff_t amount);
             };
+
+            // serializes the growth of pools with a concurrent free list
+            template <bool Concurrent>
+            class memory_pool_growth_lock
+            {
+            public:
+                memory_pool_growth_lock() noexcept = default;
+                memory_pool_growth_lock(memory_pool_growth_lock&&) noexcept {}
+
+                memory_pool_growth_lock& operator=(memory_pool_growth_lock&&) noexcept
+                {
+                    return *this;
+                }
+
+                void lock() noexcept
+                {
+                    while (flag_.test_and_set(std::memory_order_acquire))
+                    {
+                    }
+                }
+
+                void unlock() noexcept
+                {
+                    flag_.clear(std::memory_order_release);
+                }
+
+            private:
+                std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+            };
+
+            template <>
+            class memory_pool_growth_lock<false>
+            {
+            public:
+                void lock() noexcept {}
+                void unlock() noexcept {}
+            };
+
+            // per-object leak counters are not thread safe
+            template <class FreeList>
+            using memory_pool_leak_checker = typename std::conditional<
+                is_concurrent_free_list<FreeList>::value,
+                no_leak_checker<memory_pool_leak_handler>,
+                default_leak_checker<memory_pool_leak_handler>>::type;
+
+            // a memory block of a pool and the number of its free nodes
+            struct pool_block_nodes
+            {
+                memory_block block;
+                std::size_t  free_nodes, usable_nodes;
+                bool         release;
+            };
+
+            // the blocks of a pool sorted by address
+            struct pool_block_table
+            {
+                pool_block_nodes* blocks;
+                std::size_t       size;
+
+                // sorts the blocks
+                void sort() noexcept;
+
+                // returns the block containing the memory or nullptr
+                pool_block_nodes* find(const void* memory) const noexcept;
+
+                // visitor of the free list that counts the free nodes of each block
+                static void count_free_nodes(void* table, char* node,
+                                             std::size_t no_nodes) noexcept;
+
+                // filter of the free list for the nodes of the blocks that are released
+                static bool is_released(void* table, char* node) noexcept;
+            };
         } // namespace detail
 
         /// A stateful \concept{concept_rawallocator,RawAllocator} that manages \concept{concept_node,nodes} of fixed size.
@@ -42,13 +118,19 @@ namespace foonathan
         /// for example in a node based container like \c std::list.
         /// It is not so good for different allocation sizes and has some drawbacks for arrays
         /// as described in \ref memory_pool_type.hpp.
+        /// \note With \ref concurrent_node_pool, \ref allocate_node(), \ref try_allocate_node() and \ref deallocate_node()
+        /// can be called from multiple threads at the same time.
         /// \ingroup allocator
         template <typename PoolType = node_pool, class BlockOrRawAllocator = default_allocator>
         class memory_pool
-        : FOONATHAN_EBO(detail::default_leak_checker<detail::memory_pool_leak_handler>)
+        : FOONATHAN_EBO(detail::memory_pool_leak_checker<typename PoolType::type>),
+          FOONATHAN_EBO(detail::memory_pool_growth_lock<
+                        detail::is_concurrent_free_list<typename PoolType::type>::value>)
         {
-            using free_list    = typename PoolType::type;
-            using leak_checker = detail::default_leak_checker<detail::memory_pool_leak_handler>;
+            using free_list     = typename PoolType::type;
+            using leak_checker  = detail::memory_pool_leak_checker<free_list>;
+            using is_concurrent = detail::is_concurrent_free_list<free_list>;
+            using growth_lock   = detail::memory_pool_growth_lock<is_concurrent::value>;
 
         public:
             using allocator_type = make_block_allocator_t<BlockOrRawAllocator>;
@@ -94,6 +176,7 @@ namespace foonathan
             /// even when passing it memory that was previously allocated by this object.
             memory_pool(memory_pool&& other) noexcept
             : leak_checker(detail::move(other)),
+              growth_lock(),
               arena_(detail::move(other.arena_)),
               free_list_(detail::move(other.free_list_))
             {
@@ -116,10 +199,7 @@ namespace foonathan
             /// \throws Anything thrown by the used \concept{concept_blockallocator,BlockAllocator}'s allocation function if a growth is needed.
             void* allocate_node()
             {
-                if (free_list_.empty())
-                    allocate_block();
-                FOONATHAN_MEMORY_ASSERT(!free_list_.empty());
-                return free_list_.allocate();
+                return allocate_node(is_concurrent{});
             }
 
             /// \effects Allocates a single \concept{concept_node,node} similar to \ref allocate_node().
@@ -130,6 +210,66 @@ namespace foonathan
                 return free_list_.empty() ? nullptr : free_list_.allocate();
             }
 
+            /// \effects Allocates a single \concept{concept_node,node} like \ref allocate_node() whose bytes are all zero.
+            /// Nodes of the \ref node_pool and \ref cache_aligned_node_pool that were never allocated
+            /// from a block the \ref memory_arena reports as zeroed,
+            /// e.g. fresh memory of a \ref virtual_block_allocator, are not cleared again.
+            /// \returns A node of size \ref node_size() suitable aligned.
+            /// \throws Anything thrown by \ref allocate_node().
+            void* allocate_node_zeroed()
+            {
+                return allocate_node_zeroed(is_concurrent{});
+            }
+
+            /// \effects Allocates \c count \concept{concept_node,nodes} at once and stores them in \c nodes.
+            /// The arena grows as often as needed to have enough nodes on the free list first,
+            /// then all of them are removed from it in one pass.
+            /// \throws Anything thrown by the used \concept{concept_blockallocator,BlockAllocator}'s allocation function if a growth is needed.
+            /// If it throws, no node has been allocated.
+            /// \requires \c nodes must point to an array of at least \c count pointers.
+            void allocate_node_batch(void** nodes, std::size_t count)
+            {
+                allocate_node_batch(nodes, count, is_concurrent{});
+            }
+
+            /// \effects Allocates \c count \concept{concept_node,nodes} similar to \ref allocate_node_batch().
+            /// But if there are not enough nodes on the free list, a new block will *not* be allocated.
+            /// \returns `true` if all nodes have been allocated, `false` if none have been allocated.
+            bool try_allocate_node_batch(void** nodes, std::size_t count) noexcept
+            {
+                if (free_list_.capacity() < count)
+                    return false;
+                for (std::size_t i = 0u; i != count; ++i)
+                {
+                    nodes[i] = try_allocate_node();
+                    if (!nodes[i])
+                    {
+                        // another thread was faster
+                        deallocate_node_batch(nodes, i);
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            /// \effects Allocates memory blocks until at least \c capacity \concept{concept_node,nodes} can be allocated
+            /// without growing the arena.
+            /// If the \concept{concept_blockallocator,BlockAllocator} can allocate multiple blocks at once,
+            /// like \ref growing_block_allocator and \ref virtual_block_allocator,
+            /// the memory for all missing nodes is allocated with one allocation, see \ref memory_arena::allocate_blocks().
+            /// \throws Anything thrown by the used \concept{concept_blockallocator,BlockAllocator}'s allocation function.
+            void reserve(std::size_t capacity)
+            {
+                std::lock_guard<growth_lock> lock(*this);
+                while (free_list_.capacity() < capacity)
+                {
+                    auto nodes_per_block = next_capacity() / node_size();
+                    FOONATHAN_MEMORY_ASSERT(nodes_per_block != 0u);
+                    auto missing = capacity - free_list_.capacity();
+                    allocate_blocks((missing + nodes_per_block - 1u) / nodes_per_block);
+                }
+            }
+
             /// \effects Allocates an \concept{concept_array,array} of nodes by searching for \c n continuous nodes on the list and removing them.
             /// Depending on the \c PoolType this can be a slow operation or not allowed at all.
             /// This can sometimes lead to a growth, even if technically there is enough continuous memory on the free list.
@@ -160,6 +300,7 @@ namespace foonathan
             void deallocate_node(void* ptr) noexcept
             {
                 free_list_.deallocate(ptr);
+                release_empty_block(releases_blocks{});
             }
 
             /// \effects Deallocates a single \concept{concept_node,node} but it does not be a result of a previous call to \ref allocate_node().
@@ -170,7 +311,27 @@ namespace foonathan
             {
                 if (!arena_.owns(ptr))
                     return false;
-                free_list_.deallocate(ptr);
+                deallocate_node(ptr);
+                return true;
+            }
+
+            /// \effects Deallocates \c count \concept{concept_node,nodes} by putting them back onto the free list.
+            /// \requires All nodes must be a result from a previous call to \ref allocate_node() or \ref allocate_node_batch() on the same free list.
+            void deallocate_node_batch(void* const* nodes, std::size_t count) noexcept
+            {
+                for (std::size_t i = 0u; i != count; ++i)
+                    deallocate_node(nodes[i]);
+            }
+
+            /// \effects Deallocates \c count \concept{concept_node,nodes} similar to \ref deallocate_node_batch(),
+            /// but only if all of them are in memory owned by the pool.
+            /// \returns `true` if the nodes have been deallocated, `false` otherwise.
+            bool try_deallocate_node_batch(void* const* nodes, std::size_t count) noexcept
+            {
+                for (std::size_t i = 0u; i != count; ++i)
+                    if (!arena_.owns(nodes[i]))
+                        return false;
+                deallocate_node_batch(nodes, count);
                 return true;
             }
 
@@ -180,7 +341,7 @@ namespace foonathan
             void deallocate_array(void* ptr, std::size_t n) noexcept
             {
                 FOONATHAN_MEMORY_ASSERT_MSG(pool_type::value, "does not support array allocations");
-                free_list_.deallocate(ptr, n * node_size());
+                deallocate_array(ptr, n, node_size());
             }
 
             /// \effects Deallocates an \concept{concept_array,array} but it does not be a result of a previous call to \ref allocate_array().
@@ -192,6 +353,32 @@ namespace foonathan
                 return try_deallocate_array(ptr, n, node_size());
             }
 
+            /// \effects Returns memory blocks that contain only free nodes back to the \concept{concept_blockallocator,BlockAllocator},
+            /// starting with the most recently allocated block and stopping at the first one with a node still in use.
+            /// With a \ref virtual_block_allocator, this decommits the pages of the blocks while the address range stays reserved,
+            /// so the pool keeps stable addresses but its resident memory shrinks back after a load spike.
+            /// The blocks are allocated again when needed.
+            /// \note This walks the free list once to count the free nodes of each block and once more to remove them,
+            /// so it should be called periodically, e.g. after a spike, and not after every deallocation.
+            /// The untouched rest of a new block is counted without writing to it.
+            /// With more than 16 blocks, it needs a temporary array from \ref heap_alloc() and does nothing if that fails.
+            /// It does nothing for \ref small_node_pool, \ref wide_small_node_pool and \ref concurrent_node_pool.
+            void shrink_to_fit() noexcept
+            {
+                release_free_blocks(true, can_shrink{});
+            }
+
+            /// \effects Returns all memory blocks that contain only free nodes back to the \concept{concept_blockallocator,BlockAllocator},
+            /// not only the most recently allocated ones like \ref shrink_to_fit(),
+            /// so a pool whose nodes are spread over many blocks after a long uptime can give the unused ones back.
+            /// \requires The \concept{concept_blockallocator,BlockAllocator} must allow deallocating its blocks in any order,
+            /// see \ref memory_arena::deallocate_block(memory_block).
+            /// \note This has the same cost and requirements as \ref shrink_to_fit().
+            void release_empty_blocks() noexcept
+            {
+                release_free_blocks(false, can_shrink{});
+            }
+
             /// \returns The size of each \concept{concept_node,node} in the pool,
             /// this is either the same value as in the constructor or \c min_node_size if the value was too small.
             std::size_t node_size() const noexcept
@@ -212,7 +399,39 @@ namespace foonathan
             /// \note Due to fence memory in debug mode this cannot be just divided by the \ref node_size() to get the number of nodes.
             std::size_t next_capacity() const noexcept
             {
-                return free_list_.usable_size(arena_.next_block_size());
+                // blocks are aligned for the node alignment, so all have the same offset
+                auto offset =
+                    detail::align_offset(detail::memory_block_stack::implementation_offset(),
+                                         node_alignment());
+                auto size   = arena_.next_block_size();
+                return size < offset ? 0u : free_list_.usable_size(size - offset);
+            }
+
+            /// \returns The memory usage of the pool.
+            /// The nodes that are not on the free list count as \c used_bytes,
+            /// the nodes that were never allocated as \c unused_bytes
+            /// and the rest of the blocks that is too small for a node and the bookkeeping as \c wasted_bytes.
+            /// \note The nodes are counted with \ref node_size(),
+            /// the difference to the live bytes of an \ref allocation_statistics object is the rounding.
+            /// \note This walks all blocks in use.
+            memory_stats stats() const noexcept
+            {
+                auto result      = arena_.stats();
+                auto nodes_bytes = std::size_t(0u);
+                arena_.for_each_block([&](memory_block block) {
+                    auto offset = detail::align_offset(block.memory, node_alignment());
+                    if (offset < block.size)
+                        nodes_bytes +=
+                            detail::inserted_size(0, free_list_,
+                                                  static_cast<char*>(block.memory) + offset,
+                                                  block.size - offset);
+                });
+
+                result.unused_bytes      = detail::untouched_capacity(0, free_list_) * node_size();
+                result.free_listed_bytes = capacity_left() - result.unused_bytes;
+                result.used_bytes        = nodes_bytes - capacity_left();
+                result.wasted_bytes      = result.committed_bytes - nodes_bytes;
+                return result;
             }
 
             /// \returns A reference to the \concept{concept_blockallocator,BlockAllocator} used for managing the arena.
@@ -233,12 +452,195 @@ namespace foonathan
                 return {FOONATHAN_MEMORY_LOG_PREFIX "::memory_pool", this};
             }
 
+            void* allocate_node(std::false_type)
+            {
+                if (FOONATHAN_MEMORY_UNLIKELY(free_list_.empty()))
+                    allocate_block();
+                FOONATHAN_MEMORY_ASSERT(!free_list_.empty());
+                return free_list_.allocate();
+            }
+
+            void* allocate_node(std::true_type)
+            {
+                while (true)
+                {
+                    auto node = free_list_.allocate();
+                    if (FOONATHAN_MEMORY_LIKELY(node))
+                        return node;
+
+                    // only one thread may grow the arena at a time,
+                    // the others just retry if it was grown in the meantime
+                    std::lock_guard<growth_lock> lock(*this);
+                    if (free_list_.empty())
+                        allocate_block();
+                }
+            }
+
+            void* allocate_node_zeroed(std::false_type)
+            {
+                if (FOONATHAN_MEMORY_UNLIKELY(free_list_.empty()))
+                    allocate_block();
+                FOONATHAN_MEMORY_ASSERT(!free_list_.empty());
+                return detail::allocate_zeroed(0, free_list_);
+            }
+
+            void* allocate_node_zeroed(std::true_type)
+            {
+                auto node = allocate_node(std::true_type{});
+                std::memset(node, 0, node_size());
+                return node;
+            }
+
+            void allocate_node_batch(void** nodes, std::size_t count, std::false_type)
+            {
+                while (free_list_.capacity() < count)
+                    allocate_block();
+                for (std::size_t i = 0u; i != count; ++i)
+                    nodes[i] = free_list_.allocate();
+            }
+
+            void allocate_node_batch(void** nodes, std::size_t count, std::true_type)
+            {
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+                std::size_t i = 0u;
+                try
+                {
+                    for (; i != count; ++i)
+                        nodes[i] = allocate_node(std::true_type{});
+                }
+                catch (...)
+                {
+                    deallocate_node_batch(nodes, i);
+                    throw;
+                }
+#else
+                for (std::size_t i = 0u; i != count; ++i)
+                    nodes[i] = allocate_node(std::true_type{});
+#endif
+            }
+
             void allocate_block()
             {
-                auto mem = arena_.allocate_block();
-                free_list_.insert(static_cast<char*>(mem.memory), mem.size);
+                allocate_blocks(1u);
+            }
+
+            void allocate_blocks(std::size_t n)
+            {
+                auto mem    = arena_.allocate_blocks(n);
+                auto offset = detail::align_offset(mem.memory, node_alignment());
+                FOONATHAN_MEMORY_ASSERT(offset < mem.size);
+                detail::insert_block(0, free_list_, static_cast<char*>(mem.memory) + offset,
+                                     mem.size - offset, arena_.last_block_zeroed());
+            }
+
+            // the free lists that put the nodes of a block right after each other,
+            // so the nodes are aligned for the lowest set bit of the node size if the first one is
+            using can_align = std::integral_constant<
+                bool, std::is_same<free_list, detail::free_memory_list>::value
+                          || std::is_base_of<detail::ordered_free_memory_list, free_list>::value
+                          || std::is_same<free_list, detail::concurrent_free_memory_list>::value>;
+
+            // the alignment of the nodes,
+            // bigger than the one of the free list if the blocks are over-aligned,
+            // e.g. with aligned_block_allocator
+            std::size_t node_alignment() const noexcept
+            {
+                auto alignment = free_list_.alignment();
+                if (!can_align::value)
+                    return alignment;
+
+                auto block_alignment = detail::block_alignment(0, arena_.get_allocator());
+                auto natural         = node_size() & (0u - node_size());
+                auto result          = natural < block_alignment ? natural : block_alignment;
+                return result < alignment ? alignment : result;
+            }
+
+            // the free lists that allow moving nodes onto another list
+            using can_shrink = std::integral_constant<
+                bool, std::is_same<free_list, detail::free_memory_list>::value
+                          || std::is_base_of<detail::ordered_free_memory_list, free_list>::value>;
+
+            // returns the blocks that contain only free nodes to the arena,
+            // or only those on top of it, which works with every BlockAllocator
+            // a template, so it is only instantiated for the free lists that can shrink
+            template <class CanShrink>
+            void release_free_blocks(bool only_top, CanShrink) noexcept
+            {
+                static constexpr std::size_t local_size = 16u;
+
+                auto size = arena_.size();
+                if (size == 0u)
+                    return;
+                detail::pool_block_nodes local[local_size];
+                auto                     bytes = size * sizeof(detail::pool_block_nodes);
+                auto blocks = size <= local_size ?
+                                  local :
+                                  static_cast<detail::pool_block_nodes*>(heap_alloc(bytes));
+                if (!blocks)
+                    return;
+
+                std::size_t index = 0u;
+                arena_.for_each_block(
+                    [&](const memory_block& block)
+                    {
+                        auto offset     = detail::align_offset(block.memory, node_alignment());
+                        auto usable     = offset < block.size ?
+                                              free_list_.usable_size(block.size - offset) :
+                                              0u;
+                        blocks[index++] = {block, 0u, usable / node_size(), false};
+                    });
+
+                detail::pool_block_table table{blocks, size};
+                table.sort();
+                free_list_.visit(&detail::pool_block_table::count_free_nodes, &table);
+
+                auto is_empty = [](const detail::pool_block_nodes& b)
+                { return b.usable_nodes != 0u && b.free_nodes == b.usable_nodes; };
+                std::size_t no_released = 0u;
+                if (only_top)
+                {
+                    // stop at the first block in use, in reversed order of allocation
+                    auto in_use = false;
+                    arena_.for_each_block(
+                        [&](const memory_block& block)
+                        {
+                            auto b = table.find(block.memory);
+                            in_use = in_use || !is_empty(*b);
+                            if (!in_use)
+                            {
+                                b->release = true;
+                                ++no_released;
+                            }
+                        });
+                }
+                else
+                {
+                    for (std::size_t i = 0u; i != size; ++i)
+                        if (is_empty(blocks[i]))
+                        {
+                            blocks[i].release = true;
+                            ++no_released;
+                        }
+                }
+
+                if (no_released != 0u)
+                {
+                    free_list_.remove_if(&detail::pool_block_table::is_released, &table);
+                    if (only_top)
+                        for (std::size_t i = 0u; i != no_released; ++i)
+                            arena_.deallocate_block();
+                    else
+                        for (std::size_t i = 0u; i != size; ++i)
+                            if (blocks[i].release)
+                                arena_.deallocate_block(blocks[i].block);
+                }
+
+                if (blocks != local)
+                    heap_dealloc(blocks, bytes);
             }
 
+            void release_free_blocks(bool, std::false_type) noexcept {}
+
             void* allocate_array(std::size_t n, std::size_t node_size)
             {
                 auto mem = free_list_.empty() ? nullptr : free_list_.allocate(n * node_size);
@@ -247,11 +649,55 @@ namespace foonathan
                     allocate_block();
                     mem = free_list_.allocate(n * node_size);
                     if (!mem)
-                        FOONATHAN_THROW(bad_array_size(info(), n * node_size, capacity_left()));
+                        detail::throw_bad_allocation_size<bad_array_size>(info(), n * node_size,
+                                                                          capacity_left());
                 }
                 return mem;
             }
 
+            // the free lists that remove the blocks whose nodes are all free
+            using releases_blocks =
+                std::is_same<free_list, detail::releasing_bitmap_free_memory_list>;
+
+            // only the releasing free lists have remove_empty_block(),
+            // but all members are instantiated by the extern templates
+            static void* remove_empty_block(
+                detail::releasing_bitmap_free_memory_list& list) noexcept
+            {
+                return list.remove_empty_block();
+            }
+
+            template <class FreeList>
+            static void* remove_empty_block(FreeList&) noexcept
+            {
+                return nullptr;
+            }
+
+            void release_empty_block(std::false_type) noexcept {}
+
+            void release_empty_block(std::true_type) noexcept
+            {
+                auto mem = remove_empty_block(free_list_);
+                if (!mem)
+                    return;
+
+                // the free list got the block after the alignment offset
+                memory_block empty;
+                arena_.for_each_block(
+                    [&](const memory_block& block)
+                    {
+                        if (block.contains(mem))
+                            empty = block;
+                    });
+                arena_.deallocate_block(empty);
+            }
+
+            void deallocate_array(void* ptr, std::size_t n, std::size_t node_size) noexcept
+            {
+                free_list_.deallocate(ptr, n * node_size);
+                release_empty_block(releases_blocks{});
+            }
+
             void* try_allocate_array(std::size_t n, std::size_t node_size) noexcept
             {
                 return !pool_type::value || free_list_.empty() ? nullptr :
@@ -263,6 +709,7 @@ namespace foonathan
                 if (!pool_type::value || !arena_.owns(ptr))
                     return false;
                 free_list_.deallocate(ptr, n * node_size);
+                release_empty_block(releases_blocks{});
                 return true;
             }
 
@@ -276,7 +723,9 @@ namespace foonathan
 #if FOONATHAN_MEMORY_EXTERN_TEMPLATE
         extern template class memory_pool<node_pool>;
         extern template class memory_pool<array_pool>;
+        extern template class memory_pool<bitmap_array_pool>;
         extern template class memory_pool<small_node_pool>;
+        extern template class memory_pool<concurrent_node_pool>;
 #endif
 
         template <class Type, class Alloc>
@@ -308,6 +757,36 @@ namespace foonathan
                 return mem;
             }
 
+            /// \effects Forwards to \ref memory_pool::allocate_node_zeroed().
+            /// \returns A zeroed \concept{concept_node,node} of size \ref memory_pool::node_size().
+            /// \throws Anything thrown by the pool allocation function
+            /// or a \ref bad_allocation_size exception.
+            static void* allocate_node_zeroed(allocator_type& state, std::size_t size,
+                                              std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_node_size>(size, max_node_size(state),
+                                                             state.info());
+                detail::check_allocation_size<bad_alignment>(
+                    alignment, [&] { return max_alignment(state); }, state.info());
+                auto mem = state.allocate_node_zeroed();
+                state.on_allocate(size);
+                return mem;
+            }
+
+            /// \effects Forwards to \ref memory_pool::allocate_node_batch().
+            /// \throws Anything thrown by the pool allocation function
+            /// or a \ref bad_allocation_size exception.
+            static void allocate_node_batch(allocator_type& state, void** nodes, std::size_t count,
+                                            std::size_t size, std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_node_size>(size, max_node_size(state),
+                                                             state.info());
+                detail::check_allocation_size<bad_alignment>(
+                    alignment, [&] { return max_alignment(state); }, state.info());
+                state.allocate_node_batch(nodes, count);
+                state.on_allocate(count * size);
+            }
+
             /// \effects Forwards to \ref memory_pool::allocate_array()
             /// with the number of nodes adjusted to be the minimum,
             /// i.e. when the \c size is less than the \ref memory_pool::node_size().
@@ -328,6 +807,44 @@ namespace foonathan
                 return mem;
             }
 
+            /// \effects Same as \ref allocate_node().
+            /// \returns The node and its usable size, which is the \ref memory_pool::node_size().
+            /// \throws Anything thrown by the pool allocation function
+            /// or a \ref bad_allocation_size exception.
+            static allocation_result allocate_node_at_least(allocator_type& state, std::size_t size,
+                                                            std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_node_size>(size, max_node_size(state),
+                                                             state.info());
+                detail::check_allocation_size<bad_alignment>(
+                    alignment, [&] { return max_alignment(state); }, state.info());
+                auto mem = state.allocate_node();
+                state.on_allocate(state.node_size());
+                return {mem, state.node_size()};
+            }
+
+            /// \effects Same as \ref allocate_array().
+            /// \returns The array and the number of elements that fit into the nodes used for it.
+            /// \requires The \ref memory_pool has to support array allocations.
+            /// \throws Anything thrown by the pool allocation function.
+            static allocation_result allocate_array_at_least(allocator_type& state,
+                                                             std::size_t count, std::size_t size,
+                                                             std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_node_size>(size, max_node_size(state),
+                                                             state.info());
+                detail::check_allocation_size<bad_alignment>(
+                    alignment, [&] { return max_alignment(state); }, state.info());
+                detail::check_allocation_size<bad_array_size>(count * size, max_array_size(state),
+                                                              state.info());
+                auto mem = state.allocate_array(count, size);
+
+                auto no_nodes = (count * size + state.node_size() - 1u) / state.node_size();
+                auto usable   = no_nodes * state.node_size() / size;
+                state.on_allocate(usable * size);
+                return {mem, usable};
+            }
+
             /// \effects Just forwards to \ref memory_pool::deallocate_node().
             static void deallocate_node(allocator_type& state, void* node, std::size_t size,
                                         std::size_t) noexcept
@@ -336,11 +853,20 @@ namespace foonathan
                 state.on_deallocate(size);
             }
 
+            /// \effects Just forwards to \ref memory_pool::deallocate_node_batch().
+            static void deallocate_node_batch(allocator_type& state, void* const* nodes,
+                                              std::size_t count, std::size_t size,
+                                              std::size_t) noexcept
+            {
+                state.deallocate_node_batch(nodes, count);
+                state.on_deallocate(count * size);
+            }
+
             /// \effects Forwards to \ref memory_pool::deallocate_array() with the same size adjustment.
             static void deallocate_array(allocator_type& state, void* array, std::size_t count,
                                          std::size_t size, std::size_t) noexcept
             {
-                state.free_list_.deallocate(array, count * size);
+                state.deallocate_array(array, count, size);
                 state.on_deallocate(count * size);
             }
 
@@ -358,9 +884,11 @@ namespace foonathan
 
             /// \returns The maximum alignment which is the next bigger power of two if less than \c alignof(std::max_align_t)
             /// or the maximum alignment itself otherwise.
+            /// If the blocks of the \concept{concept_blockallocator,BlockAllocator} have a bigger alignment, like with an \ref aligned_block_allocator,
+            /// it is the lowest set bit of the node size up to that alignment.
             static std::size_t max_alignment(const allocator_type& state) noexcept
             {
-                return state.free_list_.alignment();
+                return state.node_alignment();
             }
         };
 
@@ -384,6 +912,17 @@ namespace foonathan
                 return state.try_allocate_node();
             }
 
+            /// \returns The result of \ref memory_pool::try_allocate_node_batch()
+            /// or `false` if the allocation size was too big.
+            static bool try_allocate_node_batch(allocator_type& state, void** nodes,
+                                                std::size_t count, std::size_t size,
+                                                std::size_t alignment) noexcept
+            {
+                if (size > traits::max_node_size(state) || alignment > traits::max_alignment(state))
+                    return false;
+                return state.try_allocate_node_batch(nodes, count);
+            }
+
             /// \effects Forwards to \ref memory_pool::try_allocate_array()
             /// with the number of nodes adjusted to be the minimum,
             /// if the \c size is less than the \ref memory_pool::node_size().
@@ -409,6 +948,17 @@ namespace foonathan
                 return state.try_deallocate_node(node);
             }
 
+            /// \effects Just forwards to \ref memory_pool::try_deallocate_node_batch().
+            /// \returns Whether the deallocation was successful.
+            static bool try_deallocate_node_batch(allocator_type& state, void* const* nodes,
+                                                  std::size_t count, std::size_t size,
+                                                  std::size_t alignment) noexcept
+            {
+                if (size > traits::max_node_size(state) || alignment > traits::max_alignment(state))
+                    return false;
+                return state.try_deallocate_node_batch(nodes, count);
+            }
+
             /// \effects Forwards to \ref memory_pool::deallocate_array() with the same size adjustment.
             /// \returns Whether the deallocation was successful.
             static bool try_deallocate_array(allocator_type& state, void* array, std::size_t count,
@@ -425,11 +975,15 @@ namespace foonathan
 #if FOONATHAN_MEMORY_EXTERN_TEMPLATE
         extern template class allocator_traits<memory_pool<node_pool>>;
         extern template class allocator_traits<memory_pool<array_pool>>;
+        extern template class allocator_traits<memory_pool<bitmap_array_pool>>;
         extern template class allocator_traits<memory_pool<small_node_pool>>;
+        extern template class allocator_traits<memory_pool<concurrent_node_pool>>;
 
         extern template class composable_allocator_traits<memory_pool<node_pool>>;
         extern template class composable_allocator_traits<memory_pool<array_pool>>;
+        extern template class composable_allocator_traits<memory_pool<bitmap_array_pool>>;
         extern template class composable_allocator_traits<memory_pool<small_node_pool>>;
+        extern template class composable_allocator_traits<memory_pool<concurrent_node_pool>>;
 #endif
     } // namespace memory
 } // namespace foonathan
@@ -18,6 +18,7 @@
 #include "error.hpp"
 #include "memory_arena.hpp"
 #include "memory_pool_type.hpp"
+#include "virtual_memory.hpp"
 
 namespace foonathan
 {
@@ -29,6 +30,11 @@ namespace foonathan
             {
                 void operator()(std::ptrdiff_t amount);
             };
+
+            struct slab_pool_collection_leak_handler
+            {
+                void operator()(std::ptrdiff_t amount);
+            };
         } // namespace detail
 
         /// A \c BucketDistribution for \ref memory_pool_collection defining that there is a bucket, i.e. pool, for each size.
@@ -49,9 +55,20 @@ namespace foonathan
             using type = detail::log2_access_policy;
         };
 
+        /// A \c BucketDistribution for \ref memory_pool_collection defining that there are four buckets, i.e. pools, for each power of two.
+        /// That means each range between two powers of two is split into four size classes of equal width,
+        /// e.g. 40, 48, 56 and 64 bytes, and there will be a separate free list for each of them.
+        /// Allocating a node will waste less than a quarter of the memory,
+        /// while needing far fewer free lists than \ref identity_buckets for big maximum node sizes.
+        /// \ingroup allocator
+        struct geometric_buckets
+        {
+            using type = detail::geometric_access_policy;
+        };
+
         /// A stateful \concept{concept_rawallocator,RawAllocator} that behaves as a collection of multiple \ref memory_pool objects.
         /// It maintains a list of multiple free lists, whose types are controlled via the \c PoolType tags defined in \ref memory_pool_type.hpp,
-        /// each of a different size as defined in the \c BucketDistribution (\ref identity_buckets or \ref log2_buckets).
+        /// each of a different size as defined in the \c BucketDistribution (\ref identity_buckets, \ref log2_buckets or \ref geometric_buckets).
         /// Allocating a node of given size will use the appropriate free list.<br>
         /// This allocator is ideal for \concept{concept_node,node} allocations in any order but with a predefined set of sizes,
         /// not only one size like \ref memory_pool.
@@ -131,7 +148,7 @@ namespace foonathan
                 if (pool.empty())
                 {
                     auto block = reserve_memory(pool, def_capacity());
-                    pool.insert(block.memory, block.size);
+                    insert_nodes(pool, block.memory, block.size);
                 }
 
                 auto mem = pool.allocate();
@@ -181,7 +198,7 @@ namespace foonathan
                 {
                     // reserve more memory
                     auto block = reserve_memory(pool, def_capacity());
-                    pool.insert(block.memory, block.size);
+                    insert_nodes(pool, block.memory, block.size);
 
                     mem = pool.allocate(count * node_size);
                     if (!mem)
@@ -192,7 +209,7 @@ namespace foonathan
                             [&] { return next_capacity() - pool.alignment() + 1; }, info());
 
                         block = reserve_memory(pool, count * node_size);
-                        pool.insert(block.memory, block.size);
+                        insert_nodes(pool, block.memory, block.size);
 
                         mem = pool.allocate(count * node_size);
                         FOONATHAN_MEMORY_ASSERT(mem);
@@ -265,14 +282,21 @@ namespace foonathan
             /// It will try to put \c capacity_left bytes from the arena onto the free list defined over the \c BucketDistribution,
             /// if the arena is empty, a new memory block is requested from the \concept{concept_blockallocator,BlockAllocator}
             /// and it will be used.
+            /// If \c prefault is \c true, the memory is also made resident with \ref prefault_memory(),
+            /// so that the allocations from it do not cause page faults.
             /// \throws Anything thrown by the \concept{concept_blockallocator,BlockAllocator} if a growth is needed.
             /// \requires \c node_size must be valid \concept{concept_node,node size} less than or equal to \ref max_node_size(),
-            /// \c capacity_left must be less than \ref next_capacity().
-            void reserve(std::size_t node_size, std::size_t capacity)
+            /// \c capacity_left must be less than \ref next_capacity(),
+            /// unless the \concept{concept_blockallocator,BlockAllocator} can allocate multiple blocks at once,
+            /// then a bigger reservation gets them with one allocation, see \ref memory_arena::allocate_blocks().
+            void reserve(std::size_t node_size, std::size_t capacity, bool prefault = false)
             {
                 FOONATHAN_MEMORY_ASSERT_MSG(node_size <= max_node_size(), "node_size too big");
-                auto& pool = pools_.get(node_size);
-                reserve_memory(pool, capacity);
+                auto& pool  = pools_.get(node_size);
+                auto  block = reserve_memory(pool, capacity);
+                if (prefault)
+                    prefault_memory(block.memory, block.size);
+                insert_nodes(pool, block.memory, block.size);
             }
 
             /// \returns The maximum node size for which is a free list.
@@ -309,6 +333,51 @@ namespace foonathan
                 return arena_.next_block_size();
             }
 
+            /// \returns The memory usage of the collection.
+            /// The memory not yet distributed to the free lists and the nodes that were never allocated count as \c unused_bytes,
+            /// the free lists themselves, the rest of the blocks that was too small for the next free list
+            /// and the rest of the memory inserted into a free list that was too small for a node as \c wasted_bytes.
+            /// \note The nodes are counted with the node size of their free list,
+            /// the difference to the live bytes of an \ref allocation_statistics object is the rounding to the buckets.
+            /// \note This walks all blocks in use and all free lists.
+            memory_stats stats() const noexcept
+            {
+                auto result = arena_.stats();
+                auto nodes = std::size_t(0u), untouched = std::size_t(0u);
+                for (std::size_t i = 0u; i != pools_.size(); ++i)
+                {
+                    auto& pool = pools_.at(i);
+                    auto  free = pool.capacity() * pool.node_size();
+                    auto  never_used = detail::untouched_capacity(0, pool) * pool.node_size();
+                    nodes += pools_.inserted_size(pool);
+                    untouched += never_used;
+                    result.free_listed_bytes += free - never_used;
+                }
+
+                result.unused_bytes = capacity_left() + untouched;
+                result.used_bytes   = nodes - result.free_listed_bytes - untouched;
+                result.wasted_bytes = result.committed_bytes - nodes - capacity_left();
+                return result;
+            }
+
+            /// \returns The memory usage of the free list for nodes of given size
+            /// as defined over the \c BucketDistribution.
+            /// The memory inserted into it counts as \c committed_bytes and \c reserved_bytes,
+            /// the nodes that were never allocated as \c unused_bytes,
+            /// there are no blocks or wasted bytes.
+            memory_stats pool_stats(std::size_t node_size) const noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT_MSG(node_size <= max_node_size(), "node_size too big");
+                auto&        pool = pools_.get(node_size);
+                auto         free = pool.capacity() * pool.node_size();
+                memory_stats result;
+                result.reserved_bytes = result.committed_bytes = pools_.inserted_size(pool);
+                result.unused_bytes = detail::untouched_capacity(0, pool) * pool.node_size();
+                result.free_listed_bytes = free - result.unused_bytes;
+                result.used_bytes        = result.committed_bytes - free;
+                return result;
+            }
+
             /// \returns A reference to the \concept{concept_blockallocator,BlockAllocator} used for managing the arena.
             /// \requires It is undefined behavior to move this allocator out into another object.
             allocator_type& get_allocator() noexcept
@@ -327,9 +396,12 @@ namespace foonathan
                 return arena_.current_block().size / pools_.size();
             }
 
-            detail::fixed_memory_stack allocate_block()
+            // allocates the memory of as many blocks as needed for capacity at once
+            detail::fixed_memory_stack allocate_block(std::size_t capacity = 0u)
             {
-                return detail::fixed_memory_stack(arena_.allocate_block().memory);
+                auto block_size = arena_.next_block_size();
+                auto no_blocks  = (capacity + block_size - 1u) / block_size;
+                return detail::fixed_memory_stack(arena_.allocate_blocks(no_blocks).memory);
             }
 
             const char* block_end() const noexcept
@@ -343,10 +415,13 @@ namespace foonathan
                 if (auto remaining = std::size_t(block_end() - stack_.top()))
                 {
                     auto offset = detail::align_offset(stack_.top(), detail::max_alignment);
-                    if (offset < remaining)
+                    // the rest might be too small for a single node of the pool
+                    if (offset < remaining
+                        && detail::inserted_size(0, pool, stack_.top() + offset, remaining - offset)
+                               != 0u)
                     {
                         detail::debug_fill(stack_.top(), offset, debug_magic::alignment_memory);
-                        pool.insert(stack_.top() + offset, remaining - offset);
+                        insert_nodes(pool, stack_.top() + offset, remaining - offset);
                         return true;
                     }
                 }
@@ -354,13 +429,20 @@ namespace foonathan
                 return false;
             }
 
+            void insert_nodes(typename pool_type::type& pool, void* memory,
+                              std::size_t size) noexcept
+            {
+                pools_.inserted_size(pool) += detail::inserted_size(0, pool, memory, size);
+                pool.insert(memory, size);
+            }
+
             void try_reserve_memory(typename pool_type::type& pool, std::size_t capacity) noexcept
             {
                 auto mem = stack_.allocate(block_end(), capacity, detail::max_alignment);
                 if (!mem)
                     insert_rest(pool);
                 else
-                    pool.insert(mem, capacity);
+                    insert_nodes(pool, mem, capacity);
             }
 
             memory_block reserve_memory(typename pool_type::type& pool, std::size_t capacity)
@@ -370,7 +452,7 @@ namespace foonathan
                 {
                     insert_rest(pool);
                     // get new block
-                    stack_ = allocate_block();
+                    stack_ = allocate_block(capacity);
 
                     // allocate ensuring alignment
                     mem = stack_.allocate(block_end(), capacity, detail::max_alignment);
@@ -394,6 +476,10 @@ namespace foonathan
         extern template class memory_pool_collection<node_pool, log2_buckets>;
         extern template class memory_pool_collection<array_pool, log2_buckets>;
         extern template class memory_pool_collection<small_node_pool, log2_buckets>;
+
+        extern template class memory_pool_collection<node_pool, geometric_buckets>;
+        extern template class memory_pool_collection<array_pool, geometric_buckets>;
+        extern template class memory_pool_collection<small_node_pool, geometric_buckets>;
 #endif
 
         /// An alias for \ref memory_pool_collection using the \ref identity_buckets policy
@@ -403,6 +489,227 @@ namespace foonathan
         FOONATHAN_ALIAS_TEMPLATE(bucket_allocator,
                                  memory_pool_collection<PoolType, identity_buckets, ImplAllocator>);
 
+        /// A stateful \concept{concept_rawallocator,RawAllocator} that behaves like a \ref memory_pool_collection,
+        /// but only creates the state of a size class when it is used for the first time.
+        /// Unlike \ref memory_pool_collection it does not allocate a memory block in the constructor
+        /// and does not create all free lists up front, so an unused object costs little more than its arena.
+        /// Each size class takes whole memory blocks, the slabs, from the arena instead of fragments of a shared block.
+        /// The first slab of a size class also stores its free list
+        /// and the very first slab the table of the free lists defined over the \c BucketDistribution.<br>
+        /// This allocator is ideal for many short-lived objects like per-connection state that only use a few size classes,
+        /// but as every size class takes at least one slab, the slab size should be small.
+        /// \ingroup allocator
+        template <class PoolType, class BucketDistribution,
+                  class BlockOrRawAllocator = default_allocator>
+        class slab_pool_collection
+        : FOONATHAN_EBO(detail::default_leak_checker<detail::slab_pool_collection_leak_handler>)
+        {
+            using free_list = typename PoolType::type;
+            using free_list_array =
+                detail::lazy_free_list_array<free_list, typename BucketDistribution::type>;
+            using leak_checker =
+                detail::default_leak_checker<detail::slab_pool_collection_leak_handler>;
+
+        public:
+            using allocator_type      = make_block_allocator_t<BlockOrRawAllocator>;
+            using pool_type           = PoolType;
+            using bucket_distribution = BucketDistribution;
+            using is_stateful         = std::true_type;
+
+            /// \effects Creates it by giving it the maximum node size it should be able to allocate,
+            /// the size of the slabs and other constructor arguments for the \concept{concept_blockallocator,BlockAllocator}.
+            /// It does not allocate any memory.
+            /// \requires \c max_node_size must be a valid \concept{concept_node,node} size
+            /// and \c slab_size must be big enough for the table of the free lists,
+            /// a free list and a node of \c max_node_size.
+            template <typename... Args>
+            slab_pool_collection(std::size_t max_node_size, std::size_t slab_size, Args&&... args)
+            : arena_(slab_size, detail::forward<Args>(args)...), pools_(max_node_size)
+            {
+                FOONATHAN_MEMORY_ASSERT_MSG(pools_.table_size() + sizeof(free_list) + max_node_size
+                                                    + 2 * (detail::max_alignment
+                                                           + detail::debug_fence_size)
+                                                <= slab_size,
+                                            "slab size too small");
+            }
+
+            /// \effects Destroys the \ref slab_pool_collection by returning all slabs,
+            /// regardless of properly deallocated back to the \concept{concept_blockallocator,BlockAllocator}.
+            ~slab_pool_collection() noexcept = default;
+
+            /// @{
+            /// \effects Moving a \ref slab_pool_collection object transfers ownership over the free lists,
+            /// i.e. the moved from pool is completely empty and the new one has all its memory.
+            /// That means that it is not allowed to call \ref deallocate_node() on a moved-from allocator
+            /// even when passing it memory that was previously allocated by this object.
+            slab_pool_collection(slab_pool_collection&& other) noexcept
+            : leak_checker(detail::move(other)),
+              arena_(detail::move(other.arena_)),
+              pools_(detail::move(other.pools_))
+            {
+            }
+
+            slab_pool_collection& operator=(slab_pool_collection&& other) noexcept
+            {
+                leak_checker::operator=(detail::move(other));
+                arena_ = detail::move(other.arena_);
+                pools_ = detail::move(other.pools_);
+                return *this;
+            }
+            /// @}
+
+            /// \effects Allocates a \concept{concept_node,node} of given size from the free list defined over the \c BucketDistribution.
+            /// If the free list has not been created yet, it is created in a new slab and the rest of the slab is put onto it.
+            /// If it is empty, a new slab is put onto it.
+            /// \returns A \concept{concept_node,node} of given size suitable aligned.
+            /// \throws Anything thrown by the \concept{concept_blockallocator,BlockAllocator} if a growth is needed
+            /// or a \ref bad_allocation_size exception if the size or alignment is too big.
+            void* allocate_node(std::size_t size, std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_node_size>(size, max_node_size(), info());
+                detail::check_allocation_size<bad_alignment>(
+                    alignment, [&] { return detail::alignment_for(size); }, info());
+
+                auto& pool = get_pool(size);
+                if (FOONATHAN_MEMORY_UNLIKELY(pool.empty()))
+                    insert_slab(pool);
+
+                auto mem = pool.allocate();
+                FOONATHAN_MEMORY_ASSERT(mem);
+                this->on_allocate(size);
+                return mem;
+            }
+
+            /// \effects Allocates an \concept{concept_array,array} of nodes by searching for continuous nodes on the appropriate free list,
+            /// putting a new slab onto it if that fails.
+            /// Depending on the \c PoolType this can be a slow operation or not allowed at all.
+            /// \returns An array of \c count nodes of given size suitable aligned.
+            /// \throws Anything thrown by the \concept{concept_blockallocator,BlockAllocator} if a growth is needed
+            /// or a \ref bad_allocation_size exception if the array does not fit into a slab.
+            void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_node_size>(size, max_node_size(), info());
+                detail::check_allocation_size<bad_alignment>(
+                    alignment, [&] { return detail::alignment_for(size); }, info());
+
+                auto& pool = get_pool(size);
+                auto  mem  = pool.empty() ? nullptr : pool.allocate(count * size);
+                if (!mem)
+                {
+                    insert_slab(pool);
+                    mem = pool.allocate(count * size);
+                    if (!mem)
+                        detail::throw_bad_allocation_size<bad_array_size>(info(), count * size,
+                                                                          max_array_size());
+                }
+                this->on_allocate(count * size);
+                return mem;
+            }
+
+            /// \effects Deallocates a \concept{concept_node,node} by putting it back onto the appropriate free list.
+            /// \requires \c ptr must be a result from a previous call to \ref allocate_node() with the same size on the same free list,
+            /// i.e. either this allocator object or a new object created by moving this to it.
+            void deallocate_node(void* ptr, std::size_t size, std::size_t) noexcept
+            {
+                pools_.get(size)->deallocate(ptr);
+                this->on_deallocate(size);
+            }
+
+            /// \effects Deallocates an \concept{concept_array,array} by putting it back onto the free list.
+            /// \requires \c ptr must be a result from a previous call to \ref allocate_array() with the same sizes on the same free list,
+            /// i.e. either this allocator object or a new object created by moving this to it.
+            void deallocate_array(void* ptr, std::size_t count, std::size_t size,
+                                  std::size_t) noexcept
+            {
+                pools_.get(size)->deallocate(ptr, count * size);
+                this->on_deallocate(count * size);
+            }
+
+            /// \returns The number of size classes whose free list has been created.
+            std::size_t no_pools_created() const noexcept
+            {
+                return pools_.no_created();
+            }
+
+            /// \returns The amount of nodes available in the free list for nodes of given size
+            /// as defined over the \c BucketDistribution,
+            /// or \c 0 if the free list has not been created yet.
+            std::size_t pool_capacity_left(std::size_t node_size) const noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT_MSG(node_size <= max_node_size(), "node_size too big");
+                auto pool = pools_.get(node_size);
+                return pool ? pool->capacity() : 0u;
+            }
+
+            /// \returns The maximum node size for which is a free list.
+            /// This is the value passed to it in the constructor.
+            std::size_t max_node_size() const noexcept
+            {
+                return pools_.max_node_size();
+            }
+
+            /// \returns An upper bound on the maximum array size which is the size of the next slab.
+            std::size_t max_array_size() const noexcept
+            {
+                return arena_.next_block_size();
+            }
+
+            /// \returns Just \c alignof(std::max_align_t) since the actual maximum alignment depends on the node size,
+            /// the nodes must not be over-aligned.
+            std::size_t max_alignment() const noexcept
+            {
+                return detail::max_alignment;
+            }
+
+            /// \returns A reference to the \concept{concept_blockallocator,BlockAllocator} used for managing the arena.
+            /// \requires It is undefined behavior to move this allocator out into another object.
+            allocator_type& get_allocator() noexcept
+            {
+                return arena_.get_allocator();
+            }
+
+        private:
+            allocator_info info() const noexcept
+            {
+                return {FOONATHAN_MEMORY_LOG_PREFIX "::slab_pool_collection", this};
+            }
+
+            free_list& get_pool(std::size_t node_size)
+            {
+                if (auto pool = pools_.get(node_size))
+                    return *pool;
+                return create_pool(node_size);
+            }
+
+            // creates the free list at the beginning of a new slab and puts the rest onto it
+            // the first slab also stores the table
+            free_list& create_pool(std::size_t node_size)
+            {
+                auto block = arena_.allocate_block();
+                auto stack = detail::fixed_memory_stack(block.memory);
+                auto end   = static_cast<const char*>(block.memory) + block.size;
+                if (!pools_.has_table())
+                    pools_.create_table(stack.allocate(end, pools_.table_size(),
+                                                       alignof(free_list*), 0u));
+
+                auto& pool = pools_.create(node_size, stack.allocate(end, sizeof(free_list),
+                                                                     alignof(free_list), 0u));
+                auto  rest = stack.top() + detail::align_offset(stack.top(), detail::max_alignment);
+                FOONATHAN_MEMORY_ASSERT(rest < end);
+                pool.insert(rest, std::size_t(end - rest));
+                return pool;
+            }
+
+            void insert_slab(free_list& pool)
+            {
+                auto block = arena_.allocate_block();
+                pool.insert(block.memory, block.size);
+            }
+
+            memory_arena<allocator_type, false> arena_;
+            free_list_array                     pools_;
+        };
+
         template <class Allocator>
         class allocator_traits;
 
@@ -446,6 +753,40 @@ namespace foonathan
                 return mem;
             }
 
+            /// \effects Same as \ref allocate_node().
+            /// \returns The node and its usable size,
+            /// which is the node size of the bucket the \c BucketDistribution chose for \c size.
+            /// \throws Anything thrown by the pool allocation function or a \ref bad_allocation_size exception.
+            static allocation_result allocate_node_at_least(allocator_type& state, std::size_t size,
+                                                            std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_alignment>(
+                    alignment, [&] { return detail::alignment_for(size); }, state.info());
+                auto mem       = state.allocate_node(size);
+                auto node_size = state.pools_.get(size).node_size();
+                state.on_allocate(node_size);
+                return {mem, node_size};
+            }
+
+            /// \effects Same as \ref allocate_array().
+            /// \returns The array and the number of elements that fit into the nodes used for it.
+            /// \throws Anything thrown by the pool allocation function or a \ref bad_allocation_size exception.
+            /// \requires The \ref memory_pool_collection has to support array allocations.
+            static allocation_result allocate_array_at_least(allocator_type& state,
+                                                             std::size_t count, std::size_t size,
+                                                             std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_alignment>(
+                    alignment, [&] { return detail::alignment_for(size); }, state.info());
+                auto mem = state.allocate_array(count, size);
+
+                auto node_size = state.pools_.get(size).node_size();
+                auto no_nodes  = (count * size + node_size - 1u) / node_size;
+                auto usable    = no_nodes * node_size / size;
+                state.on_allocate(usable * size);
+                return {mem, usable};
+            }
+
             /// \effects Calls \ref memory_pool_collection::deallocate_node().
             static void deallocate_node(allocator_type& state, void* node, std::size_t size,
                                         std::size_t) noexcept
@@ -548,6 +889,13 @@ namespace foonathan
         extern template class allocator_traits<
             memory_pool_collection<small_node_pool, log2_buckets>>;
 
+        extern template class allocator_traits<
+            memory_pool_collection<node_pool, geometric_buckets>>;
+        extern template class allocator_traits<
+            memory_pool_collection<array_pool, geometric_buckets>>;
+        extern template class allocator_traits<
+            memory_pool_collection<small_node_pool, geometric_buckets>>;
+
         extern template class composable_allocator_traits<
             memory_pool_collection<node_pool, identity_buckets>>;
         extern template class composable_allocator_traits<
@@ -561,6 +909,13 @@ namespace foonathan
             memory_pool_collection<array_pool, log2_buckets>>;
         extern template class composable_allocator_traits<
             memory_pool_collection<small_node_pool, log2_buckets>>;
+
+        extern template class composable_allocator_traits<
+            memory_pool_collection<node_pool, geometric_buckets>>;
+        extern template class composable_allocator_traits<
+            memory_pool_collection<array_pool, geometric_buckets>>;
+        extern template class composable_allocator_traits<
+            memory_pool_collection<small_node_pool, geometric_buckets>>;
 #endif
     } // namespace memory
 } // namespace foonathan
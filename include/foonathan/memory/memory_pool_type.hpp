@@ -7,8 +7,11 @@
 /// \file
 /// The \c PoolType tag types.
 
+#include <cstring>
 #include <type_traits>
 
+#include "detail/bitmap_free_list.hpp"
+#include "detail/fixed_free_list.hpp"
 #include "detail/free_list.hpp"
 #include "detail/small_free_list.hpp"
 #include "config.hpp"
@@ -29,7 +32,8 @@ namespace foonathan
         /// Tag type defining a memory pool optimized for arrays.
         /// It keeps the nodes ordered inside the free list and searches the list for an appropriate memory block.
         /// Array allocations are still pretty slow, if the array gets big enough it can get slower than \c new.
-        /// Node allocations are still fast, unless there is deallocation in random order.
+        /// Node allocations are still fast, deallocations in random order search the list from the closest of a fixed number of hints,
+        /// so they are slower than those of \ref node_pool but do not need to search the entire list.
         /// \note Use this tag type only if you really need to have a memory pool!
         /// \ingroup allocator
         struct array_pool : FOONATHAN_EBO(std::true_type)
@@ -37,6 +41,48 @@ namespace foonathan
             using type = detail::array_free_memory_list;
         };
 
+        /// Tag type defining a memory pool optimized for arrays of varying length.
+        /// Instead of a free list it keeps a bitmap of the free nodes for each memory block,
+        /// so an array allocation scans the bitmap words for a run of free nodes
+        /// and does not get slower the more the pool is fragmented, unlike \ref array_pool.
+        /// Node allocations are a little bit slower than with \ref node_pool,
+        /// but they always return the free node with the lowest address of a block, which keeps the pool compact.
+        /// As the bitmap is stored at the beginning of each block and not in the nodes, they can have any size.
+        /// An array must not span multiple blocks.
+        /// \ingroup allocator
+        struct bitmap_array_pool : FOONATHAN_EBO(std::true_type)
+        {
+            using type = detail::bitmap_free_memory_list;
+        };
+
+        /// Tag type defining a memory pool that returns memory blocks as soon as they are no longer used.
+        /// It is the same as \ref bitmap_array_pool but the bitmap of each block also counts its free nodes,
+        /// so once the last node of a block is deallocated, \ref memory_pool gives the block back to the \concept{concept_blockallocator,BlockAllocator},
+        /// even if it is in the middle of the other blocks.
+        /// A block is only kept if it is the only one with free nodes left,
+        /// so allocating and deallocating a node at the boundary does not allocate a new block each time.
+        /// Use it for pools whose peak usage is much higher than the usual one
+        /// and whose nodes are not deallocated in the reversed order of allocation, so \ref memory_pool::shrink_to_fit() does not help.
+        /// \requires The \concept{concept_blockallocator,BlockAllocator} must allow deallocating its blocks in any order,
+        /// see \ref memory_arena::deallocate_block(memory_block).
+        /// \ingroup allocator
+        struct releasing_bitmap_array_pool : FOONATHAN_EBO(std::true_type)
+        {
+            using type = detail::releasing_bitmap_free_memory_list;
+        };
+
+        /// Tag type defining a memory pool whose nodes never straddle a cache line.
+        /// It is the same as \ref node_pool but node sizes up to a cache line are rounded up to the next power of two
+        /// and bigger ones to a multiple of the cache line size, and the nodes of each block start at a cache line boundary.
+        /// So a node of the size of a cache line or bigger does not share a cache line with another node,
+        /// which prevents false sharing if nodes are used by different threads at the same time.
+        /// This costs memory for node sizes that are not already one of those sizes.
+        /// \ingroup allocator
+        struct cache_aligned_node_pool : FOONATHAN_EBO(std::true_type)
+        {
+            using type = detail::cache_aligned_free_memory_list;
+        };
+
         /// Tag type defining a memory pool optimized for small nodes.
         /// The free list is intrusive and thus requires that each node has at least the size of a pointer.
         /// This tag type does not have this requirement and thus allows zero-memory-overhead allocations of small nodes.
@@ -46,6 +92,112 @@ namespace foonathan
         {
             using type = detail::small_free_memory_list;
         };
+
+        /// Tag type defining a memory pool optimized for a large number of small nodes.
+        /// It is the same as \ref small_node_pool but stores up to 65535 instead of 255 nodes in one chunk,
+        /// which leads to fewer chunks and thus less chunk header overhead and faster chunk searches in big pools.
+        /// The minimum node size is two bytes.
+        /// It does not support arrays.
+        /// \ingroup allocator
+        struct wide_small_node_pool : FOONATHAN_EBO(std::false_type)
+        {
+            using type = detail::wide_small_free_memory_list;
+        };
+
+        /// Tag type defining a memory pool that can be shared between threads without a mutex.
+        /// \ref memory_pool::allocate_node() and \ref memory_pool::deallocate_node()
+        /// can be called concurrently, e.g. by a producer and a consumer thread.
+        /// On x86-64 the free list is lock-free, as the ABA tag is stored in the unused upper bits of the pointer.
+        /// On other platforms it needs a double-width compare-and-swap,
+        /// if the standard library does not provide one, it falls back to a lock in \c std::atomic.
+        /// Only the growth of the pool is serialized with a spin lock.
+        /// It is a little bit slower than \ref node_pool in single-threaded use and does not support arrays.
+        /// \ingroup allocator
+        struct concurrent_node_pool : FOONATHAN_EBO(std::false_type)
+        {
+            using type = detail::concurrent_free_memory_list;
+        };
+
+        /// Tag type defining a memory pool for nodes whose size and alignment are known at compile time,
+        /// e.g. those of a specific struct.
+        /// It is the same as \ref node_pool but the free list does not store the node size,
+        /// so all computations with it are done with constants and the \ref memory_pool object is smaller.
+        /// The node size passed to the \ref memory_pool must not be bigger than \c NodeSize,
+        /// the actual node size is \c NodeSize rounded up to a multiple of \c Alignment and to the size of a pointer.
+        /// By default, \c Alignment is the one a \ref node_pool uses for \c NodeSize.
+        /// It does not support arrays.
+        /// \ingroup allocator
+        template <std::size_t NodeSize,
+                  std::size_t Alignment = detail::fixed_alignment_for(NodeSize)>
+        struct fixed_node_pool : FOONATHAN_EBO(std::false_type)
+        {
+            using type = detail::fixed_free_memory_list<NodeSize, Alignment>;
+        };
+
+        namespace detail
+        {
+            // the usable size of memory inserted into a free list,
+            // exact for the free lists where it depends on the address of the memory
+            template <class FreeList>
+            auto inserted_size(int, const FreeList& list, const void* mem,
+                               std::size_t size) noexcept -> decltype(list.usable_size(mem, size))
+            {
+                return list.usable_size(mem, size);
+            }
+
+            template <class FreeList>
+            std::size_t inserted_size(short, const FreeList& list, const void*,
+                                      std::size_t size) noexcept
+            {
+                return list.usable_size(size);
+            }
+
+            // the number of nodes of a free list that were never allocated,
+            // only tracked by the free lists that link the nodes lazily
+            template <class FreeList>
+            auto untouched_capacity(int, const FreeList& list) noexcept
+                -> decltype(list.untouched_capacity())
+            {
+                return list.untouched_capacity();
+            }
+
+            template <class FreeList>
+            std::size_t untouched_capacity(short, const FreeList&) noexcept
+            {
+                return 0u;
+            }
+
+            // inserts a block into a free list,
+            // telling the free lists that track zeroed memory whether it is zeroed
+            template <class FreeList>
+            auto insert_block(int, FreeList& list, void* mem, std::size_t size,
+                              bool zeroed) noexcept -> decltype(list.insert(mem, size, zeroed))
+            {
+                list.insert(mem, size, zeroed);
+            }
+
+            template <class FreeList>
+            void insert_block(short, FreeList& list, void* mem, std::size_t size, bool) noexcept
+            {
+                list.insert(mem, size);
+            }
+
+            // allocates a node whose bytes are all zero,
+            // the free lists that track zeroed memory only clear it if needed
+            template <class FreeList>
+            auto allocate_zeroed(int, FreeList& list) noexcept -> decltype(list.allocate_zeroed())
+            {
+                return list.allocate_zeroed();
+            }
+
+            template <class FreeList>
+            void* allocate_zeroed(short, FreeList& list) noexcept
+            {
+                auto node = list.allocate();
+                std::memset(node, 0, list.node_size());
+                return node;
+            }
+        } // namespace detail
     } // namespace memory
 } // namespace foonathan
 
@@ -0,0 +1,239 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_MEMORY_REGION_HPP_INCLUDED
+#define FOONATHAN_MEMORY_MEMORY_REGION_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::memory_region.
+
+#include <new>
+#include <type_traits>
+
+#include "detail/utility.hpp"
+#include "config.hpp"
+#include "default_allocator.hpp"
+#include "memory_stack.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        namespace detail
+        {
+            // stored in the region right before the object it destroys
+            struct region_finalizer
+            {
+                region_finalizer* next;
+                void (*finalize)(void*);
+                void* object;
+            };
+
+            template <typename T>
+            void destroy_region_object(void* object) noexcept
+            {
+                static_cast<T*>(object)->~T();
+            }
+
+            template <class Stack>
+            struct region_marker
+            {
+                typename Stack::marker stack;
+                region_finalizer*      finalizers;
+            };
+        } // namespace detail
+
+        /// A \ref memory_stack that also destroys the objects created in it.
+        /// Objects are created by \ref create() with the speed of a stack allocation,
+        /// if they are not trivially destructible a finalizer is registered for them.
+        /// The finalizers form an intrusive list stored in the memory of the stack itself,
+        /// so registering one does not need any additional allocation.
+        /// \ref unwind() runs the finalizers registered after the marker in reverse order
+        /// and then releases all the memory in one step, like \ref memory_stack::unwind();
+        /// the destructor runs all remaining finalizers.
+        /// This gives objects with a lifetime bound to a scope, like a request,
+        /// without tracking and destroying them individually.
+        /// \note It provides \c marker, \c top() and \c unwind(),
+        /// so it can be used with a \ref memory_stack_raii_unwind.
+        /// \ingroup allocator
+        template <class BlockOrRawAllocator = default_allocator>
+        class memory_region
+        {
+            using stack_type = memory_stack<BlockOrRawAllocator>;
+
+        public:
+            using allocator_type = typename stack_type::allocator_type;
+
+            /// The type of a finalizer registered with \ref add_finalizer().
+            using finalizer = void (*)(void*);
+
+            /// \returns The minimum block size required for a region containing the given amount of memory.
+            /// \note Each object that is not trivially destructible needs additional memory for its finalizer.
+            static constexpr std::size_t min_block_size(std::size_t byte_size) noexcept
+            {
+                return stack_type::min_block_size(byte_size);
+            }
+
+            /// \effects Creates it with a given initial block size and other constructor arguments for the \concept{concept_blockallocator,BlockAllocator}.
+            /// \requires \c block_size must be at least \c min_block_size(1).
+            template <typename... Args>
+            explicit memory_region(std::size_t block_size, Args&&... args)
+            : stack_(block_size, detail::forward<Args>(args)...), finalizers_(nullptr)
+            {
+            }
+
+            memory_region(memory_region&& other) noexcept
+            : stack_(detail::move(other.stack_)), finalizers_(other.finalizers_)
+            {
+                other.finalizers_ = nullptr;
+            }
+
+            /// \effects Runs all finalizers in reverse order of their registration,
+            /// then releases the memory.
+            ~memory_region() noexcept
+            {
+                finalize(nullptr);
+            }
+
+            memory_region& operator=(memory_region&& other) noexcept
+            {
+                finalize(nullptr);
+                stack_            = detail::move(other.stack_);
+                finalizers_       = other.finalizers_;
+                other.finalizers_ = nullptr;
+                return *this;
+            }
+
+            /// \effects Creates an object of type \c T in the region, forwarding the arguments to its constructor.
+            /// If \c T is not trivially destructible, its destructor is registered as finalizer.
+            /// If the constructor throws, the memory is released again.
+            /// \returns A pointer to the object, it is destroyed by \ref unwind() or the destructor of the region.
+            /// \throws Anything thrown by the allocation or the constructor.
+            template <typename T, typename... Args>
+            T* create(Args&&... args)
+            {
+                auto m      = top();
+                auto record = allocate_finalizer(std::is_trivially_destructible<T>{});
+                auto memory = stack_.allocate(sizeof(T), alignof(T));
+
+                T* object = nullptr;
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+                try
+                {
+                    object = ::new (memory) T(detail::forward<Args>(args)...);
+                }
+                catch (...)
+                {
+                    stack_.unwind(m.stack);
+                    throw;
+                }
+#else
+                object = ::new (memory) T(detail::forward<Args>(args)...);
+#endif
+                if (record)
+                    link_finalizer(record, &detail::destroy_region_object<T>, object);
+                return object;
+            }
+
+            /// \effects Allocates raw memory of given size and alignment,
+            /// it is released by \ref unwind() or the destructor of the region.
+            /// \returns The memory.
+            /// \throws Anything thrown by \ref memory_stack::allocate().
+            void* allocate(std::size_t size, std::size_t alignment)
+            {
+                return stack_.allocate(size, alignment);
+            }
+
+            /// \effects Registers a function that is called with \c object
+            /// when the region is unwound to a marker obtained before this call or destroyed,
+            /// before the memory is released.
+            /// \throws Anything thrown by \ref memory_stack::allocate(), the function is not registered then.
+            /// \requires \c f must not throw.
+            void add_finalizer(finalizer f, void* object)
+            {
+                link_finalizer(allocate_finalizer(std::false_type{}), f, object);
+            }
+
+            /// The marker type that is used for unwinding.
+            using marker = FOONATHAN_IMPL_DEFINED(detail::region_marker<stack_type>);
+
+            /// \returns A marker to the current top of the region.
+            marker top() const noexcept
+            {
+                return {stack_.top(), finalizers_};
+            }
+
+            /// \effects Runs all finalizers registered since the marker was obtained in reverse order
+            /// and then unwinds the \ref memory_stack to it.
+            /// \requires The marker must have been obtained from this region
+            /// and the region must not have been unwound to an earlier marker since.
+            void unwind(marker m) noexcept
+            {
+                finalize(m.finalizers);
+                stack_.unwind(m.stack);
+            }
+
+            /// \returns The amount of memory remaining in the current block.
+            std::size_t capacity_left() const noexcept
+            {
+                return stack_.capacity_left();
+            }
+
+            /// \returns The size of the next memory block after the current block is exhausted.
+            std::size_t next_capacity() const noexcept
+            {
+                return stack_.next_capacity();
+            }
+
+            /// \returns A reference to the \concept{concept_blockallocator,BlockAllocator} used for managing the arena.
+            /// \requires It is undefined behavior to move this allocator out into another object.
+            allocator_type& get_allocator() noexcept
+            {
+                return stack_.get_allocator();
+            }
+
+        private:
+            detail::region_finalizer* allocate_finalizer(std::true_type)
+            {
+                return nullptr;
+            }
+
+            detail::region_finalizer* allocate_finalizer(std::false_type)
+            {
+                return static_cast<detail::region_finalizer*>(
+                    stack_.allocate(sizeof(detail::region_finalizer),
+                                    alignof(detail::region_finalizer)));
+            }
+
+            void link_finalizer(detail::region_finalizer* record, finalizer f,
+                                void* object) noexcept
+            {
+                record->next     = finalizers_;
+                record->finalize = f;
+                record->object   = object;
+                finalizers_      = record;
+            }
+
+            void finalize(detail::region_finalizer* until) noexcept
+            {
+                while (finalizers_ != until)
+                {
+                    FOONATHAN_MEMORY_ASSERT(finalizers_);
+                    // unlink first, so a finalizer sees a consistent list
+                    auto record = finalizers_;
+                    finalizers_ = record->next;
+                    record->finalize(record->object);
+                }
+            }
+
+            stack_type                stack_;
+            detail::region_finalizer* finalizers_;
+        };
+
+#if FOONATHAN_MEMORY_EXTERN_TEMPLATE
+        extern template class memory_region<>;
+#endif
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_MEMORY_REGION_HPP_INCLUDED
@@ -0,0 +1,177 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_MEMORY_RESOURCES_HPP_INCLUDED
+#define FOONATHAN_MEMORY_MEMORY_RESOURCES_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::pool_resource and \ref foonathan::memory::monotonic_resource.
+
+#include "detail/align.hpp"
+#include "detail/utility.hpp"
+#include "allocator_traits.hpp"
+#include "config.hpp"
+#include "default_allocator.hpp"
+#include "memory_pool_collection.hpp"
+#include "memory_resource_adapter.hpp"
+#include "memory_stack.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// A \ref memory_resource that allocates from a \ref memory_pool_collection.
+        /// Unlike a \ref memory_resource_adapter of the collection,
+        /// it directly calls the functions of the collection in its virtual functions,
+        /// so an allocation is only the virtual call followed by the lookup of the pool of the size class.
+        /// Allocations bigger than the maximum node size of the collection
+        /// or over-aligned ones are forwarded to the \ref default_allocator.
+        /// It is the equivalent of a \c std::pmr::unsynchronized_pool_resource and not thread-safe either.
+        /// \ingroup adapter
+        template <class PoolType = node_pool, class BucketDistribution = log2_buckets,
+                  class BlockOrRawAllocator = default_allocator>
+        class pool_resource : public memory_resource
+        {
+            using upstream_traits = allocator_traits<default_allocator>;
+
+        public:
+            using collection_type =
+                memory_pool_collection<PoolType, BucketDistribution, BlockOrRawAllocator>;
+
+            /// \effects Creates it by creating the \ref memory_pool_collection with the same arguments.
+            template <typename... Args>
+            pool_resource(std::size_t max_node_size, std::size_t block_size, Args&&... args)
+            : pools_(max_node_size, block_size, detail::forward<Args>(args)...)
+            {
+            }
+
+            /// @{
+            /// \returns A reference to the \ref memory_pool_collection used for the allocations.
+            collection_type& get_collection() noexcept
+            {
+                return pools_;
+            }
+
+            const collection_type& get_collection() const noexcept
+            {
+                return pools_;
+            }
+            /// @}
+
+        protected:
+            /// \effects Allocates a node from the pool of the size class of \c bytes,
+            /// or from the \ref default_allocator if it is too big or over-aligned.
+            /// \returns The new memory.
+            /// \throws Anything thrown by the \ref memory_pool_collection or \ref default_allocator.
+            void* do_allocate(std::size_t bytes, std::size_t alignment) override
+            {
+                auto size = node_size(bytes, alignment);
+                if (size <= pools_.max_node_size())
+                    return pools_.allocate_node(size);
+                return upstream_traits::allocate_node(upstream_, bytes, alignment);
+            }
+
+            /// \effects Deallocates memory previously allocated by \ref do_allocate.
+            /// \throws Nothing.
+            void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+            {
+                auto size = node_size(bytes, alignment);
+                if (size <= pools_.max_node_size())
+                    pools_.deallocate_node(p, size);
+                else
+                    upstream_traits::deallocate_node(upstream_, p, bytes, alignment);
+            }
+
+            /// \returns Whether or not \c *this is equal to \c other
+            /// by comparing the addresses.
+            bool do_is_equal(const memory_resource& other) const noexcept override
+            {
+                return this == &other;
+            }
+
+        private:
+            // the node size whose nodes have at least the given alignment,
+            // or the maximum value if there is none
+            static std::size_t node_size(std::size_t bytes, std::size_t alignment) noexcept
+            {
+                if (alignment > detail::max_alignment)
+                    return std::size_t(-1);
+                // the nodes of a bucket are placed right after each other,
+                // so a multiple of the alignment keeps all of them aligned
+                return bytes < alignment ? alignment : (bytes + alignment - 1u) & ~(alignment - 1u);
+            }
+
+            collection_type   pools_;
+            default_allocator upstream_;
+        };
+
+        /// A \ref memory_resource that allocates from a \ref memory_stack and never deallocates individual allocations.
+        /// Unlike a \ref memory_resource_adapter of the stack,
+        /// it directly calls the functions of the stack in its virtual functions,
+        /// so an allocation is only the virtual call followed by bumping the top of the stack.
+        /// All memory is freed on \ref release() or when it is destroyed.
+        /// It is the equivalent of a \c std::pmr::monotonic_buffer_resource and not thread-safe either.
+        /// \ingroup adapter
+        template <class BlockOrRawAllocator = default_allocator>
+        class monotonic_resource : public memory_resource
+        {
+        public:
+            using stack_type = memory_stack<BlockOrRawAllocator>;
+
+            /// \effects Creates it by creating the \ref memory_stack with the same arguments.
+            template <typename... Args>
+            explicit monotonic_resource(std::size_t block_size, Args&&... args)
+            : stack_(block_size, detail::forward<Args>(args)...), begin_(stack_.top())
+            {
+            }
+
+            /// \effects Frees all memory allocated from the resource
+            /// and gives all but the first block of the stack back to its \concept{concept_blockallocator,BlockAllocator}.
+            void release() noexcept
+            {
+                stack_.unwind(begin_);
+                stack_.shrink_to_fit();
+            }
+
+            /// @{
+            /// \returns A reference to the \ref memory_stack used for the allocations.
+            /// \note Unwinding it below the top at construction is not allowed.
+            stack_type& get_stack() noexcept
+            {
+                return stack_;
+            }
+
+            const stack_type& get_stack() const noexcept
+            {
+                return stack_;
+            }
+            /// @}
+
+        protected:
+            /// \effects Allocates from the \ref memory_stack.
+            /// \returns The new memory.
+            /// \throws Anything thrown by \ref memory_stack::allocate(),
+            /// i.e. \ref bad_allocation_size if the allocation does not fit into a block.
+            void* do_allocate(std::size_t bytes, std::size_t alignment) override
+            {
+                return stack_.allocate(bytes, alignment);
+            }
+
+            /// \effects Does nothing, the memory is freed by \ref release().
+            void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+            /// \returns Whether or not \c *this is equal to \c other
+            /// by comparing the addresses.
+            bool do_is_equal(const memory_resource& other) const noexcept override
+            {
+                return this == &other;
+            }
+
+        private:
+            stack_type                  stack_;
+            typename stack_type::marker begin_;
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_MEMORY_RESOURCES_HPP_INCLUDED
@@ -18,6 +18,7 @@
 #include "config.hpp"
 #include "error.hpp"
 #include "memory_arena.hpp"
+#include "virtual_memory.hpp"
 
 namespace foonathan
 {
@@ -92,6 +93,18 @@ namespace foonathan
             };
         } // namespace detail
 
+        /// The state of a \ref memory_stack that is needed to restore it from memory blocks that were kept,
+        /// e.g. from a file mapped by a \ref mmap_block_allocator.
+        /// It does not contain any pointers, so it can be written to disk as is.
+        /// \ingroup allocator
+        struct memory_stack_snapshot
+        {
+            /// The number of memory blocks in use.
+            std::size_t no_blocks;
+            /// The offset of the top in the last memory block.
+            std::size_t top_offset;
+        };
+
         /// A stateful \concept{concept_rawallocator,RawAllocator} that provides stack-like (LIFO) allocations.
         /// It uses a \ref memory_arena with a given \c BlockOrRawAllocator defaulting to \ref growing_block_allocator to allocate huge blocks
         /// and saves a marker to the current top.
@@ -122,8 +135,31 @@ namespace foonathan
             template <typename... Args>
             explicit memory_stack(std::size_t block_size, Args&&... args)
             : arena_(block_size, detail::forward<Args>(args)...),
-              stack_(arena_.allocate_block().memory)
+              stack_(arena_.allocate_block().memory),
+              zeroed_(arena_.last_block_zeroed() ? stack_.top() : block_end())
+            {
+                detail::debug_poison(stack_.top(), std::size_t(block_end() - stack_.top()));
+            }
+
+            /// \effects Creates it from a \ref memory_stack_snapshot of a previous stack,
+            /// passing the block size and the other arguments to the \concept{concept_blockallocator,BlockAllocator} like the other constructor.
+            /// It allocates as many blocks as the previous stack was using,
+            /// without modifying their contents, and sets the top to the same offset in the last one.
+            /// If the \concept{concept_blockallocator,BlockAllocator} returns the same memory in the same order,
+            /// e.g. a \ref mmap_block_allocator for the same file,
+            /// all the memory allocated from the previous stack is then allocated from this one,
+            /// so warm starting with previously built data structures does not require building them again.
+            /// \requires The \concept{concept_blockallocator,BlockAllocator} must return blocks of the same size as before.
+            /// \note Pointers in the data are only valid if the memory is at the same address as before,
+            /// otherwise use \ref offset_ptr.
+            template <typename... Args>
+            memory_stack(const memory_stack_snapshot& snapshot, std::size_t block_size,
+                         Args&&... args)
+            : arena_(block_size, detail::forward<Args>(args)...),
+              stack_(restore(snapshot)),
+              zeroed_(block_end())
             {
+                detail::debug_poison(stack_.top(), std::size_t(block_end() - stack_.top()));
             }
 
             /// \effects Allocates a memory block of given size and alignment.
@@ -140,12 +176,15 @@ namespace foonathan
                 auto fence  = detail::debug_fence_size;
                 auto offset = detail::align_offset(stack_.top() + fence, alignment);
 
-                if (!stack_.top()
-                    || fence + offset + size + fence > std::size_t(block_end() - stack_.top()))
+                if (FOONATHAN_MEMORY_UNLIKELY(
+                        !stack_.top()
+                        || fence + offset + size + fence > std::size_t(block_end() - stack_.top())))
                 {
                     // need to grow
                     auto block = arena_.allocate_block();
                     stack_     = detail::fixed_memory_stack(block.memory);
+                    zeroed_    = arena_.last_block_zeroed() ? stack_.top() : block_end();
+                    detail::debug_poison(block.memory, block.size);
 
                     // new alignment required for over-aligned types
                     offset = detail::align_offset(stack_.top() + fence, alignment);
@@ -157,6 +196,36 @@ namespace foonathan
                 return stack_.allocate_unchecked(size, offset);
             }
 
+            /// \effects Allocates a memory block like \ref allocate(),
+            /// but with a size and alignment known at compile-time,
+            /// so the alignment offset is not computed for an alignment of one
+            /// and the check of the remaining memory is done with constants.
+            /// \returns A \concept{concept_node,node} with given size and alignment.
+            /// \throws Anything thrown by \ref allocate() if a growth is needed.
+            /// \requires \c Size and \c Alignment must be valid.
+            template <std::size_t Size, std::size_t Alignment>
+            void* allocate()
+            {
+                auto memory = stack_.template allocate<Size, Alignment>(block_end());
+                if (FOONATHAN_MEMORY_LIKELY(memory))
+                    return memory;
+                return allocate(Size, Alignment);
+            }
+
+            /// \effects Allocates a memory block like \ref allocate() whose bytes are all zero.
+            /// Only the part of it that was used before is cleared,
+            /// memory of a new block the \ref memory_arena reports as zeroed is already zero,
+            /// e.g. fresh memory of a \ref virtual_block_allocator.
+            /// \returns A \concept{concept_node,node} with given size and alignment.
+            /// \throws Anything thrown by \ref allocate().
+            /// \requires \c size and \c alignment must be valid.
+            void* allocate_zeroed(std::size_t size, std::size_t alignment)
+            {
+                auto memory = allocate(size, alignment);
+                detail::clear_used_memory(memory, size, zeroed_);
+                return memory;
+            }
+
             /// \effects Allocates a memory block of given size and alignment,
             /// similar to \ref allocate().
             /// But it does not attempt a growth if the arena is empty.
@@ -167,6 +236,65 @@ namespace foonathan
                 return stack_.allocate(block_end(), size, alignment);
             }
 
+            /// \effects Allocates \c count memory blocks of given size and alignment at once
+            /// and stores them in \c nodes.
+            /// It moves the top marker only once by the size of all nodes,
+            /// which are laid out right after each other.
+            /// \throws Anything thrown by \ref allocate(),
+            /// or \ref bad_array_size if all nodes together are bigger than the \ref next_capacity().
+            /// \requires \c nodes must point to an array of at least \c count pointers
+            /// and \c size and \c alignment must be valid.
+            /// \note In debug mode, there is only one fence before the first and after the last node.
+            void allocate_batch(void** nodes, std::size_t count, std::size_t size,
+                                std::size_t alignment)
+            {
+                if (count == 0u)
+                    return;
+                auto stride = batch_stride(size, alignment);
+                if (FOONATHAN_MEMORY_UNLIKELY(!fits_batch(count, stride)))
+                    detail::throw_bad_allocation_size<bad_array_size>(info(),
+                                                                      batch_size(count, stride),
+                                                                      next_capacity());
+                auto memory = static_cast<char*>(allocate(count * stride, alignment));
+                for (std::size_t i = 0u; i != count; ++i)
+                    nodes[i] = memory + i * stride;
+            }
+
+            /// \effects Allocates \c count memory blocks similar to \ref allocate_batch().
+            /// But it does not attempt a growth if the arena is empty.
+            /// \returns `true` if all memory blocks have been allocated, `false` if none have been allocated.
+            bool try_allocate_batch(void** nodes, std::size_t count, std::size_t size,
+                                    std::size_t alignment) noexcept
+            {
+                if (count == 0u)
+                    return true;
+                auto stride = batch_stride(size, alignment);
+                if (!fits_batch(count, stride))
+                    return false;
+                auto memory = static_cast<char*>(try_allocate(count * stride, alignment));
+                if (!memory)
+                    return false;
+                for (std::size_t i = 0u; i != count; ++i)
+                    nodes[i] = memory + i * stride;
+                return true;
+            }
+
+            /// \effects Changes the size of the memory block returned by the last allocation in place.
+            /// If \c new_size is bigger than \c old_size, the top marker is moved further,
+            /// otherwise the memory at the end of the block is freed.
+            /// It does not attempt a growth if the current block is exhausted.
+            /// \returns `true` if the size has been changed,
+            /// `false` if there wasn't enough memory available in the current block
+            /// or the memory block wasn't returned by the last allocation.
+            /// \requires \c memory must have been allocated by this stack with the size \c old_size
+            /// and must not have been unwound.
+            bool try_expand(void* memory, std::size_t old_size, std::size_t new_size) noexcept
+            {
+                if (stack_.top() > zeroed_)
+                    zeroed_ = stack_.top();
+                return stack_.try_resize(block_end(), memory, old_size, new_size);
+            }
+
             /// The marker type that is used for unwinding.
             /// The exact type is implementation defined,
             /// it is only required that it is efficiently copyable
@@ -210,17 +338,34 @@ namespace foonathan
                         info(), m.top);
 
                     // mark memory from new top to end of the block as freed
+                    detail::debug_unpoison(m.top, std::size_t(m.end - m.top));
                     detail::debug_fill_free(m.top, std::size_t(m.end - m.top), 0);
-                    stack_ = detail::fixed_memory_stack(m.top);
+                    detail::debug_poison(m.top, std::size_t(m.end - m.top));
+                    stack_  = detail::fixed_memory_stack(m.top);
+                    zeroed_ = m.end;
                 }
                 else // same index
                 {
                     detail::debug_check_pointer([&] { return stack_.top() >= m.top; }, info(),
                                                 m.top);
+                    auto old_top = stack_.top();
+                    if (old_top > zeroed_)
+                        zeroed_ = old_top;
                     stack_.unwind(m.top);
+                    detail::debug_poison(m.top, std::size_t(old_top - m.top));
                 }
             }
 
+            /// \returns A \ref memory_stack_snapshot of the current top,
+            /// which can be used to restore the stack later on.
+            /// \note It does not include the cached memory blocks as their contents are not needed.
+            memory_stack_snapshot snapshot() const noexcept
+            {
+                auto block = arena_.current_block();
+                return {arena_.size(),
+                        std::size_t(stack_.top() - static_cast<const char*>(block.memory))};
+            }
+
             /// \effects \ref unwind() does not actually do any deallocation of blocks on the \concept{concept_blockallocator,BlockAllocator},
             /// unused memory is stored in a cache for later reuse.
             /// This function clears that cache.
@@ -229,6 +374,25 @@ namespace foonathan
                 arena_.shrink_to_fit();
             }
 
+            /// \effects Sets the limits of the cache of unused memory blocks,
+            /// blocks that do not fit are deallocated by \ref unwind().
+            /// This function just forwards to the \ref memory_arena.
+            void set_cache_limits(const arena_cache_limits& limits) noexcept
+            {
+                arena_.set_cache_limits(limits);
+            }
+
+            /// \effects Makes the memory remaining in the current block resident with \ref prefault_memory(),
+            /// so that the next allocations do not cause page faults.
+            /// Use a \ref prefault_block_allocator to do that for every new block.
+            void prefault() noexcept
+            {
+                auto size = capacity_left();
+                detail::debug_unpoison(stack_.top(), size);
+                prefault_memory(stack_.top(), size);
+                detail::debug_poison(stack_.top(), size);
+            }
+
             /// \returns The amount of memory remaining in the current block.
             /// This is the number of bytes that are available for allocation
             /// before the cache or \concept{concept_blockallocator,BlockAllocator} needs to be used.
@@ -237,6 +401,19 @@ namespace foonathan
                 return std::size_t(block_end() - stack_.top());
             }
 
+            /// \returns The memory usage of the stack.
+            /// The memory remaining in the current block counts as \c unused_bytes,
+            /// the rest of the blocks as \c used_bytes, including alignment buffers and fences
+            /// and the end of the previous blocks that was too small for the allocation that needed a new block.
+            /// \note This walks all blocks in use.
+            memory_stats stats() const noexcept
+            {
+                auto result = arena_.stats();
+                result.unused_bytes = capacity_left();
+                result.used_bytes -= result.unused_bytes;
+                return result;
+            }
+
             /// \returns The size of the next memory block after the current block is exhausted and the arena grows.
             /// This function just forwards to the \ref memory_arena.
             /// \note All of it is available for the stack to use, but due to fences and alignment buffers,
@@ -259,6 +436,34 @@ namespace foonathan
                 return {FOONATHAN_MEMORY_LOG_PREFIX "::memory_stack", this};
             }
 
+            char* restore(const memory_stack_snapshot& snapshot)
+            {
+                FOONATHAN_MEMORY_ASSERT(snapshot.no_blocks > 0u);
+                auto block = arena_.restore_block();
+                for (std::size_t i = 1u; i != snapshot.no_blocks; ++i)
+                    block = arena_.restore_block();
+                FOONATHAN_MEMORY_ASSERT(snapshot.top_offset <= block.size);
+                return static_cast<char*>(block.memory) + snapshot.top_offset;
+            }
+
+            // distance between two nodes of a batch, keeps all of them aligned
+            static std::size_t batch_stride(std::size_t size, std::size_t alignment) noexcept
+            {
+                return size + detail::align_offset(size, alignment);
+            }
+
+            // divides instead of multiplying, as count * stride may overflow
+            bool fits_batch(std::size_t count, std::size_t stride) const noexcept
+            {
+                return count <= next_capacity() / stride;
+            }
+
+            // the size of count nodes, saturated instead of overflowing
+            static std::size_t batch_size(std::size_t count, std::size_t stride) noexcept
+            {
+                return count > std::size_t(-1) / stride ? std::size_t(-1) : count * stride;
+            }
+
             const char* block_end() const noexcept
             {
                 auto block = arena_.current_block();
@@ -267,6 +472,8 @@ namespace foonathan
 
             memory_arena<allocator_type> arena_;
             detail::fixed_memory_stack   stack_;
+            // memory of the current block above both zeroed_ and the top is zero
+            const char*                  zeroed_;
 
             friend allocator_traits<memory_stack<BlockOrRawAllocator>>;
             friend composable_allocator_traits<memory_stack<BlockOrRawAllocator>>;
@@ -386,6 +593,9 @@ namespace foonathan
         public:
             using allocator_type = memory_stack<BlockAllocator>;
             using is_stateful    = std::true_type;
+            // the deallocation functions are needed for leak checking
+            using is_deallocation_noop =
+                std::integral_constant<bool, !FOONATHAN_MEMORY_DEBUG_LEAK_CHECK>;
 
             /// \returns The result of \ref memory_stack::allocate().
             static void* allocate_node(allocator_type& state, std::size_t size,
@@ -396,6 +606,15 @@ namespace foonathan
                 return mem;
             }
 
+            /// \returns The result of \ref memory_stack::allocate() for a size and alignment known at compile-time.
+            template <std::size_t Size, std::size_t Alignment>
+            static void* allocate_node(allocator_type& state)
+            {
+                auto mem = state.template allocate<Size, Alignment>();
+                state.on_allocate(Size);
+                return mem;
+            }
+
             /// \returns The result of \ref memory_stack::allocate().
             static void* allocate_array(allocator_type& state, std::size_t count, std::size_t size,
                                         std::size_t alignment)
@@ -403,6 +622,30 @@ namespace foonathan
                 return allocate_node(state, count * size, alignment);
             }
 
+            /// \returns The result of \ref memory_stack::allocate_zeroed().
+            static void* allocate_node_zeroed(allocator_type& state, std::size_t size,
+                                              std::size_t alignment)
+            {
+                auto mem = state.allocate_zeroed(size, alignment);
+                state.on_allocate(size);
+                return mem;
+            }
+
+            /// \returns The result of \ref memory_stack::allocate_zeroed().
+            static void* allocate_array_zeroed(allocator_type& state, std::size_t count,
+                                               std::size_t size, std::size_t alignment)
+            {
+                return allocate_node_zeroed(state, count * size, alignment);
+            }
+
+            /// \effects Calls \ref memory_stack::allocate_batch().
+            static void allocate_node_batch(allocator_type& state, void** nodes, std::size_t count,
+                                            std::size_t size, std::size_t alignment)
+            {
+                state.allocate_batch(nodes, count, size, alignment);
+                state.on_allocate(count * size);
+            }
+
             /// @{
             /// \effects Does nothing besides bookmarking for leak checking, if that is enabled.
             /// Actual deallocation can only be done via \ref memory_stack::unwind().
@@ -412,6 +655,13 @@ namespace foonathan
                 state.on_deallocate(size);
             }
 
+            static void deallocate_node_batch(allocator_type& state, void* const*,
+                                              std::size_t count, std::size_t size,
+                                              std::size_t) noexcept
+            {
+                state.on_deallocate(count * size);
+            }
+
             static void deallocate_array(allocator_type& state, void* ptr, std::size_t count,
                                          std::size_t size, std::size_t alignment) noexcept
             {
@@ -419,6 +669,27 @@ namespace foonathan
             }
             /// @}
 
+            /// @{
+            /// \returns The result of \ref memory_stack::try_expand().
+            static bool try_expand_node(allocator_type& state, void* node, std::size_t old_size,
+                                        std::size_t new_size, std::size_t) noexcept
+            {
+                if (!state.try_expand(node, old_size, new_size))
+                    return false;
+                state.on_deallocate(old_size);
+                state.on_allocate(new_size);
+                return true;
+            }
+
+            static bool try_expand_array(allocator_type& state, void* array, std::size_t old_count,
+                                         std::size_t new_count, std::size_t size,
+                                         std::size_t alignment) noexcept
+            {
+                return try_expand_node(state, array, old_count * size, new_count * size,
+                                       alignment);
+            }
+            /// @}
+
             /// @{
             /// \returns The maximum size which is \ref memory_stack::next_capacity().
             static std::size_t max_node_size(const allocator_type& state) noexcept
@@ -462,6 +733,14 @@ namespace foonathan
                 return state.try_allocate(count * size, alignment);
             }
 
+            /// \returns The result of \ref memory_stack::try_allocate_batch().
+            static bool try_allocate_node_batch(allocator_type& state, void** nodes,
+                                                std::size_t count, std::size_t size,
+                                                std::size_t alignment) noexcept
+            {
+                return state.try_allocate_batch(nodes, count, size, alignment);
+            }
+
             /// @{
             /// \effects Does nothing.
             /// \returns Whether the memory will be deallocated by \ref memory_stack::unwind().
@@ -476,6 +755,13 @@ namespace foonathan
             {
                 return try_deallocate_node(state, ptr, count * size, alignment);
             }
+
+            static bool try_deallocate_node_batch(allocator_type& state, void* const* nodes,
+                                                  std::size_t count, std::size_t,
+                                                  std::size_t) noexcept
+            {
+                return count == 0u || state.arena_.owns(nodes[0]);
+            }
             /// @}
         };
 
@@ -0,0 +1,210 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_METRICS_EXPORTER_HPP_INCLUDED
+#define FOONATHAN_MEMORY_METRICS_EXPORTER_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::metrics_registry and related classes.
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "detail/utility.hpp"
+#include "config.hpp"
+#include "memory_arena.hpp"
+#include "statistics_tracker.hpp"
+
+#if !FOONATHAN_HOSTED_IMPLEMENTATION
+#error "metrics_registry requires a hosted implementation"
+#endif
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// Whether a metric of a \ref metric_sample can go up and down or only up.
+        /// \ingroup adapter
+        enum class metric_kind
+        {
+            gauge,
+            counter,
+        };
+
+        /// A single value exported by a \ref metrics_registry.
+        /// \ingroup adapter
+        struct metric_sample
+        {
+            /// The name of the metric, e.g. \c foonathan_memory_used_bytes.
+            const char* metric;
+            /// A description of the metric.
+            const char* help;
+            metric_kind kind;
+            /// The name the allocator was registered with.
+            const std::string& allocator;
+            std::size_t        value;
+        };
+
+        class metrics_registry;
+
+        namespace detail
+        {
+            struct metrics_entry
+            {
+                std::string                   name;
+                std::function<memory_stats()> query;
+                const allocation_statistics*  statistics;
+                memory_stats                  stats;
+                bool                          has_stats;
+            };
+        } // namespace detail
+
+        /// The registration of an allocator in a \ref metrics_registry.
+        /// It removes the allocator from the registry when it is destroyed.
+        /// \ingroup adapter
+        class metrics_registration
+        {
+        public:
+            /// \effects Creates it without registering anything.
+            metrics_registration() noexcept : registry_(nullptr), entry_(nullptr) {}
+
+            metrics_registration(metrics_registration&& other) noexcept
+            : registry_(other.registry_), entry_(other.entry_)
+            {
+                other.registry_ = nullptr;
+                other.entry_    = nullptr;
+            }
+
+            /// \effects Removes the allocator from the registry, if there is one.
+            ~metrics_registration() noexcept;
+
+            metrics_registration& operator=(metrics_registration&& other) noexcept
+            {
+                metrics_registration tmp(detail::move(other));
+                std::swap(registry_, tmp.registry_);
+                std::swap(entry_, tmp.entry_);
+                return *this;
+            }
+
+            /// \effects Stores the memory usage of the allocator, it is exported until the next update.
+            /// This is meant for allocators that are not thread-safe:
+            /// the thread owning the allocator calls it periodically with the result of its \c stats() function,
+            /// which only copies it into the registry.
+            /// \requires The registration must have been returned by \ref metrics_registry::add(std::string).
+            void update(const memory_stats& stats) noexcept;
+
+            /// \returns Whether or not it refers to a registry.
+            explicit operator bool() const noexcept
+            {
+                return registry_ != nullptr;
+            }
+
+        private:
+            metrics_registration(metrics_registry&      registry,
+                                 detail::metrics_entry& entry) noexcept
+            : registry_(&registry), entry_(&entry)
+            {
+            }
+
+            metrics_registry*      registry_;
+            detail::metrics_entry* entry_;
+
+            friend metrics_registry;
+        };
+
+        /// A registry of named allocators whose memory usage is exported as metrics,
+        /// e.g. in the Prometheus text format or through the callbacks of an OpenTelemetry observable instrument.
+        /// The allocators only need to provide a \c stats() function like \ref memory_pool::stats()
+        /// or an \ref allocation_statistics object, so nothing is added to their allocation functions;
+        /// the values are only added up and formatted when the metrics are exported.
+        /// \note All member functions are thread-safe.
+        /// \ingroup adapter
+        class metrics_registry
+        {
+        public:
+            metrics_registry() = default;
+
+            metrics_registry(const metrics_registry&)            = delete;
+            metrics_registry& operator=(const metrics_registry&) = delete;
+
+            /// \effects Registers an allocator whose memory usage is set via \ref metrics_registration::update().
+            /// \returns The registration that can be used to update it.
+            metrics_registration add(std::string name);
+
+            /// \effects Registers an allocator whose memory usage is queried by calling the function on each export.
+            /// \requires The function must be safe to call from any thread exporting the metrics
+            /// and must not access the registry.
+            /// \returns The registration.
+            metrics_registration add(std::string name, std::function<memory_stats()> query);
+
+            /// \effects Registers the statistics of one or more \ref statistics_tracker objects,
+            /// they are read on each export.
+            /// \requires The statistics must outlive the registration.
+            /// \returns The registration.
+            metrics_registration add(std::string name, const allocation_statistics& statistics);
+
+            /// \effects Calls \c f with a \ref metric_sample for each metric of each registered allocator,
+            /// all samples of one metric are consecutive.
+            /// This can be called from an OpenTelemetry callback to report them.
+            void collect(const std::function<void(const metric_sample&)>& f) const;
+
+            /// \returns The metrics of all registered allocators in the Prometheus text exposition format,
+            /// with the name of the allocator in the label \c allocator.
+            std::string prometheus() const;
+
+            /// \effects Writes \ref prometheus() to a temporary file and renames it to \c path,
+            /// so a reader like the textfile collector of the Prometheus node exporter never sees a partial file.
+            /// \returns Whether or not it succeeded.
+            bool write_prometheus(const char* path) const;
+
+        private:
+            mutable std::mutex               mutex_;
+            std::list<detail::metrics_entry> entries_;
+
+            friend metrics_registration;
+        };
+
+        /// Calls a function with a \ref metrics_registry periodically on a background thread,
+        /// e.g. to write the metrics with \ref metrics_registry::write_prometheus()
+        /// or send them somewhere.
+        /// \ingroup adapter
+        class metrics_publisher
+        {
+        public:
+            /// \effects Starts the background thread calling \c publish with the registry every \c interval,
+            /// starting after the first interval.
+            /// \requires The registry must outlive the publisher.
+            metrics_publisher(const metrics_registry& registry, std::chrono::milliseconds interval,
+                              std::function<void(const metrics_registry&)> publish);
+
+            /// \effects Stops the background thread, without publishing again.
+            ~metrics_publisher() noexcept;
+
+            metrics_publisher(const metrics_publisher&)            = delete;
+            metrics_publisher& operator=(const metrics_publisher&) = delete;
+
+            /// \effects Calls the function immediately on the calling thread.
+            void publish_now();
+
+        private:
+            void run() noexcept;
+
+            const metrics_registry*                      registry_;
+            std::function<void(const metrics_registry&)> publish_;
+            std::chrono::milliseconds                    interval_;
+            std::mutex                                   mutex_;
+            std::condition_variable                      wakeup_;
+            bool                                         stop_;
+            std::thread                                  thread_;
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_METRICS_EXPORTER_HPP_INCLUDED
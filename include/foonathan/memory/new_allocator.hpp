@@ -26,11 +26,13 @@ namespace foonathan
             {
                 static allocator_info info() noexcept;
 
-                static void* allocate(std::size_t size, std::size_t) noexcept;
+                static void* allocate(std::size_t size, std::size_t alignment) noexcept;
 
-                static void deallocate(void* ptr, std::size_t size, std::size_t) noexcept;
+                static void deallocate(void* ptr, std::size_t size, std::size_t alignment) noexcept;
 
                 static std::size_t max_node_size() noexcept;
+
+                static std::size_t max_alignment() noexcept;
             };
 
             FOONATHAN_MEMORY_LL_ALLOCATOR_LEAK_CHECKER(new_allocator_impl,
@@ -40,6 +42,9 @@ namespace foonathan
         /// A stateless \concept{concept_rawallocator,RawAllocator} that allocates memory using (nothrow) <tt>operator new</tt>.
         /// If the operator returns \c nullptr, it behaves like \c new and loops calling \c std::new_handler,
         /// but instead of throwing a \c std::bad_alloc exception, it throws \ref out_of_memory.
+        /// If the library is compiled with a standard that provides them,
+        /// over-aligned memory is allocated with the aligned <tt>operator new</tt> of C++17
+        /// and the sized <tt>operator delete</tt> of C++14 is used.
         /// \ingroup allocator
         using new_allocator =
             FOONATHAN_IMPL_DEFINED(detail::lowlevel_allocator<detail::new_allocator_impl>);
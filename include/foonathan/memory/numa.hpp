@@ -0,0 +1,194 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_NUMA_HPP_INCLUDED
+#define FOONATHAN_MEMORY_NUMA_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::numa_block_allocator and related functions.
+
+#include <cstddef>
+#include <new>
+
+#include "detail/assert.hpp"
+#include "detail/utility.hpp"
+#include "config.hpp"
+#include "error.hpp"
+#include "heap_allocator.hpp"
+#include "memory_arena.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// Special NUMA node value that refers to the node of the thread calling the function.
+        /// \ingroup allocator
+        constexpr unsigned numa_local_node = unsigned(-1);
+
+        /// \returns The number of NUMA nodes of the system.
+        /// This is \c 1 if the system does not support NUMA or it cannot be queried.
+        /// \ingroup allocator
+        std::size_t get_numa_node_count() noexcept;
+
+        /// \returns The NUMA node the calling thread currently runs on.
+        /// This is \c 0 if the system does not support NUMA or it cannot be queried.
+        /// \ingroup allocator
+        unsigned get_current_numa_node() noexcept;
+
+        /// Binds virtual memory to a NUMA node.
+        /// \effects Sets the memory policy of \c no_pages pages starting at the given address,
+        /// so that the physical memory is preferably taken from the given node once the pages are touched.
+        /// If the node has no free memory left, other nodes are used.
+        /// \returns Whether or not the policy could be set.
+        /// It cannot be set if the system does not support NUMA.
+        /// \requires The memory must be previously reserved and not yet touched,
+        /// \c node must be less than \ref get_numa_node_count() or \ref numa_local_node.
+        /// \ingroup allocator
+        bool virtual_memory_bind(void* memory, std::size_t no_pages, unsigned node) noexcept;
+
+        /// A \concept{concept_blockallocator,BlockAllocator} that allocates blocks bound to a certain NUMA node.
+        /// Each block is reserved and committed as virtual memory and bound via \ref virtual_memory_bind() in between.
+        /// The block size is rounded up to a multiple of the \ref virtual_memory_page_size
+        /// and will grow by a factor of \c 2 after each allocation.
+        /// \note If the system does not support NUMA, it behaves like a growing \ref virtual_memory_allocator.
+        /// \ingroup allocator
+        class numa_block_allocator
+        {
+        public:
+            /// \effects Creates it by giving it the initial block size and the NUMA node.
+            /// If the node is \ref numa_local_node,
+            /// each block is bound to the node of the thread calling \ref allocate_block().
+            /// \requires \c block_size must be greater than 0,
+            /// \c node must be less than \ref get_numa_node_count() or \ref numa_local_node.
+            explicit numa_block_allocator(std::size_t block_size,
+                                          unsigned    node = numa_local_node) noexcept;
+
+            /// \effects Allocates a new memory block bound to the node
+            /// and increases the block size for the next allocation.
+            /// \returns The new \ref memory_block.
+            /// \throws \ref out_of_memory if the virtual memory cannot be reserved or committed.
+            memory_block allocate_block();
+
+            /// \effects Deallocates a previously allocated memory block.
+            /// This does not decrease the block size.
+            /// \requires \c block must be previously returned by a call to \ref allocate_block().
+            void deallocate_block(memory_block block) noexcept;
+
+            /// \returns The size of the memory block returned by the next call to \ref allocate_block().
+            std::size_t next_block_size() const noexcept
+            {
+                return block_size_;
+            }
+
+            /// \returns The NUMA node the blocks are bound to, may be \ref numa_local_node.
+            unsigned node() const noexcept
+            {
+                return node_;
+            }
+
+        private:
+            allocator_info info() noexcept;
+
+            std::size_t block_size_;
+            unsigned    node_;
+        };
+
+#if FOONATHAN_MEMORY_EXTERN_TEMPLATE
+        extern template class memory_arena<numa_block_allocator, true>;
+        extern template class memory_arena<numa_block_allocator, false>;
+#endif
+
+        /// A collection of one \c Allocator object per NUMA node.
+        /// The \c Allocator is for example a \ref memory_pool, \ref memory_stack or \ref memory_arena using the \ref numa_block_allocator.
+        /// Each object is constructed with the arguments given in the constructor followed by its node,
+        /// so each of them takes its memory from its own node.
+        /// The object for the node of the calling thread can be obtained with \ref local().
+        /// \note The objects themselves are not synchronized,
+        /// and threads may migrate between nodes, so memory must be deallocated through the object
+        /// it was allocated from and not that of the current node.
+        /// \ingroup allocator
+        template <class Allocator>
+        class per_numa_node
+        {
+        public:
+            using allocator_type = Allocator;
+
+            /// \effects Creates one \c Allocator per NUMA node,
+            /// by passing it the arguments followed by the node.
+            /// \throws \ref out_of_memory if it cannot allocate the storage for the objects,
+            /// or anything thrown by the constructor of the \c Allocator.
+            template <typename... Args>
+            explicit per_numa_node(const Args&... args) : size_(get_numa_node_count())
+            {
+                auto memory = heap_alloc(size_ * sizeof(allocator_type));
+                if (!memory)
+                    FOONATHAN_THROW(
+                        out_of_memory({FOONATHAN_MEMORY_LOG_PREFIX "::per_numa_node", this},
+                                      size_ * sizeof(allocator_type)));
+                allocators_ = static_cast<allocator_type*>(memory);
+
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+                std::size_t i = 0u;
+                try
+                {
+                    for (; i != size_; ++i)
+                        ::new (static_cast<void*>(allocators_ + i))
+                            allocator_type(args..., static_cast<unsigned>(i));
+                }
+                catch (...)
+                {
+                    destroy(i);
+                    throw;
+                }
+#else
+                for (std::size_t i = 0u; i != size_; ++i)
+                    ::new (static_cast<void*>(allocators_ + i))
+                        allocator_type(args..., static_cast<unsigned>(i));
+#endif
+            }
+
+            per_numa_node(const per_numa_node&)            = delete;
+            per_numa_node& operator=(const per_numa_node&) = delete;
+
+            /// \effects Destroys all objects.
+            ~per_numa_node() noexcept
+            {
+                destroy(size_);
+            }
+
+            /// \returns The object of the NUMA node the calling thread currently runs on.
+            allocator_type& local() noexcept
+            {
+                return get(get_current_numa_node());
+            }
+
+            /// \returns The object of the given NUMA node.
+            /// \requires \c node must be less than \ref size().
+            allocator_type& get(unsigned node) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(node < size_);
+                return allocators_[node];
+            }
+
+            /// \returns The number of objects, i.e. the number of NUMA nodes.
+            std::size_t size() const noexcept
+            {
+                return size_;
+            }
+
+        private:
+            // destroys the first n objects and frees the storage
+            void destroy(std::size_t n) noexcept
+            {
+                for (std::size_t i = 0u; i != n; ++i)
+                    allocators_[i].~allocator_type();
+                heap_dealloc(allocators_, size_ * sizeof(allocator_type));
+            }
+
+            allocator_type* allocators_;
+            std::size_t     size_;
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_NUMA_HPP_INCLUDED
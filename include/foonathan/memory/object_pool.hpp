@@ -0,0 +1,238 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_OBJECT_POOL_HPP_INCLUDED
+#define FOONATHAN_MEMORY_OBJECT_POOL_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::object_pool and related classes.
+
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#include "detail/align.hpp"
+#include "detail/assert.hpp"
+#include "detail/utility.hpp"
+#include "config.hpp"
+#include "default_allocator.hpp"
+#include "memory_pool.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        template <typename T, class BlockOrRawAllocator>
+        class object_pool;
+
+        /// A deleter class that gives an object back to the \ref object_pool it was acquired from.
+        /// It has the same interface as the \ref allocator_deleter.
+        /// \ingroup adapter
+        template <typename T, class BlockOrRawAllocator>
+        class object_pool_deleter
+        {
+        public:
+            using pool_type  = object_pool<T, BlockOrRawAllocator>;
+            using value_type = T;
+
+            /// \effects Creates it without any associated pool.
+            /// The deleter must not be used if that is the case.
+            object_pool_deleter() noexcept : pool_(nullptr) {}
+
+            /// \effects Creates it giving back objects to the given pool.
+            explicit object_pool_deleter(pool_type& pool) noexcept : pool_(&pool) {}
+
+            /// \effects Calls \ref object_pool::release().
+            /// \requires The deleter must not have been created by the default constructor.
+            void operator()(value_type* pointer) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(pool_);
+                pool_->release(pointer);
+            }
+
+            /// \returns A reference to the pool.
+            /// \requires The deleter must not have been created by the default constructor.
+            pool_type& get_pool() const noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(pool_);
+                return *pool_;
+            }
+
+        private:
+            pool_type* pool_;
+        };
+
+        /// A pool of objects of type \c T built on a \ref memory_pool of type \ref node_pool.
+        /// Objects are handed out by \ref acquire() in a \c std::unique_ptr giving them back when it is destroyed.
+        /// If a reset function is given on construction, released objects are not destroyed:
+        /// the function is called on them and they are kept constructed until they are acquired again,
+        /// so objects owning internal buffers, like a \c std::vector, keep their capacity across reuse.
+        /// Otherwise, released objects are destroyed and only their memory is reused.
+        /// \note The released objects are linked through a pointer stored after each object,
+        /// so every node is that much bigger than \c T.
+        /// \ingroup allocator
+        template <typename T, class BlockOrRawAllocator = default_allocator>
+        class object_pool
+        {
+            struct slot
+            {
+                alignas(T) unsigned char storage[sizeof(T)];
+                slot* next;
+            };
+
+            using pool = memory_pool<node_pool, BlockOrRawAllocator>;
+
+            static_assert(alignof(slot) <= detail::max_alignment,
+                          "over-aligned types are not supported");
+
+        public:
+            using value_type     = T;
+            using allocator_type = typename pool::allocator_type;
+            using deleter_type   = object_pool_deleter<T, BlockOrRawAllocator>;
+            using handle         = std::unique_ptr<T, deleter_type>;
+
+            /// The type of the function that resets a released object, it must not throw.
+            using reset_function = void (*)(T&);
+
+            /// \returns The minimum block size required for a pool containing the given number of objects.
+            static constexpr std::size_t min_block_size(std::size_t number_of_objects) noexcept
+            {
+                return pool::min_block_size(sizeof(slot), number_of_objects);
+            }
+
+            /// \effects Creates it with the initial block size and other constructor arguments for the \concept{concept_blockallocator,BlockAllocator},
+            /// released objects are destroyed.
+            /// \requires \c block_size must be at least \c min_block_size(1).
+            template <typename... Args>
+            explicit object_pool(std::size_t block_size, Args&&... args)
+            : object_pool(nullptr, block_size, detail::forward<Args>(args)...)
+            {
+            }
+
+            /// \effects Creates it like the other constructor,
+            /// but released objects are kept constructed after \c reset is called on them.
+            /// If \c reset is \c nullptr, they are destroyed instead.
+            template <typename... Args>
+            object_pool(reset_function reset, std::size_t block_size, Args&&... args)
+            : pool_(sizeof(slot), block_size, detail::forward<Args>(args)...),
+              reset_(reset),
+              cached_(nullptr),
+              no_cached_(0u)
+            {
+            }
+
+            /// \effects Destroys the objects that are kept constructed.
+            /// \requires All handles must have been destroyed.
+            ~object_pool() noexcept
+            {
+                clear_cache();
+            }
+
+            object_pool(const object_pool&)            = delete;
+            object_pool& operator=(const object_pool&) = delete;
+
+            /// \effects Takes an object that is kept constructed, if there is one,
+            /// otherwise allocates a node and constructs a new object forwarding the arguments.
+            /// \returns A handle owning the object, it gives it back to the pool when it is destroyed.
+            /// \throws Anything thrown by the allocation or the constructor, no node is allocated then.
+            /// \note The arguments are ignored when a kept object is returned,
+            /// its state is what the reset function made it.
+            template <typename... Args>
+            handle acquire(Args&&... args)
+            {
+                if (cached_)
+                {
+                    auto s  = cached_;
+                    cached_ = s->next;
+                    --no_cached_;
+                    return handle(object(s), deleter_type(*this));
+                }
+
+                auto s = static_cast<slot*>(pool_.allocate_node());
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+                try
+                {
+                    ::new (static_cast<void*>(s->storage)) T(detail::forward<Args>(args)...);
+                }
+                catch (...)
+                {
+                    pool_.deallocate_node(s);
+                    throw;
+                }
+#else
+                ::new (static_cast<void*>(s->storage)) T(detail::forward<Args>(args)...);
+#endif
+                return handle(object(s), deleter_type(*this));
+            }
+
+            /// \effects Gives back an object, this is what the deleter of the handle calls.
+            /// If there is a reset function, it is called and the object is kept constructed,
+            /// otherwise it is destroyed and its node deallocated.
+            /// \requires \c object must have been acquired from this pool and released from its handle.
+            void release(T* object) noexcept
+            {
+                auto s = reinterpret_cast<slot*>(object);
+                if (reset_)
+                {
+                    reset_(*object);
+                    s->next = cached_;
+                    cached_ = s;
+                    ++no_cached_;
+                }
+                else
+                    destroy(s);
+            }
+
+            /// \effects Destroys all objects that are kept constructed and deallocates their nodes.
+            void clear_cache() noexcept
+            {
+                while (cached_)
+                {
+                    auto s  = cached_;
+                    cached_ = s->next;
+                    destroy(s);
+                }
+                no_cached_ = 0u;
+            }
+
+            /// \returns The number of released objects that are kept constructed.
+            std::size_t cached() const noexcept
+            {
+                return no_cached_;
+            }
+
+            /// \returns The number of objects that can be constructed before the underlying \ref memory_pool needs to grow,
+            /// not including the ones that are kept constructed.
+            std::size_t capacity_left() const noexcept
+            {
+                return pool_.capacity_left() / pool_.node_size();
+            }
+
+            /// \returns A reference to the \concept{concept_blockallocator,BlockAllocator} used for managing the arena.
+            /// \requires It is undefined behavior to move this allocator out into another object.
+            allocator_type& get_allocator() noexcept
+            {
+                return pool_.get_allocator();
+            }
+
+        private:
+            static T* object(slot* s) noexcept
+            {
+                return reinterpret_cast<T*>(s->storage);
+            }
+
+            void destroy(slot* s) noexcept
+            {
+                object(s)->~T();
+                pool_.deallocate_node(s);
+            }
+
+            pool           pool_;
+            reset_function reset_;
+            slot*          cached_;
+            std::size_t    no_cached_;
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_OBJECT_POOL_HPP_INCLUDED
@@ -0,0 +1,283 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_OWNER_THREAD_POOL_HPP_INCLUDED
+#define FOONATHAN_MEMORY_OWNER_THREAD_POOL_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::owner_thread_pool and its \ref foonathan::memory::allocator_traits specialization.
+
+#include <atomic>
+#include <thread>
+#include <type_traits>
+
+#include "detail/assert.hpp"
+#include "config.hpp"
+#include "error.hpp"
+#include "memory_pool.hpp"
+
+#if !FOONATHAN_HOSTED_IMPLEMENTATION
+#error "owner_thread_pool requires a hosted implementation"
+#endif
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// A stateful \concept{concept_rawallocator,RawAllocator} that is a \ref memory_pool owned by a single thread,
+        /// but whose \concept{concept_node,nodes} can be deallocated by any thread.
+        /// Only the owning thread may allocate and it deallocates directly into the pool without any synchronization.
+        /// Other threads push the nodes they deallocate onto a lock-free remote free list instead,
+        /// which the owner moves into the pool in bulk once the pool has no free nodes left.
+        /// This is useful for producer-consumer pipelines where the consumer frees the nodes of the producer,
+        /// without making each allocation of the producer lock a mutex like a \ref thread_safe_allocator.
+        /// \note Arrays can only be allocated and deallocated by the owning thread.
+        /// \ingroup allocator
+        template <typename PoolType = node_pool, class BlockOrRawAllocator = default_allocator>
+        class owner_thread_pool
+        {
+            using pool = memory_pool<PoolType, BlockOrRawAllocator>;
+
+        public:
+            using allocator_type = typename pool::allocator_type;
+            using pool_type      = PoolType;
+
+            static constexpr std::size_t min_node_size = pool::min_node_size;
+
+            /// \returns The minimum block size required for certain number of \concept{concept_node,node}.
+            /// \requires \c node_size must be a valid \concept{concept_node,node size}
+            /// and \c number_of_nodes must be a non-zero value.
+            static constexpr std::size_t min_block_size(std::size_t node_size,
+                                                        std::size_t number_of_nodes) noexcept
+            {
+                return pool::min_block_size(node_size, number_of_nodes);
+            }
+
+            /// \effects Creates it by creating the \ref memory_pool with the same arguments.
+            /// The calling thread becomes the owner.
+            template <typename... Args>
+            owner_thread_pool(std::size_t node_size, std::size_t block_size, Args&&... args)
+            : pool_(node_size, block_size, detail::forward<Args>(args)...),
+              owner_(std::this_thread::get_id()),
+              remote_(nullptr)
+            {
+            }
+
+            /// \note Other threads refer to the remote free list, so it can neither be copied nor moved.
+            owner_thread_pool(const owner_thread_pool&)            = delete;
+            owner_thread_pool& operator=(const owner_thread_pool&) = delete;
+
+            /// \effects Allocates a single \concept{concept_node,node} from the pool.
+            /// If it has no free nodes left, the nodes deallocated by other threads are moved into it first,
+            /// and only if there are none, the pool grows.
+            /// \returns A node of size \ref node_size() suitable aligned.
+            /// \throws Anything thrown by \ref memory_pool::allocate_node().
+            /// \requires It must be called by the owning thread.
+            void* allocate_node()
+            {
+                FOONATHAN_MEMORY_ASSERT_MSG(is_owner(), "only the owner can allocate");
+                if (auto node = pool_.try_allocate_node())
+                    return node;
+                drain_remote_frees();
+                return pool_.allocate_node();
+            }
+
+            /// \effects Allocates a single \concept{concept_node,node} similar to \ref allocate_node(),
+            /// but the pool will not grow.
+            /// \returns A suitable aligned node of size \ref node_size() or `nullptr`.
+            /// \requires It must be called by the owning thread.
+            void* try_allocate_node() noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT_MSG(is_owner(), "only the owner can allocate");
+                if (auto node = pool_.try_allocate_node())
+                    return node;
+                drain_remote_frees();
+                return pool_.try_allocate_node();
+            }
+
+            /// \effects Deallocates a single \concept{concept_node,node}.
+            /// If called by the owning thread, it is put back into the pool,
+            /// otherwise it is pushed onto the remote free list.
+            /// \requires \c ptr must be a result from a previous call to \ref allocate_node() on the same object.
+            void deallocate_node(void* ptr) noexcept
+            {
+                if (is_owner())
+                {
+                    pool_.deallocate_node(ptr);
+                    return;
+                }
+
+                auto node = static_cast<void**>(ptr);
+                auto head = remote_.load(std::memory_order_relaxed);
+                do
+                    *node = head;
+                while (!remote_.compare_exchange_weak(head, ptr, std::memory_order_release,
+                                                      std::memory_order_relaxed));
+            }
+
+            /// \effects Allocates an \concept{concept_array,array} of nodes from the pool.
+            /// \returns An array of \c n nodes of size \ref node_size() suitable aligned.
+            /// \throws Anything thrown by \ref memory_pool::allocate_array().
+            /// \requires It must be called by the owning thread.
+            void* allocate_array(std::size_t n)
+            {
+                FOONATHAN_MEMORY_ASSERT_MSG(is_owner(), "only the owner can allocate");
+                return pool_.allocate_array(n);
+            }
+
+            /// \effects Deallocates an \concept{concept_array,array} of nodes.
+            /// \requires It must be called by the owning thread
+            /// and \c ptr must be a result from a previous call to \ref allocate_array() with the same \c n on the same object.
+            void deallocate_array(void* ptr, std::size_t n) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT_MSG(is_owner(), "only the owner can deallocate arrays");
+                pool_.deallocate_array(ptr, n);
+            }
+
+            /// \effects Moves all nodes deallocated by other threads so far into the pool.
+            /// \returns The number of nodes moved.
+            /// \requires It must be called by the owning thread.
+            std::size_t drain_remote_frees() noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT_MSG(is_owner(), "only the owner can drain");
+                auto count = std::size_t(0u);
+                for (auto node = remote_.exchange(nullptr, std::memory_order_acquire); node;)
+                {
+                    auto next = *static_cast<void**>(node);
+                    pool_.deallocate_node(node);
+                    node = next;
+                    ++count;
+                }
+                return count;
+            }
+
+            /// \effects Makes the calling thread the owner, e.g. after the pool was created by another thread.
+            /// \requires No other thread may use the allocator at the same time.
+            void set_owner() noexcept
+            {
+                owner_ = std::this_thread::get_id();
+            }
+
+            /// \returns Whether or not the calling thread is the owner.
+            bool is_owner() const noexcept
+            {
+                return owner_ == std::this_thread::get_id();
+            }
+
+            /// \returns The size of each \concept{concept_node,node} in the pool.
+            std::size_t node_size() const noexcept
+            {
+                return pool_.node_size();
+            }
+
+            /// \returns The total amount of bytes remaining on the free list of the pool.
+            /// \note This does not include the nodes on the remote free list.
+            /// \requires It must be called by the owning thread.
+            std::size_t capacity_left() const noexcept
+            {
+                return pool_.capacity_left();
+            }
+
+            /// \returns A reference to the \ref memory_pool used by the owning thread.
+            /// \requires It must only be used by the owning thread.
+            pool& get_pool() noexcept
+            {
+                return pool_;
+            }
+
+        private:
+            allocator_info info() const noexcept
+            {
+                return {FOONATHAN_MEMORY_LOG_PREFIX "::owner_thread_pool", this};
+            }
+
+            static std::size_t node_count(const owner_thread_pool& state, std::size_t count,
+                                          std::size_t size) noexcept
+            {
+                auto bytes = count * size;
+                return bytes / state.node_size() + (bytes % state.node_size() != 0u);
+            }
+
+            pool            pool_;
+            std::thread::id owner_;
+            // written by other threads, so on a separate cache line
+            alignas(64) std::atomic<void*> remote_;
+
+            friend allocator_traits<owner_thread_pool>;
+        };
+
+        template <class PoolType, class BlockOrRawAllocator>
+        constexpr std::size_t owner_thread_pool<PoolType, BlockOrRawAllocator>::min_node_size;
+
+        /// Specialization of the \ref allocator_traits for \ref owner_thread_pool classes.
+        /// \ingroup allocator
+        template <class PoolType, class BlockOrRawAllocator>
+        class allocator_traits<owner_thread_pool<PoolType, BlockOrRawAllocator>>
+        {
+        public:
+            using allocator_type = owner_thread_pool<PoolType, BlockOrRawAllocator>;
+            using is_stateful    = std::true_type;
+
+            /// \returns The result of \ref owner_thread_pool::allocate_node().
+            /// \throws Anything thrown by the pool allocation function
+            /// or a \ref bad_allocation_size exception.
+            static void* allocate_node(allocator_type& state, std::size_t size,
+                                       std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_node_size>(size, max_node_size(state),
+                                                             state.info());
+                detail::check_allocation_size<bad_alignment>(
+                    alignment, [&] { return max_alignment(state); }, state.info());
+                return state.allocate_node();
+            }
+
+            /// \effects Forwards to \ref owner_thread_pool::allocate_array().
+            /// \returns A \concept{concept_array,array} with specified properties.
+            /// \requires The \c PoolType has to support array allocations.
+            /// \throws Anything thrown by the pool allocation function.
+            static void* allocate_array(allocator_type& state, std::size_t count, std::size_t size,
+                                        std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_node_size>(size, max_node_size(state),
+                                                             state.info());
+                detail::check_allocation_size<bad_alignment>(
+                    alignment, [&] { return max_alignment(state); }, state.info());
+                return state.allocate_array(allocator_type::node_count(state, count, size));
+            }
+
+            /// \effects Just forwards to \ref owner_thread_pool::deallocate_node().
+            static void deallocate_node(allocator_type& state, void* node, std::size_t,
+                                        std::size_t) noexcept
+            {
+                state.deallocate_node(node);
+            }
+
+            /// \effects Forwards to \ref owner_thread_pool::deallocate_array().
+            static void deallocate_array(allocator_type& state, void* array, std::size_t count,
+                                         std::size_t size, std::size_t) noexcept
+            {
+                state.deallocate_array(array, allocator_type::node_count(state, count, size));
+            }
+
+            /// \returns The maximum size of each node which is \ref owner_thread_pool::node_size().
+            static std::size_t max_node_size(const allocator_type& state) noexcept
+            {
+                return state.node_size();
+            }
+
+            /// \returns An upper bound on the maximum array size which is \ref memory_pool::next_capacity().
+            static std::size_t max_array_size(const allocator_type& state) noexcept
+            {
+                return state.pool_.next_capacity();
+            }
+
+            /// \returns The maximum alignment of the \ref memory_pool.
+            static std::size_t max_alignment(const allocator_type& state) noexcept
+            {
+                return allocator_traits<typename allocator_type::pool>::max_alignment(state.pool_);
+            }
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_OWNER_THREAD_POOL_HPP_INCLUDED
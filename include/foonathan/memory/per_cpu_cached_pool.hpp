@@ -0,0 +1,550 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_PER_CPU_CACHED_POOL_HPP_INCLUDED
+#define FOONATHAN_MEMORY_PER_CPU_CACHED_POOL_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::per_cpu_cached_pool and its \ref foonathan::memory::allocator_traits specialization.
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+#include "detail/align.hpp"
+#include "detail/assert.hpp"
+#include "config.hpp"
+#include "error.hpp"
+#include "heap_allocator.hpp"
+#include "memory_pool.hpp"
+
+#if !FOONATHAN_HOSTED_IMPLEMENTATION
+#error "per_cpu_cached_pool requires a hosted implementation"
+#endif
+
+namespace foonathan
+{
+    namespace memory
+    {
+        namespace detail
+        {
+            // the number of caches, the number of configured CPUs if they can be identified,
+            // otherwise the number of hardware threads
+            std::size_t cpu_cache_count() noexcept;
+
+            // the index of the cache of the calling thread, less than cpu_cache_count()
+            // it is the current CPU read from the rseq area registered by the C library,
+            // or from getcpu() without one, otherwise a per-thread value
+            std::size_t current_cpu_cache() noexcept;
+
+            // whether current_cpu_cache() returns the current CPU
+            bool cpu_caches_available() noexcept;
+        } // namespace detail
+
+        /// A stateful \concept{concept_rawallocator,RawAllocator} that puts a cache per CPU
+        /// in front of a shared \ref memory_pool.
+        /// Like \ref thread_cached_pool, each cache is a magazine of up to \c MagazineSize free \concept{concept_node,nodes}
+        /// that is refilled from or flushed to the shared pool, protected by a \c Mutex, in batches of half its size.
+        /// But the caches belong to the CPUs instead of the threads,
+        /// so the memory cached is bounded by the number of cores, not by the number of threads,
+        /// which makes a difference for processes with many mostly idle threads.
+        /// On Linux, the current CPU is read from the restartable sequence area the C library registers for each thread,
+        /// which is as cheap as a thread-local variable.
+        /// Without it, the caches are assigned to the threads in a round-robin fashion instead,
+        /// so they are shared by multiple threads, see \ref uses_cpu_caches().
+        /// \note A thread owns the cache only while it allocates or deallocates from it,
+        /// which requires a single uncontended atomic exchange.
+        /// If the thread is preempted or migrated meanwhile and another one finds the cache busy,
+        /// it uses the shared pool directly.
+        /// \note Nodes allocated on one CPU can be deallocated on any other one.
+        /// \ingroup allocator
+        template <typename PoolType = node_pool, class BlockOrRawAllocator = default_allocator,
+                  class Mutex = std::mutex, std::size_t MagazineSize = 64u>
+        class per_cpu_cached_pool
+        {
+            static_assert(MagazineSize >= 2u, "magazine must be able to store at least two nodes");
+
+            using pool = memory_pool<PoolType, BlockOrRawAllocator>;
+
+            // one cache line per CPU, so the caches do not share lines
+            struct cache
+            {
+                std::atomic<bool> busy;
+                std::size_t       count;
+                void*             nodes[MagazineSize];
+
+                bool try_lock() noexcept
+                {
+                    return !busy.load(std::memory_order_relaxed)
+                           && !busy.exchange(true, std::memory_order_acquire);
+                }
+
+                void unlock() noexcept
+                {
+                    busy.store(false, std::memory_order_release);
+                }
+            };
+
+            static constexpr std::size_t cache_line = 64u;
+            static constexpr std::size_t cache_stride =
+                (sizeof(cache) + cache_line - 1u) / cache_line * cache_line;
+
+            class cache_lock
+            {
+            public:
+                explicit cache_lock(cache& c) noexcept : c_(c) {}
+
+                ~cache_lock() noexcept
+                {
+                    c_.unlock();
+                }
+
+                cache_lock(const cache_lock&)            = delete;
+                cache_lock& operator=(const cache_lock&) = delete;
+
+            private:
+                cache& c_;
+            };
+
+        public:
+            using allocator_type = typename pool::allocator_type;
+            using pool_type      = PoolType;
+            using mutex          = Mutex;
+
+            static constexpr std::size_t min_node_size = pool::min_node_size;
+            static constexpr std::size_t magazine_size = MagazineSize;
+
+            /// \returns The minimum block size required for certain number of \concept{concept_node,node}.
+            /// \requires \c node_size must be a valid \concept{concept_node,node size}
+            /// and \c number_of_nodes must be a non-zero value.
+            static constexpr std::size_t min_block_size(std::size_t node_size,
+                                                        std::size_t number_of_nodes) noexcept
+            {
+                return pool::min_block_size(node_size, number_of_nodes);
+            }
+
+            /// \returns Whether or not the caches belong to the CPUs.
+            /// If this is \c false, they are assigned to the threads instead.
+            static bool uses_cpu_caches() noexcept
+            {
+                return detail::cpu_caches_available();
+            }
+
+            /// \effects Creates it by creating the shared \ref memory_pool with the same arguments
+            /// and allocating the caches for all CPUs with \ref heap_alloc().
+            /// \throws Anything thrown by the \ref memory_pool or \ref out_of_memory if the caches could not be allocated.
+            template <typename... Args>
+            per_cpu_cached_pool(std::size_t node_size, std::size_t block_size, Args&&... args)
+            : pool_(node_size, block_size, detail::forward<Args>(args)...),
+              memory_(nullptr),
+              caches_(nullptr),
+              no_caches_(detail::cpu_cache_count())
+            {
+                auto size = memory_size();
+                memory_   = heap_alloc(size);
+                if (!memory_)
+                    FOONATHAN_THROW(out_of_memory(info(), size));
+
+                auto offset = detail::align_offset(memory_, cache_line);
+                caches_     = static_cast<char*>(memory_) + offset;
+                for (std::size_t i = 0u; i != no_caches_; ++i)
+                {
+                    auto c = ::new (static_cast<void*>(caches_ + i * cache_stride)) cache;
+                    c->busy.store(false, std::memory_order_relaxed);
+                    c->count = 0u;
+                }
+            }
+
+            /// \effects Destroys the caches and the shared \ref memory_pool.
+            /// All nodes in the caches are discarded as well.
+            /// \requires No other thread may use it anymore.
+            ~per_cpu_cached_pool() noexcept
+            {
+                for (std::size_t i = 0u; i != no_caches_; ++i)
+                    get_cache(i).~cache();
+                heap_dealloc(memory_, memory_size());
+            }
+
+            per_cpu_cached_pool(const per_cpu_cached_pool&)            = delete;
+            per_cpu_cached_pool& operator=(const per_cpu_cached_pool&) = delete;
+
+            /// \effects Allocates a single \concept{concept_node,node} from the cache of the current CPU.
+            /// If it is empty, it will be refilled from the shared pool,
+            /// which may lead to a growth of the pool.
+            /// \returns A node of size \ref node_size() suitable aligned.
+            /// \throws Anything thrown by the shared \ref memory_pool.
+            void* allocate_node()
+            {
+                auto& c = current_cache();
+                if (!c.try_lock())
+                {
+                    std::lock_guard<Mutex> lock(mutex_);
+                    return pool_.allocate_node();
+                }
+
+                cache_lock lock(c);
+                if (c.count == 0u)
+                    refill(c);
+                FOONATHAN_MEMORY_ASSERT(c.count != 0u);
+                return c.nodes[--c.count];
+            }
+
+            /// \effects Allocates a single \concept{concept_node,node} similar to \ref allocate_node(),
+            /// but the shared pool will not grow.
+            /// \returns A suitable aligned node of size \ref node_size() or `nullptr`.
+            void* try_allocate_node() noexcept
+            {
+                auto& c = current_cache();
+                if (!c.try_lock())
+                {
+                    std::lock_guard<Mutex> lock(mutex_);
+                    return pool_.try_allocate_node();
+                }
+
+                cache_lock lock(c);
+                if (c.count == 0u && !try_refill(c))
+                    return nullptr;
+                return c.nodes[--c.count];
+            }
+
+            /// \effects Deallocates a single \concept{concept_node,node} by putting it into the cache of the current CPU.
+            /// If the cache is full, half of it will be returned to the shared pool.
+            /// \requires \c ptr must be a result from a previous call to \ref allocate_node() on the same object.
+            void deallocate_node(void* ptr) noexcept
+            {
+                auto& c = current_cache();
+                if (!c.try_lock())
+                {
+                    std::lock_guard<Mutex> lock(mutex_);
+                    pool_.deallocate_node(ptr);
+                    return;
+                }
+
+                cache_lock lock(c);
+                if (c.count == MagazineSize)
+                    flush(c, MagazineSize / 2u);
+                c.nodes[c.count++] = ptr;
+            }
+
+            /// \effects Deallocates a single \concept{concept_node,node} but it does not be a result of a previous call to \ref allocate_node().
+            /// \returns `true` if the node could be deallocated, `false` otherwise.
+            bool try_deallocate_node(void* ptr) noexcept
+            {
+                if (!owns(ptr))
+                    return false;
+                deallocate_node(ptr);
+                return true;
+            }
+
+            /// \effects Allocates an \concept{concept_array,array} of nodes from the shared pool directly,
+            /// arrays are not cached.
+            /// \returns An array of \c n nodes of size \ref node_size() suitable aligned.
+            /// \throws Anything thrown by \ref memory_pool::allocate_array().
+            void* allocate_array(std::size_t n)
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                return pool_.allocate_array(n);
+            }
+
+            /// \effects Allocates an \concept{concept_array,array} similar to \ref allocate_array(),
+            /// but the shared pool will not grow.
+            /// \returns An array of \c n nodes of size \ref node_size() suitable aligned or `nullptr`.
+            void* try_allocate_array(std::size_t n) noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                return pool_.try_allocate_array(n);
+            }
+
+            /// \effects Deallocates an \concept{concept_array,array} by returning it to the shared pool directly.
+            /// \requires \c ptr must be a result from a previous call to \ref allocate_array() with the same \c n on the same object.
+            void deallocate_array(void* ptr, std::size_t n) noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                pool_.deallocate_array(ptr, n);
+            }
+
+            /// \effects Deallocates an \concept{concept_array,array} but it does not be a result of a previous call to \ref allocate_array().
+            /// \returns `true` if the array could be deallocated, `false` otherwise.
+            bool try_deallocate_array(void* ptr, std::size_t n) noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                return pool_.try_deallocate_array(ptr, n);
+            }
+
+            /// \effects Returns the nodes of all caches to the shared pool,
+            /// caches that are in use by another thread at the moment are skipped.
+            void flush_caches() noexcept
+            {
+                for (std::size_t i = 0u; i != no_caches_; ++i)
+                {
+                    auto& c = get_cache(i);
+                    if (!c.try_lock())
+                        continue;
+                    cache_lock lock(c);
+                    flush(c, c.count);
+                }
+            }
+
+            /// \returns The size of each \concept{concept_node,node} in the pool.
+            std::size_t node_size() const noexcept
+            {
+                return pool_.node_size();
+            }
+
+            /// \returns The total amount of bytes remaining on the free list of the shared pool.
+            /// \note This does not include the nodes cached by the CPUs.
+            std::size_t capacity_left() noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                return pool_.capacity_left();
+            }
+
+            /// \returns The number of caches, one per CPU.
+            std::size_t cache_count() const noexcept
+            {
+                return no_caches_;
+            }
+
+            /// \returns The number of nodes in all the caches.
+            /// \note The result is only exact if no other thread uses it at the moment.
+            std::size_t cached_nodes() noexcept
+            {
+                std::size_t result = 0u;
+                for (std::size_t i = 0u; i != no_caches_; ++i)
+                {
+                    auto& c = get_cache(i);
+                    if (!c.try_lock())
+                        continue;
+                    cache_lock lock(c);
+                    result += c.count;
+                }
+                return result;
+            }
+
+            /// \returns Whether or not `ptr` is in memory owned by the shared pool.
+            bool owns(const void* ptr) noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                return pool_.owns(ptr);
+            }
+
+        private:
+            allocator_info info() const noexcept
+            {
+                return {FOONATHAN_MEMORY_LOG_PREFIX "::per_cpu_cached_pool", this};
+            }
+
+            std::size_t memory_size() const noexcept
+            {
+                return no_caches_ * cache_stride + cache_line;
+            }
+
+            cache& get_cache(std::size_t i) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(i < no_caches_);
+                return *static_cast<cache*>(static_cast<void*>(caches_ + i * cache_stride));
+            }
+
+            cache& current_cache() noexcept
+            {
+                return get_cache(detail::current_cpu_cache() % no_caches_);
+            }
+
+            static std::size_t node_count(const per_cpu_cached_pool& state, std::size_t count,
+                                          std::size_t size) noexcept
+            {
+                auto bytes = count * size;
+                return bytes / state.node_size() + (bytes % state.node_size() != 0u);
+            }
+
+            void refill(cache& c)
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                c.nodes[c.count++] = pool_.allocate_node();
+                refill_impl(c);
+            }
+
+            bool try_refill(cache& c) noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                refill_impl(c);
+                return c.count != 0u;
+            }
+
+            void refill_impl(cache& c) noexcept
+            {
+                while (c.count < MagazineSize / 2u)
+                {
+                    auto node = pool_.try_allocate_node();
+                    if (!node)
+                        break;
+                    c.nodes[c.count++] = node;
+                }
+            }
+
+            void flush(cache& c, std::size_t n) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(n <= c.count);
+                std::lock_guard<Mutex> lock(mutex_);
+                for (auto i = 0u; i != n; ++i)
+                    pool_.deallocate_node(c.nodes[--c.count]);
+            }
+
+            pool          pool_;
+            mutable Mutex mutex_;
+            void*         memory_;
+            char*         caches_;
+            std::size_t   no_caches_;
+
+            friend allocator_traits<per_cpu_cached_pool>;
+            friend composable_allocator_traits<per_cpu_cached_pool>;
+        };
+
+        template <class PoolType, class BlockOrRawAllocator, class Mutex, std::size_t MagazineSize>
+        constexpr std::size_t
+            per_cpu_cached_pool<PoolType, BlockOrRawAllocator, Mutex, MagazineSize>::min_node_size;
+
+        template <class PoolType, class BlockOrRawAllocator, class Mutex, std::size_t MagazineSize>
+        constexpr std::size_t
+            per_cpu_cached_pool<PoolType, BlockOrRawAllocator, Mutex, MagazineSize>::magazine_size;
+
+        template <class PoolType, class BlockOrRawAllocator, class Mutex, std::size_t MagazineSize>
+        constexpr std::size_t
+            per_cpu_cached_pool<PoolType, BlockOrRawAllocator, Mutex, MagazineSize>::cache_line;
+
+        template <class PoolType, class BlockOrRawAllocator, class Mutex, std::size_t MagazineSize>
+        constexpr std::size_t
+            per_cpu_cached_pool<PoolType, BlockOrRawAllocator, Mutex, MagazineSize>::cache_stride;
+
+        /// Specialization of the \ref allocator_traits for \ref per_cpu_cached_pool classes.
+        /// \ingroup allocator
+        template <class PoolType, class BlockOrRawAllocator, class Mutex, std::size_t MagazineSize>
+        class allocator_traits<
+            per_cpu_cached_pool<PoolType, BlockOrRawAllocator, Mutex, MagazineSize>>
+        {
+        public:
+            using allocator_type =
+                per_cpu_cached_pool<PoolType, BlockOrRawAllocator, Mutex, MagazineSize>;
+            using is_stateful = std::true_type;
+
+            /// \returns The result of \ref per_cpu_cached_pool::allocate_node().
+            /// \throws Anything thrown by the pool allocation function
+            /// or a \ref bad_allocation_size exception.
+            static void* allocate_node(allocator_type& state, std::size_t size,
+                                       std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_node_size>(size, max_node_size(state),
+                                                             state.info());
+                detail::check_allocation_size<bad_alignment>(
+                    alignment, [&] { return max_alignment(state); }, state.info());
+                return state.allocate_node();
+            }
+
+            /// \effects Forwards to \ref per_cpu_cached_pool::allocate_array().
+            /// \returns A \concept{concept_array,array} with specified properties.
+            /// \requires The \c PoolType has to support array allocations.
+            /// \throws Anything thrown by the pool allocation function.
+            static void* allocate_array(allocator_type& state, std::size_t count, std::size_t size,
+                                        std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_node_size>(size, max_node_size(state),
+                                                             state.info());
+                detail::check_allocation_size<bad_alignment>(
+                    alignment, [&] { return max_alignment(state); }, state.info());
+                return state.allocate_array(allocator_type::node_count(state, count, size));
+            }
+
+            /// \effects Just forwards to \ref per_cpu_cached_pool::deallocate_node().
+            static void deallocate_node(allocator_type& state, void* node, std::size_t,
+                                        std::size_t) noexcept
+            {
+                state.deallocate_node(node);
+            }
+
+            /// \effects Forwards to \ref per_cpu_cached_pool::deallocate_array().
+            static void deallocate_array(allocator_type& state, void* array, std::size_t count,
+                                         std::size_t size, std::size_t) noexcept
+            {
+                state.deallocate_array(array, allocator_type::node_count(state, count, size));
+            }
+
+            /// \returns The maximum size of each node which is \ref per_cpu_cached_pool::node_size().
+            static std::size_t max_node_size(const allocator_type& state) noexcept
+            {
+                return state.node_size();
+            }
+
+            /// \returns An upper bound on the maximum array size which is \ref memory_pool::next_capacity().
+            static std::size_t max_array_size(const allocator_type& state) noexcept
+            {
+                std::lock_guard<Mutex> lock(state.mutex_);
+                return state.pool_.next_capacity();
+            }
+
+            /// \returns The maximum alignment of the shared \ref memory_pool.
+            static std::size_t max_alignment(const allocator_type& state) noexcept
+            {
+                return allocator_traits<typename allocator_type::pool>::max_alignment(state.pool_);
+            }
+        };
+
+        /// Specialization of the \ref composable_allocator_traits for \ref per_cpu_cached_pool classes.
+        /// \ingroup allocator
+        template <class PoolType, class BlockOrRawAllocator, class Mutex, std::size_t MagazineSize>
+        class composable_allocator_traits<
+            per_cpu_cached_pool<PoolType, BlockOrRawAllocator, Mutex, MagazineSize>>
+        {
+            using traits = allocator_traits<
+                per_cpu_cached_pool<PoolType, BlockOrRawAllocator, Mutex, MagazineSize>>;
+
+        public:
+            using allocator_type =
+                per_cpu_cached_pool<PoolType, BlockOrRawAllocator, Mutex, MagazineSize>;
+
+            /// \returns The result of \ref per_cpu_cached_pool::try_allocate_node()
+            /// or `nullptr` if the allocation size was too big.
+            static void* try_allocate_node(allocator_type& state, std::size_t size,
+                                           std::size_t alignment) noexcept
+            {
+                if (size > traits::max_node_size(state) || alignment > traits::max_alignment(state))
+                    return nullptr;
+                return state.try_allocate_node();
+            }
+
+            /// \effects Forwards to \ref per_cpu_cached_pool::try_allocate_array().
+            /// \returns A \concept{concept_array,array} with specified properties
+            /// or `nullptr` if it was unable to allocate.
+            static void* try_allocate_array(allocator_type& state, std::size_t count,
+                                            std::size_t size, std::size_t alignment) noexcept
+            {
+                if (size > traits::max_node_size(state) || alignment > traits::max_alignment(state))
+                    return nullptr;
+                return state.try_allocate_array(allocator_type::node_count(state, count, size));
+            }
+
+            /// \effects Just forwards to \ref per_cpu_cached_pool::try_deallocate_node().
+            /// \returns Whether the deallocation was successful.
+            static bool try_deallocate_node(allocator_type& state, void* node, std::size_t size,
+                                            std::size_t alignment) noexcept
+            {
+                if (size > traits::max_node_size(state) || alignment > traits::max_alignment(state))
+                    return false;
+                return state.try_deallocate_node(node);
+            }
+
+            /// \effects Forwards to \ref per_cpu_cached_pool::try_deallocate_array().
+            /// \returns Whether the deallocation was successful.
+            static bool try_deallocate_array(allocator_type& state, void* array, std::size_t count,
+                                             std::size_t size, std::size_t alignment) noexcept
+            {
+                if (size > traits::max_node_size(state) || alignment > traits::max_alignment(state))
+                    return false;
+                return state.try_deallocate_array(array,
+                                                  allocator_type::node_count(state, count, size));
+            }
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_PER_CPU_CACHED_POOL_HPP_INCLUDED
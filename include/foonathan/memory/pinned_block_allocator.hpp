@@ -0,0 +1,195 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_PINNED_BLOCK_ALLOCATOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_PINNED_BLOCK_ALLOCATOR_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::pinned_block_allocator and pinning policies.
+
+#include "detail/utility.hpp"
+#include "config.hpp"
+#include "error.hpp"
+#include "memory_arena.hpp"
+#include "virtual_memory.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// A pinning policy for the \ref pinned_block_allocator that locks the memory with \ref lock_memory().
+        /// \ingroup allocator
+        struct mlock_pinner
+        {
+            /// \effects Locks the memory.
+            /// \returns Whether or not it succeeded.
+            bool pin(void* memory, std::size_t size) noexcept
+            {
+                return lock_memory(memory, size);
+            }
+
+            /// \effects Unlocks the memory.
+            void unpin(void* memory, std::size_t size) noexcept
+            {
+                unlock_memory(memory, size);
+            }
+        };
+
+        /// A pinning policy for the \ref pinned_block_allocator that forwards to user callbacks,
+        /// e.g. \c cudaHostRegister()/\c cudaHostUnregister() or \c ibv_reg_mr()/\c ibv_dereg_mr().
+        /// The user data is passed to each callback,
+        /// it can point to the state the registration needs, like the protection domain,
+        /// or to a registry that maps each block to its memory region handle.
+        /// \ingroup allocator
+        class callback_pinner
+        {
+        public:
+            /// The pin callback, it returns whether or not it succeeded.
+            using pin_function = bool (*)(void* memory, std::size_t size, void* user_data);
+            /// The unpin callback, it must not throw.
+            using unpin_function = void (*)(void* memory, std::size_t size, void* user_data);
+
+            /// \effects Creates it giving it the callbacks and the user data passed to them.
+            /// \requires \c pin and \c unpin must not be \c nullptr.
+            callback_pinner(pin_function pin, unpin_function unpin,
+                            void* user_data = nullptr) noexcept
+            : pin_(pin), unpin_(unpin), user_data_(user_data)
+            {
+                FOONATHAN_MEMORY_ASSERT(pin_ && unpin_);
+            }
+
+            /// \effects Calls the pin callback.
+            /// \returns The result of the callback.
+            bool pin(void* memory, std::size_t size) noexcept
+            {
+                return pin_(memory, size, user_data_);
+            }
+
+            /// \effects Calls the unpin callback.
+            void unpin(void* memory, std::size_t size) noexcept
+            {
+                unpin_(memory, size, user_data_);
+            }
+
+            /// \returns The user data.
+            void* user_data() const noexcept
+            {
+                return user_data_;
+            }
+
+        private:
+            pin_function   pin_;
+            unpin_function unpin_;
+            void*          user_data_;
+        };
+
+        /// A \concept{concept_blockallocator,BlockAllocator} adapter that pins each block when it is allocated
+        /// and unpins it when it is deallocated,
+        /// so memory handed out by a \ref memory_pool or \ref memory_stack using it is ready for DMA transfers,
+        /// e.g. to GPUs or RDMA network cards, without copying it to a pinned staging buffer.
+        /// As the arenas reuse their blocks, the expensive pinning or registration happens once per block,
+        /// not once per buffer.
+        /// \c Pinner is the pinning policy: it must have a function <tt>bool pin(void*, std::size_t)</tt>
+        /// that returns whether or not it succeeded and a \c noexcept function <tt>void unpin(void*, std::size_t)</tt>,
+        /// see \ref mlock_pinner and \ref callback_pinner.
+        /// \note With the \ref mlock_pinner, the blocks should be page aligned, like the ones of the \ref virtual_block_allocator,
+        /// as locks of pages shared between blocks are not counted.
+        /// \ingroup adapter
+        template <class BlockAllocator, class Pinner = mlock_pinner>
+        class pinned_block_allocator : FOONATHAN_EBO(BlockAllocator, Pinner)
+        {
+        public:
+            using allocator_type = BlockAllocator;
+            using pinner_type    = Pinner;
+
+            /// @{
+            /// \effects Creates it by giving it the pinning policy, a default constructed one if none is given,
+            /// and forwarding the other arguments to the \concept{concept_blockallocator,BlockAllocator}.
+            /// \throws Anything thrown by the constructor of the \concept{concept_blockallocator,BlockAllocator}.
+            template <typename... Args>
+            explicit pinned_block_allocator(std::size_t block_size, Args&&... args)
+            : allocator_type(block_size, detail::forward<Args>(args)...), pinner_type()
+            {
+            }
+
+            template <typename... Args>
+            pinned_block_allocator(std::size_t block_size, pinner_type pinner, Args&&... args)
+            : allocator_type(block_size, detail::forward<Args>(args)...),
+              pinner_type(detail::move(pinner))
+            {
+            }
+            /// @}
+
+            /// \effects Allocates a new block from the \concept{concept_blockallocator,BlockAllocator} and pins it.
+            /// \returns The pinned block.
+            /// \throws Anything thrown by the \concept{concept_blockallocator,BlockAllocator},
+            /// or \ref out_of_memory if the block cannot be pinned, it is then deallocated again.
+            memory_block allocate_block()
+            {
+                auto block = allocator_type::allocate_block();
+                if (!get_pinner().pin(block.memory, block.size))
+                {
+                    allocator_type::deallocate_block(block);
+                    FOONATHAN_THROW(out_of_memory(
+                        {FOONATHAN_MEMORY_LOG_PREFIX "::pinned_block_allocator", this},
+                        block.size));
+                }
+                return block;
+            }
+
+            /// \effects Unpins the block and deallocates it.
+            void deallocate_block(memory_block block) noexcept
+            {
+                get_pinner().unpin(block.memory, block.size);
+                allocator_type::deallocate_block(block);
+            }
+
+            /// \returns The size of the next block of the \concept{concept_blockallocator,BlockAllocator}.
+            std::size_t next_block_size() const noexcept
+            {
+                return allocator_type::next_block_size();
+            }
+
+            /// \returns The alignment of the blocks of the \concept{concept_blockallocator,BlockAllocator}.
+            std::size_t block_alignment() const noexcept
+            {
+                return detail::block_alignment(0, get_allocator());
+            }
+
+            /// \returns Whether or not the \concept{concept_blockallocator,BlockAllocator} reports the last block as zeroed,
+            /// pinning does not change the contents.
+            bool last_block_zeroed() const noexcept
+            {
+                return detail::last_block_zeroed(0, get_allocator());
+            }
+
+            /// @{
+            /// \returns A reference to the \concept{concept_blockallocator,BlockAllocator}.
+            allocator_type& get_allocator() noexcept
+            {
+                return *this;
+            }
+
+            const allocator_type& get_allocator() const noexcept
+            {
+                return *this;
+            }
+            /// @}
+
+            /// @{
+            /// \returns A reference to the pinning policy.
+            pinner_type& get_pinner() noexcept
+            {
+                return *this;
+            }
+
+            const pinner_type& get_pinner() const noexcept
+            {
+                return *this;
+            }
+            /// @}
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_PINNED_BLOCK_ALLOCATOR_HPP_INCLUDED
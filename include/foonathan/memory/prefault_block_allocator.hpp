@@ -0,0 +1,244 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_PREFAULT_BLOCK_ALLOCATOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_PREFAULT_BLOCK_ALLOCATOR_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::prefault_block_allocator.
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "detail/utility.hpp"
+#include "config.hpp"
+#include "memory_arena.hpp"
+#include "virtual_memory.hpp"
+
+#if !FOONATHAN_HOSTED_IMPLEMENTATION
+#error "prefault_block_allocator requires a hosted implementation"
+#endif
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// When a \ref prefault_block_allocator makes the blocks resident.
+        /// \ingroup allocator
+        enum class prefault_mode
+        {
+            /// Each block is made resident when it is allocated.
+            on_allocate,
+            /// One block is allocated ahead of time and made resident on a background thread,
+            /// it is then returned by the next allocation.
+            ahead,
+        };
+
+        namespace detail
+        {
+            // background thread that prefaults one block at a time
+            class prefault_thread
+            {
+            public:
+                prefault_thread();
+
+                ~prefault_thread() noexcept;
+
+                // starts prefaulting the block
+                // pre: the previous block is finished
+                void start(memory_block block) noexcept;
+
+                // waits until the current block is finished
+                void wait() noexcept;
+
+            private:
+                void run() noexcept;
+
+                std::mutex              mutex_;
+                std::condition_variable wakeup_, finished_;
+                memory_block            block_;
+                bool                    pending_, stop_;
+                std::thread             thread_;
+            };
+
+            template <class BlockAllocator>
+            auto can_allocate_ahead(int, const BlockAllocator& alloc) noexcept
+                -> decltype(alloc.capacity_left() != 0u)
+            {
+                return alloc.capacity_left() != 0u;
+            }
+
+            template <class BlockAllocator>
+            bool can_allocate_ahead(short, const BlockAllocator&) noexcept
+            {
+                return true;
+            }
+        } // namespace detail
+
+        /// A \concept{concept_blockallocator,BlockAllocator} adapter that makes the blocks resident before they are used,
+        /// so the first allocations of a \ref memory_arena or \ref memory_stack from a new block do not cause page faults.
+        /// The blocks are prefaulted with \ref prefault_memory().
+        /// With \ref prefault_mode::ahead the next block is allocated as soon as the current one is handed out
+        /// and made resident on a background thread,
+        /// so only the very first allocation has to wait for its block.
+        /// \note With \ref prefault_mode::ahead, the block allocated ahead is deallocated before the given block,
+        /// so it also works for \concept{concept_blockallocator,BlockAllocator}s that require reversed deallocation order,
+        /// like \ref virtual_block_allocator.
+        /// If the \concept{concept_blockallocator,BlockAllocator} has a \c capacity_left() function,
+        /// no block is allocated ahead if it is exhausted,
+        /// and if allocating it ahead fails, the allocation of the current block still succeeds.
+        /// \ingroup adapter
+        template <class BlockAllocator, prefault_mode Mode = prefault_mode::on_allocate>
+        class prefault_block_allocator : FOONATHAN_EBO(BlockAllocator)
+        {
+        public:
+            using allocator_type = BlockAllocator;
+
+            /// \effects Creates it by forwarding all arguments to the \concept{concept_blockallocator,BlockAllocator}.
+            /// With \ref prefault_mode::ahead, it also starts the background thread.
+            /// \throws Anything thrown by the constructor of the \concept{concept_blockallocator,BlockAllocator}
+            /// or the background thread.
+            template <typename... Args>
+            explicit prefault_block_allocator(std::size_t block_size, Args&&... args)
+            : allocator_type(block_size, detail::forward<Args>(args)...),
+              ahead_(),
+              thread_(Mode == prefault_mode::ahead ? new detail::prefault_thread : nullptr)
+            {
+            }
+
+            /// \effects Deallocates the block allocated ahead, if there is one.
+            ~prefault_block_allocator() noexcept
+            {
+                release_ahead();
+            }
+
+            /// @{
+            /// \effects Moves the block allocator and the block allocated ahead.
+            prefault_block_allocator(prefault_block_allocator&& other) noexcept
+            : allocator_type(detail::move(other)),
+              ahead_(other.ahead_),
+              thread_(detail::move(other.thread_))
+            {
+                other.ahead_ = memory_block();
+            }
+
+            prefault_block_allocator& operator=(prefault_block_allocator&& other) noexcept
+            {
+                release_ahead();
+                allocator_type::operator=(detail::move(other));
+                ahead_       = other.ahead_;
+                thread_      = detail::move(other.thread_);
+                other.ahead_ = memory_block();
+                return *this;
+            }
+            /// @}
+
+            /// \effects Allocates a new block from the \concept{concept_blockallocator,BlockAllocator}
+            /// and makes it resident, or returns the block allocated ahead.
+            /// \returns The resident block.
+            /// \throws Anything thrown by the \concept{concept_blockallocator,BlockAllocator}.
+            memory_block allocate_block()
+            {
+                if (!thread_)
+                {
+                    auto block = allocator_type::allocate_block();
+                    prefault_memory(block.memory, block.size);
+                    return block;
+                }
+
+                auto block = ahead_;
+                if (block.memory)
+                    thread_->wait();
+                else
+                {
+                    block = allocator_type::allocate_block();
+                    prefault_memory(block.memory, block.size);
+                }
+
+                ahead_ = memory_block();
+                if (detail::can_allocate_ahead(0, get_allocator()))
+                    allocate_ahead();
+                return block;
+            }
+
+            /// \effects Deallocates the block allocated ahead, if there is one, and then the given block.
+            void deallocate_block(memory_block block) noexcept
+            {
+                release_ahead();
+                allocator_type::deallocate_block(block);
+            }
+
+            /// \returns The size of the block allocated ahead, if there is one,
+            /// and of the next block of the \concept{concept_blockallocator,BlockAllocator} otherwise.
+            std::size_t next_block_size() const noexcept
+            {
+                return ahead_.memory ? ahead_.size : allocator_type::next_block_size();
+            }
+
+            /// \returns The alignment of the blocks of the \concept{concept_blockallocator,BlockAllocator}.
+            std::size_t block_alignment() const noexcept
+            {
+                return detail::block_alignment(0, get_allocator());
+            }
+
+            /// \returns Whether or not the \concept{concept_blockallocator,BlockAllocator} reports the last block as zeroed,
+            /// prefaulting does not change the contents.
+            /// It is always \c false if blocks are allocated ahead,
+            /// as the last block of the \concept{concept_blockallocator,BlockAllocator} is then the one ahead.
+            bool last_block_zeroed() const noexcept
+            {
+                return Mode != prefault_mode::ahead
+                       && detail::last_block_zeroed(0, get_allocator());
+            }
+
+            /// @{
+            /// \returns A reference to the \concept{concept_blockallocator,BlockAllocator}.
+            allocator_type& get_allocator() noexcept
+            {
+                return *this;
+            }
+
+            const allocator_type& get_allocator() const noexcept
+            {
+                return *this;
+            }
+            /// @}
+
+        private:
+            void allocate_ahead()
+            {
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+                try
+                {
+                    ahead_ = allocator_type::allocate_block();
+                }
+                catch (...)
+                {
+                    // the current block can still be used, the next allocation tries again
+                    return;
+                }
+#else
+                ahead_ = allocator_type::allocate_block();
+#endif
+                thread_->start(ahead_);
+            }
+
+            void release_ahead() noexcept
+            {
+                if (ahead_.memory)
+                {
+                    thread_->wait();
+                    allocator_type::deallocate_block(ahead_);
+                    ahead_ = memory_block();
+                }
+            }
+
+            memory_block                             ahead_;
+            std::unique_ptr<detail::prefault_thread> thread_;
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_PREFAULT_BLOCK_ALLOCATOR_HPP_INCLUDED
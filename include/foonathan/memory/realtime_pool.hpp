@@ -0,0 +1,342 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_REALTIME_POOL_HPP_INCLUDED
+#define FOONATHAN_MEMORY_REALTIME_POOL_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::realtime_pool.
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+#include "detail/align.hpp"
+#include "detail/assert.hpp"
+#include "detail/free_list.hpp"
+#include "detail/utility.hpp"
+#include "config.hpp"
+#include "default_allocator.hpp"
+#include "error.hpp"
+#include "memory_arena.hpp"
+
+#if !FOONATHAN_HOSTED_IMPLEMENTATION
+#error "realtime_pool requires a hosted implementation"
+#endif
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// Who refills a \ref realtime_pool.
+        /// \ingroup allocator
+        enum class realtime_refill
+        {
+            /// A non-real-time thread of the user calls \ref realtime_pool::refill().
+            manual,
+            /// A background thread of the pool refills it periodically.
+            background,
+        };
+
+        namespace detail
+        {
+            // a block handed to the real-time thread, stored at the beginning of its nodes
+            struct realtime_block
+            {
+                realtime_block* next;
+                std::size_t     size, no_nodes;
+            };
+        } // namespace detail
+
+        /// A stateful \concept{concept_rawallocator,RawAllocator} that manages \concept{concept_node,nodes} of fixed size
+        /// with a bounded worst-case latency for allocation and deallocation.
+        /// Like a \ref memory_pool with a \ref node_pool, the nodes are kept on a free list,
+        /// but the real-time thread never allocates a block itself:
+        /// a non-real-time thread, with \ref realtime_refill::background a thread of the pool,
+        /// allocates blocks ahead of demand whenever the number of free nodes drops below the low watermark,
+        /// and hands them over with a single atomic operation.
+        /// On the real-time path, allocation and deallocation never lock, never call the \concept{concept_blockallocator,BlockAllocator},
+        /// and take constant time; if all nodes are used up, \ref try_allocate_node() returns \c nullptr.
+        /// \note Allocation and deallocation must happen on a single thread at a time,
+        /// only \ref refill() can be called concurrently to them.
+        /// The blocks are only returned to the \concept{concept_blockallocator,BlockAllocator} when the pool is destroyed.
+        /// \ingroup allocator
+        template <class BlockOrRawAllocator = default_allocator,
+                  realtime_refill Refill    = realtime_refill::background>
+        class realtime_pool
+        {
+            using block = detail::realtime_block;
+
+        public:
+            using allocator_type = make_block_allocator_t<BlockOrRawAllocator>;
+            using is_stateful    = std::true_type;
+
+            /// \effects Creates it by specifying the size of the \concept{concept_node,nodes},
+            /// the initial block size for the arena, the number of free nodes to keep in reserve
+            /// and other constructor arguments for the \concept{concept_blockallocator,BlockAllocator}.
+            /// It allocates enough blocks to reach the low watermark,
+            /// and with \ref realtime_refill::background it starts the background thread.
+            /// \requires \c low_watermark must be non-zero
+            /// and each block must be big enough for at least one node.
+            /// \throws Anything thrown by the \concept{concept_blockallocator,BlockAllocator}
+            /// or the constructor of \c std::thread.
+            template <typename... Args>
+            realtime_pool(std::size_t node_size, std::size_t block_size,
+                          std::size_t low_watermark, Args&&... args)
+            : list_(node_size),
+              spare_(nullptr),
+              free_nodes_(0u),
+              ready_(nullptr),
+              ready_nodes_(0u),
+              arena_(block_size, detail::forward<Args>(args)...),
+              low_watermark_(low_watermark),
+              interval_(std::chrono::milliseconds(1)),
+              stop_(false)
+            {
+                FOONATHAN_MEMORY_ASSERT(low_watermark_ != 0u);
+                refill();
+                if (Refill == realtime_refill::background)
+                    thread_ = std::thread([this] { run(); });
+            }
+
+            /// \effects Stops the background thread, if there is one,
+            /// and returns all blocks to the \concept{concept_blockallocator,BlockAllocator}.
+            ~realtime_pool() noexcept
+            {
+                if (thread_.joinable())
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(thread_mutex_);
+                        stop_ = true;
+                    }
+                    wakeup_.notify_one();
+                    thread_.join();
+                }
+            }
+
+            /// \note The background thread refers to the object, so it can neither be copied nor moved.
+            realtime_pool(const realtime_pool&)            = delete;
+            realtime_pool& operator=(const realtime_pool&) = delete;
+
+            //=== real-time interface ===//
+            /// \effects Allocates a single \concept{concept_node,node} by removing it from the free list,
+            /// or by taking a block handed over by the refilling thread if it is empty.
+            /// It takes constant time and never blocks.
+            /// \returns A node of size \ref node_size(), or \c nullptr if there are no free nodes.
+            void* try_allocate_node() noexcept
+            {
+                if (FOONATHAN_MEMORY_UNLIKELY(list_.empty()) && !take_block())
+                    return nullptr;
+                auto node = list_.allocate();
+                free_nodes_.store(list_.capacity(), std::memory_order_relaxed);
+                return node;
+            }
+
+            /// \effects Allocates a single \concept{concept_node,node} like \ref try_allocate_node().
+            /// \returns A node of size \ref node_size().
+            /// \throws \ref out_of_fixed_memory if there are no free nodes.
+            /// \note Throwing an exception allocates, so real-time code should prefer \ref try_allocate_node().
+            void* allocate_node()
+            {
+                auto node = try_allocate_node();
+                if (!node)
+                    FOONATHAN_THROW(out_of_fixed_memory(info(), node_size()));
+                return node;
+            }
+
+            /// \effects Deallocates a single \concept{concept_node,node} by putting it back onto the free list.
+            /// It takes constant time and never blocks.
+            /// \requires \c ptr must be a result from a previous call to \ref allocate_node() or \ref try_allocate_node().
+            void deallocate_node(void* ptr) noexcept
+            {
+                list_.deallocate(ptr);
+                free_nodes_.store(list_.capacity(), std::memory_order_relaxed);
+            }
+
+            /// @{
+            /// \effects Allocates a single \concept{concept_node,node} like \ref allocate_node().
+            /// \throws \ref out_of_fixed_memory if there are no free nodes,
+            /// or \ref bad_node_size or \ref bad_alignment if the memory does not fit into a node.
+            void* allocate_node(std::size_t size, std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_node_size>(size, node_size(), info());
+                detail::check_allocation_size<bad_alignment>(alignment, max_alignment(), info());
+                return allocate_node();
+            }
+
+            void deallocate_node(void* ptr, std::size_t, std::size_t) noexcept
+            {
+                deallocate_node(ptr);
+            }
+            /// @}
+
+            /// @{
+            /// \returns The size and alignment of the nodes.
+            std::size_t max_node_size() const noexcept
+            {
+                return node_size();
+            }
+
+            std::size_t max_alignment() const noexcept
+            {
+                return list_.alignment();
+            }
+            /// @}
+
+            //=== refilling ===//
+            /// \effects Allocates blocks from the \concept{concept_blockallocator,BlockAllocator}
+            /// and hands them to the real-time thread until there are at least \ref low_watermark() free nodes.
+            /// It must not be called from the real-time thread,
+            /// but it can be called concurrently to allocations and deallocations.
+            /// \throws Anything thrown by the \concept{concept_blockallocator,BlockAllocator}.
+            void refill()
+            {
+                std::lock_guard<std::mutex> lock(refill_mutex_);
+                while (capacity_left() < low_watermark_)
+                {
+                    auto memory = arena_.allocate_block();
+                    auto offset = detail::align_offset(memory.memory, block_alignment());
+                    FOONATHAN_MEMORY_ASSERT(offset < memory.size);
+
+                    auto size     = memory.size - offset;
+                    auto no_nodes = list_.usable_size(size) / list_.node_size();
+                    FOONATHAN_MEMORY_ASSERT_MSG(no_nodes != 0u && size >= sizeof(block),
+                                                "block too small");
+
+                    auto b = ::new (static_cast<char*>(memory.memory) + offset)
+                        block{nullptr, size, no_nodes};
+                    ready_nodes_.fetch_add(no_nodes, std::memory_order_relaxed);
+
+                    b->next = ready_.load(std::memory_order_relaxed);
+                    while (!ready_.compare_exchange_weak(b->next, b, std::memory_order_release,
+                                                         std::memory_order_relaxed))
+                    {
+                    }
+                }
+            }
+
+            /// \effects Sets the interval in which the background thread checks the low watermark,
+            /// by default it is one millisecond.
+            /// \note It has no effect with \ref realtime_refill::manual.
+            void set_refill_interval(std::chrono::microseconds interval) noexcept
+            {
+                std::lock_guard<std::mutex> lock(thread_mutex_);
+                interval_ = interval;
+            }
+
+            //=== getter ===//
+            /// \returns The size of each \concept{concept_node,node}.
+            std::size_t node_size() const noexcept
+            {
+                return list_.node_size();
+            }
+
+            /// \returns The number of free nodes that can be allocated without a refill.
+            /// \note If called from another thread, it can be outdated.
+            std::size_t capacity_left() const noexcept
+            {
+                return free_nodes_.load(std::memory_order_relaxed)
+                       + ready_nodes_.load(std::memory_order_relaxed);
+            }
+
+            /// \returns The number of free nodes a refill ensures.
+            std::size_t low_watermark() const noexcept
+            {
+                return low_watermark_;
+            }
+
+        private:
+            allocator_info info() const noexcept
+            {
+                return {FOONATHAN_MEMORY_LOG_PREFIX "::realtime_pool", this};
+            }
+
+            std::size_t block_alignment() const noexcept
+            {
+                return list_.alignment() < alignof(block) ? alignof(block) : list_.alignment();
+            }
+
+            // takes all handed over blocks at once, but inserts only one, to bound the latency
+            bool take_block() noexcept
+            {
+                if (!spare_)
+                {
+                    spare_ = ready_.exchange(nullptr, std::memory_order_acquire);
+                    if (!spare_)
+                        return false;
+                }
+
+                auto b         = spare_;
+                auto size      = b->size;
+                auto no_nodes  = b->no_nodes;
+                spare_         = b->next;
+                list_.insert(b, size);
+                // the nodes are counted as free before they are no longer counted as ready,
+                // so the refilling thread never sees too few of them
+                free_nodes_.store(list_.capacity(), std::memory_order_relaxed);
+                ready_nodes_.fetch_sub(no_nodes, std::memory_order_relaxed);
+                return true;
+            }
+
+            bool try_refill() noexcept
+            {
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+                try
+                {
+                    refill();
+                }
+                catch (...)
+                {
+                    // the next period tries again
+                    return false;
+                }
+#else
+                refill();
+#endif
+                return true;
+            }
+
+            void run() noexcept
+            {
+                std::unique_lock<std::mutex> lock(thread_mutex_);
+                while (!stop_)
+                {
+                    wakeup_.wait_for(lock, interval_);
+                    if (stop_)
+                        break;
+
+                    lock.unlock();
+                    try_refill();
+                    lock.lock();
+                }
+            }
+
+            // only used by the real-time thread
+            detail::free_memory_list list_;
+            block*                   spare_;
+            std::atomic<std::size_t> free_nodes_;
+
+            // blocks handed over by the refilling thread
+            std::atomic<block*>      ready_;
+            std::atomic<std::size_t> ready_nodes_;
+
+            // only used by the refilling thread
+            std::mutex                          refill_mutex_;
+            memory_arena<allocator_type, false> arena_;
+            std::size_t                         low_watermark_;
+
+            // the state of the background thread
+            std::mutex                thread_mutex_;
+            std::condition_variable   wakeup_;
+            std::chrono::microseconds interval_;
+            bool                      stop_;
+            std::thread               thread_;
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_REALTIME_POOL_HPP_INCLUDED
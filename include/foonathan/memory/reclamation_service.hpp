@@ -0,0 +1,125 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_RECLAMATION_SERVICE_HPP_INCLUDED
+#define FOONATHAN_MEMORY_RECLAMATION_SERVICE_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::reclamation_service.
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "config.hpp"
+
+#if !FOONATHAN_HOSTED_IMPLEMENTATION
+#error "reclamation_service requires a hosted implementation"
+#endif
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// A background thread that periodically returns unused memory of allocators,
+        /// so that the cost of trimming stays off the threads doing the allocations.
+        /// Every pass calls \ref trim_arena_caches(), \ref trim_temporary_stacks() and \ref trim_block_cache(),
+        /// followed by all registered reclaimers in the order they were added.
+        /// \note As most allocators are not thread-safe, a reclaimer must synchronize with their users itself,
+        /// e.g. by locking the same mutex, see \ref add_shrink_to_fit().
+        /// \ingroup core
+        class reclamation_service
+        {
+        public:
+            /// The type of a reclaimer, it should release unused memory of an allocator and must not throw.
+            using reclaimer = std::function<void()>;
+
+            /// The identifier of a registered reclaimer.
+            using reclaimer_id = std::size_t;
+
+            /// \effects Starts the background thread that does a pass every \c period.
+            /// \throws Anything thrown by the constructor of \c std::thread.
+            explicit reclamation_service(
+                std::chrono::milliseconds period = std::chrono::milliseconds(1000));
+
+            /// \effects Stops the background thread and waits for it to finish the current pass.
+            ~reclamation_service() noexcept;
+
+            reclamation_service(const reclamation_service&)            = delete;
+            reclamation_service& operator=(const reclamation_service&) = delete;
+
+            /// \effects Registers a reclaimer that will be called in each pass.
+            /// \returns Its identifier for \ref remove_reclaimer().
+            /// \throws Anything thrown by the allocation of the internal list.
+            /// \requires The reclaimer must not add or remove reclaimers itself.
+            reclaimer_id add_reclaimer(reclaimer r);
+
+            /// \effects Registers a reclaimer that calls `alloc.shrink_to_fit()` while holding \c mutex.
+            /// This can be used for any allocator with a \c shrink_to_fit() function, e.g. \ref memory_stack,
+            /// or \ref memory_pool whose blocks are decommitted with a \ref virtual_block_allocator.
+            /// \returns Its identifier for \ref remove_reclaimer().
+            /// \requires All other uses of \c alloc must lock \c mutex,
+            /// and both must stay valid until the reclaimer is removed.
+            template <class Allocator, class Mutex>
+            reclaimer_id add_shrink_to_fit(Allocator& alloc, Mutex& mutex)
+            {
+                return add_reclaimer(
+                    [&alloc, &mutex]
+                    {
+                        std::lock_guard<Mutex> lock(mutex);
+                        alloc.shrink_to_fit();
+                    });
+            }
+
+            /// \effects Removes a previously added reclaimer.
+            /// If it is currently running, waits for it to finish,
+            /// so it will not be called anymore once this function returns.
+            void remove_reclaimer(reclaimer_id id) noexcept;
+
+            /// \effects Sets the time between two passes.
+            void set_period(std::chrono::milliseconds period) noexcept;
+
+            /// \returns The time between two passes.
+            std::chrono::milliseconds period() const noexcept;
+
+            /// \effects Wakes the background thread for an immediate pass,
+            /// e.g. when the system is low on memory.
+            /// It does not wait for the pass to finish.
+            void reclaim_now() noexcept;
+
+            /// \effects Does a pass on the calling thread.
+            void run_once() noexcept;
+
+            /// \returns The number of passes done so far.
+            std::size_t passes() const noexcept
+            {
+                return passes_.load(std::memory_order_acquire);
+            }
+
+        private:
+            void run() noexcept;
+
+            // guards the reclaimers and is held during a pass
+            std::mutex                                       run_mutex_;
+            std::vector<std::pair<reclaimer_id, reclaimer>> reclaimers_;
+            reclaimer_id                                     next_id_;
+
+            // guards the state of the background thread
+            mutable std::mutex        mutex_;
+            std::condition_variable   wakeup_;
+            std::chrono::milliseconds period_;
+            bool                      stop_, wake_;
+
+            std::atomic<std::size_t> passes_;
+            std::thread              thread_;
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_RECLAMATION_SERVICE_HPP_INCLUDED
@@ -0,0 +1,159 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_RING_ALLOCATOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_RING_ALLOCATOR_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::ring_allocator.
+
+#include <cstddef>
+#include <type_traits>
+
+#include "detail/utility.hpp"
+#include "config.hpp"
+#include "error.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// A stateful \concept{concept_rawallocator,RawAllocator} that allocates nodes of any size from a circular region of memory
+        /// and reclaims them in the order they were allocated, like a queue.
+        /// An allocation bumps the tail of the ring and a deallocation marks the node as free,
+        /// then the head moves past all free nodes at the front,
+        /// so a node freed before the older ones is only reclaimed once they are freed as well.
+        /// It suits buffers with queue-ordered lifetimes like network receive buffers or log records,
+        /// where \ref memory_stack would require the reversed order and a pool would waste memory for the different sizes.<br>
+        /// Where supported, the region is mapped twice one after the other through the \ref virtual_memory functions of the system,
+        /// so a node that wraps around the end is still contiguous and no memory is wasted,
+        /// otherwise the rest of the region before the end is skipped.
+        /// Each node needs a header of two words, and its size is rounded up to a multiple of that.
+        /// \note It is not thread-safe, use \ref thread_safe_allocator if a producer and a consumer share it.
+        /// \ingroup allocator
+        class ring_allocator
+        {
+        public:
+            using is_stateful = std::true_type;
+
+            /// \effects Creates it with a region of at least \c capacity bytes,
+            /// rounded up to a multiple of the \ref virtual_memory_page_size.
+            /// If \c mirrored is \c true, the region is mapped twice if the system supports it,
+            /// see \ref is_mirrored().
+            /// \throws \ref out_of_memory if the memory cannot be reserved.
+            explicit ring_allocator(std::size_t capacity, bool mirrored = true);
+
+            /// \effects Releases the region.
+            /// \requires All nodes must have been deallocated.
+            ~ring_allocator() noexcept;
+
+            /// @{
+            /// \effects Moves the allocator, it transfers ownership over the region.
+            /// This does not invalidate any nodes.
+            ring_allocator(ring_allocator&& other) noexcept
+            : begin_(other.begin_),
+              capacity_(other.capacity_),
+              head_(other.head_),
+              tail_(other.tail_),
+              mirrored_(other.mirrored_)
+            {
+                other.begin_    = nullptr;
+                other.capacity_ = other.head_ = other.tail_ = 0u;
+                other.mirrored_                             = false;
+            }
+
+            ring_allocator& operator=(ring_allocator&& other) noexcept
+            {
+                ring_allocator tmp(detail::move(other));
+                swap(*this, tmp);
+                return *this;
+            }
+            /// @}
+
+            /// \effects Swaps the ownership over the regions.
+            /// This does not invalidate any nodes.
+            friend void swap(ring_allocator& a, ring_allocator& b) noexcept
+            {
+                detail::adl_swap(a.begin_, b.begin_);
+                detail::adl_swap(a.capacity_, b.capacity_);
+                detail::adl_swap(a.head_, b.head_);
+                detail::adl_swap(a.tail_, b.tail_);
+                detail::adl_swap(a.mirrored_, b.mirrored_);
+            }
+
+            /// \effects A \concept{concept_rawallocator,RawAllocator} allocation function.
+            /// It allocates the node at the tail of the ring.
+            /// \returns A \concept{concept_node,node} of the given size and alignment, it will never be \c nullptr.
+            /// \throws \ref out_of_fixed_memory if the ring is full,
+            /// i.e. the oldest nodes are still in use.
+            void* allocate_node(std::size_t size, std::size_t alignment);
+
+            /// \effects A \concept{concept_rawallocator,RawAllocator} deallocation function.
+            /// It marks the node as free and reclaims it and all free nodes after it if it is the oldest node.
+            void deallocate_node(void* node, std::size_t size, std::size_t alignment) noexcept;
+
+            /// \effects A \concept{concept_composableallocator,ComposableAllocator} allocation function.
+            /// \returns The same as \ref allocate_node() or \c nullptr if the ring is full.
+            void* try_allocate_node(std::size_t size, std::size_t alignment) noexcept;
+
+            /// \effects A \concept{concept_composableallocator,ComposableAllocator} deallocation function.
+            /// \returns Whether or not the node was allocated by this allocator and thus deallocated.
+            bool try_deallocate_node(void* node, std::size_t size, std::size_t alignment) noexcept;
+
+            /// \returns The size of the biggest node that fits into the empty ring.
+            std::size_t max_node_size() const noexcept
+            {
+                return capacity_ - header_size;
+            }
+
+            /// \returns The \ref virtual_memory_page_size, the biggest alignment that does not
+            /// waste more than a page.
+            std::size_t max_alignment() const noexcept;
+
+            /// \returns The size of the region in bytes.
+            std::size_t capacity() const noexcept
+            {
+                return capacity_;
+            }
+
+            /// \returns The number of bytes not used by a node or reclaimable by the oldest node.
+            /// \note Nodes that are freed before older ones still count as used.
+            std::size_t capacity_left() const noexcept
+            {
+                return capacity_ - (tail_ - head_);
+            }
+
+            /// \returns Whether or not there are no nodes left to reclaim.
+            bool empty() const noexcept
+            {
+                return head_ == tail_;
+            }
+
+            /// \returns Whether or not the region is mapped twice, so that nodes can wrap around.
+            bool is_mirrored() const noexcept
+            {
+                return mirrored_;
+            }
+
+        private:
+            // a node starts with its total size, whose lowest bit marks it as free,
+            // and the word before the node is the offset to the start
+            static constexpr std::size_t header_size = 2u * sizeof(std::size_t);
+
+            allocator_info info() const noexcept;
+
+            bool owns(const void* node) const noexcept;
+
+            // reclaims the free nodes at the head
+            void reclaim() noexcept;
+
+            char*       begin_;
+            std::size_t capacity_;
+            // both grow monotonically, the offset in the region is taken modulo the capacity
+            std::size_t head_, tail_;
+            bool        mirrored_;
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_RING_ALLOCATOR_HPP_INCLUDED
@@ -0,0 +1,217 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_SAMPLED_DEBUG_ALLOCATOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_SAMPLED_DEBUG_ALLOCATOR_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::sampled_debug_allocator and related functions.
+
+#include <type_traits>
+
+#include "detail/utility.hpp"
+#include "allocator_traits.hpp"
+#include "config.hpp"
+#include "error.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        namespace detail
+        {
+            // size of the header in front of each allocation and of each fence,
+            // the three marker bytes come after the two pointers an allocator might store in free memory
+            constexpr std::size_t sampled_debug_prefix_size(std::size_t alignment) noexcept
+            {
+                return (2u * sizeof(void*) + 3u + alignment - 1u) / alignment * alignment;
+            }
+
+            // returns true for every period-th call on the current thread, never if period is 0
+            bool sampled_debug_next(std::size_t period) noexcept;
+
+            // writes the header and, if sampled, the fences and the new memory fill
+            // returns the memory given to the user
+            void* sampled_debug_on_allocate(void* memory, std::size_t size, std::size_t prefix,
+                                            bool sampled) noexcept;
+
+            // checks the header and, if sampled, the fences and marks the memory as freed
+            // returns the memory to deallocate or nullptr if it is invalid
+            void* sampled_debug_on_deallocate(const allocator_info& info, void* ptr,
+                                              std::size_t size, std::size_t prefix,
+                                              bool& sampled) noexcept;
+        } // namespace detail
+
+        /// A \concept{concept_rawallocator,RawAllocator} adapter for memory checks that are cheap enough to leave enabled in production.
+        /// Unlike the checks controlled by \ref FOONATHAN_MEMORY_DEBUG_FILL, \ref FOONATHAN_MEMORY_DEBUG_FENCE and \ref FOONATHAN_MEMORY_DEBUG_DOUBLE_DEALLOC_CHECK,
+        /// they do not depend on the build configuration and their cost is selected at runtime.
+        /// Every allocation gets a small header in front of it that marks the memory as allocated,
+        /// so passing the memory to a deallocation function twice is detected in constant time
+        /// and the \ref invalid_pointer_handler is called.
+        /// In addition, every \ref sample_period()-th allocation of a thread is surrounded by fences and filled
+        /// like with \ref FOONATHAN_MEMORY_DEBUG_FILL, and the fences are checked upon deallocation,
+        /// calling the \ref buffer_overflow_handler if they have been overwritten.
+        /// \note The double deallocation check relies on the header being intact,
+        /// so it can miss the error if the memory has been allocated again in between
+        /// or the underlying allocator overwrites the header with data of its own.
+        /// \note As the header and the fences increase the size of the allocations,
+        /// the underlying allocator must support different node sizes, so it cannot be a \ref memory_pool.
+        /// \ingroup adapter
+        template <class RawAllocator>
+        class sampled_debug_allocator
+        : FOONATHAN_EBO(allocator_traits<RawAllocator>::allocator_type)
+        {
+            using traits = allocator_traits<RawAllocator>;
+
+        public:
+            using allocator_type = typename allocator_traits<RawAllocator>::allocator_type;
+            using is_stateful    = std::true_type;
+
+            /// \effects Creates it passing it the sample period and the allocator object.
+            /// A sample period of \c 1 checks all allocations, \c 0 only checks for double deallocations.
+            explicit sampled_debug_allocator(std::size_t sample_period, allocator_type&& alloc = {})
+            : allocator_type(detail::move(alloc)), sample_period_(sample_period)
+            {
+            }
+
+            /// @{
+            /// \effects Moves the \c sampled_debug_allocator object.
+            /// It simply moves the underlying allocator.
+            sampled_debug_allocator(sampled_debug_allocator&& other) noexcept
+            : allocator_type(detail::move(other)), sample_period_(other.sample_period_)
+            {
+            }
+
+            sampled_debug_allocator& operator=(sampled_debug_allocator&& other) noexcept
+            {
+                allocator_type::operator=(detail::move(other));
+                sample_period_ = other.sample_period_;
+                return *this;
+            }
+            /// @}
+
+            /// @{
+            /// \effects Allocates the memory with the header and, if sampled, the fences from the underlying allocator
+            /// through the \ref allocator_traits.
+            /// \returns The memory after the header and the front fence.
+            /// \throws Anything thrown by the underlying allocator.
+            void* allocate_node(std::size_t size, std::size_t alignment)
+            {
+                auto prefix  = detail::sampled_debug_prefix_size(alignment);
+                auto sampled = detail::sampled_debug_next(sample_period_);
+                auto memory =
+                    traits::allocate_node(get_allocator(), total_size(size, prefix, sampled),
+                                          alignment);
+                return detail::sampled_debug_on_allocate(memory, size, prefix, sampled);
+            }
+
+            void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+            {
+                return allocate_node(count * size, alignment);
+            }
+            /// @}
+
+            /// @{
+            /// \effects Checks the header and, if the allocation was sampled, the fences
+            /// and deallocates the memory through the \ref allocator_traits.
+            /// If the header does not mark the memory as allocated, it calls the \ref invalid_pointer_handler
+            /// and does not deallocate anything.
+            void deallocate_node(void* ptr, std::size_t size, std::size_t alignment) noexcept
+            {
+                auto prefix  = detail::sampled_debug_prefix_size(alignment);
+                auto sampled = false;
+                if (auto memory =
+                        detail::sampled_debug_on_deallocate(info(), ptr, size, prefix, sampled))
+                    traits::deallocate_node(get_allocator(), memory,
+                                            total_size(size, prefix, sampled), alignment);
+            }
+
+            void deallocate_array(void* ptr, std::size_t count, std::size_t size,
+                                  std::size_t alignment) noexcept
+            {
+                deallocate_node(ptr, count * size, alignment);
+            }
+            /// @}
+
+            /// @{
+            /// \returns The value returned by the \ref allocator_traits for the underlying allocator
+            /// minus the biggest memory overhead of an allocation.
+            std::size_t max_node_size() const
+            {
+                return max_size(traits::max_node_size(get_allocator()));
+            }
+
+            std::size_t max_array_size() const
+            {
+                return max_size(traits::max_node_size(get_allocator()));
+            }
+            /// @}
+
+            /// \returns The value returned by the \ref allocator_traits for the underlying allocator.
+            std::size_t max_alignment() const
+            {
+                return traits::max_alignment(get_allocator());
+            }
+
+            /// @{
+            /// \returns A reference to the underlying allocator.
+            allocator_type& get_allocator() noexcept
+            {
+                return *this;
+            }
+
+            const allocator_type& get_allocator() const noexcept
+            {
+                return *this;
+            }
+            /// @}
+
+            /// \returns The number of allocations per thread for each allocation with fences and fill.
+            std::size_t sample_period() const noexcept
+            {
+                return sample_period_;
+            }
+
+            /// \effects Sets the sample period to a new value.
+            /// It has no effect on memory already allocated, as each allocation remembers whether it was sampled.
+            void set_sample_period(std::size_t sample_period) noexcept
+            {
+                sample_period_ = sample_period;
+            }
+
+        private:
+            // front fence and header, user memory, back fence
+            static std::size_t total_size(std::size_t size, std::size_t prefix,
+                                          bool sampled) noexcept
+            {
+                return size + (sampled ? 3u * prefix : prefix);
+            }
+
+            std::size_t max_size(std::size_t max) const
+            {
+                auto overhead = 3u * detail::sampled_debug_prefix_size(max_alignment());
+                return max < overhead ? 0u : max - overhead;
+            }
+
+            allocator_info info() const noexcept
+            {
+                return {FOONATHAN_MEMORY_LOG_PREFIX "::sampled_debug_allocator", this};
+            }
+
+            std::size_t sample_period_;
+        };
+
+        /// \returns A new \ref sampled_debug_allocator created by forwarding the parameters to the constructor.
+        /// \relates sampled_debug_allocator
+        template <class RawAllocator>
+        auto make_sampled_debug_allocator(std::size_t sample_period, RawAllocator&& allocator)
+            -> sampled_debug_allocator<typename std::decay<RawAllocator>::type>
+        {
+            return sampled_debug_allocator<
+                typename std::decay<RawAllocator>::type>{sample_period,
+                                                         detail::forward<RawAllocator>(allocator)};
+        }
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_SAMPLED_DEBUG_ALLOCATOR_HPP_INCLUDED
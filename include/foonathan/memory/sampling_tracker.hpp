@@ -0,0 +1,151 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_SAMPLING_TRACKER_HPP_INCLUDED
+#define FOONATHAN_MEMORY_SAMPLING_TRACKER_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::sampling_tracker and related classes.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "config.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// A sampled heap profile that is filled by one or more \ref sampling_tracker objects.
+        /// Allocations are sampled with a probability proportional to their size
+        /// such that on average one sample is taken every \ref sample_period() bytes,
+        /// the distance between two samples is exponentially distributed like in tcmalloc's heap profiler.
+        /// For each sampled allocation the stack trace is recorded until it is deallocated,
+        /// and \ref write_pprof() writes the profile in the legacy heap format understood by \c pprof.
+        /// \note Stack traces are only available on platforms with \c backtrace(), i.e. glibc,
+        /// otherwise all samples are attributed to an empty stack.
+        /// \note The object must outlive all trackers referring to it.
+        /// \ingroup adapter
+        class heap_profile
+        {
+        public:
+            /// The default sample period which is 512KiB, the same as in tcmalloc.
+            static constexpr std::size_t default_sample_period = 512u * 1024u;
+
+            /// The maximal number of stack frames recorded for each sample.
+            static constexpr std::size_t max_stack_depth = 32u;
+
+            /// \effects Creates an empty profile with the given average number of bytes between two samples.
+            /// A sample period of \c 1 records all allocations.
+            /// \requires \c sample_period must not be \c 0.
+            explicit heap_profile(std::size_t sample_period = default_sample_period) noexcept;
+
+            heap_profile(const heap_profile&)            = delete;
+            heap_profile& operator=(const heap_profile&) = delete;
+
+            /// \effects Records the stack trace of the allocation if it is sampled.
+            /// The countdown to the next sample is per thread.
+            /// If the memory for the sample record cannot be allocated, the sample is dropped.
+            void on_allocate(void* memory, std::size_t size) noexcept;
+
+            /// \effects Removes the sample of the memory, if there is one.
+            /// This is cheap for memory that was not sampled.
+            void on_deallocate(void* memory) noexcept;
+
+            /// \effects Writes the profile to the given file in the legacy pprof heap profile format,
+            /// followed by the mapped libraries for symbolization on Linux.
+            /// It includes all allocations sampled so far, the deallocated ones only in the allocation counts.
+            void write_pprof(std::FILE* file) const;
+
+            /// \returns The number of sampled allocations that are not deallocated yet.
+            std::size_t live_samples() const noexcept;
+
+            /// \returns The average number of bytes between two samples.
+            std::size_t sample_period() const noexcept
+            {
+                return sample_period_;
+            }
+
+        private:
+            struct call_site
+            {
+                std::size_t live_objects, live_bytes, allocated_objects, allocated_bytes;
+            };
+
+            using call_site_map = std::map<std::vector<void*>, call_site>;
+
+            struct sample
+            {
+                std::size_t             size;
+                call_site_map::iterator site;
+            };
+
+            static constexpr std::size_t filter_size = 1024u;
+
+            static std::size_t filter_index(void* memory) noexcept;
+
+            mutable std::mutex                mutex_;
+            call_site_map                     sites_;
+            std::unordered_map<void*, sample> samples_;
+            // number of live samples per filter_index(),
+            // zero means a pointer is definitely not sampled
+            std::atomic<std::size_t> filter_[filter_size];
+            std::size_t              sample_period_;
+        };
+
+        /// A \concept{concept_tracker,deep tracker} that samples allocations into a \ref heap_profile.
+        /// Only the sampled allocations do more than decrementing a counter,
+        /// so it can be used on production allocators to find the call sites responsible for their memory usage.
+        /// \note Growth and shrinking of a \ref deeply_tracked_allocator are ignored,
+        /// as the blocks are already accounted for by the nodes taken from them.
+        /// \ingroup adapter
+        class sampling_tracker
+        {
+        public:
+            /// \effects Creates it recording into the given profile.
+            explicit sampling_tracker(heap_profile& profile) noexcept : profile_(&profile) {}
+
+            void on_node_allocation(void* memory, std::size_t size, std::size_t) noexcept
+            {
+                profile_->on_allocate(memory, size);
+            }
+
+            void on_array_allocation(void* memory, std::size_t count, std::size_t size,
+                                     std::size_t) noexcept
+            {
+                profile_->on_allocate(memory, count * size);
+            }
+
+            void on_node_deallocation(void* memory, std::size_t, std::size_t) noexcept
+            {
+                profile_->on_deallocate(memory);
+            }
+
+            void on_array_deallocation(void* memory, std::size_t, std::size_t,
+                                       std::size_t) noexcept
+            {
+                profile_->on_deallocate(memory);
+            }
+
+            void on_allocator_growth(void*, std::size_t) noexcept {}
+
+            void on_allocator_shrinking(void*, std::size_t) noexcept {}
+
+            /// \returns A reference to the profile.
+            heap_profile& get_profile() const noexcept
+            {
+                return *profile_;
+            }
+
+        private:
+            heap_profile* profile_;
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_SAMPLING_TRACKER_HPP_INCLUDED
@@ -5,7 +5,7 @@
 #define FOONATHAN_MEMORY_SEGREGATOR_HPP_INCLUDED
 
 /// \file
-/// Class template \ref foonathan::memory::segregator and related classes.
+/// Class template \ref foonathan::memory::segregator, \ref foonathan::memory::size_class_segregator and related classes.
 
 #include "detail/ebo_storage.hpp"
 #include "detail/utility.hpp"
@@ -76,6 +76,66 @@ namespace foonathan
                                                          std::forward<RawAllocator>(alloc));
         }
 
+        /// A \concept{concept_segregatable,Segregatable} that allocates nodes until a maximum size,
+        /// but no arrays.
+        /// This is useful for a node pool like \ref memory_pool with \ref node_pool,
+        /// which does not support arrays, so they are allocated by the next allocator.
+        /// \ingroup adapter
+        template <class RawAllocator>
+        class node_segregatable : FOONATHAN_EBO(allocator_traits<RawAllocator>::allocator_type)
+        {
+        public:
+            using allocator_type = typename allocator_traits<RawAllocator>::allocator_type;
+
+            /// \effects Creates it by passing the maximum node size it will allocate
+            /// and the allocator it uses.
+            explicit node_segregatable(std::size_t    max_size,
+                                       allocator_type alloc = allocator_type())
+            : allocator_type(detail::move(alloc)), max_size_(max_size)
+            {
+            }
+
+            /// \returns `true` if `size` is less then or equal to the maximum size,
+            /// `false` otherwise.
+            /// \note A return value of `true` means that the allocator will be used for the allocation.
+            bool use_allocate_node(std::size_t size, std::size_t) noexcept
+            {
+                return size <= max_size_;
+            }
+
+            /// \returns Always `false`, arrays are never allocated by it.
+            bool use_allocate_array(std::size_t, std::size_t, std::size_t) noexcept
+            {
+                return false;
+            }
+
+            /// @{
+            /// \returns A reference to the allocator it owns.
+            allocator_type& get_allocator() noexcept
+            {
+                return *this;
+            }
+
+            const allocator_type& get_allocator() const noexcept
+            {
+                return *this;
+            }
+            /// @}
+
+        private:
+            std::size_t max_size_;
+        };
+
+        /// \returns A \ref node_segregatable with the same parameter.
+        template <class RawAllocator>
+        node_segregatable<typename std::decay<RawAllocator>::type> node_threshold(
+            std::size_t max_size, RawAllocator&& alloc)
+        {
+            return node_segregatable<
+                typename std::decay<RawAllocator>::type>(max_size,
+                                                         std::forward<RawAllocator>(alloc));
+        }
+
         /// A composable \concept{concept_rawallocator,RawAllocator} that will always fail.
         /// This is useful for compositioning or as last resort in \ref binary_segregator.
         /// \ingroup allocator
@@ -241,6 +301,11 @@ namespace foonathan
                 return s_;
             }
 
+            const segregatable& get_segregatable() const noexcept
+            {
+                return s_;
+            }
+
             segregatable s_;
         };
 
@@ -413,7 +478,7 @@ namespace foonathan
 
         template <std::size_t I, class Segregator, class Fallback>
         auto get_segregatable_allocator(const binary_segregator<Segregator, Fallback>& s)
-            -> const segregatable_allocator_type<I, binary_segregator<Segregator, Fallback>>
+            -> const segregatable_allocator_type<I, binary_segregator<Segregator, Fallback>>&
         {
             return detail::segregatable_type<I, binary_segregator<Segregator, Fallback>>::get(s);
         }
@@ -441,6 +506,530 @@ namespace foonathan
             return detail::fallback_type<binary_segregator<Segregator, Fallback>>::get(s);
         }
         /// @}
+
+        /// A \concept{concept_segregatable,Segregatable} that allocates until a maximum size known at compile-time.
+        /// It behaves like a \ref threshold_segregatable but can be used as size class of a \ref size_class_segregator.
+        /// \ingroup adapter
+        template <std::size_t MaxSize, class RawAllocator>
+        class size_class_segregatable
+        : FOONATHAN_EBO(allocator_traits<RawAllocator>::allocator_type)
+        {
+            static_assert(MaxSize > 0u, "size class must not be empty");
+
+        public:
+            using allocator_type = typename allocator_traits<RawAllocator>::allocator_type;
+
+            /// The maximum size it will allocate.
+            static constexpr std::size_t max_size = MaxSize;
+
+            /// \effects Creates it by passing the allocator it uses.
+            explicit size_class_segregatable(allocator_type alloc = allocator_type())
+            : allocator_type(detail::move(alloc))
+            {
+            }
+
+            /// \returns `true` if `size` is less then or equal to the maximum size,
+            /// `false` otherwise.
+            /// \note A return value of `true` means that the allocator will be used for the allocation.
+            bool use_allocate_node(std::size_t size, std::size_t) noexcept
+            {
+                return size <= MaxSize;
+            }
+
+            /// \returns `true` if `count * size` is less then or equal to the maximum size,
+            /// `false` otherwise.
+            /// \note A return value of `true` means that the allocator will be used for the allocation.
+            bool use_allocate_array(std::size_t count, std::size_t size, std::size_t) noexcept
+            {
+                return count * size <= MaxSize;
+            }
+
+            /// @{
+            /// \returns A reference to the allocator it owns.
+            allocator_type& get_allocator() noexcept
+            {
+                return *this;
+            }
+
+            const allocator_type& get_allocator() const noexcept
+            {
+                return *this;
+            }
+            /// @}
+        };
+
+        template <std::size_t MaxSize, class RawAllocator>
+        constexpr std::size_t size_class_segregatable<MaxSize, RawAllocator>::max_size;
+
+        /// \returns A \ref size_class_segregatable with the same parameter.
+        template <std::size_t MaxSize, class RawAllocator>
+        size_class_segregatable<MaxSize, typename std::decay<RawAllocator>::type> size_class(
+            RawAllocator&& alloc)
+        {
+            return size_class_segregatable<MaxSize, typename std::decay<RawAllocator>::type>(
+                std::forward<RawAllocator>(alloc));
+        }
+
+        namespace detail
+        {
+            constexpr std::size_t size_class_gcd(std::size_t a, std::size_t b) noexcept
+            {
+                return b == 0u ? a : size_class_gcd(b, a % b);
+            }
+
+            constexpr std::size_t size_class_granularity(std::size_t a) noexcept
+            {
+                return a;
+            }
+
+            template <typename... Sizes>
+            constexpr std::size_t size_class_granularity(std::size_t a, std::size_t b,
+                                                         Sizes... rest) noexcept
+            {
+                return size_class_granularity(size_class_gcd(a, b), rest...);
+            }
+
+            constexpr bool size_classes_ascending(std::size_t) noexcept
+            {
+                return true;
+            }
+
+            template <typename... Sizes>
+            constexpr bool size_classes_ascending(std::size_t a, std::size_t b,
+                                                  Sizes... rest) noexcept
+            {
+                return a < b && size_classes_ascending(b, rest...);
+            }
+
+            constexpr std::size_t size_class_max(std::size_t a) noexcept
+            {
+                return a;
+            }
+
+            template <typename... Sizes>
+            constexpr std::size_t size_class_max(std::size_t a, std::size_t b,
+                                                 Sizes... rest) noexcept
+            {
+                return size_class_max(a < b ? b : a, rest...);
+            }
+
+            // index of the first size class that fits, all sizes are multiples of the granularity
+            constexpr unsigned char size_class_index(std::size_t, unsigned char index) noexcept
+            {
+                return index;
+            }
+
+            template <typename... Sizes>
+            constexpr unsigned char size_class_index(std::size_t size, unsigned char index,
+                                                     std::size_t max_size, Sizes... rest) noexcept
+            {
+                return size <= max_size ? index
+                                        : size_class_index(size, static_cast<unsigned char>(
+                                                                     index + 1u),
+                                                           rest...);
+            }
+
+            // maps size / granularity (rounded up) to the index of the size class
+            template <class Indices, std::size_t Granularity, std::size_t... MaxSizes>
+            struct size_class_table;
+
+            template <std::size_t... I, std::size_t Granularity, std::size_t... MaxSizes>
+            struct size_class_table<index_sequence<I...>, Granularity, MaxSizes...>
+            {
+                static constexpr unsigned char value[sizeof...(I)] = {
+                    size_class_index(I * Granularity, 0u, MaxSizes...)...};
+            };
+
+            template <std::size_t... I, std::size_t Granularity, std::size_t... MaxSizes>
+            constexpr unsigned char
+                size_class_table<index_sequence<I...>, Granularity, MaxSizes...>::value
+                    [sizeof...(I)];
+
+            template <std::size_t I, class RawAllocator>
+            struct size_class_leaf
+            {
+                RawAllocator alloc;
+            };
+
+            // stores the allocators of all size classes and the fallback
+            template <class Indices, class... RawAllocators>
+            struct size_class_storage;
+
+            template <std::size_t... I, class... RawAllocators>
+            struct size_class_storage<index_sequence<I...>, RawAllocators...>
+            : size_class_leaf<I, RawAllocators>...
+            {
+                explicit size_class_storage(RawAllocators... allocs)
+                : size_class_leaf<I, RawAllocators>{detail::move(allocs)}...
+                {
+                }
+            };
+
+            template <std::size_t I, class RawAllocator>
+            RawAllocator& get_size_class(size_class_leaf<I, RawAllocator>& leaf) noexcept
+            {
+                return leaf.alloc;
+            }
+
+            template <std::size_t I, class RawAllocator>
+            const RawAllocator& get_size_class(
+                const size_class_leaf<I, RawAllocator>& leaf) noexcept
+            {
+                return leaf.alloc;
+            }
+
+            template <std::size_t I, class RawAllocator, class Storage>
+            void* size_class_allocate_node(Storage& s, std::size_t size, std::size_t alignment)
+            {
+                return allocator_traits<RawAllocator>::allocate_node(get_size_class<I>(s), size,
+                                                                     alignment);
+            }
+
+            template <std::size_t I, class RawAllocator, class Storage>
+            void size_class_deallocate_node(Storage& s, void* ptr, std::size_t size,
+                                            std::size_t alignment) noexcept
+            {
+                allocator_traits<RawAllocator>::deallocate_node(get_size_class<I>(s), ptr, size,
+                                                                alignment);
+            }
+
+            template <std::size_t I, class RawAllocator, class Storage>
+            void* size_class_allocate_array(Storage& s, std::size_t count, std::size_t size,
+                                            std::size_t alignment)
+            {
+                return allocator_traits<RawAllocator>::allocate_array(get_size_class<I>(s), count,
+                                                                      size, alignment);
+            }
+
+            template <std::size_t I, class RawAllocator, class Storage>
+            void size_class_deallocate_array(Storage& s, void* ptr, std::size_t count,
+                                             std::size_t size, std::size_t alignment) noexcept
+            {
+                allocator_traits<RawAllocator>::deallocate_array(get_size_class<I>(s), ptr, count,
+                                                                 size, alignment);
+            }
+
+            // one function per allocator, indexed by the result of the size class table
+            template <class Storage, class Indices, class... RawAllocators>
+            struct size_class_dispatch;
+
+            template <class Storage, std::size_t... I, class... RawAllocators>
+            struct size_class_dispatch<Storage, index_sequence<I...>, RawAllocators...>
+            {
+                using allocate_node_fn   = void* (*)(Storage&, std::size_t, std::size_t);
+                using deallocate_node_fn = void (*)(Storage&, void*, std::size_t, std::size_t);
+                using allocate_array_fn =
+                    void* (*)(Storage&, std::size_t, std::size_t, std::size_t);
+                using deallocate_array_fn = void (*)(Storage&, void*, std::size_t, std::size_t,
+                                                     std::size_t);
+
+                static constexpr allocate_node_fn allocate_node[sizeof...(I)] = {
+                    &size_class_allocate_node<I, RawAllocators, Storage>...};
+                static constexpr deallocate_node_fn deallocate_node[sizeof...(I)] = {
+                    &size_class_deallocate_node<I, RawAllocators, Storage>...};
+                static constexpr allocate_array_fn allocate_array[sizeof...(I)] = {
+                    &size_class_allocate_array<I, RawAllocators, Storage>...};
+                static constexpr deallocate_array_fn deallocate_array[sizeof...(I)] = {
+                    &size_class_deallocate_array<I, RawAllocators, Storage>...};
+            };
+
+            template <class Storage, std::size_t... I, class... RawAllocators>
+            constexpr typename size_class_dispatch<Storage, index_sequence<I...>,
+                                                   RawAllocators...>::allocate_node_fn
+                size_class_dispatch<Storage, index_sequence<I...>,
+                                    RawAllocators...>::allocate_node[sizeof...(I)];
+
+            template <class Storage, std::size_t... I, class... RawAllocators>
+            constexpr typename size_class_dispatch<Storage, index_sequence<I...>,
+                                                   RawAllocators...>::deallocate_node_fn
+                size_class_dispatch<Storage, index_sequence<I...>,
+                                    RawAllocators...>::deallocate_node[sizeof...(I)];
+
+            template <class Storage, std::size_t... I, class... RawAllocators>
+            constexpr typename size_class_dispatch<Storage, index_sequence<I...>,
+                                                   RawAllocators...>::allocate_array_fn
+                size_class_dispatch<Storage, index_sequence<I...>,
+                                    RawAllocators...>::allocate_array[sizeof...(I)];
+
+            template <class Storage, std::size_t... I, class... RawAllocators>
+            constexpr typename size_class_dispatch<Storage, index_sequence<I...>,
+                                                   RawAllocators...>::deallocate_array_fn
+                size_class_dispatch<Storage, index_sequence<I...>,
+                                    RawAllocators...>::deallocate_array[sizeof...(I)];
+        } // namespace detail
+
+        /// A \concept{concept_rawallocator,RawAllocator} that chooses between multiple size classes with a single table lookup.
+        /// Each size class is a \ref size_class_segregatable and they must be given in ascending order of their maximum size,
+        /// allocations bigger than the last one use the `Fallback` \concept{concept_rawallocator,RawAllocator}.
+        /// It behaves exactly like a \ref segregator of the same size classes,
+        /// but instead of asking each \concept{concept_segregatable,Segregatable} in turn,
+        /// it looks up the allocator to use in a table computed at compile-time and calls it through a table of functions.
+        /// \note The table has one entry per multiple of the greatest common divisor of the maximum sizes,
+        /// so they should all be multiples of a reasonably big value like \c 8.
+        /// \ingroup adapter
+        template <class Fallback, class... SizeClasses>
+        class size_class_segregator
+        {
+            static_assert(sizeof...(SizeClasses) > 0u, "must have at least one size class");
+            static_assert(sizeof...(SizeClasses) < 255u, "too many size classes");
+            static_assert(detail::size_classes_ascending(SizeClasses::max_size...),
+                          "size classes must be in ascending order of their maximum size");
+
+            using fallback_traits = allocator_traits<Fallback>;
+            using indices         = detail::make_index_sequence<sizeof...(SizeClasses) + 1u>;
+            using storage =
+                detail::size_class_storage<indices, typename SizeClasses::allocator_type...,
+                                           typename fallback_traits::allocator_type>;
+            using dispatch =
+                detail::size_class_dispatch<storage, indices,
+                                            typename SizeClasses::allocator_type...,
+                                            typename fallback_traits::allocator_type>;
+
+            static constexpr std::size_t granularity =
+                detail::size_class_granularity(SizeClasses::max_size...);
+            static constexpr std::size_t max_size =
+                detail::size_class_max(SizeClasses::max_size...);
+
+            using table =
+                detail::size_class_table<detail::make_index_sequence<max_size / granularity + 1u>,
+                                         granularity, SizeClasses::max_size...>;
+
+        public:
+            using fallback_allocator_type = typename fallback_traits::allocator_type;
+
+            /// \effects Creates it by giving the size classes
+            /// and the \concept{concept_rawallocator,RawAllocator} used for bigger allocations.
+            explicit size_class_segregator(
+                SizeClasses... size_classes,
+                fallback_allocator_type fallback = fallback_allocator_type())
+            : storage_(detail::move(size_classes.get_allocator())..., detail::move(fallback))
+            {
+            }
+
+            /// @{
+            /// \effects Looks up the allocator of the smallest size class the allocation fits in,
+            /// which is the one a \ref segregator would choose.
+            /// Then forwards to the chosen allocator.
+            void* allocate_node(std::size_t size, std::size_t alignment)
+            {
+                return dispatch::allocate_node[index_of(size)](storage_, size, alignment);
+            }
+
+            void deallocate_node(void* ptr, std::size_t size, std::size_t alignment) noexcept
+            {
+                dispatch::deallocate_node[index_of(size)](storage_, ptr, size, alignment);
+            }
+
+            void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+            {
+                return dispatch::allocate_array[index_of(count * size)](storage_, count, size,
+                                                                        alignment);
+            }
+
+            void deallocate_array(void* array, std::size_t count, std::size_t size,
+                                  std::size_t alignment) noexcept
+            {
+                dispatch::deallocate_array[index_of(count * size)](storage_, array, count, size,
+                                                                   alignment);
+            }
+            /// @}
+
+            /// @{
+            /// \returns The maximum value of the fallback.
+            /// \note It assumes that the fallback will be used for larger allocations,
+            /// and the size classes for smaller ones.
+            std::size_t max_node_size() const
+            {
+                return fallback_traits::max_node_size(get_fallback_allocator());
+            }
+
+            std::size_t max_array_size() const
+            {
+                return fallback_traits::max_array_size(get_fallback_allocator());
+            }
+
+            std::size_t max_alignment() const
+            {
+                return fallback_traits::max_alignment(get_fallback_allocator());
+            }
+            /// @}
+
+            /// @{
+            /// \returns A reference to the allocator of the `I`th size class.
+            template <std::size_t I>
+            auto get_segregatable_allocator() noexcept
+                -> decltype(detail::get_size_class<I>(std::declval<storage&>()))
+            {
+                static_assert(I < sizeof...(SizeClasses), "invalid size class");
+                return detail::get_size_class<I>(storage_);
+            }
+
+            template <std::size_t I>
+            auto get_segregatable_allocator() const noexcept
+                -> decltype(detail::get_size_class<I>(std::declval<const storage&>()))
+            {
+                static_assert(I < sizeof...(SizeClasses), "invalid size class");
+                return detail::get_size_class<I>(storage_);
+            }
+            /// @}
+
+            /// @{
+            /// \returns A reference to the fallback allocator.
+            /// It will be used for allocations bigger than the biggest size class.
+            fallback_allocator_type& get_fallback_allocator() noexcept
+            {
+                return detail::get_size_class<sizeof...(SizeClasses)>(storage_);
+            }
+
+            const fallback_allocator_type& get_fallback_allocator() const noexcept
+            {
+                return detail::get_size_class<sizeof...(SizeClasses)>(storage_);
+            }
+            /// @}
+
+        private:
+            static std::size_t index_of(std::size_t size) noexcept
+            {
+                return size <= max_size ? table::value[(size + granularity - 1u) / granularity]
+                                        : sizeof...(SizeClasses);
+            }
+
+            storage storage_;
+        };
+
+        template <class Fallback, class... SizeClasses>
+        constexpr std::size_t size_class_segregator<Fallback, SizeClasses...>::granularity;
+
+        template <class Fallback, class... SizeClasses>
+        constexpr std::size_t size_class_segregator<Fallback, SizeClasses...>::max_size;
+
+        namespace detail
+        {
+            template <class List, class... Allocators>
+            struct make_size_class_segregator_t;
+
+            template <class... SizeClasses>
+            struct size_class_list
+            {
+            };
+
+            template <class Last>
+            struct is_size_class : std::false_type
+            {
+            };
+
+            template <std::size_t MaxSize, class RawAllocator>
+            struct is_size_class<size_class_segregatable<MaxSize, RawAllocator>> : std::true_type
+            {
+            };
+
+            // the last one is either the fallback or another size class
+            template <class... SizeClasses, class Last>
+            struct make_size_class_segregator_t<size_class_list<SizeClasses...>, Last>
+            {
+                using type = typename std::conditional<
+                    is_size_class<Last>::value,
+                    size_class_segregator<null_allocator, SizeClasses..., Last>,
+                    size_class_segregator<Last, SizeClasses...>>::type;
+            };
+
+            template <class... SizeClasses, class Head, class Next, class... Tail>
+            struct make_size_class_segregator_t<size_class_list<SizeClasses...>, Head, Next,
+                                                Tail...>
+            : make_size_class_segregator_t<size_class_list<SizeClasses..., Head>, Next, Tail...>
+            {
+            };
+
+            template <std::size_t I, class Fallback, class... SizeClasses>
+            struct segregatable_type<I, size_class_segregator<Fallback, SizeClasses...>>
+            {
+                using type = typename std::decay<decltype(
+                    std::declval<size_class_segregator<Fallback, SizeClasses...>&>()
+                        .template get_segregatable_allocator<I>())>::type;
+
+                static type& get(size_class_segregator<Fallback, SizeClasses...>& s)
+                {
+                    return s.template get_segregatable_allocator<I>();
+                }
+
+                static const type& get(const size_class_segregator<Fallback, SizeClasses...>& s)
+                {
+                    return s.template get_segregatable_allocator<I>();
+                }
+            };
+
+            template <class Fallback, class... SizeClasses>
+            struct fallback_type<size_class_segregator<Fallback, SizeClasses...>>
+            {
+                using segregator = size_class_segregator<Fallback, SizeClasses...>;
+                using type       = typename segregator::fallback_allocator_type;
+
+                static const std::size_t size = sizeof...(SizeClasses);
+
+                static type& get(size_class_segregator<Fallback, SizeClasses...>& s)
+                {
+                    return s.get_fallback_allocator();
+                }
+
+                static const type& get(const size_class_segregator<Fallback, SizeClasses...>& s)
+                {
+                    return s.get_fallback_allocator();
+                }
+            };
+        } // namespace detail
+
+        /// \returns A \ref size_class_segregator created from the allocators `args`.
+        /// They must be \ref size_class_segregatable objects in ascending order of their maximum size,
+        /// optionally followed by the \concept{concept_rawallocator,RawAllocator} used as fallback,
+        /// just like for \ref make_segregator().
+        /// If there is no fallback, it is \ref null_allocator.
+        /// \relates size_class_segregator
+        template <typename... Args>
+        auto make_size_class_segregator(Args&&... args) ->
+            typename detail::make_size_class_segregator_t<detail::size_class_list<>,
+                                                          typename std::decay<Args>::type...>::type
+        {
+            return typename detail::make_size_class_segregator_t<
+                detail::size_class_list<>,
+                typename std::decay<Args>::type...>::type(std::forward<Args>(args)...);
+        }
+
+        /// @{
+        /// \returns The allocator of the `I`th size class.
+        /// \relates size_class_segregator
+        template <std::size_t I, class Fallback, class... SizeClasses>
+        auto get_segregatable_allocator(size_class_segregator<Fallback, SizeClasses...>& s)
+            -> segregatable_allocator_type<I, size_class_segregator<Fallback, SizeClasses...>>&
+        {
+            return s.template get_segregatable_allocator<I>();
+        }
+
+        template <std::size_t I, class Fallback, class... SizeClasses>
+        auto get_segregatable_allocator(const size_class_segregator<Fallback, SizeClasses...>& s)
+            -> const segregatable_allocator_type<I,
+                                                 size_class_segregator<Fallback, SizeClasses...>>&
+        {
+            return s.template get_segregatable_allocator<I>();
+        }
+        /// @}
+
+        /// @{
+        /// \returns The fallback \concept{concept_rawallocator,RawAllocator}.
+        /// \relates size_class_segregator
+        template <class Fallback, class... SizeClasses>
+        auto get_fallback_allocator(size_class_segregator<Fallback, SizeClasses...>& s)
+            -> fallback_allocator_type<size_class_segregator<Fallback, SizeClasses...>>&
+        {
+            return s.get_fallback_allocator();
+        }
+
+        template <class Fallback, class... SizeClasses>
+        auto get_fallback_allocator(const size_class_segregator<Fallback, SizeClasses...>& s)
+            -> const fallback_allocator_type<size_class_segregator<Fallback, SizeClasses...>>&
+        {
+            return s.get_fallback_allocator();
+        }
+        /// @}
     } // namespace memory
 } // namespace foonathan
 
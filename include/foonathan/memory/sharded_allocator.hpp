@@ -0,0 +1,269 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_SHARDED_ALLOCATOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_SHARDED_ALLOCATOR_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::sharded_allocator.
+
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+#include "detail/assert.hpp"
+#include "allocator_traits.hpp"
+#include "config.hpp"
+#include "error.hpp"
+
+#if !FOONATHAN_HOSTED_IMPLEMENTATION
+#error "sharded_allocator requires a hosted implementation"
+#endif
+
+namespace foonathan
+{
+    namespace memory
+    {
+        namespace detail
+        {
+            // returns a number unique to the calling thread,
+            // the numbers are assigned consecutively on first use
+            std::size_t thread_shard_hint() noexcept;
+        } // namespace detail
+
+        /// A stateful \concept{concept_rawallocator,RawAllocator} that spreads the allocations of multiple threads
+        /// over \c Shards independent instances of a \concept{concept_rawallocator,ComposableAllocator},
+        /// each protected by its own \c Mutex.
+        /// Each thread allocates from the shard assigned to it in a round-robin fashion on its first use,
+        /// so with as many shards as threads there is almost no lock contention,
+        /// unlike a \ref thread_safe_allocator where all threads share one lock.
+        /// Deallocation first tries the shard of the calling thread
+        /// and then asks the other shards whether they own the memory via their \c try_deallocate functions,
+        /// e.g. a \ref memory_pool checks whether the memory lies in one of its blocks.
+        /// \note Memory deallocated by another thread than the one that allocated it
+        /// may need to lock multiple shards, so it is slower.
+        /// \ingroup allocator
+        template <class RawAllocator, std::size_t Shards, class Mutex = std::mutex>
+        class sharded_allocator
+        {
+            static_assert(Shards > 0u, "must have at least one shard");
+            static_assert(is_composable_allocator<RawAllocator>::value,
+                          "RawAllocator must be composable to find the owning shard");
+
+            using traits            = allocator_traits<RawAllocator>;
+            using composable_traits = composable_allocator_traits<RawAllocator>;
+
+        public:
+            using allocator_type = typename traits::allocator_type;
+            using mutex          = Mutex;
+            using is_stateful    = std::true_type;
+
+            /// \effects Creates each shard by passing the same arguments to the constructor of the \c RawAllocator.
+            /// \throws Anything thrown by the constructor.
+            template <typename... Args>
+            explicit sharded_allocator(const Args&... args)
+            {
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+                std::size_t i = 0u;
+                try
+                {
+                    for (; i != Shards; ++i)
+                        ::new (static_cast<void*>(&storage_[i])) shard(args...);
+                }
+                catch (...)
+                {
+                    while (i-- != 0u)
+                        get_shard(i).~shard();
+                    throw;
+                }
+#else
+                for (std::size_t i = 0u; i != Shards; ++i)
+                    ::new (static_cast<void*>(&storage_[i])) shard(args...);
+#endif
+            }
+
+            /// \effects Destroys all shards.
+            ~sharded_allocator() noexcept
+            {
+                for (std::size_t i = 0u; i != Shards; ++i)
+                    get_shard(i).~shard();
+            }
+
+            sharded_allocator(const sharded_allocator&)            = delete;
+            sharded_allocator& operator=(const sharded_allocator&) = delete;
+
+            /// @{
+            /// \effects Allocates from the shard of the calling thread while holding its lock.
+            /// \returns The result of the allocator of the shard.
+            /// \throws Anything thrown by the allocator.
+            void* allocate_node(std::size_t size, std::size_t alignment)
+            {
+                auto&                  s = get_shard(current_shard());
+                std::lock_guard<Mutex> lock(s.mutex);
+                return traits::allocate_node(s.alloc, size, alignment);
+            }
+
+            void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+            {
+                auto&                  s = get_shard(current_shard());
+                std::lock_guard<Mutex> lock(s.mutex);
+                return traits::allocate_array(s.alloc, count, size, alignment);
+            }
+            /// @}
+
+            /// @{
+            /// \effects Allocates from the shard of the calling thread,
+            /// similar to the \c try_allocate functions of the allocator.
+            /// \returns The result of the allocator of the shard.
+            void* try_allocate_node(std::size_t size, std::size_t alignment) noexcept
+            {
+                auto&                  s = get_shard(current_shard());
+                std::lock_guard<Mutex> lock(s.mutex);
+                return composable_traits::try_allocate_node(s.alloc, size, alignment);
+            }
+
+            void* try_allocate_array(std::size_t count, std::size_t size,
+                                     std::size_t alignment) noexcept
+            {
+                auto&                  s = get_shard(current_shard());
+                std::lock_guard<Mutex> lock(s.mutex);
+                return composable_traits::try_allocate_array(s.alloc, count, size, alignment);
+            }
+            /// @}
+
+            /// @{
+            /// \effects Deallocates the memory in the shard owning it.
+            /// \requires The memory must have been allocated by this allocator.
+            void deallocate_node(void* node, std::size_t size, std::size_t alignment) noexcept
+            {
+                auto deallocated = try_deallocate_node(node, size, alignment);
+                FOONATHAN_MEMORY_ASSERT_MSG(deallocated, "memory not owned by any shard");
+                (void)deallocated;
+            }
+
+            void deallocate_array(void* array, std::size_t count, std::size_t size,
+                                  std::size_t alignment) noexcept
+            {
+                auto deallocated = try_deallocate_array(array, count, size, alignment);
+                FOONATHAN_MEMORY_ASSERT_MSG(deallocated, "memory not owned by any shard");
+                (void)deallocated;
+            }
+            /// @}
+
+            /// @{
+            /// \effects Deallocates the memory in the shard owning it, trying the shard of the calling thread first.
+            /// \returns Whether or not any shard owned the memory.
+            bool try_deallocate_node(void* node, std::size_t size, std::size_t alignment) noexcept
+            {
+                return for_owning_shard(
+                    [&](allocator_type& alloc)
+                    {
+                        return composable_traits::try_deallocate_node(alloc, node, size,
+                                                                      alignment);
+                    });
+            }
+
+            bool try_deallocate_array(void* array, std::size_t count, std::size_t size,
+                                      std::size_t alignment) noexcept
+            {
+                return for_owning_shard(
+                    [&](allocator_type& alloc)
+                    {
+                        return composable_traits::try_deallocate_array(alloc, array, count, size,
+                                                                       alignment);
+                    });
+            }
+            /// @}
+
+            /// @{
+            /// \returns The maximum sizes and alignment supported by the allocator of the first shard.
+            std::size_t max_node_size() const
+            {
+                auto&                  s = get_shard(0u);
+                std::lock_guard<Mutex> lock(s.mutex);
+                return traits::max_node_size(s.alloc);
+            }
+
+            std::size_t max_array_size() const
+            {
+                auto&                  s = get_shard(0u);
+                std::lock_guard<Mutex> lock(s.mutex);
+                return traits::max_array_size(s.alloc);
+            }
+
+            std::size_t max_alignment() const
+            {
+                auto&                  s = get_shard(0u);
+                std::lock_guard<Mutex> lock(s.mutex);
+                return traits::max_alignment(s.alloc);
+            }
+            /// @}
+
+            /// \returns The number of shards.
+            /// This is the template parameter `Shards`.
+            static constexpr std::size_t shard_count() noexcept
+            {
+                return Shards;
+            }
+
+            /// \returns The index of the shard the calling thread allocates from.
+            static std::size_t current_shard() noexcept
+            {
+                return detail::thread_shard_hint() % Shards;
+            }
+
+            /// \effects Calls \c f with a reference to the allocator of the given shard while holding its lock.
+            /// \returns The result of \c f.
+            /// \requires \c i must be less than \ref shard_count().
+            template <typename Func>
+            auto with_shard(std::size_t i, Func f) -> decltype(f(std::declval<allocator_type&>()))
+            {
+                auto&                  s = get_shard(i);
+                std::lock_guard<Mutex> lock(s.mutex);
+                return f(s.alloc);
+            }
+
+        private:
+            struct alignas(64) shard
+            {
+                mutable Mutex  mutex;
+                allocator_type alloc;
+
+                template <typename... Args>
+                explicit shard(const Args&... args) : alloc(args...)
+                {
+                }
+            };
+
+            shard& get_shard(std::size_t i) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(i < Shards);
+                return *static_cast<shard*>(static_cast<void*>(&storage_[i]));
+            }
+
+            const shard& get_shard(std::size_t i) const noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(i < Shards);
+                return *static_cast<const shard*>(static_cast<const void*>(&storage_[i]));
+            }
+
+            template <typename Func>
+            bool for_owning_shard(Func try_dealloc) noexcept
+            {
+                auto first = current_shard();
+                for (std::size_t n = 0u; n != Shards; ++n)
+                {
+                    auto&                  s = get_shard((first + n) % Shards);
+                    std::lock_guard<Mutex> lock(s.mutex);
+                    if (try_dealloc(s.alloc))
+                        return true;
+                }
+                return false;
+            }
+
+            typename std::aligned_storage<sizeof(shard), alignof(shard)>::type storage_[Shards];
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_SHARDED_ALLOCATOR_HPP_INCLUDED
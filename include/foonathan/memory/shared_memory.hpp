@@ -0,0 +1,508 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_SHARED_MEMORY_HPP_INCLUDED
+#define FOONATHAN_MEMORY_SHARED_MEMORY_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::shared_memory_block_allocator and the offset-based \ref foonathan::memory::offset_std_allocator.
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+#include "detail/utility.hpp"
+#include "config.hpp"
+#include "error.hpp"
+#include "memory_arena.hpp"
+#include "std_allocator.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        namespace detail
+        {
+            template <typename T>
+            struct offset_ptr_element
+            {
+                using reference = T&;
+            };
+
+            // allows declaring the functions of offset_ptr<void>, they are just never used
+            template <>
+            struct offset_ptr_element<void>
+            {
+                using reference = char&;
+            };
+
+            template <>
+            struct offset_ptr_element<const void>
+            {
+                using reference = const char&;
+            };
+        } // namespace detail
+
+        /// A fancy pointer that stores the distance between the object it points to and itself.
+        /// As long as both lie in the same memory mapping,
+        /// it stays valid if the mapping is moved to a different address,
+        /// e.g. when the same shared memory is mapped into several processes.
+        /// It fulfills the requirements of a random access iterator and of the \c NullablePointer concept
+        /// and can be used as the \c pointer type of an allocator, like \ref offset_std_allocator does.
+        /// \note Copying it into memory outside of the mapping leads to a pointer that is only valid for the current mapping,
+        /// copy it back into the mapping before it is used by another process.
+        /// \ingroup adapter
+        template <typename T>
+        class offset_ptr
+        {
+        public:
+            using element_type      = T;
+            using value_type        = typename std::remove_cv<T>::type;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = T*;
+            using reference         = typename detail::offset_ptr_element<T>::reference;
+            using iterator_category = std::random_access_iterator_tag;
+
+            template <typename U>
+            using rebind = offset_ptr<U>;
+
+            //=== constructors ===//
+            /// @{
+            /// \effects Creates a null pointer.
+            offset_ptr() noexcept : offset_(null_offset) {}
+
+            offset_ptr(std::nullptr_t) noexcept : offset_(null_offset) {}
+            /// @}
+
+            /// \effects Creates it pointing to the same object as \c ptr.
+            offset_ptr(T* ptr) noexcept : offset_(to_offset(ptr)) {}
+
+            /// \effects Creates it pointing to the same object as \c other.
+            /// The stored offset is recomputed for the new location.
+            offset_ptr(const offset_ptr& other) noexcept : offset_(to_offset(other.get())) {}
+
+            /// \effects Creates it from an \ref offset_ptr to a type implicitly convertible to it,
+            /// e.g. a non-\c const or a derived type.
+            template <typename U, FOONATHAN_REQUIRES((std::is_convertible<U*, T*>::value))>
+            offset_ptr(const offset_ptr<U>& other) noexcept : offset_(to_offset(other.get()))
+            {
+            }
+
+            /// \effects Creates it from an \ref offset_ptr using a \c static_cast,
+            /// e.g. from <tt>offset_ptr<void></tt>.
+            template <typename U, FOONATHAN_REQUIRES((!std::is_convertible<U*, T*>::value)),
+                      typename = decltype(static_cast<T*>(std::declval<U*>()))>
+            explicit offset_ptr(const offset_ptr<U>& other) noexcept
+            : offset_(to_offset(static_cast<T*>(other.get())))
+            {
+            }
+
+            /// @{
+            /// \effects Changes the object it points to.
+            offset_ptr& operator=(const offset_ptr& other) noexcept
+            {
+                offset_ = to_offset(other.get());
+                return *this;
+            }
+
+            offset_ptr& operator=(T* ptr) noexcept
+            {
+                offset_ = to_offset(ptr);
+                return *this;
+            }
+
+            offset_ptr& operator=(std::nullptr_t) noexcept
+            {
+                offset_ = null_offset;
+                return *this;
+            }
+            /// @}
+
+            /// \returns An \ref offset_ptr to the given object.
+            /// This is required by <tt>std::pointer_traits</tt>.
+            static offset_ptr pointer_to(reference obj) noexcept
+            {
+                return offset_ptr(static_cast<T*>(&obj));
+            }
+
+            //=== access ===//
+            /// \returns The native pointer to the object in the current mapping.
+            T* get() const noexcept
+            {
+                return offset_ == null_offset ?
+                           nullptr :
+                           reinterpret_cast<T*>(reinterpret_cast<std::uintptr_t>(this)
+                                                + static_cast<std::uintptr_t>(offset_));
+            }
+
+            /// \returns Whether or not it is not a null pointer.
+            explicit operator bool() const noexcept
+            {
+                return offset_ != null_offset;
+            }
+
+            /// @{
+            /// \returns The object it points to.
+            /// \requires It must not be a null pointer.
+            reference operator*() const noexcept
+            {
+                return *get();
+            }
+
+            T* operator->() const noexcept
+            {
+                return get();
+            }
+
+            reference operator[](difference_type i) const noexcept
+            {
+                return get()[i];
+            }
+            /// @}
+
+            //=== arithmetic ===//
+            /// @{
+            /// \effects Moves the pointer like a native pointer.
+            offset_ptr& operator+=(difference_type n) noexcept
+            {
+                return *this = get() + n;
+            }
+
+            offset_ptr& operator-=(difference_type n) noexcept
+            {
+                return *this = get() - n;
+            }
+
+            offset_ptr& operator++() noexcept
+            {
+                return *this += 1;
+            }
+
+            offset_ptr operator++(int) noexcept
+            {
+                auto result = *this;
+                ++*this;
+                return result;
+            }
+
+            offset_ptr& operator--() noexcept
+            {
+                return *this -= 1;
+            }
+
+            offset_ptr operator--(int) noexcept
+            {
+                auto result = *this;
+                --*this;
+                return result;
+            }
+
+            friend offset_ptr operator+(const offset_ptr& ptr, difference_type n) noexcept
+            {
+                return offset_ptr(ptr.get() + n);
+            }
+
+            friend offset_ptr operator+(difference_type n, const offset_ptr& ptr) noexcept
+            {
+                return offset_ptr(ptr.get() + n);
+            }
+
+            friend offset_ptr operator-(const offset_ptr& ptr, difference_type n) noexcept
+            {
+                return offset_ptr(ptr.get() - n);
+            }
+
+            friend difference_type operator-(const offset_ptr& a, const offset_ptr& b) noexcept
+            {
+                return a.get() - b.get();
+            }
+            /// @}
+
+            //=== comparison ===//
+            /// @{
+            /// \returns The result of the comparison of the native pointers.
+            friend bool operator==(const offset_ptr& a, const offset_ptr& b) noexcept
+            {
+                return a.get() == b.get();
+            }
+
+            friend bool operator!=(const offset_ptr& a, const offset_ptr& b) noexcept
+            {
+                return a.get() != b.get();
+            }
+
+            friend bool operator<(const offset_ptr& a, const offset_ptr& b) noexcept
+            {
+                return a.get() < b.get();
+            }
+
+            friend bool operator>(const offset_ptr& a, const offset_ptr& b) noexcept
+            {
+                return a.get() > b.get();
+            }
+
+            friend bool operator<=(const offset_ptr& a, const offset_ptr& b) noexcept
+            {
+                return a.get() <= b.get();
+            }
+
+            friend bool operator>=(const offset_ptr& a, const offset_ptr& b) noexcept
+            {
+                return a.get() >= b.get();
+            }
+
+            friend bool operator==(const offset_ptr& a, std::nullptr_t) noexcept
+            {
+                return !a;
+            }
+
+            friend bool operator==(std::nullptr_t, const offset_ptr& a) noexcept
+            {
+                return !a;
+            }
+
+            friend bool operator!=(const offset_ptr& a, std::nullptr_t) noexcept
+            {
+                return bool(a);
+            }
+
+            friend bool operator!=(std::nullptr_t, const offset_ptr& a) noexcept
+            {
+                return bool(a);
+            }
+            /// @}
+
+        private:
+            // an object can never start in the middle of the pointer itself
+            static constexpr std::ptrdiff_t null_offset = 1;
+
+            std::ptrdiff_t to_offset(T* ptr) const noexcept
+            {
+                return ptr ? static_cast<std::ptrdiff_t>(reinterpret_cast<std::uintptr_t>(ptr)
+                                                         - reinterpret_cast<std::uintptr_t>(this)) :
+                             null_offset;
+            }
+
+            std::ptrdiff_t offset_;
+        };
+
+        template <typename T>
+        constexpr std::ptrdiff_t offset_ptr<T>::null_offset;
+
+        /// \returns The native pointer stored in the \ref offset_ptr.
+        /// \relates offset_ptr
+        template <typename T>
+        T* to_address(const offset_ptr<T>& ptr) noexcept
+        {
+            return ptr.get();
+        }
+
+        /// A \ref std_allocator whose \c pointer type is \ref offset_ptr.
+        /// The containers using it contain only offsets to their memory,
+        /// so if they and the memory of the \concept{concept_rawallocator,RawAllocator} are placed in the same shared memory,
+        /// e.g. allocated from a \ref shared_memory_block_allocator,
+        /// they can be used by all processes mapping it, even at different addresses.
+        /// \note Like \ref std_allocator it stores a native reference to the \c RawAllocator,
+        /// so only the process owning it may allocate or deallocate memory through it,
+        /// i.e. modify the size of the containers.
+        /// All other processes may only read and write the existing elements.
+        /// \note It only works with containers that support fancy pointers, e.g. \c std::vector and \c std::deque.
+        /// \ingroup adapter
+        template <typename T, class RawAllocator>
+        class offset_std_allocator : public std_allocator<T, RawAllocator>
+        {
+            using std_alloc = std_allocator<T, RawAllocator>;
+
+        public:
+            using pointer            = offset_ptr<T>;
+            using const_pointer      = offset_ptr<const T>;
+            using void_pointer       = offset_ptr<void>;
+            using const_void_pointer = offset_ptr<const void>;
+            using size_type          = typename std_alloc::size_type;
+
+            template <typename U>
+            struct rebind
+            {
+                using other = offset_std_allocator<U, RawAllocator>;
+            };
+
+            /// \effects Creates it in the same way as a \ref std_allocator.
+            using std_alloc::std_alloc;
+
+            /// \effects Creates it from a \ref std_allocator using the same allocator.
+            offset_std_allocator(const std_alloc& alloc) noexcept : std_alloc(alloc) {}
+
+            /// \effects Creates it from another \ref offset_std_allocator allocating a different type.
+            template <typename U>
+            offset_std_allocator(const offset_std_allocator<U, RawAllocator>& alloc) noexcept
+            : std_alloc(alloc)
+            {
+            }
+
+            /// \returns A copy of the allocator, forwarding to the \ref propagation_traits.
+            offset_std_allocator select_on_container_copy_construction() const
+            {
+                return std_alloc::select_on_container_copy_construction();
+            }
+
+            /// \effects Allocates memory like \ref std_allocator::allocate().
+            /// \returns An \ref offset_ptr to the memory.
+            /// \throws Anything thrown by the \c RawAllocator.
+            pointer allocate(size_type n, void* = nullptr)
+            {
+                return pointer(std_alloc::allocate(n));
+            }
+
+#if defined(__cpp_lib_allocate_at_least)
+            /// \effects Allocates memory like \ref std_allocator::allocate_at_least().
+            /// \returns An \ref offset_ptr to the memory and the number of objects that fit into it.
+            /// \throws Anything thrown by the \c RawAllocator.
+            std::allocation_result<pointer, size_type> allocate_at_least(size_type n)
+            {
+                auto result = std_alloc::allocate_at_least(n);
+                return {pointer(result.ptr), result.count};
+            }
+#endif
+
+            /// \effects Deallocates memory like \ref std_allocator::deallocate().
+            void deallocate(pointer p, size_type n) noexcept
+            {
+                std_alloc::deallocate(p.get(), n);
+            }
+        };
+
+        /// A \concept{concept_blockallocator,BlockAllocator} that allocates the blocks from named shared memory.
+        /// It uses \c shm_open() on POSIX systems and a named file mapping backed by the paging file on Windows.
+        /// Like \ref mmap_block_allocator it maps <tt>block_size * no_blocks</tt> bytes up front,
+        /// hands out consecutive blocks starting at the beginning of the shared memory
+        /// and, on POSIX systems, grows the shared memory object when a block beyond its current end is allocated.
+        /// Deallocations are only allowed in reversed order which is guaranteed by \ref memory_arena.<br>
+        /// One process creates the data structures by allocating from the blocks, e.g. through a \ref memory_stack,
+        /// the other processes only map the memory with an allocator of the same size and name
+        /// and access the data relative to \ref memory().
+        /// \note As the memory can be mapped at a different address in each process,
+        /// pointers stored in it must be \ref offset_ptr, e.g. by using \ref offset_std_allocator for containers.
+        /// \note The shared memory is not removed when the allocator is destroyed, use \ref remove() for that.
+        /// \ingroup allocator
+        class shared_memory_block_allocator
+        {
+        public:
+            /// \effects Creates it giving it the block size, the total number of blocks it can allocate and the name of the shared memory.
+            /// The shared memory is created if it does not exist, otherwise its existing contents are mapped.
+            /// The order of the parameters allows creating it through \ref memory_arena,
+            /// e.g. <tt>memory_stack<shared_memory_block_allocator>(block_size, no_blocks, name)</tt>.
+            /// \requires \c block_size must be non-zero and a multiple of the \ref virtual_memory_page_size.
+            /// \c no_blocks must be bigger than \c 0.
+            /// \c name must be a valid name for shared memory on the system, e.g. start with a slash on POSIX.
+            /// \throws \ref out_of_memory if it cannot open or map the shared memory.
+            shared_memory_block_allocator(std::size_t block_size, std::size_t no_blocks,
+                                          const char* name);
+
+            /// \effects Unmaps the shared memory and closes it.
+            /// The shared memory itself stays until it is removed.
+            ~shared_memory_block_allocator() noexcept;
+
+            /// @{
+            /// \effects Moves the block allocator, it transfers ownership over the mapping.
+            /// This does not invalidate any memory blocks.
+            shared_memory_block_allocator(shared_memory_block_allocator&& other) noexcept
+            : begin_(other.begin_),
+              cur_(other.cur_),
+              end_(other.end_),
+              block_size_(other.block_size_),
+              size_(other.size_),
+              handle_(other.handle_)
+            {
+                other.begin_ = other.cur_ = other.end_ = nullptr;
+                other.block_size_ = other.size_ = 0u;
+                other.handle_                   = invalid_handle();
+            }
+
+            shared_memory_block_allocator& operator=(shared_memory_block_allocator&& other) noexcept
+            {
+                shared_memory_block_allocator tmp(detail::move(other));
+                swap(*this, tmp);
+                return *this;
+            }
+            /// @}
+
+            /// \effects Swaps the ownership over the mapping.
+            /// This does not invalidate any memory blocks.
+            friend void swap(shared_memory_block_allocator& a,
+                             shared_memory_block_allocator& b) noexcept
+            {
+                detail::adl_swap(a.begin_, b.begin_);
+                detail::adl_swap(a.cur_, b.cur_);
+                detail::adl_swap(a.end_, b.end_);
+                detail::adl_swap(a.block_size_, b.block_size_);
+                detail::adl_swap(a.size_, b.size_);
+                detail::adl_swap(a.handle_, b.handle_);
+            }
+
+            /// \effects Allocates the next \ref next_block_size() bytes of the shared memory,
+            /// growing it if the block is beyond its end.
+            /// \returns The new memory block.
+            /// \throws \ref out_of_fixed_memory if the \ref capacity_left() is exhausted,
+            /// \ref out_of_memory if the shared memory cannot be grown.
+            memory_block allocate_block();
+
+            /// \effects Deallocates the last allocated memory block.
+            /// This block will be returned again on the next call to \ref allocate_block(),
+            /// its contents are kept.
+            /// \requires \c block must be the current top block of the memory,
+            /// this is guaranteed by \ref memory_arena.
+            void deallocate_block(memory_block block) noexcept;
+
+            /// \returns The beginning of the mapping in the current process.
+            /// Its contents are the same in all processes.
+            void* memory() const noexcept
+            {
+                return begin_;
+            }
+
+            /// \returns The size of the shared memory, it is at least the size of all allocated blocks.
+            /// \note On Windows, the entire mapping is reserved when it is created.
+            std::size_t size() const noexcept
+            {
+                return size_;
+            }
+
+            /// \returns The next block size, this is the block size of the constructor.
+            std::size_t next_block_size() const noexcept
+            {
+                return block_size_;
+            }
+
+            /// \returns The number of blocks that can be allocated until it runs out of memory.
+            std::size_t capacity_left() const noexcept
+            {
+                return static_cast<std::size_t>(end_ - cur_) / block_size_;
+            }
+
+            /// \returns The alignment of all memory blocks, which is the \ref virtual_memory_page_size.
+            std::size_t block_alignment() const noexcept;
+
+            /// \effects Removes the shared memory with the given name,
+            /// it is destroyed once all processes have unmapped it.
+            /// \returns Whether or not it was successful.
+            /// \note On Windows, this function does nothing,
+            /// the shared memory is destroyed once the last process has unmapped it.
+            static bool remove(const char* name) noexcept;
+
+        private:
+            static std::intptr_t invalid_handle() noexcept
+            {
+                return -1;
+            }
+
+            allocator_info info() noexcept;
+
+            char *        begin_, *cur_, *end_;
+            std::size_t   block_size_, size_;
+            std::intptr_t handle_;
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_SHARED_MEMORY_HPP_INCLUDED
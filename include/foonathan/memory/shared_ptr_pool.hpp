@@ -0,0 +1,100 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_SHARED_PTR_POOL_HPP_INCLUDED
+#define FOONATHAN_MEMORY_SHARED_PTR_POOL_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::shared_ptr_pool.
+/// \note Only available on a hosted implementation.
+
+#include "config.hpp"
+#if !FOONATHAN_HOSTED_IMPLEMENTATION
+#error "This header is only available for a hosted implementation."
+#endif
+
+#include <memory>
+
+#include "detail/utility.hpp"
+#include "container.hpp"
+#include "memory_pool.hpp"
+#include "smart_ptr.hpp"
+
+#if defined(FOONATHAN_MEMORY_NO_NODE_SIZE)
+#error "shared_ptr_pool requires the node size of std::allocate_shared"
+#endif
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// A pool that creates \c std::shared_ptr objects of type \c T.
+        /// It owns a \c PoolAllocator whose nodes are exactly big enough for the combined control block and object
+        /// created by \ref allocate_shared, as given by \ref allocate_shared_node_size,
+        /// so creating a shared pointer does not need a general purpose heap allocation.
+        /// The \c PoolAllocator defaults to a \ref memory_pool,
+        /// use a \ref thread_cached_pool if the shared pointers are created or destroyed on multiple threads.
+        /// \requires The shared pool must live as long as all shared pointers created from it,
+        /// including their weak pointers.
+        /// \ingroup adapter
+        template <typename T, class PoolAllocator = memory_pool<>>
+        class shared_ptr_pool
+        {
+        public:
+            using value_type     = T;
+            using allocator_type = PoolAllocator;
+
+            /// The node size of the pool required for one shared pointer.
+            static constexpr std::size_t node_size =
+                allocate_shared_node_size<T, allocator_type>::value;
+
+            /// \returns The minimum block size required for the given number of shared pointers.
+            static constexpr std::size_t min_block_size(std::size_t number_of_objects) noexcept
+            {
+                return allocator_type::min_block_size(node_size, number_of_objects);
+            }
+
+            /// \effects Creates it by creating the \c PoolAllocator with the \ref node_size
+            /// and the given block size and other arguments.
+            template <typename... Args>
+            explicit shared_ptr_pool(std::size_t block_size, Args&&... args)
+            : pool_(node_size, block_size, detail::forward<Args>(args)...)
+            {
+            }
+
+            shared_ptr_pool(const shared_ptr_pool&)            = delete;
+            shared_ptr_pool& operator=(const shared_ptr_pool&) = delete;
+
+            /// \effects Allocates a node from the pool and creates an object of type \c T in it
+            /// from the given arguments.
+            /// \returns A \c std::shared_ptr owning the object.
+            /// \throws Anything thrown by the allocation or the constructor of \c T.
+            template <typename... Args>
+            std::shared_ptr<T> make_shared(Args&&... args)
+            {
+                return allocate_shared<T>(pool_, detail::forward<Args>(args)...);
+            }
+
+            /// @{
+            /// \returns A reference to the pool used for the allocation.
+            allocator_type& get_allocator() noexcept
+            {
+                return pool_;
+            }
+
+            const allocator_type& get_allocator() const noexcept
+            {
+                return pool_;
+            }
+            /// @}
+
+        private:
+            allocator_type pool_;
+        };
+
+        template <typename T, class PoolAllocator>
+        constexpr std::size_t shared_ptr_pool<T, PoolAllocator>::node_size;
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_SHARED_PTR_POOL_HPP_INCLUDED
@@ -0,0 +1,342 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_SMALL_VECTOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_SMALL_VECTOR_HPP_INCLUDED
+
+/// \file
+/// Class template \ref foonathan::memory::small_vector.
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "detail/utility.hpp"
+#include "config.hpp"
+#include "vector_buffer.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// A growable array of \c T that stores up to \c N elements inline in the object itself
+        /// and only takes memory from a \concept{concept_rawallocator,RawAllocator} once it grows beyond that.
+        /// Once spilled, it grows like \ref vector_buffer:
+        /// it first asks the allocator to expand the memory in place via \c try_expand_array() of the \ref allocator_traits,
+        /// and new memory is allocated with \c allocate_array_at_least(), so any slack of the allocator is used as capacity.
+        /// With an allocator like \ref memory_stack or \ref temporary_allocator,
+        /// short arrays never touch the allocator and the others get the speed of a bump allocation.
+        /// \note Unlike \ref vector_buffer, moving it moves the elements if they are stored inline,
+        /// which invalidates iterators.
+        /// \ingroup adapter
+        template <typename T, std::size_t N, class RawAllocator>
+        class small_vector : detail::vector_storage<T, N, RawAllocator>
+        {
+            static_assert(N > 0u, "use vector_buffer without inline storage");
+
+            using storage       = detail::vector_storage<T, N, RawAllocator>;
+            using allocator_ref = typename storage::allocator_ref;
+            using storage::data_;
+            using storage::size_;
+            using storage::capacity_;
+            using storage::construct_back;
+            using storage::deallocate;
+
+        public:
+            using value_type     = T;
+            using allocator_type = typename allocator_ref::allocator_type;
+            using iterator       = T*;
+            using const_iterator = const T*;
+
+            /// The number of elements stored inline.
+            static constexpr std::size_t inline_capacity = N;
+
+            //=== constructors/destructor ===//
+            /// \effects Creates an empty array that will use the given allocator once it spills.
+            /// It does not allocate any memory.
+            explicit small_vector(allocator_ref alloc) noexcept : storage(detail::move(alloc)) {}
+
+            /// \effects Move constructs the array by taking over the memory of \c other,
+            /// or by moving its elements if they are stored inline.
+            /// \c other will be empty afterwards.
+            small_vector(small_vector&& other) noexcept(
+                std::is_nothrow_move_constructible<T>::value)
+            : storage(detail::move(static_cast<allocator_ref&>(other)))
+            {
+                take(other);
+            }
+
+            /// \effects Destroys all elements and deallocates the memory.
+            ~small_vector() noexcept = default;
+
+            /// \effects Move assigns the array by taking over the memory of \c other,
+            /// or by moving its elements if they are stored inline.
+            /// \c other will be empty afterwards.
+            small_vector& operator=(small_vector&& other) noexcept(
+                std::is_nothrow_move_constructible<T>::value)
+            {
+                if (this != &other)
+                {
+                    clear();
+                    deallocate();
+                    data_     = this->inline_data();
+                    capacity_ = N;
+
+                    static_cast<allocator_ref&>(*this) =
+                        detail::move(static_cast<allocator_ref&>(other));
+                    take(other);
+                }
+                return *this;
+            }
+
+            small_vector(const small_vector&)            = delete;
+            small_vector& operator=(const small_vector&) = delete;
+
+            //=== modifiers ===//
+            /// \effects Creates a new element at the end by forwarding the arguments to its constructor,
+            /// growing the array if necessary.
+            /// \returns A reference to the new element.
+            /// \throws Anything thrown by the allocation or the constructor of \c T.
+            /// If an exception is thrown, the array is unchanged.
+            template <typename... Args>
+            T& emplace_back(Args&&... args)
+            {
+                return storage::emplace_back(detail::forward<Args>(args)...);
+            }
+
+            /// @{
+            /// \effects Same as `emplace_back(value)`.
+            void push_back(const T& value)
+            {
+                emplace_back(value);
+            }
+
+            void push_back(T&& value)
+            {
+                emplace_back(detail::move(value));
+            }
+            /// @}
+
+            /// \effects Creates a new element before \c pos by forwarding the arguments to its constructor,
+            /// growing the array if necessary, the following elements are moved back by one.
+            /// \returns An iterator to the new element.
+            /// \throws Anything thrown by the allocation or the constructor or move operations of \c T.
+            /// If an exception is thrown before the last element was moved back, the array is unchanged.
+            /// \requires \c pos must be an iterator into the array or \ref end().
+            template <typename... Args>
+            iterator emplace(const_iterator pos, Args&&... args)
+            {
+                return storage::emplace(pos, detail::forward<Args>(args)...);
+            }
+
+            /// @{
+            /// \effects Destroys the element or the elements in the range,
+            /// the following elements are moved forward.
+            /// \returns An iterator to the element following the erased ones.
+            /// \throws Anything thrown by the move assignment of \c T.
+            /// \requires The iterators must form a valid range of the array.
+            iterator erase(const_iterator pos)
+            {
+                return erase(pos, pos + 1);
+            }
+
+            iterator erase(const_iterator first, const_iterator last)
+            {
+                return storage::erase(first, last);
+            }
+            /// @}
+
+            /// \effects Destroys the last element.
+            /// \requires The array must not be empty.
+            void pop_back() noexcept
+            {
+                storage::pop_back();
+            }
+
+            /// \effects Destroys all elements.
+            /// The memory is not deallocated.
+            void clear() noexcept
+            {
+                storage::clear();
+            }
+
+            /// \effects Ensures that the array can hold at least \c new_capacity elements,
+            /// expanding the memory in place if possible.
+            /// \throws Anything thrown by the allocation or the move constructor of \c T.
+            void reserve(std::size_t new_capacity)
+            {
+                storage::reserve(new_capacity);
+            }
+
+            /// \effects Moves the elements back into the inline storage and deallocates the memory,
+            /// if they fit.
+            /// \throws Anything thrown by the move constructor of \c T.
+            void shrink_to_fit()
+            {
+                if (is_inline() || size_ > N)
+                    return;
+
+                auto memory = data_;
+                auto size   = size_;
+                data_       = this->inline_data();
+                size_       = 0u;
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+                try
+                {
+                    for (; size_ != size; ++size_)
+                        ::new (static_cast<void*>(data_ + size_))
+                            T(std::move_if_noexcept(memory[size_]));
+                }
+                catch (...)
+                {
+                    clear();
+                    data_ = memory;
+                    size_ = size;
+                    throw;
+                }
+#else
+                for (; size_ != size; ++size_)
+                    ::new (static_cast<void*>(data_ + size_)) T(detail::move(memory[size_]));
+#endif
+
+                for (std::size_t i = 0u; i != size; ++i)
+                    memory[i].~T();
+                allocator_ref::deallocate_array(memory, capacity_, sizeof(T), alignof(T));
+                capacity_ = N;
+            }
+
+            //=== accessors ===//
+            /// @{
+            /// \returns A reference to the element at the given index.
+            /// \requires \c i must be less than \ref size().
+            T& operator[](std::size_t i) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(i < size_);
+                return data_[i];
+            }
+
+            const T& operator[](std::size_t i) const noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(i < size_);
+                return data_[i];
+            }
+            /// @}
+
+            /// @{
+            /// \returns A pointer to the first element, either into the inline storage or into the memory of the allocator.
+            T* data() noexcept
+            {
+                return data_;
+            }
+
+            const T* data() const noexcept
+            {
+                return data_;
+            }
+            /// @}
+
+            /// @{
+            /// \returns An iterator to the first element or one past the last element.
+            iterator begin() noexcept
+            {
+                return data_;
+            }
+
+            const_iterator begin() const noexcept
+            {
+                return data_;
+            }
+
+            iterator end() noexcept
+            {
+                return data_ + size_;
+            }
+
+            const_iterator end() const noexcept
+            {
+                return data_ + size_;
+            }
+            /// @}
+
+            /// \returns The number of elements.
+            std::size_t size() const noexcept
+            {
+                return size_;
+            }
+
+            /// \returns Whether or not there are no elements.
+            bool empty() const noexcept
+            {
+                return size_ == 0u;
+            }
+
+            /// \returns The number of elements that fit into the array without growing it,
+            /// at least \c N.
+            std::size_t capacity() const noexcept
+            {
+                return capacity_;
+            }
+
+            /// \returns Whether or not the elements are stored inline, i.e. no memory is allocated.
+            bool is_inline() const noexcept
+            {
+                return storage::is_inline();
+            }
+
+            /// @{
+            /// \returns A reference to the allocator.
+            auto get_allocator() noexcept
+                -> decltype(std::declval<allocator_ref>().get_allocator())
+            {
+                return allocator_ref::get_allocator();
+            }
+
+            auto get_allocator() const noexcept
+                -> decltype(std::declval<const allocator_ref>().get_allocator())
+            {
+                return allocator_ref::get_allocator();
+            }
+            /// @}
+
+        private:
+            // requires that the array is empty and inline
+            void take(small_vector& other)
+            {
+                if (other.is_inline())
+                {
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+                    try
+                    {
+                        for (auto& element : other)
+                            construct_back(detail::move(element));
+                    }
+                    catch (...)
+                    {
+                        clear();
+                        throw;
+                    }
+#else
+                    for (auto& element : other)
+                        construct_back(detail::move(element));
+#endif
+                    other.clear();
+                }
+                else
+                {
+                    data_     = other.data_;
+                    size_     = other.size_;
+                    capacity_ = other.capacity_;
+
+                    other.data_     = other.inline_data();
+                    other.size_     = 0u;
+                    other.capacity_ = N;
+                }
+            }
+        };
+
+        template <typename T, std::size_t N, class RawAllocator>
+        constexpr std::size_t small_vector<T, N, RawAllocator>::inline_capacity;
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_SMALL_VECTOR_HPP_INCLUDED
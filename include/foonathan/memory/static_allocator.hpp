@@ -14,6 +14,7 @@
 #include "detail/memory_stack.hpp"
 #include "detail/utility.hpp"
 #include "config.hpp"
+#include "error.hpp"
 
 #if FOONATHAN_MEMORY_EXTERN_TEMPLATE
 #include "allocator_traits.hpp"
@@ -27,18 +28,25 @@ namespace foonathan
         /// Its constructor will take a reference to it and use it for its allocation.
         /// The storage type is simply a \c char array aligned for maximum alignment.
         /// \note It is not allowed to access the memory of the storage.
+        /// \note If \ref FOONATHAN_MEMORY_DEBUG_POISON is \c true, it is not trivially destructible:
+        /// its destructor unpoisons the memory, as the allocators using it might have left parts of it poisoned.
         /// \ingroup allocator
         template <std::size_t Size>
         struct static_allocator_storage
         {
             alignas(detail::max_alignment) char storage[Size];
+
+#if FOONATHAN_MEMORY_DEBUG_POISON
+            ~static_allocator_storage() noexcept
+            {
+                detail::debug_unpoison(storage, Size);
+            }
+#endif
         };
 
         static_assert(sizeof(static_allocator_storage<1024>) == 1024, "");
         static_assert(alignof(static_allocator_storage<1024>) == detail::max_alignment, "");
 
-        struct allocator_info;
-
         /// A stateful \concept{concept_rawallocator,RawAllocator} that uses a fixed sized storage for the allocations.
         /// It works on a \ref static_allocator_storage and uses its memory for all allocations.
         /// Deallocations are not supported, memory cannot be marked as freed.<br>
@@ -47,7 +55,8 @@ namespace foonathan
         class static_allocator
         {
         public:
-            using is_stateful = std::true_type;
+            using is_stateful          = std::true_type;
+            using is_deallocation_noop = std::true_type;
 
             /// \effects Creates it by passing it a \ref static_allocator_storage by reference.
             /// It will take the address of the storage and use its memory for the allocation.
@@ -94,8 +103,272 @@ namespace foonathan
         extern template class allocator_traits<static_allocator>;
 #endif
 
+        /// A stateful \concept{concept_rawallocator,RawAllocator} that bump-allocates from a storage of \c Size bytes inside the object itself.
+        /// Unlike \ref static_allocator it is header-only and keeps the top as an offset into the storage,
+        /// so the allocation functions inline completely
+        /// and the alignment and bounds computations fold into constants when the sizes are known at compile time.
+        /// Deallocations are not supported, all memory can be released at once with \ref unwind() or \ref reset().<br>
+        /// The layout of a sequence of allocations does not depend on the address of the object,
+        /// so it can be computed in constant expressions by \ref next_top(), e.g. to check the budget of an initialization table.
+        /// \note The object cannot be copied or moved, as that would invalidate the memory.
+        /// \ingroup allocator
+        template <std::size_t Size, std::size_t Alignment = detail::max_alignment>
+        class inline_stack
+        {
+            static_assert(detail::is_valid_alignment(Alignment), "invalid alignment");
+
+        public:
+            using is_stateful          = std::true_type;
+            using is_deallocation_noop = std::true_type;
+
+            /// The marker type that is used for unwinding.
+            using marker = FOONATHAN_IMPL_DEFINED(std::size_t);
+
+            /// \effects Creates it with an empty storage.
+            inline_stack() noexcept : top_(0u) {}
+
+            inline_stack(const inline_stack&)            = delete;
+            inline_stack& operator=(const inline_stack&) = delete;
+
+            /// \returns The top offset after an allocation of given size and alignment when the top is at \c top,
+            /// or a value greater than \ref capacity() if the allocation does not fit.
+            /// \requires \c alignment must be a valid alignment not greater than \c Alignment.
+            static constexpr std::size_t next_top(std::size_t top, std::size_t size,
+                                                  std::size_t alignment) noexcept
+            {
+                return (top + fence_size + alignment - 1u) / alignment * alignment + size
+                       + fence_size;
+            }
+
+            /// \effects A \concept{concept_rawallocator,RawAllocator} allocation function.
+            /// It bumps the top of the storage.
+            /// \returns A pointer to a \concept{concept_node,node}, it will never be \c nullptr.
+            /// \throws An exception of type \ref out_of_fixed_memory or whatever is thrown by its handler if the storage is exhausted.
+            /// \requires \c alignment must not be greater than \ref max_alignment().
+            void* allocate_node(std::size_t size, std::size_t alignment)
+            {
+                auto mem = try_allocate_node(size, alignment);
+                if (FOONATHAN_MEMORY_UNLIKELY(!mem))
+                    detail::throw_out_of_fixed_memory(info(), size);
+                return mem;
+            }
+
+            /// \effects Allocates a node similar to \ref allocate_node(),
+            /// but the size and alignment are template parameters.
+            /// If the node cannot fit into an empty storage, the program is ill-formed.
+            /// \returns A pointer to a \concept{concept_node,node}, it will never be \c nullptr.
+            /// \throws An exception of type \ref out_of_fixed_memory or whatever is thrown by its handler if the storage is exhausted.
+            template <std::size_t NodeSize, std::size_t NodeAlignment = detail::max_alignment>
+            void* allocate_node()
+            {
+                static_assert(NodeAlignment <= Alignment, "alignment exceeds alignment of storage");
+                static_assert(detail::is_valid_alignment(NodeAlignment), "invalid alignment");
+                static_assert(next_top(0u, NodeSize, NodeAlignment) <= Size,
+                              "node does not fit into the storage");
+                return allocate_node(NodeSize, NodeAlignment);
+            }
+
+            /// \effects Allocates a node similar to \ref allocate_node().
+            /// \returns A pointer to a \concept{concept_node,node} or \c nullptr if the storage is exhausted.
+            void* try_allocate_node(std::size_t size, std::size_t alignment) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(detail::is_valid_alignment(alignment)
+                                        && alignment <= Alignment);
+                // compares against the capacity left to avoid overflow for big sizes
+                auto begin = (top_ + fence_size + alignment - 1u) / alignment * alignment;
+                if (FOONATHAN_MEMORY_UNLIKELY(begin + fence_size > Size
+                                              || size > Size - begin - fence_size))
+                    return nullptr;
+
+                fill(top_, begin - fence_size - top_, debug_magic::alignment_memory);
+                fill(begin - fence_size, fence_size, debug_magic::fence_memory);
+                fill(begin, size, debug_magic::new_memory);
+                fill(begin + size, fence_size, debug_magic::fence_memory);
+                top_ = begin + size + fence_size;
+                return storage_ + begin;
+            }
+
+            /// \effects A \concept{concept_rawallocator,RawAllocator} deallocation function.
+            /// It does nothing, deallocation is only supported through \ref unwind().
+            void deallocate_node(void*, std::size_t, std::size_t) noexcept {}
+
+            /// \returns A marker to the current top of the storage.
+            marker top() const noexcept
+            {
+                return top_;
+            }
+
+            /// \effects Unwinds the storage to a marker position,
+            /// deallocating all memory allocated since the marker was obtained.
+            /// \requires The marker must have been obtained by \ref top() without unwinding to an older marker in the mean time.
+            void unwind(marker m) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(m <= top_);
+                fill(m, top_ - m, debug_magic::freed_memory);
+                top_ = m;
+            }
+
+            /// \effects Deallocates all memory, same as unwinding to the beginning of the storage.
+            void reset() noexcept
+            {
+                unwind(0u);
+            }
+
+            /// \returns The size of the storage, this is \c Size.
+            static constexpr std::size_t capacity() noexcept
+            {
+                return Size;
+            }
+
+            /// \returns The number of bytes remaining inside the storage.
+            std::size_t capacity_left() const noexcept
+            {
+                return Size - top_;
+            }
+
+            /// \returns The maximum node size which is \ref capacity_left().
+            std::size_t max_node_size() const noexcept
+            {
+                return capacity_left();
+            }
+
+            /// \returns The alignment of the storage, this is \c Alignment.
+            std::size_t max_alignment() const noexcept
+            {
+                return Alignment;
+            }
+
+        private:
+            static constexpr std::size_t fence_size = detail::debug_fence_size;
+
+            void fill(std::size_t offset, std::size_t size, debug_magic m) noexcept
+            {
+                detail::debug_fill(storage_ + offset, size, m);
+            }
+
+            allocator_info info() const noexcept
+            {
+                return {FOONATHAN_MEMORY_LOG_PREFIX "::inline_stack", this};
+            }
+
+            alignas(Alignment) char storage_[Size];
+            std::size_t top_;
+        };
+
+        template <std::size_t Size, std::size_t Alignment>
+        constexpr std::size_t inline_stack<Size, Alignment>::fence_size;
+
         struct memory_block;
 
+        /// A stateful \concept{concept_rawallocator,RawAllocator} that uses a fixed sized storage for allocations by multiple threads at once.
+        /// Like \ref static_allocator it bump-allocates from a \ref static_allocator_storage or any other fixed memory block,
+        /// e.g. a single block of \ref virtual_block_allocator,
+        /// but the top pointer is advanced with an atomic compare-and-swap,
+        /// so allocation is lock-free and it can be shared by multiple threads without a \ref thread_safe_allocator.
+        /// Deallocations are not supported, all memory can be released at once with \ref unwind(),
+        /// which must not be called concurrently with any allocation.
+        /// \note It is not allowed to share the memory between multiple allocator objects.
+        /// \ingroup allocator
+        class atomic_static_allocator
+        {
+        public:
+            using is_stateful          = std::true_type;
+            using is_deallocation_noop = std::true_type;
+
+            /// \effects Creates it by passing it a \ref static_allocator_storage by reference.
+            /// It will take the address of the storage and use its memory for the allocation.
+            /// \requires The storage object must live as long as the allocator object.
+            /// It must not be shared between multiple allocators,
+            /// i.e. the object must not have been passed to a constructor before.
+            template <std::size_t Size>
+            atomic_static_allocator(static_allocator_storage<Size>& storage) noexcept
+            : stack_(&storage), begin_(stack_.top()), end_(begin_ + Size)
+            {
+            }
+
+            /// \effects Creates it by passing it a memory block, e.g. one returned by a \concept{concept_blockallocator,BlockAllocator}.
+            /// \requires The memory block must be valid as long as the allocator object,
+            /// and must not be shared between multiple allocators.
+            explicit atomic_static_allocator(const memory_block& block) noexcept;
+
+            atomic_static_allocator(const atomic_static_allocator&)            = delete;
+            atomic_static_allocator& operator=(const atomic_static_allocator&) = delete;
+
+            /// \effects A \concept{concept_rawallocator,RawAllocator} allocation function.
+            /// It can be called by multiple threads at the same time.
+            /// \returns A pointer to a \concept{concept_node,node}, it will never be \c nullptr.
+            /// \throws An exception of type \ref out_of_fixed_memory or whatever is thrown by its handler if the storage is exhausted.
+            void* allocate_node(std::size_t size, std::size_t alignment);
+
+            /// \effects Allocates a node similar to \ref allocate_node().
+            /// \returns A pointer to a \concept{concept_node,node} or \c nullptr if the storage is exhausted.
+            void* try_allocate_node(std::size_t size, std::size_t alignment) noexcept
+            {
+                return stack_.allocate(end_, size, alignment);
+            }
+
+            /// \effects A \concept{concept_rawallocator,RawAllocator} deallocation function.
+            /// It does nothing, deallocation is only supported through \ref unwind().
+            void deallocate_node(void*, std::size_t, std::size_t) noexcept {}
+
+            /// The marker type that is used for unwinding.
+            using marker = FOONATHAN_IMPL_DEFINED(char*);
+
+            /// \returns A marker to the current top of the storage.
+            /// \note If other threads allocate at the same time, it may already be outdated.
+            marker top() const noexcept
+            {
+                return stack_.top();
+            }
+
+            /// \effects Unwinds the storage to a marker position,
+            /// deallocating all memory allocated since the marker was obtained.
+            /// \requires No other thread may allocate at the same time,
+            /// and the marker must have been obtained by \ref top() without unwinding to an older marker in the mean time.
+            void unwind(marker m) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(begin_ <= m && m <= stack_.top());
+                stack_.unwind(m);
+            }
+
+            /// \effects Deallocates all memory, same as unwinding to the beginning of the storage.
+            /// \requires No other thread may allocate at the same time.
+            void reset() noexcept
+            {
+                stack_.unwind(begin_);
+            }
+
+            /// \returns The number of bytes remaining inside the storage.
+            std::size_t capacity_left() const noexcept
+            {
+                return static_cast<std::size_t>(end_ - stack_.top());
+            }
+
+            /// \returns The maximum node size which is \ref capacity_left().
+            std::size_t max_node_size() const noexcept
+            {
+                return capacity_left();
+            }
+
+            /// \returns The maximum possible value since there is no alignment restriction
+            /// (except indirectly through the size of the storage).
+            std::size_t max_alignment() const noexcept
+            {
+                return std::size_t(-1);
+            }
+
+        private:
+            allocator_info info() const noexcept;
+
+            detail::atomic_fixed_memory_stack stack_;
+            char*                             begin_;
+            const char*                       end_;
+        };
+
+#if FOONATHAN_MEMORY_EXTERN_TEMPLATE
+        extern template class allocator_traits<atomic_static_allocator>;
+#endif
+
         /// A \concept{concept_blockallocator,BlockAllocator} that allocates the blocks from a fixed size storage.
         /// It works on a \ref static_allocator_storage and uses it for all allocations,
         /// deallocations are only allowed in reversed order which is guaranteed by \ref memory_arena.
@@ -0,0 +1,185 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_STATISTICS_TRACKER_HPP_INCLUDED
+#define FOONATHAN_MEMORY_STATISTICS_TRACKER_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::statistics_tracker and related classes.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+
+#include "config.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// The number of size classes in the histogram of \ref allocation_statistics_snapshot.
+        /// \ingroup adapter
+        constexpr std::size_t allocation_histogram_size = 32u;
+
+        /// The statistics of an allocator at a certain point in time as returned by \ref allocation_statistics::snapshot().
+        /// \ingroup adapter
+        struct allocation_statistics_snapshot
+        {
+            /// The number of node and array allocations and deallocations.
+            std::size_t allocations, deallocations;
+
+            /// The total number of bytes allocated and deallocated.
+            std::size_t bytes_allocated, bytes_deallocated;
+
+            /// The number of bytes currently allocated,
+            /// i.e. the difference of \c bytes_allocated and \c bytes_deallocated.
+            std::size_t live_bytes;
+
+            /// An approximation of the highest value of \c live_bytes so far.
+            /// It is never less than \c live_bytes but may lag behind the true peak
+            /// by up to \ref allocation_statistics::peak_granularity bytes per thread.
+            std::size_t peak_bytes;
+
+            /// The number of memory blocks allocated from and returned to the \concept{concept_blockallocator,BlockAllocator},
+            /// only counted by a \ref deeply_tracked_allocator.
+            std::size_t growths, shrinks;
+
+            /// The number of bytes in the blocks currently owned by the allocator,
+            /// only counted by a \ref deeply_tracked_allocator.
+            std::size_t block_bytes;
+
+            /// The number of allocations per size class:
+            /// element \c i counts the allocations of more than <tt>2^(i-1)</tt> and at most <tt>2^i</tt> bytes,
+            /// the last element all bigger ones as well.
+            std::size_t histogram[allocation_histogram_size];
+        };
+
+        /// \effects Writes the snapshot to a file in a line based text format:
+        /// a header line, then the name of each member and its value separated by a space,
+        /// and a line <tt>histogram i n</tt> for each size class \c i with \c n allocations.
+        /// The file can be read back with \ref read_statistics()
+        /// and is used by the \c pool_advisor tool to recommend the sizes of pools and stacks.
+        /// \returns Whether or not the write succeeded.
+        /// \ingroup adapter
+        bool write_statistics(std::FILE*                            file,
+                              const allocation_statistics_snapshot& snapshot) noexcept;
+
+        /// \effects Reads a snapshot written by \ref write_statistics() from a file.
+        /// Members that are missing in the file are set to zero.
+        /// \returns Whether or not the file contained a valid snapshot.
+        /// \ingroup adapter
+        bool read_statistics(std::FILE* file, allocation_statistics_snapshot& snapshot) noexcept;
+
+        /// Allocation statistics shared by one or more \ref statistics_tracker objects.
+        /// Each thread updates its own set of counters,
+        /// so recording an event is only a few uncontended atomic additions,
+        /// and \ref snapshot() adds them up while the allocators keep running.
+        /// \note The object must outlive all trackers referring to it.
+        /// \ingroup adapter
+        class allocation_statistics
+        {
+        public:
+            /// The number of bytes a thread can allocate before the peak is updated.
+            static constexpr std::size_t peak_granularity = 64u * 1024u;
+
+            /// \effects Creates it with all counters being zero.
+            allocation_statistics() noexcept;
+
+            allocation_statistics(const allocation_statistics&)            = delete;
+            allocation_statistics& operator=(const allocation_statistics&) = delete;
+
+            /// \effects Records an allocation of the given number of bytes.
+            void on_allocate(std::size_t size) noexcept;
+
+            /// \effects Records a deallocation of the given number of bytes.
+            void on_deallocate(std::size_t size) noexcept;
+
+            /// \effects Records that the allocator got a new memory block of given size.
+            void on_growth(std::size_t size) noexcept;
+
+            /// \effects Records that the allocator returned a memory block of given size.
+            void on_shrinking(std::size_t size) noexcept;
+
+            /// \returns The current statistics.
+            /// \note Events recorded by other threads at the same time may or may not be included,
+            /// and different counters may include different events.
+            allocation_statistics_snapshot snapshot() const noexcept;
+
+        private:
+            static constexpr std::size_t shard_count = 16u;
+
+            struct alignas(64) shard
+            {
+                std::atomic<std::size_t>    allocations, deallocations;
+                std::atomic<std::size_t>    bytes_allocated, bytes_deallocated;
+                std::atomic<std::size_t>    growths, shrinks;
+                std::atomic<std::size_t>    block_bytes_allocated, block_bytes_deallocated;
+                std::atomic<std::ptrdiff_t> unflushed_bytes;
+                std::atomic<std::size_t>    histogram[allocation_histogram_size];
+            };
+
+            void flush(shard& s) noexcept;
+
+            shard                       shards_[shard_count];
+            std::atomic<std::ptrdiff_t> live_bytes_;
+            std::atomic<std::size_t>    peak_bytes_;
+        };
+
+        /// A \concept{concept_tracker,deep tracker} that records allocation statistics in an \ref allocation_statistics object.
+        /// It is cheap enough to be used for hot allocators like a \ref memory_pool,
+        /// and multiple allocators can share the same statistics.
+        /// \ingroup adapter
+        class statistics_tracker
+        {
+        public:
+            /// \effects Creates it recording into the given statistics.
+            explicit statistics_tracker(allocation_statistics& statistics) noexcept
+            : statistics_(&statistics)
+            {
+            }
+
+            void on_node_allocation(void*, std::size_t size, std::size_t) noexcept
+            {
+                statistics_->on_allocate(size);
+            }
+
+            void on_array_allocation(void*, std::size_t count, std::size_t size,
+                                     std::size_t) noexcept
+            {
+                statistics_->on_allocate(count * size);
+            }
+
+            void on_node_deallocation(void*, std::size_t size, std::size_t) noexcept
+            {
+                statistics_->on_deallocate(size);
+            }
+
+            void on_array_deallocation(void*, std::size_t count, std::size_t size,
+                                       std::size_t) noexcept
+            {
+                statistics_->on_deallocate(count * size);
+            }
+
+            void on_allocator_growth(void*, std::size_t size) noexcept
+            {
+                statistics_->on_growth(size);
+            }
+
+            void on_allocator_shrinking(void*, std::size_t size) noexcept
+            {
+                statistics_->on_shrinking(size);
+            }
+
+            /// \returns A reference to the statistics.
+            allocation_statistics& get_statistics() const noexcept
+            {
+                return *statistics_;
+            }
+
+        private:
+            allocation_statistics* statistics_;
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_STATISTICS_TRACKER_HPP_INCLUDED
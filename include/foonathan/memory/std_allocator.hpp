@@ -196,6 +196,20 @@ namespace foonathan
                 return static_cast<pointer>(allocate_impl(is_any{}, n));
             }
 
+#if defined(__cpp_lib_allocate_at_least)
+            /// \effects Allocates memory like \ref allocate(),
+            /// but uses \c allocate_array_at_least() of the \ref allocator_traits if \c n is not \c 1,
+            /// so the memory can be bigger than requested.
+            /// \returns The memory and the number of objects of type \c T that fit into it,
+            /// which must be passed to \ref deallocate().
+            /// \throws Anything thrown by the \c RawAllocator.
+            /// \note This function is only available if the standard library supports \c std::allocation_result of C++23.
+            std::allocation_result<pointer, size_type> allocate_at_least(size_type n)
+            {
+                return allocate_at_least_impl(is_any{}, n);
+            }
+#endif
+
             /// \effects Deallcoates memory using the underlying \concept{concept_rawallocator,RawAllocator}.
             /// It will forward to the deallocation function in the same way as in \ref allocate().
             /// \requires The pointer must come from a previous call to \ref allocate() with the same \c n on this object or any copy of it.
@@ -254,6 +268,14 @@ namespace foonathan
                 return get_allocator().allocate_impl(n, sizeof(T), alignof(T));
             }
 
+#if defined(__cpp_lib_allocate_at_least)
+            std::allocation_result<pointer, size_type> allocate_at_least_impl(std::true_type,
+                                                                              size_type n)
+            {
+                return {allocate(n), n};
+            }
+#endif
+
             void deallocate_impl(std::true_type, void* ptr, size_type n)
             {
                 get_allocator().deallocate_impl(ptr, n, sizeof(T), alignof(T));
@@ -263,11 +285,23 @@ namespace foonathan
             void* allocate_impl(std::false_type, size_type n)
             {
                 if (n == 1)
-                    return this->allocate_node(sizeof(T), alignof(T));
+                    return this->template allocate_node<sizeof(T), alignof(T)>();
                 else
                     return this->allocate_array(n, sizeof(T), alignof(T));
             }
 
+#if defined(__cpp_lib_allocate_at_least)
+            std::allocation_result<pointer, size_type> allocate_at_least_impl(std::false_type,
+                                                                              size_type n)
+            {
+                if (n == 1)
+                    return {allocate(n), n};
+
+                auto result = this->allocate_array_at_least(n, sizeof(T), alignof(T));
+                return {static_cast<pointer>(result.memory), result.size};
+            }
+#endif
+
             void deallocate_impl(std::false_type, void* ptr, size_type n)
             {
                 if (n == 1)
@@ -0,0 +1,353 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_STRING_ARENA_HPP_INCLUDED
+#define FOONATHAN_MEMORY_STRING_ARENA_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::string_ref and class templates \ref foonathan::memory::string_arena
+/// and \ref foonathan::memory::string_interner.
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "detail/utility.hpp"
+#include "config.hpp"
+#include "default_allocator.hpp"
+#include "flat_hash_map.hpp"
+#include "memory_stack.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// A lightweight view of an immutable string, i.e. a pointer and a size.
+        /// The strings of a \ref string_arena are null-terminated, so \ref c_str() can be used for them.
+        /// \ingroup adapter
+        class string_ref
+        {
+        public:
+            /// \effects Creates a view of an empty string.
+            constexpr string_ref() noexcept : data_(""), size_(0u) {}
+
+            /// \effects Creates a view of the given characters.
+            constexpr string_ref(const char* data, std::size_t size) noexcept
+            : data_(data), size_(size)
+            {
+            }
+
+            /// \effects Creates a view of the null-terminated string.
+            string_ref(const char* str) noexcept : data_(str), size_(std::strlen(str)) {}
+
+            /// \effects Creates a view of the characters of the string.
+            string_ref(const std::string& str) noexcept : data_(str.data()), size_(str.size()) {}
+
+            /// \returns A pointer to the characters.
+            constexpr const char* data() const noexcept
+            {
+                return data_;
+            }
+
+            /// \returns A pointer to the characters.
+            /// \requires The string must be null-terminated, like all strings of a \ref string_arena.
+            constexpr const char* c_str() const noexcept
+            {
+                return data_;
+            }
+
+            /// \returns The number of characters.
+            constexpr std::size_t size() const noexcept
+            {
+                return size_;
+            }
+
+            /// \returns Whether or not the string is empty.
+            constexpr bool empty() const noexcept
+            {
+                return size_ == 0u;
+            }
+
+            /// \returns The character at the given index.
+            /// \requires \c i must be less than \ref size().
+            constexpr char operator[](std::size_t i) const noexcept
+            {
+                return data_[i];
+            }
+
+            /// \returns An iterator to the first character or one past the last character.
+            constexpr const char* begin() const noexcept
+            {
+                return data_;
+            }
+
+            constexpr const char* end() const noexcept
+            {
+                return data_ + size_;
+            }
+
+            /// \returns A copy of the characters.
+            std::string str() const
+            {
+                return std::string(data_, size_);
+            }
+
+            /// @{
+            /// \returns The result of comparing the characters of both strings.
+            friend bool operator==(string_ref a, string_ref b) noexcept
+            {
+                return a.size_ == b.size_
+                       && (a.data_ == b.data_ || std::memcmp(a.data_, b.data_, a.size_) == 0);
+            }
+
+            friend bool operator!=(string_ref a, string_ref b) noexcept
+            {
+                return !(a == b);
+            }
+
+            friend bool operator<(string_ref a, string_ref b) noexcept
+            {
+                auto size   = a.size_ < b.size_ ? a.size_ : b.size_;
+                auto result = size == 0u ? 0 : std::memcmp(a.data_, b.data_, size);
+                return result < 0 || (result == 0 && a.size_ < b.size_);
+            }
+            /// @}
+
+        private:
+            const char* data_;
+            std::size_t size_;
+        };
+
+        /// The hash function of \ref string_ref, FNV-1a of the characters.
+        /// \ingroup adapter
+        struct string_ref_hash
+        {
+            std::size_t operator()(string_ref str) const noexcept
+            {
+                std::uint64_t hash = 14695981039346656037ull;
+                for (auto c : str)
+                {
+                    hash ^= static_cast<unsigned char>(c);
+                    hash *= 1099511628211ull;
+                }
+                return static_cast<std::size_t>(hash);
+            }
+        };
+
+        /// A \ref memory_stack for immutable strings.
+        /// The characters of each string and a null terminator are copied contiguously into the blocks of the stack,
+        /// so there is no per-string allocation and no overhead beyond the terminator,
+        /// unlike a \c std::string with a heap allocation for every string longer than the small string buffer.
+        /// The strings are freed all at once by \ref unwind() or \ref clear().
+        /// \ingroup adapter
+        template <class BlockOrRawAllocator = default_allocator>
+        class string_arena
+        {
+        public:
+            using allocator_type = typename memory_stack<BlockOrRawAllocator>::allocator_type;
+            using marker         = typename memory_stack<BlockOrRawAllocator>::marker;
+
+            /// \effects Creates it by giving it the block size of the \ref memory_stack
+            /// and forwarding the other arguments to the \concept{concept_blockallocator,BlockAllocator}.
+            /// It allocates the first block.
+            template <typename... Args>
+            explicit string_arena(std::size_t block_size, Args&&... args)
+            : stack_(block_size, detail::forward<Args>(args)...), begin_(stack_.top())
+            {
+            }
+
+            /// \effects Copies the characters and a null terminator into the arena.
+            /// \returns A view of the copy that is valid until the arena is unwound before it.
+            /// \throws Anything thrown by the allocation of the \ref memory_stack,
+            /// in particular \ref bad_allocation_size if the string does not fit into the next memory block.
+            string_ref store(string_ref str)
+            {
+                auto memory = static_cast<char*>(stack_.allocate(str.size() + 1u, 1u));
+                if (!str.empty())
+                    std::memcpy(memory, str.data(), str.size());
+                memory[str.size()] = '\0';
+                return {memory, str.size()};
+            }
+
+            /// \returns A marker to the current top of the stack,
+            /// all strings stored after it are freed by unwinding to it.
+            marker top() const noexcept
+            {
+                return stack_.top();
+            }
+
+            /// \effects Frees all strings stored after the marker was obtained.
+            /// \requires The marker must be valid for the \ref memory_stack, see \ref memory_stack::unwind().
+            void unwind(marker m) noexcept
+            {
+                stack_.unwind(m);
+            }
+
+            /// \effects Frees all strings.
+            /// The memory blocks are kept for later use.
+            void clear() noexcept
+            {
+                stack_.unwind(begin_);
+            }
+
+            /// \effects Deallocates the memory blocks that are no longer in use.
+            void shrink_to_fit() noexcept
+            {
+                stack_.shrink_to_fit();
+            }
+
+            /// \returns The memory usage of the \ref memory_stack, see \ref memory_stack::stats().
+            memory_stats stats() const noexcept
+            {
+                return stack_.stats();
+            }
+
+            /// \returns A reference to the \ref memory_stack storing the strings.
+            /// \requires It must not be unwound below the strings that are still in use.
+            memory_stack<BlockOrRawAllocator>& get_stack() noexcept
+            {
+                return stack_;
+            }
+
+        private:
+            memory_stack<BlockOrRawAllocator> stack_;
+            marker                            begin_;
+        };
+
+        /// A \ref string_arena that stores each distinct string only once.
+        /// A hash table maps every string to its copy in the arena,
+        /// so interning a string again returns a view of the same characters,
+        /// and two interned strings are equal if and only if their \c data() pointers are equal.
+        /// The table is a \ref flat_hash_map allocated by the \concept{concept_rawallocator,RawAllocator},
+        /// its entries only point into the arena and are removed when the arena is unwound.
+        /// \note It is not thread-safe.
+        /// \ingroup adapter
+        template <class BlockOrRawAllocator = default_allocator,
+                  class RawAllocator        = default_allocator>
+        class string_interner
+        {
+            using table_type =
+                flat_hash_map<string_ref, std::size_t, RawAllocator, string_ref_hash>;
+
+        public:
+            /// The marker type used for unwinding.
+            class marker
+            {
+                typename string_arena<BlockOrRawAllocator>::marker arena_;
+                std::size_t                                        size_;
+
+                marker(typename string_arena<BlockOrRawAllocator>::marker arena,
+                       std::size_t                                        size) noexcept
+                : arena_(arena), size_(size)
+                {
+                }
+
+                friend string_interner;
+            };
+
+            /// \effects Creates it by giving it the block size of the \ref memory_stack of the \ref string_arena,
+            /// and the allocator of the table.
+            template <typename... Args>
+            explicit string_interner(std::size_t                       block_size,
+                                     allocator_reference<RawAllocator> alloc, Args&&... args)
+            : arena_(block_size, detail::forward<Args>(args)...), table_(detail::move(alloc))
+            {
+            }
+
+            /// \effects Creates it by giving it the block size of the \ref memory_stack of the \ref string_arena,
+            /// the table uses a default constructed \concept{concept_rawallocator,RawAllocator}.
+            explicit string_interner(std::size_t block_size)
+            : string_interner(block_size, RawAllocator())
+            {
+            }
+
+            /// \effects Copies the string into the arena unless an equal string was interned before.
+            /// \returns A view of the copy in the arena,
+            /// the same one for all equal strings until the arena is unwound before it.
+            /// \throws Anything thrown by the allocation of the \ref string_arena or of the table.
+            /// If an exception is thrown, the interner is unchanged.
+            string_ref intern(string_ref str)
+            {
+                auto result = table_.try_emplace(str, table_.size());
+                if (!result.second)
+                    return result.first->first;
+
+                // the entry refers to str until it is replaced with the copy
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+                try
+                {
+                    result.first->first = arena_.store(str);
+                }
+                catch (...)
+                {
+                    table_.erase(result.first);
+                    throw;
+                }
+#else
+                result.first->first = arena_.store(str);
+#endif
+                return result.first->first;
+            }
+
+            /// \returns The view of the interned string equal to \c str,
+            /// or a view with a \c nullptr as \c data() if there is none.
+            string_ref find(string_ref str) const
+            {
+                auto iter = table_.find(str);
+                return iter == table_.end() ? string_ref(nullptr, 0u) : iter->first;
+            }
+
+            /// \returns A marker to the current state,
+            /// all strings interned after it are freed and forgotten by unwinding to it.
+            marker top() const noexcept
+            {
+                return {arena_.top(), table_.size()};
+            }
+
+            /// \effects Frees and forgets all strings interned after the marker was obtained.
+            /// \throws Anything thrown by the allocation of the table, as it is rebuilt,
+            /// then nothing is freed.
+            /// \requires The marker must be valid, see \ref memory_stack::unwind().
+            void unwind(marker m)
+            {
+                if (m.size_ != table_.size())
+                {
+                    table_type table(table_.get_allocator());
+                    table.reserve(m.size_);
+                    for (auto& entry : table_)
+                        if (entry.second < m.size_)
+                            table.insert(entry);
+                    table_ = detail::move(table);
+                }
+                arena_.unwind(m.arena_);
+            }
+
+            /// \effects Frees and forgets all strings.
+            /// The memory blocks of the arena and the memory of the table are kept for later use.
+            void clear() noexcept
+            {
+                table_.clear();
+                arena_.clear();
+            }
+
+            /// \returns The number of distinct strings.
+            std::size_t size() const noexcept
+            {
+                return table_.size();
+            }
+
+            /// \returns A reference to the \ref string_arena storing the strings.
+            /// \requires It must not be unwound, as the table refers to its strings.
+            string_arena<BlockOrRawAllocator>& get_arena() noexcept
+            {
+                return arena_;
+            }
+
+        private:
+            string_arena<BlockOrRawAllocator> arena_;
+            table_type                        table_;
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_STRING_ARENA_HPP_INCLUDED
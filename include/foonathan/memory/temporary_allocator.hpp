@@ -7,6 +7,9 @@
 /// \file
 /// Class \ref foonathan::memory::temporary_allocator and related functions.
 
+#include <new>
+
+#include "detail/memory_stack.hpp"
 #include "config.hpp"
 #include "memory_stack.hpp"
 
@@ -57,15 +60,35 @@ namespace foonathan
             {
             public:
                 // doesn't add into list
-                temporary_stack_list_node() noexcept : in_use_(true) {}
+                temporary_stack_list_node() noexcept : in_use_(true), locked_(false) {}
 
                 temporary_stack_list_node(int) noexcept;
 
                 ~temporary_stack_list_node() noexcept {}
 
+            protected:
+                // held by the owning thread while a temporary_allocator is active
+                // and by trim_temporary_stacks() while it trims the stack
+                void lock() noexcept
+                {
+                    while (locked_.exchange(true, std::memory_order_acquire))
+                        ;
+                }
+
+                bool try_lock() noexcept
+                {
+                    return !locked_.exchange(true, std::memory_order_acquire);
+                }
+
+                void unlock() noexcept
+                {
+                    locked_.store(false, std::memory_order_release);
+                }
+
             private:
                 temporary_stack_list_node* next_ = nullptr;
                 std::atomic<bool>          in_use_;
+                std::atomic<bool>          locked_;
 
                 friend temporary_stack_list;
             };
@@ -85,6 +108,10 @@ namespace foonathan
                 temporary_stack_list_node(int) noexcept {}
 
                 ~temporary_stack_list_node() noexcept {}
+
+                void lock() noexcept {}
+
+                void unlock() noexcept {}
             };
 #endif
         } // namespace detail
@@ -124,6 +151,13 @@ namespace foonathan
             {
             }
 
+            /// \effects Makes the memory remaining in the current block of the internal `memory_stack` resident,
+            /// see \ref memory_stack::prefault().
+            void prefault() noexcept
+            {
+                stack_.prefault();
+            }
+
             /// \returns `next_capacity()` of the internal `memory_stack`.
             std::size_t next_capacity() const noexcept
             {
@@ -205,10 +239,98 @@ namespace foonathan
         /// \note If \ref FOONATHAN_MEMORY_TEMPORARY_STACK_MODE is equal to `1`,
         /// this function can create the temporary stack.
         /// But if there is no \ref temporary_stack_initializer, it won't be destroyed.
+        /// \note If \ref FOONATHAN_MEMORY_TEMPORARY_STACK_MODE is equal to `2`,
+        /// it adopts an unused stack of an exited thread or from \ref reserve_temporary_stacks(),
+        /// if there is one whose first block has at least the initial size.
         /// \relatesalso temporary_stack
         temporary_stack& get_temporary_stack(
             std::size_t initial_size = temporary_stack_initializer::default_stack_size);
 
+        /// \effects Binds a \ref temporary_stack to the calling thread as its current stack,
+        /// so that \ref get_current_temporary_stack() and thus the default constructor of \ref temporary_allocator use it
+        /// instead of the per-thread stack; \c nullptr unbinds it again.
+        /// A fiber or coroutine scheduler can own a stack per task and bind it whenever it resumes the task,
+        /// so that the task uses its own stack regardless of the thread it runs on
+        /// and the LIFO order of its \ref temporary_allocator objects is kept when it migrates.
+        /// \returns The previously bound stack or \c nullptr.
+        /// \note Binding is a single store to a thread-local variable, so it is cheap enough for every context switch.
+        /// \relatesalso temporary_stack
+        temporary_stack* bind_temporary_stack(temporary_stack* stack) noexcept;
+
+        /// The type of a function returning the \ref temporary_stack of the currently running task,
+        /// or \c nullptr to use the per-thread stack.
+        /// \relatesalso temporary_stack
+        using temporary_stack_provider = temporary_stack* (*)();
+
+        /// \effects Sets a function that is asked for the current stack by \ref get_current_temporary_stack()
+        /// if no stack is bound to the calling thread, \c nullptr removes it.
+        /// This is an alternative to \ref bind_temporary_stack() for schedulers that cannot run code when switching tasks,
+        /// but can look up the running task, e.g. through a fiber-local variable.
+        /// \returns The previous provider.
+        /// \note This function is thread-safe, the provider is used by all threads.
+        /// \relatesalso temporary_stack
+        temporary_stack_provider set_temporary_stack_provider(temporary_stack_provider p) noexcept;
+
+        /// \returns The \ref temporary_stack bound to the calling thread by \ref bind_temporary_stack(),
+        /// otherwise the one returned by the \ref temporary_stack_provider, if it returns one,
+        /// otherwise \ref get_temporary_stack() with the given initial size.
+        /// \requires If there is neither a bound nor a provided stack,
+        /// there must be a per-thread temporary stack (\ref FOONATHAN_MEMORY_TEMPORARY_STACK_MODE must not be equal to `0`).
+        /// \relatesalso temporary_stack
+        temporary_stack& get_current_temporary_stack(
+            std::size_t initial_size = temporary_stack_initializer::default_stack_size);
+
+        /// Binds a \ref temporary_stack to the calling thread for its lifetime using \ref bind_temporary_stack(),
+        /// the destructor restores the previously bound stack.
+        /// \relatesalso temporary_stack
+        class temporary_stack_binding
+        {
+        public:
+            /// \effects Binds the stack to the calling thread.
+            explicit temporary_stack_binding(temporary_stack& stack) noexcept
+            : prev_(bind_temporary_stack(&stack))
+            {
+            }
+
+            /// \effects Binds the previously bound stack again.
+            ~temporary_stack_binding() noexcept
+            {
+                bind_temporary_stack(prev_);
+            }
+
+            temporary_stack_binding(const temporary_stack_binding&)            = delete;
+            temporary_stack_binding& operator=(const temporary_stack_binding&) = delete;
+
+        private:
+            temporary_stack* prev_;
+        };
+
+        /// \effects Releases the unused memory blocks of the per-thread \ref temporary_stack of every thread
+        /// that does not have an active \ref temporary_allocator at the moment,
+        /// like \ref temporary_allocator::shrink_to_fit() would do in the thread itself.
+        /// Stacks that are currently in use are skipped,
+        /// so this can be called from a background thread without affecting the other threads.
+        /// \note This function only has an effect if \ref FOONATHAN_MEMORY_TEMPORARY_STACK_MODE is `2`,
+        /// as the stacks are not known otherwise.
+        /// \requires It must not be called during program termination,
+        /// after the per-thread stacks have been destroyed.
+        /// \relatesalso temporary_stack
+        void trim_temporary_stacks() noexcept;
+
+        /// \effects Creates \c count unused per-thread \ref temporary_stack objects with the given initial size,
+        /// so that threads started later adopt one of them instead of creating their own.
+        /// This allows a thread to start with a stack that is big enough without growing it first.
+        /// If \c prefault is \c true, the memory of the stacks is made resident as well,
+        /// so that the new threads do not take page faults on their first temporary allocations.
+        /// \throws Anything thrown by the allocation of the stacks.
+        /// \note The stack of an exiting thread is kept together with its memory blocks as well,
+        /// and adopted by the next new thread, unless it was released by a \ref temporary_stack_initializer.
+        /// Use \ref trim_temporary_stacks() to release the memory of unused stacks.
+        /// \note This function only has an effect if \ref FOONATHAN_MEMORY_TEMPORARY_STACK_MODE is `2`.
+        /// \relatesalso temporary_stack
+        void reserve_temporary_stacks(std::size_t count, std::size_t initial_size,
+                                      bool prefault = false);
+
         /// A stateful \concept{concept_rawallocator,RawAllocator} that handles temporary allocations.
         /// It works similar to \c alloca() but uses a seperate \ref memory_stack for the allocations,
         /// instead of the actual program stack.
@@ -219,8 +341,9 @@ namespace foonathan
         class temporary_allocator
         {
         public:
-            /// \effects Creates it by using the \ref get_temporary_stack() to get the temporary stack.
-            /// \requires There must be a per-thread temporary stack (\ref FOONATHAN_MEMORY_TEMPORARY_STACK_MODE must not be equal to `0`).
+            /// \effects Creates it by using the \ref get_current_temporary_stack() to get the temporary stack,
+            /// i.e. the per-thread stack unless a stack is bound to the thread or given by the \ref temporary_stack_provider.
+            /// \requires The requirements of \ref get_current_temporary_stack() must be fulfilled.
             temporary_allocator();
 
             /// \effects Creates it by giving it the \ref temporary_stack it uses for allocation.
@@ -236,6 +359,12 @@ namespace foonathan
             /// \requires `is_active()` must return `true`.
             void* allocate(std::size_t size, std::size_t alignment);
 
+            /// \effects Changes the size of the memory block returned by the last allocation in place
+            /// by forwarding to the internal \ref memory_stack.
+            /// \returns The result of \ref memory_stack::try_expand().
+            /// \requires `is_active()` must return `true`.
+            bool try_expand(void* memory, std::size_t old_size, std::size_t new_size) noexcept;
+
             /// \returns Whether or not the allocator object is active.
             /// \note The active allocator object is the last object created for one stack.
             /// Moving changes the active allocator.
@@ -256,6 +385,8 @@ namespace foonathan
             }
 
         private:
+            static temporary_stack& lock_stack(temporary_stack& stack) noexcept;
+
             memory_stack_raii_unwind<temporary_stack> unwind_;
             temporary_allocator*                      prev_;
             bool                                      shrink_to_fit_;
@@ -272,8 +403,9 @@ namespace foonathan
         class allocator_traits<temporary_allocator>
         {
         public:
-            using allocator_type = temporary_allocator;
-            using is_stateful    = std::true_type;
+            using allocator_type       = temporary_allocator;
+            using is_stateful          = std::true_type;
+            using is_deallocation_noop = std::true_type;
 
             /// \returns The result of \ref temporary_allocator::allocate().
             static void* allocate_node(allocator_type& state, std::size_t size,
@@ -308,6 +440,22 @@ namespace foonathan
             }
             /// @}
 
+            /// @{
+            /// \returns The result of \ref temporary_allocator::try_expand().
+            static bool try_expand_node(allocator_type& state, void* node, std::size_t old_size,
+                                        std::size_t new_size, std::size_t) noexcept
+            {
+                return state.try_expand(node, old_size, new_size);
+            }
+
+            static bool try_expand_array(allocator_type& state, void* array, std::size_t old_count,
+                                         std::size_t new_count, std::size_t size,
+                                         std::size_t) noexcept
+            {
+                return state.try_expand(array, old_count * size, new_count * size);
+            }
+            /// @}
+
             /// @{
             /// \returns The maximum size which is \ref memory_stack::next_capacity() of the internal stack.
             static std::size_t max_node_size(const allocator_type& state) noexcept
@@ -328,6 +476,125 @@ namespace foonathan
                 return std::size_t(-1);
             }
         };
+
+        /// A stateful \concept{concept_rawallocator,RawAllocator} for temporary allocations
+        /// that serves the first allocations out of a buffer of \c N bytes inside the object.
+        /// Only if that buffer is exhausted, it creates a \ref temporary_allocator on the per-thread \ref temporary_stack
+        /// and forwards the remaining allocations to it.
+        /// So as long as the allocations fit into the buffer, it does not access the per-thread stack at all.
+        /// All memory is freed when the object is destroyed.
+        /// \requires If the buffer is exhausted, there must be a per-thread temporary stack (\ref FOONATHAN_MEMORY_TEMPORARY_STACK_MODE must not be equal to `0`),
+        /// and all \ref temporary_allocator objects created after this one must have been destroyed already.
+        /// \ingroup allocator
+        template <std::size_t N>
+        class inline_temporary_allocator
+        {
+        public:
+            using is_stateful = std::true_type;
+
+            /// \effects Creates it without accessing the per-thread stack.
+            inline_temporary_allocator() noexcept : stack_(&buffer_), has_fallback_(false) {}
+
+            /// \effects Destroys the \ref temporary_allocator, if one was created.
+            ~inline_temporary_allocator() noexcept
+            {
+                if (has_fallback_)
+                    fallback().~temporary_allocator();
+            }
+
+            inline_temporary_allocator(inline_temporary_allocator&&)            = delete;
+            inline_temporary_allocator& operator=(inline_temporary_allocator&&) = delete;
+
+            /// @{
+            /// \effects Allocates memory from the buffer or, if there is not enough left,
+            /// from the \ref temporary_allocator.
+            /// \returns The allocated memory.
+            /// \throws Anything thrown by \ref temporary_allocator::allocate().
+            void* allocate_node(std::size_t size, std::size_t alignment)
+            {
+                if (auto memory = stack_.allocate(buffer_end(), size, alignment))
+                    return memory;
+                return get_fallback().allocate(size, alignment);
+            }
+
+            void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+            {
+                return allocate_node(count * size, alignment);
+            }
+            /// @}
+
+            /// @{
+            /// \effects Does nothing, the memory is freed when the object is destroyed.
+            void deallocate_node(void*, std::size_t, std::size_t) noexcept {}
+
+            void deallocate_array(void*, std::size_t, std::size_t, std::size_t) noexcept {}
+            /// @}
+
+            /// @{
+            /// \effects Changes the size of the memory returned by the last allocation in place,
+            /// either in the buffer or in the \ref temporary_allocator.
+            /// \returns Whether or not the size has been changed.
+            bool try_expand_node(void* node, std::size_t old_size, std::size_t new_size,
+                                 std::size_t) noexcept
+            {
+                if (is_inline(node))
+                    return stack_.try_resize(buffer_end(), node, old_size, new_size);
+                return has_fallback_ && fallback().try_expand(node, old_size, new_size);
+            }
+
+            bool try_expand_array(void* array, std::size_t old_count, std::size_t new_count,
+                                  std::size_t size, std::size_t alignment) noexcept
+            {
+                return try_expand_node(array, old_count * size, new_count * size, alignment);
+            }
+            /// @}
+
+            /// \returns Whether or not the buffer was exhausted and a \ref temporary_allocator has been created.
+            bool uses_fallback() const noexcept
+            {
+                return has_fallback_;
+            }
+
+            /// \returns The number of bytes left in the buffer.
+            /// \note Due to fences and alignment buffers, less memory may be usable.
+            std::size_t capacity_left() const noexcept
+            {
+                return std::size_t(buffer_end() - stack_.top());
+            }
+
+        private:
+            const char* buffer_end() const noexcept
+            {
+                return buffer_ + N;
+            }
+
+            bool is_inline(const void* memory) const noexcept
+            {
+                auto ptr = static_cast<const char*>(memory);
+                return buffer_ <= ptr && ptr < buffer_end();
+            }
+
+            temporary_allocator& fallback() noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(has_fallback_);
+                return *static_cast<temporary_allocator*>(static_cast<void*>(&fallback_storage_));
+            }
+
+            temporary_allocator& get_fallback()
+            {
+                if (!has_fallback_)
+                {
+                    ::new (static_cast<void*>(&fallback_storage_)) temporary_allocator();
+                    has_fallback_ = true;
+                }
+                return fallback();
+            }
+
+            alignas(detail::max_alignment) char buffer_[N];
+            detail::fixed_memory_stack stack_;
+            alignas(temporary_allocator) char fallback_storage_[sizeof(temporary_allocator)];
+            bool has_fallback_;
+        };
     } // namespace memory
 } // namespace foonathan
 
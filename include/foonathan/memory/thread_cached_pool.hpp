@@ -0,0 +1,476 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_THREAD_CACHED_POOL_HPP_INCLUDED
+#define FOONATHAN_MEMORY_THREAD_CACHED_POOL_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::thread_cached_pool and its \ref foonathan::memory::allocator_traits specialization.
+
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+
+#include "detail/assert.hpp"
+#include "detail/tracepoint.hpp"
+#include "config.hpp"
+#include "error.hpp"
+#include "memory_pool.hpp"
+#include "threading.hpp"
+
+#if !FOONATHAN_HOSTED_IMPLEMENTATION
+#error "thread_cached_pool requires a hosted implementation"
+#endif
+
+namespace foonathan
+{
+    namespace memory
+    {
+        namespace detail
+        {
+            // per-thread magazine of free nodes for one thread_cached_pool object
+            // the nodes are stored directly after the header
+            struct thread_cache
+            {
+                using flush_fn = void (*)(void* owner, thread_cache& cache) noexcept;
+
+                thread_cache*      next_in_thread; // list of caches of one thread
+                thread_cache*      next_global;    // list of all caches
+                std::atomic<void*> owner;          // nullptr if unused
+                flush_fn           flush;
+                std::size_t        count, capacity;
+                bool               adopt; // kept with its contents on thread exit
+
+                void** nodes() noexcept
+                {
+                    return reinterpret_cast<void**>(this + 1);
+                }
+            };
+
+            // returns the cache of the current thread for the given owner,
+            // creates or reuses one if necessary, returns nullptr if it could not be created
+            // the cache is flushed via the given function on thread exit,
+            // unless adopt is true: then it is orphaned with its contents in O(1)
+            // and the next thread asking for a cache of the owner adopts it
+            thread_cache* get_thread_cache(void* owner, std::size_t capacity,
+                                           thread_cache::flush_fn flush,
+                                           bool                   adopt = false) noexcept;
+
+            // detaches all caches of the given owner in all threads without flushing them
+            void release_thread_caches(void* owner) noexcept;
+
+            // flushes and detaches all caches of the given owner in all threads,
+            // the threads must not use them concurrently
+            void flush_thread_caches(void* owner) noexcept;
+
+            // flushes and detaches the orphaned caches of the given owner
+            // returns the number of flushed caches
+            std::size_t flush_orphaned_thread_caches(void* owner) noexcept;
+        } // namespace detail
+
+        /// A stateful \concept{concept_rawallocator,RawAllocator} that puts small per-thread caches
+        /// in front of a shared \ref memory_pool.
+        /// Each thread has a magazine of up to \c MagazineSize free \concept{concept_node,nodes}.
+        /// Allocation and deallocation only access the magazine of the calling thread without any locking.
+        /// Only if it is empty or full, half of the magazine will be refilled from or flushed to the shared pool,
+        /// which is protected by a \c Mutex.
+        /// This reduces the lock acquisitions to one per <tt>MagazineSize / 2</tt> operations,
+        /// making it suitable as replacement for a \ref thread_safe_allocator of a \ref memory_pool.
+        /// \note Nodes allocated on one thread can be deallocated on any other thread.
+        /// They will then be cached by the other thread.
+        /// \note If a thread exits, its magazine is not flushed node by node:
+        /// it is handed over in constant time to a global list of orphaned magazines,
+        /// and the next thread that uses the pool adopts it with its nodes.
+        /// Use \ref flush_orphaned_caches() to return the nodes of orphaned magazines to the shared pool instead,
+        /// e.g. if the pool is no longer used by new threads.
+        /// \ingroup allocator
+        template <typename PoolType = node_pool, class BlockOrRawAllocator = default_allocator,
+                  class Mutex = std::mutex, std::size_t MagazineSize = 64u>
+        class thread_cached_pool
+        {
+            static_assert(MagazineSize >= 2u, "magazine must be able to store at least two nodes");
+
+            using pool = memory_pool<PoolType, BlockOrRawAllocator>;
+
+        public:
+            using allocator_type = typename pool::allocator_type;
+            using pool_type      = PoolType;
+            using mutex          = Mutex;
+
+            static constexpr std::size_t min_node_size = pool::min_node_size;
+            static constexpr std::size_t magazine_size = MagazineSize;
+
+            /// \returns The minimum block size required for certain number of \concept{concept_node,node}.
+            /// \requires \c node_size must be a valid \concept{concept_node,node size}
+            /// and \c number_of_nodes must be a non-zero value.
+            static constexpr std::size_t min_block_size(std::size_t node_size,
+                                                        std::size_t number_of_nodes) noexcept
+            {
+                return pool::min_block_size(node_size, number_of_nodes);
+            }
+
+            /// \effects Creates it by creating the shared \ref memory_pool with the same arguments.
+            template <typename... Args>
+            thread_cached_pool(std::size_t node_size, std::size_t block_size, Args&&... args)
+            : pool_(node_size, block_size, detail::forward<Args>(args)...)
+            {
+            }
+
+            /// \effects Destroys the \ref thread_cached_pool and the shared \ref memory_pool.
+            /// All nodes in the thread caches are discarded as well.
+            /// \requires No other thread may use it anymore.
+            ~thread_cached_pool() noexcept
+            {
+                detail::release_thread_caches(this);
+            }
+
+            /// \note The thread caches point to the object, so it can neither be copied nor moved.
+            thread_cached_pool(const thread_cached_pool&) = delete;
+            thread_cached_pool& operator=(const thread_cached_pool&) = delete;
+
+            /// \effects Allocates a single \concept{concept_node,node} from the magazine of the calling thread.
+            /// If the magazine is empty, it will be refilled from the shared pool,
+            /// which may lead to a growth of the pool.
+            /// \returns A node of size \ref node_size() suitable aligned.
+            /// \throws Anything thrown by the shared \ref memory_pool.
+            void* allocate_node()
+            {
+                auto cache = get_cache();
+                if (!cache)
+                    FOONATHAN_THROW(out_of_memory(info(), sizeof(detail::thread_cache)
+                                                              + MagazineSize * sizeof(void*)));
+                else if (cache->count == 0u)
+                    refill(*cache);
+                FOONATHAN_MEMORY_ASSERT(cache->count != 0u);
+                return cache->nodes()[--cache->count];
+            }
+
+            /// \effects Allocates a single \concept{concept_node,node} similar to \ref allocate_node(),
+            /// but the shared pool will not grow.
+            /// \returns A suitable aligned node of size \ref node_size() or `nullptr`.
+            void* try_allocate_node() noexcept
+            {
+                auto cache = get_cache();
+                if (!cache)
+                {
+                    std::lock_guard<Mutex> lock(mutex_);
+                    return pool_.try_allocate_node();
+                }
+                else if (cache->count == 0u && !try_refill(*cache))
+                    return nullptr;
+                return cache->nodes()[--cache->count];
+            }
+
+            /// \effects Deallocates a single \concept{concept_node,node} by putting it into the magazine of the calling thread.
+            /// If the magazine is full, half of it will be returned to the shared pool.
+            /// \requires \c ptr must be a result from a previous call to \ref allocate_node() on the same object.
+            void deallocate_node(void* ptr) noexcept
+            {
+                auto cache = get_cache();
+                if (!cache)
+                {
+                    std::lock_guard<Mutex> lock(mutex_);
+                    pool_.deallocate_node(ptr);
+                    return;
+                }
+                else if (cache->count == cache->capacity)
+                    flush(*cache, cache->capacity / 2u);
+                cache->nodes()[cache->count++] = ptr;
+            }
+
+            /// \effects Deallocates a single \concept{concept_node,node} but it does not be a result of a previous call to \ref allocate_node().
+            /// \returns `true` if the node could be deallocated, `false` otherwise.
+            bool try_deallocate_node(void* ptr) noexcept
+            {
+                if (!owns(ptr))
+                    return false;
+                deallocate_node(ptr);
+                return true;
+            }
+
+            /// \effects Allocates an \concept{concept_array,array} of nodes from the shared pool directly,
+            /// arrays are not cached.
+            /// \returns An array of \c n nodes of size \ref node_size() suitable aligned.
+            /// \throws Anything thrown by \ref memory_pool::allocate_array().
+            void* allocate_array(std::size_t n)
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                return pool_.allocate_array(n);
+            }
+
+            /// \effects Allocates an \concept{concept_array,array} similar to \ref allocate_array(),
+            /// but the shared pool will not grow.
+            /// \returns An array of \c n nodes of size \ref node_size() suitable aligned or `nullptr`.
+            void* try_allocate_array(std::size_t n) noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                return pool_.try_allocate_array(n);
+            }
+
+            /// \effects Deallocates an \concept{concept_array,array} by returning it to the shared pool directly.
+            /// \requires \c ptr must be a result from a previous call to \ref allocate_array() with the same \c n on the same object.
+            void deallocate_array(void* ptr, std::size_t n) noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                pool_.deallocate_array(ptr, n);
+            }
+
+            /// \effects Deallocates an \concept{concept_array,array} but it does not be a result of a previous call to \ref allocate_array().
+            /// \returns `true` if the array could be deallocated, `false` otherwise.
+            bool try_deallocate_array(void* ptr, std::size_t n) noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                return pool_.try_deallocate_array(ptr, n);
+            }
+
+            /// \effects Returns all nodes cached by the calling thread to the shared pool.
+            void flush_thread_cache() noexcept
+            {
+                if (auto cache = get_cache())
+                    flush(*cache, cache->count);
+            }
+
+            /// \effects Returns the nodes in the magazines of exited threads that have not been adopted yet
+            /// to the shared pool.
+            /// \returns The number of magazines flushed.
+            std::size_t flush_orphaned_caches() noexcept
+            {
+                return detail::flush_orphaned_thread_caches(this);
+            }
+
+            /// \returns The size of each \concept{concept_node,node} in the pool.
+            std::size_t node_size() const noexcept
+            {
+                return pool_.node_size();
+            }
+
+            /// \returns The total amount of bytes remaining on the free list of the shared pool.
+            /// \note This does not include the nodes cached by the threads.
+            std::size_t capacity_left() noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                return pool_.capacity_left();
+            }
+
+            /// \returns The number of nodes currently cached by the calling thread.
+            std::size_t thread_cache_size() noexcept
+            {
+                auto cache = get_cache();
+                return cache ? cache->count : 0u;
+            }
+
+            /// \returns Whether or not `ptr` is in memory owned by the shared pool.
+            bool owns(const void* ptr) noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                return pool_.owns(ptr);
+            }
+
+        private:
+            allocator_info info() const noexcept
+            {
+                return {FOONATHAN_MEMORY_LOG_PREFIX "::thread_cached_pool", this};
+            }
+
+            detail::thread_cache* get_cache() noexcept
+            {
+                // one per thread and instantiation, the common case is a single object per thread
+                static thread_local detail::thread_cache* last = nullptr;
+                if (!last || last->owner.load(std::memory_order_relaxed) != this)
+                    last = detail::get_thread_cache(this, MagazineSize, &flush_all, true);
+                return last;
+            }
+
+            static std::size_t node_count(const thread_cached_pool& state, std::size_t count,
+                                          std::size_t size) noexcept
+            {
+                auto bytes = count * size;
+                return bytes / state.node_size() + (bytes % state.node_size() != 0u);
+            }
+
+            void refill(detail::thread_cache& cache)
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                cache.nodes()[cache.count++] = pool_.allocate_node();
+                refill_impl(cache);
+            }
+
+            bool try_refill(detail::thread_cache& cache) noexcept
+            {
+                std::lock_guard<Mutex> lock(mutex_);
+                refill_impl(cache);
+                return cache.count != 0u;
+            }
+
+            void refill_impl(detail::thread_cache& cache) noexcept
+            {
+                FOONATHAN_MEMORY_TRACE2(thread_cache_refill, this, cache.count);
+                while (cache.count < cache.capacity / 2u)
+                {
+                    auto node = pool_.try_allocate_node();
+                    if (!node)
+                        break;
+                    cache.nodes()[cache.count++] = node;
+                }
+            }
+
+            void flush(detail::thread_cache& cache, std::size_t n) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(n <= cache.count);
+                FOONATHAN_MEMORY_TRACE2(thread_cache_flush, this, n);
+                std::lock_guard<Mutex> lock(mutex_);
+                for (auto i = 0u; i != n; ++i)
+                    pool_.deallocate_node(cache.nodes()[--cache.count]);
+            }
+
+            static void flush_all(void* owner, detail::thread_cache& cache) noexcept
+            {
+                auto& self = *static_cast<thread_cached_pool*>(owner);
+                self.flush(cache, cache.count);
+            }
+
+            pool          pool_;
+            mutable Mutex mutex_;
+
+            friend allocator_traits<thread_cached_pool>;
+            friend composable_allocator_traits<thread_cached_pool>;
+        };
+
+        template <class PoolType, class BlockOrRawAllocator, class Mutex, std::size_t MagazineSize>
+        constexpr std::size_t
+            thread_cached_pool<PoolType, BlockOrRawAllocator, Mutex, MagazineSize>::min_node_size;
+
+        template <class PoolType, class BlockOrRawAllocator, class Mutex, std::size_t MagazineSize>
+        constexpr std::size_t
+            thread_cached_pool<PoolType, BlockOrRawAllocator, Mutex, MagazineSize>::magazine_size;
+
+        /// Specialization of the \ref allocator_traits for \ref thread_cached_pool classes.
+        /// \ingroup allocator
+        template <class PoolType, class BlockOrRawAllocator, class Mutex, std::size_t MagazineSize>
+        class allocator_traits<thread_cached_pool<PoolType, BlockOrRawAllocator, Mutex, MagazineSize>>
+        {
+        public:
+            using allocator_type =
+                thread_cached_pool<PoolType, BlockOrRawAllocator, Mutex, MagazineSize>;
+            using is_stateful = std::true_type;
+
+            /// \returns The result of \ref thread_cached_pool::allocate_node().
+            /// \throws Anything thrown by the pool allocation function
+            /// or a \ref bad_allocation_size exception.
+            static void* allocate_node(allocator_type& state, std::size_t size,
+                                       std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_node_size>(size, max_node_size(state),
+                                                             state.info());
+                detail::check_allocation_size<bad_alignment>(
+                    alignment, [&] { return max_alignment(state); }, state.info());
+                return state.allocate_node();
+            }
+
+            /// \effects Forwards to \ref thread_cached_pool::allocate_array().
+            /// \returns A \concept{concept_array,array} with specified properties.
+            /// \requires The \c PoolType has to support array allocations.
+            /// \throws Anything thrown by the pool allocation function.
+            static void* allocate_array(allocator_type& state, std::size_t count, std::size_t size,
+                                        std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_node_size>(size, max_node_size(state),
+                                                             state.info());
+                detail::check_allocation_size<bad_alignment>(
+                    alignment, [&] { return max_alignment(state); }, state.info());
+                return state.allocate_array(allocator_type::node_count(state, count, size));
+            }
+
+            /// \effects Just forwards to \ref thread_cached_pool::deallocate_node().
+            static void deallocate_node(allocator_type& state, void* node, std::size_t,
+                                        std::size_t) noexcept
+            {
+                state.deallocate_node(node);
+            }
+
+            /// \effects Forwards to \ref thread_cached_pool::deallocate_array().
+            static void deallocate_array(allocator_type& state, void* array, std::size_t count,
+                                         std::size_t size, std::size_t) noexcept
+            {
+                state.deallocate_array(array, allocator_type::node_count(state, count, size));
+            }
+
+            /// \returns The maximum size of each node which is \ref thread_cached_pool::node_size().
+            static std::size_t max_node_size(const allocator_type& state) noexcept
+            {
+                return state.node_size();
+            }
+
+            /// \returns An upper bound on the maximum array size which is \ref memory_pool::next_capacity().
+            static std::size_t max_array_size(const allocator_type& state) noexcept
+            {
+                std::lock_guard<Mutex> lock(state.mutex_);
+                return state.pool_.next_capacity();
+            }
+
+            /// \returns The maximum alignment of the shared \ref memory_pool.
+            static std::size_t max_alignment(const allocator_type& state) noexcept
+            {
+                return allocator_traits<typename allocator_type::pool>::max_alignment(state.pool_);
+            }
+        };
+
+        /// Specialization of the \ref composable_allocator_traits for \ref thread_cached_pool classes.
+        /// \ingroup allocator
+        template <class PoolType, class BlockOrRawAllocator, class Mutex, std::size_t MagazineSize>
+        class composable_allocator_traits<
+            thread_cached_pool<PoolType, BlockOrRawAllocator, Mutex, MagazineSize>>
+        {
+            using traits = allocator_traits<
+                thread_cached_pool<PoolType, BlockOrRawAllocator, Mutex, MagazineSize>>;
+
+        public:
+            using allocator_type =
+                thread_cached_pool<PoolType, BlockOrRawAllocator, Mutex, MagazineSize>;
+
+            /// \returns The result of \ref thread_cached_pool::try_allocate_node()
+            /// or `nullptr` if the allocation size was too big.
+            static void* try_allocate_node(allocator_type& state, std::size_t size,
+                                           std::size_t alignment) noexcept
+            {
+                if (size > traits::max_node_size(state) || alignment > traits::max_alignment(state))
+                    return nullptr;
+                return state.try_allocate_node();
+            }
+
+            /// \effects Forwards to \ref thread_cached_pool::try_allocate_array().
+            /// \returns A \concept{concept_array,array} with specified properties
+            /// or `nullptr` if it was unable to allocate.
+            static void* try_allocate_array(allocator_type& state, std::size_t count,
+                                            std::size_t size, std::size_t alignment) noexcept
+            {
+                if (size > traits::max_node_size(state) || alignment > traits::max_alignment(state))
+                    return nullptr;
+                return state.try_allocate_array(allocator_type::node_count(state, count, size));
+            }
+
+            /// \effects Just forwards to \ref thread_cached_pool::try_deallocate_node().
+            /// \returns Whether the deallocation was successful.
+            static bool try_deallocate_node(allocator_type& state, void* node, std::size_t size,
+                                            std::size_t alignment) noexcept
+            {
+                if (size > traits::max_node_size(state) || alignment > traits::max_alignment(state))
+                    return false;
+                return state.try_deallocate_node(node);
+            }
+
+            /// \effects Forwards to \ref thread_cached_pool::try_deallocate_array().
+            /// \returns Whether the deallocation was successful.
+            static bool try_deallocate_array(allocator_type& state, void* array, std::size_t count,
+                                             std::size_t size, std::size_t alignment) noexcept
+            {
+                if (size > traits::max_node_size(state) || alignment > traits::max_alignment(state))
+                    return false;
+                return state.try_deallocate_array(array,
+                                                  allocator_type::node_count(state, count, size));
+            }
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_THREAD_CACHED_POOL_HPP_INCLUDED
@@ -0,0 +1,128 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_THREAD_LOCAL_REFERENCE_HPP_INCLUDED
+#define FOONATHAN_MEMORY_THREAD_LOCAL_REFERENCE_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::thread_local_reference.
+
+#include <type_traits>
+
+#include "detail/assert.hpp"
+#include "allocator_traits.hpp"
+#include "config.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// A stateless \concept{concept_rawallocator,RawAllocator} that forwards to the allocator currently bound to the calling thread.
+        /// An allocator is bound for the lifetime of a \ref binding object,
+        /// bindings can be nested and the innermost one is used.
+        /// As it does not store anything, a \ref std_allocator using it is an empty type,
+        /// so containers using it do not need to store a pointer to the allocator,
+        /// e.g. each inner container of a `std::vector<std::list<T, std_allocator<T, thread_local_reference<A>>>>` is smaller by a pointer.
+        /// This is useful for allocators only used by a single thread,
+        /// like a \ref temporary_allocator or a \ref memory_pool per thread.
+        /// Different \c Tag types allow binding multiple allocators of the same type at the same time.
+        /// \requires Memory must be deallocated on the same thread with the same allocator bound as during the allocation.
+        /// \ingroup adapter
+        template <class RawAllocator, class Tag = void>
+        class thread_local_reference
+        {
+            using traits = allocator_traits<RawAllocator>;
+
+        public:
+            using allocator_type = typename traits::allocator_type;
+            using is_stateful    = std::false_type;
+
+            /// Binds an allocator to the thread that creates it.
+            /// It must be destroyed on the same thread.
+            class binding
+            {
+            public:
+                /// \effects Binds \c alloc to the calling thread, replacing the previous binding.
+                explicit binding(allocator_type& alloc) noexcept : previous_(current())
+                {
+                    current() = &alloc;
+                }
+
+                /// \effects Restores the previous binding.
+                ~binding() noexcept
+                {
+                    current() = previous_;
+                }
+
+                binding(const binding&)            = delete;
+                binding& operator=(const binding&) = delete;
+
+            private:
+                allocator_type* previous_;
+            };
+
+            /// \returns Whether or not an allocator is bound to the calling thread.
+            static bool is_bound() noexcept
+            {
+                return current() != nullptr;
+            }
+
+            /// \returns A reference to the allocator bound to the calling thread.
+            /// \requires \ref is_bound() must return `true`.
+            static allocator_type& get_allocator() noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT_MSG(current(), "no allocator bound to the thread");
+                return *current();
+            }
+
+            /// @{
+            /// \effects Forwards to the allocator bound to the calling thread.
+            /// \requires \ref is_bound() must return `true`.
+            void* allocate_node(std::size_t size, std::size_t alignment)
+            {
+                return traits::allocate_node(get_allocator(), size, alignment);
+            }
+
+            void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+            {
+                return traits::allocate_array(get_allocator(), count, size, alignment);
+            }
+
+            void deallocate_node(void* node, std::size_t size, std::size_t alignment) noexcept
+            {
+                traits::deallocate_node(get_allocator(), node, size, alignment);
+            }
+
+            void deallocate_array(void* array, std::size_t count, std::size_t size,
+                                  std::size_t alignment) noexcept
+            {
+                traits::deallocate_array(get_allocator(), array, count, size, alignment);
+            }
+
+            std::size_t max_node_size() const
+            {
+                return traits::max_node_size(get_allocator());
+            }
+
+            std::size_t max_array_size() const
+            {
+                return traits::max_array_size(get_allocator());
+            }
+
+            std::size_t max_alignment() const
+            {
+                return traits::max_alignment(get_allocator());
+            }
+            /// @}
+
+        private:
+            static allocator_type*& current() noexcept
+            {
+                static thread_local allocator_type* alloc = nullptr;
+                return alloc;
+            }
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_THREAD_LOCAL_REFERENCE_HPP_INCLUDED
@@ -7,6 +7,7 @@
 /// \file
 /// The mutex types.
 
+#include <atomic>
 #include <type_traits>
 
 #include "allocator_traits.hpp"
@@ -16,6 +17,10 @@
 #include <mutex>
 #endif
 
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#endif
+
 namespace foonathan
 {
     namespace memory
@@ -35,6 +40,122 @@ namespace foonathan
             void unlock() noexcept {}
         };
 
+        namespace detail
+        {
+            // hint to the CPU that this is a spin-wait loop
+            inline void spin_pause() noexcept
+            {
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+                _mm_pause();
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+                __builtin_ia32_pause();
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+                __asm__ __volatile__("yield");
+#endif
+            }
+
+            // spins with exponentially increasing number of pauses up to a limit
+            class spin_backoff
+            {
+            public:
+                static constexpr unsigned max_pauses = 64u;
+
+                spin_backoff() noexcept : pauses_(1u) {}
+
+                // returns false once the limit is reached
+                bool spin() noexcept
+                {
+                    for (auto i = 0u; i != pauses_; ++i)
+                        spin_pause();
+                    if (pauses_ == max_pauses)
+                        return false;
+                    pauses_ *= 2u;
+                    return true;
+                }
+
+            private:
+                unsigned pauses_;
+            };
+        } // namespace detail
+
+        /// A \c Mutex that busy-waits instead of blocking the thread.
+        /// Waiting threads only read the lock until it becomes free, pausing exponentially longer in between,
+        /// and it is padded to a cache line so that it does not share one with other data.
+        /// It is faster than \c std::mutex for the short critical sections of most allocators,
+        /// but wastes CPU time if the lock is held for long or there are more threads than cores.
+        /// \ingroup core
+        class alignas(64) spin_mutex
+        {
+        public:
+            spin_mutex() noexcept : locked_(false) {}
+
+            spin_mutex(const spin_mutex&)            = delete;
+            spin_mutex& operator=(const spin_mutex&) = delete;
+
+            void lock() noexcept
+            {
+                detail::spin_backoff backoff;
+                while (!try_lock())
+                    while (locked_.load(std::memory_order_relaxed))
+                        backoff.spin();
+            }
+
+            bool try_lock() noexcept
+            {
+                return !locked_.load(std::memory_order_relaxed)
+                       && !locked_.exchange(true, std::memory_order_acquire);
+            }
+
+            void unlock() noexcept
+            {
+                locked_.store(false, std::memory_order_release);
+            }
+
+        private:
+            std::atomic<bool> locked_;
+        };
+
+#if FOONATHAN_HOSTED_IMPLEMENTATION
+        /// A \c Mutex that spins for a short time before blocking the thread.
+        /// It first tries to acquire the lock with exponential backoff like a \ref spin_mutex,
+        /// and only if it is still locked then, it blocks on a \c std::mutex.
+        /// This avoids the cost of parking a thread for short critical sections,
+        /// without wasting CPU time for long ones.
+        /// \ingroup core
+        class adaptive_mutex
+        {
+        public:
+            adaptive_mutex() noexcept = default;
+
+            adaptive_mutex(const adaptive_mutex&)            = delete;
+            adaptive_mutex& operator=(const adaptive_mutex&) = delete;
+
+            void lock()
+            {
+                detail::spin_backoff backoff;
+                do
+                {
+                    if (mutex_.try_lock())
+                        return;
+                } while (backoff.spin());
+                mutex_.lock();
+            }
+
+            bool try_lock()
+            {
+                return mutex_.try_lock();
+            }
+
+            void unlock() noexcept
+            {
+                mutex_.unlock();
+            }
+
+        private:
+            std::mutex mutex_;
+        };
+#endif
+
         /// Specifies whether or not a \concept{concept_rawallocator,RawAllocator} is thread safe as-is.
         /// This allows to use \ref no_mutex as an optimization.
         /// Note that stateless allocators are implictly thread-safe.
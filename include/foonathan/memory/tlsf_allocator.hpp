@@ -0,0 +1,246 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_TLSF_ALLOCATOR_HPP_INCLUDED
+#define FOONATHAN_MEMORY_TLSF_ALLOCATOR_HPP_INCLUDED
+
+/// \file
+/// Class template \ref foonathan::memory::tlsf_allocator.
+
+#include <type_traits>
+
+#include "detail/debug_helpers.hpp"
+#include "detail/assert.hpp"
+#include "detail/tlsf.hpp"
+#include "config.hpp"
+#include "default_allocator.hpp"
+#include "error.hpp"
+#include "memory_arena.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// A stateful \concept{concept_rawallocator,RawAllocator} for nodes of any size with random lifetimes,
+        /// using the two-level segregated fit algorithm on the blocks of a \ref memory_arena.
+        /// The free memory is kept in lists of similar sizes:
+        /// \c FirstLevelCount lists for the powers of two of a size, each split linearly into <tt>2^SecondLevelLog2</tt> lists.
+        /// A bitmap per level finds the first non-empty list big enough for a node in constant time,
+        /// a bigger free block is split and the rest put back onto a list,
+        /// and a deallocated node is merged with the free blocks right before and after it, again in constant time.
+        /// Each node has a header of two pointers and its size is rounded up to a multiple of that,
+        /// a bigger \c SecondLevelLog2 gives a better fit but a bigger allocator object.<br>
+        /// Unlike \ref memory_pool it is not restricted to a single size, unlike \ref memory_stack it can deallocate in any order,
+        /// and unlike \ref heap_allocator its time is bounded, which makes it a good leaf of a \ref segregator
+        /// or the \ref fallback_allocator of pools.
+        /// \ingroup allocator
+        template <class BlockOrRawAllocator = default_allocator, std::size_t FirstLevelCount = 32,
+                  std::size_t SecondLevelLog2 = 4>
+        class tlsf_allocator
+        {
+            using free_list = detail::tlsf_free_list<FirstLevelCount, SecondLevelLog2>;
+
+        public:
+            using allocator_type = make_block_allocator_t<BlockOrRawAllocator>;
+            using is_stateful    = std::true_type;
+
+            /// \effects Creates it by giving it the initial block size for the arena
+            /// and other constructor arguments for the \concept{concept_blockallocator,BlockAllocator}.
+            /// It will allocate an initial memory block with the given size from the \concept{concept_blockallocator,BlockAllocator}.
+            template <typename... Args>
+            explicit tlsf_allocator(std::size_t block_size, Args&&... args)
+            : arena_(block_size, detail::forward<Args>(args)...)
+            {
+                allocate_block();
+            }
+
+            /// \effects Destroys it by returning all memory blocks to the \concept{concept_blockallocator,BlockAllocator}.
+            ~tlsf_allocator() noexcept
+            {
+#if FOONATHAN_MEMORY_DEBUG_LEAK_CHECK
+                auto leaked = list_.managed() - list_.capacity();
+                if (leaked != 0u)
+                    detail::debug_handle_memory_leak(info(), static_cast<std::ptrdiff_t>(leaked));
+#endif
+            }
+
+            /// @{
+            /// \effects Moving it transfers ownership over the blocks,
+            /// i.e. the moved from allocator is completely empty and the new one has all its memory.
+            tlsf_allocator(tlsf_allocator&& other) noexcept
+            : arena_(detail::move(other.arena_)), list_(detail::move(other.list_))
+            {
+            }
+
+            tlsf_allocator& operator=(tlsf_allocator&& other) noexcept
+            {
+                arena_ = detail::move(other.arena_);
+                list_  = detail::move(other.list_);
+                return *this;
+            }
+            /// @}
+
+            /// \effects A \concept{concept_rawallocator,RawAllocator} allocation function.
+            /// It takes a block from the first non-empty list big enough,
+            /// if there is none, a new memory block is allocated from the arena.
+            /// \returns A \concept{concept_node,node} of the given size and alignment.
+            /// \throws Anything thrown by the \concept{concept_blockallocator,BlockAllocator} if a growth is needed,
+            /// or \ref bad_node_size or \ref bad_alignment if the node does not fit into a new block.
+            void* allocate_node(std::size_t size, std::size_t alignment)
+            {
+                FOONATHAN_MEMORY_ASSERT(detail::is_valid_alignment(alignment));
+                detail::check_allocation_size<bad_node_size>(
+                    size, [&] { return max_node_size(); }, info());
+                detail::check_allocation_size<bad_alignment>(
+                    alignment, [&] { return max_alignment(); }, info());
+
+                auto node = list_.allocate(size);
+                if (FOONATHAN_MEMORY_UNLIKELY(!node))
+                {
+                    allocate_block();
+                    node = list_.allocate(size);
+                    FOONATHAN_MEMORY_ASSERT(node);
+                }
+                detail::debug_fill(node, size, debug_magic::new_memory);
+                return node;
+            }
+
+            /// \effects A \concept{concept_rawallocator,RawAllocator} allocation function for an \concept{concept_array,array},
+            /// it allocates a node for the whole array like \ref allocate_node().
+            /// \throws The same as \ref allocate_node() but \ref bad_array_size if the array does not fit into a new block.
+            void* allocate_array(std::size_t count, std::size_t size, std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_array_size>(
+                    count * size, [&] { return max_array_size(); }, info());
+                return allocate_node(count * size, alignment);
+            }
+
+            /// \effects A \concept{concept_rawallocator,RawAllocator} deallocation function.
+            /// It merges the node with the free blocks next to it.
+            void deallocate_node(void* node, std::size_t size, std::size_t) noexcept
+            {
+                detail::debug_check_pointer([&] { return arena_.owns(node); }, info(), node);
+                detail::debug_check_double_dealloc(
+                    [&] { return !free_list::header_of(node)->is_free(); }, info(), node);
+                detail::debug_fill(node, size, debug_magic::freed_memory);
+                list_.deallocate(node);
+            }
+
+            /// \effects A \concept{concept_rawallocator,RawAllocator} deallocation function for an \concept{concept_array,array}.
+            void deallocate_array(void* array, std::size_t count, std::size_t size,
+                                  std::size_t alignment) noexcept
+            {
+                deallocate_node(array, count * size, alignment);
+            }
+
+            /// \effects A \concept{concept_composableallocator,ComposableAllocator} allocation function.
+            /// \returns The same as \ref allocate_node() or \c nullptr if no free block is big enough,
+            /// it never allocates a new memory block.
+            void* try_allocate_node(std::size_t size, std::size_t alignment) noexcept
+            {
+                if (alignment > max_alignment())
+                    return nullptr;
+                auto node = list_.allocate(size);
+                if (node)
+                    detail::debug_fill(node, size, debug_magic::new_memory);
+                return node;
+            }
+
+            /// \effects A \concept{concept_composableallocator,ComposableAllocator} allocation function for an \concept{concept_array,array}.
+            /// \returns The same as \ref try_allocate_node() for the whole array.
+            void* try_allocate_array(std::size_t count, std::size_t size,
+                                     std::size_t alignment) noexcept
+            {
+                if (size != 0u && count > max_array_size() / size)
+                    return nullptr;
+                return try_allocate_node(count * size, alignment);
+            }
+
+            /// \effects A \concept{concept_composableallocator,ComposableAllocator} deallocation function.
+            /// \returns Whether or not the node is in a block of this allocator and thus deallocated.
+            bool try_deallocate_node(void* node, std::size_t size, std::size_t alignment) noexcept
+            {
+                if (!arena_.owns(node))
+                    return false;
+                deallocate_node(node, size, alignment);
+                return true;
+            }
+
+            /// \effects A \concept{concept_composableallocator,ComposableAllocator} deallocation function for an \concept{concept_array,array}.
+            /// \returns Whether or not the array is in a block of this allocator and thus deallocated.
+            bool try_deallocate_array(void* array, std::size_t count, std::size_t size,
+                                      std::size_t alignment) noexcept
+            {
+                return try_deallocate_node(array, count * size, alignment);
+            }
+
+            /// \returns The size of the biggest node that fits into the next memory block.
+            std::size_t max_node_size() const noexcept
+            {
+                return free_list::max_node_size(next_capacity());
+            }
+
+            /// \returns The biggest size of an \concept{concept_array,array}, the same as \ref max_node_size().
+            std::size_t max_array_size() const noexcept
+            {
+                return max_node_size();
+            }
+
+            /// \returns The maximum alignment, the one of the node headers.
+            std::size_t max_alignment() const noexcept
+            {
+                return free_list::granularity;
+            }
+
+            /// \returns The number of bytes in the free blocks, including their headers.
+            /// \note A node allocation may still lead to a growth if no single free block is big enough.
+            std::size_t capacity_left() const noexcept
+            {
+                return list_.capacity();
+            }
+
+            /// \returns The number of bytes in the free block of the next memory block after the arena grows.
+            /// \ref capacity_left() will increase by this amount.
+            std::size_t next_capacity() const noexcept
+            {
+                auto offset =
+                    detail::align_offset(detail::memory_block_stack::implementation_offset(),
+                                         free_list::granularity);
+                auto size   = arena_.next_block_size();
+                return size < offset ? 0u : free_list::usable_size(size - offset);
+            }
+
+            /// \returns A reference to the \concept{concept_blockallocator,BlockAllocator} used for managing the arena.
+            /// \requires It is undefined behavior to move this allocator out into another object.
+            allocator_type& get_allocator() noexcept
+            {
+                return arena_.get_allocator();
+            }
+
+            /// \returns If `ptr` is in memory owned by the underlying arena.
+            bool owns(const void* ptr) const noexcept
+            {
+                return arena_.owns(ptr);
+            }
+
+        private:
+            allocator_info info() const noexcept
+            {
+                return {FOONATHAN_MEMORY_LOG_PREFIX "::tlsf_allocator", this};
+            }
+
+            void allocate_block()
+            {
+                auto mem    = arena_.allocate_block();
+                auto offset = detail::align_offset(mem.memory, free_list::granularity);
+                FOONATHAN_MEMORY_ASSERT(offset < mem.size);
+                list_.insert(static_cast<char*>(mem.memory) + offset, mem.size - offset);
+            }
+
+            memory_arena<allocator_type, false> arena_;
+            free_list                           list_;
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_TLSF_ALLOCATOR_HPP_INCLUDED
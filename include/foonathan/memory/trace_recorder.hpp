@@ -0,0 +1,186 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_TRACE_RECORDER_HPP_INCLUDED
+#define FOONATHAN_MEMORY_TRACE_RECORDER_HPP_INCLUDED
+
+/// \file
+/// Class \ref foonathan::memory::trace_recorder and related classes.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#include "config.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// The kind of a \ref trace_event.
+        /// \ingroup adapter
+        enum class trace_event_kind : std::uint8_t
+        {
+            allocate_node,
+            allocate_array,
+            deallocate_node,
+            deallocate_array,
+            /// The \ref deeply_tracked_allocator allocated a block.
+            allocator_growth,
+            /// The \ref deeply_tracked_allocator deallocated a block.
+            allocator_shrinking,
+        };
+
+        /// A single event of an \ref allocation_trace.
+        /// It is written to the trace file as is, in the native byte order.
+        /// \ingroup adapter
+        struct trace_event
+        {
+            /// The time of the event in nanoseconds since the creation of the trace.
+            std::uint64_t timestamp;
+            /// The address of the memory, it identifies the matching allocation of a deallocation.
+            std::uint64_t address;
+            /// The node size, the size of the array elements or the size of the block.
+            std::uint64_t size;
+            /// The number of array elements, \c 1 for all other events.
+            std::uint32_t count;
+            /// The index of the thread in the order the threads recorded their first event.
+            std::uint16_t thread;
+            trace_event_kind kind;
+            /// The base-2 logarithm of the alignment.
+            std::uint8_t alignment_log2;
+
+            /// \returns The alignment of the event.
+            std::size_t alignment() const noexcept
+            {
+                return std::size_t(1u) << alignment_log2;
+            }
+        };
+
+        static_assert(sizeof(trace_event) == 32u, "trace_event must not contain padding");
+
+        /// A trace of allocation events that is filled by one or more \ref trace_recorder objects.
+        /// The events are either kept in memory or streamed to a file in a compact binary format:
+        /// the eight bytes of \ref file_magic followed by the \ref trace_event objects.
+        /// Such a file can be replayed against different allocators with the \c trace_replay tool.
+        /// \note Recording an event locks a mutex, so it serializes allocations of multiple threads.
+        /// \note The object must outlive all trackers referring to it.
+        /// \ingroup adapter
+        class allocation_trace
+        {
+        public:
+            /// The first eight bytes of a trace file.
+            static constexpr char file_magic[9] = "FMTRACE1";
+
+            /// The number of events buffered before they are written to the file.
+            static constexpr std::size_t buffer_size = 4096u;
+
+            /// \effects Creates a trace that keeps all events in memory.
+            allocation_trace();
+
+            /// \effects Creates a trace that writes the events to a file as soon as \ref buffer_size events are recorded,
+            /// the file header is written immediately.
+            /// \requires \c file must be opened in binary mode and stay open until the trace is destroyed.
+            explicit allocation_trace(std::FILE* file);
+
+            /// \effects Writes the remaining events to the file, if there is one.
+            ~allocation_trace() noexcept;
+
+            allocation_trace(const allocation_trace&)            = delete;
+            allocation_trace& operator=(const allocation_trace&) = delete;
+
+            /// \effects Records an event of the current thread.
+            /// If the memory for the event cannot be allocated, it is dropped.
+            void record(trace_event_kind kind, const void* memory, std::size_t size,
+                        std::size_t count, std::size_t alignment) noexcept;
+
+            /// \effects Writes the buffered events to the file, if there is one.
+            void flush() noexcept;
+
+            /// \effects Writes the file header and all events kept in memory to the given file.
+            /// \returns Whether or not the write succeeded.
+            /// \requires The trace must keep the events in memory.
+            bool write(std::FILE* file) const noexcept;
+
+            /// \effects Appends the events of a trace file to \c events.
+            /// \returns Whether or not the file is a complete trace file.
+            static bool read(std::FILE* file, std::vector<trace_event>& events);
+
+            /// \returns A copy of the events that are kept in memory,
+            /// or of the buffered events that are not yet written to the file.
+            std::vector<trace_event> events() const;
+
+            /// \returns The number of events recorded so far, including the dropped ones.
+            std::size_t size() const noexcept;
+
+            /// \returns Whether or not all events were recorded and written successfully.
+            bool good() const noexcept;
+
+        private:
+            void write_buffer() noexcept;
+
+            mutable std::mutex                    mutex_;
+            std::vector<trace_event>              buffer_;
+            std::chrono::steady_clock::time_point start_;
+            std::FILE*                            file_;
+            std::size_t                           size_;
+            bool                                  good_;
+        };
+
+        /// A \concept{concept_tracker,deep tracker} that records all events into an \ref allocation_trace.
+        /// \ingroup adapter
+        class trace_recorder
+        {
+        public:
+            /// \effects Creates it recording into the given trace.
+            explicit trace_recorder(allocation_trace& trace) noexcept : trace_(&trace) {}
+
+            void on_node_allocation(void* memory, std::size_t size, std::size_t alignment) noexcept
+            {
+                trace_->record(trace_event_kind::allocate_node, memory, size, 1u, alignment);
+            }
+
+            void on_array_allocation(void* memory, std::size_t count, std::size_t size,
+                                     std::size_t alignment) noexcept
+            {
+                trace_->record(trace_event_kind::allocate_array, memory, size, count, alignment);
+            }
+
+            void on_node_deallocation(void* memory, std::size_t size,
+                                      std::size_t alignment) noexcept
+            {
+                trace_->record(trace_event_kind::deallocate_node, memory, size, 1u, alignment);
+            }
+
+            void on_array_deallocation(void* memory, std::size_t count, std::size_t size,
+                                       std::size_t alignment) noexcept
+            {
+                trace_->record(trace_event_kind::deallocate_array, memory, size, count, alignment);
+            }
+
+            void on_allocator_growth(void* memory, std::size_t size) noexcept
+            {
+                trace_->record(trace_event_kind::allocator_growth, memory, size, 1u, 1u);
+            }
+
+            void on_allocator_shrinking(void* memory, std::size_t size) noexcept
+            {
+                trace_->record(trace_event_kind::allocator_shrinking, memory, size, 1u, 1u);
+            }
+
+            /// \returns A reference to the trace.
+            allocation_trace& get_trace() const noexcept
+            {
+                return *trace_;
+            }
+
+        private:
+            allocation_trace* trace_;
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_TRACE_RECORDER_HPP_INCLUDED
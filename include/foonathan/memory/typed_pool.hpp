@@ -0,0 +1,204 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_TYPED_POOL_HPP_INCLUDED
+#define FOONATHAN_MEMORY_TYPED_POOL_HPP_INCLUDED
+
+/// \file
+/// Class template \ref foonathan::memory::typed_pool and functions \ref foonathan::memory::pooled_new and \ref foonathan::memory::pooled_delete.
+
+#include <new>
+#include <type_traits>
+
+#include "detail/align.hpp"
+#include "detail/utility.hpp"
+#include "config.hpp"
+#include "error.hpp"
+#include "thread_cached_pool.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// A stateless \concept{concept_rawallocator,RawAllocator} that allocates objects of type \c T
+        /// from a global pool just for them.
+        /// The pool is a \ref thread_cached_pool with a \ref node_pool,
+        /// whose node size is fixed at compile time from the size and alignment of \c T.
+        /// It is created on first use and destroyed at exit after the magazines have been flushed,
+        /// so all its memory blocks are returned.
+        /// Objects deallocated during the destruction of other globals after that are ignored,
+        /// as their memory has already been released.
+        /// Use \ref pooled_new() and \ref pooled_delete() to create single objects,
+        /// or pass it to \ref allocate_unique() for a \c T.
+        /// \note Each \c BlockSize is a separate pool.
+        /// \ingroup allocator
+        template <typename T, std::size_t BlockSize = 64u * 1024u>
+        class typed_pool
+        {
+            static_assert(alignof(T) <= detail::max_alignment,
+                          "over-aligned types are not supported");
+
+        public:
+            using pool_type   = thread_cached_pool<node_pool>;
+            using is_stateful = std::false_type;
+
+            /// The size of the nodes, \c sizeof(T) rounded up for the free list and the alignment of \c T.
+            static constexpr std::size_t node_size =
+                ((sizeof(T) < pool_type::min_node_size ? pool_type::min_node_size : sizeof(T))
+                 + alignof(T) - 1u)
+                & ~(alignof(T) - 1u);
+
+            /// The size of the blocks of the pool.
+            static constexpr std::size_t block_size = BlockSize;
+
+            static_assert(block_size >= pool_type::min_block_size(node_size, 1u),
+                          "block size too small for a single node");
+
+            /// \returns The global pool for \c T, it is created on the first call.
+            /// \throws Anything thrown by the constructor of the pool on the first call.
+            static pool_type& get_pool()
+            {
+                static holder h;
+                return h.pool;
+            }
+
+            /// \effects Allocates a node for a \c T from the magazine of the calling thread of the global pool.
+            /// \returns The node.
+            /// \throws Anything thrown by \ref thread_cached_pool::allocate_node().
+            static void* allocate_node()
+            {
+                return get_pool().allocate_node();
+            }
+
+            /// \effects Deallocates a node for a \c T.
+            /// \requires \c ptr must have been returned by \ref allocate_node() for the same \c T.
+            static void deallocate_node(void* ptr) noexcept
+            {
+                if (FOONATHAN_MEMORY_LIKELY(alive()))
+                    get_pool().deallocate_node(ptr);
+            }
+
+            /// @{
+            /// \effects Allocates or deallocates a node as required by the \concept{concept_rawallocator,RawAllocator} concept.
+            /// \throws \ref bad_node_size or \ref bad_alignment if the memory does not fit into a node,
+            /// or anything thrown by \ref allocate_node().
+            void* allocate_node(std::size_t size, std::size_t alignment)
+            {
+                detail::check_allocation_size<bad_node_size>(size, node_size, info());
+                detail::check_allocation_size<bad_alignment>(alignment, max_alignment(), info());
+                return allocate_node();
+            }
+
+            void deallocate_node(void* ptr, std::size_t, std::size_t) noexcept
+            {
+                deallocate_node(ptr);
+            }
+            /// @}
+
+            /// @{
+            /// \returns The size and alignment of the nodes.
+            std::size_t max_node_size() const noexcept
+            {
+                return node_size;
+            }
+
+            std::size_t max_alignment() const noexcept
+            {
+                return alignof(T);
+            }
+            /// @}
+
+        private:
+            // destroyed after all globals constructed before the first use of the pool
+            struct holder
+            {
+                holder() : pool(node_size, block_size)
+                {
+                    alive() = true;
+                }
+
+                ~holder() noexcept
+                {
+                    alive() = false;
+                    // the magazine of the main thread is already orphaned at this point
+                    pool.flush_orphaned_caches();
+                    pool.flush_thread_cache();
+                }
+
+                pool_type pool;
+            };
+
+            // constant initialized, so it can still be read after the holder has been destroyed
+            static bool& alive() noexcept
+            {
+                static bool value = false;
+                return value;
+            }
+
+            allocator_info info() const noexcept
+            {
+                return {FOONATHAN_MEMORY_LOG_PREFIX "::typed_pool", this};
+            }
+        };
+
+        template <typename T, std::size_t BlockSize>
+        constexpr std::size_t typed_pool<T, BlockSize>::node_size;
+
+        template <typename T, std::size_t BlockSize>
+        constexpr std::size_t typed_pool<T, BlockSize>::block_size;
+
+        /// \effects Creates a \c T in a node of its \ref typed_pool by forwarding the arguments to its constructor.
+        /// \returns A pointer to the new object, it must be destroyed with \ref pooled_delete().
+        /// \throws Anything thrown by the allocation or the constructor of \c T,
+        /// in the latter case the node is deallocated again.
+        /// \ingroup allocator
+        template <typename T, typename... Args>
+        T* pooled_new(Args&&... args)
+        {
+            using pool  = typed_pool<typename std::remove_cv<T>::type>;
+            auto memory = pool::allocate_node();
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+            try
+            {
+                return ::new (memory) T(detail::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                pool::deallocate_node(memory);
+                throw;
+            }
+#else
+            return ::new (memory) T(detail::forward<Args>(args)...);
+#endif
+        }
+
+        /// \effects Destroys an object created by \ref pooled_new() and deallocates its node,
+        /// does nothing for \c nullptr.
+        /// \requires \c T must be the same type the object was created with, not a base class.
+        /// \ingroup allocator
+        template <typename T>
+        void pooled_delete(T* ptr) noexcept
+        {
+            if (ptr)
+            {
+                ptr->~T();
+                typed_pool<typename std::remove_cv<T>::type>::deallocate_node(
+                    const_cast<typename std::remove_cv<T>::type*>(ptr));
+            }
+        }
+
+        /// A deleter that calls \ref pooled_delete(), e.g. for a \c std::unique_ptr owning an object created by \ref pooled_new().
+        /// \ingroup allocator
+        template <typename T>
+        struct pooled_deleter
+        {
+            /// \effects Calls \ref pooled_delete().
+            void operator()(T* ptr) const noexcept
+            {
+                pooled_delete(ptr);
+            }
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_TYPED_POOL_HPP_INCLUDED
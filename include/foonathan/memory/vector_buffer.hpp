@@ -0,0 +1,450 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_VECTOR_BUFFER_HPP_INCLUDED
+#define FOONATHAN_MEMORY_VECTOR_BUFFER_HPP_INCLUDED
+
+/// \file
+/// Class template \ref foonathan::memory::vector_buffer.
+
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "detail/assert.hpp"
+#include "detail/utility.hpp"
+#include "allocator_storage.hpp"
+#include "config.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        namespace detail
+        {
+            template <typename T, std::size_t N>
+            class inline_vector_storage
+            {
+            protected:
+                T* inline_data() noexcept
+                {
+                    return reinterpret_cast<T*>(&storage_);
+                }
+
+                const T* inline_data() const noexcept
+                {
+                    return reinterpret_cast<const T*>(&storage_);
+                }
+
+            private:
+                typename std::aligned_storage<N * sizeof(T), alignof(T)>::type storage_;
+            };
+
+            template <typename T>
+            class inline_vector_storage<T, 0u>
+            {
+            protected:
+                T* inline_data() const noexcept
+                {
+                    return nullptr;
+                }
+            };
+
+            // the elements of vector_buffer and small_vector
+            // up to N elements are stored inline, memory is only allocated if !is_inline()
+            // without inline storage the inline data is nullptr
+            template <typename T, std::size_t N, class RawAllocator>
+            class vector_storage : FOONATHAN_EBO(protected allocator_reference<RawAllocator>),
+                                   protected inline_vector_storage<T, N>
+            {
+            protected:
+                using allocator_ref = allocator_reference<RawAllocator>;
+
+                explicit vector_storage(allocator_ref alloc) noexcept
+                : allocator_ref(detail::move(alloc)),
+                  data_(this->inline_data()),
+                  size_(0u),
+                  capacity_(N)
+                {
+                }
+
+                ~vector_storage() noexcept
+                {
+                    clear();
+                    deallocate();
+                }
+
+                vector_storage(const vector_storage&)            = delete;
+                vector_storage& operator=(const vector_storage&) = delete;
+
+                bool is_inline() const noexcept
+                {
+                    return data_ == this->inline_data();
+                }
+
+                template <typename... Args>
+                T& emplace_back(Args&&... args)
+                {
+                    if (size_ == capacity_)
+                    {
+                        // the arguments may refer to an element that is moved by the growth
+                        T value(detail::forward<Args>(args)...);
+                        grow(size_ + 1u);
+                        return construct_back(detail::move(value));
+                    }
+                    return construct_back(detail::forward<Args>(args)...);
+                }
+
+                template <typename... Args>
+                T* emplace(const T* pos, Args&&... args)
+                {
+                    auto index = std::size_t(pos - data_);
+                    FOONATHAN_MEMORY_ASSERT(index <= size_);
+                    if (index == size_)
+                        return &emplace_back(detail::forward<Args>(args)...);
+
+                    // the arguments may refer to an element that is moved
+                    T value(detail::forward<Args>(args)...);
+                    if (size_ == capacity_)
+                        grow(size_ + 1u);
+                    construct_back(detail::move(data_[size_ - 1u]));
+                    std::move_backward(data_ + index, data_ + size_ - 2u, data_ + size_ - 1u);
+                    data_[index] = detail::move(value);
+                    return data_ + index;
+                }
+
+                T* erase(const T* first, const T* last)
+                {
+                    FOONATHAN_MEMORY_ASSERT(data_ <= first && first <= last
+                                            && last <= data_ + size_);
+                    auto begin   = data_ + (first - data_);
+                    auto new_end = std::move(data_ + (last - data_), data_ + size_, begin);
+                    while (data_ + size_ != new_end)
+                        pop_back();
+                    return begin;
+                }
+
+                void pop_back() noexcept
+                {
+                    FOONATHAN_MEMORY_ASSERT(size_ != 0u);
+                    data_[--size_].~T();
+                }
+
+                void clear() noexcept
+                {
+                    while (size_ != 0u)
+                        data_[--size_].~T();
+                }
+
+                void reserve(std::size_t new_capacity)
+                {
+                    if (new_capacity > capacity_)
+                        reallocate(new_capacity);
+                }
+
+                template <typename... Args>
+                T& construct_back(Args&&... args)
+                {
+                    auto ptr =
+                        ::new (static_cast<void*>(data_ + size_)) T(detail::forward<Args>(args)...);
+                    ++size_;
+                    return *ptr;
+                }
+
+                void deallocate() noexcept
+                {
+                    if (!is_inline())
+                        allocator_ref::deallocate_array(data_, capacity_, sizeof(T), alignof(T));
+                }
+
+                T*          data_;
+                std::size_t size_, capacity_;
+
+            private:
+                void grow(std::size_t min_capacity)
+                {
+                    // without inline storage, the first allocation has room for a few elements
+                    auto new_capacity = N == 0u && capacity_ < 4u ? 4u : 2u * capacity_;
+                    reallocate(new_capacity < min_capacity ? min_capacity : new_capacity);
+                }
+
+                void reallocate(std::size_t new_capacity)
+                {
+                    if (!is_inline()
+                        && allocator_ref::try_expand_array(data_, capacity_, new_capacity,
+                                                           sizeof(T), alignof(T)))
+                    {
+                        capacity_ = new_capacity;
+                        return;
+                    }
+
+                    auto result =
+                        allocator_ref::allocate_array_at_least(new_capacity, sizeof(T), alignof(T));
+                    auto new_data = static_cast<T*>(result.memory);
+                    new_capacity  = result.size;
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+                    std::size_t i = 0u;
+                    try
+                    {
+                        for (; i != size_; ++i)
+                            ::new (static_cast<void*>(new_data + i))
+                                T(std::move_if_noexcept(data_[i]));
+                    }
+                    catch (...)
+                    {
+                        while (i != 0u)
+                            new_data[--i].~T();
+                        allocator_ref::deallocate_array(new_data, new_capacity, sizeof(T),
+                                                        alignof(T));
+                        throw;
+                    }
+#else
+                    for (std::size_t i = 0u; i != size_; ++i)
+                        ::new (static_cast<void*>(new_data + i)) T(detail::move(data_[i]));
+#endif
+
+                    auto size = size_;
+                    clear();
+                    deallocate();
+
+                    data_     = new_data;
+                    size_     = size;
+                    capacity_ = new_capacity;
+                }
+            };
+        } // namespace detail
+
+        /// A simple growable array of \c T that takes its memory from a \concept{concept_rawallocator,RawAllocator}.
+        /// Unlike \c std::vector, it first asks the allocator to expand the buffer in place via \c try_expand_array() of the \ref allocator_traits
+        /// before it allocates a new buffer, moves the elements and deallocates the old one.
+        /// With an allocator like \ref memory_stack, \ref iteration_allocator or \ref temporary_allocator,
+        /// a buffer that was the last allocation thus grows without copying,
+        /// and if it has to be moved, deallocating the old buffer does nothing.
+        /// New memory is allocated with \c allocate_array_at_least(), so any slack of the allocator is used as capacity.
+        /// \note Other allocations from the same allocator made in between prevent the growth in place.
+        /// \ingroup adapter
+        template <typename T, class RawAllocator>
+        class vector_buffer : detail::vector_storage<T, 0u, RawAllocator>
+        {
+            using storage       = detail::vector_storage<T, 0u, RawAllocator>;
+            using allocator_ref = typename storage::allocator_ref;
+            using storage::data_;
+            using storage::size_;
+            using storage::capacity_;
+
+        public:
+            using value_type     = T;
+            using allocator_type = typename allocator_ref::allocator_type;
+            using iterator       = T*;
+            using const_iterator = const T*;
+
+            //=== constructors/destructor ===//
+            /// \effects Creates an empty buffer that will use the given allocator.
+            /// It does not allocate any memory.
+            explicit vector_buffer(allocator_ref alloc) noexcept : storage(detail::move(alloc)) {}
+
+            /// \effects Move constructs the buffer by taking over the memory of \c other,
+            /// which will be empty afterwards.
+            vector_buffer(vector_buffer&& other) noexcept
+            : storage(detail::move(static_cast<allocator_ref&>(other)))
+            {
+                data_     = other.data_;
+                size_     = other.size_;
+                capacity_ = other.capacity_;
+
+                other.data_     = nullptr;
+                other.size_     = 0u;
+                other.capacity_ = 0u;
+            }
+
+            /// \effects Destroys all elements and deallocates the memory.
+            ~vector_buffer() noexcept = default;
+
+            /// \effects Move assigns the buffer by taking over the memory of \c other,
+            /// which will be empty afterwards.
+            vector_buffer& operator=(vector_buffer&& other) noexcept
+            {
+                vector_buffer tmp(detail::move(other));
+                swap(*this, tmp);
+                return *this;
+            }
+
+            vector_buffer(const vector_buffer&)            = delete;
+            vector_buffer& operator=(const vector_buffer&) = delete;
+
+            /// \effects Swaps the elements and the allocators of both buffers.
+            friend void swap(vector_buffer& a, vector_buffer& b) noexcept
+            {
+                detail::adl_swap(static_cast<allocator_ref&>(a), static_cast<allocator_ref&>(b));
+                detail::adl_swap(a.data_, b.data_);
+                detail::adl_swap(a.size_, b.size_);
+                detail::adl_swap(a.capacity_, b.capacity_);
+            }
+
+            //=== modifiers ===//
+            /// \effects Creates a new element at the end by forwarding the arguments to its constructor,
+            /// growing the buffer if necessary.
+            /// \returns A reference to the new element.
+            /// \throws Anything thrown by the allocation or the constructor of \c T.
+            /// If an exception is thrown, the buffer is unchanged.
+            template <typename... Args>
+            T& emplace_back(Args&&... args)
+            {
+                return storage::emplace_back(detail::forward<Args>(args)...);
+            }
+
+            /// @{
+            /// \effects Same as `emplace_back(value)`.
+            void push_back(const T& value)
+            {
+                emplace_back(value);
+            }
+
+            void push_back(T&& value)
+            {
+                emplace_back(detail::move(value));
+            }
+            /// @}
+
+            /// \effects Creates a new element before \c pos by forwarding the arguments to its constructor,
+            /// growing the buffer if necessary, the following elements are moved back by one.
+            /// \returns An iterator to the new element.
+            /// \throws Anything thrown by the allocation or the constructor or move operations of \c T.
+            /// If an exception is thrown before the last element was moved back, the buffer is unchanged.
+            /// \requires \c pos must be an iterator into the buffer or \ref end().
+            template <typename... Args>
+            iterator emplace(const_iterator pos, Args&&... args)
+            {
+                return storage::emplace(pos, detail::forward<Args>(args)...);
+            }
+
+            /// @{
+            /// \effects Destroys the element or the elements in the range,
+            /// the following elements are moved forward.
+            /// \returns An iterator to the element following the erased ones.
+            /// \throws Anything thrown by the move assignment of \c T.
+            /// \requires The iterators must form a valid range of the buffer.
+            iterator erase(const_iterator pos)
+            {
+                return erase(pos, pos + 1);
+            }
+
+            iterator erase(const_iterator first, const_iterator last)
+            {
+                return storage::erase(first, last);
+            }
+            /// @}
+
+            /// \effects Destroys the last element.
+            /// \requires The buffer must not be empty.
+            void pop_back() noexcept
+            {
+                storage::pop_back();
+            }
+
+            /// \effects Destroys all elements.
+            /// The memory is not deallocated.
+            void clear() noexcept
+            {
+                storage::clear();
+            }
+
+            /// \effects Ensures that the buffer can hold at least \c new_capacity elements,
+            /// expanding the memory in place if possible.
+            /// \throws Anything thrown by the allocation or the move constructor of \c T.
+            void reserve(std::size_t new_capacity)
+            {
+                storage::reserve(new_capacity);
+            }
+
+            //=== accessors ===//
+            /// @{
+            /// \returns A reference to the element at the given index.
+            /// \requires \c i must be less than \ref size().
+            T& operator[](std::size_t i) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(i < size_);
+                return data_[i];
+            }
+
+            const T& operator[](std::size_t i) const noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(i < size_);
+                return data_[i];
+            }
+            /// @}
+
+            /// @{
+            /// \returns A pointer to the first element, may be \c nullptr if there is no memory allocated.
+            T* data() noexcept
+            {
+                return data_;
+            }
+
+            const T* data() const noexcept
+            {
+                return data_;
+            }
+            /// @}
+
+            /// @{
+            /// \returns An iterator to the first element or one past the last element.
+            iterator begin() noexcept
+            {
+                return data_;
+            }
+
+            const_iterator begin() const noexcept
+            {
+                return data_;
+            }
+
+            iterator end() noexcept
+            {
+                return data_ + size_;
+            }
+
+            const_iterator end() const noexcept
+            {
+                return data_ + size_;
+            }
+            /// @}
+
+            /// \returns The number of elements.
+            std::size_t size() const noexcept
+            {
+                return size_;
+            }
+
+            /// \returns Whether or not there are no elements.
+            bool empty() const noexcept
+            {
+                return size_ == 0u;
+            }
+
+            /// \returns The number of elements that fit into the buffer without growing it.
+            std::size_t capacity() const noexcept
+            {
+                return capacity_;
+            }
+
+            /// @{
+            /// \returns A reference to the allocator.
+            auto get_allocator() noexcept
+                -> decltype(std::declval<allocator_ref>().get_allocator())
+            {
+                return allocator_ref::get_allocator();
+            }
+
+            auto get_allocator() const noexcept
+                -> decltype(std::declval<const allocator_ref>().get_allocator())
+            {
+                return allocator_ref::get_allocator();
+            }
+            /// @}
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_VECTOR_BUFFER_HPP_INCLUDED
@@ -0,0 +1,243 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#ifndef FOONATHAN_MEMORY_VIRTUAL_ARRAY_HPP_INCLUDED
+#define FOONATHAN_MEMORY_VIRTUAL_ARRAY_HPP_INCLUDED
+
+/// \file
+/// Class template \ref foonathan::memory::virtual_array.
+
+#include <new>
+
+#include "detail/assert.hpp"
+#include "detail/utility.hpp"
+#include "config.hpp"
+#include "virtual_memory.hpp"
+
+namespace foonathan
+{
+    namespace memory
+    {
+        /// A growable array of \c T that lives in a \ref virtual_buffer.
+        /// The virtual memory for the maximum number of elements is reserved up front,
+        /// but pages are only committed once the array grows into them.
+        /// Unlike \c std::vector or \ref vector_buffer, growing the array therefore never moves the elements:
+        /// pointers and references to them stay valid until they are removed,
+        /// and growing a huge array does not temporarily need twice its memory.
+        /// \note Reserving virtual memory is cheap but it is limited by the address space,
+        /// so the maximum size can be generous but should not be arbitrary.
+        /// \ingroup adapter
+        template <typename T>
+        class virtual_array
+        {
+        public:
+            using value_type     = T;
+            using iterator       = T*;
+            using const_iterator = const T*;
+
+            //=== constructors/destructor ===//
+            /// \effects Creates an empty array that can hold at most \c max_size elements.
+            /// It reserves the virtual memory but does not commit any.
+            /// \requires \c max_size must be non-zero.
+            /// \throws \ref out_of_memory if it cannot reserve the virtual memory.
+            explicit virtual_array(std::size_t max_size)
+            : buffer_(max_size * sizeof(T)), size_(0u)
+            {
+            }
+
+            /// \effects Move constructs the array by taking over the memory of \c other,
+            /// which will be empty and have a maximum size of zero afterwards.
+            /// The elements keep their addresses.
+            virtual_array(virtual_array&& other) noexcept
+            : buffer_(detail::move(other.buffer_)), size_(other.size_)
+            {
+                other.size_ = 0u;
+            }
+
+            /// \effects Destroys all elements and releases the memory.
+            ~virtual_array() noexcept
+            {
+                clear();
+            }
+
+            /// \effects Move assigns the array by taking over the memory of \c other,
+            /// which will be empty afterwards.
+            virtual_array& operator=(virtual_array&& other) noexcept
+            {
+                virtual_array tmp(detail::move(other));
+                swap(*this, tmp);
+                return *this;
+            }
+
+            virtual_array(const virtual_array&)            = delete;
+            virtual_array& operator=(const virtual_array&) = delete;
+
+            /// \effects Swaps the elements of both arrays, without moving them.
+            friend void swap(virtual_array& a, virtual_array& b) noexcept
+            {
+                swap(a.buffer_, b.buffer_);
+                detail::adl_swap(a.size_, b.size_);
+            }
+
+            //=== modifiers ===//
+            /// \effects Creates a new element at the end by forwarding the arguments to its constructor,
+            /// committing more memory if necessary.
+            /// \returns A reference to the new element.
+            /// \throws \ref out_of_fixed_memory if the array has reached its \ref max_size(),
+            /// \ref out_of_memory if the memory cannot be committed,
+            /// or anything thrown by the constructor of \c T.
+            /// If an exception is thrown, the array is unchanged.
+            template <typename... Args>
+            T& emplace_back(Args&&... args)
+            {
+                if (size_ == capacity())
+                    // the elements do not move, so the arguments stay valid
+                    grow(size_ + 1u);
+                auto ptr = ::new (static_cast<void*>(data() + size_))
+                    T(detail::forward<Args>(args)...);
+                ++size_;
+                return *ptr;
+            }
+
+            /// @{
+            /// \effects Same as `emplace_back(value)`.
+            void push_back(const T& value)
+            {
+                emplace_back(value);
+            }
+
+            void push_back(T&& value)
+            {
+                emplace_back(detail::move(value));
+            }
+            /// @}
+
+            /// \effects Destroys the last element.
+            /// \requires The array must not be empty.
+            void pop_back() noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(!empty());
+                data()[--size_].~T();
+            }
+
+            /// \effects Destroys all elements.
+            /// The memory stays committed, use \ref shrink_to_fit() to decommit it.
+            void clear() noexcept
+            {
+                while (size_ != 0u)
+                    data()[--size_].~T();
+            }
+
+            /// \effects Ensures that the array can hold at least \c new_capacity elements,
+            /// by committing the memory for them.
+            /// \throws \ref out_of_fixed_memory if \c new_capacity is bigger than \ref max_size(),
+            /// or \ref out_of_memory if the memory cannot be committed.
+            void reserve(std::size_t new_capacity)
+            {
+                if (new_capacity > capacity())
+                    buffer_.commit(new_capacity * sizeof(T));
+            }
+
+            /// \effects Decommits the memory after the last element, rounded to whole pages.
+            /// The elements are not moved.
+            void shrink_to_fit() noexcept
+            {
+                buffer_.decommit(size_ * sizeof(T));
+            }
+
+            //=== accessors ===//
+            /// @{
+            /// \returns A reference to the element at the given index.
+            /// \requires \c i must be less than \ref size().
+            T& operator[](std::size_t i) noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(i < size_);
+                return data()[i];
+            }
+
+            const T& operator[](std::size_t i) const noexcept
+            {
+                FOONATHAN_MEMORY_ASSERT(i < size_);
+                return data()[i];
+            }
+            /// @}
+
+            /// @{
+            /// \returns A pointer to the first element, it does not change while the array grows.
+            T* data() noexcept
+            {
+                return static_cast<T*>(buffer_.data());
+            }
+
+            const T* data() const noexcept
+            {
+                return static_cast<const T*>(buffer_.data());
+            }
+            /// @}
+
+            /// @{
+            /// \returns An iterator to the first element or one past the last element.
+            iterator begin() noexcept
+            {
+                return data();
+            }
+
+            const_iterator begin() const noexcept
+            {
+                return data();
+            }
+
+            iterator end() noexcept
+            {
+                return data() + size_;
+            }
+
+            const_iterator end() const noexcept
+            {
+                return data() + size_;
+            }
+            /// @}
+
+            /// \returns The number of elements.
+            std::size_t size() const noexcept
+            {
+                return size_;
+            }
+
+            /// \returns Whether or not there are no elements.
+            bool empty() const noexcept
+            {
+                return size_ == 0u;
+            }
+
+            /// \returns The number of elements that fit into the committed memory.
+            std::size_t capacity() const noexcept
+            {
+                return buffer_.committed_size() / sizeof(T);
+            }
+
+            /// \returns The maximum number of elements, the array cannot grow beyond it.
+            std::size_t max_size() const noexcept
+            {
+                return buffer_.max_size() / sizeof(T);
+            }
+
+        private:
+            void grow(std::size_t min_capacity)
+            {
+                // commit geometrically to keep the number of system calls low
+                auto new_capacity = 2u * capacity();
+                if (new_capacity < min_capacity)
+                    new_capacity = min_capacity;
+                else if (new_capacity > max_size())
+                    new_capacity = max_size() < min_capacity ? min_capacity : max_size();
+                buffer_.commit(new_capacity * sizeof(T));
+            }
+
+            virtual_buffer buffer_;
+            std::size_t    size_;
+        };
+    } // namespace memory
+} // namespace foonathan
+
+#endif // FOONATHAN_MEMORY_VIRTUAL_ARRAY_HPP_INCLUDED
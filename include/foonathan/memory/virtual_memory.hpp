@@ -11,12 +11,10 @@
 #include <type_traits>
 
 #include "detail/debug_helpers.hpp"
+#include "detail/memory_stack.hpp"
 #include "detail/utility.hpp"
-#include "config.hpp"
-
-#if FOONATHAN_MEMORY_EXTERN_TEMPLATE
 #include "allocator_traits.hpp"
-#endif
+#include "config.hpp"
 
 namespace foonathan
 {
@@ -76,6 +74,62 @@ namespace foonathan
         /// \ingroup allocator
         void virtual_memory_decommit(void* memory, std::size_t no_pages) noexcept;
 
+        /// The kind of pages backing virtual memory.
+        /// \ingroup allocator
+        enum class virtual_memory_page_mode
+        {
+            /// Pages of \ref get_virtual_memory_page_size().
+            normal,
+            /// Huge pages of \ref get_virtual_memory_huge_page_size() if supported, normal pages otherwise.
+            huge,
+        };
+
+        /// \returns The size of huge pages, or \c 0 if they are not supported.
+        /// On Linux, these are transparent huge pages, usually 2MiB.
+        /// They are not supported on other systems currently.
+        /// \ingroup allocator
+        std::size_t get_virtual_memory_huge_page_size() noexcept;
+
+        /// Commits reserved virtual memory using the given kind of pages.
+        /// \effects Same as \ref virtual_memory_commit(),
+        /// but if \c mode is \c huge, the system is also advised to back the memory by huge pages.
+        /// Parts of the memory that are not aligned to the huge page size,
+        /// or all of it if they are not supported, use normal pages.
+        /// \returns The beginning of the committed area, i.e. \c memory, or \c nullptr in case of error.
+        /// \requires The memory must be previously reserved.
+        /// \ingroup allocator
+        void* virtual_memory_commit(void* memory, std::size_t no_pages,
+                                    virtual_memory_page_mode mode) noexcept;
+
+        /// Makes memory resident, so that it does not cause page faults when it is used.
+        /// \effects Populates the pages of the given memory region with physical memory,
+        /// using \c madvise(MADV_POPULATE_WRITE) if supported and by touching every page otherwise.
+        /// The contents of the memory are not changed.
+        /// \requires The memory must be committed and writeable,
+        /// and it must not be accessed by another thread at the same time.
+        /// \note This is useful for memory that has just been allocated from the system,
+        /// so that the page faults happen ahead of time instead of on the first use,
+        /// see also \ref prefault_block_allocator.
+        /// \ingroup allocator
+        void prefault_memory(void* memory, std::size_t size) noexcept;
+
+        /// Locks memory in physical memory, so that it is never paged out.
+        /// \effects Locks all pages of the given memory region using \c mlock() or \c VirtualLock().
+        /// Locked memory is resident and can be the source or target of DMA transfers.
+        /// \returns Whether or not the memory could be locked,
+        /// this fails if the limit of the process for locked memory would be exceeded.
+        /// \requires The memory must be committed.
+        /// \note Locks are not counted: unlocking a page unlocks it for all regions it belongs to,
+        /// so regions that are locked and unlocked independently should not share pages,
+        /// see also \ref pinned_block_allocator.
+        /// \ingroup allocator
+        bool lock_memory(void* memory, std::size_t size) noexcept;
+
+        /// \effects Unlocks all pages of the given memory region, they can be paged out again.
+        /// \requires The memory must be committed.
+        /// \ingroup allocator
+        void unlock_memory(void* memory, std::size_t size) noexcept;
+
         /// A stateless \concept{concept_rawallocator,RawAllocator} that allocates memory using the virtual memory allocation functions.
         /// It does not prereserve any memory and will always reserve and commit combined.
         /// \ingroup allocator
@@ -104,6 +158,20 @@ namespace foonathan
             /// \throws An exception of type \ref out_of_memory or whatever is thrown by its handler if the allocation fails.
             void* allocate_node(std::size_t size, std::size_t alignment);
 
+            /// @{
+            /// \effects Allocates memory like \ref allocate_node() whose bytes are all zero.
+            /// Freshly committed memory is already zeroed by the operating system,
+            /// so it only needs to be cleared if debug filling is enabled.
+            /// \returns A pointer to the zeroed memory.
+            /// \throws Anything thrown by \ref allocate_node().
+            void* allocate_node_zeroed(std::size_t size, std::size_t alignment);
+
+            void* allocate_array_zeroed(std::size_t count, std::size_t size, std::size_t alignment)
+            {
+                return allocate_node_zeroed(count * size, alignment);
+            }
+            /// @}
+
             /// \effects A \concept{concept_rawallocator,RawAllocator} deallocation function.
             /// It calls \ref virtual_memory_decommit followed by \ref virtual_memory_release for the deallocation.
             void deallocate_node(void* node, std::size_t size, std::size_t alignment) noexcept;
@@ -115,8 +183,69 @@ namespace foonathan
             std::size_t max_alignment() const noexcept;
         };
 
+        /// A stateless \concept{concept_rawallocator,RawAllocator} that allocates memory backed by huge pages if possible.
+        /// It behaves like \ref virtual_memory_allocator but commits the memory with \ref virtual_memory_page_mode::huge
+        /// and rounds allocations up to a multiple of \ref page_size().
+        /// If huge pages are not supported, it uses normal pages.
+        /// \note A constructor option on \ref virtual_memory_allocator would make that allocator stateful,
+        /// so huge pages are provided by this separate class instead.
+        /// \ingroup allocator
+        class huge_page_allocator
+        : FOONATHAN_EBO(detail::global_leak_checker<detail::virtual_memory_allocator_leak_handler>)
+        {
+        public:
+            using is_stateful = std::false_type;
+
+            huge_page_allocator() noexcept = default;
+            huge_page_allocator(huge_page_allocator&&) noexcept {}
+            ~huge_page_allocator() noexcept = default;
+
+            huge_page_allocator& operator=(huge_page_allocator&&) noexcept
+            {
+                return *this;
+            }
+
+            /// \effects A \concept{concept_rawallocator,RawAllocator} allocation function.
+            /// It uses \ref virtual_memory_reserve followed by \ref virtual_memory_commit for the allocation.
+            /// The memory will be aligned for and consist of whole huge pages, if they are supported.
+            /// If debug fences are activated, one additional page before and after the memory will be allocated.
+            /// \returns A pointer to a \concept{concept_node,node}, it will never be \c nullptr.
+            /// It will always be aligned on a fence boundary, regardless of the alignment parameter.
+            /// \throws An exception of type \ref out_of_memory or whatever is thrown by its handler if the allocation fails.
+            void* allocate_node(std::size_t size, std::size_t alignment);
+
+            /// @{
+            /// \effects Allocates memory like \ref allocate_node() whose bytes are all zero.
+            /// Freshly committed memory is already zeroed by the operating system,
+            /// so it only needs to be cleared if debug filling is enabled.
+            /// \returns A pointer to the zeroed memory.
+            /// \throws Anything thrown by \ref allocate_node().
+            void* allocate_node_zeroed(std::size_t size, std::size_t alignment);
+
+            void* allocate_array_zeroed(std::size_t count, std::size_t size, std::size_t alignment)
+            {
+                return allocate_node_zeroed(count * size, alignment);
+            }
+            /// @}
+
+            /// \effects A \concept{concept_rawallocator,RawAllocator} deallocation function.
+            /// It calls \ref virtual_memory_decommit followed by \ref virtual_memory_release for the deallocation.
+            void deallocate_node(void* node, std::size_t size, std::size_t alignment) noexcept;
+
+            /// \returns The maximum node size by returning the maximum value.
+            std::size_t max_node_size() const noexcept;
+
+            /// \returns The maximum alignment which is the same as the \ref virtual_memory_page_size.
+            std::size_t max_alignment() const noexcept;
+
+            /// \returns The size of the pages actually used,
+            /// i.e. \ref get_virtual_memory_huge_page_size() if supported, \ref get_virtual_memory_page_size() otherwise.
+            static std::size_t page_size() noexcept;
+        };
+
 #if FOONATHAN_MEMORY_EXTERN_TEMPLATE
         extern template class allocator_traits<virtual_memory_allocator>;
+        extern template class allocator_traits<huge_page_allocator>;
 #endif
 
         struct memory_block;
@@ -131,10 +260,15 @@ namespace foonathan
         public:
             /// \effects Creates it giving it the block size and the total number of blocks it can allocate.
             /// It reserves enough virtual memory for <tt>block_size * no_blocks</tt>.
+            /// If \c mode is \c huge and huge pages are supported,
+            /// the \c block_size is rounded up to a multiple of the huge page size
+            /// and the reserved memory is aligned for them, so each block consists of whole huge pages.
             /// \requires \c block_size must be non-zero and a multiple of the \ref virtual_memory_page_size.
             /// \c no_blocks must be bigger than \c 1.
             /// \throws \ref out_of_memory if it cannot reserve the virtual memory.
-            explicit virtual_block_allocator(std::size_t block_size, std::size_t no_blocks);
+            explicit virtual_block_allocator(
+                std::size_t block_size, std::size_t no_blocks,
+                virtual_memory_page_mode mode = virtual_memory_page_mode::normal);
 
             /// \effects Releases the reserved virtual memory.
             /// \requires All previously \ref allocate_block() committed blocks must be decommitted via
@@ -145,10 +279,16 @@ namespace foonathan
             /// \effects Moves the block allocator, it transfers ownership over the reserved area.
             /// This does not invalidate any memory blocks.
             virtual_block_allocator(virtual_block_allocator&& other) noexcept
-            : cur_(other.cur_), end_(other.end_), block_size_(other.block_size_)
+            : begin_(other.begin_),
+              cur_(other.cur_),
+              fresh_(other.fresh_),
+              end_(other.end_),
+              block_size_(other.block_size_),
+              page_size_(other.page_size_),
+              last_zeroed_(other.last_zeroed_)
             {
-                other.cur_ = other.end_ = nullptr;
-                other.block_size_       = 0;
+                other.begin_ = other.cur_ = other.fresh_ = other.end_ = nullptr;
+                other.block_size_                      = 0;
             }
 
             virtual_block_allocator& operator=(virtual_block_allocator&& other) noexcept
@@ -163,9 +303,13 @@ namespace foonathan
             /// This does not invalidate any memory blocks.
             friend void swap(virtual_block_allocator& a, virtual_block_allocator& b) noexcept
             {
+                detail::adl_swap(a.begin_, b.begin_);
                 detail::adl_swap(a.cur_, b.cur_);
+                detail::adl_swap(a.fresh_, b.fresh_);
                 detail::adl_swap(a.end_, b.end_);
                 detail::adl_swap(a.block_size_, b.block_size_);
+                detail::adl_swap(a.page_size_, b.page_size_);
+                detail::adl_swap(a.last_zeroed_, b.last_zeroed_);
             }
 
             /// \effects Allocates a new memory block by committing the next \ref next_block_size() number of bytes.
@@ -173,8 +317,13 @@ namespace foonathan
             /// \throws \ref out_of_memory if it cannot commit the memory or the \ref capacity_left() is exhausted.
             memory_block allocate_block();
 
+            /// \effects Allocates the memory of \c n blocks as one block by committing it with a single call.
+            /// \returns The \ref memory_block committed, it is deallocated as one block.
+            /// \throws \ref out_of_memory if it cannot commit the memory or the \ref capacity_left() is less than \c n.
+            memory_block allocate_blocks(std::size_t n);
+
             /// \effects Deallocates the last allocated memory block by decommitting it.
-            /// This block will be returned again on the next call to \ref allocate_block().
+            /// This memory will be returned again on the next call to \ref allocate_block() or \ref allocate_blocks().
             /// \requires \c block must be the current top block of the memory,
             /// this is guaranteed by \ref memory_arena.
             void deallocate_block(memory_block block) noexcept;
@@ -191,11 +340,623 @@ namespace foonathan
                 return static_cast<std::size_t>(end_ - cur_) / block_size_;
             }
 
+            /// \returns Whether or not the last allocated block was committed for the first time,
+            /// so all of its bytes are zero.
+            /// A block that was deallocated and allocated again is not,
+            /// as decommitted memory may keep its contents.
+            bool last_block_zeroed() const noexcept
+            {
+                return last_zeroed_;
+            }
+
+            /// \returns The size of the pages backing the blocks,
+            /// i.e. the huge page size if they were requested and are supported,
+            /// \ref get_virtual_memory_page_size() otherwise.
+            std::size_t page_size() const noexcept
+            {
+                return page_size_;
+            }
+
+            /// \returns The alignment of all memory blocks, which is the \ref page_size().
+            std::size_t block_alignment() const noexcept
+            {
+                return page_size_;
+            }
+
+        private:
+            allocator_info info() noexcept;
+
+            virtual_memory_page_mode mode() const noexcept
+            {
+                return page_size_ == get_virtual_memory_page_size() ?
+                           virtual_memory_page_mode::normal :
+                           virtual_memory_page_mode::huge;
+            }
+
+            // all memory above fresh_ has never been committed
+            char *      begin_, *cur_, *fresh_, *end_;
+            std::size_t block_size_, page_size_;
+            bool        last_zeroed_;
+        };
+
+#if defined(__unix__) || defined(__APPLE__) || defined(__VXWORKS__)                                \
+    || defined(__QNXNTO__) // POSIX systems
+        /// The options of a \ref mmap_block_allocator.
+        /// They can be combined with <tt>operator|</tt>.
+        /// \ingroup allocator
+        enum class mmap_options : unsigned
+        {
+            /// Grows the file sparsely and lets the system choose how to read it.
+            none = 0u,
+            /// Reads the existing contents of the file when it is mapped and each new block when it is allocated,
+            /// using \c MAP_POPULATE and \c madvise() where supported.
+            populate = 1u << 0,
+            /// Reserves the disk space of each new block with \c posix_fallocate() instead of growing the file sparsely.
+            preallocate = 1u << 1,
+            /// Advises the system that the memory is accessed sequentially.
+            sequential = 1u << 2,
+            /// Advises the system that the memory is accessed randomly, so it does not read ahead.
+            random = 1u << 3,
+        };
+
+        /// \returns The combination of both options.
+        /// \relates mmap_options
+        constexpr mmap_options operator|(mmap_options a, mmap_options b) noexcept
+        {
+            return static_cast<mmap_options>(static_cast<unsigned>(a) | static_cast<unsigned>(b));
+        }
+
+        /// \returns Whether \c a contains the option \c b.
+        /// \relates mmap_options
+        constexpr bool operator&(mmap_options a, mmap_options b) noexcept
+        {
+            return (static_cast<unsigned>(a) & static_cast<unsigned>(b)) != 0u;
+        }
+
+        /// A \concept{concept_blockallocator,BlockAllocator} that allocates the blocks from a memory-mapped file.
+        /// It maps a range of the file as shared memory, so the data structures built in the blocks are written to the file
+        /// and can be paged out by the system.
+        /// The file only grows when a block beyond its current end is allocated.
+        /// The blocks are handed out in the order of the file starting at its beginning,
+        /// so after reopening a file the same block contains the same data,
+        /// and the existing contents are never overwritten by the allocator.<br>
+        /// Deallocations are only allowed in reversed order which is guaranteed by \ref memory_arena,
+        /// they do not shrink the file.
+        /// \note Pointers stored inside the file are only valid as long as it is mapped to the same address,
+        /// so data structures meant to be reopened should either be mapped at a fixed address
+        /// or use \ref offset_ptr.
+        /// A \ref memory_stack using it can be restored from a \ref memory_stack_snapshot.
+        /// \note \ref memory_arena writes its bookkeeping into the beginning of each block
+        /// and fills deallocated blocks if \ref FOONATHAN_MEMORY_DEBUG_FILL is \c true.
+        /// \note It is only available on POSIX systems.
+        /// \ingroup allocator
+        class mmap_block_allocator
+        {
+        public:
+            /// \effects Creates it giving it the block size, the total number of blocks it can allocate and the path of the file.
+            /// The file is created if it does not exist,
+            /// and <tt>block_size * no_blocks</tt> bytes of it are mapped into memory.
+            /// If \c address is not \c nullptr, the file is mapped exactly at that address,
+            /// e.g. the \ref memory() of a previous mapping, so that pointers stored in it stay valid.
+            /// The order of the parameters allows creating it through \ref memory_arena,
+            /// e.g. <tt>memory_stack<mmap_block_allocator>(block_size, no_blocks, path)</tt>.
+            /// \requires \c block_size must be non-zero and a multiple of the \ref virtual_memory_page_size.
+            /// \c no_blocks must be bigger than \c 0.
+            /// \c address must be a multiple of the \ref virtual_memory_page_size.
+            /// \throws \ref out_of_memory if it cannot open or map the file,
+            /// or map it at the requested address because that memory is already in use.
+            mmap_block_allocator(std::size_t block_size, std::size_t no_blocks, const char* path,
+                                 mmap_options options = mmap_options::none,
+                                 void* address = nullptr);
+
+            /// \effects Unmaps the file and closes it.
+            /// The contents of the file are kept, but not explicitly synchronized, use \ref sync() for that.
+            ~mmap_block_allocator() noexcept;
+
+            /// @{
+            /// \effects Moves the block allocator, it transfers ownership over the mapped file.
+            /// This does not invalidate any memory blocks.
+            mmap_block_allocator(mmap_block_allocator&& other) noexcept
+            : begin_(other.begin_),
+              cur_(other.cur_),
+              end_(other.end_),
+              block_size_(other.block_size_),
+              file_size_(other.file_size_),
+              fd_(other.fd_),
+              options_(other.options_)
+            {
+                other.begin_ = other.cur_ = other.end_ = nullptr;
+                other.block_size_ = other.file_size_ = 0u;
+                other.fd_                            = -1;
+            }
+
+            mmap_block_allocator& operator=(mmap_block_allocator&& other) noexcept
+            {
+                mmap_block_allocator tmp(detail::move(other));
+                swap(*this, tmp);
+                return *this;
+            }
+            /// @}
+
+            /// \effects Swaps the ownership over the mapped file.
+            /// This does not invalidate any memory blocks.
+            friend void swap(mmap_block_allocator& a, mmap_block_allocator& b) noexcept
+            {
+                detail::adl_swap(a.begin_, b.begin_);
+                detail::adl_swap(a.cur_, b.cur_);
+                detail::adl_swap(a.end_, b.end_);
+                detail::adl_swap(a.block_size_, b.block_size_);
+                detail::adl_swap(a.file_size_, b.file_size_);
+                detail::adl_swap(a.fd_, b.fd_);
+                detail::adl_swap(a.options_, b.options_);
+            }
+
+            /// \effects Allocates the next \ref next_block_size() bytes of the file,
+            /// growing it if the block is beyond its end.
+            /// \returns The new memory block.
+            /// \throws \ref out_of_fixed_memory if the \ref capacity_left() is exhausted,
+            /// \ref out_of_memory if the file cannot be grown.
+            memory_block allocate_block();
+
+            /// \effects Deallocates the last allocated memory block.
+            /// This block will be returned again on the next call to \ref allocate_block(),
+            /// its contents are kept.
+            /// \requires \c block must be the current top block of the memory,
+            /// this is guaranteed by \ref memory_arena.
+            void deallocate_block(memory_block block) noexcept;
+
+            /// \effects Writes the modified contents of all allocated blocks to the file and waits for it to finish.
+            /// \returns Whether or not it was successful.
+            bool sync() noexcept;
+
+            /// \returns The next block size, this is the block size of the constructor.
+            std::size_t next_block_size() const noexcept
+            {
+                return block_size_;
+            }
+
+            /// \returns The number of blocks that can be allocated until it runs out of memory.
+            std::size_t capacity_left() const noexcept
+            {
+                return static_cast<std::size_t>(end_ - cur_) / block_size_;
+            }
+
+            /// \returns The size of the file, it is at least the size of all allocated blocks.
+            std::size_t file_size() const noexcept
+            {
+                return file_size_;
+            }
+
+            /// \returns The address the beginning of the file is mapped to.
+            void* memory() const noexcept
+            {
+                return begin_;
+            }
+
+            /// \returns The alignment of all memory blocks, which is the \ref virtual_memory_page_size.
+            std::size_t block_alignment() const noexcept
+            {
+                return get_virtual_memory_page_size();
+            }
+
         private:
             allocator_info info() noexcept;
 
-            char *      cur_, *end_;
-            std::size_t block_size_;
+            char *       begin_, *cur_, *end_;
+            std::size_t  block_size_, file_size_;
+            int          fd_;
+            mmap_options options_;
+        };
+#endif
+
+        /// A contiguous range of virtual memory that is reserved once and committed from its beginning as needed.
+        /// It is the building block for growable buffers like \ref virtual_array:
+        /// as the reserved range never moves, growing the committed part neither copies memory nor changes addresses.
+        /// \ingroup allocator
+        class virtual_buffer
+        {
+        public:
+            /// \effects Creates it by reserving virtual memory for \c max_size bytes,
+            /// rounded up to a multiple of the page size.
+            /// No memory is committed yet.
+            /// \requires \c max_size must be non-zero.
+            /// \throws \ref out_of_memory if it cannot reserve the virtual memory.
+            explicit virtual_buffer(std::size_t max_size);
+
+            /// \effects Releases the reserved virtual memory.
+            ~virtual_buffer() noexcept;
+
+            /// @{
+            /// \effects Moves the buffer, it transfers ownership over the reserved memory.
+            /// This does not change the address of the memory.
+            virtual_buffer(virtual_buffer&& other) noexcept
+            : begin_(other.begin_), committed_(other.committed_), end_(other.end_)
+            {
+                other.begin_ = other.committed_ = other.end_ = nullptr;
+            }
+
+            virtual_buffer& operator=(virtual_buffer&& other) noexcept
+            {
+                virtual_buffer tmp(detail::move(other));
+                swap(*this, tmp);
+                return *this;
+            }
+            /// @}
+
+            /// \effects Swaps the ownership over the reserved memory.
+            friend void swap(virtual_buffer& a, virtual_buffer& b) noexcept
+            {
+                detail::adl_swap(a.begin_, b.begin_);
+                detail::adl_swap(a.committed_, b.committed_);
+                detail::adl_swap(a.end_, b.end_);
+            }
+
+            /// \effects Commits pages such that at least the first \c size bytes are committed.
+            /// \throws \ref out_of_fixed_memory if \c size is bigger than \ref max_size(),
+            /// or \ref out_of_memory if the pages cannot be committed.
+            void commit(std::size_t size);
+
+            /// \effects Commits pages like \ref commit(), but does not throw.
+            /// \returns Whether or not the first \c size bytes are committed.
+            bool try_commit(std::size_t size) noexcept;
+
+            /// \effects Decommits all pages after the first \c size bytes.
+            void decommit(std::size_t size) noexcept;
+
+            /// \returns The beginning of the reserved memory.
+            void* data() const noexcept
+            {
+                return begin_;
+            }
+
+            /// \returns The number of bytes currently committed, it is a multiple of the page size.
+            std::size_t committed_size() const noexcept
+            {
+                return std::size_t(committed_ - begin_);
+            }
+
+            /// \returns The number of bytes reserved, it is a multiple of the page size.
+            std::size_t max_size() const noexcept
+            {
+                return std::size_t(end_ - begin_);
+            }
+
+        private:
+            allocator_info info() noexcept;
+
+            char *begin_, *committed_, *end_;
+        };
+
+        /// A stateful \concept{concept_rawallocator,RawAllocator} that provides stack-like (LIFO) allocations
+        /// inside a single contiguous range of virtual memory.
+        /// The whole capacity is reserved up front, but pages are only committed once the top of the stack advances onto them,
+        /// so unlike a \ref memory_stack using a \ref virtual_block_allocator it grows in place and never switches blocks.
+        /// Pages are committed in steps of \ref commit_size() and thus physical memory is only used for the part of the stack that was actually reached.
+        /// If a decommit margin is given, \ref unwind() decommits all pages that are further away from the new top than the margin.
+        /// \ingroup allocator
+        class virtual_memory_stack
+        {
+        public:
+            /// The decommit margin that never decommits any pages on \ref unwind().
+            static constexpr std::size_t never_decommit = std::size_t(-1);
+
+            /// \effects Creates it by reserving virtual memory for \c capacity bytes,
+            /// rounded up to a multiple of the \ref page_size().
+            /// No memory is committed yet.
+            /// If \c mode is \c huge and huge pages are supported, the memory is backed by huge pages.
+            /// On \ref unwind(), all committed memory more than \c decommit_margin bytes above the new top is decommitted.
+            /// \requires \c capacity must be non-zero.
+            /// \throws \ref out_of_memory if it cannot reserve the virtual memory.
+            explicit virtual_memory_stack(
+                std::size_t capacity, std::size_t decommit_margin = never_decommit,
+                virtual_memory_page_mode mode = virtual_memory_page_mode::normal);
+
+            /// \effects Releases the reserved virtual memory.
+            ~virtual_memory_stack() noexcept;
+
+            /// @{
+            /// \effects Moves the stack, it transfers ownership over the reserved area.
+            /// This does not invalidate any memory allocated from it.
+            virtual_memory_stack(virtual_memory_stack&& other) noexcept
+            : begin_(other.begin_),
+              committed_(other.committed_),
+              zeroed_(other.zeroed_),
+              end_(other.end_),
+              page_size_(other.page_size_),
+              decommit_margin_(other.decommit_margin_),
+              stack_(detail::move(other.stack_))
+            {
+                other.begin_ = other.committed_ = other.zeroed_ = other.end_ = nullptr;
+            }
+
+            virtual_memory_stack& operator=(virtual_memory_stack&& other) noexcept
+            {
+                virtual_memory_stack tmp(detail::move(other));
+                swap(*this, tmp);
+                return *this;
+            }
+            /// @}
+
+            /// \effects Swaps the ownership over the reserved memory.
+            /// This does not invalidate any memory allocated from them.
+            friend void swap(virtual_memory_stack& a, virtual_memory_stack& b) noexcept
+            {
+                detail::adl_swap(a.begin_, b.begin_);
+                detail::adl_swap(a.committed_, b.committed_);
+                detail::adl_swap(a.zeroed_, b.zeroed_);
+                detail::adl_swap(a.end_, b.end_);
+                detail::adl_swap(a.page_size_, b.page_size_);
+                detail::adl_swap(a.decommit_margin_, b.decommit_margin_);
+                detail::fixed_memory_stack tmp(detail::move(a.stack_));
+                a.stack_ = detail::move(b.stack_);
+                b.stack_ = detail::move(tmp);
+            }
+
+            /// \effects Allocates a memory block of given size and alignment by moving the top marker,
+            /// committing further pages if needed.
+            /// \returns A \concept{concept_node,node} with given size and alignment.
+            /// \throws \ref out_of_fixed_memory if the reserved memory is exhausted,
+            /// or \ref out_of_memory if the pages cannot be committed.
+            /// \requires \c size and \c alignment must be valid.
+            void* allocate(std::size_t size, std::size_t alignment)
+            {
+                auto fence  = detail::debug_fence_size;
+                auto offset = detail::align_offset(stack_.top() + fence, alignment);
+                auto needed = fence + offset + size + fence;
+                if (needed > std::size_t(committed_ - stack_.top()))
+                    commit(needed);
+                return stack_.allocate_unchecked(size, offset);
+            }
+
+            /// \effects Allocates a memory block of given size and alignment similar to \ref allocate(),
+            /// but it does not throw.
+            /// \returns A \concept{concept_node,node} with given size and alignment
+            /// or \c nullptr if the reserved memory is exhausted or the pages cannot be committed.
+            void* try_allocate(std::size_t size, std::size_t alignment) noexcept
+            {
+                auto fence  = detail::debug_fence_size;
+                auto offset = detail::align_offset(stack_.top() + fence, alignment);
+                auto needed = fence + offset + size + fence;
+                if (needed > std::size_t(committed_ - stack_.top()) && !try_commit(needed))
+                    return nullptr;
+                return stack_.allocate_unchecked(size, offset);
+            }
+
+            /// \effects Allocates a memory block like \ref allocate() whose bytes are all zero.
+            /// Only the part of it that was allocated before and unwound since is cleared,
+            /// the rest is fresh virtual memory that is still zero.
+            /// \returns A \concept{concept_node,node} with given size and alignment.
+            /// \throws Anything thrown by \ref allocate().
+            /// \requires \c size and \c alignment must be valid.
+            void* allocate_zeroed(std::size_t size, std::size_t alignment)
+            {
+                auto memory = allocate(size, alignment);
+                detail::clear_used_memory(memory, size, zeroed_);
+                return memory;
+            }
+
+            /// The marker type that is used for unwinding.
+            /// It is efficiently copyable and a marker is less than another one,
+            /// if it was obtained before the other one with calls to \ref allocate() in between.
+            class marker
+            {
+            public:
+                friend bool operator==(const marker& lhs, const marker& rhs) noexcept
+                {
+                    return lhs.top_ == rhs.top_;
+                }
+
+                friend bool operator!=(const marker& lhs, const marker& rhs) noexcept
+                {
+                    return lhs.top_ != rhs.top_;
+                }
+
+                friend bool operator<(const marker& lhs, const marker& rhs) noexcept
+                {
+                    return lhs.top_ < rhs.top_;
+                }
+
+                friend bool operator>(const marker& lhs, const marker& rhs) noexcept
+                {
+                    return rhs < lhs;
+                }
+
+                friend bool operator<=(const marker& lhs, const marker& rhs) noexcept
+                {
+                    return !(rhs < lhs);
+                }
+
+                friend bool operator>=(const marker& lhs, const marker& rhs) noexcept
+                {
+                    return !(lhs < rhs);
+                }
+
+            private:
+                explicit marker(char* top) noexcept : top_(top) {}
+
+                char* top_;
+
+                friend virtual_memory_stack;
+            };
+
+            /// \returns A marker to the current top of the stack.
+            marker top() const noexcept
+            {
+                return marker(stack_.top());
+            }
+
+            /// \effects Unwinds the stack to a certain marker position,
+            /// which deallocates all memory allocated since the marker was obtained.
+            /// If there is more committed memory above the new top than the decommit margin,
+            /// the pages beyond the margin are decommitted.
+            /// \requires The marker must have been obtained from this stack and must not be above the current top.
+            void unwind(marker m) noexcept;
+
+            /// \effects Decommits all pages above the current top.
+            void shrink_to_fit() noexcept;
+
+            /// \returns The amount of reserved memory remaining above the top,
+            /// i.e. the number of bytes that can be allocated before it runs out of memory.
+            std::size_t capacity_left() const noexcept
+            {
+                return std::size_t(end_ - stack_.top());
+            }
+
+            /// \returns The total amount of memory reserved for the stack.
+            std::size_t capacity() const noexcept
+            {
+                return std::size_t(end_ - begin_);
+            }
+
+            /// \returns The amount of memory currently committed, starting at the bottom of the stack.
+            std::size_t committed_size() const noexcept
+            {
+                return std::size_t(committed_ - begin_);
+            }
+
+            /// \returns The minimal size by which the committed memory is grown,
+            /// it is a multiple of the \ref page_size().
+            std::size_t commit_size() const noexcept;
+
+            /// \returns The size of the pages backing the stack,
+            /// i.e. the huge page size if they were requested and are supported,
+            /// \ref get_virtual_memory_page_size() otherwise.
+            std::size_t page_size() const noexcept
+            {
+                return page_size_;
+            }
+
+        private:
+            allocator_info info() noexcept;
+
+            // commits memory such that needed bytes above the top are committed
+            void commit(std::size_t needed);
+            bool try_commit(std::size_t needed) noexcept;
+
+            // decommits all pages that are more than margin bytes above the top
+            void decommit_above(std::size_t margin) noexcept;
+
+            // all memory above both zeroed_ and the top has never been allocated
+            char *                     begin_, *committed_, *zeroed_, *end_;
+            std::size_t                page_size_, decommit_margin_;
+            detail::fixed_memory_stack stack_;
+
+            friend composable_allocator_traits<virtual_memory_stack>;
+        };
+
+        /// Specialization of the \ref allocator_traits for \ref virtual_memory_stack.
+        /// \note It is not allowed to mix calls through the specialization and through the member functions,
+        /// i.e. \ref virtual_memory_stack::allocate() and this \c allocate_node().
+        /// \ingroup allocator
+        template <>
+        class allocator_traits<virtual_memory_stack>
+        {
+        public:
+            using allocator_type       = virtual_memory_stack;
+            using is_stateful          = std::true_type;
+            using is_deallocation_noop = std::true_type;
+
+            /// \returns The result of \ref virtual_memory_stack::allocate().
+            static void* allocate_node(allocator_type& state, std::size_t size,
+                                       std::size_t alignment)
+            {
+                return state.allocate(size, alignment);
+            }
+
+            /// \returns The result of \ref virtual_memory_stack::allocate().
+            static void* allocate_array(allocator_type& state, std::size_t count, std::size_t size,
+                                        std::size_t alignment)
+            {
+                return state.allocate(count * size, alignment);
+            }
+
+            /// \returns The result of \ref virtual_memory_stack::allocate_zeroed().
+            static void* allocate_node_zeroed(allocator_type& state, std::size_t size,
+                                              std::size_t alignment)
+            {
+                return state.allocate_zeroed(size, alignment);
+            }
+
+            /// \returns The result of \ref virtual_memory_stack::allocate_zeroed().
+            static void* allocate_array_zeroed(allocator_type& state, std::size_t count,
+                                               std::size_t size, std::size_t alignment)
+            {
+                return state.allocate_zeroed(count * size, alignment);
+            }
+
+            /// @{
+            /// \effects Does nothing.
+            /// Actual deallocation can only be done via \ref virtual_memory_stack::unwind().
+            static void deallocate_node(allocator_type&, void*, std::size_t, std::size_t) noexcept
+            {
+            }
+
+            static void deallocate_array(allocator_type&, void*, std::size_t, std::size_t,
+                                         std::size_t) noexcept
+            {
+            }
+            /// @}
+
+            /// @{
+            /// \returns The maximum size which is \ref virtual_memory_stack::capacity().
+            static std::size_t max_node_size(const allocator_type& state) noexcept
+            {
+                return state.capacity();
+            }
+
+            static std::size_t max_array_size(const allocator_type& state) noexcept
+            {
+                return state.capacity();
+            }
+            /// @}
+
+            /// \returns The maximum possible value since there is no alignment restriction
+            /// (except indirectly through \ref virtual_memory_stack::capacity()).
+            static std::size_t max_alignment(const allocator_type&) noexcept
+            {
+                return std::size_t(-1);
+            }
+        };
+
+        /// Specialization of the \ref composable_allocator_traits for \ref virtual_memory_stack.
+        /// \ingroup allocator
+        template <>
+        class composable_allocator_traits<virtual_memory_stack>
+        {
+        public:
+            using allocator_type = virtual_memory_stack;
+
+            /// \returns The result of \ref virtual_memory_stack::try_allocate().
+            static void* try_allocate_node(allocator_type& state, std::size_t size,
+                                           std::size_t alignment) noexcept
+            {
+                return state.try_allocate(size, alignment);
+            }
+
+            /// \returns The result of \ref virtual_memory_stack::try_allocate().
+            static void* try_allocate_array(allocator_type& state, std::size_t count,
+                                            std::size_t size, std::size_t alignment) noexcept
+            {
+                return state.try_allocate(count * size, alignment);
+            }
+
+            /// @{
+            /// \effects Does nothing.
+            /// \returns Whether the memory will be deallocated by \ref virtual_memory_stack::unwind(),
+            /// i.e. whether it lies below the top of the stack.
+            static bool try_deallocate_node(allocator_type& state, void* ptr, std::size_t,
+                                            std::size_t) noexcept
+            {
+                auto memory = static_cast<char*>(ptr);
+                return state.begin_ <= memory && memory < state.stack_.top();
+            }
+
+            static bool try_deallocate_array(allocator_type& state, void* ptr, std::size_t count,
+                                             std::size_t size, std::size_t alignment) noexcept
+            {
+                return try_deallocate_node(state, ptr, count * size, alignment);
+            }
+            /// @}
         };
     } // namespace memory
 } // namespace foonathan
@@ -0,0 +1,159 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "budgeted_block_allocator.hpp"
+
+#include "detail/assert.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    // threads are assigned a shard round-robin on their first charge
+    std::size_t current_shard(std::size_t shard_count) noexcept
+    {
+        static std::atomic<std::size_t> next_shard(0u);
+        thread_local const std::size_t  shard = next_shard.fetch_add(1u, std::memory_order_relaxed);
+        return shard % shard_count;
+    }
+} // namespace
+
+constexpr std::size_t memory_budget::unlimited;
+constexpr std::size_t memory_budget::default_granularity;
+constexpr std::size_t memory_budget::shard_count;
+
+memory_budget::memory_budget(std::size_t soft_limit, std::size_t hard_limit,
+                             memory_budget* parent, std::size_t granularity) noexcept
+: shards_(),
+  reserved_(0u),
+  above_soft_limit_(false),
+  soft_limit_(soft_limit),
+  hard_limit_(hard_limit),
+  granularity_(granularity),
+  parent_(parent),
+  handler_(nullptr),
+  user_data_(nullptr)
+{
+}
+
+memory_budget::~memory_budget() noexcept
+{
+    drain();
+    // anything still charged is returned to the parent as well
+    auto rest = reserved_.load(std::memory_order_relaxed);
+    if (rest != 0u && parent_)
+        parent_->unreserve(rest);
+}
+
+bool memory_budget::try_charge(std::size_t size) noexcept
+{
+    if (granularity_ == 0u)
+        return reserve(size, true);
+
+    auto& s     = shards_[current_shard(shard_count)];
+    auto  slack = s.slack.load(std::memory_order_relaxed);
+    while (slack >= size)
+        if (s.slack.compare_exchange_weak(slack, slack - size, std::memory_order_relaxed))
+            return true;
+
+    // reserve another step for the next charges, or only the size if that exceeds a limit
+    if (granularity_ <= hard_limit_ && size <= hard_limit_ - granularity_
+        && reserve(size + granularity_, false))
+    {
+        s.slack.fetch_add(granularity_, std::memory_order_relaxed);
+        return true;
+    }
+    return reserve(size, true);
+}
+
+void memory_budget::release(std::size_t size) noexcept
+{
+    if (granularity_ == 0u)
+    {
+        unreserve(size);
+        return;
+    }
+
+    auto& s     = shards_[current_shard(shard_count)];
+    auto  slack = s.slack.fetch_add(size, std::memory_order_relaxed) + size;
+    if (slack <= 2u * granularity_)
+        return;
+
+    // keep one step as slack and return the rest
+    while (slack > granularity_
+           && !s.slack.compare_exchange_weak(slack, granularity_, std::memory_order_relaxed))
+    {
+    }
+    if (slack > granularity_)
+        unreserve(slack - granularity_);
+}
+
+void memory_budget::trim() noexcept
+{
+    drain();
+}
+
+std::size_t memory_budget::usage() const noexcept
+{
+    std::size_t slack = 0u;
+    for (auto& s : shards_)
+        slack += s.slack.load(std::memory_order_relaxed);
+    auto reserved = reserved_.load(std::memory_order_relaxed);
+    // the counters are read one after the other, so clamp in case of concurrent updates
+    return reserved > slack ? reserved - slack : 0u;
+}
+
+bool memory_budget::reserve(std::size_t size, bool drain_on_failure) noexcept
+{
+    auto notify = drain_on_failure;
+    auto old    = reserved_.load(std::memory_order_relaxed);
+    do
+    {
+        if (old > hard_limit_ || size > hard_limit_ - old)
+        {
+            if (drain_on_failure)
+            {
+                // the slack of the shards might be enough, but only try it once
+                drain_on_failure = false;
+                drain();
+                old = reserved_.load(std::memory_order_relaxed);
+                if (old <= hard_limit_ && size <= hard_limit_ - old)
+                    continue;
+            }
+
+            if (notify && handler_)
+                handler_(*this, budget_limit::hard, old + size, user_data_);
+            return false;
+        }
+    } while (!reserved_.compare_exchange_weak(old, old + size, std::memory_order_relaxed));
+
+    if (parent_ && !parent_->reserve(size, notify))
+    {
+        reserved_.fetch_sub(size, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (old + size > soft_limit_ && !above_soft_limit_.exchange(true, std::memory_order_relaxed)
+        && handler_)
+        handler_(*this, budget_limit::soft, old + size, user_data_);
+    return true;
+}
+
+void memory_budget::unreserve(std::size_t size) noexcept
+{
+    auto old = reserved_.fetch_sub(size, std::memory_order_relaxed);
+    FOONATHAN_MEMORY_ASSERT(old >= size);
+    if (old - size <= soft_limit_)
+        above_soft_limit_.store(false, std::memory_order_relaxed);
+    if (parent_)
+        parent_->unreserve(size);
+}
+
+void memory_budget::drain() noexcept
+{
+    std::size_t slack = 0u;
+    for (auto& s : shards_)
+        slack += s.slack.exchange(0u, std::memory_order_relaxed);
+    if (slack != 0u)
+        unreserve(slack);
+}
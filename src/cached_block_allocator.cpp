@@ -0,0 +1,220 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "cached_block_allocator.hpp"
+
+#include <mutex>
+
+#include "detail/ilog2.hpp"
+#include "error.hpp"
+#include "heap_allocator.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    // the number of blocks of each size cached by a thread
+    constexpr std::size_t magazine_size = 4u;
+
+    std::size_t size_class(std::size_t size) noexcept
+    {
+        FOONATHAN_MEMORY_ASSERT(size <= detail::cached_block_max_size);
+        return detail::ilog2(size / detail::cached_block_min_size);
+    }
+
+    void*& next_block(void* block) noexcept
+    {
+        return *static_cast<void**>(block);
+    }
+
+    // the cache of the process, the blocks of each size form an intrusive list
+    struct block_depot
+    {
+        std::mutex  mutex;
+        void*       blocks[detail::cached_block_classes] = {};
+        std::size_t bytes                                = 0u;
+        std::size_t max_bytes                            = 64u * 1024u * 1024u;
+
+        ~block_depot() noexcept
+        {
+            for (auto i = 0u; i != detail::cached_block_classes; ++i)
+                release(i, blocks[i]);
+        }
+
+        static void release(std::size_t i, void* list) noexcept
+        {
+            while (list)
+            {
+                auto next = next_block(list);
+                heap_dealloc(list, detail::cached_block_min_size << i);
+                list = next;
+            }
+        }
+
+        // takes up to n blocks, returns the number taken
+        std::size_t take(std::size_t i, void** result, std::size_t n) noexcept
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto                        count = 0u;
+            for (; count != n && blocks[i]; ++count)
+            {
+                result[count] = blocks[i];
+                blocks[i]     = next_block(blocks[i]);
+                bytes -= detail::cached_block_min_size << i;
+            }
+            return count;
+        }
+
+        void put(std::size_t i, void** list, std::size_t n) noexcept
+        {
+            auto size = detail::cached_block_min_size << i;
+
+            void* excess = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (auto j = 0u; j != n; ++j)
+                    if (bytes + size <= max_bytes)
+                    {
+                        next_block(list[j]) = blocks[i];
+                        blocks[i]           = list[j];
+                        bytes += size;
+                    }
+                    else
+                    {
+                        next_block(list[j]) = excess;
+                        excess              = list[j];
+                    }
+            }
+            // freed without holding the lock
+            release(i, excess);
+        }
+
+        void trim() noexcept
+        {
+            void* lists[detail::cached_block_classes];
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (auto i = 0u; i != detail::cached_block_classes; ++i)
+                {
+                    lists[i]  = blocks[i];
+                    blocks[i] = nullptr;
+                }
+                bytes = 0u;
+            }
+            for (auto i = 0u; i != detail::cached_block_classes; ++i)
+                release(i, lists[i]);
+        }
+    };
+
+    block_depot& get_depot() noexcept
+    {
+        static block_depot depot;
+        return depot;
+    }
+
+    thread_local struct block_magazine
+    {
+        void*       blocks[detail::cached_block_classes][magazine_size];
+        std::size_t count[detail::cached_block_classes] = {};
+
+        ~block_magazine() noexcept
+        {
+            flush();
+        }
+
+        void flush() noexcept
+        {
+            for (auto i = 0u; i != detail::cached_block_classes; ++i)
+                if (count[i] != 0u)
+                {
+                    get_depot().put(i, blocks[i], count[i]);
+                    count[i] = 0u;
+                }
+        }
+    } magazine;
+} // namespace
+
+std::size_t detail::cached_block_size(std::size_t size) noexcept
+{
+    if (size <= cached_block_min_size)
+        return cached_block_min_size;
+    else if (size > cached_block_max_size)
+        return size;
+    return std::size_t(1u) << ilog2_ceil(size);
+}
+
+void* detail::allocate_cached_block(std::size_t size) noexcept
+{
+    if (size > cached_block_max_size)
+        return heap_alloc(size);
+
+    auto  i     = size_class(size);
+    auto& count = magazine.count[i];
+    if (count == 0u)
+        // refill half of the magazine at once
+        count = get_depot().take(i, magazine.blocks[i], magazine_size / 2u);
+    if (count == 0u)
+        return heap_alloc(size);
+    return magazine.blocks[i][--count];
+}
+
+void detail::deallocate_cached_block(void* memory, std::size_t size) noexcept
+{
+    if (size > cached_block_max_size)
+    {
+        heap_dealloc(memory, size);
+        return;
+    }
+
+    auto  i     = size_class(size);
+    auto& count = magazine.count[i];
+    if (count == magazine_size)
+    {
+        count -= magazine_size / 2u;
+        get_depot().put(i, magazine.blocks[i] + count, magazine_size / 2u);
+    }
+    magazine.blocks[i][count++] = memory;
+}
+
+void foonathan::memory::set_block_cache_limit(std::size_t max_bytes) noexcept
+{
+    auto&                       depot = get_depot();
+    std::lock_guard<std::mutex> lock(depot.mutex);
+    depot.max_bytes = max_bytes;
+}
+
+std::size_t foonathan::memory::block_cache_size() noexcept
+{
+    auto&                       depot = get_depot();
+    std::lock_guard<std::mutex> lock(depot.mutex);
+    return depot.bytes;
+}
+
+void foonathan::memory::trim_block_cache() noexcept
+{
+    magazine.flush();
+    get_depot().trim();
+}
+
+memory_block cached_block_allocator::allocate_block()
+{
+    auto memory = detail::allocate_cached_block(block_size_);
+    if (!memory)
+        FOONATHAN_THROW(
+            out_of_memory({FOONATHAN_MEMORY_LOG_PREFIX "::cached_block_allocator", this},
+                          block_size_));
+
+    memory_block block(memory, block_size_);
+    block_size_ *= 2u;
+    return block;
+}
+
+void cached_block_allocator::deallocate_block(memory_block block) noexcept
+{
+    detail::deallocate_cached_block(block.memory, block.size);
+}
+
+#if FOONATHAN_MEMORY_EXTERN_TEMPLATE
+template class foonathan::memory::memory_arena<cached_block_allocator, true>;
+template class foonathan::memory::memory_arena<cached_block_allocator, false>;
+#endif
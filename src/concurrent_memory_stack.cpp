@@ -0,0 +1,13 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "concurrent_memory_stack.hpp"
+
+using namespace foonathan::memory;
+
+#if FOONATHAN_MEMORY_EXTERN_TEMPLATE
+template class foonathan::memory::concurrent_memory_stack<>;
+template class foonathan::memory::memory_stack_raii_unwind<concurrent_memory_stack<>>;
+template class foonathan::memory::allocator_traits<concurrent_memory_stack<>>;
+template class foonathan::memory::composable_allocator_traits<concurrent_memory_stack<>>;
+#endif
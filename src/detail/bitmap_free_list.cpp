@@ -0,0 +1,352 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "detail/bitmap_free_list.hpp"
+
+#include <climits>
+#include <new>
+
+#include "detail/debug_helpers.hpp"
+#include "detail/assert.hpp"
+#include "detail/ilog2.hpp"
+#include "error.hpp"
+
+using namespace foonathan::memory;
+using namespace detail;
+
+namespace
+{
+    constexpr std::size_t   bits_per_word = 64u;
+    constexpr std::uint64_t all_free      = ~std::uint64_t(0);
+
+    std::size_t word_count(std::size_t no_nodes) noexcept
+    {
+        return (no_nodes + bits_per_word - 1u) / bits_per_word;
+    }
+
+    // index of the lowest set bit
+    // pre: bits != 0
+    std::size_t lowest_bit(std::uint64_t bits) noexcept
+    {
+        return ilog2(bits & (~bits + 1u));
+    }
+
+    // number of free nodes at the start and the end of a word that is not completely free
+    std::size_t trailing_ones(std::uint64_t bits) noexcept
+    {
+        return lowest_bit(~bits);
+    }
+
+    std::size_t leading_ones(std::uint64_t bits) noexcept
+    {
+        return bits_per_word - 1u - ilog2(~bits);
+    }
+
+    // bit i is set if the bits i to i + count - 1 are all set
+    // pre: count <= bits_per_word
+    std::uint64_t run_mask(std::uint64_t bits, std::size_t count) noexcept
+    {
+        // after each step bit i is set if the bits i to i + length - 1 are all set
+        for (std::size_t length = 1u; length < count && bits != 0u;)
+        {
+            auto shift = length < count - length ? length : count - length;
+            bits &= bits >> shift;
+            length += shift;
+        }
+        return bits;
+    }
+
+    // finds count free nodes next to each other
+    // returns the index of the first one or block->no_nodes if there are none
+    std::size_t find_run(bitmap_block* block, std::size_t count) noexcept
+    {
+        auto bitmap = block->bitmap();
+        auto words  = word_count(block->no_nodes);
+
+        // the run of free nodes that goes up to the current word
+        std::size_t run = 0u, start = 0u;
+        for (auto i = block->first_free; i != words; ++i)
+        {
+            auto bits = bitmap[i];
+            if (bits == all_free)
+            {
+                if (run == 0u)
+                    start = i * bits_per_word;
+                run += bits_per_word;
+                if (run >= count)
+                    return start;
+                continue;
+            }
+
+            if (run != 0u && run + trailing_ones(bits) >= count)
+                return start;
+            if (count <= bits_per_word)
+            {
+                if (auto mask = run_mask(bits, count))
+                    return i * bits_per_word + lowest_bit(mask);
+            }
+
+            // the free nodes at the end of the word start a new run
+            run   = leading_ones(bits);
+            start = (i + 1u) * bits_per_word - run;
+        }
+        return block->no_nodes;
+    }
+
+    // marks count nodes starting at index as free or in use
+    void mark_range(bitmap_block* block, std::size_t index, std::size_t count, bool free) noexcept
+    {
+        auto bitmap = block->bitmap();
+        for (auto end = index + count; index != end;)
+        {
+            auto bit   = index % bits_per_word;
+            auto n     = bits_per_word - bit < end - index ? bits_per_word - bit : end - index;
+            auto range = (n == bits_per_word ? all_free : (std::uint64_t(1) << n) - 1u) << bit;
+
+            auto& word = bitmap[index / bits_per_word];
+            if (free)
+                word |= range;
+            else
+                word &= ~range;
+            index += n;
+        }
+    }
+
+    allocator_info info(const bitmap_free_memory_list* list) noexcept
+    {
+        return {FOONATHAN_MEMORY_LOG_PREFIX "::detail::bitmap_free_memory_list", list};
+    }
+} // namespace
+
+constexpr std::size_t bitmap_free_memory_list::min_element_size;
+constexpr std::size_t bitmap_free_memory_list::min_element_alignment;
+constexpr std::size_t bitmap_free_memory_list::bits_per_word;
+
+bitmap_free_memory_list::bitmap_free_memory_list(std::size_t node_size) noexcept
+: first_(nullptr),
+  alloc_block_(nullptr),
+  dealloc_block_(nullptr),
+  node_size_(node_size < min_element_size ? min_element_size : node_size),
+  capacity_(0u)
+{
+}
+
+bitmap_free_memory_list::bitmap_free_memory_list(std::size_t node_size, void* mem,
+                                                 std::size_t size) noexcept
+: bitmap_free_memory_list(node_size)
+{
+    insert(mem, size);
+}
+
+bitmap_free_memory_list::bitmap_free_memory_list(bitmap_free_memory_list&& other) noexcept
+: first_(other.first_),
+  alloc_block_(other.alloc_block_),
+  dealloc_block_(other.dealloc_block_),
+  node_size_(other.node_size_),
+  capacity_(other.capacity_)
+{
+    other.first_ = other.alloc_block_ = other.dealloc_block_ = nullptr;
+    other.capacity_                                          = 0u;
+}
+
+bitmap_free_memory_list& bitmap_free_memory_list::operator=(
+    bitmap_free_memory_list&& other) noexcept
+{
+    bitmap_free_memory_list tmp(detail::move(other));
+    swap(*this, tmp);
+    return *this;
+}
+
+void foonathan::memory::detail::swap(bitmap_free_memory_list& a,
+                                     bitmap_free_memory_list& b) noexcept
+{
+    detail::adl_swap(a.first_, b.first_);
+    detail::adl_swap(a.alloc_block_, b.alloc_block_);
+    detail::adl_swap(a.dealloc_block_, b.dealloc_block_);
+    detail::adl_swap(a.node_size_, b.node_size_);
+    detail::adl_swap(a.capacity_, b.capacity_);
+}
+
+void bitmap_free_memory_list::insert(void* mem, std::size_t size) noexcept
+{
+    FOONATHAN_MEMORY_ASSERT(mem);
+    FOONATHAN_MEMORY_ASSERT(is_aligned(mem, max_alignment));
+    detail::debug_fill_internal(mem, size, false);
+
+    auto no = no_nodes(size);
+    FOONATHAN_MEMORY_ASSERT(no > 0u);
+
+    auto block        = ::new (mem) bitmap_block;
+    block->next       = first_;
+    block->nodes      = static_cast<char*>(mem) + header_size(no, alignment());
+    block->no_nodes   = no;
+    block->capacity   = no;
+    block->first_free = 0u;
+
+    // the bits after the last node are never set, so runs stop at the end of the block
+    auto bitmap = block->bitmap();
+    auto words  = word_count(no);
+    for (std::size_t i = 0u; i != words; ++i)
+        bitmap[i] = all_free;
+    if (no % bits_per_word != 0u)
+        bitmap[words - 1u] = (std::uint64_t(1) << no % bits_per_word) - 1u;
+
+    first_ = block;
+    capacity_ += no;
+}
+
+void* bitmap_free_memory_list::allocate() noexcept
+{
+    FOONATHAN_MEMORY_ASSERT(!empty());
+
+    auto block = alloc_block_;
+    if (!block || block->capacity == 0u)
+    {
+        block = first_;
+        while (block->capacity == 0u)
+            block = block->next;
+        alloc_block_ = block;
+    }
+
+    auto bitmap = block->bitmap();
+    auto word   = block->first_free;
+    while (bitmap[word] == 0u)
+        ++word;
+    block->first_free = word;
+
+    auto index = word * bits_per_word + lowest_bit(bitmap[word]);
+    bitmap[word] &= bitmap[word] - 1u; // clear the lowest set bit
+    --block->capacity;
+    --capacity_;
+
+    return debug_fill_new(block->nodes + index * node_size_, node_size_, 0);
+}
+
+void* bitmap_free_memory_list::allocate(std::size_t n) noexcept
+{
+    if (n <= node_size_)
+        return empty() ? nullptr : allocate();
+
+    auto count = (n + node_size_ - 1u) / node_size_;
+    for (auto block = first_; block; block = block->next)
+    {
+        if (block->capacity < count)
+            continue;
+
+        auto index = find_run(block, count);
+        if (index == block->no_nodes)
+            continue;
+
+        mark_range(block, index, count, false);
+        block->capacity -= count;
+        capacity_ -= count;
+        return debug_fill_new(block->nodes + index * node_size_, n, 0);
+    }
+    return nullptr;
+}
+
+void bitmap_free_memory_list::deallocate(void* ptr) noexcept
+{
+    auto node  = static_cast<char*>(debug_fill_free(ptr, node_size_, 0));
+    auto block = find_block(node);
+    debug_check_pointer([&]
+                        { return block && std::size_t(node - block->nodes) % node_size_ == 0u; },
+                        info(this), ptr);
+
+    auto index = std::size_t(node - block->nodes) / node_size_;
+    auto word  = index / bits_per_word;
+    auto bit   = std::uint64_t(1) << index % bits_per_word;
+    debug_check_double_dealloc([&] { return (block->bitmap()[word] & bit) == 0u; }, info(this),
+                               ptr);
+
+    block->bitmap()[word] |= bit;
+    if (word < block->first_free)
+        block->first_free = word;
+    ++block->capacity;
+    ++capacity_;
+}
+
+void bitmap_free_memory_list::deallocate(void* ptr, std::size_t n) noexcept
+{
+    if (n <= node_size_)
+    {
+        deallocate(ptr);
+        return;
+    }
+
+    auto node  = static_cast<char*>(debug_fill_free(ptr, n, 0));
+    auto block = find_block(node);
+    debug_check_pointer([&]
+                        { return block && std::size_t(node - block->nodes) % node_size_ == 0u; },
+                        info(this), ptr);
+
+    auto index = std::size_t(node - block->nodes) / node_size_;
+    auto count = (n + node_size_ - 1u) / node_size_;
+    mark_range(block, index, count, true);
+    if (index / bits_per_word < block->first_free)
+        block->first_free = index / bits_per_word;
+    block->capacity += count;
+    capacity_ += count;
+}
+
+void* bitmap_free_memory_list::remove_empty_block() noexcept
+{
+    auto block = dealloc_block_;
+    if (!block || block->capacity != block->no_nodes || block->capacity == capacity_)
+        return nullptr;
+
+    auto link = &first_;
+    while (*link != block)
+        link = &(*link)->next;
+    *link = block->next;
+
+    if (alloc_block_ == block)
+        alloc_block_ = nullptr;
+    dealloc_block_ = nullptr;
+    capacity_ -= block->no_nodes;
+    return block;
+}
+
+std::size_t bitmap_free_memory_list::alignment() const noexcept
+{
+    return alignment_for(node_size_);
+}
+
+std::size_t bitmap_free_memory_list::no_nodes(std::size_t size) const noexcept
+{
+    if (size <= sizeof(bitmap_block))
+        return 0u;
+
+    // each node needs one bit in addition to its size,
+    // start with that estimate and remove nodes until the aligned header fits as well
+    auto no = (size - sizeof(bitmap_block)) * CHAR_BIT / (node_size_ * CHAR_BIT + 1u);
+    while (no != 0u && header_size(no, alignment()) + no * node_size_ > size)
+        --no;
+    return no;
+}
+
+bitmap_block* bitmap_free_memory_list::find_block(char* node) noexcept
+{
+    auto contains = [&](bitmap_block* block)
+    { return block->nodes <= node && node < block->nodes + block->no_nodes * node_size_; };
+
+    if (dealloc_block_ && contains(dealloc_block_))
+        return dealloc_block_;
+
+    for (bitmap_block *block = first_, *prev = nullptr; block; prev = block, block = block->next)
+    {
+        if (contains(block))
+        {
+            if (prev)
+            {
+                // move to front, blocks with recent deallocations are likely to get more
+                prev->next  = block->next;
+                block->next = first_;
+                first_      = block;
+            }
+            dealloc_block_ = block;
+            return block;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,287 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "detail/buddy_system.hpp"
+
+#include <new>
+
+#include "detail/debug_helpers.hpp"
+#include "detail/assert.hpp"
+#include "detail/ilog2.hpp"
+#include "error.hpp"
+
+using namespace foonathan::memory;
+using namespace detail;
+
+namespace
+{
+    constexpr std::size_t bits_per_word = 64u;
+
+    // the number of bits of all orders for a block with size bytes of nodes
+    std::size_t bit_count(std::size_t size, std::size_t log2_node_size) noexcept
+    {
+        std::size_t result = 0u;
+        for (auto nodes = size >> log2_node_size; nodes != 0u; nodes /= 2u)
+            result += nodes;
+        return result;
+    }
+
+    std::size_t descriptor_size(std::size_t size, std::size_t log2_node_size) noexcept
+    {
+        auto words = (bit_count(size, log2_node_size) + bits_per_word - 1u) / bits_per_word;
+        return sizeof(buddy_block) + words * sizeof(std::uint64_t);
+    }
+
+    // the bit of the node at the given offset with the given order
+    std::size_t bit_index(const buddy_block* block, std::size_t offset, std::size_t order,
+                          std::size_t log2_node_size) noexcept
+    {
+        return block->bit_offset[order] + (offset >> (log2_node_size + order));
+    }
+
+    bool test_bit(buddy_block* block, std::size_t index) noexcept
+    {
+        return (block->bitmap()[index / bits_per_word] >> index % bits_per_word & 1u) != 0u;
+    }
+
+    // the index of the lowest set bit
+    // pre: bits != 0
+    std::size_t lowest_bit(std::size_t bits) noexcept
+    {
+        return ilog2(bits & (~bits + 1u));
+    }
+
+    allocator_info info(const buddy_system* list) noexcept
+    {
+        return {FOONATHAN_MEMORY_LOG_PREFIX "::detail::buddy_system", list};
+    }
+} // namespace
+
+constexpr std::size_t buddy_block::max_orders;
+constexpr std::size_t buddy_system::max_orders;
+constexpr std::size_t buddy_system::min_element_size;
+
+buddy_system::buddy_system(std::size_t node_size) noexcept
+: first_(nullptr),
+  log2_node_size_(ilog2_ceil(node_size < min_element_size ? min_element_size : node_size)),
+  capacity_(0u),
+  managed_(0u),
+  non_empty_(0u)
+{
+    for (auto& head : free_)
+        head = nullptr;
+}
+
+buddy_system::buddy_system(buddy_system&& other) noexcept
+: first_(other.first_),
+  log2_node_size_(other.log2_node_size_),
+  capacity_(other.capacity_),
+  managed_(other.managed_),
+  non_empty_(other.non_empty_)
+{
+    for (std::size_t i = 0u; i != max_orders; ++i)
+    {
+        free_[i]       = other.free_[i];
+        other.free_[i] = nullptr;
+    }
+    other.first_    = nullptr;
+    other.capacity_ = other.managed_ = other.non_empty_ = 0u;
+}
+
+buddy_system& buddy_system::operator=(buddy_system&& other) noexcept
+{
+    buddy_system tmp(detail::move(other));
+    swap(*this, tmp);
+    return *this;
+}
+
+void foonathan::memory::detail::swap(buddy_system& a, buddy_system& b) noexcept
+{
+    for (std::size_t i = 0u; i != buddy_system::max_orders; ++i)
+        detail::adl_swap(a.free_[i], b.free_[i]);
+    detail::adl_swap(a.first_, b.first_);
+    detail::adl_swap(a.log2_node_size_, b.log2_node_size_);
+    detail::adl_swap(a.capacity_, b.capacity_);
+    detail::adl_swap(a.managed_, b.managed_);
+    detail::adl_swap(a.non_empty_, b.non_empty_);
+}
+
+void buddy_system::insert(void* mem, std::size_t size) noexcept
+{
+    FOONATHAN_MEMORY_ASSERT(mem);
+    FOONATHAN_MEMORY_ASSERT(is_aligned(mem, max_alignment));
+    detail::debug_fill_internal(mem, size, false);
+
+    auto usable = usable_size(size);
+    FOONATHAN_MEMORY_ASSERT(usable > 0u);
+
+    auto block   = ::new (static_cast<char*>(mem) + usable) buddy_block;
+    block->next  = first_;
+    block->begin = static_cast<char*>(mem);
+    block->size  = usable;
+
+    std::size_t bits = 0u;
+    for (std::size_t order = 0u; order != max_orders; ++order)
+    {
+        block->bit_offset[order] = bits;
+        if (log2_node_size_ + order < max_orders)
+            bits += usable >> (log2_node_size_ + order);
+    }
+    auto words = (bits + bits_per_word - 1u) / bits_per_word;
+    for (std::size_t i = 0u; i != words; ++i)
+        block->bitmap()[i] = 0u;
+    first_ = block;
+
+    // one free node per set bit of the size, the biggest first,
+    // so every node is aligned for its size relative to the beginning
+    std::size_t offset = 0u;
+    for (auto order = max_orders; order-- != 0u;)
+    {
+        auto size_of_order = node_size() << order;
+        if (order + log2_node_size_ < max_orders && (usable & size_of_order) != 0u)
+        {
+            push(block, block->begin + offset, order);
+            offset += size_of_order;
+        }
+    }
+
+    capacity_ += usable;
+    managed_ += usable;
+}
+
+std::size_t buddy_system::usable_size(std::size_t size) const noexcept
+{
+    auto min_size = sizeof(buddy_block) + sizeof(std::uint64_t);
+    if (size < min_size + node_size())
+        return 0u;
+
+    // every node needs about two bits, so a quarter byte per node size
+    auto factor = 4u * node_size();
+    auto result = (size - min_size) / (factor + 1u) * factor;
+    while (result != 0u && result + descriptor_size(result, log2_node_size_) > size)
+        result -= node_size();
+    return result;
+}
+
+std::size_t buddy_system::max_node_size(std::size_t size) const noexcept
+{
+    auto usable = usable_size(size);
+    return usable == 0u ? 0u : std::size_t(1u) << ilog2(usable);
+}
+
+void* buddy_system::allocate(std::size_t n) noexcept
+{
+    auto order = order_of(n);
+    if (order >= max_orders)
+        return nullptr;
+
+    auto orders = non_empty_ >> order << order;
+    if (orders == 0u)
+        return nullptr;
+
+    auto free_order = lowest_bit(orders);
+    auto node       = reinterpret_cast<char*>(free_[free_order]);
+    auto block      = find_block(node);
+    erase(block, node, free_order);
+
+    // the upper halves become free nodes of the lower orders
+    while (free_order != order)
+    {
+        --free_order;
+        push(block, node + (node_size() << free_order), free_order);
+    }
+
+    capacity_ -= node_size() << order;
+    return debug_fill_new(node, n, 0);
+}
+
+void buddy_system::deallocate(void* ptr, std::size_t n) noexcept
+{
+    auto node  = static_cast<char*>(debug_fill_free(ptr, n, 0));
+    auto block = find_block(node);
+    auto order = order_of(n);
+    debug_check_pointer(
+        [&]
+        {
+            return block && order < max_orders
+                   && std::size_t(node - block->begin) % (node_size() << order) == 0u
+                   && std::size_t(node - block->begin) + (node_size() << order) <= block->size;
+        },
+        info(this), ptr);
+
+    auto offset = std::size_t(node - block->begin);
+    debug_check_double_dealloc(
+        [&] { return !test_bit(block, bit_index(block, offset, order, log2_node_size_)); },
+        info(this), ptr);
+    capacity_ += node_size() << order;
+
+    // merge with the buddy as long as it is free and the parent is in the block
+    for (; order + 1u < max_orders; ++order)
+    {
+        auto size   = node_size() << order;
+        auto parent = offset & ~size;
+        if (parent + 2u * size > block->size)
+            break;
+
+        auto buddy = offset ^ size;
+        if (!test_bit(block, bit_index(block, buddy, order, log2_node_size_)))
+            break;
+
+        erase(block, block->begin + buddy, order);
+        offset = parent;
+    }
+    push(block, block->begin + offset, order);
+}
+
+bool buddy_system::owns(const void* ptr) const noexcept
+{
+    return find_block(static_cast<const char*>(ptr)) != nullptr;
+}
+
+std::size_t buddy_system::max_free_size() const noexcept
+{
+    return non_empty_ == 0u ? 0u : node_size() << ilog2(non_empty_);
+}
+
+std::size_t buddy_system::order_of(std::size_t n) const noexcept
+{
+    return n <= node_size() ? 0u : ilog2_ceil(n) - log2_node_size_;
+}
+
+buddy_block* buddy_system::find_block(const char* node) const noexcept
+{
+    for (auto block = first_; block; block = block->next)
+        if (block->begin <= node && node < block->begin + block->size)
+            return block;
+    return nullptr;
+}
+
+void buddy_system::push(buddy_block* block, char* node, std::size_t order) noexcept
+{
+    auto index = bit_index(block, std::size_t(node - block->begin), order, log2_node_size_);
+    block->bitmap()[index / bits_per_word] |= std::uint64_t(1) << index % bits_per_word;
+
+    auto free  = ::new (static_cast<void*>(node)) free_node;
+    free->prev = nullptr;
+    free->next = free_[order];
+    if (free->next)
+        free->next->prev = free;
+    free_[order] = free;
+    non_empty_ |= std::size_t(1u) << order;
+}
+
+void buddy_system::erase(buddy_block* block, char* node, std::size_t order) noexcept
+{
+    auto index = bit_index(block, std::size_t(node - block->begin), order, log2_node_size_);
+    block->bitmap()[index / bits_per_word] &= ~(std::uint64_t(1) << index % bits_per_word);
+
+    auto free = reinterpret_cast<free_node*>(node);
+    if (free->prev)
+        free->prev->next = free->next;
+    else
+        free_[order] = free->next;
+    if (free->next)
+        free->next->prev = free->prev;
+    if (!free_[order])
+        non_empty_ &= ~(std::size_t(1u) << order);
+}
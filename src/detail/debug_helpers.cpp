@@ -4,11 +4,33 @@
 #include "detail/debug_helpers.hpp"
 
 #if FOONATHAN_HOSTED_IMPLEMENTATION
+#include <cstdint>
 #include <cstring>
 #endif
 
 #include "debugging.hpp"
 
+#if FOONATHAN_MEMORY_DEBUG_POISON
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define FOONATHAN_MEMORY_IMPL_ASAN 1
+#endif
+#endif
+#if !defined(FOONATHAN_MEMORY_IMPL_ASAN) && defined(__SANITIZE_ADDRESS__)
+#define FOONATHAN_MEMORY_IMPL_ASAN 1
+#endif
+#if defined(FOONATHAN_MEMORY_IMPL_ASAN)
+#include <sanitizer/asan_interface.h>
+#endif
+
+#if defined(__has_include)
+#if __has_include(<valgrind/memcheck.h>)
+#include <valgrind/memcheck.h>
+#define FOONATHAN_MEMORY_IMPL_VALGRIND 1
+#endif
+#endif
+#endif
+
 using namespace foonathan::memory;
 using namespace detail;
 
@@ -25,10 +47,35 @@ void detail::debug_fill(void* memory, std::size_t size, debug_magic m) noexcept
 #endif
 }
 
+#if FOONATHAN_HOSTED_IMPLEMENTATION
+namespace
+{
+    std::uint64_t load_word(const unsigned char* ptr) noexcept
+    {
+        std::uint64_t word;
+        std::memcpy(&word, ptr, sizeof(word));
+        return word;
+    }
+} // namespace
+#endif
+
 void* detail::debug_is_filled(void* memory, std::size_t size, debug_magic m) noexcept
 {
     auto byte = static_cast<unsigned char*>(memory);
-    for (auto end = byte + size; byte != end; ++byte)
+    auto end  = byte + size;
+#if FOONATHAN_HOSTED_IMPLEMENTATION
+    // compare four words at once, the compiler can turn it into vector instructions,
+    // and leave a block with a mismatch to the byte loop to find the exact address
+    auto pattern = std::uint64_t(static_cast<unsigned char>(m)) * 0x0101010101010101u;
+    for (; end - byte >= 32; byte += 32)
+    {
+        auto diff = (load_word(byte) ^ pattern) | (load_word(byte + 8) ^ pattern)
+                    | (load_word(byte + 16) ^ pattern) | (load_word(byte + 24) ^ pattern);
+        if (diff != 0u)
+            break;
+    }
+#endif
+    for (; byte != end; ++byte)
         if (*byte != static_cast<unsigned char>(m))
             return byte;
     return nullptr;
@@ -75,6 +122,50 @@ void detail::debug_fill_internal(void* memory, std::size_t size, bool free) noex
 }
 #endif
 
+#if FOONATHAN_MEMORY_DEBUG_POISON
+void detail::debug_poison(const void* memory, std::size_t size) noexcept
+{
+#if defined(FOONATHAN_MEMORY_IMPL_ASAN)
+    __asan_poison_memory_region(memory, size);
+#endif
+#if defined(FOONATHAN_MEMORY_IMPL_VALGRIND)
+    VALGRIND_MAKE_MEM_NOACCESS(memory, size);
+#endif
+    (void)memory;
+    (void)size;
+}
+
+void detail::debug_unpoison(const void* memory, std::size_t size) noexcept
+{
+#if defined(FOONATHAN_MEMORY_IMPL_ASAN)
+    __asan_unpoison_memory_region(memory, size);
+#endif
+#if defined(FOONATHAN_MEMORY_IMPL_VALGRIND)
+    VALGRIND_MAKE_MEM_UNDEFINED(memory, size);
+#endif
+    (void)memory;
+    (void)size;
+}
+
+bool detail::debug_is_poisoned(const void* memory) noexcept
+{
+#if defined(FOONATHAN_MEMORY_IMPL_ASAN)
+    return __asan_address_is_poisoned(memory) != 0;
+#else
+    (void)memory;
+    return false;
+#endif
+}
+#endif
+
+std::size_t detail::leak_counter_shard() noexcept
+{
+    static std::atomic<std::size_t> next_shard(0u);
+    thread_local const std::size_t  shard =
+        next_shard.fetch_add(1u, std::memory_order_relaxed) % leak_counter_shard_count;
+    return shard;
+}
+
 void detail::debug_handle_invalid_ptr(const allocator_info& info, void* ptr)
 {
     get_invalid_pointer_handler()(info, ptr);
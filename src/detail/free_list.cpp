@@ -3,9 +3,12 @@
 
 #include "detail/free_list.hpp"
 
+#include <cstring>
+
 #include "detail/align.hpp"
 #include "detail/debug_helpers.hpp"
 #include "detail/assert.hpp"
+#include "detail/ilog2.hpp"
 #include "debugging.hpp"
 #include "error.hpp"
 
@@ -16,6 +19,12 @@ using namespace detail;
 
 namespace
 {
+    // poisons a node in a free_memory_list except for the pointer to the next one
+    void poison_node(char* node, std::size_t node_size) noexcept
+    {
+        debug_poison(node + sizeof(char*), node_size - sizeof(char*));
+    }
+
     // i.e. array
     struct interval
     {
@@ -125,8 +134,11 @@ constexpr std::size_t free_memory_list::min_element_alignment;
 
 free_memory_list::free_memory_list(std::size_t node_size) noexcept
 : first_(nullptr),
+  untouched_(nullptr),
+  untouched_end_(nullptr),
   node_size_(node_size > min_element_size ? node_size : min_element_size),
-  capacity_(0u)
+  capacity_(0u),
+  untouched_zeroed_(false)
 {
 }
 
@@ -137,10 +149,17 @@ free_memory_list::free_memory_list(std::size_t node_size, void* mem, std::size_t
 }
 
 free_memory_list::free_memory_list(free_memory_list&& other) noexcept
-: first_(other.first_), node_size_(other.node_size_), capacity_(other.capacity_)
+: first_(other.first_),
+  untouched_(other.untouched_),
+  untouched_end_(other.untouched_end_),
+  node_size_(other.node_size_),
+  capacity_(other.capacity_),
+  untouched_zeroed_(other.untouched_zeroed_)
 {
-    other.first_    = nullptr;
-    other.capacity_ = 0u;
+    other.first_         = nullptr;
+    other.untouched_     = nullptr;
+    other.untouched_end_ = nullptr;
+    other.capacity_      = 0u;
 }
 
 free_memory_list& free_memory_list::operator=(free_memory_list&& other) noexcept
@@ -153,17 +172,37 @@ free_memory_list& free_memory_list::operator=(free_memory_list&& other) noexcept
 void foonathan::memory::detail::swap(free_memory_list& a, free_memory_list& b) noexcept
 {
     detail::adl_swap(a.first_, b.first_);
+    detail::adl_swap(a.untouched_, b.untouched_);
+    detail::adl_swap(a.untouched_end_, b.untouched_end_);
     detail::adl_swap(a.node_size_, b.node_size_);
     detail::adl_swap(a.capacity_, b.capacity_);
+    detail::adl_swap(a.untouched_zeroed_, b.untouched_zeroed_);
 }
 
-void free_memory_list::insert(void* mem, std::size_t size) noexcept
+void free_memory_list::insert(void* mem, std::size_t size, bool zeroed) noexcept
 {
     FOONATHAN_MEMORY_ASSERT(mem);
     FOONATHAN_MEMORY_ASSERT(is_aligned(mem, alignment()));
+    // the memory may still be poisoned by a previous owner
+    detail::debug_unpoison(mem, size);
     detail::debug_fill_internal(mem, size, false);
 
-    insert_impl(mem, size);
+    auto no_nodes = size / node_size_;
+    FOONATHAN_MEMORY_ASSERT(no_nodes > 0);
+
+    // only one untouched region is kept, the old one is usually empty
+    if (untouched_ != untouched_end_)
+    {
+        auto old_size = static_cast<std::size_t>(untouched_end_ - untouched_);
+        capacity_ -= old_size / node_size_;
+        insert_impl(untouched_, old_size);
+    }
+
+    untouched_        = static_cast<char*>(mem);
+    untouched_end_    = untouched_ + no_nodes * node_size_;
+    untouched_zeroed_ = zeroed;
+    detail::debug_poison(untouched_, no_nodes * node_size_);
+    capacity_ += no_nodes;
 }
 
 void* free_memory_list::allocate() noexcept
@@ -171,20 +210,56 @@ void* free_memory_list::allocate() noexcept
     FOONATHAN_MEMORY_ASSERT(!empty());
     --capacity_;
 
-    auto mem = first_;
-    first_   = list_get_next(first_);
+    char* mem;
+    if (first_)
+    {
+        mem    = first_;
+        first_ = list_get_next(first_);
+        // the next allocation reads the pointer stored in the new first node,
+        // after churn it is likely not in the cache anymore
+        if (first_)
+            list_prefetch(first_);
+    }
+    else
+    {
+        mem = untouched_;
+        untouched_ += node_size_;
+    }
+    detail::debug_unpoison(mem, node_size_);
     return detail::debug_fill_new(mem, node_size_, 0);
 }
 
+void* free_memory_list::allocate_zeroed() noexcept
+{
+    // the nodes of the untouched region have never been written
+    auto zeroed = first_ == nullptr && untouched_zeroed_;
+    auto mem    = allocate();
+    if (!zeroed)
+        std::memset(mem, 0, node_size_);
+    return mem;
+}
+
 void* free_memory_list::allocate(std::size_t n) noexcept
 {
     FOONATHAN_MEMORY_ASSERT(!empty());
     if (n <= node_size_)
         return allocate();
 
-    auto i = list_search_array(first_, n, node_size_);
+    auto i = first_ ? list_search_array(first_, n, node_size_) : interval{};
     if (i.first == nullptr)
-        return nullptr;
+    {
+        // the untouched region is contiguous
+        auto no_nodes = (n + node_size_ - 1u) / node_size_;
+        if (untouched_capacity() < no_nodes)
+            return nullptr;
+
+        auto mem = untouched_;
+        untouched_ += no_nodes * node_size_;
+        capacity_ -= no_nodes;
+
+        detail::debug_unpoison(mem, n);
+        return detail::debug_fill_new(mem, n, 0);
+    }
 
     if (i.prev)
         list_set_next(i.prev, i.next); // change next from previous to first after
@@ -192,6 +267,7 @@ void* free_memory_list::allocate(std::size_t n) noexcept
         first_ = i.next;
     capacity_ -= i.size(node_size_);
 
+    detail::debug_unpoison(i.first, n);
     return detail::debug_fill_new(i.first, n, 0);
 }
 
@@ -201,6 +277,7 @@ void free_memory_list::deallocate(void* ptr) noexcept
 
     auto node = static_cast<char*>(detail::debug_fill_free(ptr, node_size_, 0));
     list_set_next(node, first_);
+    poison_node(node, node_size_);
     first_ = node;
 }
 
@@ -215,6 +292,58 @@ void free_memory_list::deallocate(void* ptr, std::size_t n) noexcept
     }
 }
 
+void free_memory_list::visit(free_node_visitor f, void* context) const noexcept
+{
+    for (auto cur = first_; cur; cur = list_get_next(cur))
+        f(context, cur, 1u);
+    if (untouched_ != untouched_end_)
+        f(context, untouched_, untouched_capacity());
+}
+
+void free_memory_list::remove_if(free_node_filter f, void* context) noexcept
+{
+    // the last node that is kept and whether the nodes after it were removed
+    char* kept    = nullptr;
+    auto  removed = false;
+    for (auto cur = first_; cur;)
+    {
+        auto next = list_get_next(cur);
+        if (f(context, cur))
+        {
+            --capacity_;
+            removed = true;
+        }
+        else
+        {
+            if (removed)
+            {
+                if (kept)
+                    list_set_next(kept, cur);
+                else
+                    first_ = cur;
+                removed = false;
+            }
+            kept = cur;
+        }
+        cur = next;
+    }
+    if (removed)
+    {
+        if (kept)
+            list_set_next(kept, nullptr);
+        else
+            first_ = nullptr;
+    }
+
+    if (untouched_ != untouched_end_ && f(context, untouched_))
+    {
+        capacity_ -= untouched_capacity();
+        untouched_        = nullptr;
+        untouched_end_    = nullptr;
+        untouched_zeroed_ = false;
+    }
+}
+
 std::size_t free_memory_list::alignment() const noexcept
 {
     return alignment_for(node_size_);
@@ -224,19 +353,187 @@ void free_memory_list::insert_impl(void* mem, std::size_t size) noexcept
 {
     auto no_nodes = size / node_size_;
     FOONATHAN_MEMORY_ASSERT(no_nodes > 0);
+    // the old untouched region is still poisoned
+    detail::debug_unpoison(mem, no_nodes * node_size_);
 
     auto cur = static_cast<char*>(mem);
     for (std::size_t i = 0u; i != no_nodes - 1; ++i)
     {
         list_set_next(cur, cur + node_size_);
+        poison_node(cur, node_size_);
         cur += node_size_;
     }
     list_set_next(cur, first_);
+    poison_node(cur, node_size_);
     first_ = static_cast<char*>(mem);
 
     capacity_ += no_nodes;
 }
 
+void cache_aligned_free_memory_list::insert(void* mem, std::size_t size, bool zeroed) noexcept
+{
+    auto offset = align_offset(mem, cache_line_size);
+    FOONATHAN_MEMORY_ASSERT(offset < size);
+    free_memory_list::insert(static_cast<char*>(mem) + offset, size - offset, zeroed);
+}
+
+constexpr std::size_t concurrent_free_memory_list::min_element_size;
+constexpr std::size_t concurrent_free_memory_list::min_element_alignment;
+
+concurrent_free_memory_list::concurrent_free_memory_list(std::size_t node_size) noexcept
+: first_(tagged_ptr{}),
+  capacity_(0u),
+  node_size_(node_size > min_element_size ? node_size : min_element_size)
+{
+}
+
+concurrent_free_memory_list::concurrent_free_memory_list(std::size_t node_size, void* mem,
+                                                         std::size_t size) noexcept
+: concurrent_free_memory_list(node_size)
+{
+    insert(mem, size);
+}
+
+concurrent_free_memory_list::concurrent_free_memory_list(
+    concurrent_free_memory_list&& other) noexcept
+: first_(other.first_.load()), capacity_(other.capacity_.load()), node_size_(other.node_size_)
+{
+    other.first_.store(tagged_ptr{});
+    other.capacity_.store(0u);
+}
+
+concurrent_free_memory_list& concurrent_free_memory_list::operator=(
+    concurrent_free_memory_list&& other) noexcept
+{
+    concurrent_free_memory_list tmp(detail::move(other));
+    swap(*this, tmp);
+    return *this;
+}
+
+void foonathan::memory::detail::swap(concurrent_free_memory_list& a,
+                                     concurrent_free_memory_list& b) noexcept
+{
+    a.first_.store(b.first_.exchange(a.first_.load()));
+    a.capacity_.store(b.capacity_.exchange(a.capacity_.load()));
+    detail::adl_swap(a.node_size_, b.node_size_);
+}
+
+void concurrent_free_memory_list::insert(void* mem, std::size_t size) noexcept
+{
+    FOONATHAN_MEMORY_ASSERT(mem);
+    FOONATHAN_MEMORY_ASSERT(is_aligned(mem, alignment()));
+    detail::debug_fill_internal(mem, size, false);
+
+    auto no_nodes = size / node_size_;
+    FOONATHAN_MEMORY_ASSERT(no_nodes > 0);
+
+    auto cur = static_cast<char*>(mem);
+    for (std::size_t i = 0u; i != no_nodes - 1; ++i)
+    {
+        list_set_next(cur, cur + node_size_);
+        cur += node_size_;
+    }
+    push(static_cast<char*>(mem), cur, no_nodes);
+}
+
+void* concurrent_free_memory_list::allocate() noexcept
+{
+    auto first = first_.load(std::memory_order_acquire);
+    while (auto node = get_ptr(first))
+    {
+        // note: the node might be allocated and modified by another thread in the meantime,
+        // but then the tag has changed and the exchange fails
+        auto next = next_tagged(first, list_get_next(node));
+        if (first_.compare_exchange_weak(first, next, std::memory_order_acquire,
+                                         std::memory_order_acquire))
+        {
+            capacity_.fetch_sub(1u, std::memory_order_relaxed);
+            return detail::debug_fill_new(node, node_size_, 0);
+        }
+    }
+    return nullptr;
+}
+
+void* concurrent_free_memory_list::allocate(std::size_t n) noexcept
+{
+    return n <= node_size_ ? allocate() : nullptr;
+}
+
+void concurrent_free_memory_list::deallocate(void* ptr) noexcept
+{
+    auto node = static_cast<char*>(detail::debug_fill_free(ptr, node_size_, 0));
+    push(node, node, 1u);
+}
+
+void concurrent_free_memory_list::deallocate(void* ptr, std::size_t n) noexcept
+{
+    if (n <= node_size_)
+        deallocate(ptr);
+    else
+    {
+        auto mem = detail::debug_fill_free(ptr, n, 0);
+        insert(mem, n);
+    }
+}
+
+std::size_t concurrent_free_memory_list::alignment() const noexcept
+{
+    return alignment_for(node_size_);
+}
+
+bool concurrent_free_memory_list::empty() const noexcept
+{
+    return get_ptr(first_.load(std::memory_order_relaxed)) == nullptr;
+}
+
+#if FOONATHAN_MEMORY_IMPL_PACKED_TAG
+static_assert(ATOMIC_POINTER_LOCK_FREE == 2 && sizeof(std::uintptr_t) == sizeof(char*),
+              "the packed tag requires a lock-free pointer sized atomic");
+
+namespace
+{
+    constexpr auto tag_shift = 48u;
+    constexpr auto ptr_mask  = (std::uintptr_t(1) << tag_shift) - 1u;
+} // namespace
+
+char* concurrent_free_memory_list::get_ptr(tagged_ptr tagged) noexcept
+{
+    return reinterpret_cast<char*>(tagged & ptr_mask);
+}
+
+concurrent_free_memory_list::tagged_ptr concurrent_free_memory_list::next_tagged(
+    tagged_ptr old, char* ptr) noexcept
+{
+    auto value = reinterpret_cast<std::uintptr_t>(ptr);
+    FOONATHAN_MEMORY_ASSERT_MSG((value & ~ptr_mask) == 0u, "address does not fit into 48 bits");
+    // the tag wraps around in the upper bits
+    return ((old & ~ptr_mask) + (std::uintptr_t(1) << tag_shift)) | value;
+}
+#else
+char* concurrent_free_memory_list::get_ptr(tagged_ptr tagged) noexcept
+{
+    return tagged.ptr;
+}
+
+concurrent_free_memory_list::tagged_ptr concurrent_free_memory_list::next_tagged(
+    tagged_ptr old, char* ptr) noexcept
+{
+    return tagged_ptr{ptr, old.tag + 1u};
+}
+#endif
+
+void concurrent_free_memory_list::push(char* first, char* last, std::size_t no_nodes) noexcept
+{
+    capacity_.fetch_add(no_nodes, std::memory_order_relaxed);
+
+    auto old = first_.load(std::memory_order_relaxed);
+    do
+    {
+        list_set_next(last, get_ptr(old));
+    } while (!first_.compare_exchange_weak(old, next_tagged(old, first), std::memory_order_release,
+                                           std::memory_order_relaxed));
+}
+
 namespace
 {
     // converts a block into a linked list
@@ -326,23 +623,59 @@ namespace
         FOONATHAN_MEMORY_UNREACHABLE("memory must be in some half or outside");
         return {nullptr, nullptr};
     }
+
+    // finds the position if it is at the front, at the end or next to the last deallocation,
+    // returns {nullptr, nullptr} if a search is needed
+    pos find_pos_constant(char* memory, char* begin_node, char* end_node, char* last_dealloc,
+                          char* last_dealloc_prev) noexcept
+    {
+        auto first = xor_list_get_other(begin_node, nullptr);
+        auto last  = xor_list_get_other(end_node, nullptr);
+
+        if (greater(first, memory))
+            // insert at front
+            return {begin_node, first};
+        else if (less(last, memory))
+            // insert at the end
+            return {last, end_node};
+        else if (less(last_dealloc_prev, memory) && less(memory, last_dealloc))
+            // insert before last_dealloc
+            return {last_dealloc_prev, last_dealloc};
+        else if (last_dealloc != end_node && less(last_dealloc, memory))
+        {
+            // nodes are often deallocated in ascending order, so try after last_dealloc
+            auto next = xor_list_get_other(last_dealloc, last_dealloc_prev);
+            if (less(memory, next))
+                return {last_dealloc, next};
+        }
+
+        return {nullptr, nullptr};
+    }
 } // namespace
 
 constexpr std::size_t ordered_free_memory_list::min_element_size;
 constexpr std::size_t ordered_free_memory_list::min_element_alignment;
+constexpr std::size_t ordered_free_memory_list::hint_count;
 
 ordered_free_memory_list::ordered_free_memory_list(std::size_t node_size) noexcept
 : node_size_(node_size > min_element_size ? node_size : min_element_size),
   capacity_(0u),
   last_dealloc_(end_node()),
-  last_dealloc_prev_(begin_node())
+  last_dealloc_prev_(begin_node()),
+  hints_(nullptr),
+  hint_shift_(ilog2_ceil(node_size_)),
+  no_hints_(0u)
 {
     xor_list_set(begin_node(), nullptr, end_node());
     xor_list_set(end_node(), begin_node(), nullptr);
 }
 
 ordered_free_memory_list::ordered_free_memory_list(ordered_free_memory_list&& other) noexcept
-: node_size_(other.node_size_), capacity_(other.capacity_)
+: node_size_(other.node_size_),
+  capacity_(other.capacity_),
+  hints_(nullptr),
+  hint_shift_(other.hint_shift_),
+  no_hints_(0u)
 {
     if (!other.empty())
     {
@@ -367,6 +700,8 @@ ordered_free_memory_list::ordered_free_memory_list(ordered_free_memory_list&& ot
     // for programming convenience, last_dealloc is reset
     last_dealloc_prev_ = begin_node();
     last_dealloc_      = xor_list_get_other(last_dealloc_prev_, nullptr);
+    // the hints of other might refer to its proxy nodes
+    other.reset_hints();
 }
 
 void foonathan::memory::detail::swap(ordered_free_memory_list& a,
@@ -406,6 +741,7 @@ void foonathan::memory::detail::swap(ordered_free_memory_list& a,
 
     detail::adl_swap(a.node_size_, b.node_size_);
     detail::adl_swap(a.capacity_, b.capacity_);
+    detail::adl_swap(a.hint_shift_, b.hint_shift_);
 
     // for programming convenience, last_dealloc is reset
     a.last_dealloc_prev_ = a.begin_node();
@@ -413,6 +749,10 @@ void foonathan::memory::detail::swap(ordered_free_memory_list& a,
 
     b.last_dealloc_prev_ = b.begin_node();
     b.last_dealloc_      = xor_list_get_other(b.last_dealloc_prev_, nullptr);
+
+    // the hints are not swapped and refer to the other list
+    a.reset_hints();
+    b.reset_hints();
 }
 
 void ordered_free_memory_list::insert(void* mem, std::size_t size) noexcept
@@ -422,6 +762,15 @@ void ordered_free_memory_list::insert(void* mem, std::size_t size) noexcept
     detail::debug_fill_internal(mem, size, false);
 
     insert_impl(mem, size);
+
+    // grow the regions with the capacity, so the hints cover all of it
+    auto region = capacity_ / hint_count * node_size_;
+    auto shift  = ilog2_ceil(region > node_size_ ? region : node_size_);
+    if (shift > hint_shift_)
+    {
+        hint_shift_ = shift;
+        reset_hints();
+    }
 }
 
 void* ordered_free_memory_list::allocate() noexcept
@@ -436,6 +785,8 @@ void* ordered_free_memory_list::allocate() noexcept
     xor_list_set(prev, nullptr, next); // link prev to next
     xor_list_change(next, node, prev); // change prev of next
     --capacity_;
+    if (no_hints_ != 0u)
+        remove_hints(prev, node, node, next);
 
     if (node == last_dealloc_)
     {
@@ -467,6 +818,8 @@ void* ordered_free_memory_list::allocate(std::size_t n) noexcept
     xor_list_change(i.prev, i.first, i.next); // change next pointer from i.prev to i.next
     xor_list_change(i.next, i.last, i.prev);  // change prev pointer from i.next to i.prev
     capacity_ -= i.size(node_size_);
+    if (no_hints_ != 0u)
+        remove_hints(i.prev, i.first, i.last, i.next);
 
     // if last_dealloc_ points into the array being removed
     if ((less_equal(i.first, last_dealloc_) && less_equal(last_dealloc_, i.last)))
@@ -490,13 +843,16 @@ void ordered_free_memory_list::deallocate(void* ptr) noexcept
 {
     auto node = static_cast<char*>(debug_fill_free(ptr, node_size_, 0));
 
-    auto p =
-        find_pos(allocator_info(FOONATHAN_MEMORY_LOG_PREFIX "::detail::ordered_free_memory_list",
-                                this),
-                 node, begin_node(), end_node(), last_dealloc_, last_dealloc_prev_);
+    auto p        = find_pos_constant(node, begin_node(), end_node(), last_dealloc_,
+                                      last_dealloc_prev_);
+    auto searched = p.prev == nullptr;
+    if (searched)
+        search_pos(node, p.prev, p.next);
 
     xor_list_insert(node, p.prev, p.next);
     ++capacity_;
+    if (searched || no_hints_ != 0u)
+        insert_hints(p.prev, node, node, p.next, searched);
 
     last_dealloc_      = node;
     last_dealloc_prev_ = p.prev;
@@ -516,6 +872,57 @@ void ordered_free_memory_list::deallocate(void* ptr, std::size_t n) noexcept
     }
 }
 
+void ordered_free_memory_list::visit(free_node_visitor f, void* context) noexcept
+{
+    auto prev = begin_node();
+    auto cur  = xor_list_get_other(prev, nullptr);
+    while (cur != end_node())
+    {
+        f(context, cur, 1u);
+        xor_list_iter_next(cur, prev);
+    }
+}
+
+void ordered_free_memory_list::remove_if(free_node_filter f, void* context) noexcept
+{
+    // the last node that is kept and the first one removed after it, if any
+    auto  kept          = begin_node();
+    char* first_removed = nullptr;
+
+    auto prev = begin_node();
+    auto cur  = xor_list_get_other(prev, nullptr);
+    while (true)
+    {
+        auto next = cur == end_node() ? nullptr : xor_list_get_other(cur, prev);
+        if (cur != end_node() && f(context, cur))
+        {
+            --capacity_;
+            if (!first_removed)
+                first_removed = cur;
+        }
+        else
+        {
+            if (first_removed)
+            {
+                // link the kept nodes around the removed ones
+                xor_list_change(kept, first_removed, cur);
+                xor_list_change(cur, prev, kept);
+                first_removed = nullptr;
+            }
+            if (cur == end_node())
+                break;
+            kept = cur;
+        }
+        prev = cur;
+        cur  = next;
+    }
+
+    // the hints may refer to removed nodes
+    reset_hints();
+    last_dealloc_prev_ = begin_node();
+    last_dealloc_      = xor_list_get_other(last_dealloc_prev_, nullptr);
+}
+
 std::size_t ordered_free_memory_list::alignment() const noexcept
 {
     return alignment_for(node_size_);
@@ -526,23 +933,133 @@ char* ordered_free_memory_list::insert_impl(void* mem, std::size_t size) noexcep
     auto no_nodes = size / node_size_;
     FOONATHAN_MEMORY_ASSERT(no_nodes > 0);
 
-    auto p =
-        find_pos(allocator_info(FOONATHAN_MEMORY_LOG_PREFIX "::detail::ordered_free_memory_list",
-                                this),
-                 static_cast<char*>(mem), begin_node(), end_node(), last_dealloc_,
-                 last_dealloc_prev_);
+    auto first    = static_cast<char*>(mem);
+    auto p        = find_pos_constant(first, begin_node(), end_node(), last_dealloc_,
+                                      last_dealloc_prev_);
+    auto searched = p.prev == nullptr;
+    if (searched)
+        search_pos(first, p.prev, p.next);
 
     xor_link_block(mem, node_size_, no_nodes, p.prev, p.next);
     capacity_ += no_nodes;
+    if (searched || no_hints_ != 0u)
+        insert_hints(p.prev, first, first + (no_nodes - 1u) * node_size_, p.next, searched);
 
     if (p.prev == last_dealloc_prev_)
     {
-        last_dealloc_ = static_cast<char*>(mem);
+        last_dealloc_ = first;
     }
 
     return p.prev;
 }
 
+void ordered_free_memory_list::search_pos(char* memory, char*& prev, char*& next) noexcept
+{
+    allocator_info info(FOONATHAN_MEMORY_LOG_PREFIX "::detail::ordered_free_memory_list", this);
+
+    if (no_hints_ != 0u)
+    {
+        // start from the hint of the region of memory or of the closest region with one,
+        // all nodes in between are in those regions, which bounds the search
+        auto region = reinterpret_cast<std::uintptr_t>(memory) >> hint_shift_;
+        for (std::size_t distance = 0u; distance != hint_count / 2u; ++distance)
+        {
+            auto h = find_hint(region - distance);
+            if (!h && distance != 0u)
+                h = find_hint(region + distance);
+            if (!h)
+                continue;
+
+            prev = h->prev;
+            next = h->node;
+            if (less(next, memory))
+                while (next != end_node() && less(next, memory))
+                    xor_list_iter_next(next, prev);
+            else
+                while (prev != begin_node() && greater(prev, memory))
+                    xor_list_iter_next(prev, next);
+            debug_check_double_dealloc([&] { return prev != memory && next != memory; }, info,
+                                       memory);
+            return;
+        }
+    }
+
+    auto p =
+        find_pos(info, memory, begin_node(), end_node(), last_dealloc_, last_dealloc_prev_);
+    prev = p.prev;
+    next = p.next;
+}
+
+void ordered_free_memory_list::insert_hints(char* prev, char* first, char* last, char* next,
+                                            bool create) noexcept
+{
+    if (no_hints_ != 0u)
+    {
+        auto& next_hint = get_hint(next);
+        if (next_hint.node == next)
+        {
+            FOONATHAN_MEMORY_ASSERT(next_hint.prev == prev);
+            next_hint.prev = last;
+        }
+    }
+
+    if (create && hints_)
+    {
+        auto& h = get_hint(first);
+        if (!h.node)
+            ++no_hints_;
+        h = {prev, first};
+    }
+}
+
+void ordered_free_memory_list::remove_hints(char* prev, char* first, char* last,
+                                            char* next) noexcept
+{
+    if (first == last)
+    {
+        auto& h = get_hint(first);
+        if (h.node == first)
+        {
+            h.node = nullptr;
+            --no_hints_;
+        }
+    }
+    else
+    {
+        // the removed nodes are consecutive in memory
+        for (std::size_t i = 0u; i != hint_count; ++i)
+        {
+            auto& h = hints_[i];
+            if (h.node && less_equal(first, h.node) && less_equal(h.node, last))
+            {
+                h.node = nullptr;
+                --no_hints_;
+            }
+        }
+    }
+
+    auto& next_hint = get_hint(next);
+    if (next_hint.node == next)
+    {
+        FOONATHAN_MEMORY_ASSERT(next_hint.prev == last);
+        next_hint.prev = prev;
+    }
+}
+
+void ordered_free_memory_list::reset_hints() noexcept
+{
+    if (hints_)
+        for (std::size_t i = 0u; i != hint_count; ++i)
+            hints_[i].node = nullptr;
+    no_hints_ = 0u;
+}
+
+void ordered_free_memory_list::set_hints(hint* hints) noexcept
+{
+    hints_ = hints;
+    reset_hints();
+}
+
 char* ordered_free_memory_list::begin_node() noexcept
 {
     void* mem = &begin_proxy_;
@@ -19,3 +19,34 @@ std::size_t log2_access_policy::size_from_index(std::size_t index) noexcept
 {
     return std::size_t(1) << index;
 }
+
+namespace
+{
+    // log2 of the number of size classes per power of two
+    constexpr std::size_t geometric_class_bits = 2u;
+    constexpr std::size_t geometric_classes    = std::size_t(1) << geometric_class_bits;
+} // namespace
+
+std::size_t geometric_access_policy::index_from_size(std::size_t size) noexcept
+{
+    FOONATHAN_MEMORY_ASSERT_MSG(size, "size must not be zero");
+    if (size <= geometric_classes)
+        return size;
+
+    // size is in (2^group, 2^(group + 1)], which is split into classes of equal width
+    auto group       = ilog2_ceil(size) - 1u;
+    auto width_bits  = group - geometric_class_bits;
+    auto class_index = (size - (std::size_t(1) << group) + (std::size_t(1) << width_bits) - 1u)
+                       >> width_bits;
+    return (group - geometric_class_bits + 1u) * geometric_classes + class_index;
+}
+
+std::size_t geometric_access_policy::size_from_index(std::size_t index) noexcept
+{
+    if (index <= geometric_classes)
+        return index;
+
+    auto group       = (index - 1u) / geometric_classes + geometric_class_bits - 1u;
+    auto class_index = (index - 1u) % geometric_classes + 1u;
+    return (std::size_t(1) << group) + (class_index << (group - geometric_class_bits));
+}
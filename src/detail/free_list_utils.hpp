@@ -15,6 +15,10 @@
 #include <functional>
 #endif
 
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#endif
+
 namespace foonathan
 {
     namespace memory
@@ -75,6 +79,18 @@ namespace foonathan
                 set_int(address, to_int(ptr));
             }
 
+            // hints the CPU to fetch the cache line of a node that is about to be accessed
+            inline void list_prefetch(const void* address) noexcept
+            {
+#if defined(__GNUC__) || defined(__clang__)
+                __builtin_prefetch(address, 1, 3);
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+                _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+                (void)address;
+#endif
+            }
+
             //=== intrusive xor linked list ===//
             // returns the other pointer given one pointer
             inline char* xor_list_get_other(void* address, char* prev_or_next) noexcept
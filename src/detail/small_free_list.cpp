@@ -3,6 +3,7 @@
 
 #include "detail/small_free_list.hpp"
 
+#include <climits>
 #include <new>
 
 #include "detail/debug_helpers.hpp"
@@ -14,32 +15,58 @@
 using namespace foonathan::memory;
 using namespace detail;
 
-struct foonathan::memory::detail::chunk : chunk_base
+namespace
+{
+    // reads the index of the next free node stored in a free node
+    template <typename IndexType>
+    IndexType get_node_index(const unsigned char* node) noexcept
+    {
+        IndexType result = 0;
+        for (auto i = 0u; i != sizeof(IndexType); ++i)
+            result = static_cast<IndexType>(result | IndexType(node[i]) << (i * CHAR_BIT));
+        return result;
+    }
+
+    // stores the index of the next free node in a free node
+    template <typename IndexType>
+    void set_node_index(unsigned char* node, IndexType index) noexcept
+    {
+        for (auto i = 0u; i != sizeof(IndexType); ++i)
+            node[i] = static_cast<unsigned char>(index >> (i * CHAR_BIT));
+    }
+} // namespace
+
+template <typename IndexType>
+struct foonathan::memory::detail::chunk : chunk_base<IndexType>
 {
+    using list = basic_small_free_memory_list<IndexType>;
+
     // gives it the size of the memory block it is created in and the size of a node
     chunk(std::size_t total_memory, std::size_t node_size) noexcept
-    : chunk_base(static_cast<unsigned char>((total_memory - chunk_memory_offset) / node_size))
+    : chunk_base<IndexType>(
+        static_cast<IndexType>((total_memory - list::chunk_memory_offset) / node_size))
     {
-        static_assert(sizeof(chunk) == sizeof(chunk_base), "chunk must not have members");
-        FOONATHAN_MEMORY_ASSERT((total_memory - chunk_memory_offset) / node_size
-                                <= chunk_max_nodes);
-        FOONATHAN_MEMORY_ASSERT(capacity > 0);
+        static_assert(sizeof(chunk) == sizeof(chunk_base<IndexType>),
+                      "chunk must not have members");
+        FOONATHAN_MEMORY_ASSERT((total_memory - list::chunk_memory_offset) / node_size
+                                <= list::chunk_max_nodes);
+        FOONATHAN_MEMORY_ASSERT(this->capacity > 0);
         auto p = list_memory();
-        for (unsigned char i = 0u; i != no_nodes; p += node_size)
-            *p = ++i;
+        for (IndexType i = 0u; i != this->no_nodes; p += node_size)
+            set_node_index(p, ++i);
     }
 
     // returns memory of the free list
     unsigned char* list_memory() noexcept
     {
         auto mem = static_cast<void*>(this);
-        return static_cast<unsigned char*>(mem) + chunk_memory_offset;
+        return static_cast<unsigned char*>(mem) + list::chunk_memory_offset;
     }
 
     // returns the nth node
-    unsigned char* node_memory(unsigned char i, std::size_t node_size) noexcept
+    unsigned char* node_memory(IndexType i, std::size_t node_size) noexcept
     {
-        FOONATHAN_MEMORY_ASSERT(i < no_nodes);
+        FOONATHAN_MEMORY_ASSERT(i < this->no_nodes);
         return list_memory() + i * node_size;
     }
 
@@ -47,20 +74,20 @@ struct foonathan::memory::detail::chunk : chunk_base
     bool from(unsigned char* node, std::size_t node_size) noexcept
     {
         auto begin = list_memory();
-        auto end   = list_memory() + no_nodes * node_size;
+        auto end   = list_memory() + this->no_nodes * node_size;
         return (begin <= node) & (node < end);
     }
 
     // checks whether a node is already in this chunk
     bool contains(unsigned char* node, std::size_t node_size) noexcept
     {
-        auto cur_index = first_free;
-        while (cur_index != no_nodes)
+        auto cur_index = this->first_free;
+        while (cur_index != this->no_nodes)
         {
             auto cur_mem = node_memory(cur_index, node_size);
             if (cur_mem == node)
                 return true;
-            cur_index = *cur_mem;
+            cur_index = get_node_index<IndexType>(cur_mem);
         }
         return false;
     }
@@ -69,49 +96,47 @@ struct foonathan::memory::detail::chunk : chunk_base
     // chunk most not be empty
     unsigned char* allocate(std::size_t node_size) noexcept
     {
-        --capacity;
+        --this->capacity;
 
-        auto node  = node_memory(first_free, node_size);
-        first_free = *node;
+        auto node        = node_memory(this->first_free, node_size);
+        this->first_free = get_node_index<IndexType>(node);
         return node;
     }
 
     // deallocates a single node given its address and index
     // it must be from this chunk
-    void deallocate(unsigned char* node, unsigned char node_index) noexcept
+    void deallocate(unsigned char* node, IndexType node_index) noexcept
     {
-        ++capacity;
+        ++this->capacity;
 
-        *node      = first_free;
-        first_free = node_index;
+        set_node_index(node, this->first_free);
+        this->first_free = node_index;
     }
 };
 
 namespace
 {
     // converts a chunk_base to a chunk (if it is one)
-    chunk* make_chunk(chunk_base* c) noexcept
+    template <typename IndexType>
+    chunk<IndexType>* make_chunk(chunk_base<IndexType>* c) noexcept
     {
-        return static_cast<chunk*>(c);
+        return static_cast<chunk<IndexType>*>(c);
     }
 
     // same as above but also requires a certain size
-    chunk* make_chunk(chunk_base* c, std::size_t size_needed) noexcept
+    template <typename IndexType>
+    chunk<IndexType>* make_chunk(chunk_base<IndexType>* c, std::size_t size_needed) noexcept
     {
-        FOONATHAN_MEMORY_ASSERT(size_needed <= chunk_max_nodes);
+        FOONATHAN_MEMORY_ASSERT(size_needed
+                                <= basic_small_free_memory_list<IndexType>::chunk_max_nodes);
         return c->capacity >= size_needed ? make_chunk(c) : nullptr;
     }
 
-    // checks if memory was from a chunk, assumes chunk isn't proxy
-    chunk* from_chunk(chunk_base* c, unsigned char* node, std::size_t node_size) noexcept
-    {
-        auto res = make_chunk(c);
-        return res->from(node, node_size) ? res : nullptr;
-    }
-
     // inserts already interconnected chunks into the list
     // list will be kept ordered
-    void insert_chunks(chunk_base* list, chunk_base* begin, chunk_base* end) noexcept
+    template <typename IndexType>
+    void insert_chunks(chunk_base<IndexType>* list, chunk_base<IndexType>* begin,
+                       chunk_base<IndexType>* end) noexcept
     {
         FOONATHAN_MEMORY_ASSERT(begin && end);
 
@@ -148,28 +173,37 @@ namespace
     }
 } // namespace
 
-constexpr std::size_t small_free_memory_list::min_element_size;
-constexpr std::size_t small_free_memory_list::min_element_alignment;
-
-small_free_memory_list::small_free_memory_list(std::size_t node_size) noexcept
-: node_size_(node_size), capacity_(0u), alloc_chunk_(&base_), dealloc_chunk_(&base_)
+template <typename IndexType>
+basic_small_free_memory_list<IndexType>::basic_small_free_memory_list(
+    std::size_t node_size) noexcept
+: node_size_(actual_node_size(node_size)),
+  capacity_(0u),
+  alloc_chunk_(&base_),
+  dealloc_chunk_(&base_),
+  blocks_(nullptr)
 {
 }
 
-small_free_memory_list::small_free_memory_list(std::size_t node_size, void* mem,
-                                               std::size_t size) noexcept
-: small_free_memory_list(node_size)
+template <typename IndexType>
+basic_small_free_memory_list<IndexType>::basic_small_free_memory_list(std::size_t node_size,
+                                                                      void*       mem,
+                                                                      std::size_t size) noexcept
+: basic_small_free_memory_list(node_size)
 {
     insert(mem, size);
 }
 
-small_free_memory_list::small_free_memory_list(small_free_memory_list&& other) noexcept
+template <typename IndexType>
+basic_small_free_memory_list<IndexType>::basic_small_free_memory_list(
+    basic_small_free_memory_list&& other) noexcept
 : node_size_(other.node_size_),
   capacity_(other.capacity_),
   // reset markers for simplicity
   alloc_chunk_(&base_),
-  dealloc_chunk_(&base_)
+  dealloc_chunk_(&base_),
+  blocks_(other.blocks_)
 {
+    other.blocks_ = nullptr;
     if (!other.empty())
     {
         base_.next             = other.base_.next;
@@ -180,6 +214,9 @@ small_free_memory_list::small_free_memory_list(small_free_memory_list&& other) n
         other.base_.next = &other.base_;
         other.base_.prev = &other.base_;
         other.capacity_  = 0u;
+
+        // markers of other point into the moved chunks
+        other.alloc_chunk_ = other.dealloc_chunk_ = &other.base_;
     }
     else
     {
@@ -188,7 +225,9 @@ small_free_memory_list::small_free_memory_list(small_free_memory_list&& other) n
     }
 }
 
-void foonathan::memory::detail::swap(small_free_memory_list& a, small_free_memory_list& b) noexcept
+template <typename IndexType>
+void foonathan::memory::detail::swap(basic_small_free_memory_list<IndexType>& a,
+                                     basic_small_free_memory_list<IndexType>& b) noexcept
 {
     auto b_next = b.base_.next;
     auto b_prev = b.base_.prev;
@@ -221,29 +260,36 @@ void foonathan::memory::detail::swap(small_free_memory_list& a, small_free_memor
 
     detail::adl_swap(a.node_size_, b.node_size_);
     detail::adl_swap(a.capacity_, b.capacity_);
+    detail::adl_swap(a.blocks_, b.blocks_);
 
     // reset markers for simplicity
     a.alloc_chunk_ = a.dealloc_chunk_ = &a.base_;
     b.alloc_chunk_ = b.dealloc_chunk_ = &b.base_;
 }
 
-void small_free_memory_list::insert(void* mem, std::size_t size) noexcept
+template <typename IndexType>
+void basic_small_free_memory_list<IndexType>::insert(void* mem, std::size_t size) noexcept
 {
     FOONATHAN_MEMORY_ASSERT(mem);
     FOONATHAN_MEMORY_ASSERT(is_aligned(mem, max_alignment));
+    FOONATHAN_MEMORY_ASSERT_MSG(size > chunk_block_offset, "memory block too small");
     debug_fill_internal(mem, size, false);
 
+    auto block = ::new (mem) chunk_block;
+    auto first = static_cast<char*>(mem) + chunk_block_offset;
+    size -= chunk_block_offset;
+
     auto total_chunk_size = chunk_memory_offset + node_size_ * chunk_max_nodes;
-    auto align_buffer     = align_offset(total_chunk_size, alignof(chunk));
+    auto stride           = chunk_stride(node_size_);
 
-    auto no_chunks = size / (total_chunk_size + align_buffer);
-    auto remainder = size % (total_chunk_size + align_buffer);
+    auto no_chunks = size / stride;
+    auto remainder = size % stride;
 
-    auto memory          = static_cast<char*>(mem);
+    auto memory          = first;
     auto construct_chunk = [&](std::size_t total_memory, std::size_t node_size)
     {
-        FOONATHAN_MEMORY_ASSERT(align_offset(memory, alignof(chunk)) == 0);
-        return ::new (static_cast<void*>(memory)) chunk(total_memory, node_size);
+        FOONATHAN_MEMORY_ASSERT(align_offset(memory, alignof(chunk_type)) == 0);
+        return ::new (static_cast<void*>(memory)) chunk_type(total_memory, node_size);
     };
 
     auto prev = static_cast<chunk_base*>(nullptr);
@@ -256,9 +302,9 @@ void small_free_memory_list::insert(void* mem, std::size_t size) noexcept
             prev->next = c;
         prev = c;
 
-        memory += total_chunk_size;
-        memory += align_buffer;
+        memory += stride;
     }
+    block->end = reinterpret_cast<unsigned char*>(memory);
 
     auto new_nodes = no_chunks * chunk_max_nodes;
     if (remainder >= chunk_memory_offset + node_size_) // at least one node
@@ -271,24 +317,34 @@ void small_free_memory_list::insert(void* mem, std::size_t size) noexcept
         prev = c;
 
         new_nodes += c->no_nodes;
+        block->end = c->list_memory() + c->no_nodes * node_size_;
     }
 
     FOONATHAN_MEMORY_ASSERT_MSG(new_nodes > 0, "memory block too small");
-    insert_chunks(&base_, static_cast<chunk_base*>(mem), prev);
+    insert_chunks(&base_, reinterpret_cast<chunk_base*>(first), prev);
     capacity_ += new_nodes;
+
+    block->next = blocks_;
+    blocks_     = block;
 }
 
-std::size_t small_free_memory_list::usable_size(std::size_t size) const noexcept
+template <typename IndexType>
+std::size_t basic_small_free_memory_list<IndexType>::usable_size(std::size_t size) const noexcept
 {
-    auto total_chunk_size = chunk_memory_offset + node_size_ * chunk_max_nodes;
-    auto no_chunks        = size / total_chunk_size;
-    auto remainder        = size % total_chunk_size;
+    if (size <= chunk_block_offset)
+        return 0u;
+    size -= chunk_block_offset;
+
+    auto stride    = chunk_stride(node_size_);
+    auto no_chunks = size / stride;
+    auto remainder = size % stride;
 
     return no_chunks * chunk_max_nodes * node_size_
            + (remainder > chunk_memory_offset ? remainder - chunk_memory_offset : 0u);
 }
 
-void* small_free_memory_list::allocate() noexcept
+template <typename IndexType>
+void* basic_small_free_memory_list<IndexType>::allocate() noexcept
 {
     auto chunk   = find_chunk_impl(1);
     alloc_chunk_ = chunk;
@@ -301,7 +357,8 @@ void* small_free_memory_list::allocate() noexcept
     return detail::debug_fill_new(mem, node_size_, 0);
 }
 
-void small_free_memory_list::deallocate(void* mem) noexcept
+template <typename IndexType>
+void basic_small_free_memory_list<IndexType>::deallocate(void* mem) noexcept
 {
     auto info =
         allocator_info(FOONATHAN_MEMORY_LOG_PREFIX "::detail::small_free_memory_list", this);
@@ -321,17 +378,20 @@ void small_free_memory_list::deallocate(void* mem) noexcept
 
     auto index = offset / node_size_;
     FOONATHAN_MEMORY_ASSERT(index < chunk->no_nodes);
-    chunk->deallocate(node, static_cast<unsigned char>(index));
+    chunk->deallocate(node, static_cast<IndexType>(index));
 
     ++capacity_;
 }
 
-std::size_t small_free_memory_list::alignment() const noexcept
+template <typename IndexType>
+std::size_t basic_small_free_memory_list<IndexType>::alignment() const noexcept
 {
     return alignment_for(node_size_);
 }
 
-chunk* small_free_memory_list::find_chunk_impl(std::size_t n) noexcept
+template <typename IndexType>
+typename basic_small_free_memory_list<IndexType>::chunk_type* basic_small_free_memory_list<
+    IndexType>::find_chunk_impl(std::size_t n) noexcept
 {
     if (auto c = make_chunk(alloc_chunk_, n))
         return c;
@@ -357,38 +417,42 @@ chunk* small_free_memory_list::find_chunk_impl(std::size_t n) noexcept
     return nullptr;
 }
 
-chunk* small_free_memory_list::find_chunk_impl(unsigned char* node, chunk_base* first,
-                                               chunk_base* last) noexcept
+template <typename IndexType>
+typename basic_small_free_memory_list<IndexType>::chunk_type* basic_small_free_memory_list<
+    IndexType>::find_chunk_impl(unsigned char* node) noexcept
 {
-    do
-    {
-        if (auto c = from_chunk(first, node, node_size_))
-            return c;
-        else if ((c = from_chunk(last, node, node_size_)) != nullptr)
-            return c;
-
-        first = first->next;
-        last  = last->prev;
-    } while (!greater(first, last));
-    return nullptr;
-}
+    if (dealloc_chunk_ != &base_ && make_chunk(dealloc_chunk_)->from(node, node_size_))
+        return make_chunk(dealloc_chunk_);
 
-chunk* small_free_memory_list::find_chunk_impl(unsigned char* node) noexcept
-{
-    if (auto c = from_chunk(dealloc_chunk_, node, node_size_))
-        return c;
-    else if ((c = from_chunk(alloc_chunk_, node, node_size_)) != nullptr)
-        return c;
-    else if (less(dealloc_chunk_, node))
+    auto stride = chunk_stride(node_size_);
+    for (chunk_block *block = blocks_, *prev = nullptr; block; prev = block, block = block->next)
     {
-        // node is in (dealloc_chunk_, base_.prev]
-        return find_chunk_impl(node, dealloc_chunk_->next, base_.prev);
-    }
-    else if (greater(dealloc_chunk_, node))
-    {
-        // node is in [base.next, dealloc_chunk_)
-        return find_chunk_impl(node, base_.next, dealloc_chunk_->prev);
+        auto begin = reinterpret_cast<unsigned char*>(block) + chunk_block_offset;
+        if (begin <= node && node < block->end)
+        {
+            if (prev)
+            {
+                // move to front, blocks with recent deallocations are likely to have more
+                prev->next  = block->next;
+                block->next = blocks_;
+                blocks_     = block;
+            }
+
+            auto index = static_cast<std::size_t>(node - begin) / stride;
+            auto c     = make_chunk(reinterpret_cast<chunk_base*>(begin + index * stride));
+            // node might point into the chunk header
+            return c->from(node, node_size_) ? c : nullptr;
+        }
     }
-    FOONATHAN_MEMORY_UNREACHABLE("must be in one half");
     return nullptr;
 }
+
+template class foonathan::memory::detail::basic_small_free_memory_list<unsigned char>;
+template class foonathan::memory::detail::basic_small_free_memory_list<std::uint_least16_t>;
+
+template void foonathan::memory::detail::swap(
+    basic_small_free_memory_list<unsigned char>&,
+    basic_small_free_memory_list<unsigned char>&) noexcept;
+template void foonathan::memory::detail::swap(
+    basic_small_free_memory_list<std::uint_least16_t>&,
+    basic_small_free_memory_list<std::uint_least16_t>&) noexcept;
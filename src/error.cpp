@@ -3,6 +3,8 @@
 
 #include "error.hpp"
 
+#include "detail/tracepoint.hpp"
+
 #include <atomic>
 
 #if FOONATHAN_HOSTED_IMPLEMENTATION
@@ -38,6 +40,7 @@ out_of_memory::handler out_of_memory::get_handler()
 out_of_memory::out_of_memory(const allocator_info& info, std::size_t amount)
 : info_(info), amount_(amount)
 {
+    FOONATHAN_MEMORY_TRACE3(out_of_memory, info.name, info.allocator, amount);
     out_of_memory_h.load()(info, amount);
 }
 
@@ -103,3 +106,13 @@ const char* bad_alignment::what() const noexcept
 {
     return "allocation alignment exceeds supported maximum of allocator";
 }
+
+void detail::throw_out_of_memory(const allocator_info& info, std::size_t amount)
+{
+    FOONATHAN_THROW(out_of_memory(info, amount));
+}
+
+void detail::throw_out_of_fixed_memory(const allocator_info& info, std::size_t amount)
+{
+    FOONATHAN_THROW(out_of_fixed_memory(info, amount));
+}
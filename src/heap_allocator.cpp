@@ -7,7 +7,61 @@
 
 using namespace foonathan::memory;
 
-#ifdef _WIN32
+#if FOONATHAN_MEMORY_HEAP_BACKEND != 0
+#include <memory>
+
+#if FOONATHAN_MEMORY_HEAP_BACKEND == 1
+#include <jemalloc/jemalloc.h>
+
+void* foonathan::memory::heap_alloc(std::size_t size) noexcept
+{
+    return mallocx(size, 0);
+}
+
+void foonathan::memory::heap_dealloc(void* ptr, std::size_t size) noexcept
+{
+    sdallocx(ptr, size, 0);
+}
+
+#elif FOONATHAN_MEMORY_HEAP_BACKEND == 2
+#include <mimalloc.h>
+
+void* foonathan::memory::heap_alloc(std::size_t size) noexcept
+{
+    return mi_malloc(size);
+}
+
+void foonathan::memory::heap_dealloc(void* ptr, std::size_t size) noexcept
+{
+    mi_free_size(ptr, size);
+}
+
+#elif FOONATHAN_MEMORY_HEAP_BACKEND == 3
+#include <gperftools/tcmalloc.h>
+
+void* foonathan::memory::heap_alloc(std::size_t size) noexcept
+{
+    return tc_malloc(size);
+}
+
+void foonathan::memory::heap_dealloc(void* ptr, std::size_t size) noexcept
+{
+    tc_free_sized(ptr, size);
+}
+
+#else
+#error "invalid value of FOONATHAN_MEMORY_HEAP_BACKEND"
+#endif
+
+namespace
+{
+    std::size_t max_size() noexcept
+    {
+        return std::allocator_traits<std::allocator<char>>::max_size({});
+    }
+} // namespace
+
+#elif defined(_WIN32)
 #include <malloc.h>
 #include <windows.h>
 
@@ -0,0 +1,52 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "io_buffer_pool.hpp"
+
+#include "detail/align.hpp"
+#include "virtual_memory.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    std::size_t round_up(std::size_t size, std::size_t multiple) noexcept
+    {
+        auto rest = size % multiple;
+        return rest == 0u ? size : size + multiple - rest;
+    }
+} // namespace
+
+io_buffer_pool::io_buffer_pool(std::size_t buffer_size, std::size_t no_buffers,
+                               std::size_t alignment)
+: list_(round_up(buffer_size, alignment)), reserved_(nullptr), alignment_(alignment)
+{
+    FOONATHAN_MEMORY_ASSERT(buffer_size != 0u && no_buffers != 0u);
+    FOONATHAN_MEMORY_ASSERT(detail::is_valid_alignment(alignment));
+
+    auto page_size = get_virtual_memory_page_size();
+    auto size      = round_up(list_.node_size() * no_buffers, page_size);
+    // pages are only aligned to the page size, a bigger alignment needs some slack
+    reserved_size_ = size + (alignment > page_size ? alignment - page_size : 0u);
+
+    reserved_ = virtual_memory_reserve(reserved_size_ / page_size);
+    if (!reserved_)
+        FOONATHAN_THROW(out_of_memory(info(), reserved_size_));
+
+    auto memory = static_cast<char*>(reserved_) + detail::align_offset(reserved_, alignment);
+    if (!virtual_memory_commit(memory, size / page_size))
+    {
+        virtual_memory_release(reserved_, reserved_size_ / page_size);
+        FOONATHAN_THROW(out_of_memory(info(), size));
+    }
+
+    // only whole buffers are inserted, the rest of the last page is unused
+    region_ = memory_block(memory, list_.node_size() * no_buffers);
+    list_.insert(memory, region_.size);
+}
+
+io_buffer_pool::~io_buffer_pool() noexcept
+{
+    if (reserved_)
+        virtual_memory_release(reserved_, reserved_size_ / get_virtual_memory_page_size());
+}
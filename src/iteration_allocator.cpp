@@ -9,4 +9,5 @@ using namespace foonathan::memory;
 template class foonathan::memory::iteration_allocator<2>;
 template class foonathan::memory::allocator_traits<iteration_allocator<2>>;
 template class foonathan::memory::composable_allocator_traits<iteration_allocator<2>>;
+template class foonathan::memory::concurrent_iteration_allocator<2>;
 #endif
@@ -0,0 +1,127 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "latency_tracking.hpp"
+
+#include "detail/assert.hpp"
+#include "detail/ilog2.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    // each power of two is split into 2^sub_bucket_bits buckets
+    constexpr std::size_t sub_bucket_bits  = 3u;
+    constexpr std::size_t sub_bucket_count = std::size_t(1) << sub_bucket_bits;
+
+    static_assert(latency_histogram_size == (64u - sub_bucket_bits + 1u) * sub_bucket_count,
+                  "histogram size must cover all 64 bit values");
+
+    // threads are assigned a shard round-robin on their first event
+    std::size_t current_shard(std::size_t shard_count) noexcept
+    {
+        static std::atomic<std::size_t> next_shard(0u);
+        thread_local const std::size_t  shard = next_shard.fetch_add(1u, std::memory_order_relaxed);
+        return shard % shard_count;
+    }
+
+    std::uint64_t get(const std::atomic<std::uint64_t>& counter) noexcept
+    {
+        return counter.load(std::memory_order_relaxed);
+    }
+} // namespace
+
+constexpr bool latency_clock::is_cycle_counter;
+
+std::size_t latency_histogram_snapshot::bucket_of(std::uint64_t ticks) noexcept
+{
+    if (ticks < sub_bucket_count)
+        return std::size_t(ticks);
+    // the most significant bit selects the power of two, the next ones the bucket within it
+    auto exponent = detail::ilog2(ticks);
+    auto sub      = std::size_t(ticks >> (exponent - sub_bucket_bits)) & (sub_bucket_count - 1u);
+    return (exponent - sub_bucket_bits + 1u) * sub_bucket_count + sub;
+}
+
+std::uint64_t latency_histogram_snapshot::upper_bound(std::size_t bucket) noexcept
+{
+    FOONATHAN_MEMORY_ASSERT(bucket < latency_histogram_size);
+    if (bucket < sub_bucket_count)
+        return bucket;
+    auto shift = bucket / sub_bucket_count - 1u;
+    auto lower = std::uint64_t(sub_bucket_count + bucket % sub_bucket_count) << shift;
+    return lower + ((std::uint64_t(1) << shift) - 1u);
+}
+
+std::uint64_t latency_histogram_snapshot::percentile(double p) const noexcept
+{
+    FOONATHAN_MEMORY_ASSERT(p >= 0.0 && p <= 100.0);
+    if (count == 0u)
+        return 0u;
+
+    // the rank of the call, counting from one
+    auto rank = std::uint64_t(p / 100.0 * double(count) + 0.5);
+    if (rank == 0u)
+        rank = 1u;
+    else if (rank > count)
+        rank = count;
+
+    std::uint64_t seen = 0u;
+    for (std::size_t i = 0u; i != latency_histogram_size; ++i)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+        {
+            auto bound = upper_bound(i);
+            return bound < max ? bound : max;
+        }
+    }
+    return max;
+}
+
+bool detail::latency_sample_next(std::size_t period) noexcept
+{
+    // counts down to the next sampled call
+    thread_local std::size_t countdown = 0u;
+    if (period == 0u)
+        return false;
+    if (countdown == 0u || countdown > period)
+        countdown = period;
+    return --countdown == 0u;
+}
+
+constexpr std::size_t allocation_latency::shard_count;
+
+allocation_latency::allocation_latency() noexcept : shards_() {}
+
+void allocation_latency::record(latency_operation op, std::uint64_t ticks) noexcept
+{
+    auto& h = shards_[current_shard(shard_count)].histograms[static_cast<std::size_t>(op)];
+    h.buckets[latency_histogram_snapshot::bucket_of(ticks)].fetch_add(1u,
+                                                                      std::memory_order_relaxed);
+
+    auto max = h.max.load(std::memory_order_relaxed);
+    while (ticks > max && !h.max.compare_exchange_weak(max, ticks, std::memory_order_relaxed))
+    {
+    }
+}
+
+latency_histogram_snapshot allocation_latency::snapshot(latency_operation op) const noexcept
+{
+    latency_histogram_snapshot result = {};
+    for (auto& s : shards_)
+    {
+        auto& h = s.histograms[static_cast<std::size_t>(op)];
+        for (std::size_t i = 0u; i != latency_histogram_size; ++i)
+        {
+            auto count = get(h.buckets[i]);
+            result.buckets[i] += count;
+            result.count += count;
+        }
+
+        auto max = get(h.max);
+        if (max > result.max)
+            result.max = max;
+    }
+    return result;
+}
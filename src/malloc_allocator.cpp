@@ -6,10 +6,82 @@
 
 #include "malloc_allocator.hpp"
 
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
 #include "error.hpp"
 
 using namespace foonathan::memory;
 
+// the sized deallocation functions of C23
+#if defined(__STDC_VERSION_STDLIB_H__) && __STDC_VERSION_STDLIB_H__ >= 202311L
+#define FOONATHAN_MEMORY_IMPL_FREE_SIZED 1
+#else
+#define FOONATHAN_MEMORY_IMPL_FREE_SIZED 0
+#endif
+
+// allocation of over-aligned memory
+#if defined(_WIN32) || defined(__unix__) || defined(__APPLE__)
+#define FOONATHAN_MEMORY_IMPL_MALLOC_ALIGNED 1
+#else
+#define FOONATHAN_MEMORY_IMPL_MALLOC_ALIGNED 0
+#endif
+
+void* detail::malloc_allocator_impl::allocate(std::size_t size, std::size_t alignment) noexcept
+{
+#if FOONATHAN_MEMORY_IMPL_MALLOC_ALIGNED
+    if (alignment > detail::max_alignment)
+    {
+#if defined(_WIN32)
+        return _aligned_malloc(size, alignment);
+#else
+        void* memory = nullptr;
+        return posix_memalign(&memory, alignment, size) == 0 ? memory : nullptr;
+#endif
+    }
+#else
+    (void)alignment;
+#endif
+    return std::malloc(size);
+}
+
+void detail::malloc_allocator_impl::deallocate(void* ptr, std::size_t size,
+                                               std::size_t alignment) noexcept
+{
+#if FOONATHAN_MEMORY_IMPL_MALLOC_ALIGNED
+    if (alignment > detail::max_alignment)
+    {
+#if defined(_WIN32)
+        _aligned_free(ptr);
+#elif FOONATHAN_MEMORY_IMPL_FREE_SIZED
+        free_aligned_sized(ptr, alignment, size);
+#else
+        std::free(ptr);
+#endif
+        return;
+    }
+#else
+    (void)alignment;
+#endif
+
+#if FOONATHAN_MEMORY_IMPL_FREE_SIZED
+    free_sized(ptr, size);
+#else
+    (void)size;
+    std::free(ptr);
+#endif
+}
+
+std::size_t detail::malloc_allocator_impl::max_alignment() noexcept
+{
+#if FOONATHAN_MEMORY_IMPL_MALLOC_ALIGNED
+    return detail::max_extended_alignment;
+#else
+    return detail::max_alignment;
+#endif
+}
+
 allocator_info detail::malloc_allocator_impl::info() noexcept
 {
     return {FOONATHAN_MEMORY_LOG_PREFIX "::malloc_allocator", nullptr};
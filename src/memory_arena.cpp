@@ -3,6 +3,7 @@
 
 #include "memory_arena.hpp"
 
+#include <atomic>
 #include <new>
 
 #include "detail/align.hpp"
@@ -36,6 +37,26 @@ void memory_block_stack::steal_top(memory_block_stack& other) noexcept
     head_          = to_steal;
 }
 
+void memory_block_stack::move_to_top(const void* memory) noexcept
+{
+    // the blocks are only linked downwards, so remember the block above
+    node* above = nullptr;
+    auto  cur   = head_;
+    while (cur && static_cast<char*>(static_cast<void*>(cur)) + implementation_offset() != memory)
+    {
+        above = cur;
+        cur   = cur->prev;
+    }
+    FOONATHAN_MEMORY_ASSERT_MSG(cur, "block is not in use");
+
+    if (above)
+    {
+        above->prev = cur->prev;
+        cur->prev   = head_;
+        head_       = cur;
+    }
+}
+
 bool memory_block_stack::owns(const void* ptr) const noexcept
 {
     auto address = static_cast<const char*>(ptr);
@@ -56,6 +77,21 @@ std::size_t memory_block_stack::size() const noexcept
     return res;
 }
 
+namespace
+{
+    std::atomic<std::size_t> trim_epoch(0u);
+} // namespace
+
+std::size_t detail::arena_trim_epoch() noexcept
+{
+    return trim_epoch.load(std::memory_order_relaxed);
+}
+
+void foonathan::memory::trim_arena_caches() noexcept
+{
+    trim_epoch.fetch_add(1u, std::memory_order_relaxed);
+}
+
 #if FOONATHAN_MEMORY_EXTERN_TEMPLATE
 template class foonathan::memory::memory_arena<static_block_allocator, true>;
 template class foonathan::memory::memory_arena<static_block_allocator, false>;
@@ -69,4 +105,8 @@ template class foonathan::memory::memory_arena<growing_block_allocator<>, false>
 template class foonathan::memory::fixed_block_allocator<>;
 template class foonathan::memory::memory_arena<fixed_block_allocator<>, true>;
 template class foonathan::memory::memory_arena<fixed_block_allocator<>, false>;
+
+template class foonathan::memory::adaptive_block_allocator<>;
+template class foonathan::memory::memory_arena<adaptive_block_allocator<>, true>;
+template class foonathan::memory::memory_arena<adaptive_block_allocator<>, false>;
 #endif
@@ -3,6 +3,9 @@
 
 #include "memory_pool.hpp"
 
+#include <algorithm>
+#include <functional>
+
 #include "debugging.hpp"
 
 using namespace foonathan::memory;
@@ -12,16 +15,55 @@ void detail::memory_pool_leak_handler::operator()(std::ptrdiff_t amount)
     get_leak_handler()({FOONATHAN_MEMORY_LOG_PREFIX "::memory_pool", this}, amount);
 }
 
+void detail::pool_block_table::sort() noexcept
+{
+    std::sort(blocks, blocks + size,
+              [](const pool_block_nodes& a, const pool_block_nodes& b)
+              { return std::less<void*>()(a.block.memory, b.block.memory); });
+}
+
+detail::pool_block_nodes* detail::pool_block_table::find(const void* memory) const noexcept
+{
+    // the first block after the memory
+    auto last = std::upper_bound(blocks, blocks + size, memory,
+                                 [](const void* mem, const pool_block_nodes& b)
+                                 { return std::less<const void*>()(mem, b.block.memory); });
+    if (last == blocks || !(last - 1)->block.contains(memory))
+        return nullptr;
+    return last - 1;
+}
+
+void detail::pool_block_table::count_free_nodes(void* table, char* node,
+                                                std::size_t no_nodes) noexcept
+{
+    auto block = static_cast<pool_block_table*>(table)->find(node);
+    FOONATHAN_MEMORY_ASSERT(block);
+    block->free_nodes += no_nodes;
+}
+
+bool detail::pool_block_table::is_released(void* table, char* node) noexcept
+{
+    auto block = static_cast<pool_block_table*>(table)->find(node);
+    FOONATHAN_MEMORY_ASSERT(block);
+    return block->release;
+}
+
 #if FOONATHAN_MEMORY_EXTERN_TEMPLATE
 template class foonathan::memory::memory_pool<node_pool>;
 template class foonathan::memory::memory_pool<array_pool>;
+template class foonathan::memory::memory_pool<bitmap_array_pool>;
 template class foonathan::memory::memory_pool<small_node_pool>;
+template class foonathan::memory::memory_pool<concurrent_node_pool>;
 
 template class foonathan::memory::allocator_traits<memory_pool<node_pool>>;
 template class foonathan::memory::allocator_traits<memory_pool<array_pool>>;
+template class foonathan::memory::allocator_traits<memory_pool<bitmap_array_pool>>;
 template class foonathan::memory::allocator_traits<memory_pool<small_node_pool>>;
+template class foonathan::memory::allocator_traits<memory_pool<concurrent_node_pool>>;
 
 template class foonathan::memory::composable_allocator_traits<memory_pool<node_pool>>;
 template class foonathan::memory::composable_allocator_traits<memory_pool<array_pool>>;
+template class foonathan::memory::composable_allocator_traits<memory_pool<bitmap_array_pool>>;
 template class foonathan::memory::composable_allocator_traits<memory_pool<small_node_pool>>;
+template class foonathan::memory::composable_allocator_traits<memory_pool<concurrent_node_pool>>;
 #endif
@@ -12,6 +12,11 @@ void detail::memory_pool_collection_leak_handler::operator()(std::ptrdiff_t amou
     get_leak_handler()({FOONATHAN_MEMORY_LOG_PREFIX "::memory_pool_collection", this}, amount);
 }
 
+void detail::slab_pool_collection_leak_handler::operator()(std::ptrdiff_t amount)
+{
+    get_leak_handler()({FOONATHAN_MEMORY_LOG_PREFIX "::slab_pool_collection", this}, amount);
+}
+
 #if FOONATHAN_MEMORY_EXTERN_TEMPLATE
 template class foonathan::memory::memory_pool_collection<node_pool, identity_buckets>;
 template class foonathan::memory::memory_pool_collection<array_pool, identity_buckets>;
@@ -21,6 +26,10 @@ template class foonathan::memory::memory_pool_collection<node_pool, log2_buckets
 template class foonathan::memory::memory_pool_collection<array_pool, log2_buckets>;
 template class foonathan::memory::memory_pool_collection<small_node_pool, log2_buckets>;
 
+template class foonathan::memory::memory_pool_collection<node_pool, geometric_buckets>;
+template class foonathan::memory::memory_pool_collection<array_pool, geometric_buckets>;
+template class foonathan::memory::memory_pool_collection<small_node_pool, geometric_buckets>;
+
 template class foonathan::memory::allocator_traits<
     memory_pool_collection<node_pool, identity_buckets>>;
 template class foonathan::memory::allocator_traits<
@@ -34,6 +43,13 @@ template class foonathan::memory::allocator_traits<
 template class foonathan::memory::allocator_traits<
     memory_pool_collection<small_node_pool, log2_buckets>>;
 
+template class foonathan::memory::allocator_traits<
+    memory_pool_collection<node_pool, geometric_buckets>>;
+template class foonathan::memory::allocator_traits<
+    memory_pool_collection<array_pool, geometric_buckets>>;
+template class foonathan::memory::allocator_traits<
+    memory_pool_collection<small_node_pool, geometric_buckets>>;
+
 template class foonathan::memory::composable_allocator_traits<
     memory_pool_collection<node_pool, identity_buckets>>;
 template class foonathan::memory::composable_allocator_traits<
@@ -47,4 +63,11 @@ template class foonathan::memory::composable_allocator_traits<
     memory_pool_collection<array_pool, log2_buckets>>;
 template class foonathan::memory::composable_allocator_traits<
     memory_pool_collection<small_node_pool, log2_buckets>>;
+
+template class foonathan::memory::composable_allocator_traits<
+    memory_pool_collection<node_pool, geometric_buckets>>;
+template class foonathan::memory::composable_allocator_traits<
+    memory_pool_collection<array_pool, geometric_buckets>>;
+template class foonathan::memory::composable_allocator_traits<
+    memory_pool_collection<small_node_pool, geometric_buckets>>;
 #endif
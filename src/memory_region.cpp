@@ -0,0 +1,10 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "memory_region.hpp"
+
+using namespace foonathan::memory;
+
+#if FOONATHAN_MEMORY_EXTERN_TEMPLATE
+template class foonathan::memory::memory_region<>;
+#endif
@@ -0,0 +1,296 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "metrics_exporter.hpp"
+
+#include <vector>
+
+#include "detail/assert.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    enum class metric_source
+    {
+        stats,
+        statistics,
+    };
+
+    struct metric_info
+    {
+        const char*   name;
+        const char*   help;
+        metric_kind   kind;
+        metric_source source;
+    };
+
+    const metric_info metrics[] = {
+        {"foonathan_memory_reserved_bytes",
+         "Total size of the blocks owned by the allocator, including the cached ones.",
+         metric_kind::gauge, metric_source::stats},
+        {"foonathan_memory_committed_bytes", "Total size of the blocks in use by the allocator.",
+         metric_kind::gauge, metric_source::stats},
+        {"foonathan_memory_used_bytes", "Size of the memory handed out by the allocator.",
+         metric_kind::gauge, metric_source::stats},
+        {"foonathan_memory_free_listed_bytes",
+         "Size of the memory on the free lists of the allocator.", metric_kind::gauge,
+         metric_source::stats},
+        {"foonathan_memory_unused_bytes",
+         "Size of the memory in the blocks that has never been handed out.", metric_kind::gauge,
+         metric_source::stats},
+        {"foonathan_memory_wasted_bytes",
+         "Size of the memory lost to bookkeeping, alignment and rounding.", metric_kind::gauge,
+         metric_source::stats},
+        {"foonathan_memory_blocks", "Number of blocks in use by the allocator.",
+         metric_kind::gauge, metric_source::stats},
+        {"foonathan_memory_cached_blocks", "Number of blocks cached by the allocator.",
+         metric_kind::gauge, metric_source::stats},
+        {"foonathan_memory_allocations_total", "Number of allocations.", metric_kind::counter,
+         metric_source::statistics},
+        {"foonathan_memory_deallocations_total", "Number of deallocations.",
+         metric_kind::counter, metric_source::statistics},
+        {"foonathan_memory_allocated_bytes_total", "Number of bytes allocated.",
+         metric_kind::counter, metric_source::statistics},
+        {"foonathan_memory_deallocated_bytes_total", "Number of bytes deallocated.",
+         metric_kind::counter, metric_source::statistics},
+        {"foonathan_memory_live_bytes", "Number of bytes currently allocated.",
+         metric_kind::gauge, metric_source::statistics},
+        {"foonathan_memory_peak_bytes", "Approximate peak of the bytes allocated at a time.",
+         metric_kind::gauge, metric_source::statistics},
+        {"foonathan_memory_growths_total", "Number of blocks allocated by the allocator.",
+         metric_kind::counter, metric_source::statistics},
+        {"foonathan_memory_shrinks_total", "Number of blocks deallocated by the allocator.",
+         metric_kind::counter, metric_source::statistics},
+        {"foonathan_memory_block_bytes", "Total size of the blocks owned by the allocator.",
+         metric_kind::gauge, metric_source::statistics},
+    };
+
+    constexpr std::size_t metric_count = sizeof(metrics) / sizeof(metrics[0]);
+
+    struct entry_values
+    {
+        std::string   name;
+        metric_source source;
+        std::size_t   values[metric_count];
+    };
+
+    void read_values(const memory_stats& stats, std::size_t* values) noexcept
+    {
+        values[0] = stats.reserved_bytes;
+        values[1] = stats.committed_bytes;
+        values[2] = stats.used_bytes;
+        values[3] = stats.free_listed_bytes;
+        values[4] = stats.unused_bytes;
+        values[5] = stats.wasted_bytes;
+        values[6] = stats.blocks;
+        values[7] = stats.cached_blocks;
+    }
+
+    void read_values(const allocation_statistics_snapshot& snapshot, std::size_t* values) noexcept
+    {
+        values[8]  = snapshot.allocations;
+        values[9]  = snapshot.deallocations;
+        values[10] = snapshot.bytes_allocated;
+        values[11] = snapshot.bytes_deallocated;
+        values[12] = snapshot.live_bytes;
+        values[13] = snapshot.peak_bytes;
+        values[14] = snapshot.growths;
+        values[15] = snapshot.shrinks;
+        values[16] = snapshot.block_bytes;
+    }
+
+    void append_label_value(std::string& out, const std::string& value)
+    {
+        for (auto c : value)
+        {
+            if (c == '\\')
+                out += "\\\\";
+            else if (c == '"')
+                out += "\\\"";
+            else if (c == '\n')
+                out += "\\n";
+            else
+                out += c;
+        }
+    }
+} // namespace
+
+metrics_registration::~metrics_registration() noexcept
+{
+    if (registry_)
+    {
+        std::lock_guard<std::mutex> lock(registry_->mutex_);
+        for (auto iter = registry_->entries_.begin(); iter != registry_->entries_.end(); ++iter)
+            if (&*iter == entry_)
+            {
+                registry_->entries_.erase(iter);
+                break;
+            }
+    }
+}
+
+void metrics_registration::update(const memory_stats& stats) noexcept
+{
+    FOONATHAN_MEMORY_ASSERT(registry_ && !entry_->query && !entry_->statistics);
+    std::lock_guard<std::mutex> lock(registry_->mutex_);
+    entry_->stats     = stats;
+    entry_->has_stats = true;
+}
+
+metrics_registration metrics_registry::add(std::string name)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back({detail::move(name), {}, nullptr, memory_stats(), false});
+    return {*this, entries_.back()};
+}
+
+metrics_registration metrics_registry::add(std::string name, std::function<memory_stats()> query)
+{
+    FOONATHAN_MEMORY_ASSERT(query);
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back({detail::move(name), detail::move(query), nullptr, memory_stats(), false});
+    return {*this, entries_.back()};
+}
+
+metrics_registration metrics_registry::add(std::string                  name,
+                                           const allocation_statistics& statistics)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back({detail::move(name), {}, &statistics, memory_stats(), false});
+    return {*this, entries_.back()};
+}
+
+void metrics_registry::collect(const std::function<void(const metric_sample&)>& f) const
+{
+    // the values are read under the lock, but f is called without it
+    std::vector<entry_values> entries;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries.reserve(entries_.size());
+        for (auto& entry : entries_)
+        {
+            entry_values values;
+            values.name = entry.name;
+            if (entry.statistics)
+            {
+                values.source = metric_source::statistics;
+                read_values(entry.statistics->snapshot(), values.values);
+            }
+            else if (entry.query)
+            {
+                values.source = metric_source::stats;
+                read_values(entry.query(), values.values);
+            }
+            else if (entry.has_stats)
+            {
+                values.source = metric_source::stats;
+                read_values(entry.stats, values.values);
+            }
+            else
+                // not updated yet
+                continue;
+            entries.push_back(detail::move(values));
+        }
+    }
+
+    for (auto i = 0u; i != metric_count; ++i)
+        for (auto& entry : entries)
+            if (entry.source == metrics[i].source)
+                f({metrics[i].name, metrics[i].help, metrics[i].kind, entry.name,
+                   entry.values[i]});
+}
+
+std::string metrics_registry::prometheus() const
+{
+    std::string result;
+    const char* last_metric = nullptr;
+    collect(
+        [&](const metric_sample& sample)
+        {
+            if (sample.metric != last_metric)
+            {
+                last_metric = sample.metric;
+                result += "# HELP ";
+                result += sample.metric;
+                result += ' ';
+                result += sample.help;
+                result += "\n# TYPE ";
+                result += sample.metric;
+                result += sample.kind == metric_kind::counter ? " counter\n" : " gauge\n";
+            }
+
+            result += sample.metric;
+            result += "{allocator=\"";
+            append_label_value(result, sample.allocator);
+            result += "\"} ";
+            result += std::to_string(sample.value);
+            result += '\n';
+        });
+    return result;
+}
+
+bool metrics_registry::write_prometheus(const char* path) const
+{
+    auto text = prometheus();
+
+    auto tmp_path = std::string(path) + ".tmp";
+    auto file     = std::fopen(tmp_path.c_str(), "w");
+    if (!file)
+        return false;
+    auto written = std::fwrite(text.data(), 1u, text.size(), file) == text.size();
+    if (std::fclose(file) != 0 || !written || std::rename(tmp_path.c_str(), path) != 0)
+    {
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+metrics_publisher::metrics_publisher(const metrics_registry&                      registry,
+                                     std::chrono::milliseconds                    interval,
+                                     std::function<void(const metrics_registry&)> publish)
+: registry_(&registry),
+  publish_(detail::move(publish)),
+  interval_(interval),
+  stop_(false),
+  thread_(&metrics_publisher::run, this)
+{
+}
+
+metrics_publisher::~metrics_publisher() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wakeup_.notify_one();
+    thread_.join();
+}
+
+void metrics_publisher::publish_now()
+{
+    publish_(*registry_);
+}
+
+void metrics_publisher::run() noexcept
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!wakeup_.wait_for(lock, interval_, [&] { return stop_; }))
+    {
+        lock.unlock();
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+        try
+        {
+            publish_(*registry_);
+        }
+        catch (...)
+        {
+            // try again on the next interval
+        }
+#else
+        publish_(*registry_);
+#endif
+        lock.lock();
+    }
+}
@@ -13,17 +13,39 @@
 
 using namespace foonathan::memory;
 
+namespace
+{
+    // the aligned and sized operator new/delete of C++17 and C++14
+#if defined(__cpp_aligned_new)
+    bool use_aligned_new(std::size_t alignment) noexcept
+    {
+        return alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+    }
+#endif
+
+    void* try_new(std::size_t size, std::size_t alignment) noexcept
+    {
+#if defined(__cpp_aligned_new)
+        if (use_aligned_new(alignment))
+            return ::operator new(size, std::align_val_t(alignment), std::nothrow);
+#else
+        (void)alignment;
+#endif
+        return ::operator new(size, std::nothrow);
+    }
+} // namespace
+
 allocator_info detail::new_allocator_impl::info() noexcept
 {
     return {FOONATHAN_MEMORY_LOG_PREFIX "::new_allocator", nullptr};
 }
 
-void* detail::new_allocator_impl::allocate(std::size_t size, size_t) noexcept
+void* detail::new_allocator_impl::allocate(std::size_t size, size_t alignment) noexcept
 {
     void* memory = nullptr;
     while (true)
     {
-        memory = ::operator new(size, std::nothrow);
+        memory = try_new(size, alignment);
         if (memory)
             break;
 
@@ -51,9 +73,37 @@ void* detail::new_allocator_impl::allocate(std::size_t size, size_t) noexcept
     return memory;
 }
 
-void detail::new_allocator_impl::deallocate(void* ptr, std::size_t, size_t) noexcept
+void detail::new_allocator_impl::deallocate(void* ptr, std::size_t size, size_t alignment) noexcept
 {
+#if defined(__cpp_aligned_new)
+    if (use_aligned_new(alignment))
+    {
+#if defined(__cpp_sized_deallocation)
+        ::operator delete(ptr, size, std::align_val_t(alignment));
+#else
+        ::operator delete(ptr, std::align_val_t(alignment));
+#endif
+        return;
+    }
+#else
+    (void)alignment;
+#endif
+
+#if defined(__cpp_sized_deallocation)
+    ::operator delete(ptr, size);
+#else
+    (void)size;
     ::operator delete(ptr);
+#endif
+}
+
+std::size_t detail::new_allocator_impl::max_alignment() noexcept
+{
+#if defined(__cpp_aligned_new)
+    return detail::max_extended_alignment;
+#else
+    return detail::max_alignment;
+#endif
 }
 
 std::size_t detail::new_allocator_impl::max_node_size() noexcept
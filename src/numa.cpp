@@ -0,0 +1,162 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "numa.hpp"
+
+#include "virtual_memory.hpp"
+
+using namespace foonathan::memory;
+
+#if defined(__linux__)
+#include <climits>
+#include <cstdio>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+    // from <linux/mempolicy.h>, which is not always installed
+    constexpr int mpol_preferred = 1;
+
+    // the node mask passed to the kernel, limits the number of supported nodes
+    constexpr std::size_t node_mask_words = 16u;
+    constexpr std::size_t node_mask_bits  = node_mask_words * sizeof(unsigned long) * CHAR_BIT;
+
+    std::size_t query_node_count() noexcept
+    {
+        // the file contains a list of ranges like "0-1,3", the last number is the highest node
+        auto file = std::fopen("/sys/devices/system/node/possible", "r");
+        if (!file)
+            return 1u;
+
+        unsigned long highest = 0u, cur = 0u;
+        auto          c       = std::fgetc(file);
+        for (auto in_number = false; c != EOF; c = std::fgetc(file))
+        {
+            if (c >= '0' && c <= '9')
+            {
+                cur       = (in_number ? cur * 10u : 0u) + static_cast<unsigned long>(c - '0');
+                in_number = true;
+            }
+            else if (in_number)
+            {
+                highest   = cur > highest ? cur : highest;
+                in_number = false;
+            }
+        }
+        std::fclose(file);
+
+        highest = cur > highest ? cur : highest;
+        return highest + 1u > node_mask_bits ? node_mask_bits : std::size_t(highest + 1u);
+    }
+} // namespace
+
+std::size_t foonathan::memory::get_numa_node_count() noexcept
+{
+    static const std::size_t count = query_node_count();
+    return count;
+}
+
+unsigned foonathan::memory::get_current_numa_node() noexcept
+{
+#if defined(SYS_getcpu)
+    unsigned cpu = 0u, node = 0u;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 && node < get_numa_node_count())
+        return node;
+#endif
+    return 0u;
+}
+
+bool foonathan::memory::virtual_memory_bind(void* memory, std::size_t no_pages,
+                                            unsigned node) noexcept
+{
+#if defined(SYS_mbind)
+    if (node == numa_local_node)
+        node = get_current_numa_node();
+    if (get_numa_node_count() == 1u || node >= node_mask_bits)
+        return false;
+
+    constexpr auto word_bits = sizeof(unsigned long) * CHAR_BIT;
+
+    unsigned long mask[node_mask_words] = {};
+    mask[node / word_bits] |= 1ul << (node % word_bits);
+    // the kernel expects the number of bits plus one
+    return syscall(SYS_mbind, memory, no_pages * virtual_memory_page_size, mpol_preferred, mask,
+                   node_mask_bits + 1u, 0u)
+           == 0;
+#else
+    (void)memory;
+    (void)no_pages;
+    (void)node;
+    return false;
+#endif
+}
+#else
+std::size_t foonathan::memory::get_numa_node_count() noexcept
+{
+    return 1u;
+}
+
+unsigned foonathan::memory::get_current_numa_node() noexcept
+{
+    return 0u;
+}
+
+bool foonathan::memory::virtual_memory_bind(void*, std::size_t, unsigned) noexcept
+{
+    return false;
+}
+#endif
+
+namespace
+{
+    std::size_t round_up_to_pages(std::size_t size) noexcept
+    {
+        auto rest = size % virtual_memory_page_size;
+        return rest == 0u ? size : size + virtual_memory_page_size - rest;
+    }
+} // namespace
+
+numa_block_allocator::numa_block_allocator(std::size_t block_size, unsigned node) noexcept
+: block_size_(round_up_to_pages(block_size)), node_(node)
+{
+    FOONATHAN_MEMORY_ASSERT(block_size > 0u);
+    FOONATHAN_MEMORY_ASSERT(node == numa_local_node || node < get_numa_node_count());
+}
+
+memory_block numa_block_allocator::allocate_block()
+{
+    auto no_pages = block_size_ / virtual_memory_page_size;
+    auto memory   = virtual_memory_reserve(no_pages);
+    if (!memory)
+        FOONATHAN_THROW(out_of_memory(info(), block_size_));
+
+    // binding is only a hint, the memory is usable anyway
+    virtual_memory_bind(memory, no_pages, node_);
+    if (!virtual_memory_commit(memory, no_pages))
+    {
+        virtual_memory_release(memory, no_pages);
+        FOONATHAN_THROW(out_of_memory(info(), block_size_));
+    }
+
+    memory_block block(memory, block_size_);
+    block_size_ *= 2u;
+    return block;
+}
+
+void numa_block_allocator::deallocate_block(memory_block block) noexcept
+{
+    auto no_pages = block.size / virtual_memory_page_size;
+    virtual_memory_decommit(block.memory, no_pages);
+    virtual_memory_release(block.memory, no_pages);
+}
+
+allocator_info numa_block_allocator::info() noexcept
+{
+    return {FOONATHAN_MEMORY_LOG_PREFIX "::numa_block_allocator", this};
+}
+
+#if FOONATHAN_MEMORY_EXTERN_TEMPLATE
+template class foonathan::memory::memory_arena<numa_block_allocator, true>;
+template class foonathan::memory::memory_arena<numa_block_allocator, false>;
+#endif
@@ -0,0 +1,90 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "per_cpu_cached_pool.hpp"
+
+#include <thread>
+
+#include "sharded_allocator.hpp"
+
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+
+#if defined(__has_include)
+#if __has_include(<sys/rseq.h>)
+#include <sys/rseq.h>
+#endif
+#endif
+#endif
+
+using namespace foonathan::memory;
+
+#if defined(RSEQ_SIG) && defined(__GNUC__) && (defined(__x86_64__) || defined(__aarch64__))
+#define FOONATHAN_MEMORY_IMPL_RSEQ 1
+#else
+#define FOONATHAN_MEMORY_IMPL_RSEQ 0
+#endif
+
+namespace
+{
+#if FOONATHAN_MEMORY_IMPL_RSEQ
+    // the kernel updates the field whenever the thread is migrated,
+    // an invalid id means it was not registered and is larger than any CPU
+    unsigned rseq_cpu_id() noexcept
+    {
+        if (__rseq_size == 0u)
+            return unsigned(-1);
+        auto area = reinterpret_cast<volatile struct rseq*>(
+            static_cast<char*>(__builtin_thread_pointer()) + __rseq_offset);
+        return area->cpu_id;
+    }
+#endif
+
+    std::size_t query_cpu_count() noexcept
+    {
+#if defined(__linux__)
+        auto count = sysconf(_SC_NPROCESSORS_CONF);
+        if (count > 0)
+            return std::size_t(count);
+#endif
+        auto threads = std::thread::hardware_concurrency();
+        return threads == 0u ? 1u : threads;
+    }
+
+    bool query_cpu_available() noexcept
+    {
+#if defined(__linux__)
+        return sched_getcpu() >= 0;
+#else
+        return false;
+#endif
+    }
+} // namespace
+
+std::size_t detail::cpu_cache_count() noexcept
+{
+    static const std::size_t count = query_cpu_count();
+    return count;
+}
+
+std::size_t detail::current_cpu_cache() noexcept
+{
+#if FOONATHAN_MEMORY_IMPL_RSEQ
+    auto id = rseq_cpu_id();
+    if (id < cpu_cache_count())
+        return id;
+#endif
+#if defined(__linux__)
+    auto cpu = sched_getcpu();
+    if (cpu >= 0)
+        return std::size_t(cpu);
+#endif
+    return thread_shard_hint();
+}
+
+bool detail::cpu_caches_available() noexcept
+{
+    static const bool available = query_cpu_available();
+    return available;
+}
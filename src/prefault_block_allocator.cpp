@@ -0,0 +1,57 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "prefault_block_allocator.hpp"
+
+using namespace foonathan::memory;
+
+detail::prefault_thread::prefault_thread()
+: pending_(false), stop_(false), thread_(&prefault_thread::run, this)
+{
+}
+
+detail::prefault_thread::~prefault_thread() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wakeup_.notify_one();
+    thread_.join();
+}
+
+void detail::prefault_thread::start(memory_block block) noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        FOONATHAN_MEMORY_ASSERT(!pending_);
+        block_   = block;
+        pending_ = true;
+    }
+    wakeup_.notify_one();
+}
+
+void detail::prefault_thread::wait() noexcept
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_.wait(lock, [&] { return !pending_; });
+}
+
+void detail::prefault_thread::run() noexcept
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        wakeup_.wait(lock, [&] { return pending_ || stop_; });
+        if (stop_)
+            break;
+
+        auto block = block_;
+        lock.unlock();
+        prefault_memory(block.memory, block.size);
+        lock.lock();
+
+        pending_ = false;
+        finished_.notify_all();
+    }
+}
@@ -0,0 +1,118 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "reclamation_service.hpp"
+
+#include "detail/utility.hpp"
+#include "cached_block_allocator.hpp"
+#include "memory_arena.hpp"
+#include "temporary_allocator.hpp"
+
+using namespace foonathan::memory;
+
+reclamation_service::reclamation_service(std::chrono::milliseconds period)
+: next_id_(0u), period_(period), stop_(false), wake_(false), passes_(0u)
+{
+    // started last, after all members are initialized
+    thread_ = std::thread([this] { run(); });
+}
+
+reclamation_service::~reclamation_service() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wakeup_.notify_one();
+    thread_.join();
+}
+
+reclamation_service::reclaimer_id reclamation_service::add_reclaimer(reclaimer r)
+{
+    std::lock_guard<std::mutex> lock(run_mutex_);
+    auto                        id = next_id_++;
+    reclaimers_.emplace_back(id, detail::move(r));
+    return id;
+}
+
+void reclamation_service::remove_reclaimer(reclaimer_id id) noexcept
+{
+    std::lock_guard<std::mutex> lock(run_mutex_);
+    for (auto iter = reclaimers_.begin(); iter != reclaimers_.end(); ++iter)
+        if (iter->first == id)
+        {
+            reclaimers_.erase(iter);
+            break;
+        }
+}
+
+void reclamation_service::set_period(std::chrono::milliseconds period) noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        period_ = period;
+    }
+    // wait again with the new period
+    wakeup_.notify_one();
+}
+
+std::chrono::milliseconds reclamation_service::period() const noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return period_;
+}
+
+void reclamation_service::reclaim_now() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wake_ = true;
+    }
+    wakeup_.notify_one();
+}
+
+void reclamation_service::run_once() noexcept
+{
+    std::lock_guard<std::mutex> lock(run_mutex_);
+
+    trim_arena_caches();
+    trim_temporary_stacks();
+    trim_block_cache();
+    for (auto& r : reclaimers_)
+    {
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+        try
+        {
+            r.second();
+        }
+        catch (...)
+        {
+            // must not escape the background thread
+        }
+#else
+        r.second();
+#endif
+    }
+
+    passes_.fetch_add(1u, std::memory_order_release);
+}
+
+void reclamation_service::run() noexcept
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_)
+    {
+        auto deadline = std::chrono::steady_clock::now() + period_;
+        auto period   = period_;
+        wakeup_.wait_until(lock, deadline, [&] { return stop_ || wake_ || period_ != period; });
+        if (stop_)
+            break;
+        else if (!wake_ && period_ != period && std::chrono::steady_clock::now() < deadline)
+            continue; // period changed, wait again
+
+        wake_ = false;
+        lock.unlock();
+        run_once();
+        lock.lock();
+    }
+}
@@ -0,0 +1,268 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "ring_allocator.hpp"
+
+#include "detail/align.hpp"
+#include "detail/debug_helpers.hpp"
+#include "debugging.hpp"
+#include "virtual_memory.hpp"
+
+using namespace foonathan::memory;
+
+#if defined(__unix__) || defined(__APPLE__) || defined(__VXWORKS__)                                \
+    || defined(__QNXNTO__) // POSIX systems
+#include <cstdint>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+namespace
+{
+    // returns an anonymous file of the given size, or -1
+    int create_ring_file(std::size_t size) noexcept
+    {
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+        auto fd = memfd_create("foonathan_memory_ring", MFD_CLOEXEC);
+#else
+        // the name is removed right away, it only has to be unique for a moment
+        char name[64];
+        std::snprintf(name, sizeof(name), "/foonathan_memory_ring_%ld_%lu",
+                      static_cast<long>(getpid()),
+                      static_cast<unsigned long>(reinterpret_cast<std::uintptr_t>(&name)));
+        auto fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (fd >= 0)
+            shm_unlink(name);
+#endif
+        if (fd >= 0 && ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+        return fd;
+    }
+
+    // maps the same file twice one after the other, returns nullptr if that fails
+    char* map_mirrored(std::size_t size) noexcept
+    {
+        auto fd = create_ring_file(size);
+        if (fd < 0)
+            return nullptr;
+
+        // reserve the address range of both mappings first, so nothing else is mapped in between
+        auto region = mmap(nullptr, 2u * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (region == MAP_FAILED)
+        {
+            close(fd);
+            return nullptr;
+        }
+
+        auto begin  = static_cast<char*>(region);
+        auto first  = mmap(begin, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+        auto second = first == MAP_FAILED ?
+                          MAP_FAILED :
+                          mmap(begin + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+                               fd, 0);
+        // the mappings keep the file alive
+        close(fd);
+        if (second == MAP_FAILED)
+        {
+            munmap(region, 2u * size);
+            return nullptr;
+        }
+        return begin;
+    }
+
+    void unmap_mirrored(char* memory, std::size_t size) noexcept
+    {
+        munmap(memory, 2u * size);
+    }
+} // namespace
+#else
+namespace
+{
+    char* map_mirrored(std::size_t) noexcept
+    {
+        return nullptr;
+    }
+
+    void unmap_mirrored(char*, std::size_t) noexcept {}
+} // namespace
+#endif
+
+namespace
+{
+    std::size_t round_up(std::size_t size, std::size_t multiple) noexcept
+    {
+        return (size + multiple - 1u) / multiple * multiple;
+    }
+
+    std::size_t& header_of(char* start) noexcept
+    {
+        return *reinterpret_cast<std::size_t*>(start);
+    }
+
+    std::size_t& offset_of(void* node) noexcept
+    {
+        return reinterpret_cast<std::size_t*>(node)[-1];
+    }
+} // namespace
+
+constexpr std::size_t ring_allocator::header_size;
+
+ring_allocator::ring_allocator(std::size_t capacity, bool mirrored)
+: begin_(nullptr),
+  capacity_(round_up(capacity == 0u ? 1u : capacity, virtual_memory_page_size)),
+  head_(0u),
+  tail_(0u),
+  mirrored_(false)
+{
+    if (mirrored)
+    {
+        begin_    = map_mirrored(capacity_);
+        mirrored_ = begin_ != nullptr;
+    }
+
+    if (!begin_)
+    {
+        auto no_pages = capacity_ / virtual_memory_page_size;
+        auto memory   = virtual_memory_reserve(no_pages);
+        if (memory && !virtual_memory_commit(memory, no_pages))
+        {
+            virtual_memory_release(memory, no_pages);
+            memory = nullptr;
+        }
+        if (!memory)
+            FOONATHAN_THROW(out_of_memory(info(), capacity_));
+        begin_ = static_cast<char*>(memory);
+    }
+}
+
+ring_allocator::~ring_allocator() noexcept
+{
+    if (!begin_)
+        return;
+
+#if FOONATHAN_MEMORY_DEBUG_LEAK_CHECK
+    if (!empty())
+        detail::debug_handle_memory_leak(info(), static_cast<std::ptrdiff_t>(tail_ - head_));
+#endif
+
+    if (mirrored_)
+        unmap_mirrored(begin_, capacity_);
+    else
+    {
+        auto no_pages = capacity_ / virtual_memory_page_size;
+        virtual_memory_decommit(begin_, no_pages);
+        virtual_memory_release(begin_, no_pages);
+    }
+}
+
+void* ring_allocator::allocate_node(std::size_t size, std::size_t alignment)
+{
+    auto node = try_allocate_node(size, alignment);
+    if (!node)
+        FOONATHAN_THROW(out_of_fixed_memory(info(), size));
+    return node;
+}
+
+void ring_allocator::deallocate_node(void* node, std::size_t size, std::size_t) noexcept
+{
+    detail::debug_check_pointer([&] { return owns(node); }, info(), node);
+    auto& header = header_of(static_cast<char*>(node) - offset_of(node));
+    detail::debug_check_double_dealloc([&] { return (header & 1u) == 0u; }, info(), node);
+
+    detail::debug_fill(node, size, debug_magic::freed_memory);
+    header |= 1u;
+    reclaim();
+}
+
+void* ring_allocator::try_allocate_node(std::size_t size, std::size_t alignment) noexcept
+{
+    FOONATHAN_MEMORY_ASSERT(detail::is_valid_alignment(alignment));
+    if (size > max_node_size() || alignment > max_alignment())
+        return nullptr;
+
+    // the header and the alignment buffer come first, the total is a multiple of the header
+    auto extent = [&](char* start)
+    {
+        auto node = start + header_size + detail::align_offset(start + header_size, alignment);
+        return round_up(std::size_t(node - start) + size, header_size);
+    };
+
+    auto offset = tail_ % capacity_;
+    auto total  = extent(begin_ + offset);
+    if (!mirrored_ && offset + total > capacity_)
+    {
+        // skip the rest of the region, it is reclaimed like a free node
+        auto skipped = capacity_ - offset;
+        auto front   = extent(begin_);
+        if (tail_ - head_ + skipped + front > capacity_)
+            return nullptr;
+
+        header_of(begin_ + offset) = skipped | 1u;
+        tail_ += skipped;
+        offset = 0u;
+        total  = front;
+    }
+    else if (tail_ - head_ + total > capacity_)
+        return nullptr;
+
+    auto start = begin_ + offset;
+    auto node  = start + header_size + detail::align_offset(start + header_size, alignment);
+    header_of(start) = total;
+    offset_of(node)  = std::size_t(node - start);
+    tail_ += total;
+    detail::debug_fill(node, size, debug_magic::new_memory);
+    return node;
+}
+
+bool ring_allocator::try_deallocate_node(void* node, std::size_t size,
+                                         std::size_t alignment) noexcept
+{
+    if (!owns(node))
+        return false;
+    deallocate_node(node, size, alignment);
+    return true;
+}
+
+std::size_t ring_allocator::max_alignment() const noexcept
+{
+    return virtual_memory_page_size;
+}
+
+allocator_info ring_allocator::info() const noexcept
+{
+    return {FOONATHAN_MEMORY_LOG_PREFIX "::ring_allocator", this};
+}
+
+bool ring_allocator::owns(const void* node) const noexcept
+{
+    auto ptr = static_cast<const char*>(node);
+    return begin_ <= ptr && ptr < begin_ + (mirrored_ ? 2u : 1u) * capacity_;
+}
+
+void ring_allocator::reclaim() noexcept
+{
+    while (head_ != tail_)
+    {
+        auto header = header_of(begin_ + head_ % capacity_);
+        if ((header & 1u) == 0u)
+            break;
+        head_ += header & ~std::size_t(1u);
+    }
+
+    // start at the beginning again, so that the next nodes do not need to wrap around
+    if (head_ == tail_)
+        head_ = tail_ = 0u;
+}
@@ -0,0 +1,103 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "sampled_debug_allocator.hpp"
+
+#if FOONATHAN_HOSTED_IMPLEMENTATION
+#include <cstring>
+#endif
+
+#include "debugging.hpp"
+
+using namespace foonathan::memory;
+using namespace detail;
+
+namespace
+{
+    // the markers are the last bytes of the header, right before the (front fence and) user memory
+    constexpr unsigned char allocated_marker = 0xA1;
+    constexpr unsigned char freed_marker     = 0xF1;
+
+    void fill(unsigned char* memory, std::size_t size, debug_magic m) noexcept
+    {
+#if FOONATHAN_HOSTED_IMPLEMENTATION
+        std::memset(memory, static_cast<int>(m), size);
+#else
+        for (auto end = memory + size; memory != end; ++memory)
+            *memory = static_cast<unsigned char>(m);
+#endif
+    }
+
+    void check_fence(void* user, std::size_t size, unsigned char* fence,
+                     std::size_t fence_size) noexcept
+    {
+        for (auto end = fence + fence_size; fence != end; ++fence)
+            if (*fence != static_cast<unsigned char>(debug_magic::fence_memory))
+            {
+                get_buffer_overflow_handler()(user, size, fence);
+                return;
+            }
+    }
+} // namespace
+
+bool detail::sampled_debug_next(std::size_t period) noexcept
+{
+    // counts down to the next sampled allocation
+    thread_local std::size_t countdown = 0u;
+    if (period == 0u)
+        return false;
+    if (countdown == 0u || countdown > period)
+        countdown = period;
+    return --countdown == 0u;
+}
+
+void* detail::sampled_debug_on_allocate(void* memory, std::size_t size, std::size_t prefix,
+                                        bool sampled) noexcept
+{
+    // front fence if sampled, header, user memory, back fence if sampled
+    auto header = static_cast<unsigned char*>(memory);
+    if (sampled)
+    {
+        fill(header, prefix, debug_magic::fence_memory);
+        header += prefix;
+    }
+    auto user = header + prefix;
+
+    // the markers are at the end of the header,
+    // after the memory an allocator might use for its free list
+    fill(header, prefix - 3u, debug_magic::internal_memory);
+    user[-3] = static_cast<unsigned char>(sampled ? debug_magic::fence_memory :
+                                                    debug_magic::internal_memory);
+    user[-2] = allocated_marker;
+    user[-1] = allocated_marker;
+
+    if (sampled)
+    {
+        fill(user, size, debug_magic::new_memory);
+        fill(user + size, prefix, debug_magic::fence_memory);
+    }
+    return user;
+}
+
+void* detail::sampled_debug_on_deallocate(const allocator_info& info, void* ptr, std::size_t size,
+                                          std::size_t prefix, bool& sampled) noexcept
+{
+    auto user = static_cast<unsigned char*>(ptr);
+    if (!user || user[-2] != allocated_marker || user[-1] != allocated_marker)
+    {
+        get_invalid_pointer_handler()(info, ptr);
+        return nullptr;
+    }
+    user[-2] = freed_marker;
+    user[-1] = freed_marker;
+
+    auto header = user - prefix;
+    sampled     = user[-3] == static_cast<unsigned char>(debug_magic::fence_memory);
+    if (!sampled)
+        return header;
+
+    check_fence(user, size, header - prefix, prefix);
+    check_fence(user, size, user + size, prefix);
+    fill(user, size, debug_magic::freed_memory);
+    return header - prefix;
+}
@@ -0,0 +1,185 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "sampling_tracker.hpp"
+
+#include <cmath>
+#include <cstdint>
+
+#include "detail/assert.hpp"
+#include "detail/utility.hpp"
+
+#if defined(__GLIBC__)
+#include <execinfo.h>
+#endif
+
+using namespace foonathan::memory;
+
+namespace
+{
+    // per-thread state for the distance to the next sample
+    struct sample_countdown
+    {
+        std::uint64_t  random_state;
+        std::ptrdiff_t bytes_left;
+        bool           initialized;
+    };
+
+    thread_local sample_countdown countdown = {0u, 0, false};
+
+    std::uint64_t next_random(std::uint64_t& state) noexcept
+    {
+        // xorshift64*
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1Dull;
+    }
+
+    // exponentially distributed with the given mean
+    std::ptrdiff_t next_sample_distance(std::uint64_t& state, std::size_t mean) noexcept
+    {
+        if (mean == 1u)
+            return 1;
+
+        // uniform in (0, 1]
+        auto u        = double((next_random(state) >> 11) + 1u) / double(std::uint64_t(1) << 53);
+        auto distance = -std::log(u) * double(mean);
+        return distance < 1.0 ? 1 : std::ptrdiff_t(distance);
+    }
+
+    void write_mapped_libraries(std::FILE* file)
+    {
+        std::fputs("\nMAPPED_LIBRARIES:\n", file);
+#if defined(__linux__)
+        if (auto maps = std::fopen("/proc/self/maps", "r"))
+        {
+            char        buffer[4096];
+            std::size_t read;
+            while ((read = std::fread(buffer, 1u, sizeof(buffer), maps)) != 0u)
+                std::fwrite(buffer, 1u, read, file);
+            std::fclose(maps);
+        }
+#endif
+    }
+} // namespace
+
+constexpr std::size_t heap_profile::default_sample_period;
+constexpr std::size_t heap_profile::max_stack_depth;
+constexpr std::size_t heap_profile::filter_size;
+
+heap_profile::heap_profile(std::size_t sample_period) noexcept : sample_period_(sample_period)
+{
+    FOONATHAN_MEMORY_ASSERT(sample_period > 0u);
+    for (auto& count : filter_)
+        count.store(0u, std::memory_order_relaxed);
+}
+
+void heap_profile::on_allocate(void* memory, std::size_t size) noexcept
+{
+    if (!countdown.initialized)
+    {
+        // seed with the address of the thread local, which is different for each thread
+        countdown.random_state = std::uint64_t(reinterpret_cast<std::uintptr_t>(&countdown)) | 1u;
+        countdown.bytes_left  = next_sample_distance(countdown.random_state, sample_period_);
+        countdown.initialized = true;
+    }
+
+    countdown.bytes_left -= std::ptrdiff_t(size);
+    if (countdown.bytes_left > 0)
+        return;
+    countdown.bytes_left = next_sample_distance(countdown.random_state, sample_period_);
+
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+    try
+#endif
+    {
+        // captured here directly, so only this function needs to be skipped
+        std::vector<void*> stack;
+#if defined(__GLIBC__)
+        void* frames[max_stack_depth + 1u];
+        auto  depth = backtrace(frames, int(max_stack_depth + 1u));
+        if (depth > 1)
+            stack.assign(frames + 1, frames + depth);
+#endif
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto site = sites_.emplace(detail::move(stack), call_site{0u, 0u, 0u, 0u}).first;
+        if (!samples_.emplace(memory, sample{size, site}).second)
+            return; // memory is already sampled, deallocation was not tracked
+
+        ++site->second.live_objects;
+        site->second.live_bytes += size;
+        ++site->second.allocated_objects;
+        site->second.allocated_bytes += size;
+        // pointer must be passed to the deallocating thread, which synchronizes
+        filter_[filter_index(memory)].fetch_add(1u, std::memory_order_relaxed);
+    }
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+    catch (...)
+    {
+        // out of memory, drop the sample
+    }
+#endif
+}
+
+void heap_profile::on_deallocate(void* memory) noexcept
+{
+    auto& count = filter_[filter_index(memory)];
+    if (count.load(std::memory_order_relaxed) == 0u)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto                        iter = samples_.find(memory);
+    if (iter == samples_.end())
+        return;
+
+    auto& site = iter->second.site->second;
+    --site.live_objects;
+    site.live_bytes -= iter->second.size;
+    samples_.erase(iter);
+    count.fetch_sub(1u, std::memory_order_relaxed);
+}
+
+void heap_profile::write_pprof(std::FILE* file) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    call_site total = {0u, 0u, 0u, 0u};
+    for (auto& site : sites_)
+    {
+        total.live_objects += site.second.live_objects;
+        total.live_bytes += site.second.live_bytes;
+        total.allocated_objects += site.second.allocated_objects;
+        total.allocated_bytes += site.second.allocated_bytes;
+    }
+
+    // heap_v2 tells pprof that the counts are sampled with the given period
+    std::fprintf(file, "heap profile: %zu: %zu [%zu: %zu] @ heap_v2/%zu\n", total.live_objects,
+                 total.live_bytes, total.allocated_objects, total.allocated_bytes,
+                 sample_period_);
+    for (auto& site : sites_)
+    {
+        std::fprintf(file, "%zu: %zu [%zu: %zu] @", site.second.live_objects,
+                     site.second.live_bytes, site.second.allocated_objects,
+                     site.second.allocated_bytes);
+        for (auto frame : site.first)
+            std::fprintf(file, " %p", frame);
+        std::fputc('\n', file);
+    }
+
+    write_mapped_libraries(file);
+}
+
+std::size_t heap_profile::live_samples() const noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return samples_.size();
+}
+
+std::size_t heap_profile::filter_index(void* memory) noexcept
+{
+    // fibonacci hashing, ignoring the lower bits which are mostly zero due to alignment
+    auto value = std::uint64_t(reinterpret_cast<std::uintptr_t>(memory) >> 4u);
+    return std::size_t((value * 0x9E3779B97F4A7C15ull) >> 54u) % filter_size;
+}
@@ -0,0 +1,15 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "sharded_allocator.hpp"
+
+#include <atomic>
+
+using namespace foonathan::memory;
+
+std::size_t detail::thread_shard_hint() noexcept
+{
+    static std::atomic<std::size_t> next(0u);
+    static thread_local std::size_t hint = next.fetch_add(1u, std::memory_order_relaxed);
+    return hint;
+}
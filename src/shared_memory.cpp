@@ -0,0 +1,174 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "shared_memory.hpp"
+
+#include "detail/debug_helpers.hpp"
+#include "virtual_memory.hpp"
+
+using namespace foonathan::memory;
+
+#if defined(_WIN32)
+#define FOONATHAN_MEMORY_IMPL_HAS_SHARED_MEMORY 1
+#include <windows.h>
+
+shared_memory_block_allocator::shared_memory_block_allocator(std::size_t block_size,
+                                                             std::size_t no_blocks,
+                                                             const char* name)
+: begin_(nullptr),
+  cur_(nullptr),
+  end_(nullptr),
+  block_size_(block_size),
+  size_(0u),
+  handle_(invalid_handle())
+{
+    FOONATHAN_MEMORY_ASSERT(block_size > 0u && block_size % virtual_memory_page_size == 0u);
+    FOONATHAN_MEMORY_ASSERT(no_blocks > 0u);
+    auto total_size = static_cast<unsigned long long>(block_size * no_blocks);
+
+    // opens the existing mapping if there is one, the entire size is reserved in the paging file
+    auto handle =
+        CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                           static_cast<DWORD>(total_size >> 32u),
+                           static_cast<DWORD>(total_size & 0xFFFFFFFFu), name);
+    if (!handle)
+        FOONATHAN_THROW(out_of_memory(info(), block_size * no_blocks));
+
+    auto memory = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0u, 0u, block_size * no_blocks);
+    if (!memory)
+    {
+        CloseHandle(handle);
+        FOONATHAN_THROW(out_of_memory(info(), block_size * no_blocks));
+    }
+
+    handle_ = reinterpret_cast<std::intptr_t>(handle);
+    begin_ = cur_ = static_cast<char*>(memory);
+    end_          = begin_ + block_size * no_blocks;
+    size_         = block_size * no_blocks;
+}
+
+shared_memory_block_allocator::~shared_memory_block_allocator() noexcept
+{
+    if (begin_)
+        UnmapViewOfFile(begin_);
+    if (handle_ != invalid_handle())
+        CloseHandle(reinterpret_cast<HANDLE>(handle_));
+}
+
+memory_block shared_memory_block_allocator::allocate_block()
+{
+    if (std::size_t(end_ - cur_) < block_size_)
+        FOONATHAN_THROW(out_of_fixed_memory(info(), block_size_));
+
+    auto mem = cur_;
+    cur_ += block_size_;
+    return {mem, block_size_};
+}
+
+bool shared_memory_block_allocator::remove(const char*) noexcept
+{
+    return true;
+}
+#elif defined(__unix__) || defined(__APPLE__) || defined(__VXWORKS__)                              \
+    || defined(__QNXNTO__) // POSIX systems
+#define FOONATHAN_MEMORY_IMPL_HAS_SHARED_MEMORY 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+shared_memory_block_allocator::shared_memory_block_allocator(std::size_t block_size,
+                                                             std::size_t no_blocks,
+                                                             const char* name)
+: begin_(nullptr),
+  cur_(nullptr),
+  end_(nullptr),
+  block_size_(block_size),
+  size_(0u),
+  handle_(invalid_handle())
+{
+    FOONATHAN_MEMORY_ASSERT(block_size > 0u && block_size % virtual_memory_page_size == 0u);
+    FOONATHAN_MEMORY_ASSERT(no_blocks > 0u);
+    auto total_size = block_size * no_blocks;
+
+    struct stat status;
+    auto        fd = shm_open(name, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0 || fstat(fd, &status) != 0)
+    {
+        if (fd >= 0)
+            close(fd);
+        FOONATHAN_THROW(out_of_memory(info(), total_size));
+    }
+
+    // the shared memory object only grows when blocks are allocated,
+    // until then the pages beyond its end must not be accessed
+    auto memory = mmap(nullptr, total_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED)
+    {
+        close(fd);
+        FOONATHAN_THROW(out_of_memory(info(), total_size));
+    }
+
+    handle_ = fd;
+    begin_ = cur_ = static_cast<char*>(memory);
+    end_          = begin_ + total_size;
+    size_         = static_cast<std::size_t>(status.st_size);
+}
+
+shared_memory_block_allocator::~shared_memory_block_allocator() noexcept
+{
+    if (begin_)
+        munmap(begin_, static_cast<std::size_t>(end_ - begin_));
+    if (handle_ != invalid_handle())
+        close(static_cast<int>(handle_));
+}
+
+memory_block shared_memory_block_allocator::allocate_block()
+{
+    if (std::size_t(end_ - cur_) < block_size_)
+        FOONATHAN_THROW(out_of_fixed_memory(info(), block_size_));
+
+    auto needed = std::size_t(cur_ - begin_) + block_size_;
+    if (needed > size_)
+    {
+        if (ftruncate(static_cast<int>(handle_), static_cast<off_t>(needed)) != 0)
+            FOONATHAN_THROW(out_of_memory(info(), block_size_));
+        size_ = needed;
+    }
+
+    auto mem = cur_;
+    cur_ += block_size_;
+    return {mem, block_size_};
+}
+
+bool shared_memory_block_allocator::remove(const char* name) noexcept
+{
+    return shm_unlink(name) == 0;
+}
+#else
+#warning "shared_memory_block_allocator not available on your platform"
+#endif
+
+#if defined(FOONATHAN_MEMORY_IMPL_HAS_SHARED_MEMORY)
+void shared_memory_block_allocator::deallocate_block(memory_block block) noexcept
+{
+    detail::debug_check_pointer([&]
+                                { return static_cast<char*>(block.memory) == cur_ - block_size_; },
+                                info(), block.memory);
+    cur_ -= block_size_;
+}
+
+std::size_t shared_memory_block_allocator::block_alignment() const noexcept
+{
+    return get_virtual_memory_page_size();
+}
+
+allocator_info shared_memory_block_allocator::info() noexcept
+{
+    return {FOONATHAN_MEMORY_LOG_PREFIX "::shared_memory_block_allocator", this};
+}
+#endif
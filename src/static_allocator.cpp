@@ -26,6 +26,28 @@ allocator_info static_allocator::info() const noexcept
 template class foonathan::memory::allocator_traits<static_allocator>;
 #endif
 
+atomic_static_allocator::atomic_static_allocator(const memory_block& block) noexcept
+: stack_(block.memory), begin_(stack_.top()), end_(begin_ + block.size)
+{
+}
+
+void* atomic_static_allocator::allocate_node(std::size_t size, std::size_t alignment)
+{
+    auto mem = stack_.allocate(end_, size, alignment);
+    if (!mem)
+        FOONATHAN_THROW(out_of_fixed_memory(info(), size));
+    return mem;
+}
+
+allocator_info atomic_static_allocator::info() const noexcept
+{
+    return {FOONATHAN_MEMORY_LOG_PREFIX "::atomic_static_allocator", this};
+}
+
+#if FOONATHAN_MEMORY_EXTERN_TEMPLATE
+template class foonathan::memory::allocator_traits<atomic_static_allocator>;
+#endif
+
 memory_block static_block_allocator::allocate_block()
 {
     if (cur_ + block_size_ > end_)
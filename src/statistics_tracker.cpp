@@ -0,0 +1,206 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "statistics_tracker.hpp"
+
+#include <cstring>
+
+#include "detail/ilog2.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    // threads are assigned a shard round-robin on their first event
+    std::size_t current_shard(std::size_t shard_count) noexcept
+    {
+        static std::atomic<std::size_t> next_shard(0u);
+        thread_local const std::size_t  shard = next_shard.fetch_add(1u, std::memory_order_relaxed);
+        return shard % shard_count;
+    }
+
+    std::size_t size_class(std::size_t size) noexcept
+    {
+        if (size <= 1u)
+            return 0u;
+        auto result = detail::ilog2_ceil(size);
+        return result < allocation_histogram_size ? result : allocation_histogram_size - 1u;
+    }
+
+    void add(std::atomic<std::size_t>& counter, std::size_t value) noexcept
+    {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    std::size_t get(const std::atomic<std::size_t>& counter) noexcept
+    {
+        return counter.load(std::memory_order_relaxed);
+    }
+    const char statistics_header[] = "foonathan_memory_statistics 1";
+
+    struct statistics_member
+    {
+        const char* name;
+        std::size_t allocation_statistics_snapshot::*member;
+    };
+
+    const statistics_member statistics_members[] = {
+        {"allocations", &allocation_statistics_snapshot::allocations},
+        {"deallocations", &allocation_statistics_snapshot::deallocations},
+        {"bytes_allocated", &allocation_statistics_snapshot::bytes_allocated},
+        {"bytes_deallocated", &allocation_statistics_snapshot::bytes_deallocated},
+        {"live_bytes", &allocation_statistics_snapshot::live_bytes},
+        {"peak_bytes", &allocation_statistics_snapshot::peak_bytes},
+        {"growths", &allocation_statistics_snapshot::growths},
+        {"shrinks", &allocation_statistics_snapshot::shrinks},
+        {"block_bytes", &allocation_statistics_snapshot::block_bytes},
+    };
+} // namespace
+
+bool foonathan::memory::write_statistics(std::FILE*                            file,
+                                         const allocation_statistics_snapshot& snapshot) noexcept
+{
+    auto good = std::fprintf(file, "%s\n", statistics_header) > 0;
+    for (auto& m : statistics_members)
+        good = std::fprintf(file, "%s %llu\n", m.name,
+                            static_cast<unsigned long long>(snapshot.*m.member))
+                   > 0
+               && good;
+    for (std::size_t i = 0u; i != allocation_histogram_size; ++i)
+        if (snapshot.histogram[i] != 0u)
+            good = std::fprintf(file, "histogram %u %llu\n", static_cast<unsigned>(i),
+                                static_cast<unsigned long long>(snapshot.histogram[i]))
+                       > 0
+                   && good;
+    return good;
+}
+
+bool foonathan::memory::read_statistics(std::FILE*                      file,
+                                        allocation_statistics_snapshot& snapshot) noexcept
+{
+    snapshot = {};
+
+    char line[128];
+    if (!std::fgets(line, sizeof(line), file)
+        || std::strncmp(line, statistics_header, sizeof(statistics_header) - 1u) != 0)
+        return false;
+
+    while (std::fgets(line, sizeof(line), file))
+    {
+        char               name[64];
+        unsigned long long value = 0u;
+        unsigned           index = 0u;
+        if (std::sscanf(line, "histogram %u %llu", &index, &value) == 2)
+        {
+            if (index >= allocation_histogram_size)
+                return false;
+            snapshot.histogram[index] = std::size_t(value);
+            continue;
+        }
+        else if (std::sscanf(line, "%63s %llu", name, &value) != 2)
+            return false;
+
+        // unknown members are ignored, so newer files can still be read
+        for (auto& m : statistics_members)
+            if (std::strcmp(m.name, name) == 0)
+                snapshot.*m.member = std::size_t(value);
+    }
+    return std::feof(file) != 0;
+}
+
+constexpr std::size_t allocation_statistics::peak_granularity;
+constexpr std::size_t allocation_statistics::shard_count;
+
+allocation_statistics::allocation_statistics() noexcept
+: shards_(), live_bytes_(0), peak_bytes_(0u)
+{
+}
+
+void allocation_statistics::on_allocate(std::size_t size) noexcept
+{
+    auto& s = shards_[current_shard(shard_count)];
+    add(s.allocations, 1u);
+    add(s.bytes_allocated, size);
+    add(s.histogram[size_class(size)], 1u);
+
+    // live bytes are only propagated in bigger steps to avoid contention
+    auto unflushed =
+        s.unflushed_bytes.fetch_add(std::ptrdiff_t(size), std::memory_order_relaxed)
+        + std::ptrdiff_t(size);
+    if (unflushed >= std::ptrdiff_t(peak_granularity))
+        flush(s);
+}
+
+void allocation_statistics::on_deallocate(std::size_t size) noexcept
+{
+    auto& s = shards_[current_shard(shard_count)];
+    add(s.deallocations, 1u);
+    add(s.bytes_deallocated, size);
+
+    auto unflushed =
+        s.unflushed_bytes.fetch_sub(std::ptrdiff_t(size), std::memory_order_relaxed)
+        - std::ptrdiff_t(size);
+    if (unflushed <= -std::ptrdiff_t(peak_granularity))
+        flush(s);
+}
+
+void allocation_statistics::on_growth(std::size_t size) noexcept
+{
+    auto& s = shards_[current_shard(shard_count)];
+    add(s.growths, 1u);
+    add(s.block_bytes_allocated, size);
+}
+
+void allocation_statistics::on_shrinking(std::size_t size) noexcept
+{
+    auto& s = shards_[current_shard(shard_count)];
+    add(s.shrinks, 1u);
+    add(s.block_bytes_deallocated, size);
+}
+
+void allocation_statistics::flush(shard& s) noexcept
+{
+    auto amount = s.unflushed_bytes.exchange(0, std::memory_order_relaxed);
+    auto live   = live_bytes_.fetch_add(amount, std::memory_order_relaxed) + amount;
+    if (live <= 0)
+        return;
+
+    auto peak = peak_bytes_.load(std::memory_order_relaxed);
+    while (std::size_t(live) > peak
+           && !peak_bytes_.compare_exchange_weak(peak, std::size_t(live),
+                                                 std::memory_order_relaxed))
+    {
+    }
+}
+
+allocation_statistics_snapshot allocation_statistics::snapshot() const noexcept
+{
+    allocation_statistics_snapshot result = {};
+
+    std::size_t block_bytes_allocated = 0u, block_bytes_deallocated = 0u;
+    for (auto& s : shards_)
+    {
+        result.allocations += get(s.allocations);
+        result.deallocations += get(s.deallocations);
+        result.bytes_allocated += get(s.bytes_allocated);
+        result.bytes_deallocated += get(s.bytes_deallocated);
+        result.growths += get(s.growths);
+        result.shrinks += get(s.shrinks);
+        block_bytes_allocated += get(s.block_bytes_allocated);
+        block_bytes_deallocated += get(s.block_bytes_deallocated);
+        for (std::size_t i = 0u; i != allocation_histogram_size; ++i)
+            result.histogram[i] += get(s.histogram[i]);
+    }
+
+    // the counters are read one after the other, so clamp in case of concurrent updates
+    result.live_bytes = result.bytes_allocated > result.bytes_deallocated ?
+                            result.bytes_allocated - result.bytes_deallocated :
+                            0u;
+    result.block_bytes = block_bytes_allocated > block_bytes_deallocated ?
+                             block_bytes_allocated - block_bytes_deallocated :
+                             0u;
+
+    auto peak         = get(peak_bytes_);
+    result.peak_bytes = peak > result.live_bytes ? peak : result.live_bytes;
+    return result;
+}
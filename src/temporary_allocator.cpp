@@ -3,6 +3,7 @@
 
 #include "temporary_allocator.hpp"
 
+#include <atomic>
 #include <new>
 #include <type_traits>
 
@@ -94,19 +95,55 @@ public:
         if (auto ptr = find_unused())
         {
             FOONATHAN_MEMORY_ASSERT(ptr->in_use_);
-            ptr->stack_ = detail::temporary_stack_impl(size);
+            // adopt the retired stack with its blocks, unless its first block is too small
+            ptr->lock();
+            if (detail::temporary_stack_impl::min_block_size(ptr->stack_.capacity_left()) < size)
+                ptr->stack_ = detail::temporary_stack_impl(size);
+            ptr->set_growth_tracker(default_growth_tracker);
+            ptr->unlock();
             return ptr;
         }
         return create_new(size);
     }
 
-    void clear(temporary_stack& stack)
+    void reserve(std::size_t count, std::size_t size, bool prefault)
     {
-        // stack should be empty now, so shrink_to_fit() clears all memory
-        stack.stack_.shrink_to_fit();
+        for (std::size_t i = 0u; i != count; ++i)
+        {
+            auto stack = create_new(size);
+            if (prefault)
+                stack->prefault();
+            stack->in_use_ = false;
+        }
+    }
+
+    // stack should be empty now
+    // keeps its blocks for the next thread, unless release is true
+    void clear(temporary_stack& stack, bool release)
+    {
+        if (release)
+        {
+            stack.lock();
+            stack.stack_.shrink_to_fit();
+            stack.unlock();
+        }
         stack.in_use_ = false; // mark as free
     }
 
+    void trim()
+    {
+        for (auto ptr = first.load(); ptr; ptr = ptr->next_)
+        {
+            auto& stack = static_cast<temporary_stack&>(*ptr);
+            // skip stacks with an active allocator
+            if (stack.try_lock())
+            {
+                stack.stack_.shrink_to_fit();
+                stack.unlock();
+            }
+        }
+    }
+
     void destroy()
     {
         for (auto ptr = first.exchange(nullptr); ptr;)
@@ -141,12 +178,15 @@ namespace
                 // and that destructor uses the temporary allocator
                 // the stack needs to grow again
                 // but who does temporary allocation in a destructor?!
-                temporary_stack_list_obj.clear(*temp_stack);
+                // the cached blocks are kept, so the next thread starts with a warm stack
+                temporary_stack_list_obj.clear(*temp_stack, false);
+            temp_stack = nullptr;
         }
     } thread_exit_detector;
 } // namespace
 
-detail::temporary_stack_list_node::temporary_stack_list_node(int) noexcept : in_use_(true)
+detail::temporary_stack_list_node::temporary_stack_list_node(int) noexcept
+: in_use_(true), locked_(false)
 {
     next_ = temporary_stack_list_obj.first.load();
     while (!temporary_stack_list_obj.first.compare_exchange_weak(next_, this))
@@ -161,14 +201,17 @@ detail::temporary_allocator_dtor_t::temporary_allocator_dtor_t() noexcept
 
 detail::temporary_allocator_dtor_t::~temporary_allocator_dtor_t() noexcept
 {
-    if (--nifty_counter == 0u && temp_stack)
+    if (--nifty_counter == 0u && temporary_stack_list_obj.first.load())
         temporary_stack_list_obj.destroy();
 }
 
 temporary_stack_initializer::temporary_stack_initializer(std::size_t initial_size)
 {
     if (!temp_stack)
+    {
         temp_stack = temporary_stack_list_obj.create(initial_size);
+        (void)&thread_exit_detector; // ODR-use it, so an adopted stack is cleared as well
+    }
 }
 
 temporary_stack_initializer::~temporary_stack_initializer() noexcept
@@ -176,16 +219,32 @@ temporary_stack_initializer::~temporary_stack_initializer() noexcept
     // don't destroy, nifty counter does that
     // but can get rid of all the memory
     if (temp_stack)
-        temporary_stack_list_obj.clear(*temp_stack);
+        temporary_stack_list_obj.clear(*temp_stack, true);
+    // it may be adopted by another thread now
+    temp_stack = nullptr;
 }
 
 temporary_stack& foonathan::memory::get_temporary_stack(std::size_t initial_size)
 {
     if (!temp_stack)
+    {
         temp_stack = temporary_stack_list_obj.create(initial_size);
+        (void)&thread_exit_detector; // ODR-use it, so an adopted stack is cleared as well
+    }
     return *temp_stack;
 }
 
+void foonathan::memory::trim_temporary_stacks() noexcept
+{
+    temporary_stack_list_obj.trim();
+}
+
+void foonathan::memory::reserve_temporary_stacks(std::size_t count, std::size_t initial_size,
+                                                 bool prefault)
+{
+    temporary_stack_list_obj.reserve(count, initial_size, prefault);
+}
+
 #elif FOONATHAN_MEMORY_TEMPORARY_STACK_MODE == 1
 
 namespace
@@ -227,6 +286,10 @@ temporary_stack& foonathan::memory::get_temporary_stack(std::size_t initial_size
     return get();
 }
 
+void foonathan::memory::trim_temporary_stacks() noexcept {}
+
+void foonathan::memory::reserve_temporary_stacks(std::size_t, std::size_t, bool) {}
+
 #else
 
 // no lifetime managment
@@ -248,14 +311,47 @@ temporary_stack& foonathan::memory::get_temporary_stack(std::size_t)
     std::abort();
 }
 
+void foonathan::memory::trim_temporary_stacks() noexcept {}
+
+void foonathan::memory::reserve_temporary_stacks(std::size_t, std::size_t, bool) {}
+
 #endif
 
 const temporary_stack_initializer::defer_create_t temporary_stack_initializer::defer_create;
 
-temporary_allocator::temporary_allocator() : temporary_allocator(get_temporary_stack()) {}
+namespace
+{
+    thread_local temporary_stack*          bound_stack = nullptr;
+    std::atomic<temporary_stack_provider> stack_provider(nullptr);
+} // namespace
+
+temporary_stack* foonathan::memory::bind_temporary_stack(temporary_stack* stack) noexcept
+{
+    auto prev   = bound_stack;
+    bound_stack = stack;
+    return prev;
+}
+
+temporary_stack_provider foonathan::memory::set_temporary_stack_provider(
+    temporary_stack_provider p) noexcept
+{
+    return stack_provider.exchange(p, std::memory_order_acq_rel);
+}
+
+temporary_stack& foonathan::memory::get_current_temporary_stack(std::size_t initial_size)
+{
+    if (bound_stack)
+        return *bound_stack;
+    else if (auto provider = stack_provider.load(std::memory_order_acquire))
+        if (auto stack = provider())
+            return *stack;
+    return get_temporary_stack(initial_size);
+}
+
+temporary_allocator::temporary_allocator() : temporary_allocator(get_current_temporary_stack()) {}
 
 temporary_allocator::temporary_allocator(temporary_stack& stack)
-: unwind_(stack), prev_(stack.top_), shrink_to_fit_(false)
+: unwind_(lock_stack(stack)), prev_(stack.top_), shrink_to_fit_(false)
 {
     FOONATHAN_MEMORY_ASSERT(!prev_ || prev_->is_active());
     stack.top_ = this;
@@ -271,15 +367,36 @@ temporary_allocator::~temporary_allocator() noexcept
         if (shrink_to_fit_)
             // to call shrink_to_fit() afterwards
             stack.stack_.shrink_to_fit();
+        if (!prev_)
+        {
+            unwind_.release(); // already unwound, don't touch the stack after unlocking
+            stack.unlock();
+        }
     }
 }
 
+temporary_stack& temporary_allocator::lock_stack(temporary_stack& stack) noexcept
+{
+    // the outermost allocator keeps trim_temporary_stacks() away,
+    // before the marker is taken
+    if (!stack.top_)
+        stack.lock();
+    return stack;
+}
+
 void* temporary_allocator::allocate(std::size_t size, std::size_t alignment)
 {
     FOONATHAN_MEMORY_ASSERT_MSG(is_active(), "object isn't the active allocator");
     return unwind_.get_stack().stack_.allocate(size, alignment);
 }
 
+bool temporary_allocator::try_expand(void* memory, std::size_t old_size,
+                                     std::size_t new_size) noexcept
+{
+    FOONATHAN_MEMORY_ASSERT_MSG(is_active(), "object isn't the active allocator");
+    return unwind_.get_stack().stack_.try_expand(memory, old_size, new_size);
+}
+
 void temporary_allocator::shrink_to_fit() noexcept
 {
     shrink_to_fit_ = true;
@@ -0,0 +1,169 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "thread_cached_pool.hpp"
+
+#include <new>
+
+#include "heap_allocator.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    // protects the global list and the ownership of the caches
+    // the per-object mutex is only locked while holding it, never the other way round
+    std::mutex& cache_mutex() noexcept
+    {
+        static std::mutex m;
+        return m;
+    }
+
+    detail::thread_cache* global_caches = nullptr;
+
+    std::size_t cache_size(std::size_t capacity) noexcept
+    {
+        return sizeof(detail::thread_cache) + capacity * sizeof(void*);
+    }
+
+    thread_local struct thread_cache_list
+    {
+        detail::thread_cache* first = nullptr;
+
+        ~thread_cache_list() noexcept
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex());
+            for (auto cache = first; cache;)
+            {
+                auto next  = cache->next_in_thread;
+                auto owner = cache->owner.load(std::memory_order_relaxed);
+                if (owner && !cache->adopt)
+                    // return all nodes to owner, it is still alive as we hold the lock
+                    cache->flush(owner, *cache);
+                if (!owner || !cache->adopt)
+                {
+                    // mark as unused, it can be reused by any new thread
+                    cache->owner.store(nullptr, std::memory_order_relaxed);
+                    cache->count = 0u;
+                }
+                // otherwise it is orphaned with its contents until a new thread adopts it
+                cache->next_in_thread = cache;
+                cache                 = next;
+            }
+            first = nullptr;
+        }
+    } thread_caches;
+
+    // the caches of exited threads point to themselves instead of being part of a thread list
+    bool is_detached(const detail::thread_cache& cache) noexcept
+    {
+        return cache.next_in_thread == &cache;
+    }
+
+    // searches for an unused cache of an exited thread
+    detail::thread_cache* find_unused(std::size_t capacity) noexcept
+    {
+        for (auto cache = global_caches; cache; cache = cache->next_global)
+            if (!cache->owner.load(std::memory_order_relaxed) && cache->capacity == capacity
+                && is_detached(*cache))
+                return cache;
+        return nullptr;
+    }
+
+    // searches for an orphaned cache of the owner, it still has its contents
+    detail::thread_cache* find_orphan(void* owner, std::size_t capacity) noexcept
+    {
+        for (auto cache = global_caches; cache; cache = cache->next_global)
+            if (cache->owner.load(std::memory_order_relaxed) == owner
+                && cache->capacity == capacity && is_detached(*cache))
+                return cache;
+        return nullptr;
+    }
+} // namespace
+
+detail::thread_cache* detail::get_thread_cache(void* owner, std::size_t capacity,
+                                                thread_cache::flush_fn flush, bool adopt) noexcept
+{
+    // search for an existing cache of this thread first, no lock required
+    for (auto cache = thread_caches.first; cache; cache = cache->next_in_thread)
+        if (cache->owner.load(std::memory_order_relaxed) == owner)
+            return cache;
+
+    std::lock_guard<std::mutex> lock(cache_mutex());
+    // reuse a detached cache of this thread
+    for (auto cache = thread_caches.first; cache; cache = cache->next_in_thread)
+        if (!cache->owner.load(std::memory_order_relaxed) && cache->capacity == capacity)
+        {
+            cache->flush = flush;
+            cache->count = 0u;
+            cache->adopt = adopt;
+            cache->owner.store(owner, std::memory_order_relaxed);
+            return cache;
+        }
+
+    if (auto orphan = adopt ? find_orphan(owner, capacity) : nullptr)
+    {
+        // adopt it with its contents
+        orphan->next_in_thread = thread_caches.first;
+        thread_caches.first    = orphan;
+        return orphan;
+    }
+
+    auto cache = find_unused(capacity);
+    if (!cache)
+    {
+        auto memory = heap_alloc(cache_size(capacity));
+        if (!memory)
+            return nullptr;
+        cache              = ::new (memory) thread_cache;
+        cache->capacity    = capacity;
+        cache->next_global = global_caches;
+        global_caches      = cache;
+    }
+
+    cache->next_in_thread = thread_caches.first;
+    thread_caches.first   = cache;
+    cache->flush          = flush;
+    cache->count          = 0u;
+    cache->adopt          = adopt;
+    cache->owner.store(owner, std::memory_order_relaxed);
+    return cache;
+}
+
+void detail::flush_thread_caches(void* owner) noexcept
+{
+    std::lock_guard<std::mutex> lock(cache_mutex());
+    for (auto cache = global_caches; cache; cache = cache->next_global)
+        if (cache->owner.load(std::memory_order_relaxed) == owner)
+        {
+            cache->flush(owner, *cache);
+            cache->owner.store(nullptr, std::memory_order_relaxed);
+            cache->count = 0u;
+        }
+}
+
+void detail::release_thread_caches(void* owner) noexcept
+{
+    std::lock_guard<std::mutex> lock(cache_mutex());
+    for (auto cache = global_caches; cache; cache = cache->next_global)
+        if (cache->owner.load(std::memory_order_relaxed) == owner)
+        {
+            cache->owner.store(nullptr, std::memory_order_relaxed);
+            cache->count = 0u;
+        }
+}
+
+std::size_t detail::flush_orphaned_thread_caches(void* owner) noexcept
+{
+    std::lock_guard<std::mutex> lock(cache_mutex());
+    auto                        count = std::size_t(0u);
+    for (auto cache = global_caches; cache; cache = cache->next_global)
+        if (cache->owner.load(std::memory_order_relaxed) == owner && is_detached(*cache))
+        {
+            cache->flush(owner, *cache);
+            cache->owner.store(nullptr, std::memory_order_relaxed);
+            cache->count = 0u;
+            ++count;
+        }
+    return count;
+}
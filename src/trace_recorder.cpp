@@ -0,0 +1,145 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "trace_recorder.hpp"
+
+#include <atomic>
+#include <cstring>
+
+#include "detail/assert.hpp"
+#include "detail/ilog2.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    std::atomic<std::uint16_t> next_thread_index(0u);
+
+    std::uint16_t current_thread_index() noexcept
+    {
+        thread_local std::uint16_t index =
+            next_thread_index.fetch_add(1u, std::memory_order_relaxed);
+        return index;
+    }
+} // namespace
+
+constexpr char        allocation_trace::file_magic[9];
+constexpr std::size_t allocation_trace::buffer_size;
+
+allocation_trace::allocation_trace()
+: start_(std::chrono::steady_clock::now()), file_(nullptr), size_(0u), good_(true)
+{
+}
+
+allocation_trace::allocation_trace(std::FILE* file)
+: start_(std::chrono::steady_clock::now()), file_(file), size_(0u), good_(true)
+{
+    FOONATHAN_MEMORY_ASSERT(file);
+    buffer_.reserve(buffer_size);
+    good_ = std::fwrite(file_magic, 1u, 8u, file_) == 8u;
+}
+
+allocation_trace::~allocation_trace() noexcept
+{
+    flush();
+}
+
+void allocation_trace::record(trace_event_kind kind, const void* memory, std::size_t size,
+                              std::size_t count, std::size_t alignment) noexcept
+{
+    trace_event event;
+    event.address        = reinterpret_cast<std::uintptr_t>(memory);
+    event.size           = size;
+    event.count          = static_cast<std::uint32_t>(count);
+    event.thread         = current_thread_index();
+    event.kind           = kind;
+    event.alignment_log2 = static_cast<std::uint8_t>(detail::ilog2(alignment));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // taken under the lock, so the timestamps are ordered like the events
+    event.timestamp = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()
+                                                             - start_)
+            .count());
+    ++size_;
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+    try
+    {
+        buffer_.push_back(event);
+    }
+    catch (...)
+    {
+        good_ = false;
+        return;
+    }
+#else
+    buffer_.push_back(event);
+#endif
+    if (file_ && buffer_.size() == buffer_size)
+        write_buffer();
+}
+
+void allocation_trace::flush() noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_)
+    {
+        write_buffer();
+        good_ = std::fflush(file_) == 0 && good_;
+    }
+}
+
+bool allocation_trace::write(std::FILE* file) const noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    FOONATHAN_MEMORY_ASSERT(!file_);
+    return std::fwrite(file_magic, 1u, 8u, file) == 8u
+           && std::fwrite(buffer_.data(), sizeof(trace_event), buffer_.size(), file)
+                  == buffer_.size();
+}
+
+bool allocation_trace::read(std::FILE* file, std::vector<trace_event>& events)
+{
+    char magic[8];
+    if (std::fread(magic, 1u, 8u, file) != 8u || std::memcmp(magic, file_magic, 8u) != 0)
+        return false;
+
+    trace_event buffer[256];
+    std::size_t bytes;
+    do
+    {
+        bytes = std::fread(buffer, 1u, sizeof(buffer), file);
+        events.insert(events.end(), buffer, buffer + bytes / sizeof(trace_event));
+    } while (bytes == sizeof(buffer));
+    // a partial event means the file is truncated
+    return bytes % sizeof(trace_event) == 0u && !std::ferror(file);
+}
+
+std::vector<trace_event> allocation_trace::events() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return buffer_;
+}
+
+std::size_t allocation_trace::size() const noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+}
+
+bool allocation_trace::good() const noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return good_;
+}
+
+void allocation_trace::write_buffer() noexcept
+{
+    if (!buffer_.empty())
+    {
+        good_ = std::fwrite(buffer_.data(), sizeof(trace_event), buffer_.size(), file_)
+                    == buffer_.size()
+                && good_;
+        buffer_.clear();
+    }
+}
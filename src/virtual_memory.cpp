@@ -3,6 +3,9 @@
 
 #include "virtual_memory.hpp"
 
+#include <cstring>
+
+#include "detail/align.hpp"
 #include "detail/debug_helpers.hpp"
 #include "error.hpp"
 #include "memory_arena.hpp"
@@ -71,8 +74,42 @@ void foonathan::memory::virtual_memory_decommit(void* memory, std::size_t no_pag
     auto result = VirtualFree(memory, no_pages * virtual_memory_page_size, MEM_DECOMMIT);
     FOONATHAN_MEMORY_ASSERT_MSG(result, "cannot decommit memory");
 }
+
+// large pages require MEM_LARGE_PAGES on reservation and commit at the same time
+// as well as a special privilege, so they are not supported
+std::size_t foonathan::memory::get_virtual_memory_huge_page_size() noexcept
+{
+    return 0u;
+}
+
+void* foonathan::memory::virtual_memory_commit(void* memory, std::size_t no_pages,
+                                               virtual_memory_page_mode) noexcept
+{
+    return virtual_memory_commit(memory, no_pages);
+}
+
+bool foonathan::memory::lock_memory(void* memory, std::size_t size) noexcept
+{
+    return VirtualLock(memory, size) != 0;
+}
+
+void foonathan::memory::unlock_memory(void* memory, std::size_t size) noexcept
+{
+    VirtualUnlock(memory, size);
+}
+
+namespace
+{
+    // huge pages are not supported, so no alignment is required
+    void* reserve_for_huge_pages(std::size_t no_pages, std::size_t) noexcept
+    {
+        return virtual_memory_reserve(no_pages);
+    }
+} // namespace
 #elif defined(__unix__) || defined(__APPLE__) || defined(__VXWORKS__)                              \
     || defined(__QNXNTO__) // POSIX systems
+#include <cstdio>
+#include <cstring>
 #include <sys/mman.h>
 #include <unistd.h>
 
@@ -136,6 +173,87 @@ void foonathan::memory::virtual_memory_decommit(void* memory, std::size_t no_pag
     FOONATHAN_MEMORY_ASSERT_MSG(result == 0, "cannot decommit memory");
     (void)result;
 }
+
+namespace
+{
+    std::size_t get_huge_page_size() noexcept
+    {
+#if defined(MADV_HUGEPAGE)
+        // transparent huge pages can be used unless they are disabled completely
+        char buffer[64] = {};
+        auto enabled    = std::fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+        if (!enabled)
+            return 0u;
+        auto read = std::fgets(buffer, sizeof(buffer), enabled);
+        std::fclose(enabled);
+        if (!read || std::strstr(buffer, "[never]"))
+            return 0u;
+
+        unsigned long size = 0u;
+        auto          file = std::fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r");
+        if (!file)
+            return 0u;
+        if (std::fscanf(file, "%lu", &size) != 1)
+            size = 0u;
+        std::fclose(file);
+        return size > virtual_memory_page_size && size % virtual_memory_page_size == 0u ?
+                   std::size_t(size) :
+                   0u;
+#else
+        return 0u;
+#endif
+    }
+
+    // reserves the pages so that they start at a multiple of alignment
+    // the pages around it are released again, so it can be released as usual
+    void* reserve_for_huge_pages(std::size_t no_pages, std::size_t alignment) noexcept
+    {
+        auto extra_pages = alignment / virtual_memory_page_size - 1u;
+        auto pages       = static_cast<char*>(virtual_memory_reserve(no_pages + extra_pages));
+        if (!pages)
+            return nullptr;
+
+        auto offset = detail::align_offset(pages, alignment);
+        if (offset != 0u)
+            virtual_memory_release(pages, offset / virtual_memory_page_size);
+        if (offset != extra_pages * virtual_memory_page_size)
+            virtual_memory_release(pages + offset + no_pages * virtual_memory_page_size,
+                                   extra_pages - offset / virtual_memory_page_size);
+        return pages + offset;
+    }
+} // namespace
+
+std::size_t foonathan::memory::get_virtual_memory_huge_page_size() noexcept
+{
+    static const std::size_t size = get_huge_page_size();
+    return size;
+}
+
+void* foonathan::memory::virtual_memory_commit(void* memory, std::size_t no_pages,
+                                               virtual_memory_page_mode mode) noexcept
+{
+    if (!virtual_memory_commit(memory, no_pages))
+        return nullptr;
+
+#if defined(MADV_HUGEPAGE)
+    // only a hint, the memory is usable either way
+    if (mode == virtual_memory_page_mode::huge && get_virtual_memory_huge_page_size() != 0u)
+        madvise(memory, no_pages * virtual_memory_page_size, MADV_HUGEPAGE);
+#else
+    (void)mode;
+#endif
+    return memory;
+}
+
+bool foonathan::memory::lock_memory(void* memory, std::size_t size) noexcept
+{
+    return mlock(memory, size) == 0;
+}
+
+void foonathan::memory::unlock_memory(void* memory, std::size_t size) noexcept
+{
+    munlock(memory, size);
+}
 #else
 #warning "virtual memory functions not available on your platform, define your own"
 #endif
@@ -145,6 +263,26 @@ std::size_t foonathan::memory::get_virtual_memory_page_size() noexcept
     return virtual_memory_page_size;
 }
 
+void foonathan::memory::prefault_memory(void* memory, std::size_t size) noexcept
+{
+    auto begin = static_cast<char*>(memory);
+    auto end   = begin + size;
+#if defined(MADV_POPULATE_WRITE)
+    // populates whole pages, the partial first page is touched below
+    auto offset = detail::align_offset(begin, virtual_memory_page_size);
+    if (offset < size && madvise(begin + offset, size - offset, MADV_POPULATE_WRITE) == 0)
+        end = begin + offset;
+#endif
+
+    // the first access to each page faults it in, writing makes sure it is not a shared zero page
+    for (auto cur = begin; cur < end;
+         cur += detail::align_offset(cur + 1, virtual_memory_page_size) + 1u)
+    {
+        auto page = static_cast<volatile char*>(cur);
+        *page     = *page;
+    }
+}
+
 namespace
 {
     std::size_t calc_no_pages(std::size_t size) noexcept
@@ -169,6 +307,15 @@ void* virtual_memory_allocator::allocate_node(std::size_t size, std::size_t)
     return detail::debug_fill_new(pages, size, virtual_memory_page_size);
 }
 
+void* virtual_memory_allocator::allocate_node_zeroed(std::size_t size, std::size_t alignment)
+{
+    auto memory = allocate_node(size, alignment);
+#if FOONATHAN_MEMORY_DEBUG_FILL
+    std::memset(memory, 0, size);
+#endif
+    return memory;
+}
+
 void virtual_memory_allocator::deallocate_node(void* node, std::size_t size, std::size_t) noexcept
 {
     auto pages = detail::debug_fill_free(node, size, virtual_memory_page_size);
@@ -190,50 +337,465 @@ std::size_t virtual_memory_allocator::max_alignment() const noexcept
     return virtual_memory_page_size;
 }
 
+namespace
+{
+    // rounds the number of pages up to a multiple of the huge page size
+    std::size_t calc_no_huge_pages(std::size_t size) noexcept
+    {
+        auto no_pages  = calc_no_pages(size);
+        auto per_huge  = huge_page_allocator::page_size() / virtual_memory_page_size;
+        auto remainder = no_pages % per_huge;
+        return remainder == 0u ? no_pages : no_pages + per_huge - remainder;
+    }
+} // namespace
+
+void* huge_page_allocator::allocate_node(std::size_t size, std::size_t)
+{
+    auto no_pages = calc_no_huge_pages(size);
+    auto pages    = reserve_for_huge_pages(no_pages, page_size());
+    if (!pages || !virtual_memory_commit(pages, no_pages, virtual_memory_page_mode::huge))
+        FOONATHAN_THROW(
+            out_of_memory({FOONATHAN_MEMORY_LOG_PREFIX "::huge_page_allocator", nullptr},
+                          no_pages * virtual_memory_page_size));
+    on_allocate(size);
+
+    return detail::debug_fill_new(pages, size, virtual_memory_page_size);
+}
+
+void* huge_page_allocator::allocate_node_zeroed(std::size_t size, std::size_t alignment)
+{
+    auto memory = allocate_node(size, alignment);
+#if FOONATHAN_MEMORY_DEBUG_FILL
+    std::memset(memory, 0, size);
+#endif
+    return memory;
+}
+
+void huge_page_allocator::deallocate_node(void* node, std::size_t size, std::size_t) noexcept
+{
+    auto pages = detail::debug_fill_free(node, size, virtual_memory_page_size);
+
+    on_deallocate(size);
+
+    auto no_pages = calc_no_huge_pages(size);
+    virtual_memory_decommit(pages, no_pages);
+    virtual_memory_release(pages, no_pages);
+}
+
+std::size_t huge_page_allocator::max_node_size() const noexcept
+{
+    return std::size_t(-1);
+}
+
+std::size_t huge_page_allocator::max_alignment() const noexcept
+{
+    return virtual_memory_page_size;
+}
+
+std::size_t huge_page_allocator::page_size() noexcept
+{
+    auto huge_page_size = get_virtual_memory_huge_page_size();
+    return huge_page_size == 0u ? virtual_memory_page_size : huge_page_size;
+}
+
 #if FOONATHAN_MEMORY_EXTERN_TEMPLATE
 template class foonathan::memory::allocator_traits<virtual_memory_allocator>;
+template class foonathan::memory::allocator_traits<huge_page_allocator>;
 #endif
 
-virtual_block_allocator::virtual_block_allocator(std::size_t block_size, std::size_t no_blocks)
-: block_size_(block_size)
+virtual_block_allocator::virtual_block_allocator(std::size_t block_size, std::size_t no_blocks,
+                                                 virtual_memory_page_mode mode)
+: block_size_(block_size), page_size_(virtual_memory_page_size), last_zeroed_(false)
 {
     FOONATHAN_MEMORY_ASSERT(block_size % virtual_memory_page_size == 0u);
     FOONATHAN_MEMORY_ASSERT(no_blocks > 0);
+    if (mode == virtual_memory_page_mode::huge && get_virtual_memory_huge_page_size() != 0u)
+    {
+        page_size_ = get_virtual_memory_huge_page_size();
+        if (block_size_ % page_size_ != 0u)
+            block_size_ += page_size_ - block_size_ % page_size_;
+    }
+
     auto total_size = block_size_ * no_blocks;
     auto no_pages   = total_size / virtual_memory_page_size;
 
-    cur_ = static_cast<char*>(virtual_memory_reserve(no_pages));
+    cur_ = static_cast<char*>(page_size_ == virtual_memory_page_size ?
+                                  virtual_memory_reserve(no_pages) :
+                                  reserve_for_huge_pages(no_pages, page_size_));
     if (!cur_)
         FOONATHAN_THROW(out_of_memory(info(), total_size));
-    end_ = cur_ + total_size;
+    begin_ = fresh_ = cur_;
+    end_            = cur_ + total_size;
 }
 
 virtual_block_allocator::~virtual_block_allocator() noexcept
 {
-    virtual_memory_release(cur_, static_cast<std::size_t>(end_ - cur_) / virtual_memory_page_size);
+    if (begin_)
+        virtual_memory_release(begin_, static_cast<std::size_t>(end_ - begin_)
+                                           / virtual_memory_page_size);
 }
 
 memory_block virtual_block_allocator::allocate_block()
 {
-    if (std::size_t(end_ - cur_) < block_size_)
-        FOONATHAN_THROW(out_of_fixed_memory(info(), block_size_));
-    auto mem = virtual_memory_commit(cur_, block_size_ / virtual_memory_page_size);
+    return allocate_blocks(1u);
+}
+
+memory_block virtual_block_allocator::allocate_blocks(std::size_t n)
+{
+    auto size = n * block_size_;
+    if (capacity_left() < n)
+        FOONATHAN_THROW(out_of_fixed_memory(info(), size));
+    auto mem = virtual_memory_commit(cur_, size / virtual_memory_page_size, mode());
     if (!mem)
+        FOONATHAN_THROW(out_of_fixed_memory(info(), size));
+    // only the memory after the highest committed address is fresh
+    last_zeroed_ = cur_ >= fresh_;
+    cur_ += size;
+    if (cur_ > fresh_)
+        fresh_ = cur_;
+    return {mem, size};
+}
+
+void virtual_block_allocator::deallocate_block(memory_block block) noexcept
+{
+    detail::debug_check_pointer([&]
+                                { return static_cast<char*>(block.memory) == cur_ - block.size; },
+                                info(), block.memory);
+    cur_ -= block.size;
+    virtual_memory_decommit(cur_, block.size / virtual_memory_page_size);
+}
+
+allocator_info virtual_block_allocator::info() noexcept
+{
+    return {FOONATHAN_MEMORY_LOG_PREFIX "::virtual_block_allocator", this};
+}
+
+namespace
+{
+    // the minimal amount of memory committed at once, avoids a system call for each allocation
+    constexpr std::size_t min_commit_pages = 16u;
+
+    std::size_t round_up(std::size_t size, std::size_t multiple) noexcept
+    {
+        auto rest = size % multiple;
+        return rest == 0u ? size : size + multiple - rest;
+    }
+} // namespace
+
+virtual_buffer::virtual_buffer(std::size_t max_size)
+{
+    FOONATHAN_MEMORY_ASSERT(max_size > 0u);
+    auto total_size = round_up(max_size, virtual_memory_page_size);
+
+    begin_ = static_cast<char*>(virtual_memory_reserve(total_size / virtual_memory_page_size));
+    if (!begin_)
+        FOONATHAN_THROW(out_of_memory(info(), total_size));
+    committed_ = begin_;
+    end_       = begin_ + total_size;
+}
+
+virtual_buffer::~virtual_buffer() noexcept
+{
+    if (begin_)
+    {
+        // the user of the buffer might have poisoned parts of it
+        detail::debug_unpoison(begin_, committed_size());
+        virtual_memory_release(begin_, max_size() / virtual_memory_page_size);
+    }
+}
+
+void virtual_buffer::commit(std::size_t size)
+{
+    if (size > max_size())
+        FOONATHAN_THROW(out_of_fixed_memory(info(), size));
+    else if (!try_commit(size))
+        FOONATHAN_THROW(out_of_memory(info(), size));
+}
+
+bool virtual_buffer::try_commit(std::size_t size) noexcept
+{
+    if (size <= committed_size())
+        return true;
+    else if (size > max_size())
+        return false;
+
+    auto new_end  = begin_ + round_up(size, virtual_memory_page_size);
+    auto no_pages = std::size_t(new_end - committed_) / virtual_memory_page_size;
+    if (!virtual_memory_commit(committed_, no_pages))
+        return false;
+    committed_ = new_end;
+    return true;
+}
+
+void virtual_buffer::decommit(std::size_t size) noexcept
+{
+    auto new_end = begin_ + round_up(size, virtual_memory_page_size);
+    if (new_end < committed_)
+    {
+        detail::debug_unpoison(new_end, std::size_t(committed_ - new_end));
+        virtual_memory_decommit(new_end, std::size_t(committed_ - new_end)
+                                             / virtual_memory_page_size);
+        committed_ = new_end;
+    }
+}
+
+allocator_info virtual_buffer::info() noexcept
+{
+    return {FOONATHAN_MEMORY_LOG_PREFIX "::virtual_buffer", this};
+}
+
+constexpr std::size_t virtual_memory_stack::never_decommit;
+
+virtual_memory_stack::virtual_memory_stack(std::size_t capacity, std::size_t decommit_margin,
+                                           virtual_memory_page_mode mode)
+: page_size_(virtual_memory_page_size), decommit_margin_(decommit_margin)
+{
+    FOONATHAN_MEMORY_ASSERT(capacity > 0u);
+    if (mode == virtual_memory_page_mode::huge && get_virtual_memory_huge_page_size() != 0u)
+        page_size_ = get_virtual_memory_huge_page_size();
+
+    auto total_size = round_up(capacity, page_size_);
+    auto no_pages   = total_size / virtual_memory_page_size;
+
+    begin_ = static_cast<char*>(page_size_ == virtual_memory_page_size ?
+                                    virtual_memory_reserve(no_pages) :
+                                    reserve_for_huge_pages(no_pages, page_size_));
+    if (!begin_)
+        FOONATHAN_THROW(out_of_memory(info(), total_size));
+    committed_ = begin_;
+    end_       = begin_ + total_size;
+    // debug filling writes to all memory that is allocated
+    zeroed_ = FOONATHAN_MEMORY_DEBUG_FILL ? end_ : begin_;
+    stack_  = detail::fixed_memory_stack(begin_);
+}
+
+virtual_memory_stack::~virtual_memory_stack() noexcept
+{
+    if (begin_)
+    {
+        // the user of the stack might have poisoned parts of it
+        detail::debug_unpoison(begin_, committed_size());
+        virtual_memory_release(begin_, capacity() / virtual_memory_page_size);
+    }
+}
+
+void virtual_memory_stack::unwind(marker m) noexcept
+{
+    FOONATHAN_MEMORY_ASSERT(m <= top());
+    detail::debug_check_pointer([&] { return begin_ <= m.top_; }, info(), m.top_);
+    if (stack_.top() > zeroed_)
+        zeroed_ = stack_.top();
+    stack_.unwind(m.top_);
+    if (decommit_margin_ != never_decommit)
+        decommit_above(decommit_margin_);
+}
+
+void virtual_memory_stack::shrink_to_fit() noexcept
+{
+    decommit_above(0u);
+}
+
+std::size_t virtual_memory_stack::commit_size() const noexcept
+{
+    return round_up(min_commit_pages * virtual_memory_page_size, page_size_);
+}
+
+allocator_info virtual_memory_stack::info() noexcept
+{
+    return {FOONATHAN_MEMORY_LOG_PREFIX "::virtual_memory_stack", this};
+}
+
+void virtual_memory_stack::commit(std::size_t needed)
+{
+    if (needed > capacity_left())
+        FOONATHAN_THROW(out_of_fixed_memory(info(), needed));
+    else if (!try_commit(needed))
+        FOONATHAN_THROW(out_of_memory(info(), needed));
+}
+
+bool virtual_memory_stack::try_commit(std::size_t needed) noexcept
+{
+    if (needed > capacity_left())
+        return false;
+
+    auto new_size = round_up(std::size_t(stack_.top() - begin_) + needed, commit_size());
+    auto new_end  = new_size > capacity() ? end_ : begin_ + new_size;
+    auto mode     = page_size_ == virtual_memory_page_size ? virtual_memory_page_mode::normal :
+                                                             virtual_memory_page_mode::huge;
+    auto no_pages = std::size_t(new_end - committed_) / virtual_memory_page_size;
+    if (!virtual_memory_commit(committed_, no_pages, mode))
+        return false;
+    committed_ = new_end;
+    return true;
+}
+
+void virtual_memory_stack::decommit_above(std::size_t margin) noexcept
+{
+    auto used      = std::size_t(stack_.top() - begin_);
+    auto committed = std::size_t(committed_ - begin_);
+    if (committed - used <= margin)
+        return;
+
+    // keep whole pages, so that huge pages are not split up,
+    // the offset is only turned into a pointer once it is below the committed end,
+    // rounding it up can go beyond the end of the reservation
+    auto keep = round_up(used + margin, page_size_);
+    if (keep < committed)
+    {
+        auto no_pages = (committed - keep) / virtual_memory_page_size;
+        detail::debug_unpoison(begin_ + keep, committed - keep);
+        virtual_memory_decommit(begin_ + keep, no_pages);
+        committed_ = begin_ + keep;
+    }
+}
+
+#if defined(__unix__) || defined(__APPLE__) || defined(__VXWORKS__)                                \
+    || defined(__QNXNTO__) // POSIX systems
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+namespace
+{
+    void advise_mapping(void* memory, std::size_t size, mmap_options options) noexcept
+    {
+#if defined(MADV_SEQUENTIAL)
+        if (options & mmap_options::sequential)
+            madvise(memory, size, MADV_SEQUENTIAL);
+        else if (options & mmap_options::random)
+            madvise(memory, size, MADV_RANDOM);
+#elif defined(POSIX_MADV_SEQUENTIAL)
+        if (options & mmap_options::sequential)
+            posix_madvise(memory, size, POSIX_MADV_SEQUENTIAL);
+        else if (options & mmap_options::random)
+            posix_madvise(memory, size, POSIX_MADV_RANDOM);
+#else
+        (void)memory;
+        (void)size;
+        (void)options;
+#endif
+    }
+
+    bool grow_file(int fd, std::size_t old_size, std::size_t new_size, bool preallocate) noexcept
+    {
+#if defined(__linux__) || defined(__FreeBSD__)
+        // posix_fallocate() also extends the file
+        if (preallocate)
+            return posix_fallocate(fd, static_cast<off_t>(old_size),
+                                   static_cast<off_t>(new_size - old_size))
+                   == 0;
+#else
+        (void)old_size;
+        (void)preallocate;
+#endif
+        return ftruncate(fd, static_cast<off_t>(new_size)) == 0;
+    }
+} // namespace
+
+mmap_block_allocator::mmap_block_allocator(std::size_t block_size, std::size_t no_blocks,
+                                           const char* path, mmap_options options,
+                                           void* address)
+: begin_(nullptr),
+  cur_(nullptr),
+  end_(nullptr),
+  block_size_(block_size),
+  file_size_(0u),
+  fd_(-1),
+  options_(options)
+{
+    FOONATHAN_MEMORY_ASSERT(block_size > 0u && block_size % virtual_memory_page_size == 0u);
+    FOONATHAN_MEMORY_ASSERT(no_blocks > 0u);
+    auto total_size = block_size * no_blocks;
+
+    struct stat status;
+    fd_ = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0 || fstat(fd_, &status) != 0)
+    {
+        if (fd_ >= 0)
+            close(fd_);
+        FOONATHAN_THROW(out_of_memory(info(), total_size));
+    }
+    file_size_ = static_cast<std::size_t>(status.st_size);
+
+    auto flags = MAP_SHARED;
+#if defined(MAP_POPULATE)
+    if (options & mmap_options::populate)
+        flags |= MAP_POPULATE;
+#endif
+#if defined(MAP_FIXED_NOREPLACE)
+    if (address)
+        flags |= MAP_FIXED_NOREPLACE;
+#endif
+    auto memory = mmap(address, total_size, PROT_READ | PROT_WRITE, flags, fd_, 0);
+    if (memory != MAP_FAILED && address && memory != address)
+    {
+        // the address is only a hint without MAP_FIXED_NOREPLACE
+        munmap(memory, total_size);
+        memory = MAP_FAILED;
+    }
+    if (memory == MAP_FAILED)
+    {
+        close(fd_);
+        FOONATHAN_THROW(out_of_memory(info(), total_size));
+    }
+    advise_mapping(memory, total_size, options);
+
+    begin_ = cur_ = static_cast<char*>(memory);
+    end_          = begin_ + total_size;
+}
+
+mmap_block_allocator::~mmap_block_allocator() noexcept
+{
+    if (begin_)
+        munmap(begin_, static_cast<std::size_t>(end_ - begin_));
+    if (fd_ >= 0)
+        close(fd_);
+}
+
+memory_block mmap_block_allocator::allocate_block()
+{
+    if (std::size_t(end_ - cur_) < block_size_)
         FOONATHAN_THROW(out_of_fixed_memory(info(), block_size_));
+
+    auto needed = std::size_t(cur_ - begin_) + block_size_;
+    if (needed > file_size_)
+    {
+        // accessing the memory beyond the end of the file is an error
+        if (!grow_file(fd_, file_size_, needed, options_ & mmap_options::preallocate))
+            FOONATHAN_THROW(out_of_memory(info(), block_size_));
+        file_size_ = needed;
+    }
+
+#if defined(MADV_WILLNEED)
+    if (options_ & mmap_options::populate)
+        madvise(cur_, block_size_, MADV_WILLNEED);
+#endif
+
+    auto mem = cur_;
     cur_ += block_size_;
     return {mem, block_size_};
 }
 
-void virtual_block_allocator::deallocate_block(memory_block block) noexcept
+void mmap_block_allocator::deallocate_block(memory_block block) noexcept
 {
     detail::debug_check_pointer([&]
                                 { return static_cast<char*>(block.memory) == cur_ - block_size_; },
                                 info(), block.memory);
     cur_ -= block_size_;
-    virtual_memory_decommit(cur_, block_size_ / virtual_memory_page_size);
 }
 
-allocator_info virtual_block_allocator::info() noexcept
+bool mmap_block_allocator::sync() noexcept
 {
-    return {FOONATHAN_MEMORY_LOG_PREFIX "::virtual_block_allocator", this};
+    if (cur_ != begin_ && msync(begin_, std::size_t(cur_ - begin_), MS_SYNC) != 0)
+        return false;
+    return fsync(fd_) == 0;
 }
+
+allocator_info mmap_block_allocator::info() noexcept
+{
+    return {FOONATHAN_MEMORY_LOG_PREFIX "::mmap_block_allocator", this};
+}
+#endif
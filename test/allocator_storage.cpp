@@ -0,0 +1,55 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "allocator_storage.hpp"
+
+#include <doctest/doctest.h>
+
+#include "heap_allocator.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("any_allocator_reference")
+{
+    SUBCASE("stateful")
+    {
+        test_allocator          alloc;
+        any_allocator_reference ref(alloc);
+        REQUIRE(ref.max_node_size() == alloc.max_node_size());
+
+        auto node = ref.allocate_node(16u, 8u);
+        REQUIRE(alloc.no_allocated() == 1u);
+        ref.deallocate_node(node, 16u, 8u);
+        REQUIRE(alloc.no_allocated() == 0u);
+        REQUIRE(alloc.last_deallocation_valid());
+
+        auto array = ref.allocate_array(4u, 16u, 8u);
+        REQUIRE(alloc.no_allocated() == 1u);
+        ref.deallocate_array(array, 4u, 16u, 8u);
+        REQUIRE(alloc.no_allocated() == 0u);
+        REQUIRE(alloc.last_deallocation_valid());
+
+        // a copy refers to the same allocator
+        any_allocator_reference copy(ref);
+        node = copy.allocate_node(16u, 8u);
+        REQUIRE(alloc.no_allocated() == 1u);
+        ref.deallocate_node(node, 16u, 8u);
+        REQUIRE(alloc.no_allocated() == 0u);
+    }
+    SUBCASE("stateless")
+    {
+        heap_allocator          alloc;
+        any_allocator_reference ref(alloc);
+        REQUIRE(ref.max_node_size() == allocator_traits<heap_allocator>::max_node_size(alloc));
+        REQUIRE(ref.max_array_size() == allocator_traits<heap_allocator>::max_array_size(alloc));
+        REQUIRE(ref.max_alignment() == allocator_traits<heap_allocator>::max_alignment(alloc));
+
+        any_allocator_reference copy(ref);
+        REQUIRE(copy.max_node_size() == ref.max_node_size());
+
+        auto node = copy.allocate_node(16u, 8u);
+        REQUIRE(node);
+        ref.deallocate_node(node, 16u, 8u);
+    }
+}
@@ -5,6 +5,7 @@
 
 #include <doctest/doctest.h>
 
+#include <cstring>
 #include <type_traits>
 
 #include "heap_allocator.hpp"
@@ -47,6 +48,18 @@ namespace foonathan
 
 static_assert(is_raw_allocator<raw_allocator_specialized>::value, "");
 
+struct noop_deallocation_allocator
+{
+    using is_deallocation_noop = std::true_type;
+
+    void* allocate_node(std::size_t, std::size_t);
+    void  deallocate_node(void*, std::size_t, std::size_t);
+};
+
+static_assert(is_deallocation_noop<noop_deallocation_allocator>::value, "");
+static_assert(!is_deallocation_noop<heap_allocator>::value, "");
+static_assert(!is_deallocation_noop<std::allocator<char>>::value, "");
+
 template <class Allocator, class Type, bool Stateful>
 void test_type_statefulness()
 {
@@ -289,6 +302,140 @@ TEST_CASE("allocator_traits")
         REQUIRE(!array4.alloc);
         REQUIRE(!array4.dealloc);
     }
+    SUBCASE("batch")
+    {
+        // minimum interface works
+        struct counting_allocator
+        {
+            std::size_t allocated = 0u;
+            char        memory[4];
+
+            void* allocate_node(std::size_t, std::size_t)
+            {
+                return &memory[allocated++];
+            }
+
+            void deallocate_node(void*, std::size_t, std::size_t) noexcept
+            {
+                --allocated;
+            }
+        } counting;
+
+        void* nodes[4];
+        allocator_traits<counting_allocator>::allocate_node_batch(counting, nodes, 4u, 1u, 1u);
+        REQUIRE(counting.allocated == 4u);
+        REQUIRE(nodes[3] == &counting.memory[3]);
+        allocator_traits<counting_allocator>::deallocate_node_batch(counting, nodes, 4u, 1u, 1u);
+        REQUIRE(counting.allocated == 0u);
+
+        struct batch_raw : min_raw_allocator
+        {
+            bool alloc_batch = false, dealloc_batch = false;
+
+            void allocate_node_batch(void**, std::size_t, std::size_t, std::size_t)
+            {
+                alloc_batch = true;
+            }
+
+            void deallocate_node_batch(void* const*, std::size_t, std::size_t,
+                                       std::size_t) noexcept
+            {
+                dealloc_batch = true;
+            }
+        };
+
+        // batch works over node
+        batch_raw batch;
+        allocator_traits<batch_raw>::allocate_node_batch(batch, nodes, 4u, 1u, 1u);
+        allocator_traits<batch_raw>::deallocate_node_batch(batch, nodes, 4u, 1u, 1u);
+        REQUIRE(batch.alloc_batch);
+        REQUIRE(batch.dealloc_batch);
+        REQUIRE(!batch.alloc_node);
+        REQUIRE(!batch.dealloc_node);
+    }
+    SUBCASE("at least")
+    {
+        // minimum interface works and returns the requested size
+        min_raw_allocator min;
+        auto result = allocator_traits<min_raw_allocator>::allocate_node_at_least(min, 3u, 1u);
+        REQUIRE(min.alloc_node);
+        REQUIRE(result.size == 3u);
+
+        result = allocator_traits<min_raw_allocator>::allocate_array_at_least(min, 2u, 3u, 1u);
+        REQUIRE(result.size == 2u);
+
+        struct at_least_raw : min_raw_allocator
+        {
+            allocation_result allocate_node_at_least(std::size_t size, std::size_t)
+            {
+                return {nullptr, 2u * size};
+            }
+
+            allocation_result allocate_array_at_least(std::size_t count, std::size_t,
+                                                      std::size_t)
+            {
+                return {nullptr, count + 1u};
+            }
+        };
+
+        at_least_raw at_least;
+        result = allocator_traits<at_least_raw>::allocate_node_at_least(at_least, 3u, 1u);
+        REQUIRE(result.size == 6u);
+        result = allocator_traits<at_least_raw>::allocate_array_at_least(at_least, 2u, 3u, 1u);
+        REQUIRE(result.size == 3u);
+        REQUIRE(!at_least.alloc_node);
+    }
+    SUBCASE("zeroed")
+    {
+        struct buffer_raw_allocator
+        {
+            char buffer[16];
+
+            void* allocate_node(std::size_t, std::size_t)
+            {
+                std::memset(buffer, 'a', sizeof(buffer));
+                return buffer;
+            }
+
+            void deallocate_node(void*, std::size_t, std::size_t) noexcept {}
+        };
+
+        // minimum interface clears exactly the requested memory
+        buffer_raw_allocator buffer;
+        using traits = allocator_traits<buffer_raw_allocator>;
+        auto node    = static_cast<char*>(traits::allocate_node_zeroed(buffer, 8u, 1u));
+        REQUIRE(node == buffer.buffer);
+        for (auto i = 0u; i != 8u; ++i)
+            REQUIRE(node[i] == 0);
+        REQUIRE(node[8] == 'a');
+
+        auto array = static_cast<char*>(traits::allocate_array_zeroed(buffer, 3u, 4u, 1u));
+        for (auto i = 0u; i != 12u; ++i)
+            REQUIRE(array[i] == 0);
+        REQUIRE(array[12] == 'a');
+
+        struct zeroed_raw_allocator : buffer_raw_allocator
+        {
+            void* allocate_node_zeroed(std::size_t, std::size_t)
+            {
+                return buffer;
+            }
+
+            void* allocate_array_zeroed(std::size_t, std::size_t, std::size_t)
+            {
+                return buffer + 1;
+            }
+        };
+
+        zeroed_raw_allocator zeroed;
+        zeroed.buffer[0] = 'b';
+        node = static_cast<char*>(allocator_traits<zeroed_raw_allocator>::allocate_node_zeroed(
+            zeroed, 8u, 1u));
+        REQUIRE(node[0] == 'b');
+        array = static_cast<char*>(
+            allocator_traits<zeroed_raw_allocator>::allocate_array_zeroed(zeroed, 3u, 4u, 1u));
+        REQUIRE(array == zeroed.buffer + 1);
+    }
     SUBCASE("max getter")
     {
         min_raw_allocator min;
@@ -416,4 +563,34 @@ TEST_CASE("composable_allocator_traits")
         REQUIRE(!array.alloc_node);
         REQUIRE(!array.dealloc_node);
     }
+    SUBCASE("batch")
+    {
+        // failure of a single node deallocates the others again
+        struct limited_composable : min_composable_allocator
+        {
+            std::size_t allocated = 0u;
+            char        memory[2];
+
+            void* try_allocate_node(std::size_t, std::size_t) noexcept
+            {
+                return allocated == 2u ? nullptr : &memory[allocated++];
+            }
+
+            bool try_deallocate_node(void*, std::size_t, std::size_t) noexcept
+            {
+                --allocated;
+                return true;
+            }
+        } limited;
+
+        using traits = composable_allocator_traits<limited_composable>;
+
+        void* nodes[3];
+        REQUIRE(!traits::try_allocate_node_batch(limited, nodes, 3u, 1u, 1u));
+        REQUIRE(limited.allocated == 0u);
+        REQUIRE(traits::try_allocate_node_batch(limited, nodes, 2u, 1u, 1u));
+        REQUIRE(limited.allocated == 2u);
+        REQUIRE(traits::try_deallocate_node_batch(limited, nodes, 2u, 1u, 1u));
+        REQUIRE(limited.allocated == 0u);
+    }
 }
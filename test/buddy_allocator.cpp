@@ -0,0 +1,123 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "buddy_allocator.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <doctest/doctest.h>
+#include <random>
+#include <vector>
+
+#include "allocator_traits.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    struct node
+    {
+        unsigned char* memory;
+        std::size_t    size;
+    };
+} // namespace
+
+TEST_CASE("buddy_allocator")
+{
+    buddy_allocator<> alloc(16u, 64u * 1024u);
+    auto              capacity = alloc.capacity_left();
+    REQUIRE(capacity > 32u * 1024u);
+
+    SUBCASE("split and merge")
+    {
+        // the first block has a single node of half its size
+        auto size = std::size_t(32u * 1024u);
+        REQUIRE(alloc.max_node_size() >= size);
+
+        auto a = alloc.allocate_node(1u, 1u);
+        REQUIRE(alloc.capacity_left() == capacity - 16u);
+        auto b = alloc.allocate_node(1u, 1u);
+        REQUIRE(alloc.capacity_left() == capacity - 32u);
+
+        // the buddies are merged again, so the biggest node fits
+        alloc.deallocate_node(a, 1u, 1u);
+        alloc.deallocate_node(b, 1u, 1u);
+        REQUIRE(alloc.capacity_left() == capacity);
+
+        auto big = alloc.allocate_node(size, 1u);
+        REQUIRE(alloc.try_allocate_node(size, 1u) == nullptr);
+        alloc.deallocate_node(big, size, 1u);
+        REQUIRE(alloc.capacity_left() == capacity);
+    }
+    SUBCASE("alignment")
+    {
+        auto a = alloc.allocate_node(8u, 1u);
+        auto b = alloc.allocate_node(24u, 16u);
+        auto c = alloc.allocate_node(200u, 8u);
+        REQUIRE(detail::is_aligned(b, 16u));
+        REQUIRE(detail::is_aligned(c, 16u));
+        REQUIRE(alloc.owns(c));
+
+        alloc.deallocate_node(b, 24u, 16u);
+        alloc.deallocate_node(a, 8u, 1u);
+        alloc.deallocate_node(c, 200u, 8u);
+        REQUIRE(alloc.capacity_left() == capacity);
+    }
+    SUBCASE("random order")
+    {
+        std::mt19937      engine(42u);
+        std::vector<node> nodes;
+        for (auto round = 0; round != 4; ++round)
+        {
+            for (std::size_t i = 0u; i != 100u; ++i)
+            {
+                auto size = std::size_t(1u) + engine() % 300u;
+                auto mem  = static_cast<unsigned char*>(alloc.try_allocate_node(size, 1u));
+                if (!mem)
+                    break;
+                std::memset(mem, static_cast<unsigned char>(size), size);
+                nodes.push_back({mem, size});
+            }
+
+            std::shuffle(nodes.begin(), nodes.end(), engine);
+            for (auto half = nodes.size() / 2u; nodes.size() != half;)
+            {
+                auto n = nodes.back();
+                nodes.pop_back();
+                for (std::size_t j = 0u; j != n.size; ++j)
+                    REQUIRE(n.memory[j] == static_cast<unsigned char>(n.size));
+                alloc.deallocate_node(n.memory, n.size, 1u);
+            }
+        }
+
+        for (auto& n : nodes)
+        {
+            REQUIRE(n.memory[0] == static_cast<unsigned char>(n.size));
+            alloc.deallocate_node(n.memory, n.size, 1u);
+        }
+        REQUIRE(alloc.capacity_left() == capacity);
+        alloc.deallocate_node(alloc.allocate_node(alloc.max_node_size(), 1u),
+                              alloc.max_node_size(), 1u);
+    }
+}
+
+TEST_CASE("buddy_allocator growth")
+{
+    buddy_allocator<> alloc(32u, 4096u);
+    REQUIRE(alloc.min_node_size() == 32u);
+
+    // the first block has no node left that is big enough
+    auto first = alloc.capacity_left();
+    auto size  = alloc.max_node_size();
+    auto array = allocator_traits<buddy_allocator<>>::allocate_array(alloc, size, 1u, 1u);
+    REQUIRE(alloc.capacity_left() > first);
+    REQUIRE(alloc.owns(array));
+
+    auto node = allocator_traits<buddy_allocator<>>::allocate_node(alloc, 33u, 1u);
+    allocator_traits<buddy_allocator<>>::deallocate_node(alloc, node, 33u, 1u);
+    allocator_traits<buddy_allocator<>>::deallocate_array(alloc, array, size, 1u, 1u);
+
+    buddy_allocator<> moved(detail::move(alloc));
+    auto              mem = moved.allocate_node(100u, 8u);
+    moved.deallocate_node(mem, 100u, 8u);
+}
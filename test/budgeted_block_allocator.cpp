@@ -0,0 +1,174 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "budgeted_block_allocator.hpp"
+
+#include <atomic>
+#include <doctest/doctest.h>
+#include <thread>
+#include <vector>
+
+#include "memory_stack.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    struct limit_calls
+    {
+        std::size_t soft = 0u, hard = 0u, amount = 0u;
+    };
+
+    void on_limit(const memory_budget&, budget_limit limit, std::size_t amount, void* data)
+    {
+        auto& calls = *static_cast<limit_calls*>(data);
+        (limit == budget_limit::soft ? calls.soft : calls.hard) += 1u;
+        calls.amount = amount;
+    }
+} // namespace
+
+TEST_CASE("memory_budget")
+{
+    limit_calls calls;
+
+    SUBCASE("limits")
+    {
+        memory_budget budget(1000u, 2000u, nullptr, 0u);
+        budget.set_limit_handler(on_limit, &calls);
+
+        REQUIRE(budget.try_charge(800u));
+        REQUIRE(budget.usage() == 800u);
+        REQUIRE(calls.soft == 0u);
+
+        REQUIRE(budget.try_charge(400u));
+        REQUIRE(calls.soft == 1u);
+        REQUIRE(calls.amount == 1200u);
+        // only reported again after dropping below the limit
+        REQUIRE(budget.try_charge(100u));
+        REQUIRE(calls.soft == 1u);
+
+        REQUIRE(!budget.try_charge(800u));
+        REQUIRE(calls.hard == 1u);
+        REQUIRE(calls.amount == 2100u);
+        REQUIRE(budget.usage() == 1300u);
+
+        budget.release(1300u);
+        REQUIRE(budget.usage() == 0u);
+        REQUIRE(budget.try_charge(2000u));
+        REQUIRE(calls.soft == 2u);
+        budget.release(2000u);
+    }
+    SUBCASE("slack")
+    {
+        memory_budget budget(memory_budget::unlimited, 2000u, nullptr, 1500u);
+        budget.set_limit_handler(on_limit, &calls);
+
+        // reserves a step for the next charges
+        REQUIRE(budget.try_charge(100u));
+        REQUIRE(budget.usage() == 100u);
+        REQUIRE(budget.reserved() == 1600u);
+        REQUIRE(budget.try_charge(200u));
+        REQUIRE(budget.reserved() == 1600u);
+        budget.release(300u);
+        REQUIRE(budget.usage() == 0u);
+        REQUIRE(budget.reserved() == 1600u);
+
+        // the slack is returned before the hard limit is reached
+        REQUIRE(budget.try_charge(1900u));
+        REQUIRE(budget.usage() == 1900u);
+        REQUIRE(budget.reserved() == 1900u);
+        REQUIRE(calls.hard == 0u);
+        REQUIRE(!budget.try_charge(200u));
+        REQUIRE(calls.hard == 1u);
+
+        budget.release(1900u);
+        budget.trim();
+        REQUIRE(budget.reserved() == 0u);
+    }
+    SUBCASE("hierarchy")
+    {
+        memory_budget process(memory_budget::unlimited, 3000u, nullptr, 0u);
+        memory_budget service(memory_budget::unlimited, memory_budget::unlimited, &process, 0u);
+        memory_budget tenant_a(memory_budget::unlimited, 2000u, &service, 0u);
+        memory_budget tenant_b(memory_budget::unlimited, 2000u, &service, 0u);
+        process.set_limit_handler(on_limit, &calls);
+
+        REQUIRE(tenant_a.try_charge(2000u));
+        REQUIRE(!tenant_a.try_charge(1u));
+        REQUIRE(calls.hard == 0u);
+        REQUIRE(service.usage() == 2000u);
+        REQUIRE(process.usage() == 2000u);
+
+        // the limit of the process is reached first
+        REQUIRE(tenant_b.try_charge(1000u));
+        REQUIRE(!tenant_b.try_charge(1u));
+        REQUIRE(calls.hard == 1u);
+        REQUIRE(tenant_b.usage() == 1000u);
+
+        tenant_a.release(2000u);
+        REQUIRE(tenant_b.try_charge(1000u));
+        REQUIRE(process.usage() == 2000u);
+        tenant_b.release(2000u);
+        REQUIRE(process.usage() == 0u);
+    }
+    SUBCASE("multiple threads")
+    {
+        memory_budget process;
+        memory_budget budget(memory_budget::unlimited, memory_budget::unlimited, &process, 256u);
+
+        std::atomic<std::size_t> failures(0u);
+        std::vector<std::thread> threads;
+        for (auto i = 0; i != 4; ++i)
+            threads.emplace_back([&] {
+                for (auto j = 0; j != 1000; ++j)
+                {
+                    if (!budget.try_charge(100u))
+                        ++failures;
+                    budget.release(100u);
+                }
+                budget.try_charge(10u);
+            });
+        for (auto& thread : threads)
+            thread.join();
+
+        REQUIRE(failures == 0u);
+        REQUIRE(budget.usage() == 40u);
+        budget.release(40u);
+        budget.trim();
+        REQUIRE(budget.reserved() == 0u);
+        REQUIRE(process.reserved() == 0u);
+    }
+}
+
+TEST_CASE("budgeted_block_allocator")
+{
+    memory_budget budget(memory_budget::unlimited, 4096u + 8192u, nullptr, 0u);
+    {
+        memory_stack<budgeted_block_allocator<>> stack(4096u, budget);
+        REQUIRE(&stack.get_allocator().get_budget() == &budget);
+        REQUIRE(budget.usage() == 4096u);
+
+        stack.allocate(4096u, 1u);
+        REQUIRE(budget.usage() == 4096u + 8192u);
+
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+        auto old = out_of_memory::set_handler([](const allocator_info&, std::size_t) {});
+        auto failed = false;
+        try
+        {
+            stack.allocate(8192u, 1u);
+        }
+        catch (out_of_memory& ex)
+        {
+            failed = true;
+            REQUIRE(ex.failed_allocation_size() == 16384u);
+        }
+        out_of_memory::set_handler(old);
+        REQUIRE(failed);
+        REQUIRE(budget.usage() == 4096u + 8192u);
+#endif
+
+        stack.shrink_to_fit();
+    }
+    REQUIRE(budget.usage() == 0u);
+}
@@ -0,0 +1,91 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "cached_block_allocator.hpp"
+
+#include <doctest/doctest.h>
+#include <thread>
+
+#include "memory_stack.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("cached_block_allocator")
+{
+    trim_block_cache();
+
+    SUBCASE("block sizes")
+    {
+        cached_block_allocator alloc(5000u);
+        REQUIRE(alloc.next_block_size() == 8192u);
+
+        auto block = alloc.allocate_block();
+        REQUIRE(block.size == 8192u);
+        REQUIRE(alloc.next_block_size() == 16384u);
+        alloc.deallocate_block(block);
+
+        REQUIRE(cached_block_allocator(1u).next_block_size() == detail::cached_block_min_size);
+        REQUIRE(cached_block_allocator(detail::cached_block_max_size + 1u).next_block_size()
+                == detail::cached_block_max_size + 1u);
+    }
+    SUBCASE("reuse")
+    {
+        void* memory = nullptr;
+        {
+            memory_stack<cached_block_allocator> stack(4096u);
+            memory = stack.allocate(16u, 8u);
+        }
+        {
+            // the block is in the cache of the thread
+            memory_stack<cached_block_allocator> stack(4096u);
+            REQUIRE(stack.allocate(16u, 8u) == memory);
+        }
+    }
+    SUBCASE("process cache")
+    {
+        memory_block blocks[8];
+        {
+            cached_block_allocator alloc(4096u);
+            for (auto& block : blocks)
+            {
+                block = alloc.allocate_block();
+                // same size each time
+                alloc = cached_block_allocator(4096u);
+            }
+        }
+
+        // the thread cache is full after four blocks, the rest moves to the process
+        std::thread([&] {
+            cached_block_allocator alloc(4096u);
+            for (auto& block : blocks)
+                alloc.deallocate_block(block);
+        }).join();
+        REQUIRE(block_cache_size() == 8u * 4096u);
+
+        auto block = cached_block_allocator(4096u).allocate_block();
+        REQUIRE(block_cache_size() < 8u * 4096u);
+        cached_block_allocator(4096u).deallocate_block(block);
+
+        trim_block_cache();
+        REQUIRE(block_cache_size() == 0u);
+    }
+    SUBCASE("limit")
+    {
+        set_block_cache_limit(4096u);
+        std::thread([] {
+            cached_block_allocator alloc(4096u);
+            memory_block           blocks[4];
+            for (auto& block : blocks)
+            {
+                block = alloc.allocate_block();
+                alloc = cached_block_allocator(4096u);
+            }
+            for (auto& block : blocks)
+                alloc.deallocate_block(block);
+        }).join();
+        REQUIRE(block_cache_size() == 4096u);
+
+        set_block_cache_limit(64u * 1024u * 1024u);
+        trim_block_cache();
+    }
+}
@@ -0,0 +1,147 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "compressed_pool.hpp"
+
+#include <doctest/doctest.h>
+
+#include <memory>
+
+using namespace foonathan::memory;
+
+namespace
+{
+    struct handle_tag
+    {
+    };
+
+    struct trie_tag
+    {
+    };
+
+    struct container_tag
+    {
+    };
+
+    struct trie_node
+    {
+        compressed_ptr<trie_node, trie_tag> children[2];
+        int                                 value;
+    };
+} // namespace
+
+TEST_CASE("compressed_node_pool")
+{
+    compressed_node_pool<handle_tag> pool(12u, 100000u);
+    REQUIRE(compressed_node_pool<handle_tag>::instance() == &pool);
+    REQUIRE(pool.node_size() == 16u);
+    REQUIRE(pool.max_alignment() == 16u);
+    REQUIRE(pool.capacity_left() == 100000u);
+
+    auto a = pool.allocate_handle();
+    auto b = pool.allocate_handle();
+    REQUIRE(a != 0u);
+    REQUIRE(b != 0u);
+    REQUIRE(a != b);
+
+    auto ptr = compressed_node_pool<handle_tag>::get_pointer(a);
+    REQUIRE(pool.owns(ptr));
+    REQUIRE(compressed_node_pool<handle_tag>::get_handle(ptr) == a);
+    REQUIRE(compressed_node_pool<handle_tag>::get_pointer(0u) == nullptr);
+    REQUIRE(compressed_node_pool<handle_tag>::get_handle(nullptr) == 0u);
+
+    // nodes never move when the pool grows
+    *static_cast<int*>(ptr) = 42;
+    for (auto i = 0; i != 10000; ++i)
+        pool.allocate_node();
+    REQUIRE(compressed_node_pool<handle_tag>::get_pointer(a) == ptr);
+    REQUIRE(*static_cast<int*>(ptr) == 42);
+    REQUIRE(pool.capacity_left() == 100000u - 10002u);
+
+    pool.deallocate_handle(b);
+    REQUIRE(pool.allocate_handle() == b);
+
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+    auto thrown = false;
+    try
+    {
+        pool.allocate_node(32u, 8u);
+    }
+    catch (bad_node_size&)
+    {
+        thrown = true;
+    }
+    REQUIRE(thrown);
+#endif
+}
+
+TEST_CASE("compressed_ptr")
+{
+    static_assert(sizeof(compressed_ptr<trie_node, trie_tag>) == sizeof(compressed_handle), "");
+    static_assert(sizeof(trie_node) == 12u, "");
+
+    compressed_node_pool<trie_tag> pool(sizeof(trie_node), 1024u);
+    using ptr = compressed_ptr<trie_node, trie_tag>;
+
+    ptr root(::new (pool.allocate_node()) trie_node{{nullptr, nullptr}, 0});
+    REQUIRE(root);
+    REQUIRE(root != nullptr);
+    REQUIRE(root->children[0] == nullptr);
+
+    // inserts the numbers 0-15 in a binary trie
+    for (auto i = 0; i != 16; ++i)
+    {
+        auto cur = root;
+        for (auto bit = 0; bit != 4; ++bit)
+        {
+            auto& child = cur->children[(i >> bit) & 1];
+            if (!child)
+                child = ptr(::new (pool.allocate_node()) trie_node{{nullptr, nullptr}, -1});
+            cur = child;
+        }
+        cur->value = i;
+    }
+    REQUIRE(pool.capacity_left() == 1024u - 31u);
+
+    for (auto i = 0; i != 16; ++i)
+    {
+        auto cur = root;
+        for (auto bit = 0; bit != 4; ++bit)
+            cur = cur->children[(i >> bit) & 1];
+        REQUIRE((*cur).value == i);
+        REQUIRE(ptr::pointer_to(*cur) == cur);
+        REQUIRE(ptr::from_handle(cur.handle()) == cur);
+    }
+
+    compressed_ptr<void, trie_tag>            void_ptr(root);
+    compressed_ptr<const trie_node, trie_tag> const_ptr(root);
+    REQUIRE(void_ptr.get() == root.get());
+    REQUIRE(const_ptr.get() == root.get());
+    REQUIRE(ptr(void_ptr) == root);
+}
+
+TEST_CASE("compressed_allocator")
+{
+    compressed_node_pool<container_tag> pool(sizeof(trie_node), 1024u);
+
+    using traits = std::allocator_traits<compressed_allocator<int, container_tag>>;
+    static_assert(std::is_same<traits::pointer, compressed_ptr<int, container_tag>>::value, "");
+    static_assert(std::is_same<traits::void_pointer, compressed_ptr<void, container_tag>>::value,
+                  "");
+
+    using node_traits = traits::rebind_traits<trie_node>;
+    node_traits::allocator_type alloc;
+    REQUIRE(alloc == compressed_allocator<int, container_tag>());
+    REQUIRE(node_traits::max_size(alloc) == 1u);
+
+    auto node = node_traits::allocate(alloc, 1u);
+    REQUIRE(node);
+    REQUIRE(pool.owns(node.get()));
+    REQUIRE(pool.capacity_left() == 1023u);
+
+    node_traits::construct(alloc, node.get(), trie_node{{nullptr, nullptr}, 42});
+    REQUIRE(node->value == 42);
+    node_traits::destroy(alloc, node.get());
+    node_traits::deallocate(alloc, node, 1u);
+    REQUIRE(pool.capacity_left() == 1024u);
+}
@@ -0,0 +1,81 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "concurrent_memory_stack.hpp"
+
+#include <doctest/doctest.h>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("concurrent_memory_stack")
+{
+    test_allocator alloc;
+    concurrent_memory_stack<allocator_reference<test_allocator>> stack(
+        concurrent_memory_stack<>::min_block_size(1024u), alloc);
+    REQUIRE(alloc.no_allocated() == 0u);
+    REQUIRE(stack.capacity_left() == 0u);
+
+    SUBCASE("single thread")
+    {
+        auto m = stack.top();
+        auto a = stack.allocate(16u, 1u);
+        REQUIRE(alloc.no_allocated() == 1u);
+        REQUIRE(stack.owns(a));
+        REQUIRE(stack.capacity_left() < 1024u);
+        REQUIRE(stack.try_allocate(16u, 1u));
+        REQUIRE(!stack.try_allocate(2048u, 1u));
+
+        // new block after marker
+        auto m2 = stack.top();
+        REQUIRE(m < m2);
+        stack.allocate(16u, 1u);
+        REQUIRE(alloc.no_allocated() == 2u);
+
+        stack.unwind(m2);
+        REQUIRE(stack.capacity_left() == 0u);
+        REQUIRE(stack.owns(a));
+        stack.unwind(m);
+        REQUIRE(!stack.owns(a));
+
+        // reuses the cached block
+        stack.allocate(16u, 1u);
+        REQUIRE(alloc.no_allocated() == 2u);
+        stack.shrink_to_fit();
+        REQUIRE(alloc.no_allocated() == 1u);
+    }
+    SUBCASE("threads")
+    {
+        auto m = stack.top();
+
+        std::vector<std::thread> threads;
+        std::atomic<bool>        ok(true);
+        for (auto i = 0u; i != 4u; ++i)
+            threads.emplace_back(
+                [&, i]
+                {
+                    for (auto j = 0u; j != 128u; ++j)
+                    {
+                        auto mem = stack.allocate(16u, 8u);
+                        std::memset(mem, int(i), 16u);
+                        if (!stack.owns(mem))
+                            ok = false;
+                    }
+                });
+        for (auto& thread : threads)
+            thread.join();
+        REQUIRE(ok);
+        // each thread has its own blocks
+        REQUIRE(alloc.no_allocated() >= 4u);
+
+        stack.unwind(m);
+        stack.shrink_to_fit();
+        REQUIRE(alloc.no_allocated() == 0u);
+    }
+}
@@ -0,0 +1,153 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "container.hpp"
+
+#include <doctest/doctest.h>
+
+#include "memory_pool.hpp"
+#include "memory_stack.hpp"
+
+using namespace foonathan::memory;
+
+#if !defined(FOONATHAN_MEMORY_NO_NODE_SIZE)
+TEST_CASE("container_node_size")
+{
+    static_assert(container_node_size<std::list<int>>::value == list_node_size<int>::value, "");
+    static_assert(container_node_size<set<int, memory_pool<>>>::value
+                      == set_node_size<int>::value,
+                  "");
+    static_assert(container_node_size<std::map<int, char>>::value
+                      == map_node_size<std::pair<const int, char>>::value,
+                  "");
+    static_assert(container_node_size<unordered_map<int, int, memory_pool<>>>::value
+                      == unordered_map_node_size<std::pair<const int, int>>::value,
+                  "");
+}
+
+TEST_CASE("container_node_pool")
+{
+    SUBCASE("list")
+    {
+        using pool_type = container_node_pool<list<int, memory_pool<>>>;
+        pool_type pool(pool_type::min_block_size(16u));
+        REQUIRE(pool.get_allocator().node_size() >= list_node_size<int>::value);
+
+        auto& alloc    = pool.get_allocator();
+        auto  capacity = alloc.capacity_left();
+        {
+            auto list = make_pooled_list(pool);
+            for (auto i = 0; i != 16; ++i)
+                list.push_back(i);
+            REQUIRE(list.size() == 16u);
+            REQUIRE(alloc.capacity_left() == capacity - 16u * alloc.node_size());
+        }
+        REQUIRE(alloc.capacity_left() == capacity);
+    }
+    SUBCASE("map")
+    {
+        using pool_type = container_node_pool<map<int, double, memory_pool<>>>;
+        pool_type pool(pool_type::min_block_size(16u));
+
+        auto map = make_pooled_map(pool);
+        for (auto i = 0; i != 16; ++i)
+            map.emplace(i, i / 2.);
+        REQUIRE(map.size() == 16u);
+        REQUIRE(map[3] == 1.5);
+        REQUIRE(pool.get_allocator().capacity_left() == 0u);
+    }
+    SUBCASE("unordered_set")
+    {
+        // the bucket arrays are arrays of the pool
+        using pool_type = container_node_pool<unordered_set<int, memory_pool<array_pool>>>;
+        pool_type pool(pool_type::min_block_size(256u));
+
+        auto set = make_pooled_unordered_set(pool);
+        for (auto i = 0; i != 64; ++i)
+            set.insert(i);
+        REQUIRE(set.size() == 64u);
+        REQUIRE(set.count(42) == 1u);
+    }
+    SUBCASE("unordered_map")
+    {
+        // the bucket arrays are not allocated by the node pool
+        using pool_type = container_node_pool<unordered_map<int, int, pooled_node_segregator<>>>;
+        pool_type pool(pool_type::min_block_size(64u));
+
+        auto& nodes    = pool.get_allocator().get_node_pool();
+        auto  capacity = nodes.capacity_left();
+        {
+            auto map = make_pooled_unordered_map(pool);
+            for (auto i = 0; i != 64; ++i)
+                map.emplace(i, 2 * i);
+            REQUIRE(map.size() == 64u);
+            REQUIRE(map.at(42) == 84);
+            REQUIRE(map.bucket_count() >= 64u);
+            REQUIRE(nodes.capacity_left() == capacity - 64u * nodes.node_size());
+        }
+        REQUIRE(nodes.capacity_left() == capacity);
+    }
+}
+#endif
+
+namespace
+{
+    // forwards to a stack, but counts the deallocations it claims to not need
+    struct counting_stack_allocator
+    {
+        using is_deallocation_noop = std::true_type;
+
+        memory_stack<>* stack;
+        std::size_t*    deallocations;
+
+        void* allocate_node(std::size_t size, std::size_t alignment)
+        {
+            return stack->allocate(size, alignment);
+        }
+
+        void deallocate_node(void*, std::size_t, std::size_t) noexcept
+        {
+            ++*deallocations;
+        }
+    };
+} // namespace
+
+TEST_CASE("arena_container")
+{
+    static_assert(arena_container<map<int, int, memory_stack<>>>::skips_destruction::value
+                      == !FOONATHAN_MEMORY_DEBUG_LEAK_CHECK,
+                  "");
+    static_assert(!arena_container<list<int, memory_pool<>>>::skips_destruction::value, "");
+
+    memory_stack<> stack(4096u);
+    auto           marker = stack.top();
+
+    std::size_t              deallocations = 0u;
+    counting_stack_allocator alloc{&stack, &deallocations};
+    SUBCASE("trivial")
+    {
+        using container = arena_container<map<int, int, counting_stack_allocator>>;
+        static_assert(container::skips_destruction::value, "");
+        {
+            container map(alloc);
+            for (auto i = 0; i != 32; ++i)
+                map->emplace(i, 2 * i);
+            REQUIRE(map->size() == 32u);
+            REQUIRE((*map)[16] == 32);
+        }
+        REQUIRE(deallocations == 0u);
+    }
+    SUBCASE("non-trivial")
+    {
+        using container = arena_container<map<int, std::string, counting_stack_allocator>>;
+        static_assert(!container::skips_destruction::value, "");
+        {
+            container map(alloc);
+            for (auto i = 0; i != 32; ++i)
+                map->emplace(i, "a string that does not fit into the small buffer");
+            REQUIRE(map.get().size() == 32u);
+        }
+        REQUIRE(deallocations == 32u);
+    }
+    stack.unwind(marker);
+}
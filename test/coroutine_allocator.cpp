@@ -0,0 +1,153 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "coroutine_allocator.hpp"
+
+#include <doctest/doctest.h>
+
+#include "heap_allocator.hpp"
+#include "memory_stack.hpp"
+#include "test_allocator.hpp"
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define FOONATHAN_MEMORY_TEST_COROUTINES 1
+#endif
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+// GCC pairs the sized operator delete with the placement operator new and warns,
+// even though it is the one called by a coroutine
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+using namespace foonathan::memory;
+
+namespace
+{
+    struct frame_object
+    {
+    };
+} // namespace
+
+TEST_CASE("coroutine_frame_allocator")
+{
+    SUBCASE("any_allocator")
+    {
+        using promise = coroutine_frame_allocator<>;
+
+        test_allocator alloc;
+        auto           frame = promise::operator new(13u, std::allocator_arg, alloc, 1, 'a');
+        REQUIRE(alloc.no_allocated() == 1u);
+        REQUIRE(alloc.last_allocated().size == promise::frame_size(13u));
+        REQUIRE(alloc.last_allocated().size > 13u);
+        REQUIRE(alloc.last_allocated().alignment == detail::max_alignment);
+
+        frame_object object;
+        auto         member_frame = promise::operator new(64u, object, std::allocator_arg, alloc);
+        REQUIRE(alloc.no_allocated() == 2u);
+
+        promise::operator delete(frame, 13u);
+        promise::operator delete(member_frame, 64u);
+        REQUIRE(alloc.no_allocated() == 0u);
+        REQUIRE(alloc.last_deallocation_valid());
+    }
+    SUBCASE("stateful")
+    {
+        using promise = coroutine_frame_allocator<memory_stack<>>;
+
+        memory_stack<> stack(memory_stack<>::min_block_size(1024u));
+        auto           marker = stack.top();
+        auto           frame  = promise::operator new(100u, std::allocator_arg, stack);
+        REQUIRE(stack.top() != marker);
+        promise::operator delete(frame, 100u);
+        stack.unwind(marker);
+    }
+    SUBCASE("stateless")
+    {
+        using promise = coroutine_frame_allocator<heap_allocator>;
+        // nothing is stored for a stateless allocator
+        REQUIRE(promise::frame_size(13u) == 13u);
+
+        auto frame = promise::operator new(13u);
+        promise::operator delete(frame, 13u);
+
+        heap_allocator heap;
+        frame = promise::operator new(13u, std::allocator_arg, heap);
+        promise::operator delete(frame, 13u);
+    }
+}
+
+#if FOONATHAN_MEMORY_TEST_COROUTINES
+namespace
+{
+    struct task
+    {
+        struct promise_type : coroutine_frame_allocator<>
+        {
+            task get_return_object() noexcept
+            {
+                return {std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            std::suspend_always initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            std::suspend_always final_suspend() noexcept
+            {
+                return {};
+            }
+
+            void return_value(int v) noexcept
+            {
+                value = v;
+            }
+
+            void unhandled_exception() noexcept {}
+
+            int value = 0;
+        };
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    task add(std::allocator_arg_t, test_allocator&, int a, int b)
+    {
+        co_return a + b;
+    }
+
+    struct adder
+    {
+        int value;
+
+        task add(std::allocator_arg_t, test_allocator&, int b)
+        {
+            co_return value + b;
+        }
+    };
+} // namespace
+
+TEST_CASE("coroutine_frame_allocator coroutine")
+{
+    test_allocator alloc;
+
+    auto t = add(std::allocator_arg, alloc, 1, 2);
+    REQUIRE(alloc.no_allocated() == 1u);
+    t.handle.resume();
+    REQUIRE(t.handle.promise().value == 3);
+    t.handle.destroy();
+    REQUIRE(alloc.no_allocated() == 0u);
+
+    adder a{40};
+    t = a.add(std::allocator_arg, alloc, 2);
+    REQUIRE(alloc.no_allocated() == 1u);
+    t.handle.resume();
+    REQUIRE(t.handle.promise().value == 42);
+    t.handle.destroy();
+    REQUIRE(alloc.no_allocated() == 0u);
+    REQUIRE(alloc.last_deallocation_valid());
+}
+#endif
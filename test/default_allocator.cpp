@@ -6,6 +6,8 @@
 #include "default_allocator.hpp"
 
 #include <doctest/doctest.h>
+#include <atomic>
+#include <thread>
 #include <vector>
 
 #include "detail/align.hpp"
@@ -41,6 +43,19 @@ void check_default_allocator(Allocator& alloc, std::size_t def_alignment = detai
         alloc.deallocate_node(nodes[i], i, 1);
 }
 
+// checks every alignment the allocator claims to support
+template <class Allocator>
+void check_over_aligned(Allocator& alloc)
+{
+    for (auto alignment = detail::max_alignment; alignment <= alloc.max_alignment();
+         alignment *= 2u)
+    {
+        auto node = alloc.allocate_node(alignment + 1u, alignment);
+        REQUIRE(detail::is_aligned(node, alignment));
+        alloc.deallocate_node(node, alignment + 1u, alignment);
+    }
+}
+
 TEST_CASE("heap_allocator")
 {
     heap_allocator alloc;
@@ -51,12 +66,14 @@ TEST_CASE("new_allocator")
 {
     new_allocator alloc;
     check_default_allocator(alloc);
+    check_over_aligned(alloc);
 }
 
 TEST_CASE("malloc_allocator")
 {
     malloc_allocator alloc;
     check_default_allocator(alloc);
+    check_over_aligned(alloc);
 }
 
 TEST_CASE("static_allocator")
@@ -68,10 +85,57 @@ TEST_CASE("static_allocator")
     check_default_allocator(alloc, 1);
 }
 
+TEST_CASE("atomic_static_allocator")
+{
+    static_allocator_storage<4096> storage;
+    atomic_static_allocator        alloc(storage);
+    check_default_allocator(alloc, 1);
+
+    alloc.reset();
+    REQUIRE(alloc.capacity_left() == 4096u);
+    auto m = alloc.top();
+    REQUIRE(alloc.allocate_node(16u, 8u));
+    REQUIRE(alloc.capacity_left() < 4096u);
+    REQUIRE(!alloc.try_allocate_node(8192u, 1u));
+
+    std::vector<std::thread> threads;
+    std::atomic<bool>        ok(true);
+    for (auto i = 0u; i != 4u; ++i)
+        threads.emplace_back(
+            [&, i]
+            {
+                for (auto j = 0u; j != 16u; ++j)
+                {
+                    auto node = static_cast<unsigned char*>(alloc.try_allocate_node(16u, 8u));
+                    if (!node || !detail::is_aligned(node, 8u))
+                    {
+                        ok = false;
+                        continue;
+                    }
+                    for (auto k = 0u; k != 16u; ++k)
+                        node[k] = static_cast<unsigned char>(i);
+                    for (auto k = 0u; k != 16u; ++k)
+                        if (node[k] != i)
+                            ok = false; // overlapping allocation
+                }
+            });
+    for (auto& thread : threads)
+        thread.join();
+    REQUIRE(ok);
+
+    alloc.unwind(m);
+    REQUIRE(alloc.capacity_left() == 4096u);
+}
+
 TEST_CASE("virtual_memory_allocator")
 {
     virtual_memory_allocator alloc;
     check_default_allocator(alloc, get_virtual_memory_page_size());
+
+    auto node = static_cast<char*>(alloc.allocate_node_zeroed(100u, 1u));
+    for (auto i = 0u; i != 100u; ++i)
+        REQUIRE(node[i] == 0);
+    alloc.deallocate_node(node, 100u, 1u);
 }
 
 TEST_CASE("virtual_block_allocator")
@@ -83,5 +147,44 @@ TEST_CASE("virtual_block_allocator")
     auto                    block = alloc.allocate_block();
     REQUIRE(block.memory != nullptr);
     REQUIRE(block.size == page_size);
+    REQUIRE(alloc.last_block_zeroed());
+    alloc.deallocate_block(block);
+
+    // decommitted memory may keep its contents
+    block = alloc.allocate_block();
+    REQUIRE(!alloc.last_block_zeroed());
+    auto next = alloc.allocate_block();
+    REQUIRE(alloc.last_block_zeroed());
+    alloc.deallocate_block(next);
+    alloc.deallocate_block(block);
+}
+
+TEST_CASE("huge_page_allocator")
+{
+    huge_page_allocator alloc;
+    REQUIRE(huge_page_allocator::page_size() >= get_virtual_memory_page_size());
+    check_default_allocator(alloc, get_virtual_memory_page_size());
+
+    using traits = allocator_traits<huge_page_allocator>;
+    auto array   = static_cast<char*>(traits::allocate_array_zeroed(alloc, 10u, 10u, 1u));
+    for (auto i = 0u; i != 100u; ++i)
+        REQUIRE(array[i] == 0);
+    traits::deallocate_array(alloc, array, 10u, 10u, 1u);
+}
+
+TEST_CASE("virtual_block_allocator with huge pages")
+{
+    auto const            page_size = get_virtual_memory_page_size();
+    constexpr std::size_t no_blocks{4u};
+
+    virtual_block_allocator alloc{page_size, no_blocks, virtual_memory_page_mode::huge};
+    REQUIRE(alloc.page_size() == huge_page_allocator::page_size());
+    REQUIRE(alloc.next_block_size() % alloc.page_size() == 0u);
+    REQUIRE(alloc.capacity_left() == no_blocks);
+
+    auto block = alloc.allocate_block();
+    REQUIRE(block.memory != nullptr);
+    REQUIRE(block.size == alloc.next_block_size());
+    REQUIRE(detail::is_aligned(block.memory, alloc.page_size()));
     alloc.deallocate_block(block);
 }
@@ -0,0 +1,83 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "deferred_deallocator.hpp"
+
+#include <doctest/doctest.h>
+#include <thread>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "container.hpp"
+#include "memory_pool.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("deferred_deallocator")
+{
+    test_allocator alloc;
+    {
+        using allocator = deferred_deallocator<allocator_reference<test_allocator>, std::mutex, 4u>;
+        allocator deferred(alloc);
+
+        SUBCASE("batches")
+        {
+            std::vector<void*> nodes;
+            for (auto i = 0u; i != 6u; ++i)
+                nodes.push_back(deferred.allocate_node(16u, 8u));
+            REQUIRE(alloc.no_allocated() == 6u);
+
+            for (auto i = 0u; i != 3u; ++i)
+                deferred.deallocate_node(nodes[i], 16u, 8u);
+            // not a full batch yet
+            REQUIRE(alloc.no_allocated() == 6u);
+
+            auto array = deferred.allocate_array(4u, 16u, 8u);
+            deferred.deallocate_array(array, 4u, 16u, 8u);
+            deferred.drain();
+            REQUIRE(alloc.no_allocated() == 3u);
+            REQUIRE(deferred.pending_batches() == 0u);
+
+            for (auto i = 3u; i != 6u; ++i)
+                deferred.deallocate_node(nodes[i], 16u, 8u);
+            deferred.flush();
+        }
+        SUBCASE("multiple threads")
+        {
+            std::vector<std::thread> threads;
+            for (auto t = 0u; t != 4u; ++t)
+                threads.emplace_back([&] {
+                    std::vector<void*> nodes;
+                    for (auto i = 0u; i != 50u; ++i)
+                        nodes.push_back(deferred.allocate_node(32u, 8u));
+                    for (auto node : nodes)
+                        deferred.deallocate_node(node, 32u, 8u);
+                });
+            for (auto& thread : threads)
+                thread.join();
+
+            // exited threads have handed over their buffers
+            deferred.drain();
+            REQUIRE(alloc.no_allocated() == 0u);
+        }
+        SUBCASE("container")
+        {
+            memory_pool<> pool(list_node_size<int>::value, 4096u);
+
+            using pool_allocator = deferred_deallocator<allocator_reference<memory_pool<>>>;
+            pool_allocator deferred_pool(pool);
+            auto           capacity = pool.capacity_left();
+            {
+                list<int, pool_allocator> l(deferred_pool);
+                for (auto i = 0; i != 100; ++i)
+                    l.push_back(i);
+                REQUIRE(l.size() == 100u);
+            }
+            deferred_pool.drain();
+            REQUIRE(pool.capacity_left() >= capacity);
+        }
+    }
+    // the destructor does the remaining deallocations
+    REQUIRE(alloc.no_allocated() == 0u);
+}
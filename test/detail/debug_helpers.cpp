@@ -4,6 +4,8 @@
 #include "detail/debug_helpers.hpp"
 
 #include <doctest/doctest.h>
+#include <thread>
+#include <vector>
 
 #include "debugging.hpp"
 
@@ -42,6 +44,24 @@ TEST_CASE("detail::debug_is_filled")
 #else
     REQUIRE(ptr == nullptr);
 #endif
+
+    // finds the first mismatch of bigger memory at any offset
+    debug_magic big[100];
+    for (auto i = 0u; i != 100u; ++i)
+    {
+        for (auto& el : big)
+            el = debug_magic::freed_memory;
+        big[i]      = debug_magic::new_memory;
+        big[99 - i] = debug_magic::new_memory;
+
+        ptr = static_cast<debug_magic*>(
+            debug_is_filled(big, sizeof(big), debug_magic::freed_memory));
+#if FOONATHAN_MEMORY_DEBUG_FILL
+        REQUIRE(ptr == big + (i < 99u - i ? i : 99u - i));
+#else
+        REQUIRE(ptr == nullptr);
+#endif
+    }
 }
 
 TEST_CASE("detail::debug_fill_new/free")
@@ -77,3 +97,27 @@ TEST_CASE("detail::debug_fill_new/free")
         REQUIRE(array[i] == debug_magic::freed_memory);
 #endif
 }
+
+TEST_CASE("detail::sharded_leak_counter")
+{
+    static sharded_leak_counter counter;
+    REQUIRE(counter.total() == 0);
+    REQUIRE(leak_counter_shard() < leak_counter_shard_count);
+    REQUIRE(leak_counter_shard() == leak_counter_shard());
+
+    std::vector<std::thread> threads;
+    for (auto i = 0; i != 4; ++i)
+        threads.emplace_back([] {
+            for (auto j = 0; j != 1000; ++j)
+                counter.add(16);
+            for (auto j = 0; j != 500; ++j)
+                counter.add(-16);
+        });
+    for (auto& thread : threads)
+        thread.join();
+    REQUIRE(counter.total() == 4 * 500 * 16);
+
+    // memory can be deallocated by another thread
+    std::thread([] { counter.add(-4 * 500 * 16); }).join();
+    REQUIRE(counter.total() == 0);
+}
@@ -1,16 +1,22 @@
 // Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
 // SPDX-License-Identifier: Zlib
 
+#include "detail/bitmap_free_list.hpp"
+#include "detail/fixed_free_list.hpp"
 #include "detail/free_list.hpp"
 #include "detail/small_free_list.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <doctest/doctest.h>
+#include <functional>
 #include <random>
+#include <thread>
 #include <vector>
 
 #include "detail/align.hpp"
 #include "static_allocator.hpp"
+#include "../test_allocator.hpp"
 
 using namespace foonathan::memory;
 using namespace detail;
@@ -145,6 +151,49 @@ void check_move(FreeList& list)
     list.deallocate(ptr);
 }
 
+template <class FreeList>
+void check_remove_if(FreeList& list)
+{
+    static_allocator_storage<1024> a, b;
+    list.insert(&a, 1024u);
+    list.insert(&b, 1024u);
+    auto nodes = list.capacity() / 2u;
+
+    struct context
+    {
+        char*       begin;
+        std::size_t in_block, total;
+
+        bool contains(const char* node) const
+        {
+            return begin <= node && node < begin + 1024;
+        }
+    } ctx{reinterpret_cast<char*>(&b), 0u, 0u};
+
+    auto used   = static_cast<char*>(list.allocate());
+    auto b_free = ctx.contains(used) ? nodes - 1u : nodes;
+
+    list.visit(
+        [](void* data, char* node, std::size_t no_nodes)
+        {
+            auto& c = *static_cast<context*>(data);
+            c.total += no_nodes;
+            if (c.contains(node))
+                c.in_block += no_nodes;
+        },
+        &ctx);
+    REQUIRE(ctx.total == list.capacity());
+    REQUIRE(ctx.in_block == b_free);
+
+    // remove the free nodes of b, the ones of a are still there
+    list.remove_if([](void* data, char* node)
+                   { return static_cast<context*>(data)->contains(node); },
+                   &ctx);
+    REQUIRE(list.capacity() == 2u * nodes - 1u - b_free);
+    while (!list.empty())
+        REQUIRE(!ctx.contains(static_cast<char*>(list.allocate())));
+}
+
 TEST_CASE("free_memory_list")
 {
     free_memory_list list(4);
@@ -166,6 +215,21 @@ TEST_CASE("free_memory_list")
 
         check_move(list);
     }
+    SUBCASE("poisoning")
+    {
+        auto poisoned = poisoning_active();
+
+        static_allocator_storage<1024> memory;
+        free_memory_list               big(32u, &memory, 1024u);
+        auto                           node = static_cast<char*>(big.allocate());
+        REQUIRE(!detail::debug_is_poisoned(node + 31));
+
+        big.deallocate(node);
+        REQUIRE(!detail::debug_is_poisoned(node)); // the pointer to the next node
+        REQUIRE(detail::debug_is_poisoned(node + 31) == poisoned);
+        REQUIRE(big.allocate() == node);
+        REQUIRE(!detail::debug_is_poisoned(node + 31));
+    }
     SUBCASE("multiple insert")
     {
         static_allocator_storage<1024> a;
@@ -177,9 +241,111 @@ TEST_CASE("free_memory_list")
 
         check_move(list);
     }
+    SUBCASE("untouched nodes")
+    {
+        static_allocator_storage<1024> a, b;
+        free_memory_list               big(32u);
+        auto                           first = reinterpret_cast<char*>(&a);
+        auto                           size  = big.node_size();
+        auto                           nodes = 1024u / size;
+
+        // nothing is linked until a node is deallocated
+        a.storage[0] = 'a';
+        big.insert(&a, 1024u);
+        REQUIRE(big.capacity() == nodes);
+        REQUIRE(big.untouched_capacity() == nodes);
+#if !FOONATHAN_MEMORY_DEBUG_FILL
+        REQUIRE(a.storage[0] == 'a');
+#endif
+
+        // nodes are taken in address order
+        auto node = big.allocate();
+        REQUIRE(node == first);
+        REQUIRE(big.allocate() == first + size);
+        REQUIRE(big.untouched_capacity() == nodes - 2u);
+
+        // freed nodes are reused first
+        big.deallocate(node);
+        REQUIRE(big.capacity() == nodes - 1u);
+        REQUIRE(big.allocate() == node);
+        REQUIRE(big.allocate() == first + 2u * size);
+
+        // arrays are taken from the untouched nodes as well
+        REQUIRE(big.allocate(2u * size) == first + 3u * size);
+        REQUIRE(big.untouched_capacity() == nodes - 5u);
+
+        // inserting another block links the remaining nodes of the previous one
+        big.insert(&b, 1024u);
+        REQUIRE(big.capacity() == 2u * nodes - 5u);
+        REQUIRE(big.untouched_capacity() == nodes);
+        REQUIRE(big.allocate() == first + 5u * size);
+    }
+    SUBCASE("remove_if")
+    {
+        check_remove_if(list);
+    }
 }
 
-void use_list_array(ordered_free_memory_list& list)
+TEST_CASE("fixed_free_memory_list")
+{
+    using list_type = fixed_free_memory_list<12u, 4u>;
+    static_assert(list_type::fixed_node_size == 12u, "");
+    static_assert(fixed_free_memory_list<2u, 2u>::fixed_node_size == sizeof(char*), "");
+    static_assert(fixed_free_memory_list<20u, 8u>::fixed_node_size == 24u, "");
+    static_assert(sizeof(list_type) < sizeof(free_memory_list), "");
+
+    list_type list;
+    REQUIRE(list.empty());
+    REQUIRE(list.node_size() == 12u);
+    REQUIRE(list.alignment() == 4u);
+    REQUIRE(list.capacity() == 0u);
+
+    SUBCASE("normal insert")
+    {
+        static_allocator_storage<1024> memory;
+        check_list(list, &memory, 1024);
+
+        check_move(list);
+    }
+    SUBCASE("uneven insert")
+    {
+        static_allocator_storage<1023> memory; // not dividable
+        check_list(list, &memory, 1023);
+
+        check_move(list);
+    }
+    SUBCASE("multiple insert")
+    {
+        static_allocator_storage<1024> a;
+        static_allocator_storage<100>  b;
+        static_allocator_storage<1337> c;
+        check_list(list, &a, 1024);
+        check_list(list, &b, 100);
+        check_list(list, &c, 1337);
+
+        check_move(list);
+    }
+    SUBCASE("zeroed")
+    {
+        static_allocator_storage<120> memory;
+        std::memset(&memory, 0, sizeof(memory));
+        // like memory_arena, debug filling overwrites the zeroes
+        list.insert(&memory, 120u, !FOONATHAN_MEMORY_DEBUG_FILL);
+        REQUIRE(list.untouched_capacity() == 10u);
+
+        auto node = static_cast<char*>(list.allocate_zeroed());
+        REQUIRE(std::all_of(node, node + 12, [](char c) { return c == 0; }));
+        std::memset(node, 'a', 12u);
+        list.deallocate(node);
+
+        // the reused node is cleared again
+        REQUIRE(list.allocate_zeroed() == node);
+        REQUIRE(std::all_of(node, node + 12, [](char c) { return c == 0; }));
+    }
+}
+
+template <class FreeList>
+void use_list_array(FreeList& list)
 {
     std::vector<void*> ptrs;
     auto               capacity = list.capacity();
@@ -241,6 +407,43 @@ void use_list_array(ordered_free_memory_list& list)
     }
 }
 
+template <class FreeList>
+void use_list_random(FreeList& list)
+{
+    auto capacity = list.capacity();
+
+    std::vector<void*> ptrs;
+    for (std::size_t i = 0u; i != capacity; ++i)
+        ptrs.push_back(list.allocate());
+
+    std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{});
+    // reallocate some of the nodes in between, so the list changes around the hints
+    for (std::size_t i = 0u; i != ptrs.size(); ++i)
+    {
+        list.deallocate(ptrs[i]);
+        if (i % 3u == 0u)
+        {
+            ptrs[i] = list.allocate();
+            list.deallocate(ptrs[i]);
+        }
+    }
+    REQUIRE(list.capacity() == capacity);
+
+    // the list is still sorted
+    char* prev = nullptr;
+    for (std::size_t i = 0u; i != capacity; ++i)
+    {
+        auto node = static_cast<char*>(list.allocate());
+        REQUIRE(std::less<char*>()(prev, node));
+        prev    = node;
+        ptrs[i] = node;
+    }
+    std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{});
+    for (auto ptr : ptrs)
+        list.deallocate(ptr);
+    REQUIRE(list.capacity() == capacity);
+}
+
 TEST_CASE("ordered_free_memory_list")
 {
     ordered_free_memory_list list(4);
@@ -278,6 +481,137 @@ TEST_CASE("ordered_free_memory_list")
 
         check_move(list);
     }
+    SUBCASE("remove_if")
+    {
+        check_remove_if(list);
+    }
+    SUBCASE("random deallocation")
+    {
+        static_allocator_storage<4096> memory;
+        list.insert(&memory, 4096);
+        use_list_random(list);
+    }
+}
+
+TEST_CASE("indexed_free_memory_list")
+{
+    indexed_free_memory_list list(4);
+    REQUIRE(list.empty());
+    REQUIRE(list.node_size() >= 4);
+    REQUIRE(list.capacity() == 0u);
+
+    SUBCASE("normal insert")
+    {
+        static_allocator_storage<1024> memory;
+        check_list(list, &memory, 1024);
+        use_list_array(list);
+
+        check_move(list);
+    }
+    SUBCASE("multiple insert")
+    {
+        static_allocator_storage<1024> a;
+        static_allocator_storage<100>  b;
+        static_allocator_storage<1337> c;
+        check_list(list, &a, 1024);
+        use_list_array(list);
+        check_list(list, &b, 100);
+        use_list_array(list);
+        check_list(list, &c, 1337);
+        use_list_array(list);
+
+        check_move(list);
+    }
+    SUBCASE("random deallocation")
+    {
+        static_allocator_storage<4096> a;
+        static_allocator_storage<4096> b;
+        list.insert(&a, 4096);
+        list.insert(&b, 4096);
+        use_list_random(list);
+
+        // the hints are not moved with the list
+        auto list2 = detail::move(list);
+        use_list_random(list2);
+        list = detail::move(list2);
+        use_list_random(list);
+    }
+}
+
+TEST_CASE("bitmap_free_memory_list")
+{
+    bitmap_free_memory_list list(4);
+    REQUIRE(list.empty());
+    REQUIRE(list.node_size() == 4);
+    REQUIRE(list.capacity() == 0u);
+
+    SUBCASE("normal insert")
+    {
+        static_allocator_storage<1024> memory;
+        check_list(list, &memory, 1024);
+        REQUIRE(list.capacity() * list.node_size() == list.usable_size(1024));
+        use_list_array(list);
+
+        check_move(list);
+    }
+    SUBCASE("uneven insert")
+    {
+        static_allocator_storage<1023> memory; // not dividable
+        check_list(list, &memory, 1023);
+        use_list_array(list);
+
+        check_move(list);
+    }
+    SUBCASE("multiple insert")
+    {
+        static_allocator_storage<1024> a;
+        static_allocator_storage<100>  b;
+        static_allocator_storage<1337> c;
+        check_list(list, &a, 1024);
+        use_list_array(list);
+        check_list(list, &b, 100);
+        use_list_array(list);
+        check_list(list, &c, 1337);
+        use_list_array(list);
+
+        check_move(list);
+    }
+    SUBCASE("fragmented arrays")
+    {
+        static_allocator_storage<4096> memory;
+        list.insert(&memory, 4096);
+        auto capacity = list.capacity();
+        REQUIRE(capacity > 192u);
+
+        std::vector<char*> nodes;
+        while (!list.empty())
+            nodes.push_back(static_cast<char*>(list.allocate()));
+        // nodes are handed out in address order
+        REQUIRE(std::is_sorted(nodes.begin(), nodes.end()));
+
+        // free every other node, a run of three nodes and one of 100 nodes crossing bitmap words
+        for (std::size_t i = 0u; i < 60u; i += 2u)
+            list.deallocate(nodes[i]);
+        for (std::size_t i = 61u; i != 64u; ++i)
+            list.deallocate(nodes[i]);
+        for (std::size_t i = 90u; i != 190u; ++i)
+            list.deallocate(nodes[i]);
+
+        REQUIRE(list.allocate(4u * list.node_size()) == nodes[90]);
+        REQUIRE(list.allocate(3u * list.node_size()) == nodes[61]);
+        REQUIRE(list.allocate(96u * list.node_size()) == nodes[94]);
+        REQUIRE(list.allocate(2u * list.node_size()) == nullptr);
+        REQUIRE(list.capacity() == 30u);
+
+        list.deallocate(nodes[90], 4u * list.node_size());
+        list.deallocate(nodes[61], 3u * list.node_size());
+        list.deallocate(nodes[94], 96u * list.node_size());
+        for (std::size_t i = 0u; i != nodes.size(); ++i)
+            if ((i >= 60u || i % 2u == 1u) && (i < 61u || i >= 64u) && (i < 90u || i >= 190u))
+                list.deallocate(nodes[i]);
+        REQUIRE(list.capacity() == capacity);
+        REQUIRE(list.allocate() == nodes.front());
+    }
 }
 
 TEST_CASE("small_free_memory_list")
@@ -320,3 +654,95 @@ TEST_CASE("small_free_memory_list")
         check_move(list);
     }
 }
+
+TEST_CASE("wide_small_free_memory_list")
+{
+    wide_small_free_memory_list list(1);
+    REQUIRE(list.empty());
+    REQUIRE(list.node_size() == 2);
+    REQUIRE(list.capacity() == 0u);
+
+    SUBCASE("normal insert")
+    {
+        static_allocator_storage<1024> memory;
+        check_list(list, &memory, 1024);
+
+        check_move(list);
+    }
+    SUBCASE("big insert")
+    {
+        // more nodes than fit into a chunk of small_free_memory_list
+        static_allocator_storage<4096> memory;
+        check_list(list, &memory, 4096);
+        REQUIRE(list.capacity() > small_free_memory_list::chunk_max_nodes);
+
+        check_move(list);
+    }
+    SUBCASE("multiple insert")
+    {
+        static_allocator_storage<1024> a;
+        static_allocator_storage<100>  b;
+        static_allocator_storage<1337> c;
+        check_list(list, &a, 1024);
+        check_list(list, &b, 100);
+        check_list(list, &c, 1337);
+
+        check_move(list);
+    }
+}
+
+TEST_CASE("concurrent_free_memory_list")
+{
+    concurrent_free_memory_list list(4);
+    REQUIRE(list.empty());
+    REQUIRE(list.node_size() >= 4);
+    REQUIRE(list.capacity() == 0u);
+#if FOONATHAN_MEMORY_IMPL_PACKED_TAG
+    REQUIRE(list.is_lock_free());
+#endif
+
+    SUBCASE("normal insert")
+    {
+        static_allocator_storage<1024> memory;
+        check_list(list, &memory, 1024);
+
+        check_move(list);
+    }
+    SUBCASE("multiple insert")
+    {
+        static_allocator_storage<1024> a;
+        static_allocator_storage<100>  b;
+        static_allocator_storage<1337> c;
+        check_list(list, &a, 1024);
+        check_list(list, &b, 100);
+        check_list(list, &c, 1337);
+
+        check_move(list);
+    }
+    SUBCASE("concurrent use")
+    {
+        static_allocator_storage<4096> memory;
+        list.insert(&memory, 4096);
+        auto capacity = list.capacity();
+
+        std::vector<std::thread> threads;
+        for (auto t = 0u; t != 4u; ++t)
+            threads.emplace_back([&] {
+                std::vector<void*> ptrs;
+                for (auto round = 0u; round != 100u; ++round)
+                {
+                    for (auto i = 0u; i != 16u; ++i)
+                        if (auto ptr = list.allocate())
+                            ptrs.push_back(ptr);
+                    for (auto ptr : ptrs)
+                        list.deallocate(ptr);
+                    ptrs.clear();
+                }
+            });
+        for (auto& thread : threads)
+            thread.join();
+
+        REQUIRE(list.capacity() == capacity);
+        use_list_node(list);
+    }
+}
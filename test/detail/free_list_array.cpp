@@ -30,6 +30,33 @@ TEST_CASE("detail::log2_access_policy")
     REQUIRE(ap::size_from_index(3) == 8u);
 }
 
+TEST_CASE("detail::geometric_access_policy")
+{
+    using ap = detail::geometric_access_policy;
+    REQUIRE(ap::index_from_size(1) == 1u);
+    REQUIRE(ap::index_from_size(4) == 4u);
+    REQUIRE(ap::index_from_size(5) == 5u);
+    REQUIRE(ap::index_from_size(8) == 8u);
+    REQUIRE(ap::index_from_size(9) == 9u);
+    REQUIRE(ap::index_from_size(10) == 9u);
+    REQUIRE(ap::index_from_size(11) == 10u);
+    REQUIRE(ap::index_from_size(41) == 18u);
+    REQUIRE(ap::index_from_size(48) == 18u);
+    REQUIRE(ap::index_from_size(64) == 20u);
+
+    for (auto i = 1u; i != 100u; ++i)
+    {
+        REQUIRE(ap::index_from_size(ap::size_from_index(i)) == i);
+        REQUIRE(ap::size_from_index(i) < ap::size_from_index(i + 1u));
+    }
+    for (auto size = 1u; size != 1000u; ++size)
+    {
+        auto class_size = ap::size_from_index(ap::index_from_size(size));
+        REQUIRE(class_size >= size);
+        REQUIRE((class_size - size) * 4u < class_size);
+    }
+}
+
 TEST_CASE("detail::free_list_array")
 {
     static_allocator_storage<1024> memory;
@@ -78,4 +105,16 @@ TEST_CASE("detail::free_list_array")
         REQUIRE(arr.get(9u).node_size() == 16u);
         REQUIRE(arr.get(15u).node_size() == 16u);
     }
+    SUBCASE("geometric, normal list")
+    {
+        using array =
+            detail::free_list_array<detail::free_memory_list, detail::geometric_access_policy>;
+        array arr(stack, stack.top() + 1024, 60);
+        REQUIRE(arr.max_node_size() == 64u);
+
+        REQUIRE(arr.get(1u).node_size() == detail::free_memory_list::min_element_size);
+        REQUIRE(arr.get(33u).node_size() == 40u);
+        REQUIRE(arr.get(41u).node_size() == 48u);
+        REQUIRE(arr.get(60u).node_size() == 64u);
+    }
 }
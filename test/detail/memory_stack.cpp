@@ -44,6 +44,23 @@ TEST_CASE("detail::fixed_memory_stack")
             REQUIRE(ptr);
             REQUIRE(is_aligned(ptr, 2 * max_alignment));
         }
+        SUBCASE("alignment known at compile-time")
+        {
+            auto ptr = stack.allocate<13, 1>(end);
+            REQUIRE(ptr == reinterpret_cast<char*>(&memory) + debug_fence_size);
+
+            ptr = stack.allocate<10, 8>(end);
+            REQUIRE(ptr);
+            REQUIRE(is_aligned(ptr, 8u));
+
+            ptr = stack.allocate<10, 2 * max_alignment>(end);
+            REQUIRE(ptr);
+            REQUIRE(is_aligned(ptr, 2 * max_alignment));
+
+            auto top = stack.top();
+            REQUIRE(!stack.allocate<1024, 1>(end));
+            REQUIRE(stack.top() == top);
+        }
         SUBCASE("allocate/unwind")
         {
             REQUIRE(stack.allocate(end, 10u, 1u));
@@ -61,6 +78,25 @@ TEST_CASE("detail::fixed_memory_stack")
             REQUIRE(!stack.allocate(end, 1024, 1));
             REQUIRE(stack.top() == top);
         }
+        SUBCASE("try_resize")
+        {
+            auto first = stack.allocate(end, 10u, 1u);
+            auto last  = stack.allocate(end, 10u, 1u);
+            REQUIRE(first);
+            REQUIRE(last);
+
+            // only the last allocation can be resized
+            REQUIRE(!stack.try_resize(end, first, 10u, 20u));
+            REQUIRE(stack.try_resize(end, last, 10u, 100u));
+            REQUIRE(stack.top() == static_cast<char*>(last) + 100u + debug_fence_size);
+
+            REQUIRE(stack.try_resize(end, last, 100u, 5u));
+            REQUIRE(stack.top() == static_cast<char*>(last) + 5u + debug_fence_size);
+
+            auto top = stack.top();
+            REQUIRE(!stack.try_resize(end, last, 5u, 1024u));
+            REQUIRE(stack.top() == top);
+        }
     }
     SUBCASE("move")
     {
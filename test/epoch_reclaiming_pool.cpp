@@ -0,0 +1,142 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "epoch_reclaiming_pool.hpp"
+
+#include <doctest/doctest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace foonathan::memory;
+
+TEST_CASE("epoch_reclaiming_pool")
+{
+    using pool_type = epoch_reclaiming_pool<>;
+
+    pool_type pool(sizeof(void*), pool_type::min_block_size(sizeof(void*), 256u));
+    auto      capacity = pool.capacity_left();
+
+    SUBCASE("deferred")
+    {
+        pool_type::participant a(pool), b(pool);
+
+        auto node = pool.allocate_node();
+        {
+            auto guard = b.pin();
+            REQUIRE(b.is_pinned());
+
+            a.retire(node);
+            REQUIRE(a.retired() == 1u);
+            a.collect();
+            a.collect();
+            a.collect();
+            // b might still access it
+            REQUIRE(a.retired() == 1u);
+            REQUIRE(pool.epoch() == 1u);
+        }
+        REQUIRE(!b.is_pinned());
+
+        a.collect();
+        REQUIRE(a.retired() == 0u);
+        REQUIRE(pool.epoch() == 2u);
+        REQUIRE(pool.capacity_left() == capacity);
+    }
+    SUBCASE("nested pin")
+    {
+        pool_type::participant a(pool);
+        auto                   outer = a.pin();
+        {
+            auto inner = a.pin();
+        }
+        REQUIRE(a.is_pinned());
+        REQUIRE(pool.try_advance());
+        // a has not observed the new epoch
+        REQUIRE(!pool.try_advance());
+    }
+    SUBCASE("threshold")
+    {
+        pool_type::participant a(pool);
+        for (auto i = 0u; i != 4u * pool_type::collect_threshold; ++i)
+        {
+            auto guard = a.pin();
+            a.retire(pool.allocate_node());
+        }
+        REQUIRE(a.retired() < 4u * pool_type::collect_threshold);
+        REQUIRE(pool.epoch() >= 3u);
+    }
+    SUBCASE("orphaned")
+    {
+        {
+            pool_type::participant a(pool);
+            a.retire(pool.allocate_node());
+        }
+        pool_type::participant b(pool), c(pool);
+        REQUIRE(b.retired() == 1u);
+        c.collect();
+        c.collect();
+        c.collect();
+        REQUIRE(b.retired() == 1u);
+
+        // the state of a was reused by b, so c does not see the node anymore
+        b.collect();
+        REQUIRE(b.retired() == 0u);
+        REQUIRE(pool.capacity_left() == capacity);
+    }
+}
+
+TEST_CASE("epoch_reclaiming_pool concurrent")
+{
+    struct node
+    {
+        std::size_t value;
+    };
+
+    using pool_type = epoch_reclaiming_pool<>;
+    pool_type pool(sizeof(node), pool_type::min_block_size(sizeof(node), 64u));
+
+    auto make = [&](std::size_t value)
+    {
+        auto result   = static_cast<node*>(pool.allocate_node());
+        result->value = value;
+        return result;
+    };
+
+    constexpr std::size_t    no_writers = 2u, no_readers = 2u, iterations = 20000u;
+    std::atomic<node*>       current(make(0u));
+    std::atomic<std::size_t> errors(0u);
+
+    std::vector<std::thread> threads;
+    for (auto t = 0u; t != no_writers; ++t)
+        threads.emplace_back(
+            [&, t]
+            {
+                pool_type::participant self(pool);
+                for (auto i = 0u; i != iterations; ++i)
+                {
+                    auto guard = self.pin();
+                    auto old   = current.exchange(make(2u * (t * iterations + i) + 1u));
+                    self.retire(old);
+                }
+            });
+    for (auto t = 0u; t != no_readers; ++t)
+        threads.emplace_back(
+            [&]
+            {
+                pool_type::participant self(pool);
+                for (auto i = 0u; i != iterations; ++i)
+                {
+                    auto guard = self.pin();
+                    // a deallocated node would have its value overwritten by the free list link
+                    auto value = current.load()->value;
+                    if (value % 2u == 0u && value != 0u)
+                        errors.fetch_add(1u);
+                }
+            });
+    for (auto& thread : threads)
+        thread.join();
+
+    REQUIRE(errors.load() == 0u);
+    REQUIRE(pool.epoch() > 2u);
+    pool.deallocate_node(current.load());
+}
@@ -56,3 +56,133 @@ TEST_CASE("fallback_allocator")
     REQUIRE(default_alloc.no_deallocated() == 1u);
     REQUIRE(fallback_alloc.no_deallocated() == 1u);
 }
+
+TEST_CASE("adaptive_fallback_allocator")
+{
+    struct test_compositioning : test_allocator
+    {
+        std::size_t capacity = 1u;
+        std::size_t tries    = 0u;
+
+        void* try_allocate_node(std::size_t size, std::size_t alignment)
+        {
+            ++tries;
+            if (no_allocated() == capacity)
+                return nullptr;
+            return allocate_node(size, alignment);
+        }
+
+        bool try_deallocate_node(void* ptr, std::size_t size, std::size_t alignment)
+        {
+            if (!owns(ptr))
+                return false;
+            deallocate_node(ptr, size, alignment);
+            return true;
+        }
+
+        bool owns(void* ptr)
+        {
+            return ptr == owned;
+        }
+
+        void* owned = nullptr;
+    } default_alloc;
+    test_allocator fallback_alloc;
+
+    using allocator = adaptive_fallback_allocator<allocator_reference<test_compositioning>,
+                                                  allocator_reference<test_allocator>>;
+
+    allocator alloc(default_alloc, fallback_alloc, 3u);
+    REQUIRE(!alloc.is_exhausted());
+    REQUIRE(alloc.stats().hit_ratio() == 0.);
+
+    auto first          = alloc.allocate_node(1, 1);
+    default_alloc.owned = first;
+    REQUIRE(default_alloc.no_allocated() == 1u);
+    REQUIRE(alloc.stats().hits == 1u);
+
+    // the first failure marks it as exhausted, the next allocations skip it
+    void* nodes[4];
+    for (auto& node : nodes)
+        node = alloc.allocate_node(1, 1);
+    REQUIRE(alloc.is_exhausted());
+    REQUIRE(fallback_alloc.no_allocated() == 4u);
+    REQUIRE(default_alloc.tries == 3u);
+    REQUIRE(alloc.stats().misses == 2u);
+    REQUIRE(alloc.stats().skips == 2u);
+    REQUIRE(alloc.stats().hit_ratio() == 0.2);
+
+    // a deallocation from the default allocator makes it available again
+    for (auto node : nodes)
+        alloc.deallocate_node(node, 1, 1);
+    REQUIRE(fallback_alloc.no_allocated() == 0u);
+    REQUIRE(alloc.is_exhausted());
+    alloc.deallocate_node(first, 1, 1);
+    REQUIRE(default_alloc.no_allocated() == 0u);
+    REQUIRE(!alloc.is_exhausted());
+
+    alloc.reset_stats();
+    auto ptr = alloc.allocate_node(1, 1);
+    REQUIRE(default_alloc.no_allocated() == 1u);
+    REQUIRE(alloc.stats().hits == 1u);
+    default_alloc.owned = ptr;
+    alloc.deallocate_node(ptr, 1, 1);
+}
+
+TEST_CASE("adaptive_fallback_allocator exhausted size")
+{
+    // can allocate nodes until a total of 16 bytes
+    struct test_compositioning : test_allocator
+    {
+        std::size_t left = 16u;
+
+        void* try_allocate_node(std::size_t size, std::size_t alignment)
+        {
+            if (size > left)
+                return nullptr;
+            left -= size;
+            return allocate_node(size, alignment);
+        }
+
+        bool try_deallocate_node(void*, std::size_t, std::size_t)
+        {
+            return false;
+        }
+    } default_alloc;
+    test_allocator fallback_alloc;
+
+    using allocator = adaptive_fallback_allocator<allocator_reference<test_compositioning>,
+                                                  allocator_reference<test_allocator>>;
+
+    allocator alloc(default_alloc, fallback_alloc, 0u);
+
+    // a large miss only skips the default allocator for large nodes
+    auto big = alloc.allocate_node(32u, 1u);
+    REQUIRE(fallback_alloc.no_allocated() == 1u);
+    REQUIRE(alloc.is_exhausted());
+    REQUIRE(alloc.exhausted_size() == 32u);
+
+    void* nodes[4];
+    for (auto& node : nodes)
+        node = alloc.allocate_node(4u, 1u);
+    REQUIRE(default_alloc.no_allocated() == 4u);
+    REQUIRE(fallback_alloc.no_allocated() == 1u);
+    REQUIRE(alloc.stats().hits == 4u);
+
+    auto other_big = alloc.allocate_node(64u, 1u);
+    REQUIRE(fallback_alloc.no_allocated() == 2u);
+    REQUIRE(alloc.stats().skips == 1u);
+
+    // the smaller miss lowers the size
+    auto small = alloc.allocate_node(4u, 1u);
+    REQUIRE(fallback_alloc.no_allocated() == 3u);
+    REQUIRE(alloc.exhausted_size() == 4u);
+    REQUIRE(alloc.stats().misses == 2u);
+
+    alloc.deallocate_node(big, 32u, 1u);
+    alloc.deallocate_node(other_big, 64u, 1u);
+    alloc.deallocate_node(small, 4u, 1u);
+    REQUIRE(fallback_alloc.no_allocated() == 0u);
+    for (auto node : nodes)
+        default_alloc.deallocate_node(node, 4u, 1u);
+}
@@ -0,0 +1,196 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "flat_map.hpp"
+#include "flat_hash_map.hpp"
+
+#include <algorithm>
+#include <doctest/doctest.h>
+#include <map>
+#include <random>
+#include <string>
+
+#include "memory_stack.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("flat_set")
+{
+    test_allocator alloc;
+    {
+        flat_set<int, test_allocator> set(alloc);
+        REQUIRE(set.empty());
+        REQUIRE(set.find(0) == set.end());
+
+        for (auto i : {5, 1, 4, 1, 3, 2, 5})
+            set.insert(i);
+        REQUIRE(set.size() == 5u);
+        const int sorted[] = {1, 2, 3, 4, 5};
+        REQUIRE(std::equal(set.begin(), set.end(), sorted));
+
+        auto result = set.emplace(3);
+        REQUIRE(!result.second);
+        REQUIRE(*result.first == 3);
+        REQUIRE(set.contains(4));
+        REQUIRE(set.count(6) == 0u);
+        REQUIRE(*set.lower_bound(3) == 3);
+        REQUIRE(*set.upper_bound(3) == 4);
+
+        REQUIRE(set.erase(3) == 1u);
+        REQUIRE(set.erase(3) == 0u);
+        REQUIRE(*set.erase(set.begin()) == 2);
+        const int erased[] = {2, 4, 5};
+        REQUIRE(std::equal(set.begin(), set.end(), erased));
+
+        set.clear();
+        REQUIRE(set.empty());
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+    REQUIRE(alloc.last_deallocation_valid());
+}
+
+TEST_CASE("flat_map")
+{
+    SUBCASE("basic")
+    {
+        test_allocator alloc;
+        {
+            flat_map<int, std::string, test_allocator, std::greater<int>> map(alloc);
+            REQUIRE(map.insert({1, "a"}).second);
+            REQUIRE(map.try_emplace(3, 2u, 'c').second);
+            REQUIRE(!map.try_emplace(1, "x").second);
+            map[2] = "b";
+            REQUIRE(map.size() == 3u);
+
+            // sorted with the comparison
+            REQUIRE(map.begin()->first == 3);
+            REQUIRE(map.begin()->second == "cc");
+            REQUIRE(map.find(1)->second == "a");
+            REQUIRE(map[2] == "b");
+            REQUIRE(map.lower_bound(2)->first == 2);
+            REQUIRE(map.upper_bound(2)->first == 1);
+            REQUIRE(map.upper_bound(1) == map.end());
+
+            REQUIRE(map.erase(3) == 1u);
+            REQUIRE(map.begin()->first == 2);
+            REQUIRE(map.erase(map.begin())->first == 1);
+            REQUIRE(map.size() == 1u);
+        }
+        REQUIRE(alloc.no_allocated() == 0u);
+        REQUIRE(alloc.last_deallocation_valid());
+    }
+    SUBCASE("growth in place")
+    {
+        memory_stack<> stack(4096u);
+
+        flat_map<int, int, memory_stack<>> map(stack);
+        map[0] = 0;
+        auto data = map.begin();
+        for (auto i = 1; i != 100; ++i)
+            map[i] = i;
+        REQUIRE(map.size() == 100u);
+        REQUIRE(map.begin() == data);
+    }
+}
+
+TEST_CASE("flat_hash_map")
+{
+    SUBCASE("basic")
+    {
+        test_allocator alloc;
+        {
+            flat_hash_map<int, std::string, test_allocator> map(alloc);
+            REQUIRE(map.empty());
+            REQUIRE(map.find(0) == map.end());
+            REQUIRE(map.begin() == map.end());
+            REQUIRE(map.erase(0) == 0u);
+
+            REQUIRE(map.insert({1, "a"}).second);
+            REQUIRE(map.try_emplace(3, 2u, 'c').second);
+            REQUIRE(!map.try_emplace(1, "x").second);
+            map[2] = "b";
+            REQUIRE(map.size() == 3u);
+            REQUIRE(map.capacity() == 8u);
+            REQUIRE(alloc.no_allocated() == 1u);
+
+            REQUIRE(map.find(1)->second == "a");
+            REQUIRE(map[3] == "cc");
+            REQUIRE(map.contains(2));
+            REQUIRE(map.count(4) == 0u);
+            REQUIRE(std::distance(map.begin(), map.end()) == 3);
+
+            map.erase(map.find(1));
+            REQUIRE(map.erase(3) == 1u);
+            REQUIRE(map.size() == 1u);
+            REQUIRE(map.begin()->first == 2);
+
+            map.clear();
+            REQUIRE(map.empty());
+            REQUIRE(map.capacity() == 8u);
+        }
+        REQUIRE(alloc.no_allocated() == 0u);
+        REQUIRE(alloc.last_deallocation_valid());
+    }
+    SUBCASE("reserve")
+    {
+        test_allocator alloc;
+        flat_hash_map<int, int, test_allocator> map(alloc);
+        map.reserve(100u);
+        REQUIRE(map.capacity() == 128u);
+
+        for (auto i = 0; i != 100; ++i)
+            map[i] = i;
+        REQUIRE(map.capacity() == 128u);
+        REQUIRE(alloc.no_allocated() == 1u);
+
+        map[100] = 100;
+        REQUIRE(map.capacity() == 128u);
+        for (auto i = 101; i != 120; ++i)
+            map[i] = i;
+        REQUIRE(map.capacity() == 256u);
+        for (auto i = 0; i != 120; ++i)
+            REQUIRE(map[i] == i);
+    }
+    SUBCASE("random")
+    {
+        test_allocator alloc;
+        {
+            // collide a lot to exercise the backward shift on erase
+            struct bad_hash
+            {
+                std::size_t operator()(int i) const noexcept
+                {
+                    return std::size_t(i % 7);
+                }
+            };
+            flat_hash_map<int, int, test_allocator, bad_hash> map(alloc);
+            std::map<int, int>                                 reference;
+
+            std::mt19937                       rng(42u);
+            std::uniform_int_distribution<int> dist(0, 200);
+            for (auto i = 0; i != 5000; ++i)
+            {
+                auto key = dist(rng);
+                if (i % 3 == 0)
+                    REQUIRE(map.erase(key) == reference.erase(key));
+                else
+                {
+                    map[key] = i;
+                    reference[key] = i;
+                }
+                REQUIRE(map.size() == reference.size());
+            }
+
+            for (auto& pair : reference)
+            {
+                auto iter = map.find(pair.first);
+                REQUIRE(iter != map.end());
+                REQUIRE(iter->second == pair.second);
+            }
+            REQUIRE(std::size_t(std::distance(map.begin(), map.end())) == reference.size());
+        }
+        REQUIRE(alloc.no_allocated() == 0u);
+        REQUIRE(alloc.last_deallocation_valid());
+    }
+}
@@ -0,0 +1,76 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "general_purpose_allocator.hpp"
+
+#include <doctest/doctest.h>
+#include <cstring>
+#include <vector>
+
+#include "container.hpp"
+#include "detail/align.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("general_purpose_allocator")
+{
+    using allocator = general_purpose_allocator<>;
+    using traits    = allocator_traits<allocator>;
+
+    allocator alloc;
+    SUBCASE("size classes")
+    {
+        auto small = traits::allocate_node(alloc, 24u, 8u);
+        REQUIRE(alloc.get_small_allocator().pool_capacity_left(24u) > 0u);
+
+        auto medium = traits::allocate_node(alloc, 1000u, 8u);
+        REQUIRE(alloc.get_medium_allocator().no_pools_created() == 1u);
+
+        auto large = traits::allocate_node(alloc, 100000u, 8u);
+        REQUIRE(detail::is_aligned(large, get_virtual_memory_page_size()));
+        std::memset(large, 0xAB, 100000u);
+
+        traits::deallocate_node(alloc, large, 100000u, 8u);
+        traits::deallocate_node(alloc, medium, 1000u, 8u);
+        traits::deallocate_node(alloc, small, 24u, 8u);
+    }
+    SUBCASE("alignment")
+    {
+        auto small = traits::allocate_node(alloc, 4u, 16u);
+        REQUIRE(detail::is_aligned(small, 16u));
+        traits::deallocate_node(alloc, small, 4u, 16u);
+
+        // the size is rounded up to a multiple of the alignment, so every node is aligned
+        void* nodes[4];
+        for (auto& node : nodes)
+        {
+            node = traits::allocate_node(alloc, 24u, 16u);
+            REQUIRE(detail::is_aligned(node, 16u));
+        }
+        for (auto node : nodes)
+            traits::deallocate_node(alloc, node, 24u, 16u);
+
+        auto page = traits::allocate_node(alloc, 64u, get_virtual_memory_page_size());
+        REQUIRE(detail::is_aligned(page, get_virtual_memory_page_size()));
+        traits::deallocate_node(alloc, page, 64u, get_virtual_memory_page_size());
+
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+        REQUIRE_THROWS_AS(traits::allocate_node(alloc, 64u, 2u * get_virtual_memory_page_size()),
+                          bad_alignment);
+#endif
+    }
+    SUBCASE("container")
+    {
+        // the buffer grows through all three allocators
+        vector<int, allocator> vec(alloc);
+        for (auto i = 0; i != 100000; ++i)
+            vec.push_back(i);
+        REQUIRE(vec[4242] == 4242);
+
+        std::vector<void*> nodes;
+        for (auto i = 1u; i != 512u; ++i)
+            nodes.push_back(traits::allocate_array(alloc, i, 64u, 8u));
+        for (auto i = 1u; i != 512u; ++i)
+            traits::deallocate_array(alloc, nodes[i - 1u], i, 64u, 8u);
+    }
+}
@@ -0,0 +1,93 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "io_buffer_pool.hpp"
+
+#include <doctest/doctest.h>
+
+#include <cstring>
+
+#include "detail/align.hpp"
+#include "allocator_traits.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("io_buffer_pool")
+{
+    SUBCASE("buffers")
+    {
+        io_buffer_pool pool(1000u, 8u, 512u);
+        REQUIRE(pool.buffer_size() == 1024u);
+        REQUIRE(pool.buffer_alignment() == 512u);
+        REQUIRE(pool.buffer_count() == 8u);
+        REQUIRE(pool.capacity_left() == 8u);
+        REQUIRE(pool.region().size == 8u * 1024u);
+        REQUIRE(detail::is_aligned(pool.region().memory, get_virtual_memory_page_size()));
+
+        void* buffers[8];
+        for (auto& buffer : buffers)
+        {
+            buffer = pool.allocate_buffer();
+            REQUIRE(pool.owns(buffer));
+            REQUIRE(detail::is_aligned(buffer, 512u));
+            REQUIRE(pool.buffer_at(pool.index_of(buffer)) == buffer);
+            std::memset(buffer, 'a', pool.buffer_size());
+        }
+        REQUIRE(pool.capacity_left() == 0u);
+        REQUIRE(!pool.try_allocate_buffer());
+
+        for (auto buffer : buffers)
+            pool.deallocate_buffer(buffer);
+        REQUIRE(pool.capacity_left() == 8u);
+    }
+    SUBCASE("adjacent buffers")
+    {
+        io_buffer_pool pool(4096u, 8u);
+        auto           a = pool.allocate_buffers(3u);
+        REQUIRE(pool.index_of(a) == 0u);
+        auto b = pool.allocate_buffer();
+        REQUIRE(pool.index_of(b) == 3u);
+        REQUIRE(pool.capacity_left() == 4u);
+        REQUIRE(!pool.try_allocate_buffers(5u));
+
+        pool.deallocate_buffers(a, 3u);
+        auto c = pool.try_allocate_buffers(4u);
+        REQUIRE(c);
+        REQUIRE(pool.index_of(c) == 4u);
+        pool.deallocate_buffers(c, 4u);
+        pool.deallocate_buffer(b);
+        REQUIRE(pool.capacity_left() == 8u);
+    }
+    SUBCASE("big alignment")
+    {
+        auto           alignment = 4u * get_virtual_memory_page_size();
+        io_buffer_pool pool(alignment, 2u, alignment);
+        REQUIRE(detail::is_aligned(pool.region().memory, alignment));
+        REQUIRE(detail::is_aligned(pool.buffer_at(1u), alignment));
+    }
+    SUBCASE("raw allocator")
+    {
+        io_buffer_pool pool(512u, 4u, 512u);
+        using traits = allocator_traits<io_buffer_pool>;
+        REQUIRE(traits::max_alignment(pool) == 512u);
+
+        auto node = traits::allocate_node(pool, 100u, 8u);
+        auto array = traits::allocate_array(pool, 3u, 200u, 8u);
+        REQUIRE(pool.index_of(array) == 1u);
+        REQUIRE(pool.capacity_left() == 1u);
+        traits::deallocate_array(pool, array, 3u, 200u, 8u);
+        traits::deallocate_node(pool, node, 100u, 8u);
+        REQUIRE(pool.capacity_left() == 4u);
+    }
+    SUBCASE("move")
+    {
+        io_buffer_pool pool(512u, 4u, 512u);
+        auto           region = pool.region();
+        auto           buffer = pool.allocate_buffer();
+
+        io_buffer_pool other(detail::move(pool));
+        REQUIRE(other.region().memory == region.memory);
+        REQUIRE(other.capacity_left() == 3u);
+        other.deallocate_buffer(buffer);
+    }
+}
@@ -4,6 +4,10 @@
 #include "iteration_allocator.hpp"
 
 #include <doctest/doctest.h>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
 
 #include "allocator_storage.hpp"
 #include "test_allocator.hpp"
@@ -55,3 +59,90 @@ TEST_CASE("iteration_allocator")
         REQUIRE(detail::is_aligned(mem, align));
     }
 }
+
+TEST_CASE("concurrent_iteration_allocator")
+{
+    test_allocator alloc;
+    concurrent_iteration_allocator<2, allocator_reference<test_allocator>> iter_alloc(4096u, 256u,
+                                                                                      alloc);
+    REQUIRE(alloc.no_allocated() == 1u);
+    REQUIRE(iter_alloc.cur_iteration() == 0u);
+    REQUIRE(iter_alloc.capacity_left() == 2048u);
+
+    SUBCASE("slices")
+    {
+        decltype(iter_alloc)::local_allocator a(iter_alloc), b(iter_alloc);
+        auto                                  mem_a = a.allocate_node(16u, 1u);
+        REQUIRE(iter_alloc.capacity_left() == 2048u - 256u);
+        a.allocate_node(16u, 1u);
+        REQUIRE(iter_alloc.capacity_left() == 2048u - 256u);
+
+        auto mem_b = b.allocate_node(16u, 1u);
+        REQUIRE(iter_alloc.capacity_left() == 2048u - 2 * 256u);
+        REQUIRE(static_cast<char*>(mem_b) - static_cast<char*>(mem_a) >= 256);
+
+        // bigger than a slice
+        REQUIRE(b.allocate_node(512u, 1u));
+        REQUIRE(iter_alloc.capacity_left() < 2048u - 2 * 256u - 512u);
+
+        iter_alloc.next_iteration();
+        REQUIRE(iter_alloc.cur_iteration() == 1u);
+        REQUIRE(iter_alloc.capacity_left() == 2048u);
+        auto mem_next = a.allocate_node(16u, 1u);
+        REQUIRE(iter_alloc.capacity_left() == 2048u - 256u);
+        REQUIRE(static_cast<char*>(mem_next) >= static_cast<char*>(mem_a) + 2048);
+
+        iter_alloc.next_iteration();
+        REQUIRE(iter_alloc.cur_iteration() == 0u);
+        REQUIRE(a.allocate_node(16u, 1u) == mem_a);
+    }
+    SUBCASE("exhausted")
+    {
+        decltype(iter_alloc)::local_allocator a(iter_alloc);
+        REQUIRE(!a.try_allocate_node(4096u, 1u));
+        REQUIRE(a.try_allocate_node(1024u, 1u));
+        REQUIRE(a.try_allocate_node(512u, 1u));
+        REQUIRE(!a.try_allocate_node(1024u, 1u));
+    }
+    SUBCASE("threads")
+    {
+        std::vector<std::thread> threads;
+        std::atomic<bool>        ok(true);
+        for (auto i = 0u; i != 4u; ++i)
+            threads.emplace_back(
+                [&, i]
+                {
+                    decltype(iter_alloc)::local_allocator local(iter_alloc);
+                    for (auto j = 0u; j != 16u; ++j)
+                    {
+                        auto mem = static_cast<char*>(local.try_allocate_node(16u, 1u));
+                        if (!mem)
+                            ok = false;
+                        else
+                            std::memset(mem, int(i), 16u);
+                    }
+                });
+        for (auto& thread : threads)
+            thread.join();
+        REQUIRE(ok);
+        REQUIRE(iter_alloc.capacity_left() <= 2048u - 4 * 256u);
+    }
+}
+
+TEST_CASE("iteration_allocator stats")
+{
+    iteration_allocator<2> iter_alloc(100u);
+
+    auto stats = iter_alloc.stats();
+    REQUIRE(stats.blocks == 1u);
+    REQUIRE(stats.committed_bytes == 100u);
+    REQUIRE(stats.unused_bytes == 100u);
+
+    iter_alloc.allocate(10u, 1u);
+    iter_alloc.next_iteration();
+    iter_alloc.allocate(20u, 1u);
+    stats = iter_alloc.stats();
+    REQUIRE(stats.used_bytes >= 30u);
+    REQUIRE(stats.committed_bytes == stats.used_bytes + stats.unused_bytes + stats.wasted_bytes);
+    REQUIRE(stats.unused_bytes == iter_alloc.capacity_left(0u) + iter_alloc.capacity_left(1u));
+}
@@ -275,3 +275,82 @@ TEST_CASE("joint_array")
         REQUIRE(arr2[2] == 3);
     }
 }
+
+TEST_CASE("joint_vector")
+{
+    struct joint_test : joint_type<joint_test>
+    {
+        int value;
+
+        joint_test(joint tag, int v) : joint_type(tag), value(v) {}
+    };
+
+    test_allocator alloc;
+    auto           ptr = allocate_joint<joint_test>(alloc, joint_size(8 * sizeof(int)), 5);
+    verify(ptr, alloc, 5);
+
+    SUBCASE("in place growth")
+    {
+        joint_vector<int, test_allocator> vec(*ptr, alloc);
+        REQUIRE(vec.empty());
+        REQUIRE(vec.capacity() == 0u);
+        REQUIRE(vec.is_joint());
+
+        for (auto i = 0; i != 8; ++i)
+            vec.push_back(i);
+        REQUIRE(vec.size() == 8u);
+        REQUIRE(vec.capacity() == 8u);
+        REQUIRE(vec.is_joint());
+        REQUIRE(vec.data() == vec.begin());
+        REQUIRE(static_cast<void*>(vec.data()) == static_cast<void*>(&*ptr + 1));
+        for (auto i = 0; i != 8; ++i)
+            REQUIRE(vec[std::size_t(i)] == i);
+        REQUIRE(alloc.no_allocated() == 1u);
+
+        vec.pop_back();
+        REQUIRE(vec.back() == 6);
+        vec.emplace_back(7);
+        REQUIRE(vec.back() == 7);
+        REQUIRE(alloc.no_allocated() == 1u);
+    }
+    SUBCASE("spill to external storage")
+    {
+        joint_vector<int, test_allocator> vec(*ptr, alloc);
+        for (auto i = 0; i != 8; ++i)
+            vec.push_back(i);
+
+        vec.push_back(vec.front());
+        REQUIRE(!vec.is_joint());
+        REQUIRE(vec.size() == 9u);
+        REQUIRE(vec.capacity() == 16u);
+        REQUIRE(vec.back() == 0);
+        for (auto i = 0; i != 8; ++i)
+            REQUIRE(vec[std::size_t(i)] == i);
+        REQUIRE(alloc.no_allocated() == 2u);
+        REQUIRE(alloc.last_allocated().size == 16u * sizeof(int));
+    }
+    SUBCASE("reserve")
+    {
+        joint_vector<int, test_allocator> vec(*ptr, alloc);
+        vec.reserve(4u);
+        REQUIRE(vec.capacity() == 4u);
+        REQUIRE(vec.is_joint());
+
+        vec.reserve(16u);
+        REQUIRE(vec.capacity() == 16u);
+        REQUIRE(!vec.is_joint());
+        REQUIRE(alloc.no_allocated() == 2u);
+    }
+    SUBCASE("joint memory released")
+    {
+        {
+            joint_vector<int, test_allocator> vec(*ptr, alloc);
+            vec.push_back(1);
+        }
+        joint_array<int> arr(8u, *ptr);
+        REQUIRE(arr.size() == 8u);
+    }
+
+    ptr.reset();
+    REQUIRE(alloc.no_allocated() == 0u);
+}
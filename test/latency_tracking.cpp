@@ -0,0 +1,129 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "latency_tracking.hpp"
+
+#include <doctest/doctest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "memory_pool.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("latency_histogram_snapshot")
+{
+    using snapshot = latency_histogram_snapshot;
+
+    for (std::uint64_t ticks = 0u; ticks != 16u; ++ticks)
+    {
+        REQUIRE(snapshot::bucket_of(ticks) == ticks);
+        REQUIRE(snapshot::upper_bound(ticks) == ticks);
+    }
+    for (std::size_t bucket = 0u; bucket + 1u != latency_histogram_size; ++bucket)
+    {
+        auto bound = snapshot::upper_bound(bucket);
+        REQUIRE(snapshot::bucket_of(bound) == bucket);
+        REQUIRE(snapshot::bucket_of(bound + 1u) == bucket + 1u);
+    }
+    REQUIRE(snapshot::bucket_of(std::uint64_t(-1)) == latency_histogram_size - 1u);
+    REQUIRE(snapshot::upper_bound(latency_histogram_size - 1u) == std::uint64_t(-1));
+
+    // the relative error is at most an eighth of the value
+    for (std::uint64_t ticks = 16u; ticks < (std::uint64_t(1) << 40); ticks = ticks * 3u + 1u)
+        REQUIRE(snapshot::upper_bound(snapshot::bucket_of(ticks)) - ticks <= ticks / 8u);
+}
+
+TEST_CASE("allocation_latency")
+{
+    std::unique_ptr<allocation_latency> latency(new allocation_latency);
+
+    auto empty = latency->snapshot(latency_operation::allocation);
+    REQUIRE(empty.count == 0u);
+    REQUIRE(empty.percentile(99.0) == 0u);
+
+    for (std::uint64_t i = 1u; i <= 1000u; ++i)
+        latency->record(latency_operation::allocation, 10u);
+    latency->record(latency_operation::allocation, 100000u);
+    latency->record(latency_operation::deallocation, 5u);
+
+    auto allocation = latency->snapshot(latency_operation::allocation);
+    REQUIRE(allocation.count == 1001u);
+    REQUIRE(allocation.max == 100000u);
+    REQUIRE(allocation.buckets[10] == 1000u);
+    REQUIRE(allocation.percentile(0.0) == 10u);
+    REQUIRE(allocation.percentile(50.0) == 10u);
+    REQUIRE(allocation.percentile(99.9) == 10u);
+    REQUIRE(allocation.percentile(100.0) == 100000u);
+
+    auto deallocation = latency->snapshot(latency_operation::deallocation);
+    REQUIRE(deallocation.count == 1u);
+    REQUIRE(deallocation.max == 5u);
+    REQUIRE(deallocation.percentile(50.0) == 5u);
+
+    SUBCASE("multiple threads")
+    {
+        std::vector<std::thread> threads;
+        for (auto i = 0; i != 4; ++i)
+            threads.emplace_back([&] {
+                for (auto j = 0; j != 1000; ++j)
+                    latency->record(latency_operation::deallocation, 20u);
+            });
+        for (auto& thread : threads)
+            thread.join();
+
+        deallocation = latency->snapshot(latency_operation::deallocation);
+        REQUIRE(deallocation.count == 4001u);
+        REQUIRE(deallocation.max == 20u);
+    }
+}
+
+TEST_CASE("latency_tracked_allocator")
+{
+    std::unique_ptr<allocation_latency> latency(new allocation_latency);
+    test_allocator                      alloc;
+
+    auto tracked =
+        make_latency_tracked_allocator(*latency, 1u, allocator_reference<test_allocator>(alloc));
+    REQUIRE(&tracked.get_latency() == latency.get());
+    REQUIRE(tracked.sample_period() == 1u);
+
+    void* nodes[10];
+    for (auto& node : nodes)
+        node = tracked.allocate_node(16u, 8u);
+    auto array = tracked.allocate_array(4u, 16u, 8u);
+    REQUIRE(alloc.no_allocated() == 11u);
+    REQUIRE(latency->snapshot(latency_operation::allocation).count == 11u);
+
+    tracked.set_sample_period(2u);
+    tracked.deallocate_array(array, 4u, 16u, 8u);
+    for (auto node : nodes)
+        tracked.deallocate_node(node, 16u, 8u);
+    REQUIRE(alloc.no_allocated() == 0u);
+    REQUIRE(latency->snapshot(latency_operation::deallocation).count == 5u);
+
+    tracked.set_sample_period(0u);
+    tracked.deallocate_node(tracked.allocate_node(16u, 8u), 16u, 8u);
+    REQUIRE(latency->snapshot(latency_operation::allocation).count == 11u);
+    REQUIRE(latency->snapshot(latency_operation::deallocation).count == 5u);
+
+    SUBCASE("memory_pool")
+    {
+        using pool = memory_pool<node_pool>;
+        latency_tracked_allocator<pool> tracked_pool(*latency, 1u,
+                                                     pool(16u, pool::min_block_size(16u, 4u)));
+        void* pool_nodes[16];
+        for (auto& node : pool_nodes)
+            node = tracked_pool.allocate_node(16u, 1u);
+        // the growths are recorded as well
+        auto snapshot = latency->snapshot(latency_operation::allocation);
+        REQUIRE(snapshot.count == 27u);
+        REQUIRE(snapshot.max >= snapshot.percentile(50.0));
+
+        for (auto node : pool_nodes)
+            tracked_pool.deallocate_node(node, 16u, 1u);
+    }
+}
@@ -0,0 +1,83 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "lifetime_router.hpp"
+
+#include <doctest/doctest.h>
+
+#include "allocator_storage.hpp"
+#include "heap_allocator.hpp"
+#include "memory_pool.hpp"
+#include "memory_stack.hpp"
+#include "tlsf_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("lifetime_router")
+{
+    using router_t = lifetime_router<memory_pool<>, tlsf_allocator<>, memory_stack<>>;
+    using traits   = allocator_traits<router_t>;
+
+    router_t router(memory_pool<>(16u, 4096u), tlsf_allocator<>(4096u), memory_stack<>(4096u));
+    auto&    pool  = router.get_short_lived_allocator();
+    auto&    tlsf  = router.get_long_lived_allocator();
+    auto&    stack = router.get_permanent_allocator();
+
+    SUBCASE("routing")
+    {
+        auto a = traits::allocate_node(router, 16u, 1u, lifetime_hint::short_lived);
+        auto b = traits::allocate_node(router, 16u, 1u, lifetime_hint::long_lived);
+        auto c = traits::allocate_node(router, 16u, 1u, lifetime_hint::permanent);
+        auto d = traits::allocate_node(router, 16u, 1u);
+        REQUIRE(pool.owns(a));
+        REQUIRE(tlsf.owns(b));
+        REQUIRE(!pool.owns(c));
+        REQUIRE(!tlsf.owns(c));
+        REQUIRE(pool.owns(d));
+
+        auto capacity = pool.capacity_left();
+        traits::deallocate_node(router, a, 16u, 1u);
+        traits::deallocate_node(router, d, 16u, 1u);
+        REQUIRE(pool.capacity_left() == capacity + 32u);
+
+        capacity = tlsf.capacity_left();
+        traits::deallocate_node(router, b, 16u, 1u);
+        REQUIRE(tlsf.capacity_left() > capacity);
+        traits::deallocate_node(router, c, 16u, 1u);
+    }
+    SUBCASE("hinted deallocation")
+    {
+        auto capacity = tlsf.capacity_left();
+        auto array    = router.allocate_array(10u, 8u, 8u, lifetime_hint::long_lived);
+        REQUIRE(tlsf.owns(array));
+        router.deallocate_array(array, 10u, 8u, 8u, lifetime_hint::long_lived);
+        REQUIRE(tlsf.capacity_left() == capacity);
+
+        auto marker = stack.top();
+        auto node   = router.allocate_node(100u, 8u, lifetime_hint::permanent);
+        REQUIRE(!tlsf.owns(node));
+        router.deallocate_node(node, 100u, 8u, lifetime_hint::permanent);
+        stack.unwind(marker);
+    }
+    SUBCASE("storage")
+    {
+        allocator_reference<router_t> ref(router);
+        auto                          node = ref.allocate_node(16u, 8u, lifetime_hint::short_lived);
+        REQUIRE(pool.owns(node));
+        ref.deallocate_node(node, 16u, 8u);
+    }
+
+    REQUIRE(router.max_alignment() >= tlsf.max_alignment());
+}
+
+TEST_CASE("lifetime_hint ignored")
+{
+    heap_allocator alloc;
+    auto node = allocator_traits<heap_allocator>::allocate_node(alloc, 16u, 8u,
+                                                                lifetime_hint::permanent);
+    allocator_traits<heap_allocator>::deallocate_node(alloc, node, 16u, 8u);
+
+    allocator_reference<heap_allocator> ref(alloc);
+    node = ref.allocate_node(16u, 8u, lifetime_hint::short_lived);
+    ref.deallocate_node(node, 16u, 8u);
+}
@@ -4,8 +4,12 @@
 #include "memory_arena.hpp"
 
 #include <doctest/doctest.h>
+#include <vector>
 
+#include "allocator_storage.hpp"
 #include "static_allocator.hpp"
+#include "test_allocator.hpp"
+#include "virtual_memory.hpp"
 
 using namespace foonathan::memory;
 using namespace detail;
@@ -98,6 +102,26 @@ TEST_CASE("detail::memory_block_stack")
         block = other.pop();
         REQUIRE(block.memory == static_cast<void*>(&c));
     }
+    SUBCASE("move_to_top")
+    {
+        auto b_memory = reinterpret_cast<char*>(&b) + memory_block_stack::implementation_offset();
+        stack.move_to_top(b_memory);
+        stack.move_to_top(b_memory);
+
+        std::vector<void*> blocks;
+        stack.for_each([&](const memory_block& block) { blocks.push_back(block.memory); });
+        REQUIRE(blocks.size() == 4u);
+        REQUIRE(blocks[0] == stack.top().memory);
+
+        auto block = stack.pop();
+        REQUIRE(block.memory == static_cast<void*>(&b));
+        block = stack.pop();
+        REQUIRE(block.memory == static_cast<void*>(&c));
+        block = stack.pop();
+        REQUIRE(block.memory == static_cast<void*>(&a));
+        block = stack.pop();
+        REQUIRE(block.memory == static_cast<void*>(&memory));
+    }
     SUBCASE("move")
     {
         memory_block_stack other = detail::move(stack);
@@ -205,6 +229,61 @@ TEST_CASE("memory_arena w/ caching")
         REQUIRE(small_arena.size() == 1u);
         REQUIRE(small_arena.capacity() == 1u);
     }
+    SUBCASE("cache limits")
+    {
+        arena_type arena(1024);
+        arena.set_cache_limits({2u});
+        REQUIRE(arena.cache_limits().max_blocks == 2u);
+
+        for (auto i = 0; i != 4; ++i)
+            arena.allocate_block();
+        REQUIRE(arena.get_allocator().i == 4u);
+
+        arena.deallocate_block();
+        arena.deallocate_block();
+        REQUIRE(arena.get_allocator().i == 4u);
+        REQUIRE(arena.cache_size() == 2u);
+
+        // the most recently allocated block is returned first
+        arena.deallocate_block();
+        REQUIRE(arena.get_allocator().i == 3u);
+        REQUIRE(arena.cache_size() == 2u);
+
+        arena.set_cache_limits({1u, 2u * 1024u});
+        REQUIRE(arena.get_allocator().i == 2u);
+        REQUIRE(arena.cache_size() == 1u);
+
+        arena.set_cache_limits({10u, 1024u});
+        REQUIRE(arena.cache_size() == 1u);
+        arena.deallocate_block();
+        REQUIRE(arena.get_allocator().i == 1u);
+        REQUIRE(arena.cache_size() == 1u);
+
+        arena.allocate_block();
+        REQUIRE(arena.get_allocator().i == 1u);
+        REQUIRE(arena.cache_size() == 0u);
+    }
+    SUBCASE("trim_arena_caches")
+    {
+        arena_type arena(1024);
+        arena.allocate_block();
+        arena.allocate_block();
+        arena.deallocate_block();
+        REQUIRE(arena.cache_size() == 1u);
+
+        // takes effect on the next block operation
+        trim_arena_caches();
+        REQUIRE(arena.cache_size() == 1u);
+        arena.deallocate_block();
+        REQUIRE(arena.get_allocator().i == 1u);
+        REQUIRE(arena.cache_size() == 1u);
+
+        trim_arena_caches();
+        arena.allocate_block();
+        REQUIRE(arena.get_allocator().i == 1u);
+        REQUIRE(arena.cache_size() == 0u);
+        arena.deallocate_block();
+    }
 }
 
 TEST_CASE("memory_arena w/o caching")
@@ -260,6 +339,26 @@ TEST_CASE("memory_arena w/o caching")
         REQUIRE(small_arena.size() == 1u);
         REQUIRE(small_arena.capacity() == 1u);
     }
+    SUBCASE("deallocate any block")
+    {
+        memory_arena<growing_block_allocator<>, false> arena(1024);
+        auto                                           a = arena.allocate_block();
+        auto                                           b = arena.allocate_block();
+        auto                                           c = arena.allocate_block();
+
+        arena.deallocate_block(b);
+        REQUIRE(arena.size() == 2u);
+        REQUIRE(arena.current_block().memory == c.memory);
+        REQUIRE(!arena.owns(b.memory));
+
+        std::vector<void*> blocks;
+        arena.for_each_block([&](const memory_block& block) { blocks.push_back(block.memory); });
+        REQUIRE(blocks == (std::vector<void*>{c.memory, a.memory}));
+
+        arena.deallocate_block(a);
+        REQUIRE(arena.size() == 1u);
+        REQUIRE(arena.current_block().memory == c.memory);
+    }
 }
 
 static_assert(
@@ -273,6 +372,70 @@ static_assert(std::is_same<growing_block_allocator<>,
 template <class RawAlloc>
 using block_wrapper = growing_block_allocator<RawAlloc>;
 
+TEST_CASE("memory_arena::last_block_zeroed")
+{
+    memory_arena<virtual_block_allocator> arena(virtual_memory_page_size, 4u);
+    arena.allocate_block();
+    REQUIRE(arena.last_block_zeroed() == !FOONATHAN_MEMORY_DEBUG_FILL);
+
+    // a cached block was used before
+    arena.deallocate_block();
+    arena.allocate_block();
+    REQUIRE(!arena.last_block_zeroed());
+
+    // the blocks of other allocators are not known to be zeroed
+    memory_arena<test_block_allocator<10>> other(1024);
+    other.allocate_block();
+    REQUIRE(!other.last_block_zeroed());
+}
+
+TEST_CASE("memory_arena::allocate_blocks")
+{
+    auto offset = memory_block_stack::implementation_offset();
+    SUBCASE("growing_block_allocator")
+    {
+        test_allocator alloc;
+        memory_arena<growing_block_allocator<allocator_reference<test_allocator>>, false> arena(
+            1024, alloc);
+
+        // one allocation for all blocks, the block size grows once
+        auto block = arena.allocate_blocks(4u);
+        REQUIRE(alloc.no_allocated() == 1u);
+        REQUIRE(block.size == 4u * 1024u - offset);
+        REQUIRE(arena.size() == 1u);
+        REQUIRE(arena.next_block_size() == 2048u - offset);
+
+        arena.deallocate_block();
+        REQUIRE(alloc.no_allocated() == 0u);
+    }
+    SUBCASE("virtual_block_allocator")
+    {
+        memory_arena<virtual_block_allocator> arena(virtual_memory_page_size, 8u);
+        arena.allocate_block();
+
+        auto block = arena.allocate_blocks(3u);
+        REQUIRE(block.size == 3u * virtual_memory_page_size - offset);
+        REQUIRE(arena.get_allocator().capacity_left() == 4u);
+        REQUIRE(arena.last_block_zeroed() == !FOONATHAN_MEMORY_DEBUG_FILL);
+
+        // the cache is skipped for multiple blocks
+        arena.deallocate_block();
+        REQUIRE(arena.cache_size() == 1u);
+        arena.shrink_to_fit();
+        REQUIRE(arena.get_allocator().capacity_left() == 7u);
+        arena.allocate_blocks(7u);
+        REQUIRE(arena.get_allocator().capacity_left() == 0u);
+    }
+    SUBCASE("fallback")
+    {
+        // without an allocate_blocks() function, a single block is allocated
+        memory_arena<test_block_allocator<10>> arena(1024);
+        auto                                   block = arena.allocate_blocks(4u);
+        REQUIRE(block.size == 1024u - offset);
+        REQUIRE(arena.size() == 1u);
+    }
+}
+
 TEST_CASE("make_block_allocator")
 {
     growing_block_allocator<heap_allocator> a1 = make_block_allocator<heap_allocator>(1024);
@@ -283,3 +446,82 @@ TEST_CASE("make_block_allocator")
     REQUIRE(a2.next_block_size() == 1024);
 }
 
+TEST_CASE("adaptive_block_allocator")
+{
+    adaptive_block_allocator<heap_allocator> alloc(1024, {4096});
+    REQUIRE(alloc.next_block_size() == 1024);
+    REQUIRE(alloc.used_size() == 0u);
+
+    // the next block is never bigger than the blocks in use
+    auto a = alloc.allocate_block();
+    REQUIRE(a.size == 1024);
+    REQUIRE(alloc.next_block_size() == 1024);
+
+    auto b = alloc.allocate_block();
+    REQUIRE(b.size == 1024);
+    REQUIRE(alloc.next_block_size() == 2048);
+
+    auto c = alloc.allocate_block();
+    REQUIRE(c.size == 2048);
+    REQUIRE(alloc.next_block_size() == 4096);
+
+    // limited by the maximal block size
+    auto d = alloc.allocate_block();
+    REQUIRE(d.size == 4096);
+    REQUIRE(alloc.next_block_size() == 4096);
+    REQUIRE(alloc.used_size() == 8192u);
+
+    // shrinks back to the blocks in use
+    alloc.deallocate_block(d);
+    REQUIRE(alloc.next_block_size() == 4096);
+    alloc.deallocate_block(c);
+    REQUIRE(alloc.next_block_size() == 2048);
+    alloc.deallocate_block(b);
+    REQUIRE(alloc.next_block_size() == 1024);
+    alloc.deallocate_block(a);
+    REQUIRE(alloc.next_block_size() == 1024);
+    REQUIRE(alloc.used_size() == 0u);
+
+    SUBCASE("memory_arena")
+    {
+        using arena_type = memory_arena<adaptive_block_allocator<heap_allocator>, false>;
+        arena_type arena(1024, block_growth_policy(4096));
+        arena.allocate_block();
+        arena.allocate_block();
+        arena.allocate_block();
+        REQUIRE(arena.get_allocator().next_block_size() == 4096);
+
+        arena.deallocate_block();
+        arena.deallocate_block();
+        REQUIRE(arena.get_allocator().next_block_size() == 1024);
+    }
+}
+
+TEST_CASE("aligned_block_allocator")
+{
+    aligned_block_allocator<heap_allocator> alloc(1000, 64u);
+    REQUIRE(alloc.next_block_size() == 1000);
+    REQUIRE(alloc.block_alignment() == 64u);
+    // the blocks of the underlying allocator are bigger
+    auto overhead = alloc.get_allocator().next_block_size() - 1000u;
+    REQUIRE(overhead >= 64u - max_alignment);
+
+    auto a = alloc.allocate_block();
+    REQUIRE(a.size == 1000);
+    REQUIRE(is_aligned(a.memory, 64u));
+    // the underlying growing_block_allocator doubles the block size including the overhead
+    REQUIRE(alloc.next_block_size() == 2000u + overhead);
+
+    auto b = alloc.allocate_block();
+    REQUIRE(is_aligned(b.memory, 64u));
+
+    alloc.deallocate_block(b);
+    alloc.deallocate_block(a);
+
+    SUBCASE("small alignment")
+    {
+        aligned_block_allocator<heap_allocator> small(1024, 1u);
+        REQUIRE(small.block_alignment() == max_alignment);
+        REQUIRE(small.next_block_size() == 1024);
+    }
+}
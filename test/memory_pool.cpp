@@ -4,12 +4,16 @@
 #include "memory_pool.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <doctest/doctest.h>
 #include <random>
+#include <thread>
 #include <vector>
 
 #include "allocator_storage.hpp"
 #include "test_allocator.hpp"
+#include "virtual_memory.hpp"
 
 using namespace foonathan::memory;
 
@@ -61,6 +65,139 @@ TEST_CASE("memory_pool")
             REQUIRE(pool.capacity_left() >= capacity);
             REQUIRE(alloc.no_allocated() == 2u);
         }
+        SUBCASE("shrink_to_fit")
+        {
+            std::vector<void*> ptrs;
+            auto               second_block = std::size_t(-1);
+            while (alloc.no_allocated() != 3u)
+            {
+                ptrs.push_back(pool.allocate_node());
+                if (alloc.no_allocated() == 2u && second_block == std::size_t(-1))
+                    second_block = ptrs.size() - 1u;
+            }
+
+            // the first node of the second block keeps it alive
+            auto in_use = ptrs[second_block];
+            ptrs.erase(ptrs.begin() + std::ptrdiff_t(second_block));
+            std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{});
+            for (auto ptr : ptrs)
+                pool.deallocate_node(ptr);
+
+            auto capacity = pool.capacity_left();
+            pool.shrink_to_fit();
+            REQUIRE(alloc.no_allocated() == 2u);
+            REQUIRE(pool.capacity_left() < capacity);
+            REQUIRE(pool.owns(in_use));
+
+            pool.deallocate_node(in_use);
+            pool.shrink_to_fit();
+            REQUIRE(alloc.no_allocated() == 0u);
+            REQUIRE(pool.capacity_left() == 0u);
+        }
+        SUBCASE("release_empty_blocks")
+        {
+            std::vector<void*> ptrs;
+            auto               second_block = std::size_t(-1);
+            while (alloc.no_allocated() != 4u)
+            {
+                ptrs.push_back(pool.allocate_node());
+                if (alloc.no_allocated() == 2u && second_block == std::size_t(-1))
+                    second_block = ptrs.size() - 1u;
+            }
+
+            // the first node of the second block and the last node keep their blocks alive
+            auto in_use = ptrs[second_block], last = ptrs.back();
+            ptrs.pop_back();
+            ptrs.erase(ptrs.begin() + std::ptrdiff_t(second_block));
+            std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{});
+            for (auto ptr : ptrs)
+                pool.deallocate_node(ptr);
+
+            // shrink_to_fit() stops at the current block
+            pool.shrink_to_fit();
+            REQUIRE(alloc.no_allocated() == 4u);
+
+            auto capacity = pool.capacity_left();
+            pool.release_empty_blocks();
+            REQUIRE(alloc.no_allocated() == 2u);
+            REQUIRE(pool.capacity_left() < capacity);
+            REQUIRE(pool.owns(in_use));
+            REQUIRE(pool.owns(last));
+
+            // the pool still works
+            auto node = pool.allocate_node();
+            REQUIRE(pool.owns(node));
+            pool.deallocate_node(node);
+
+            pool.deallocate_node(in_use);
+            pool.deallocate_node(last);
+            pool.release_empty_blocks();
+            REQUIRE(alloc.no_allocated() == 0u);
+            REQUIRE(pool.capacity_left() == 0u);
+        }
+        SUBCASE("untouched nodes")
+        {
+            // the nodes a new block has never handed out are counted without carving them,
+            // unless the pool uses an ordered free list to check for double deallocations
+            auto node   = pool.allocate_node();
+            auto unused = pool.stats().unused_bytes;
+            pool.release_empty_blocks();
+            pool.shrink_to_fit();
+            REQUIRE(alloc.no_allocated() == 1u);
+            REQUIRE(pool.stats().unused_bytes == unused);
+
+            pool.deallocate_node(node);
+            pool.shrink_to_fit();
+            REQUIRE(alloc.no_allocated() == 0u);
+            REQUIRE(pool.capacity_left() == 0u);
+        }
+        SUBCASE("at least")
+        {
+            using traits = allocator_traits<pool_type>;
+
+            auto node = traits::allocate_node_at_least(pool, 1u, 1u);
+            REQUIRE(node.size == pool.node_size());
+
+            auto array    = traits::allocate_array_at_least(pool, 3u, 3u, 1u);
+            auto no_nodes = (9u + pool.node_size() - 1u) / pool.node_size();
+            REQUIRE(array.size == no_nodes * pool.node_size() / 3u);
+
+            traits::deallocate_array(pool, array.memory, array.size, 3u, 1u);
+            traits::deallocate_node(pool, node.memory, node.size, 1u);
+        }
+        SUBCASE("batch alloc/dealloc")
+        {
+            using traits  = allocator_traits<pool_type>;
+            auto capacity = pool.capacity_left();
+
+            void* nodes[40];
+            traits::allocate_node_batch(pool, nodes, 40u, 4u, 1u);
+            REQUIRE(alloc.no_allocated() == 2u);
+            for (auto node : nodes)
+                REQUIRE(pool.owns(node));
+            REQUIRE(std::unique(nodes, nodes + 40) == nodes + 40);
+
+            traits::deallocate_node_batch(pool, nodes, 40u, 4u, 1u);
+            REQUIRE(pool.capacity_left() > capacity);
+
+            using composable = composable_allocator_traits<pool_type>;
+            auto left        = pool.capacity_left() / pool.node_size();
+            REQUIRE(!composable::try_allocate_node_batch(pool, nodes, left + 1u, 4u, 1u));
+            REQUIRE(pool.capacity_left() / pool.node_size() == left);
+            REQUIRE(composable::try_allocate_node_batch(pool, nodes, 10u, 4u, 1u));
+            REQUIRE(composable::try_deallocate_node_batch(pool, nodes, 10u, 4u, 1u));
+
+            int not_owned;
+            nodes[0] = &not_owned;
+            REQUIRE(!composable::try_deallocate_node_batch(pool, nodes, 1u, 4u, 1u));
+
+            // locks only once and forwards to the pool
+            allocator_storage<reference_storage<pool_type>, std::mutex> locked(pool);
+            locked.allocate_node_batch(nodes, 20u, 4u, 1u);
+            REQUIRE(pool.capacity_left() / pool.node_size() == left - 20u);
+            locked.deallocate_node_batch(nodes, 20u, 4u, 1u);
+            REQUIRE(pool.capacity_left() / pool.node_size() == left);
+        }
     }
     {
         pool_type pool(16, pool_type::min_block_size(16, 1), alloc);
@@ -99,6 +236,144 @@ namespace
     }
 } // namespace
 
+TEST_CASE("memory_pool<array_pool>::release_empty_blocks()")
+{
+    using block_allocator = growing_block_allocator<allocator_reference<test_allocator>, 1u, 1u>;
+    using pool_type       = memory_pool<array_pool, block_allocator>;
+    test_allocator alloc;
+    {
+        // more blocks than fit on the stack of release_empty_blocks()
+        pool_type          pool(8, pool_type::min_block_size(8, 4), alloc);
+        std::vector<void*> ptrs, kept;
+        while (alloc.no_allocated() != 40u)
+        {
+            auto blocks = alloc.no_allocated();
+            auto ptr    = pool.allocate_node();
+            // the first node of every other block keeps it alive
+            if (alloc.no_allocated() != blocks && blocks % 2u == 1u)
+                kept.push_back(ptr);
+            else
+                ptrs.push_back(ptr);
+        }
+        std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{});
+        for (auto ptr : ptrs)
+            pool.deallocate_node(ptr);
+        REQUIRE(kept.size() == 20u);
+
+        pool.release_empty_blocks();
+        REQUIRE(alloc.no_allocated() == 20u);
+        for (auto ptr : kept)
+            REQUIRE(pool.owns(ptr));
+
+        // the array allocation needs the ordered list
+        auto array = pool.allocate_array(2u);
+        pool.deallocate_array(array, 2u);
+
+        for (auto ptr : kept)
+            pool.deallocate_node(ptr);
+        pool.release_empty_blocks();
+        REQUIRE(alloc.no_allocated() == 0u);
+    }
+}
+
+TEST_CASE("memory_pool::reserve()")
+{
+    using pool_type = memory_pool<node_pool, allocator_reference<test_allocator>>;
+    test_allocator alloc;
+    {
+        pool_type pool(16u, pool_type::min_block_size(16u, 10u), alloc);
+        REQUIRE(alloc.no_allocated() == 1u);
+
+        // the missing nodes are allocated at once
+        pool.reserve(1000u);
+        REQUIRE(alloc.no_allocated() == 2u);
+        REQUIRE(pool.capacity_left() >= 1000u * pool.node_size());
+
+        // nothing to do if there are enough
+        pool.reserve(500u);
+        REQUIRE(alloc.no_allocated() == 2u);
+
+        std::vector<void*> nodes;
+        for (auto i = 0u; i != 1000u; ++i)
+            nodes.push_back(pool.allocate_node());
+        REQUIRE(alloc.no_allocated() == 2u);
+        for (auto node : nodes)
+            pool.deallocate_node(node);
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+}
+
+TEST_CASE("memory_pool<node_pool, virtual_block_allocator>")
+{
+    using pool_type = memory_pool<node_pool, virtual_block_allocator>;
+    pool_type pool(16u, virtual_memory_page_size, 4u);
+    REQUIRE(pool.get_allocator().capacity_left() == 3u);
+
+    std::vector<void*> ptrs;
+    while (pool.get_allocator().capacity_left() != 1u)
+        ptrs.push_back(pool.allocate_node());
+    auto first = ptrs.front();
+
+    for (auto ptr : ptrs)
+        pool.deallocate_node(ptr);
+    pool.shrink_to_fit();
+    REQUIRE(pool.get_allocator().capacity_left() == 4u);
+    REQUIRE(pool.capacity_left() == 0u);
+
+    // the reserved addresses are reused
+    auto node = pool.allocate_node();
+    REQUIRE(pool.owns(first));
+    pool.deallocate_node(node);
+
+    // fresh nodes are zero, deallocated ones are cleared
+    auto zeroed = static_cast<char*>(pool.allocate_node_zeroed());
+    for (auto i = 0u; i != pool.node_size(); ++i)
+        REQUIRE(zeroed[i] == 0);
+    std::memset(zeroed, 'a', pool.node_size());
+    pool.deallocate_node(zeroed);
+
+    using traits = allocator_traits<pool_type>;
+    zeroed       = static_cast<char*>(traits::allocate_node_zeroed(pool, 16u, 1u));
+    for (auto i = 0u; i != pool.node_size(); ++i)
+        REQUIRE(zeroed[i] == 0);
+    traits::deallocate_node(pool, zeroed, 16u, 1u);
+}
+
+TEST_CASE("memory_pool<node_pool, aligned_block_allocator>")
+{
+    using pool_type = memory_pool<node_pool, aligned_block_allocator<>>;
+    using traits    = allocator_traits<pool_type>;
+
+    pool_type pool(64u, 4096u, 64u);
+    REQUIRE(pool.node_size() == 64u);
+    REQUIRE(traits::max_alignment(pool) == 64u);
+    // the arena header and the padding before the first node only take up one node
+    REQUIRE(pool.capacity_left() == 4096u - 64u);
+
+    std::vector<char*> nodes;
+    for (auto i = 0u; i != 128u; ++i)
+    {
+        auto node = static_cast<char*>(traits::allocate_node(pool, 64u, 64u));
+        REQUIRE(reinterpret_cast<std::uintptr_t>(node) % 64u == 0u);
+        nodes.push_back(node);
+    }
+    // nodes of a block are next to each other without padding
+    std::sort(nodes.begin(), nodes.end());
+    REQUIRE(nodes[1] - nodes[0] == 64);
+
+    for (auto node : nodes)
+        traits::deallocate_node(pool, node, 64u, 64u);
+    pool.shrink_to_fit();
+
+    SUBCASE("natural alignment")
+    {
+        pool_type pool96(96u, 4096u, 64u);
+        REQUIRE(traits::max_alignment(pool96) == 32u);
+        pool_type pool128(128u, 4096u, 64u);
+        REQUIRE(traits::max_alignment(pool128) == 64u);
+    }
+}
+
 TEST_CASE("memory_pool::min_block_size()")
 {
     SUBCASE("node_pool")
@@ -122,5 +397,264 @@ TEST_CASE("memory_pool::min_block_size()")
         use_min_block_size<small_node_pool>(1, 1000);
         use_min_block_size<small_node_pool>(16, 1000);
     }
+    SUBCASE("wide_small_node_pool")
+    {
+        use_min_block_size<wide_small_node_pool>(1, 1);
+        use_min_block_size<wide_small_node_pool>(16, 1);
+        use_min_block_size<wide_small_node_pool>(1, 1000);
+        use_min_block_size<wide_small_node_pool>(16, 1000);
+    }
+    SUBCASE("concurrent_node_pool")
+    {
+        use_min_block_size<concurrent_node_pool>(1, 1);
+        use_min_block_size<concurrent_node_pool>(16, 1000);
+    }
+    SUBCASE("cache_aligned_node_pool")
+    {
+        use_min_block_size<cache_aligned_node_pool>(1, 1);
+        use_min_block_size<cache_aligned_node_pool>(48, 1);
+        use_min_block_size<cache_aligned_node_pool>(48, 1000);
+        use_min_block_size<cache_aligned_node_pool>(100, 1000);
+    }
+}
+
+TEST_CASE("memory_pool<bitmap_array_pool>")
+{
+    using pool_type = memory_pool<bitmap_array_pool, allocator_reference<test_allocator>>;
+    using traits    = allocator_traits<pool_type>;
+    test_allocator alloc;
+    {
+        pool_type pool(16u, pool_type::min_block_size(16u, 256u), alloc);
+        REQUIRE(pool.capacity_left() >= 256u * 16u);
+        REQUIRE(pool.next_capacity() >= 256u * 16u);
+        auto capacity = pool.capacity_left();
+
+        // fragment the pool with arrays of varying length
+        std::vector<std::pair<void*, std::size_t>> arrays;
+        for (std::size_t i = 0u; i != 32u; ++i)
+            arrays.emplace_back(traits::allocate_array(pool, 1u + i % 7u, 16u, 16u), 1u + i % 7u);
+        REQUIRE(alloc.no_allocated() == 1u);
+        for (std::size_t i = 0u; i < arrays.size(); i += 2u)
+            traits::deallocate_array(pool, arrays[i].first, arrays[i].second, 16u, 16u);
+
+        // the gaps are reused, an array that does not fit into one grows the pool
+        auto gap = traits::allocate_array(pool, 5u, 16u, 16u);
+        REQUIRE(pool.owns(gap));
+        auto big = traits::allocate_array(pool, 300u, 16u, 16u);
+        REQUIRE(alloc.no_allocated() == 2u);
+
+        traits::deallocate_array(pool, big, 300u, 16u, 16u);
+        traits::deallocate_array(pool, gap, 5u, 16u, 16u);
+        for (std::size_t i = 1u; i < arrays.size(); i += 2u)
+            traits::deallocate_array(pool, arrays[i].first, arrays[i].second, 16u, 16u);
+        REQUIRE(pool.capacity_left() >= capacity);
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+}
+
+TEST_CASE("memory_pool<releasing_bitmap_array_pool>")
+{
+    using pool_type = memory_pool<releasing_bitmap_array_pool, allocator_reference<test_allocator>>;
+    test_allocator alloc;
+    {
+        pool_type pool(16u, pool_type::min_block_size(16u, 64u), alloc);
+
+        // fill three blocks and remember the nodes of each
+        std::vector<void*> blocks[3];
+        std::size_t        block = 0u;
+        while (block != 3u)
+        {
+            auto node = pool.allocate_node();
+            block     = alloc.no_allocated() - 1u;
+            if (block != 3u)
+                blocks[block].push_back(node);
+            else
+                pool.deallocate_node(node);
+        }
+        REQUIRE(alloc.no_allocated() == 4u);
+
+        // the fourth block is the only one with free nodes, so it stays
+        REQUIRE(pool.capacity_left() != 0u);
+        pool.deallocate_node(blocks[0].back());
+        blocks[0].pop_back();
+
+        // a block in the middle is returned once its last node is deallocated
+        for (auto node : blocks[1])
+            pool.deallocate_node(node);
+        REQUIRE(alloc.no_allocated() == 3u);
+
+        pool.deallocate_node_batch(blocks[2].data(), blocks[2].size());
+        REQUIRE(alloc.no_allocated() == 2u);
+
+        // the last block with free nodes is kept
+        for (auto node : blocks[0])
+            pool.deallocate_node(node);
+        REQUIRE(alloc.no_allocated() == 1u);
+
+        auto array = pool.allocate_array(8u);
+        pool.deallocate_array(array, 8u);
+        REQUIRE(alloc.no_allocated() == 1u);
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+
+    {
+        using traits = allocator_traits<pool_type>;
+        pool_type pool(16u, pool_type::min_block_size(16u, 64u), alloc);
+
+        // an array filling the first block, so the node is in a second one
+        auto count = pool.capacity_left() / 8u;
+        auto array = traits::allocate_array(pool, count, 8u, 8u);
+        auto node  = pool.allocate_node();
+        REQUIRE(alloc.no_allocated() == 2u);
+
+        // the traits release the empty block as well
+        traits::deallocate_array(pool, array, count, 8u, 8u);
+        REQUIRE(alloc.no_allocated() == 1u);
+        pool.deallocate_node(node);
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
 }
 
+TEST_CASE("memory_pool<cache_aligned_node_pool>")
+{
+    auto check_layout = [](std::size_t node_size, std::size_t expected)
+    {
+        memory_pool<cache_aligned_node_pool> pool(node_size, 4096u);
+        REQUIRE(pool.node_size() == expected);
+        for (auto i = 0u; i != 32u; ++i)
+        {
+            auto node = reinterpret_cast<std::uintptr_t>(pool.allocate_node());
+            auto line = expected < 64u ? expected : 64u;
+            REQUIRE(node % line == 0u);
+            // does not straddle a cache line unless it is bigger than one
+            REQUIRE((node % 64u + expected <= 64u || node % 64u == 0u));
+        }
+    };
+    check_layout(1u, sizeof(void*));
+    check_layout(24u, 32u);
+    check_layout(48u, 64u);
+    check_layout(64u, 64u);
+    check_layout(100u, 128u);
+}
+
+TEST_CASE("memory_pool<fixed_node_pool>")
+{
+    struct node
+    {
+        double      d;
+        std::size_t s;
+        char        c;
+    };
+    using pool_type = memory_pool<fixed_node_pool<sizeof(node), alignof(node)>>;
+    static_assert(sizeof(pool_type) < sizeof(memory_pool<node_pool>),
+                  "the node size is not stored");
+
+    pool_type pool(sizeof(node), pool_type::min_block_size(sizeof(node), 10u));
+    REQUIRE(pool.node_size() == sizeof(node));
+    REQUIRE(pool.capacity_left() == 10u * sizeof(node));
+
+    std::vector<void*> nodes;
+    for (auto i = 0u; i != 25u; ++i)
+    {
+        auto ptr = pool.allocate_node();
+        REQUIRE(reinterpret_cast<std::uintptr_t>(ptr) % alignof(node) == 0u);
+        nodes.push_back(ptr);
+    }
+    REQUIRE(pool.owns(nodes.back()));
+
+    std::shuffle(nodes.begin(), nodes.end(), std::mt19937{});
+    for (auto ptr : nodes)
+        pool.deallocate_node(ptr);
+    REQUIRE(pool.allocate_node() == nodes.back());
+    pool.deallocate_node(nodes.back());
+
+    // small nodes are rounded up to store the free list pointer
+    memory_pool<fixed_node_pool<2u>> small(2u, 4096u);
+    REQUIRE(small.node_size() == sizeof(void*));
+}
+
+TEST_CASE("memory_pool<concurrent_node_pool>")
+{
+    using pool_type = memory_pool<concurrent_node_pool, allocator_reference<test_allocator>>;
+    test_allocator alloc;
+    {
+        pool_type pool(16, pool_type::min_block_size(16, 16), alloc);
+        REQUIRE(alloc.no_allocated() == 1u);
+
+        // producer allocates, consumer deallocates
+        std::vector<void*> ptrs(1000u);
+        // allocate more than one block's worth up front, so the pool grows regardless of scheduling
+        auto pre_allocated = 2u * pool.capacity_left() / pool.node_size();
+        for (auto i = 0u; i != pre_allocated; ++i)
+            ptrs[i] = pool.allocate_node();
+        REQUIRE(alloc.no_allocated() > 1u);
+
+        std::atomic<std::size_t> produced(pre_allocated);
+        std::thread producer([&] {
+            for (auto ptr = ptrs.begin() + pre_allocated; ptr != ptrs.end(); ++ptr)
+            {
+                *ptr = pool.allocate_node();
+                produced.store(std::size_t(ptr - ptrs.begin()) + 1u, std::memory_order_release);
+            }
+        });
+        std::thread consumer([&] {
+            for (auto i = 0u; i != ptrs.size(); ++i)
+            {
+                while (produced.load(std::memory_order_acquire) <= i)
+                    std::this_thread::yield();
+                pool.deallocate_node(ptrs[i]);
+            }
+        });
+        producer.join();
+        consumer.join();
+
+        REQUIRE(pool.capacity_left() >= 16u * pool.node_size());
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+}
+
+
+namespace
+{
+    template <class PoolType>
+    void check_pool_stats()
+    {
+        using pool_type = memory_pool<PoolType>;
+        pool_type pool(16u, pool_type::min_block_size(16u, 8u));
+
+        auto stats = pool.stats();
+        REQUIRE(stats.blocks == 1u);
+        REQUIRE(stats.committed_bytes == pool_type::min_block_size(16u, 8u));
+        REQUIRE(stats.reserved_bytes == stats.committed_bytes);
+        REQUIRE(stats.used_bytes == 0u);
+        // the nodes that were never allocated are unused if the free list tracks them
+        REQUIRE(stats.free_listed_bytes + stats.unused_bytes == pool.capacity_left());
+        REQUIRE(stats.committed_bytes
+                == stats.free_listed_bytes + stats.unused_bytes + stats.wasted_bytes);
+
+        std::vector<void*> nodes;
+        for (auto i = 0u; i != 20u; ++i)
+            nodes.push_back(pool.allocate_node());
+
+        stats = pool.stats();
+        REQUIRE(stats.blocks >= 2u);
+        REQUIRE(stats.used_bytes == 20u * pool.node_size());
+        REQUIRE(stats.free_listed_bytes + stats.unused_bytes == pool.capacity_left());
+        REQUIRE(stats.committed_bytes
+                == stats.used_bytes + stats.free_listed_bytes + stats.unused_bytes
+                       + stats.wasted_bytes);
+
+        for (auto node : nodes)
+            pool.deallocate_node(node);
+        REQUIRE(pool.stats().used_bytes == 0u);
+    }
+} // namespace
+
+TEST_CASE("memory_pool stats")
+{
+    check_pool_stats<node_pool>();
+    check_pool_stats<array_pool>();
+    check_pool_stats<small_node_pool>();
+    check_pool_stats<cache_aligned_node_pool>();
+    check_pool_stats<bitmap_array_pool>();
+}
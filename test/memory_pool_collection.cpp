@@ -4,6 +4,7 @@
 #include "memory_pool_collection.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <doctest/doctest.h>
 #include <random>
 #include <vector>
@@ -93,6 +94,172 @@ TEST_CASE("memory_pool_collection")
             for (auto ptr : b)
                 pool.deallocate_node(ptr, 5);
         }
+        SUBCASE("big reserve")
+        {
+            // bigger than a block, but only one allocation
+            pool.reserve(8u, 20000u);
+            REQUIRE(alloc.no_allocated() == 2u);
+            REQUIRE(pool.pool_capacity_left(8u) >= 20000u / 8u);
+
+            std::vector<void*> nodes;
+            for (auto i = 0u; i != 2000u; ++i)
+                nodes.push_back(pool.allocate_node(8u));
+            REQUIRE(alloc.no_allocated() == 2u);
+            for (auto ptr : nodes)
+                pool.deallocate_node(ptr, 8u);
+        }
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+}
+
+TEST_CASE("memory_pool_collection rest of block")
+{
+    using pools =
+        memory_pool_collection<node_pool, identity_buckets, allocator_reference<test_allocator>>;
+    test_allocator alloc;
+    {
+        pools pool(256u, 64u * 1024u, alloc);
+
+        // the rest of a block is given to the next pool, even if it is too small for a node
+        std::vector<std::pair<void*, std::size_t>> nodes;
+        for (auto i = 0u; i != 1000u; ++i)
+        {
+            auto size = 1u + (i * 97u) % 256u;
+            nodes.emplace_back(pool.allocate_node(size), size);
+        }
+        for (auto node : nodes)
+            pool.deallocate_node(node.first, node.second);
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+}
+
+TEST_CASE("memory_pool_collection at least")
+{
+    using pools =
+        memory_pool_collection<node_pool, log2_buckets, allocator_reference<test_allocator>>;
+    using traits = allocator_traits<pools>;
+    test_allocator alloc;
+    {
+        pools pool(64u, 4000u, alloc);
+
+        // the node is taken from the bucket for 8 bytes
+        auto node = traits::allocate_node_at_least(pool, 5u, 1u);
+        REQUIRE(node.memory);
+        REQUIRE(node.size == 8u);
+        std::memset(node.memory, 0, node.size);
+
+        // the array uses two 32 byte nodes
+        auto array = traits::allocate_array_at_least(pool, 3u, 20u, 4u);
+        REQUIRE(array.memory);
+        REQUIRE(array.size == 3u);
+
+        // the array uses one 8 byte node
+        auto small = traits::allocate_array_at_least(pool, 2u, 3u, 1u);
+        REQUIRE(small.size == 2u);
+
+        traits::deallocate_array(pool, small.memory, small.size, 3u, 1u);
+        traits::deallocate_array(pool, array.memory, array.size, 20u, 4u);
+        traits::deallocate_node(pool, node.memory, node.size, 1u);
+
+        allocator_reference<pools> ref(pool);
+        auto                       result = ref.allocate_node_at_least(33u, 8u);
+        REQUIRE(result.size == 64u);
+        ref.deallocate_node(result.memory, result.size, 8u);
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+}
+
+TEST_CASE("memory_pool_collection stats")
+{
+    using pools = memory_pool_collection<node_pool, log2_buckets>;
+    pools pool(64u, 4000u);
+
+    auto check = [&](const memory_stats& stats)
+    {
+        REQUIRE(stats.committed_bytes
+                == stats.used_bytes + stats.free_listed_bytes + stats.unused_bytes
+                       + stats.wasted_bytes);
+    };
+
+    auto stats = pool.stats();
+    check(stats);
+    REQUIRE(stats.blocks == 1u);
+    REQUIRE(stats.used_bytes == 0u);
+    REQUIRE(stats.free_listed_bytes == 0u);
+    REQUIRE(stats.unused_bytes == pool.capacity_left());
+
+    std::vector<void*> nodes;
+    for (auto i = 0u; i != 10u; ++i)
+        nodes.push_back(pool.allocate_node(5u));
+    auto big = pool.allocate_node(40u);
+
+    stats = pool.stats();
+    check(stats);
+    REQUIRE(stats.used_bytes >= 10u * 8u + 64u);
+
+    auto small     = pool.pool_stats(5u);
+    auto node_size = small.used_bytes / 10u;
+    REQUIRE(small.used_bytes == 10u * node_size);
+    REQUIRE(node_size >= 8u);
+    REQUIRE(small.committed_bytes
+            == small.used_bytes + small.free_listed_bytes + small.unused_bytes);
+    REQUIRE(small.free_listed_bytes + small.unused_bytes
+            == pool.pool_capacity_left(5u) * node_size);
+    REQUIRE(pool.pool_stats(32u).committed_bytes == 0u);
+
+    auto sum = pool.pool_stats(8u).used_bytes + pool.pool_stats(64u).used_bytes;
+    REQUIRE(stats.used_bytes == sum);
+
+    pool.deallocate_node(big, 40u);
+    for (auto node : nodes)
+        pool.deallocate_node(node, 5u);
+    stats = pool.stats();
+    check(stats);
+    REQUIRE(stats.used_bytes == 0u);
+}
+
+TEST_CASE("slab_pool_collection")
+{
+    using pools =
+        slab_pool_collection<array_pool, identity_buckets, allocator_reference<test_allocator>>;
+    test_allocator alloc;
+    {
+        pools pool(128u, 4096u, alloc);
+        REQUIRE(pool.max_node_size() == 128u);
+        REQUIRE(pool.no_pools_created() == 0u);
+        REQUIRE(pool.pool_capacity_left(16u) == 0u);
+        REQUIRE(alloc.no_allocated() == 0u);
+
+        // each size class gets its own slab
+        std::vector<void*> a, b;
+        for (auto i = 0u; i != 5u; ++i)
+        {
+            a.push_back(pool.allocate_node(16u, 8u));
+            b.push_back(pool.allocate_node(100u, 4u));
+        }
+        REQUIRE(pool.no_pools_created() == 2u);
+        REQUIRE(alloc.no_allocated() == 2u);
+        REQUIRE(pool.pool_capacity_left(16u) > 0u);
+
+        // growing takes a whole slab
+        while (pool.pool_capacity_left(100u) != 0u)
+            b.push_back(pool.allocate_node(100u, 4u));
+        b.push_back(pool.allocate_node(100u, 4u));
+        REQUIRE(alloc.no_allocated() == 3u);
+        REQUIRE(pool.no_pools_created() == 2u);
+
+        auto array = pool.allocate_array(4u, 16u, 8u);
+        pool.deallocate_array(array, 4u, 16u, 8u);
+
+        for (auto ptr : a)
+            pool.deallocate_node(ptr, 16u, 8u);
+        for (auto ptr : b)
+            pool.deallocate_node(ptr, 100u, 4u);
+
+        // the pools can be moved
+        pools other(detail::move(pool));
+        REQUIRE(other.no_pools_created() == 2u);
+        other.deallocate_node(other.allocate_node(16u, 8u), 16u, 8u);
     }
     REQUIRE(alloc.no_allocated() == 0u);
 }
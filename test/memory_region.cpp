@@ -0,0 +1,116 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "memory_region.hpp"
+
+#include <doctest/doctest.h>
+#include <string>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    struct logged
+    {
+        std::vector<int>* log;
+        int               id;
+
+        logged(std::vector<int>& l, int i) : log(&l), id(i) {}
+
+        ~logged() noexcept
+        {
+            log->push_back(id);
+        }
+    };
+
+    struct throwing
+    {
+        throwing()
+        {
+            throw 42;
+        }
+    };
+} // namespace
+
+TEST_CASE("memory_region")
+{
+    using region_type = memory_region<allocator_reference<test_allocator>>;
+
+    test_allocator   alloc;
+    std::vector<int> log;
+    SUBCASE("unwind")
+    {
+        {
+            region_type region(1024u, alloc);
+            REQUIRE(alloc.no_allocated() == 1u);
+
+            region.create<logged>(log, 0);
+            auto m = region.top();
+            auto a = region.create<logged>(log, 1);
+            auto b = region.create<logged>(log, 2);
+            REQUIRE(a->id == 1);
+            REQUIRE(b->id == 2);
+
+            // no finalizer for trivially destructible types
+            auto capacity = region.capacity_left();
+            region.allocate(sizeof(int), alignof(int));
+            auto raw_size = capacity - region.capacity_left();
+            capacity      = region.capacity_left();
+            region.create<int>(3);
+            REQUIRE(capacity - region.capacity_left() == raw_size);
+
+            region.unwind(m);
+            REQUIRE(log == (std::vector<int>{2, 1}));
+
+            auto c = region.create<logged>(log, 3);
+            REQUIRE(static_cast<void*>(c) == static_cast<void*>(a));
+        }
+        REQUIRE(log == (std::vector<int>{2, 1, 3, 0}));
+        REQUIRE(alloc.no_allocated() == 0u);
+    }
+    SUBCASE("growth")
+    {
+        region_type region(region_type::min_block_size(64u), alloc);
+        auto        m = region.top();
+        for (auto i = 0; i != 32; ++i)
+            region.create<std::string>(32u, char('a' + i % 26));
+        region.create<logged>(log, 0);
+        REQUIRE(alloc.no_allocated() > 1u);
+
+        region.unwind(m);
+        REQUIRE(log == (std::vector<int>{0}));
+    }
+    SUBCASE("add_finalizer")
+    {
+        region_type region(1024u, alloc);
+        {
+            memory_stack_raii_unwind<region_type> unwind(region);
+
+            auto memory = region.allocate(sizeof(int), alignof(int));
+            REQUIRE(memory);
+            region.add_finalizer([](void* ptr) { static_cast<std::vector<int>*>(ptr)->push_back(1); },
+                                 &log);
+            region.add_finalizer([](void* ptr) { static_cast<std::vector<int>*>(ptr)->push_back(2); },
+                                 &log);
+        }
+        REQUIRE(log == (std::vector<int>{2, 1}));
+    }
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+    SUBCASE("exception")
+    {
+        {
+            region_type region(1024u, alloc);
+            region.create<logged>(log, 0);
+
+            auto capacity = region.capacity_left();
+            REQUIRE_THROWS_AS(region.create<throwing>(), int);
+            REQUIRE(region.capacity_left() == capacity);
+        }
+        REQUIRE(log == (std::vector<int>{0}));
+    }
+#endif
+}
@@ -0,0 +1,85 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "memory_resources.hpp"
+
+#include <doctest/doctest.h>
+
+#include "detail/align.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("pool_resource")
+{
+    pool_resource<> resource(32u, 4000u);
+    memory_resource& base = resource;
+    REQUIRE(base.is_equal(resource));
+
+    auto& pools = resource.get_collection();
+    auto  node  = base.allocate(16u, 8u);
+    REQUIRE(detail::is_aligned(node, 8u));
+    base.deallocate(node, 16u, 8u);
+    auto capacity = pools.pool_capacity_left(16u);
+
+    node = base.allocate(16u, 8u);
+    REQUIRE(pools.pool_capacity_left(16u) == capacity - 1u);
+    base.deallocate(node, 16u, 8u);
+    REQUIRE(pools.pool_capacity_left(16u) == capacity);
+
+    // small but aligned allocation uses a bigger size class
+    node = base.allocate(1u, 16u);
+    REQUIRE(detail::is_aligned(node, 16u));
+    base.deallocate(node, 1u, 16u);
+    REQUIRE(pools.pool_capacity_left(16u) == capacity);
+
+
+    // too big for the collection
+    auto total = pools.capacity_left();
+    auto big   = base.allocate(1024u, 8u);
+    REQUIRE(pools.capacity_left() == total);
+    base.deallocate(big, 1024u, 8u);
+}
+
+TEST_CASE("pool_resource with identity_buckets")
+{
+    pool_resource<node_pool, identity_buckets> resource(32u, 8000u);
+    memory_resource&                           base = resource;
+
+    // the size is rounded up to a multiple of the alignment, so every node is aligned
+    void* nodes[4];
+    for (auto& node : nodes)
+    {
+        node = base.allocate(24u, 16u);
+        REQUIRE(detail::is_aligned(node, 16u));
+    }
+    for (auto node : nodes)
+        base.deallocate(node, 24u, 16u);
+}
+
+TEST_CASE("monotonic_resource")
+{
+    monotonic_resource<> resource(4000u);
+    memory_resource&     base = resource;
+    REQUIRE(base.is_equal(resource));
+
+    auto& stack    = resource.get_stack();
+    auto  capacity = stack.capacity_left();
+
+    auto a = base.allocate(16u, 16u);
+    REQUIRE(detail::is_aligned(a, 16u));
+    auto b = base.allocate(100u, 1u);
+    REQUIRE(a != b);
+    REQUIRE(stack.capacity_left() < capacity);
+
+    // deallocation does nothing
+    auto left = stack.capacity_left();
+    base.deallocate(b, 100u, 1u);
+    REQUIRE(stack.capacity_left() == left);
+
+    // enough to need a new block
+    for (auto i = 0; i != 100; ++i)
+        REQUIRE(base.allocate(100u, 8u));
+
+    resource.release();
+    REQUIRE(stack.capacity_left() == capacity);
+}
@@ -5,11 +5,25 @@
 
 #include <doctest/doctest.h>
 
+#include <cstring>
+
 #include "allocator_storage.hpp"
 #include "test_allocator.hpp"
 
 using namespace foonathan::memory;
 
+namespace
+{
+    bool is_zero(const void* memory, std::size_t size)
+    {
+        auto bytes = static_cast<const char*>(memory);
+        for (std::size_t i = 0u; i != size; ++i)
+            if (bytes[i] != 0)
+                return false;
+        return true;
+    }
+} // namespace
+
 TEST_CASE("memory_stack")
 {
     test_allocator alloc;
@@ -45,6 +59,21 @@ TEST_CASE("memory_stack")
         REQUIRE(alloc.no_allocated() == 1u);
         REQUIRE(alloc.no_deallocated() == 0u);
     }
+    SUBCASE("poisoning")
+    {
+        auto poisoned = poisoning_active();
+
+        auto m      = stack.top();
+        auto memory = static_cast<char*>(stack.allocate(10, 1));
+        REQUIRE(!detail::debug_is_poisoned(memory));
+        REQUIRE(!detail::debug_is_poisoned(memory + 9));
+        REQUIRE(detail::debug_is_poisoned(memory + 10 + detail::debug_fence_size) == poisoned);
+
+        stack.unwind(m);
+        REQUIRE(detail::debug_is_poisoned(memory) == poisoned);
+        REQUIRE(stack.allocate(10, 1) == memory);
+        REQUIRE(!detail::debug_is_poisoned(memory));
+    }
     SUBCASE("multiple block allocation/unwind")
     {
         // note: tests are mostly hoping not to get a segfault
@@ -140,10 +169,170 @@ TEST_CASE("memory_stack")
         REQUIRE(unwind2.get_marker() == m);
         REQUIRE(!unwind.will_unwind());
     }
+    SUBCASE("batch")
+    {
+        void* nodes[4];
+
+        using composable = composable_allocator_traits<stack_type>;
+        REQUIRE(!composable::try_allocate_node_batch(stack, nodes, 4u, 100u, 1u));
+        REQUIRE(composable::try_allocate_node_batch(stack, nodes, 2u, 8u, 1u));
+        REQUIRE(composable::try_deallocate_node_batch(stack, nodes, 2u, 8u, 1u));
+        REQUIRE(alloc.no_allocated() == 1u);
+
+        using traits = allocator_traits<stack_type>;
+        traits::allocate_node_batch(stack, nodes, 4u, 10u, 8u);
+        for (auto i = 0u; i != 4u; ++i)
+            REQUIRE(detail::is_aligned(nodes[i], 8u));
+        for (auto i = 1u; i != 4u; ++i)
+            REQUIRE(static_cast<char*>(nodes[i]) - static_cast<char*>(nodes[i - 1]) == 16);
+        traits::deallocate_node_batch(stack, nodes, 4u, 10u, 8u);
+
+        // count * size wraps around to a small size
+        auto wrapping = std::size_t(-1) / 8u + 2u;
+        REQUIRE(!composable::try_allocate_node_batch(stack, nodes, wrapping, 8u, 1u));
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+        REQUIRE_THROWS_AS(traits::allocate_node_batch(stack, nodes, wrapping, 8u, 1u),
+                          bad_array_size);
+#endif
+    }
+    SUBCASE("try_expand")
+    {
+        auto first = stack.allocate(10u, 1u);
+        auto last  = stack.allocate(10u, 1u);
+        REQUIRE(!stack.try_expand(first, 10u, 20u));
+        REQUIRE(stack.try_expand(last, 10u, 20u));
+        REQUIRE(!stack.try_expand(last, 20u, 200u));
+        REQUIRE(alloc.no_allocated() == 1u);
+
+        using traits = allocator_traits<stack_type>;
+        REQUIRE(traits::try_expand_node(stack, last, 20u, 5u, 1u));
+        REQUIRE(traits::try_expand_array(stack, last, 5u, 6u, 1u, 1u));
+
+        // default traits cannot expand
+        REQUIRE(!allocator_traits<test_allocator>::try_expand_node(alloc, last, 12u, 13u, 1u));
+        allocator_reference<stack_type> ref(stack);
+        REQUIRE(ref.try_expand_node(last, 6u, 16u, 1u));
+    }
     SUBCASE("overaligned")
     {
         auto align = 2 * detail::max_alignment;
         auto mem   = stack.allocate(align, align);
         REQUIRE(detail::is_aligned(mem, align));
     }
+    SUBCASE("zeroed")
+    {
+        auto m = stack.top();
+        std::memset(stack.allocate(50u, 1u), 'a', 50u);
+        stack.unwind(m);
+
+        auto memory = stack.allocate_zeroed(60u, 1u);
+        REQUIRE(is_zero(memory, 60u));
+
+        // grows
+        using traits = allocator_traits<stack_type>;
+        auto node    = traits::allocate_node_zeroed(stack, 80u, 1u);
+        REQUIRE(alloc.no_allocated() == 2u);
+        REQUIRE(is_zero(node, 80u));
+        traits::deallocate_node(stack, node, 80u, 1u);
+
+        allocator_reference<stack_type> ref(stack);
+        auto array = ref.allocate_array_zeroed(2u, 8u, 8u);
+        REQUIRE(is_zero(array, 16u));
+        ref.deallocate_array(array, 2u, 8u, 8u);
+    }
+    SUBCASE("compile-time size and alignment")
+    {
+        stack.allocate<10, 1>();
+        REQUIRE(stack.capacity_left() == capacity - 10 - 2 * detail::debug_fence_size);
+
+        auto m      = stack.top();
+        auto memory = stack.allocate<10, 16>();
+        REQUIRE(detail::is_aligned(memory, 16));
+        stack.unwind(m);
+        REQUIRE(stack.allocate(10, 16) == memory);
+
+        // grows like the runtime version
+        auto big = stack.allocate<100, 8>();
+        REQUIRE(detail::is_aligned(big, 8));
+        REQUIRE(alloc.no_allocated() == 2u);
+
+        using traits = allocator_traits<stack_type>;
+        auto node    = traits::allocate_node<4, 4>(stack);
+        REQUIRE(detail::is_aligned(node, 4));
+        traits::deallocate_node(stack, node, 4u, 4u);
+
+        // std_allocator uses it for single objects
+        allocator_reference<stack_type> ref(stack);
+        auto ptr = static_cast<double*>(ref.allocate_node<sizeof(double), alignof(double)>());
+        REQUIRE(detail::is_aligned(ptr, alignof(double)));
+        ref.deallocate_node(ptr, sizeof(double), alignof(double));
+    }
+}
+
+TEST_CASE("memory_stack<virtual_block_allocator> zeroed")
+{
+    using stack_type = memory_stack<virtual_block_allocator>;
+    stack_type stack(virtual_memory_page_size, 4u);
+
+    auto m     = stack.top();
+    auto first = static_cast<char*>(stack.allocate_zeroed(100u, 1u));
+    REQUIRE(is_zero(first, 100u));
+    std::memset(first, 'a', 100u);
+
+    // unwound memory is cleared again
+    stack.unwind(m);
+    auto memory = static_cast<char*>(stack.allocate_zeroed(200u, 1u));
+    REQUIRE(memory == first);
+    REQUIRE(is_zero(memory, 200u));
+    std::memset(memory, 'b', 200u);
+
+    // so is memory freed by shrinking
+    REQUIRE(stack.try_expand(memory, 200u, 10u));
+    auto shrunk = stack.allocate_zeroed(100u, 1u);
+    REQUIRE(is_zero(shrunk, 100u));
+    std::memset(shrunk, 'c', 100u);
+
+    // a new block and a cached one
+    auto size  = stack.capacity_left() + 1u;
+    auto block = stack.top();
+    auto grown = static_cast<char*>(stack.allocate_zeroed(size, 1u));
+    REQUIRE(is_zero(grown, size));
+    std::memset(grown, 'd', size);
+    stack.unwind(block);
+    REQUIRE(stack.allocate_zeroed(size, 1u) == grown);
+    REQUIRE(is_zero(grown, size));
+}
+
+TEST_CASE("memory_stack stats")
+{
+    using stack_type = memory_stack<>;
+    stack_type stack(stack_type::min_block_size(100u));
+
+    auto stats = stack.stats();
+    REQUIRE(stats.blocks == 1u);
+    REQUIRE(stats.committed_bytes == stack_type::min_block_size(100u));
+    REQUIRE(stats.unused_bytes == 100u);
+    REQUIRE(stats.used_bytes == 0u);
+    REQUIRE(stats.free_listed_bytes == 0u);
+    REQUIRE(stats.wasted_bytes == stats.committed_bytes - 100u);
+
+    auto m = stack.top();
+    stack.allocate(10u, 1u);
+    stats = stack.stats();
+    REQUIRE(stats.used_bytes + stats.unused_bytes == 100u);
+    REQUIRE(stats.unused_bytes == stack.capacity_left());
+
+    stack.allocate(100u, 1u);
+    stats = stack.stats();
+    REQUIRE(stats.blocks == 2u);
+    REQUIRE(stats.cached_blocks == 0u);
+    REQUIRE(stats.committed_bytes
+            == stats.used_bytes + stats.unused_bytes + stats.wasted_bytes);
+
+    stack.unwind(m);
+    stats = stack.stats();
+    REQUIRE(stats.blocks == 1u);
+    REQUIRE(stats.cached_blocks == 1u);
+    REQUIRE(stats.reserved_bytes > stats.committed_bytes);
+    REQUIRE(stats.unused_bytes == 100u);
 }
@@ -0,0 +1,164 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "metrics_exporter.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <doctest/doctest.h>
+#include <fstream>
+#include <sstream>
+
+#include "memory_pool.hpp"
+#include "memory_stack.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    bool contains(const std::string& str, const char* substr)
+    {
+        return str.find(substr) != std::string::npos;
+    }
+} // namespace
+
+TEST_CASE("metrics_registry")
+{
+    metrics_registry registry;
+    REQUIRE(registry.prometheus().empty());
+
+    memory_pool<> pool(16u, memory_pool<>::min_block_size(16u, 10u));
+    auto          node = pool.allocate_node();
+
+    auto pool_registration = registry.add("pool");
+    REQUIRE(pool_registration);
+    // not updated yet
+    REQUIRE(registry.prometheus().empty());
+
+    pool_registration.update(pool.stats());
+
+    memory_stack<> stack(memory_stack<>::min_block_size(100u));
+    stack.allocate(10u, 1u);
+    auto stack_registration =
+        registry.add("stack \"1\"", [&] { return stack.stats(); });
+
+    allocation_statistics statistics;
+    statistics.on_allocate(8u);
+    auto statistics_registration = registry.add("tracked", statistics);
+
+    SUBCASE("collect")
+    {
+        std::string last_metric;
+        auto        metrics = 0u, samples = 0u;
+        std::size_t pool_used = 0u, stack_used = 0u, tracked_live = 0u;
+        registry.collect(
+            [&](const metric_sample& sample)
+            {
+                if (sample.metric != last_metric)
+                {
+                    ++metrics;
+                    last_metric = sample.metric;
+                }
+                ++samples;
+
+                if (last_metric == "foonathan_memory_used_bytes")
+                {
+                    REQUIRE(sample.kind == metric_kind::gauge);
+                    if (sample.allocator == "pool")
+                        pool_used = sample.value;
+                    else if (sample.allocator == "stack \"1\"")
+                        stack_used = sample.value;
+                    else
+                        FAIL("unexpected allocator");
+                }
+                else if (last_metric == "foonathan_memory_live_bytes")
+                {
+                    REQUIRE(sample.allocator == "tracked");
+                    tracked_live = sample.value;
+                }
+                else if (last_metric == "foonathan_memory_allocations_total")
+                    REQUIRE(sample.kind == metric_kind::counter);
+            });
+        // each metric is reported once, with all its samples
+        REQUIRE(metrics == 17u);
+        REQUIRE(samples == 8u * 2u + 9u);
+        REQUIRE(pool_used == 16u);
+        REQUIRE(stack_used >= 10u);
+        REQUIRE(tracked_live == 8u);
+    }
+    SUBCASE("prometheus")
+    {
+        auto text = registry.prometheus();
+        REQUIRE(contains(text, "# TYPE foonathan_memory_used_bytes gauge\n"));
+        REQUIRE(contains(text, "# TYPE foonathan_memory_allocations_total counter\n"));
+        REQUIRE(contains(text, "foonathan_memory_used_bytes{allocator=\"pool\"} 16\n"));
+        REQUIRE(contains(text, "foonathan_memory_blocks{allocator=\"stack \\\"1\\\"\"} 1\n"));
+        REQUIRE(contains(text, "foonathan_memory_allocations_total{allocator=\"tracked\"} 1\n"));
+
+        // the snapshot is only changed by an update
+        pool.allocate_node();
+        REQUIRE(registry.prometheus() == text);
+        pool_registration.update(pool.stats());
+        REQUIRE(contains(registry.prometheus(),
+                         "foonathan_memory_used_bytes{allocator=\"pool\"} 32\n"));
+    }
+    SUBCASE("write_prometheus")
+    {
+        auto path = "foonathan_memory_metrics_test.prom";
+        REQUIRE(registry.write_prometheus(path));
+
+        std::ifstream     file(path);
+        std::stringstream content;
+        content << file.rdbuf();
+        REQUIRE(content.str() == registry.prometheus());
+
+        file.close();
+        std::remove(path);
+    }
+    SUBCASE("remove")
+    {
+        pool_registration       = metrics_registration();
+        stack_registration      = metrics_registration();
+        auto moved_registration = detail::move(statistics_registration);
+        REQUIRE(!statistics_registration);
+
+        auto text = registry.prometheus();
+        REQUIRE(!contains(text, "allocator=\"pool\""));
+        REQUIRE(!contains(text, "allocator=\"stack"));
+        REQUIRE(contains(text, "allocator=\"tracked\""));
+
+        moved_registration = metrics_registration();
+        REQUIRE(registry.prometheus().empty());
+    }
+
+    pool.deallocate_node(node);
+}
+
+TEST_CASE("metrics_publisher")
+{
+    metrics_registry      registry;
+    allocation_statistics statistics;
+    auto                  registration = registry.add("tracked", statistics);
+
+    std::atomic<unsigned> published(0u);
+    std::atomic<bool>     same_registry(true);
+    {
+        metrics_publisher publisher(registry, std::chrono::milliseconds(1),
+                                    [&](const metrics_registry& r)
+                                    {
+                                        if (&r != &registry)
+                                            same_registry = false;
+                                        ++published;
+                                    });
+        publisher.publish_now();
+        REQUIRE(published >= 1u);
+
+        while (published < 3u)
+            std::this_thread::yield();
+    }
+    // not called after the destructor
+    auto count = published.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    REQUIRE(published == count);
+    REQUIRE(same_registry);
+}
@@ -0,0 +1,66 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "numa.hpp"
+
+#include <doctest/doctest.h>
+
+#include "memory_pool.hpp"
+#include "memory_stack.hpp"
+#include "virtual_memory.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("numa_block_allocator")
+{
+    REQUIRE(get_numa_node_count() >= 1u);
+    REQUIRE(get_current_numa_node() < get_numa_node_count());
+
+    SUBCASE("explicit node")
+    {
+        numa_block_allocator alloc(1u, 0u);
+        REQUIRE(alloc.node() == 0u);
+        REQUIRE(alloc.next_block_size() == virtual_memory_page_size);
+
+        auto block = alloc.allocate_block();
+        REQUIRE(block.memory);
+        REQUIRE(block.size == virtual_memory_page_size);
+        REQUIRE(alloc.next_block_size() == 2 * virtual_memory_page_size);
+
+        // memory is committed
+        static_cast<char*>(block.memory)[block.size - 1u] = 'a';
+        alloc.deallocate_block(block);
+    }
+    SUBCASE("local node")
+    {
+        numa_block_allocator alloc(virtual_memory_page_size + 1u);
+        REQUIRE(alloc.node() == numa_local_node);
+        REQUIRE(alloc.next_block_size() == 2 * virtual_memory_page_size);
+
+        auto block = alloc.allocate_block();
+        static_cast<char*>(block.memory)[0] = 'a';
+        alloc.deallocate_block(block);
+    }
+    SUBCASE("memory_pool")
+    {
+        memory_pool<node_pool, numa_block_allocator> pool(16u, 4096u, 0u);
+        auto a = pool.allocate_node();
+        auto b = pool.allocate_node();
+        REQUIRE(a != b);
+        pool.deallocate_node(a);
+        pool.deallocate_node(b);
+    }
+}
+
+TEST_CASE("per_numa_node")
+{
+    per_numa_node<memory_stack<numa_block_allocator>> stacks(4096u);
+    REQUIRE(stacks.size() == get_numa_node_count());
+    for (auto i = 0u; i != stacks.size(); ++i)
+        REQUIRE(stacks.get(i).get_allocator().node() == i);
+
+    auto& stack = stacks.local();
+    auto  mem   = stack.allocate(64u, 8u);
+    REQUIRE(mem);
+    REQUIRE(stack.capacity_left() < 4096u);
+}
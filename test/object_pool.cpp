@@ -0,0 +1,115 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "object_pool.hpp"
+
+#include <doctest/doctest.h>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    struct connection
+    {
+        static int constructed, destroyed;
+
+        std::vector<char> buffer;
+        int               id;
+
+        explicit connection(int i = 0) : id(i)
+        {
+            if (i < 0)
+                throw i;
+            ++constructed;
+        }
+
+        ~connection() noexcept
+        {
+            ++destroyed;
+        }
+    };
+
+    int connection::constructed = 0;
+    int connection::destroyed   = 0;
+} // namespace
+
+TEST_CASE("object_pool")
+{
+    using pool_type = object_pool<connection, allocator_reference<test_allocator>>;
+
+    connection::constructed = connection::destroyed = 0;
+    test_allocator alloc;
+    SUBCASE("destroying")
+    {
+        {
+            pool_type pool(pool_type::min_block_size(4u), alloc);
+            REQUIRE(pool.capacity_left() == 4u);
+            {
+                auto a = pool.acquire(1);
+                auto b = pool.acquire(2);
+                REQUIRE(a->id == 1);
+                REQUIRE(b->id == 2);
+                REQUIRE(pool.capacity_left() == 2u);
+            }
+            REQUIRE(connection::destroyed == 2);
+            REQUIRE(pool.cached() == 0u);
+            REQUIRE(pool.capacity_left() == 4u);
+
+            auto c = pool.acquire(3);
+            REQUIRE(c->id == 3);
+            REQUIRE(connection::constructed == 3);
+        }
+        REQUIRE(connection::destroyed == 3);
+        REQUIRE(alloc.no_allocated() == 0u);
+    }
+    SUBCASE("recycling")
+    {
+        {
+            pool_type pool([](connection& c) { c.buffer.clear(); }, pool_type::min_block_size(4u),
+                           alloc);
+            const char* data = nullptr;
+            {
+                auto a = pool.acquire(1);
+                a->buffer.resize(1024u);
+                data = a->buffer.data();
+            }
+            REQUIRE(connection::destroyed == 0);
+            REQUIRE(pool.cached() == 1u);
+
+            auto b = pool.acquire(2);
+            REQUIRE(pool.cached() == 0u);
+            REQUIRE(connection::constructed == 1);
+            // the object and its buffer are reused
+            REQUIRE(b->id == 1);
+            REQUIRE(b->buffer.empty());
+            REQUIRE(b->buffer.capacity() >= 1024u);
+            REQUIRE(b->buffer.data() == data);
+
+            auto c = pool.acquire(3);
+            REQUIRE(c->id == 3);
+            c.reset();
+            b.reset();
+            REQUIRE(pool.cached() == 2u);
+
+            pool.clear_cache();
+            REQUIRE(connection::destroyed == 2);
+            REQUIRE(pool.capacity_left() == 4u);
+
+            pool.acquire(4).reset();
+        }
+        REQUIRE(connection::destroyed == 3);
+        REQUIRE(alloc.no_allocated() == 0u);
+    }
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+    SUBCASE("exception")
+    {
+        pool_type pool(pool_type::min_block_size(4u), alloc);
+        REQUIRE_THROWS_AS(pool.acquire(-1), int);
+        REQUIRE(pool.capacity_left() == 4u);
+    }
+#endif
+}
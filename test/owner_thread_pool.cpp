@@ -0,0 +1,58 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "owner_thread_pool.hpp"
+
+#include <atomic>
+#include <doctest/doctest.h>
+#include <thread>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("owner_thread_pool")
+{
+    using pool_type = owner_thread_pool<node_pool, allocator_reference<test_allocator>>;
+    test_allocator alloc;
+    {
+        pool_type pool(16u, pool_type::min_block_size(16u, 100u), alloc);
+        REQUIRE(pool.is_owner());
+        REQUIRE(alloc.no_allocated() == 1u);
+        auto capacity = pool.capacity_left();
+
+        std::vector<void*> ptrs;
+        for (auto i = 0u; i != 100u; ++i)
+            ptrs.push_back(pool.allocate_node());
+        REQUIRE(pool.capacity_left() == 0u);
+
+        // freed by other threads
+        std::vector<std::thread> threads;
+        std::atomic<bool>        owner(false);
+        for (auto i = 0u; i != 4u; ++i)
+            threads.emplace_back(
+                [&, i]
+                {
+                    if (pool.is_owner())
+                        owner = true;
+                    for (auto j = i; j < ptrs.size(); j += 4u)
+                        pool.deallocate_node(ptrs[j]);
+                });
+        for (auto& thread : threads)
+            thread.join();
+        REQUIRE(!owner);
+        REQUIRE(pool.capacity_left() == 0u);
+
+        // reuses the remotely freed nodes instead of growing
+        auto node = pool.allocate_node();
+        REQUIRE(alloc.no_allocated() == 1u);
+        REQUIRE(pool.capacity_left() == capacity - pool.node_size());
+        REQUIRE(pool.drain_remote_frees() == 0u);
+
+        pool.deallocate_node(node);
+        REQUIRE(pool.capacity_left() == capacity);
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+}
@@ -0,0 +1,92 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "pinned_block_allocator.hpp"
+
+#include <doctest/doctest.h>
+
+#include "memory_pool.hpp"
+#include "memory_stack.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    struct pin_registry
+    {
+        std::size_t pinned = 0u, unpinned = 0u, bytes = 0u;
+        bool        fail   = false;
+    };
+
+    bool pin_block(void*, std::size_t size, void* user_data)
+    {
+        auto& registry = *static_cast<pin_registry*>(user_data);
+        if (registry.fail)
+            return false;
+        ++registry.pinned;
+        registry.bytes += size;
+        return true;
+    }
+
+    void unpin_block(void*, std::size_t size, void* user_data)
+    {
+        auto& registry = *static_cast<pin_registry*>(user_data);
+        ++registry.unpinned;
+        registry.bytes -= size;
+    }
+} // namespace
+
+TEST_CASE("pinned_block_allocator")
+{
+    auto block_size = 4u * virtual_memory_page_size;
+
+    SUBCASE("mlock")
+    {
+        memory_stack<pinned_block_allocator<virtual_block_allocator>> stack(block_size, 2u);
+        auto memory = static_cast<char*>(stack.allocate(block_size / 2u, 1u));
+        memory[0]   = 'a';
+        REQUIRE(stack.get_allocator().get_allocator().capacity_left() == 1u);
+    }
+    SUBCASE("callbacks")
+    {
+        using allocator_t = pinned_block_allocator<virtual_block_allocator, callback_pinner>;
+
+        pin_registry registry;
+        {
+            memory_pool<node_pool, allocator_t> pool(16u, block_size,
+                                                     callback_pinner(&pin_block, &unpin_block,
+                                                                     &registry),
+                                                     4u);
+            REQUIRE(registry.pinned == 1u);
+            REQUIRE(registry.bytes == block_size);
+
+            // nodes of the same block are only pinned once
+            while (pool.capacity_left() != 0u)
+                pool.allocate_node();
+            REQUIRE(registry.pinned == 1u);
+
+            pool.allocate_node();
+            REQUIRE(registry.pinned == 2u);
+            REQUIRE(pool.get_allocator().get_pinner().user_data() == &registry);
+        }
+        REQUIRE(registry.unpinned == 2u);
+        REQUIRE(registry.bytes == 0u);
+
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+        registry.fail = true;
+        allocator_t alloc(block_size, callback_pinner(&pin_block, &unpin_block, &registry), 4u);
+        auto thrown = false;
+        try
+        {
+            alloc.allocate_block();
+        }
+        catch (out_of_memory&)
+        {
+            thrown = true;
+        }
+        REQUIRE(thrown);
+        // the block is returned when it cannot be pinned
+        REQUIRE(alloc.get_allocator().capacity_left() == 4u);
+#endif
+    }
+}
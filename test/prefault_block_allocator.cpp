@@ -0,0 +1,73 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "prefault_block_allocator.hpp"
+
+#include <doctest/doctest.h>
+
+#include "memory_pool_collection.hpp"
+#include "memory_stack.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("prefault_memory")
+{
+    // keeps the contents, also for a partial first page
+    static char buffer[3 * 4096 + 100];
+    for (std::size_t i = 0u; i != sizeof(buffer); ++i)
+        buffer[i] = char(i % 128u);
+
+    prefault_memory(buffer + 1, sizeof(buffer) - 1u);
+    for (std::size_t i = 0u; i != sizeof(buffer); ++i)
+        REQUIRE(buffer[i] == char(i % 128u));
+}
+
+TEST_CASE("prefault_block_allocator")
+{
+    auto block_size = 4u * virtual_memory_page_size;
+
+    SUBCASE("on_allocate")
+    {
+        memory_stack<prefault_block_allocator<virtual_block_allocator>> stack(block_size, 4u);
+        REQUIRE(stack.get_allocator().get_allocator().capacity_left() == 3u);
+
+        auto memory = static_cast<char*>(stack.allocate(block_size / 2u, 1u));
+        memory[0]   = 'a';
+        stack.prefault();
+    }
+    SUBCASE("ahead")
+    {
+        using allocator_t = prefault_block_allocator<virtual_block_allocator, prefault_mode::ahead>;
+        memory_stack<allocator_t> stack(block_size, 4u);
+        // one block is used and one allocated ahead
+        auto& blocks = stack.get_allocator().get_allocator();
+        REQUIRE(blocks.capacity_left() == 2u);
+        REQUIRE(stack.get_allocator().next_block_size() == block_size);
+
+        auto marker = stack.top();
+        // each allocation needs a new block
+        for (auto i = 0; i != 3; ++i)
+        {
+            auto memory = static_cast<char*>(stack.allocate(block_size / 2u, 1u));
+            memory[block_size / 2u - 1u] = 'a';
+        }
+        // all blocks in use, nothing left to allocate ahead
+        REQUIRE(blocks.capacity_left() == 0u);
+
+        // the blocks are deallocated in reversed order, starting with the one allocated ahead
+        stack.unwind(marker);
+        stack.shrink_to_fit();
+        REQUIRE(blocks.capacity_left() == 3u);
+    }
+}
+
+TEST_CASE("memory_pool_collection reserve with prefault")
+{
+    memory_pool_collection<node_pool, identity_buckets> pools(16u, 4096u);
+    auto                                                before = pools.pool_capacity_left(16u);
+    pools.reserve(16u, 256u, true);
+    REQUIRE(pools.pool_capacity_left(16u) == before + 256u / 16u);
+
+    auto node = pools.allocate_node(16u);
+    pools.deallocate_node(node, 16u);
+}
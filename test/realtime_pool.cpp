@@ -0,0 +1,90 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "realtime_pool.hpp"
+
+#include <doctest/doctest.h>
+
+#include <thread>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("realtime_pool")
+{
+    SUBCASE("manual")
+    {
+        using pool_type =
+            realtime_pool<allocator_reference<test_allocator>, realtime_refill::manual>;
+        test_allocator alloc;
+        pool_type      pool(16u, 1024u, 100u, alloc);
+        REQUIRE(pool.node_size() == 16u);
+        REQUIRE(pool.capacity_left() >= 100u);
+        auto blocks = alloc.no_allocated();
+        REQUIRE(blocks != 0u);
+
+        // allocations never allocate blocks
+        std::vector<void*> nodes;
+        while (auto node = pool.try_allocate_node())
+            nodes.push_back(node);
+        REQUIRE(nodes.size() >= 100u);
+        REQUIRE(pool.capacity_left() == 0u);
+        REQUIRE(alloc.no_allocated() == blocks);
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+        REQUIRE_THROWS_AS(pool.allocate_node(), out_of_fixed_memory);
+#endif
+
+        // deallocated nodes are reused
+        pool.deallocate_node(nodes.back());
+        REQUIRE(pool.try_allocate_node() == nodes.back());
+
+        std::thread refiller([&] { pool.refill(); });
+        refiller.join();
+        REQUIRE(pool.capacity_left() >= 100u);
+        REQUIRE(alloc.no_allocated() > blocks);
+        for (auto i = 0; i != 100; ++i)
+            nodes.push_back(pool.allocate_node());
+
+        for (auto node : nodes)
+            pool.deallocate_node(node);
+    }
+    SUBCASE("background")
+    {
+        realtime_pool<> pool(32u, 4096u, 256u);
+        pool.set_refill_interval(std::chrono::microseconds(100));
+
+        std::vector<void*> nodes;
+        auto               failures = 0;
+        while (nodes.size() != 10000u)
+        {
+            if (auto node = pool.try_allocate_node())
+                nodes.push_back(node);
+            else
+            {
+                // the background thread catches up
+                ++failures;
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+        REQUIRE(failures < 10000);
+
+        for (auto node : nodes)
+            pool.deallocate_node(node);
+        REQUIRE(pool.capacity_left() >= 10000u);
+    }
+    SUBCASE("raw allocator")
+    {
+        realtime_pool<default_allocator, realtime_refill::manual> pool(16u, 1024u, 10u);
+        using traits = allocator_traits<decltype(pool)>;
+        REQUIRE(traits::max_node_size(pool) == 16u);
+
+        auto node = traits::allocate_node(pool, 8u, 8u);
+        traits::deallocate_node(pool, node, 8u, 8u);
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+        REQUIRE_THROWS_AS(traits::allocate_node(pool, 32u, 8u), bad_node_size);
+#endif
+    }
+}
@@ -0,0 +1,94 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "reclamation_service.hpp"
+
+#include <doctest/doctest.h>
+
+#include "allocator_storage.hpp"
+#include "memory_stack.hpp"
+#include "temporary_allocator.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    // waits up to a few seconds for the background thread
+    template <typename Predicate>
+    bool wait_for(Predicate pred)
+    {
+        for (auto i = 0; i != 5000 && !pred(); ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return pred();
+    }
+} // namespace
+
+TEST_CASE("reclamation_service")
+{
+    SUBCASE("run_once")
+    {
+        reclamation_service service(std::chrono::hours(1));
+        REQUIRE(service.period() == std::chrono::hours(1));
+
+        auto calls = 0;
+        auto id    = service.add_reclaimer([&] { ++calls; });
+        service.run_once();
+        REQUIRE(calls == 1);
+        REQUIRE(service.passes() == 1u);
+
+        service.remove_reclaimer(id);
+        service.run_once();
+        REQUIRE(calls == 1);
+        REQUIRE(service.passes() == 2u);
+    }
+    SUBCASE("add_shrink_to_fit")
+    {
+        test_allocator alloc;
+        {
+            memory_stack<allocator_reference<test_allocator>> stack(4096u, alloc);
+            std::mutex                                         mutex;
+
+            reclamation_service service(std::chrono::hours(1));
+            service.add_shrink_to_fit(stack, mutex);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto                        m = stack.top();
+                stack.allocate(3000u, 1u);
+                stack.allocate(3000u, 1u);
+                REQUIRE(alloc.no_allocated() == 2u);
+                stack.unwind(m);
+                REQUIRE(alloc.no_allocated() == 2u);
+            }
+
+            service.run_once();
+            REQUIRE(alloc.no_allocated() == 1u);
+        }
+        REQUIRE(alloc.no_allocated() == 0u);
+    }
+    SUBCASE("temporary stack in use")
+    {
+        reclamation_service service(std::chrono::hours(1));
+
+        // the stack of this thread is skipped instead of waiting for it
+        temporary_allocator alloc;
+        alloc.allocate(16u, 1u);
+        service.run_once();
+        REQUIRE(service.passes() == 1u);
+    }
+    SUBCASE("background")
+    {
+        std::atomic<int> calls(0);
+
+        reclamation_service service(std::chrono::milliseconds(1));
+        service.add_reclaimer([&] { ++calls; });
+        REQUIRE(wait_for([&] { return calls.load() >= 2; }));
+
+        service.set_period(std::chrono::hours(1));
+        REQUIRE(service.period() == std::chrono::hours(1));
+        auto passes = service.passes();
+        service.reclaim_now();
+        REQUIRE(wait_for([&] { return service.passes() > passes; }));
+    }
+}
@@ -0,0 +1,108 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "ring_allocator.hpp"
+
+#include <cstring>
+#include <doctest/doctest.h>
+#include <deque>
+
+#include "allocator_traits.hpp"
+#include "virtual_memory.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    struct node
+    {
+        void*       memory;
+        std::size_t size;
+    };
+
+    void check_ring(ring_allocator& ring)
+    {
+        auto capacity = ring.capacity();
+
+        // allocate and free in queue order, wrapping around several times
+        std::deque<node> queue;
+        std::size_t      total = 0u;
+        for (std::size_t i = 0u; i != 1000u; ++i)
+        {
+            auto size = 100u + (i * 37u) % 900u;
+            while (total + size + 64u > capacity / 2u)
+            {
+                auto front = queue.front();
+                queue.pop_front();
+                REQUIRE(*static_cast<unsigned char*>(front.memory)
+                        == static_cast<unsigned char>(front.size));
+                ring.deallocate_node(front.memory, front.size, 1u);
+                total -= front.size;
+            }
+
+            auto memory = ring.allocate_node(size, 16u);
+            REQUIRE(reinterpret_cast<std::uintptr_t>(memory) % 16u == 0u);
+            // the whole node must be usable, even if it wraps around
+            std::memset(memory, static_cast<unsigned char>(size), size);
+            queue.push_back({memory, size});
+            total += size;
+        }
+
+        while (!queue.empty())
+        {
+            ring.deallocate_node(queue.front().memory, queue.front().size, 1u);
+            queue.pop_front();
+        }
+        REQUIRE(ring.empty());
+        REQUIRE(ring.capacity_left() == capacity);
+    }
+} // namespace
+
+TEST_CASE("ring_allocator")
+{
+    SUBCASE("mirrored")
+    {
+        ring_allocator ring(4096u);
+        REQUIRE(ring.capacity() == virtual_memory_page_size);
+#if defined(__linux__)
+        REQUIRE(ring.is_mirrored());
+#endif
+        check_ring(ring);
+    }
+    SUBCASE("not mirrored")
+    {
+        ring_allocator ring(4096u, false);
+        REQUIRE(!ring.is_mirrored());
+        check_ring(ring);
+    }
+    SUBCASE("out of order")
+    {
+        ring_allocator ring(4096u);
+        auto           a = ring.allocate_node(64u, 8u);
+        auto           b = ring.allocate_node(64u, 8u);
+        auto           c = ring.allocate_node(64u, 8u);
+        auto           left = ring.capacity_left();
+
+        // freeing a newer node does not reclaim it yet
+        ring.deallocate_node(b, 64u, 8u);
+        REQUIRE(ring.capacity_left() == left);
+        ring.deallocate_node(a, 64u, 8u);
+        REQUIRE(ring.capacity_left() == left + 2u * 80u);
+
+        ring.deallocate_node(c, 64u, 8u);
+        REQUIRE(ring.empty());
+    }
+    SUBCASE("full")
+    {
+        ring_allocator ring(4096u);
+        auto           size = ring.max_node_size();
+        auto           a    = ring.allocate_node(size, 1u);
+        REQUIRE(ring.capacity_left() == 0u);
+        REQUIRE(ring.try_allocate_node(1u, 1u) == nullptr);
+
+        int not_owned;
+        REQUIRE(!ring.try_deallocate_node(&not_owned, sizeof(int), alignof(int)));
+        REQUIRE(ring.try_deallocate_node(a, size, 1u));
+        REQUIRE(ring.empty());
+    }
+}
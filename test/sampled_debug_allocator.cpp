@@ -0,0 +1,90 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "sampled_debug_allocator.hpp"
+
+#include <doctest/doctest.h>
+
+#include "detail/align.hpp"
+#include "allocator_storage.hpp"
+#include "debugging.hpp"
+#include "memory_stack.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    const void* invalid_ptr  = nullptr;
+    const void* overflow_ptr = nullptr;
+
+    void record_invalid_ptr(const allocator_info&, const void* ptr)
+    {
+        invalid_ptr = ptr;
+    }
+
+    void record_overflow(const void*, std::size_t, const void* write_ptr)
+    {
+        overflow_ptr = write_ptr;
+    }
+} // namespace
+
+TEST_CASE("sampled_debug_allocator")
+{
+    using allocator_t = sampled_debug_allocator<allocator_reference<test_allocator>>;
+
+    auto old_invalid  = set_invalid_pointer_handler(record_invalid_ptr);
+    auto old_overflow = set_buffer_overflow_handler(record_overflow);
+    invalid_ptr = overflow_ptr = nullptr;
+
+    test_allocator alloc;
+    allocator_t    debug(1u, alloc);
+    REQUIRE(debug.sample_period() == 1u);
+
+    SUBCASE("sampled")
+    {
+        auto node = static_cast<unsigned char*>(debug.allocate_node(10u, 8u));
+        REQUIRE(detail::is_aligned(node, 8u));
+        REQUIRE(alloc.no_allocated() == 1u);
+        for (auto i = 0u; i != 10u; ++i)
+            REQUIRE(node[i] == static_cast<unsigned char>(debug_magic::new_memory));
+
+        // the allocation remembers that it was sampled
+        debug.set_sample_period(0u);
+        node[10] = 0u;
+        debug.deallocate_node(node, 10u, 8u);
+        REQUIRE(overflow_ptr == node + 10);
+        REQUIRE(invalid_ptr == nullptr);
+        REQUIRE(alloc.no_allocated() == 0u);
+        REQUIRE(alloc.last_deallocation_valid());
+    }
+    SUBCASE("not sampled")
+    {
+        debug.set_sample_period(0u);
+        auto array = static_cast<unsigned char*>(debug.allocate_array(4u, 4u, 16u));
+        REQUIRE(detail::is_aligned(array, 16u));
+
+        debug.set_sample_period(1u);
+        debug.deallocate_array(array, 4u, 4u, 16u);
+        REQUIRE(overflow_ptr == nullptr);
+        REQUIRE(alloc.no_allocated() == 0u);
+        REQUIRE(alloc.last_deallocation_valid());
+    }
+    SUBCASE("double deallocation")
+    {
+        // the stack does not reuse the memory, so the header stays intact
+        memory_stack<> stack(1024u);
+        auto           stack_debug =
+            make_sampled_debug_allocator(0u, allocator_reference<memory_stack<>>(stack));
+
+        auto node = stack_debug.allocate_node(32u, 8u);
+        stack_debug.deallocate_node(node, 32u, 8u);
+        REQUIRE(invalid_ptr == nullptr);
+
+        stack_debug.deallocate_node(node, 32u, 8u);
+        REQUIRE(invalid_ptr == node);
+    }
+
+    set_invalid_pointer_handler(old_invalid);
+    set_buffer_overflow_handler(old_overflow);
+}
@@ -0,0 +1,73 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "sampling_tracker.hpp"
+
+#include <doctest/doctest.h>
+#include <string>
+#include <vector>
+
+#include "heap_allocator.hpp"
+#include "tracking.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    std::string read_profile(const heap_profile& profile)
+    {
+        auto file = std::tmpfile();
+        REQUIRE(file);
+        profile.write_pprof(file);
+
+        std::string result;
+        std::rewind(file);
+        for (auto c = std::fgetc(file); c != EOF; c = std::fgetc(file))
+            result += char(c);
+        std::fclose(file);
+        return result;
+    }
+} // namespace
+
+TEST_CASE("sampling_tracker")
+{
+    SUBCASE("all allocations")
+    {
+        heap_profile profile(1u);
+        auto alloc = make_tracked_allocator(sampling_tracker(profile), heap_allocator{});
+
+        auto a = alloc.allocate_node(16u, 8u);
+        auto b = alloc.allocate_node(32u, 8u);
+        auto c = alloc.allocate_array(4u, 8u, 8u);
+        REQUIRE(profile.live_samples() == 3u);
+
+        alloc.deallocate_node(b, 32u, 8u);
+        REQUIRE(profile.live_samples() == 2u);
+
+        auto text = read_profile(profile);
+        REQUIRE(text.compare(0, 27, "heap profile: 2: 48 [3: 80]") == 0);
+        REQUIRE(text.find("@ heap_v2/1\n") != std::string::npos);
+        REQUIRE(text.find("MAPPED_LIBRARIES:") != std::string::npos);
+
+        alloc.deallocate_array(c, 4u, 8u, 8u);
+        alloc.deallocate_node(a, 16u, 8u);
+        REQUIRE(profile.live_samples() == 0u);
+    }
+    SUBCASE("sampled allocations")
+    {
+        heap_profile profile(1024u);
+        REQUIRE(profile.sample_period() == 1024u);
+        auto alloc = make_tracked_allocator(sampling_tracker(profile), heap_allocator{});
+
+        // on average one sample per 16 allocations
+        std::vector<void*> nodes;
+        for (auto i = 0; i != 10000; ++i)
+            nodes.push_back(alloc.allocate_node(64u, 8u));
+        REQUIRE(profile.live_samples() > 300u);
+        REQUIRE(profile.live_samples() < 1000u);
+
+        for (auto node : nodes)
+            alloc.deallocate_node(node, 64u, 8u);
+        REQUIRE(profile.live_samples() == 0u);
+    }
+}
@@ -27,6 +27,19 @@ TEST_CASE("threshold_segregatable")
     REQUIRE(!s.use_allocate_array(1u, 9u, 1u));
 }
 
+TEST_CASE("node_segregatable")
+{
+    using segregatable = node_segregatable<test_allocator>;
+    segregatable s(8u);
+
+    REQUIRE(s.use_allocate_node(1u, 1u));
+    REQUIRE(s.use_allocate_node(8u, 1u));
+    REQUIRE(!s.use_allocate_node(9u, 1u));
+
+    REQUIRE(!s.use_allocate_array(1u, 1u, 1u));
+    REQUIRE(!s.use_allocate_array(2u, 4u, 1u));
+}
+
 TEST_CASE("binary_segregator")
 {
     using segregatable = threshold_segregatable<test_allocator>;
@@ -170,3 +183,68 @@ TEST_CASE("segregator")
     REQUIRE(get_fallback_allocator(s).no_allocated() == 1u);
     s.deallocate_node(ptr, 17, 1);
 }
+
+TEST_CASE("size_class_segregator")
+{
+    using size_class_0 = size_class_segregatable<8, test_allocator>;
+    using size_class_1 = size_class_segregatable<16, test_allocator>;
+    using size_class_2 = size_class_segregatable<32, test_allocator>;
+    using segregator_3 =
+        size_class_segregator<test_allocator, size_class_0, size_class_1, size_class_2>;
+
+    static_assert(size_class_0::max_size == 8u, "");
+    static_assert(std::is_same<decltype(make_size_class_segregator(size_class_0{})),
+                               size_class_segregator<null_allocator, size_class_0>>::value,
+                  "");
+    static_assert(std::is_same<decltype(make_size_class_segregator(size_class_0{},
+                                                                   size_class_1{},
+                                                                   size_class_2{},
+                                                                   test_allocator{})),
+                               segregator_3>::value,
+                  "");
+
+    static_assert(segregator_size<segregator_3>::value == 3, "");
+    static_assert(std::is_same<segregatable_allocator_type<0, segregator_3>, test_allocator>::value,
+                  "");
+    static_assert(std::is_same<segregatable_allocator_type<2, segregator_3>, test_allocator>::value,
+                  "");
+    static_assert(std::is_same<fallback_allocator_type<segregator_3>, test_allocator>::value, "");
+
+    auto s = make_size_class_segregator(size_class<8>(test_allocator{}),
+                                        size_class<16>(test_allocator{}),
+                                        size_class<32>(test_allocator{}), test_allocator{});
+
+    // same allocator as a segregator of threshold_segregatable would choose
+    auto check = [&](std::size_t size, std::size_t expected)
+    {
+        auto ptr = s.allocate_node(size, 1);
+        REQUIRE(get_segregatable_allocator<0>(s).no_allocated() == (expected == 0u ? 1u : 0u));
+        REQUIRE(get_segregatable_allocator<1>(s).no_allocated() == (expected == 1u ? 1u : 0u));
+        REQUIRE(get_segregatable_allocator<2>(s).no_allocated() == (expected == 2u ? 1u : 0u));
+        REQUIRE(get_fallback_allocator(s).no_allocated() == (expected == 3u ? 1u : 0u));
+        s.deallocate_node(ptr, size, 1);
+        REQUIRE(get_segregatable_allocator<0>(s).no_allocated() == 0u);
+        REQUIRE(get_segregatable_allocator<1>(s).no_allocated() == 0u);
+        REQUIRE(get_segregatable_allocator<2>(s).no_allocated() == 0u);
+        REQUIRE(get_fallback_allocator(s).no_allocated() == 0u);
+    };
+    check(0, 0);
+    check(1, 0);
+    check(8, 0);
+    check(9, 1);
+    check(16, 1);
+    check(17, 2);
+    check(32, 2);
+    check(33, 3);
+    check(1024, 3);
+
+    auto ptr = s.allocate_array(2, 8, 1);
+    REQUIRE(get_segregatable_allocator<1>(s).no_allocated() == 1u);
+    s.deallocate_array(ptr, 2, 8, 1);
+    REQUIRE(get_segregatable_allocator<1>(s).no_deallocated() == 3u);
+
+    ptr = s.allocate_array(5, 8, 1);
+    REQUIRE(get_fallback_allocator(s).no_allocated() == 1u);
+    s.deallocate_array(ptr, 5, 8, 1);
+    REQUIRE(get_fallback_allocator(s).no_deallocated() == 3u);
+}
@@ -0,0 +1,56 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "sharded_allocator.hpp"
+
+#include <doctest/doctest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "memory_pool.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("sharded_allocator")
+{
+    using pool = memory_pool<node_pool>;
+    sharded_allocator<pool, 4u> alloc(16u, pool::min_block_size(16u, 64u));
+    REQUIRE(alloc.shard_count() == 4u);
+    REQUIRE(alloc.max_node_size() == 16u);
+
+    auto capacity = alloc.with_shard(0u, [](pool& p) { return p.capacity_left(); });
+
+    SUBCASE("single thread")
+    {
+        auto shard = alloc.current_shard();
+        auto node  = alloc.allocate_node(16u, 1u);
+        REQUIRE(alloc.with_shard(shard, [](pool& p) { return p.capacity_left(); }) < capacity);
+        alloc.deallocate_node(node, 16u, 1u);
+        REQUIRE(alloc.with_shard(shard, [](pool& p) { return p.capacity_left(); }) == capacity);
+
+        int other;
+        REQUIRE(!alloc.try_deallocate_node(&other, 16u, 1u));
+    }
+    SUBCASE("threads")
+    {
+        std::vector<void*>       nodes(4u);
+        std::vector<std::thread> threads;
+        for (auto i = 0u; i != 4u; ++i)
+            threads.emplace_back(
+                [&, i]
+                {
+                    for (auto j = 0u; j != 1000u; ++j)
+                        alloc.deallocate_node(alloc.allocate_node(16u, 1u), 16u, 1u);
+                    nodes[i] = alloc.allocate_node(16u, 1u);
+                });
+        for (auto& thread : threads)
+            thread.join();
+
+        // deallocated on another thread
+        for (auto node : nodes)
+            alloc.deallocate_node(node, 16u, 1u);
+        for (auto i = 0u; i != alloc.shard_count(); ++i)
+            REQUIRE(alloc.with_shard(i, [](pool& p) { return p.capacity_left(); }) == capacity);
+    }
+}
@@ -0,0 +1,83 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "shared_memory.hpp"
+
+#include <doctest/doctest.h>
+
+#include <vector>
+
+#include "memory_stack.hpp"
+#include "virtual_memory.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("offset_ptr")
+{
+    int array[4] = {0, 1, 2, 3};
+
+    offset_ptr<int> a(array);
+    REQUIRE(a);
+    REQUIRE(a.get() == array);
+    REQUIRE(a[2] == 2);
+    REQUIRE(*(a + 3) == 3);
+
+    // the copy points to the same object
+    offset_ptr<int> b(a);
+    ++b;
+    REQUIRE(b.get() == array + 1);
+    REQUIRE(b - a == 1);
+    REQUIRE(a < b);
+
+    offset_ptr<const int> c = b;
+    REQUIRE(c == b);
+    offset_ptr<void> v(a);
+    REQUIRE(static_cast<offset_ptr<int>>(v) == a);
+
+    offset_ptr<int> null;
+    REQUIRE(!null);
+    REQUIRE(null == nullptr);
+    REQUIRE(null.get() == nullptr);
+}
+
+TEST_CASE("shared_memory_block_allocator")
+{
+    const char* name       = "/foonathan_memory_test_shared_memory";
+    auto        block_size = 4u * virtual_memory_page_size;
+    shared_memory_block_allocator::remove(name);
+
+    using stack_t  = memory_stack<shared_memory_block_allocator>;
+    using vector_t = std::vector<int, offset_std_allocator<int, stack_t>>;
+
+    stack_t stack(block_size, 4u, name);
+    REQUIRE(stack.get_allocator().capacity_left() == 3u);
+    REQUIRE(stack.get_allocator().size() == block_size);
+
+    // build a vector inside the shared memory
+    auto vec = ::new (stack.allocate(sizeof(vector_t), alignof(vector_t))) vector_t(stack);
+    for (auto i = 0; i != 100; ++i)
+        vec->push_back(i);
+    auto offset = static_cast<char*>(static_cast<void*>(vec))
+                  - static_cast<char*>(stack.get_allocator().memory());
+
+    {
+        // map it a second time at a different address and read the vector
+        shared_memory_block_allocator reader(block_size, 4u, name);
+        REQUIRE(reader.memory() != stack.get_allocator().memory());
+        REQUIRE(reader.size() == block_size);
+
+        auto& copy = *static_cast<vector_t*>(
+            static_cast<void*>(static_cast<char*>(reader.memory()) + offset));
+        REQUIRE(copy.size() == 100u);
+        REQUIRE(static_cast<void*>(copy.data()) != static_cast<void*>(vec->data()));
+        for (auto i = 0; i != 100; ++i)
+            REQUIRE(copy[std::size_t(i)] == i);
+
+        // writes are visible to the other mapping
+        copy[50] = -1;
+        REQUIRE((*vec)[50] == -1);
+    }
+
+    vec->~vector_t();
+    REQUIRE(shared_memory_block_allocator::remove(name));
+}
@@ -0,0 +1,60 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "shared_ptr_pool.hpp"
+
+#include <doctest/doctest.h>
+
+#include <thread>
+#include <vector>
+
+#include "thread_cached_pool.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("shared_ptr_pool")
+{
+    SUBCASE("memory_pool")
+    {
+        shared_ptr_pool<int> pool(shared_ptr_pool<int>::min_block_size(16u));
+        REQUIRE(pool.get_allocator().node_size() >= shared_ptr_pool<int>::node_size);
+
+        auto& alloc    = pool.get_allocator();
+        auto  capacity = alloc.capacity_left();
+        {
+            auto ptr = pool.make_shared(42);
+            REQUIRE(*ptr == 42);
+            REQUIRE(alloc.capacity_left() == capacity - alloc.node_size());
+
+            std::weak_ptr<int> weak = ptr;
+            ptr.reset();
+            REQUIRE(weak.expired());
+            // the control block stays alive for the weak pointer
+            REQUIRE(alloc.capacity_left() < capacity);
+        }
+        REQUIRE(alloc.capacity_left() == capacity);
+
+        std::vector<std::shared_ptr<int>> ptrs;
+        for (auto i = 0; i != 16; ++i)
+            ptrs.push_back(pool.make_shared(i));
+        REQUIRE(alloc.capacity_left() == 0u);
+        ptrs.clear();
+        REQUIRE(alloc.capacity_left() == capacity);
+    }
+    SUBCASE("thread_cached_pool")
+    {
+        using pool_type = shared_ptr_pool<int, thread_cached_pool<>>;
+        pool_type pool(pool_type::min_block_size(256u));
+
+        std::vector<std::shared_ptr<int>> ptrs;
+        for (auto i = 0; i != 100; ++i)
+            ptrs.push_back(pool.make_shared(i));
+
+        // destroyed on another thread
+        std::thread([&] { ptrs.clear(); }).join();
+        REQUIRE(ptrs.empty());
+
+        auto ptr = pool.make_shared(1);
+        REQUIRE(*ptr == 1);
+    }
+}
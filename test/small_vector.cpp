@@ -0,0 +1,101 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "small_vector.hpp"
+
+#include <algorithm>
+#include <doctest/doctest.h>
+#include <string>
+
+#include "memory_stack.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("small_vector")
+{
+    SUBCASE("inline")
+    {
+        test_allocator alloc;
+        {
+            small_vector<std::string, 4u, test_allocator> vec(alloc);
+            REQUIRE(vec.empty());
+            REQUIRE(vec.capacity() == 4u);
+            REQUIRE(vec.is_inline());
+
+            for (auto i = 0; i != 4; ++i)
+                vec.emplace_back(std::size_t(i), 'a');
+            REQUIRE(vec.size() == 4u);
+            REQUIRE(vec.is_inline());
+            REQUIRE(vec[3] == "aaa");
+
+            REQUIRE(*vec.emplace(vec.begin(), "b") == "b");
+            REQUIRE(!vec.is_inline());
+            REQUIRE(vec.capacity() == 8u);
+            REQUIRE(alloc.no_allocated() == 1u);
+            const std::string spilled[] = {"b", "", "a", "aa", "aaa"};
+            REQUIRE(std::equal(vec.begin(), vec.end(), spilled));
+
+            REQUIRE(*vec.erase(vec.begin(), vec.begin() + 2) == "a");
+            vec.shrink_to_fit();
+            REQUIRE(vec.is_inline());
+            REQUIRE(vec.capacity() == 4u);
+            REQUIRE(alloc.no_allocated() == 0u);
+            const std::string shrunk[] = {"a", "aa", "aaa"};
+            REQUIRE(std::equal(vec.begin(), vec.end(), shrunk));
+        }
+        REQUIRE(alloc.no_allocated() == 0u);
+        REQUIRE(alloc.last_deallocation_valid());
+    }
+    SUBCASE("growth in place")
+    {
+        memory_stack<> stack(4096u);
+
+        small_vector<int, 8u, memory_stack<>> vec(stack);
+        for (auto i = 0; i != 9; ++i)
+            vec.push_back(i);
+        REQUIRE(!vec.is_inline());
+        auto data = vec.data();
+
+        for (auto i = 9; i != 100; ++i)
+            vec.push_back(vec[std::size_t(i - 1)] + 1);
+        REQUIRE(vec.data() == data);
+        for (auto i = 0; i != 100; ++i)
+            REQUIRE(vec[std::size_t(i)] == i);
+    }
+    SUBCASE("move")
+    {
+        test_allocator alloc;
+        {
+            small_vector<int, 2u, test_allocator> a(alloc);
+            a.push_back(1);
+
+            // inline elements are moved
+            small_vector<int, 2u, test_allocator> b(std::move(a));
+            REQUIRE(a.empty());
+            REQUIRE(b.is_inline());
+            REQUIRE(b.size() == 1u);
+            REQUIRE(b[0] == 1);
+
+            // allocated memory is taken over
+            b.push_back(2);
+            b.push_back(3);
+            auto data = b.data();
+            a         = std::move(b);
+            REQUIRE(a.data() == data);
+            REQUIRE(a.size() == 3u);
+            REQUIRE(b.is_inline());
+            REQUIRE(b.empty());
+            REQUIRE(&a.get_allocator() == &alloc);
+
+            b.push_back(4);
+            a = std::move(b);
+            REQUIRE(a.is_inline());
+            REQUIRE(a.size() == 1u);
+            REQUIRE(a[0] == 4);
+            REQUIRE(alloc.no_allocated() == 0u);
+        }
+        REQUIRE(alloc.no_allocated() == 0u);
+        REQUIRE(alloc.last_deallocation_valid());
+    }
+}
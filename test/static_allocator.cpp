@@ -0,0 +1,47 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "static_allocator.hpp"
+
+#include <doctest/doctest.h>
+
+#include "detail/align.hpp"
+#include "allocator_storage.hpp"
+
+using namespace foonathan::memory;
+
+// the layout of a table can be checked at compile time
+using table_stack = inline_stack<256u, 16u>;
+static_assert(table_stack::next_top(table_stack::next_top(0u, 24u, 8u), 64u, 16u) <= 256u, "");
+static_assert(table_stack::capacity() == 256u, "");
+
+TEST_CASE("inline_stack")
+{
+    table_stack stack;
+    REQUIRE(stack.capacity_left() == 256u);
+    REQUIRE(stack.max_alignment() == 16u);
+
+    auto a = stack.allocate_node(24u, 8u);
+    REQUIRE(detail::is_aligned(a, 8u));
+    REQUIRE(stack.top() == table_stack::next_top(0u, 24u, 8u));
+
+    auto m = stack.top();
+    auto b = stack.allocate_node<64u, 16u>();
+    REQUIRE(detail::is_aligned(b, 16u));
+    REQUIRE(stack.top() == table_stack::next_top(m, 64u, 16u));
+    REQUIRE(static_cast<char*>(b) >= static_cast<char*>(a) + 24u);
+
+    REQUIRE(!stack.try_allocate_node(1024u, 1u));
+    REQUIRE(!stack.try_allocate_node(std::size_t(-1), 1u));
+
+    stack.unwind(m);
+    REQUIRE(stack.try_allocate_node(64u, 16u) == b);
+
+    stack.reset();
+    REQUIRE(stack.capacity_left() == 256u);
+    REQUIRE(stack.allocate_node(24u, 8u) == a);
+
+    // can be used through the allocator interface
+    auto ref = make_allocator_reference(stack);
+    REQUIRE(ref.allocate_node(8u, 8u));
+}
@@ -0,0 +1,133 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "statistics_tracker.hpp"
+
+#include <doctest/doctest.h>
+#include <thread>
+#include <vector>
+
+#include "memory_pool.hpp"
+#include "tracking.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("allocation_statistics")
+{
+    allocation_statistics statistics;
+
+    auto snapshot = statistics.snapshot();
+    REQUIRE(snapshot.allocations == 0u);
+    REQUIRE(snapshot.live_bytes == 0u);
+    REQUIRE(snapshot.peak_bytes == 0u);
+
+    statistics.on_allocate(1u);
+    statistics.on_allocate(3u);
+    statistics.on_allocate(4u);
+    statistics.on_allocate(std::size_t(1) << 40);
+    statistics.on_deallocate(4u);
+
+    snapshot = statistics.snapshot();
+    REQUIRE(snapshot.allocations == 4u);
+    REQUIRE(snapshot.deallocations == 1u);
+    REQUIRE(snapshot.live_bytes == (std::size_t(1) << 40) + 4u);
+    REQUIRE(snapshot.peak_bytes == (std::size_t(1) << 40) + 8u);
+    REQUIRE(snapshot.histogram[0] == 1u);
+    REQUIRE(snapshot.histogram[2] == 2u);
+    REQUIRE(snapshot.histogram[allocation_histogram_size - 1u] == 1u);
+
+    statistics.on_deallocate(std::size_t(1) << 40);
+    snapshot = statistics.snapshot();
+    REQUIRE(snapshot.live_bytes == 4u);
+    REQUIRE(snapshot.peak_bytes == (std::size_t(1) << 40) + 8u);
+
+    SUBCASE("multiple threads")
+    {
+        std::vector<std::thread> threads;
+        for (auto i = 0; i != 4; ++i)
+            threads.emplace_back([&] {
+                for (auto j = 0; j != 1000; ++j)
+                    statistics.on_allocate(16u);
+                for (auto j = 0; j != 1000; ++j)
+                    statistics.on_deallocate(16u);
+            });
+        for (auto& thread : threads)
+            thread.join();
+
+        snapshot = statistics.snapshot();
+        REQUIRE(snapshot.allocations == 4004u);
+        REQUIRE(snapshot.deallocations == 4002u);
+        REQUIRE(snapshot.live_bytes == 4u);
+        REQUIRE(snapshot.histogram[4] == 4000u);
+    }
+}
+
+TEST_CASE("statistics_tracker")
+{
+    allocation_statistics statistics;
+    {
+        using pool = memory_pool<node_pool>;
+        auto alloc = make_deeply_tracked_allocator<pool>(statistics_tracker(statistics), 16u,
+                                                         pool::min_block_size(16u, 10u));
+        REQUIRE(&alloc.get_tracker().get_statistics() == &statistics);
+
+        auto snapshot = statistics.snapshot();
+        REQUIRE(snapshot.growths == 0u); // first block is allocated before the tracker is set
+
+        void* nodes[20];
+        for (auto& node : nodes)
+            node = alloc.allocate_node(16u, 1u);
+        auto array = alloc.allocate_array(2u, 16u, 1u);
+
+        snapshot = statistics.snapshot();
+        REQUIRE(snapshot.allocations == 21u);
+        REQUIRE(snapshot.live_bytes == 22u * 16u);
+        REQUIRE(snapshot.histogram[4] == 20u);
+        REQUIRE(snapshot.histogram[5] == 1u);
+        REQUIRE(snapshot.growths >= 1u);
+        REQUIRE(snapshot.block_bytes > 0u);
+
+        alloc.deallocate_array(array, 2u, 16u, 1u);
+        for (auto node : nodes)
+            alloc.deallocate_node(node, 16u, 1u);
+
+        snapshot = statistics.snapshot();
+        REQUIRE(snapshot.deallocations == 21u);
+        REQUIRE(snapshot.live_bytes == 0u);
+        // peak is only updated in steps of peak_granularity
+        REQUIRE(snapshot.peak_bytes <= 22u * 16u);
+    }
+    auto snapshot = statistics.snapshot();
+    REQUIRE(snapshot.shrinks < snapshot.growths + 1u);
+}
+
+TEST_CASE("write_statistics")
+{
+    allocation_statistics statistics;
+    statistics.on_allocate(16u);
+    statistics.on_allocate(100u);
+    statistics.on_growth(4096u);
+    auto snapshot = statistics.snapshot();
+
+    auto file = std::tmpfile();
+    REQUIRE(file);
+    REQUIRE(write_statistics(file, snapshot));
+    std::rewind(file);
+
+    allocation_statistics_snapshot read;
+    REQUIRE(read_statistics(file, read));
+    REQUIRE(read.allocations == 2u);
+    REQUIRE(read.bytes_allocated == 116u);
+    REQUIRE(read.live_bytes == snapshot.live_bytes);
+    REQUIRE(read.peak_bytes == snapshot.peak_bytes);
+    REQUIRE(read.growths == 1u);
+    REQUIRE(read.block_bytes == 4096u);
+    for (std::size_t i = 0u; i != allocation_histogram_size; ++i)
+        REQUIRE(read.histogram[i] == snapshot.histogram[i]);
+
+    std::rewind(file);
+    std::fputs("not a statistics file\n", file);
+    std::rewind(file);
+    REQUIRE(!read_statistics(file, read));
+    std::fclose(file);
+}
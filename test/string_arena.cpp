@@ -0,0 +1,93 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "string_arena.hpp"
+
+#include <doctest/doctest.h>
+#include <string>
+
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("string_ref")
+{
+    string_ref empty;
+    REQUIRE(empty.empty());
+    REQUIRE(*empty.c_str() == '\0');
+
+    std::string str = "hello";
+    string_ref  ref = str;
+    REQUIRE(ref.size() == 5u);
+    REQUIRE(ref == "hello");
+    REQUIRE(ref != "hell");
+    REQUIRE(string_ref("hell") < ref);
+    REQUIRE(ref < "help");
+    REQUIRE(!(ref < ref));
+    REQUIRE(ref.str() == str);
+    REQUIRE(string_ref_hash()(ref) == string_ref_hash()("hello"));
+}
+
+TEST_CASE("string_arena")
+{
+    string_arena<> arena(4096u);
+    REQUIRE(arena.stats().used_bytes == 0u);
+
+    auto a = arena.store("hello");
+    auto b = arena.store(std::string("world"));
+    auto c = arena.store("");
+    REQUIRE(a == "hello");
+    REQUIRE(a.c_str()[5] == '\0');
+    REQUIRE(b == "world");
+    REQUIRE(c.empty());
+    // stored contiguously
+    REQUIRE(b.data() >= a.data() + 6);
+
+    auto marker = arena.top();
+    auto d      = arena.store("temporary");
+    arena.unwind(marker);
+    REQUIRE(arena.store("other").data() == d.data());
+    REQUIRE(a == "hello");
+
+    std::string long_string(3000u, 'x');
+    REQUIRE(arena.store(long_string) == long_string);
+
+    arena.clear();
+    REQUIRE(arena.store("again").data() == a.data());
+}
+
+TEST_CASE("string_interner")
+{
+    test_allocator alloc;
+    {
+        string_interner<default_allocator, test_allocator> interner(4096u, alloc);
+
+        std::string hello = "hello";
+        auto        a     = interner.intern(hello);
+        REQUIRE(a == "hello");
+        REQUIRE(a.data() != hello.data());
+        REQUIRE(interner.intern("hello").data() == a.data());
+        REQUIRE(interner.find("hello").data() == a.data());
+        REQUIRE(interner.find("world").data() == nullptr);
+        REQUIRE(interner.size() == 1u);
+
+        auto marker = interner.top();
+        auto b      = interner.intern("world");
+        for (auto i = 0; i != 100; ++i)
+            interner.intern(std::to_string(i));
+        REQUIRE(interner.size() == 102u);
+        REQUIRE(interner.intern("world").data() == b.data());
+
+        interner.unwind(marker);
+        REQUIRE(interner.size() == 1u);
+        REQUIRE(interner.find("world").data() == nullptr);
+        REQUIRE(interner.find("42").data() == nullptr);
+        REQUIRE(interner.intern("hello").data() == a.data());
+
+        interner.clear();
+        REQUIRE(interner.size() == 0u);
+        REQUIRE(interner.find("hello").data() == nullptr);
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+    REQUIRE(alloc.last_deallocation_valid());
+}
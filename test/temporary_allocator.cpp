@@ -0,0 +1,123 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "temporary_allocator.hpp"
+
+#include <doctest/doctest.h>
+#include <memory>
+#include <thread>
+
+using namespace foonathan::memory;
+
+TEST_CASE("temporary_allocator")
+{
+    temporary_allocator alloc;
+    auto                a = alloc.allocate(16u, 1u);
+    REQUIRE(a);
+    {
+        temporary_allocator nested;
+        REQUIRE(nested.is_active());
+        REQUIRE(!alloc.is_active());
+        REQUIRE(nested.allocate(16u, 1u) != a);
+    }
+    REQUIRE(alloc.is_active());
+}
+
+TEST_CASE("bind_temporary_stack")
+{
+    temporary_stack task_stack(4096u);
+    REQUIRE(bind_temporary_stack(nullptr) == nullptr);
+
+    // a task that suspends with an active allocator and resumes on another thread
+    std::unique_ptr<temporary_allocator> alloc;
+    std::thread(
+        [&]
+        {
+            temporary_stack_binding binding(task_stack);
+            REQUIRE(&get_current_temporary_stack() == &task_stack);
+            alloc.reset(new temporary_allocator);
+            REQUIRE(&alloc->get_stack() == &task_stack);
+            alloc->allocate(16u, 1u);
+        })
+        .join();
+    std::thread(
+        [&]
+        {
+            temporary_stack_binding binding(task_stack);
+            REQUIRE(alloc->is_active());
+
+            temporary_allocator nested;
+            REQUIRE(nested.is_active());
+            REQUIRE(!alloc->is_active());
+        })
+        .join();
+    REQUIRE(alloc->is_active());
+    alloc.reset();
+
+    SUBCASE("provider")
+    {
+        static temporary_stack* provided = nullptr;
+        provided                         = &task_stack;
+        REQUIRE(set_temporary_stack_provider([] { return provided; }) == nullptr);
+
+        temporary_allocator provided_alloc;
+        REQUIRE(&provided_alloc.get_stack() == &task_stack);
+        {
+            // a bound stack takes precedence
+            temporary_stack         other(4096u);
+            temporary_stack_binding binding(other);
+            REQUIRE(&get_current_temporary_stack() == &other);
+        }
+
+        set_temporary_stack_provider(nullptr);
+    }
+}
+
+#if FOONATHAN_MEMORY_TEMPORARY_STACK_MODE >= 2
+TEST_CASE("reserve_temporary_stacks")
+{
+    const auto size = 1024u * 1024u;
+    reserve_temporary_stacks(1u, size, true);
+
+    // a new thread adopts the reserved stack instead of creating a small one
+    temporary_stack* stack         = nullptr;
+    std::size_t      next_capacity = 0u;
+    std::thread(
+        [&]
+        {
+            stack         = &get_temporary_stack(4096u);
+            next_capacity = stack->next_capacity();
+
+            temporary_allocator alloc;
+            alloc.allocate(size / 2u, 1u);
+        })
+        .join();
+    REQUIRE(next_capacity > size);
+
+    // and the next thread adopts it again, as it is unused after the thread exited
+    temporary_stack* next_stack = nullptr;
+    std::thread([&] { next_stack = &get_temporary_stack(4096u); }).join();
+    REQUIRE(next_stack == stack);
+}
+#endif
+
+TEST_CASE("inline_temporary_allocator")
+{
+    inline_temporary_allocator<256u> alloc;
+    REQUIRE(alloc.capacity_left() == 256u);
+
+    auto a = alloc.allocate_node(16u, 1u);
+    REQUIRE(a);
+    REQUIRE(!alloc.uses_fallback());
+    REQUIRE(alloc.capacity_left() < 256u);
+    REQUIRE(alloc.try_expand_node(a, 16u, 32u, 1u));
+    REQUIRE(!alloc.try_expand_node(a, 32u, 1024u, 1u));
+
+#if FOONATHAN_MEMORY_TEMPORARY_STACK_MODE != 0
+    auto b = alloc.allocate_node(1024u, 1u);
+    REQUIRE(b);
+    REQUIRE(b != a);
+    REQUIRE(alloc.uses_fallback());
+    REQUIRE(alloc.try_expand_node(b, 1024u, 1040u, 1u));
+#endif
+}
@@ -6,6 +6,7 @@
 
 #include <unordered_map>
 
+#include <foonathan/memory/detail/debug_helpers.hpp>
 #include <foonathan/memory/heap_allocator.hpp>
 
 struct memory_info
@@ -85,4 +86,15 @@ private:
     bool                                   last_valid_    = true;
 };
 
+// whether or not the library poisons memory,
+// i.e. FOONATHAN_MEMORY_DEBUG_POISON is enabled and it is compiled with AddressSanitizer
+inline bool poisoning_active() noexcept
+{
+    alignas(8) unsigned char probe[8] = {};
+    foonathan::memory::detail::debug_poison(probe, sizeof(probe));
+    auto result = foonathan::memory::detail::debug_is_poisoned(probe);
+    foonathan::memory::detail::debug_unpoison(probe, sizeof(probe));
+    return result;
+}
+
 #endif //FOONATHAN_MEMORY_TEST_TEST_ALLOCATOR_HPP
@@ -0,0 +1,132 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "thread_cached_pool.hpp"
+
+#include <algorithm>
+#include <doctest/doctest.h>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "container.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("thread_cached_pool")
+{
+    using pool_type =
+        thread_cached_pool<node_pool, allocator_reference<test_allocator>, std::mutex, 8u>;
+    test_allocator alloc;
+    {
+        pool_type pool(16u, pool_type::min_block_size(16u, 100u), alloc);
+        REQUIRE(pool.node_size() >= 16u);
+        REQUIRE(alloc.no_allocated() == 1u);
+
+        SUBCASE("single thread")
+        {
+            auto capacity = pool.capacity_left();
+
+            std::vector<void*> ptrs;
+            for (auto i = 0u; i != 50u; ++i)
+                ptrs.push_back(pool.allocate_node());
+            REQUIRE(pool.thread_cache_size() < pool_type::magazine_size);
+            REQUIRE(pool.capacity_left() < capacity);
+
+            std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{});
+            for (auto ptr : ptrs)
+                pool.deallocate_node(ptr);
+            REQUIRE(pool.thread_cache_size() <= pool_type::magazine_size);
+
+            pool.flush_thread_cache();
+            REQUIRE(pool.thread_cache_size() == 0u);
+            REQUIRE(pool.capacity_left() == capacity);
+            REQUIRE(alloc.no_allocated() == 1u);
+        }
+        SUBCASE("multiple threads")
+        {
+            auto capacity = pool.capacity_left();
+
+            std::vector<std::thread> threads;
+            for (auto t = 0u; t != 4u; ++t)
+                threads.emplace_back([&] {
+                    std::vector<void*> ptrs;
+                    for (auto round = 0u; round != 10u; ++round)
+                    {
+                        for (auto i = 0u; i != 40u; ++i)
+                            ptrs.push_back(pool.allocate_node());
+                        for (auto ptr : ptrs)
+                            pool.deallocate_node(ptr);
+                        ptrs.clear();
+                    }
+                });
+            for (auto& thread : threads)
+                thread.join();
+
+            // the magazines of exited threads are orphaned until they are flushed
+            REQUIRE(pool.flush_orphaned_caches() <= 4u);
+            REQUIRE(pool.flush_orphaned_caches() == 0u);
+            REQUIRE(pool.capacity_left() >= capacity);
+        }
+        SUBCASE("orphaned magazine")
+        {
+            auto capacity = pool.capacity_left();
+
+            void* node = nullptr;
+            std::thread([&] {
+                node = pool.allocate_node();
+                pool.deallocate_node(node);
+            }).join();
+            // the exited thread kept its nodes
+            REQUIRE(pool.capacity_left() < capacity);
+
+            // the next thread adopts them
+            std::size_t adopted = 0u;
+            void*       reused  = nullptr;
+            std::thread([&] {
+                adopted = pool.thread_cache_size();
+                reused  = pool.allocate_node();
+                pool.deallocate_node(reused);
+            }).join();
+            REQUIRE(adopted == pool_type::magazine_size / 2u);
+            REQUIRE(reused == node);
+
+            REQUIRE(pool.flush_orphaned_caches() == 1u);
+            REQUIRE(pool.capacity_left() == capacity);
+        }
+        SUBCASE("cross thread deallocation")
+        {
+            std::vector<void*> ptrs;
+            for (auto i = 0u; i != 20u; ++i)
+                ptrs.push_back(pool.allocate_node());
+
+            std::thread([&] {
+                for (auto ptr : ptrs)
+                    pool.deallocate_node(ptr);
+            }).join();
+        }
+        SUBCASE("container")
+        {
+            pool_type list_pool(list_node_size<int>::value,
+                                pool_type::min_block_size(list_node_size<int>::value, 50u), alloc);
+            list<int, pool_type> l(list_pool);
+            for (auto i = 0; i != 100; ++i)
+                l.push_back(i);
+            REQUIRE(l.size() == 100u);
+        }
+        SUBCASE("composable")
+        {
+            using traits = composable_allocator_traits<pool_type>;
+            auto node    = traits::try_allocate_node(pool, pool.node_size(), 1u);
+            REQUIRE(node);
+            REQUIRE(traits::try_deallocate_node(pool, node, pool.node_size(), 1u));
+            REQUIRE(!traits::try_allocate_node(pool, 2 * pool.node_size(), 1u));
+
+            int not_owned;
+            REQUIRE(!traits::try_deallocate_node(pool, &not_owned, pool.node_size(), 1u));
+        }
+    }
+    REQUIRE(alloc.no_allocated() == 0u);
+}
@@ -0,0 +1,62 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "thread_local_reference.hpp"
+
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <list>
+#include <thread>
+#include <vector>
+
+#include "std_allocator.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("thread_local_reference")
+{
+    using reference = thread_local_reference<test_allocator>;
+    using list      = std::list<int, std_allocator<int, reference>>;
+    static_assert(std::is_empty<std_allocator<int, reference>>::value, "");
+    static_assert(sizeof(list) < sizeof(std::list<int, std_allocator<int, test_allocator>>), "");
+
+    REQUIRE(!reference::is_bound());
+
+    test_allocator outer;
+    {
+        reference::binding bind_outer(outer);
+        REQUIRE(reference::is_bound());
+        REQUIRE(&reference::get_allocator() == &outer);
+
+        std::vector<list> lists(2u);
+        lists[0].push_back(1);
+        lists[1].push_back(2);
+        lists[1].push_back(3);
+        REQUIRE(outer.no_allocated() == 3u);
+
+        test_allocator inner;
+        {
+            reference::binding bind_inner(inner);
+            REQUIRE(&reference::get_allocator() == &inner);
+
+            list l;
+            l.push_back(4);
+            REQUIRE(inner.no_allocated() == 1u);
+            REQUIRE(outer.no_allocated() == 3u);
+        }
+        REQUIRE(inner.no_allocated() == 0u);
+        REQUIRE(&reference::get_allocator() == &outer);
+
+        // other threads have their own binding
+        std::atomic<bool> other_bound(true);
+        std::thread([&] { other_bound = reference::is_bound(); }).join();
+        REQUIRE(!other_bound);
+
+        lists.clear();
+        REQUIRE(outer.no_allocated() == 0u);
+        REQUIRE(outer.last_deallocation_valid());
+    }
+    REQUIRE(!reference::is_bound());
+}
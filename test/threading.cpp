@@ -0,0 +1,68 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "threading.hpp"
+
+#include <doctest/doctest.h>
+#include <thread>
+#include <vector>
+
+#include "allocator_storage.hpp"
+#include "memory_pool.hpp"
+
+using namespace foonathan::memory;
+
+template <class Mutex>
+void check_mutex()
+{
+    Mutex mutex;
+    REQUIRE(mutex.try_lock());
+    REQUIRE(!mutex.try_lock());
+    mutex.unlock();
+
+    std::size_t              counter = 0u;
+    std::vector<std::thread> threads;
+    for (auto i = 0u; i != 4u; ++i)
+        threads.emplace_back(
+            [&]
+            {
+                for (auto j = 0u; j != 10000u; ++j)
+                {
+                    std::lock_guard<Mutex> lock(mutex);
+                    ++counter;
+                }
+            });
+    for (auto& thread : threads)
+        thread.join();
+    REQUIRE(counter == 40000u);
+}
+
+TEST_CASE("spin_mutex")
+{
+    static_assert(alignof(spin_mutex) == 64u, "");
+    check_mutex<spin_mutex>();
+}
+
+TEST_CASE("adaptive_mutex")
+{
+    check_mutex<adaptive_mutex>();
+}
+
+TEST_CASE("thread_safe_allocator with spin_mutex")
+{
+    using pool = memory_pool<node_pool>;
+    thread_safe_allocator<pool, spin_mutex> alloc(pool(16u, pool::min_block_size(16u, 64u)));
+    auto                                    capacity = alloc.lock()->capacity_left();
+
+    std::vector<std::thread> threads;
+    for (auto i = 0u; i != 4u; ++i)
+        threads.emplace_back(
+            [&]
+            {
+                for (auto j = 0u; j != 1000u; ++j)
+                    alloc.deallocate_node(alloc.allocate_node(16u, 1u), 16u, 1u);
+            });
+    for (auto& thread : threads)
+        thread.join();
+    REQUIRE(alloc.lock()->capacity_left() == capacity);
+}
@@ -0,0 +1,127 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "tlsf_allocator.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <doctest/doctest.h>
+#include <random>
+#include <vector>
+
+#include "allocator_traits.hpp"
+#include "fallback_allocator.hpp"
+#include "segregator.hpp"
+#include "static_allocator.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    struct node
+    {
+        unsigned char* memory;
+        std::size_t    size;
+    };
+} // namespace
+
+TEST_CASE("tlsf_allocator")
+{
+    tlsf_allocator<> alloc(64u * 1024u);
+    auto             capacity = alloc.capacity_left();
+    REQUIRE(capacity > 60u * 1024u);
+    REQUIRE(alloc.max_node_size() >= 60u * 1024u);
+    static_assert(is_composable_allocator<tlsf_allocator<>>::value, "");
+
+    SUBCASE("split and merge")
+    {
+        auto a = alloc.allocate_node(1u, 1u);
+        auto b = alloc.allocate_node(100u, 8u);
+        auto c = alloc.allocate_node(1000u, 16u);
+        REQUIRE(detail::is_aligned(b, 8u));
+        REQUIRE(detail::is_aligned(c, 16u));
+        REQUIRE(alloc.capacity_left() < capacity - 1100u);
+
+        // the free block in the middle is merged with both neighbors
+        alloc.deallocate_node(a, 1u, 1u);
+        alloc.deallocate_node(c, 1000u, 16u);
+        alloc.deallocate_node(b, 100u, 8u);
+        REQUIRE(alloc.capacity_left() == capacity);
+
+        auto big = alloc.try_allocate_node(capacity - capacity / 8u, 1u);
+        REQUIRE(big);
+        alloc.deallocate_node(big, capacity - capacity / 8u, 1u);
+        REQUIRE(alloc.capacity_left() == capacity);
+    }
+    SUBCASE("random order")
+    {
+        std::mt19937      engine(42u);
+        std::vector<node> nodes;
+        for (auto round = 0; round != 8; ++round)
+        {
+            for (std::size_t i = 0u; i != 200u; ++i)
+            {
+                auto size = std::size_t(1u) + engine() % 500u;
+                auto mem  = static_cast<unsigned char*>(alloc.allocate_node(size, 1u));
+                std::memset(mem, static_cast<unsigned char>(size), size);
+                nodes.push_back({mem, size});
+            }
+
+            std::shuffle(nodes.begin(), nodes.end(), engine);
+            for (auto half = nodes.size() / 2u; nodes.size() != half;)
+            {
+                auto n = nodes.back();
+                nodes.pop_back();
+                for (std::size_t j = 0u; j != n.size; ++j)
+                    REQUIRE(n.memory[j] == static_cast<unsigned char>(n.size));
+                alloc.deallocate_node(n.memory, n.size, 1u);
+            }
+        }
+
+        for (auto& n : nodes)
+        {
+            REQUIRE(n.memory[n.size - 1u] == static_cast<unsigned char>(n.size));
+            alloc.deallocate_node(n.memory, n.size, 1u);
+        }
+        REQUIRE(alloc.capacity_left() > capacity);
+    }
+    SUBCASE("growth")
+    {
+        auto size = alloc.max_node_size();
+        auto big  = alloc.allocate_node(size, 1u);
+        auto left = alloc.capacity_left();
+        auto node = allocator_traits<tlsf_allocator<>>::allocate_array(alloc, 100u, 4u, 4u);
+        REQUIRE(alloc.capacity_left() <= left);
+        allocator_traits<tlsf_allocator<>>::deallocate_array(alloc, node, 100u, 4u, 4u);
+        alloc.deallocate_node(big, size, 1u);
+
+        tlsf_allocator<> moved(detail::move(alloc));
+        auto             mem = moved.allocate_node(10u, 8u);
+        moved.deallocate_node(mem, 10u, 8u);
+    }
+}
+
+TEST_CASE("tlsf_allocator composable")
+{
+    static_allocator_storage<4096u> storage;
+    using alloc_t = tlsf_allocator<static_block_allocator, 16u, 3u>;
+
+    fallback_allocator<alloc_t, heap_allocator> fallback(alloc_t(4096u, storage));
+    auto& tlsf = fallback.get_default_allocator();
+    auto  size = tlsf.capacity_left();
+
+    // the static block cannot grow, so the second node is taken from the heap
+    auto a = fallback.allocate_node(2000u, 8u);
+    auto b = fallback.allocate_node(3000u, 8u);
+    REQUIRE(tlsf.owns(a));
+    REQUIRE(!tlsf.owns(b));
+    fallback.deallocate_node(b, 3000u, 8u);
+    fallback.deallocate_node(a, 2000u, 8u);
+    REQUIRE(tlsf.capacity_left() == size);
+
+    auto s = make_segregator(threshold(16u, heap_allocator{}),
+                             tlsf_allocator<>(16u * 1024u));
+    auto c = allocator_traits<decltype(s)>::allocate_node(s, 100u, 8u);
+    REQUIRE(s.get_fallback_allocator().owns(c));
+    allocator_traits<decltype(s)>::deallocate_node(s, c, 100u, 8u);
+}
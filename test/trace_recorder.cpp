@@ -0,0 +1,131 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "trace_recorder.hpp"
+
+#include <doctest/doctest.h>
+#include <thread>
+
+#include "heap_allocator.hpp"
+#include "memory_pool.hpp"
+#include "tracking.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("trace_recorder")
+{
+    SUBCASE("in memory")
+    {
+        allocation_trace trace;
+        auto alloc = make_tracked_allocator(trace_recorder(trace), heap_allocator{});
+
+        auto a = alloc.allocate_node(16u, 8u);
+        auto b = alloc.allocate_array(4u, 8u, 4u);
+        alloc.deallocate_node(a, 16u, 8u);
+        alloc.deallocate_array(b, 4u, 8u, 4u);
+        REQUIRE(trace.size() == 4u);
+        REQUIRE(trace.good());
+
+        auto events = trace.events();
+        REQUIRE(events.size() == 4u);
+        REQUIRE(events[0].kind == trace_event_kind::allocate_node);
+        REQUIRE(events[0].address == reinterpret_cast<std::uintptr_t>(a));
+        REQUIRE(events[0].size == 16u);
+        REQUIRE(events[0].count == 1u);
+        REQUIRE(events[0].alignment() == 8u);
+        REQUIRE(events[1].kind == trace_event_kind::allocate_array);
+        REQUIRE(events[1].count == 4u);
+        REQUIRE(events[1].size == 8u);
+        REQUIRE(events[1].alignment() == 4u);
+        REQUIRE(events[2].kind == trace_event_kind::deallocate_node);
+        REQUIRE(events[3].kind == trace_event_kind::deallocate_array);
+        for (auto i = 1u; i != events.size(); ++i)
+            REQUIRE(events[i - 1].timestamp <= events[i].timestamp);
+    }
+    SUBCASE("threads")
+    {
+        allocation_trace trace;
+        trace_recorder   recorder(trace);
+
+        int obj;
+        recorder.on_node_allocation(&obj, sizeof(obj), alignof(int));
+        std::thread([&] { recorder.on_node_deallocation(&obj, sizeof(obj), alignof(int)); })
+            .join();
+
+        auto events = trace.events();
+        REQUIRE(events.size() == 2u);
+        REQUIRE(events[0].thread != events[1].thread);
+    }
+    SUBCASE("deep")
+    {
+        using pool = memory_pool<node_pool>;
+        allocation_trace trace;
+        auto             alloc = make_deeply_tracked_allocator<pool>(trace_recorder(trace), 16u,
+                                                         pool::min_block_size(16u, 1u));
+        // the first block is allocated before the tracker is set
+        auto a = alloc.allocate_node(16u, 1u);
+        auto b = alloc.allocate_node(16u, 1u);
+
+        auto events = trace.events();
+        REQUIRE(events.size() == 3u);
+        REQUIRE(events[0].kind == trace_event_kind::allocate_node);
+        REQUIRE(events[1].kind == trace_event_kind::allocator_growth);
+        REQUIRE(events[2].kind == trace_event_kind::allocate_node);
+        REQUIRE(events[2].address == reinterpret_cast<std::uintptr_t>(b));
+
+        alloc.deallocate_node(b, 16u, 1u);
+        alloc.deallocate_node(a, 16u, 1u);
+    }
+    SUBCASE("file")
+    {
+        auto file = std::tmpfile();
+        REQUIRE(file);
+        {
+            allocation_trace trace(file);
+            trace_recorder   recorder(trace);
+
+            int obj;
+            for (auto i = 0u; i != allocation_trace::buffer_size + 10u; ++i)
+                recorder.on_node_allocation(&obj, i + 1u, 1u);
+            REQUIRE(trace.events().size() == 10u);
+            REQUIRE(trace.good());
+        }
+
+        std::vector<trace_event> events;
+        std::rewind(file);
+        REQUIRE(allocation_trace::read(file, events));
+        REQUIRE(events.size() == allocation_trace::buffer_size + 10u);
+        for (auto i = 0u; i != events.size(); ++i)
+            REQUIRE(events[i].size == i + 1u);
+        std::fclose(file);
+    }
+    SUBCASE("write and read")
+    {
+        allocation_trace trace;
+        trace_recorder   recorder(trace);
+        int              obj;
+        recorder.on_node_allocation(&obj, 4u, 4u);
+        recorder.on_node_deallocation(&obj, 4u, 4u);
+
+        auto file = std::tmpfile();
+        REQUIRE(file);
+        REQUIRE(trace.write(file));
+
+        std::vector<trace_event> events;
+        std::rewind(file);
+        REQUIRE(allocation_trace::read(file, events));
+        REQUIRE(events.size() == 2u);
+        REQUIRE(events[1].kind == trace_event_kind::deallocate_node);
+
+        std::fclose(file);
+
+        // a truncated file is detected
+        file = std::tmpfile();
+        REQUIRE(file);
+        std::fwrite("FMTRACE1abc", 1u, 11u, file);
+        std::rewind(file);
+        events.clear();
+        REQUIRE(!allocation_trace::read(file, events));
+        std::fclose(file);
+    }
+}
@@ -0,0 +1,116 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "typed_pool.hpp"
+
+#include <cstdint>
+#include <doctest/doctest.h>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "smart_ptr.hpp"
+
+using namespace foonathan::memory;
+
+namespace
+{
+    struct point
+    {
+        double x, y, z;
+
+        point(double x, double y, double z) : x(x), y(y), z(z) {}
+    };
+
+    struct throwing
+    {
+        throwing()
+        {
+            throw std::runtime_error("throwing");
+        }
+    };
+
+    struct small
+    {
+        char c;
+    };
+} // namespace
+
+TEST_CASE("typed_pool")
+{
+    static_assert(typed_pool<point>::node_size == sizeof(point), "");
+    static_assert(typed_pool<small>::node_size >= typed_pool<small>::pool_type::min_node_size,
+                  "");
+    static_assert(!allocator_traits<typed_pool<point>>::is_stateful::value, "");
+
+    // one pool per type
+    REQUIRE(&typed_pool<point>::get_pool() == &typed_pool<point>::get_pool());
+    REQUIRE(static_cast<void*>(&typed_pool<point>::get_pool())
+            != static_cast<void*>(&typed_pool<small>::get_pool()));
+    REQUIRE(typed_pool<point>::get_pool().node_size() >= sizeof(point));
+
+    SUBCASE("pooled_new")
+    {
+        auto p = pooled_new<point>(1., 2., 3.);
+        REQUIRE(typed_pool<point>::get_pool().owns(p));
+        REQUIRE(reinterpret_cast<std::uintptr_t>(p) % alignof(point) == 0u);
+        REQUIRE(p->x == 1.);
+        REQUIRE(p->z == 3.);
+        pooled_delete(p);
+
+        // the node is reused from the thread cache
+        auto q = pooled_new<point>(4., 5., 6.);
+        REQUIRE(q == p);
+        pooled_delete(q);
+
+        pooled_delete(static_cast<point*>(nullptr));
+
+        // cv-qualified types share the pool of the unqualified type
+        auto c = pooled_new<const point>(7., 8., 9.);
+        REQUIRE(typed_pool<point>::get_pool().owns(c));
+        pooled_delete(c);
+    }
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+    SUBCASE("throwing constructor")
+    {
+        auto& pool     = typed_pool<throwing>::get_pool();
+        auto  capacity = pool.capacity_left() / pool.node_size() + pool.thread_cache_size();
+        REQUIRE_THROWS_AS(pooled_new<throwing>(), std::runtime_error);
+        REQUIRE(pool.capacity_left() / pool.node_size() + pool.thread_cache_size() == capacity);
+    }
+#endif
+    SUBCASE("unique_ptr")
+    {
+        std::unique_ptr<point, pooled_deleter<point>> ptr(pooled_new<point>(1., 1., 1.));
+        REQUIRE(ptr->y == 1.);
+    }
+    SUBCASE("RawAllocator")
+    {
+        auto ptr = allocate_unique<int>(typed_pool<int>{}, 42);
+        REQUIRE(*ptr == 42);
+        REQUIRE(typed_pool<int>::get_pool().owns(ptr.get()));
+
+        typed_pool<int> alloc;
+        REQUIRE(allocator_traits<typed_pool<int>>::max_node_size(alloc)
+                == typed_pool<int>::node_size);
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+        REQUIRE_THROWS_AS(allocator_traits<typed_pool<int>>::allocate_node(alloc, 64u, 1u),
+                          bad_node_size);
+#endif
+    }
+    SUBCASE("multiple threads")
+    {
+        std::vector<std::thread> threads;
+        for (auto t = 0; t != 4; ++t)
+            threads.emplace_back([] {
+                std::vector<small*> ptrs;
+                for (auto i = 0; i != 1000; ++i)
+                    ptrs.push_back(pooled_new<small>());
+                for (auto ptr : ptrs)
+                    pooled_delete(ptr);
+            });
+        for (auto& thread : threads)
+            thread.join();
+    }
+}
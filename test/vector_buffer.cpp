@@ -0,0 +1,121 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "vector_buffer.hpp"
+
+#include <algorithm>
+#include <doctest/doctest.h>
+
+#include "memory_stack.hpp"
+#include "test_allocator.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("vector_buffer")
+{
+    SUBCASE("growth in place")
+    {
+        memory_stack<> stack(4096u);
+
+        vector_buffer<int, memory_stack<>> buffer(stack);
+        REQUIRE(buffer.empty());
+        REQUIRE(buffer.data() == nullptr);
+
+        buffer.push_back(0);
+        REQUIRE(buffer.capacity() == 4u);
+        auto data = buffer.data();
+
+        for (auto i = 1; i != 100; ++i)
+            buffer.push_back(i);
+        REQUIRE(buffer.size() == 100u);
+        REQUIRE(buffer.capacity() >= 100u);
+        REQUIRE(buffer.data() == data);
+        for (auto i = 0; i != 100; ++i)
+            REQUIRE(buffer[std::size_t(i)] == i);
+
+        // another allocation prevents growth in place, the buffer is moved
+        auto capacity = buffer.capacity();
+        stack.allocate(1u, 1u);
+        buffer.reserve(capacity + 1u);
+        REQUIRE(buffer.capacity() == capacity + 1u);
+        REQUIRE(buffer.data() != data);
+        for (auto i = 0; i != 100; ++i)
+            REQUIRE(buffer[std::size_t(i)] == i);
+    }
+    SUBCASE("growth by reallocation")
+    {
+        test_allocator alloc;
+        {
+            vector_buffer<int, test_allocator> buffer(alloc);
+            for (auto i = 0; i != 10; ++i)
+                buffer.emplace_back(i);
+            REQUIRE(buffer.size() == 10u);
+            REQUIRE(buffer.capacity() == 16u);
+            REQUIRE(alloc.no_allocated() == 1u);
+            REQUIRE(alloc.no_deallocated() == 2u);
+            REQUIRE(alloc.last_deallocation_valid());
+
+            // element of the buffer itself while growing
+            while (buffer.size() != buffer.capacity())
+                buffer.push_back(0);
+            buffer.push_back(buffer[9]);
+            REQUIRE(buffer.size() == 17u);
+            REQUIRE(buffer[16] == 9);
+
+            while (buffer.size() != 10u)
+                buffer.pop_back();
+            auto sum = 0;
+            for (auto i : buffer)
+                sum += i;
+            REQUIRE(sum == 45);
+        }
+        REQUIRE(alloc.no_allocated() == 0u);
+        REQUIRE(alloc.last_deallocation_valid());
+    }
+    SUBCASE("emplace and erase")
+    {
+        test_allocator alloc;
+        {
+            vector_buffer<int, test_allocator> buffer(alloc);
+            for (auto i = 0; i != 6; ++i)
+                buffer.push_back(i * 2);
+
+            REQUIRE(*buffer.emplace(buffer.begin() + 2, 3) == 3);
+            REQUIRE(*buffer.emplace(buffer.end(), 11) == 11);
+            REQUIRE(*buffer.emplace(buffer.begin(), -1) == -1);
+            const int inserted[] = {-1, 0, 2, 3, 4, 6, 8, 10, 11};
+            REQUIRE(std::equal(buffer.begin(), buffer.end(), inserted));
+            REQUIRE(buffer.size() == 9u);
+
+            REQUIRE(*buffer.erase(buffer.begin()) == 0);
+            REQUIRE(*buffer.erase(buffer.begin() + 1, buffer.begin() + 4) == 6);
+            auto last = buffer.erase(buffer.end() - 1);
+            REQUIRE(last == buffer.end());
+            const int erased[] = {0, 6, 8, 10};
+            REQUIRE(std::equal(buffer.begin(), buffer.end(), erased));
+            REQUIRE(buffer.size() == 4u);
+        }
+        REQUIRE(alloc.no_allocated() == 0u);
+    }
+    SUBCASE("move")
+    {
+        test_allocator alloc;
+        {
+            vector_buffer<int, test_allocator> a(alloc);
+            a.push_back(42);
+            auto data = a.data();
+
+            vector_buffer<int, test_allocator> b(std::move(a));
+            REQUIRE(a.empty());
+            REQUIRE(a.capacity() == 0u);
+            REQUIRE(b.data() == data);
+            REQUIRE(b.size() == 1u);
+
+            a = std::move(b);
+            REQUIRE(a.data() == data);
+            REQUIRE(b.data() == nullptr);
+            REQUIRE(&a.get_allocator() == &alloc);
+        }
+        REQUIRE(alloc.no_allocated() == 0u);
+    }
+}
@@ -0,0 +1,100 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "virtual_array.hpp"
+
+#include <doctest/doctest.h>
+
+#include <string>
+
+#include "error.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("virtual_array")
+{
+    auto page = get_virtual_memory_page_size();
+
+    SUBCASE("growth in place")
+    {
+        virtual_array<int> array(1024u * 1024u);
+        REQUIRE(array.empty());
+        REQUIRE(array.capacity() == 0u);
+        REQUIRE(array.max_size() == 1024u * 1024u);
+
+        array.push_back(0);
+        REQUIRE(array.capacity() == page / sizeof(int));
+        auto data  = array.data();
+        auto first = &array[0];
+
+        for (auto i = 1; i != 100000; ++i)
+            array.push_back(i);
+        REQUIRE(array.size() == 100000u);
+        REQUIRE(array.capacity() >= 100000u);
+        REQUIRE(array.data() == data);
+        REQUIRE(first == &array[0]);
+        for (auto i = 0; i != 100000; ++i)
+            REQUIRE(array[std::size_t(i)] == i);
+
+        // element of the array itself while growing
+        while (array.size() != array.capacity())
+            array.push_back(0);
+        array.push_back(array[99]);
+        REQUIRE(array[array.size() - 1u] == 99);
+    }
+    SUBCASE("reserve and shrink")
+    {
+        virtual_array<std::string> array(4096u);
+        array.reserve(100u);
+        REQUIRE(array.capacity() >= 100u);
+
+        for (auto i = 0; i != 100; ++i)
+            array.emplace_back(std::to_string(i));
+        array.pop_back();
+        REQUIRE(array.size() == 99u);
+        REQUIRE(array[98] == "98");
+
+        array.clear();
+        REQUIRE(array.empty());
+        REQUIRE(array.capacity() >= 100u);
+        array.shrink_to_fit();
+        REQUIRE(array.capacity() == 0u);
+
+        array.emplace_back("after");
+        REQUIRE(array[0] == "after");
+    }
+    SUBCASE("maximum size")
+    {
+        virtual_array<char> array(page);
+        for (auto i = 0u; i != page; ++i)
+            array.push_back('a');
+        REQUIRE(array.size() == array.max_size());
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+        auto thrown = false;
+        try
+        {
+            array.push_back('b');
+        }
+        catch (out_of_fixed_memory&)
+        {
+            thrown = true;
+        }
+        REQUIRE(thrown);
+        REQUIRE(array.size() == page);
+#endif
+    }
+    SUBCASE("move")
+    {
+        virtual_array<int> array(1024u);
+        array.push_back(42);
+        auto data = array.data();
+
+        virtual_array<int> other(1u);
+        other = detail::move(array);
+        REQUIRE(other.data() == data);
+        REQUIRE(other.size() == 1u);
+        REQUIRE(other[0] == 42);
+        REQUIRE(array.empty());
+        REQUIRE(array.max_size() == 0u);
+    }
+}
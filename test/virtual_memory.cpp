@@ -0,0 +1,267 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include "virtual_memory.hpp"
+
+#include <doctest/doctest.h>
+
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__) || defined(__VXWORKS__)                                \
+    || defined(__QNXNTO__) // POSIX systems
+#include <cstdlib>
+#include <unistd.h>
+#endif
+
+#include "allocator_storage.hpp"
+#include "memory_arena.hpp"
+#include "memory_stack.hpp"
+
+using namespace foonathan::memory;
+
+TEST_CASE("virtual_memory_stack")
+{
+    virtual_memory_stack stack(1024u * virtual_memory_page_size, 2 * virtual_memory_page_size);
+    REQUIRE(stack.capacity() == 1024u * virtual_memory_page_size);
+    REQUIRE(stack.commit_size() % stack.page_size() == 0u);
+    REQUIRE(stack.capacity_left() == stack.capacity());
+    REQUIRE(stack.committed_size() == 0u);
+
+    SUBCASE("lazy commit")
+    {
+        auto m = stack.top();
+
+        auto a = static_cast<char*>(stack.allocate(10u, 1u));
+        REQUIRE(stack.committed_size() == stack.commit_size());
+        a[9] = 'a';
+
+        // grows in place
+        auto b = static_cast<char*>(stack.allocate(4u * stack.commit_size(), 16u));
+        REQUIRE(b > a);
+        REQUIRE(stack.committed_size() > 4u * stack.commit_size());
+        b[4u * stack.commit_size() - 1u] = 'b';
+
+        stack.unwind(m);
+        REQUIRE(stack.top() == m);
+        REQUIRE(stack.capacity_left() == stack.capacity());
+        REQUIRE(stack.committed_size() <= 2 * virtual_memory_page_size);
+
+        stack.allocate(10u, 1u);
+        stack.shrink_to_fit();
+        REQUIRE(stack.committed_size() == virtual_memory_page_size);
+    }
+    SUBCASE("exhausted")
+    {
+        REQUIRE(!stack.try_allocate(stack.capacity() + 1u, 1u));
+        REQUIRE(stack.committed_size() == 0u);
+
+        auto m = stack.top();
+        REQUIRE(stack.try_allocate(16u, 8u));
+        REQUIRE(m < stack.top());
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+        auto thrown = false;
+        try
+        {
+            stack.allocate(stack.capacity(), 1u);
+        }
+        catch (out_of_fixed_memory&)
+        {
+            thrown = true;
+        }
+        REQUIRE(thrown);
+#endif
+    }
+    SUBCASE("raii unwind")
+    {
+        {
+            memory_stack_raii_unwind<virtual_memory_stack> unwind(stack);
+            allocator_reference<virtual_memory_stack> ref(stack);
+            auto node = ref.allocate_node(100u, 8u);
+            using traits = composable_allocator_traits<virtual_memory_stack>;
+            REQUIRE(traits::try_deallocate_node(stack, node, 100u, 8u));
+            ref.deallocate_node(node, 100u, 8u);
+        }
+        REQUIRE(stack.capacity_left() == stack.capacity());
+    }
+    SUBCASE("decommit near the end")
+    {
+        auto page = virtual_memory_page_size;
+        virtual_memory_stack full(4u * page, 3u * page - 1u);
+        auto                 m = full.top();
+        full.allocate(page / 2u, 1u);
+        auto half = full.top();
+        full.allocate(3u * page, 1u);
+        REQUIRE(full.committed_size() == full.capacity());
+
+        // the margin rounded up reaches the end of the reservation
+        full.unwind(half);
+        REQUIRE(full.committed_size() == full.capacity());
+        full.unwind(m);
+        REQUIRE(full.committed_size() == 3u * page);
+    }
+    SUBCASE("zeroed")
+    {
+        auto m = stack.top();
+        auto a = static_cast<char*>(stack.allocate_zeroed(3u * stack.commit_size(), 1u));
+        for (auto i = 0u; i != 3u * stack.commit_size(); ++i)
+            REQUIRE(a[i] == 0);
+        std::memset(a, 'a', 3u * stack.commit_size());
+
+        // memory that was used before is cleared, even if it was decommitted
+        stack.unwind(m);
+        using traits = allocator_traits<virtual_memory_stack>;
+        auto b =
+            static_cast<char*>(traits::allocate_array_zeroed(stack, 4u, stack.commit_size(), 1u));
+        REQUIRE(b == a);
+        for (auto i = 0u; i != 4u * stack.commit_size(); ++i)
+            REQUIRE(b[i] == 0);
+    }
+}
+
+TEST_CASE("virtual_buffer")
+{
+    auto page = get_virtual_memory_page_size();
+
+    virtual_buffer buffer(4u * page + 1u);
+    REQUIRE(buffer.max_size() == 5u * page);
+    REQUIRE(buffer.committed_size() == 0u);
+    auto data = static_cast<char*>(buffer.data());
+
+    buffer.commit(1u);
+    REQUIRE(buffer.committed_size() == page);
+    data[0] = 'a';
+
+    REQUIRE(buffer.try_commit(3u * page));
+    REQUIRE(buffer.committed_size() == 3u * page);
+    REQUIRE(buffer.data() == data);
+    REQUIRE(data[0] == 'a');
+    data[3u * page - 1u] = 'b';
+
+    REQUIRE(!buffer.try_commit(5u * page + 1u));
+    REQUIRE(buffer.committed_size() == 3u * page);
+#if FOONATHAN_HAS_EXCEPTION_SUPPORT
+    auto thrown = false;
+    try
+    {
+        buffer.commit(6u * page);
+    }
+    catch (out_of_fixed_memory&)
+    {
+        thrown = true;
+    }
+    REQUIRE(thrown);
+#endif
+
+    buffer.decommit(page + 1u);
+    REQUIRE(buffer.committed_size() == 2u * page);
+    REQUIRE(data[0] == 'a');
+
+    virtual_buffer other(detail::move(buffer));
+    REQUIRE(other.data() == data);
+    REQUIRE(other.committed_size() == 2u * page);
+    REQUIRE(buffer.max_size() == 0u);
+}
+
+#if defined(__unix__) || defined(__APPLE__) || defined(__VXWORKS__)                                \
+    || defined(__QNXNTO__) // POSIX systems
+TEST_CASE("mmap_block_allocator")
+{
+    char path[] = "/tmp/foonathan_memory_mmap_XXXXXX";
+    auto fd     = mkstemp(path);
+    REQUIRE(fd >= 0);
+    close(fd);
+
+    auto block_size = 4u * virtual_memory_page_size;
+    {
+        mmap_block_allocator alloc(block_size, 8u, path, mmap_options::random);
+        REQUIRE(alloc.capacity_left() == 8u);
+        REQUIRE(alloc.file_size() == 0u);
+
+        // grows the file sparsely
+        auto a = alloc.allocate_block();
+        auto b = alloc.allocate_block();
+        REQUIRE(alloc.file_size() == 2u * block_size);
+        REQUIRE(alloc.capacity_left() == 6u);
+        REQUIRE(static_cast<char*>(b.memory) == static_cast<char*>(a.memory) + block_size);
+        std::strcpy(static_cast<char*>(b.memory), "persistent");
+        REQUIRE(alloc.sync());
+
+        // keeps the contents and the file size
+        alloc.deallocate_block(b);
+        alloc.deallocate_block(a);
+        REQUIRE(alloc.file_size() == 2u * block_size);
+    }
+    {
+        // reopening yields the same data
+        mmap_block_allocator alloc(block_size, 8u, path,
+                                   mmap_options::populate | mmap_options::preallocate);
+        REQUIRE(alloc.file_size() == 2u * block_size);
+        auto a = alloc.allocate_block();
+        auto b = alloc.allocate_block();
+        REQUIRE(std::strcmp(static_cast<char*>(b.memory), "persistent") == 0);
+
+        auto c = alloc.allocate_block();
+        REQUIRE(alloc.file_size() == 3u * block_size);
+        alloc.deallocate_block(c);
+        alloc.deallocate_block(b);
+        alloc.deallocate_block(a);
+    }
+    {
+        // usable as block allocator of an arena
+        memory_stack<mmap_block_allocator> stack(block_size, 2u, path);
+        auto mem = static_cast<char*>(stack.allocate(16u, 8u));
+        mem[15]  = 'a';
+        REQUIRE(stack.get_allocator().capacity_left() == 1u);
+    }
+    std::remove(path);
+}
+
+TEST_CASE("memory_stack_snapshot")
+{
+    char path[] = "/tmp/foonathan_memory_snapshot_XXXXXX";
+    auto fd     = mkstemp(path);
+    REQUIRE(fd >= 0);
+    close(fd);
+
+    using stack_t   = memory_stack<mmap_block_allocator>;
+    auto block_size = 4u * virtual_memory_page_size;
+
+    memory_stack_snapshot snapshot;
+    void*                 address;
+    int*                  first;
+    int**                 node;
+    {
+        // build a linked structure spanning two blocks
+        stack_t stack(block_size, 4u, path);
+        first = static_cast<int*>(stack.allocate(sizeof(int), alignof(int)));
+        node       = static_cast<int**>(stack.allocate(block_size / 2u, alignof(int*)));
+        *node      = first;
+        *first     = 42;
+
+        auto second = static_cast<int*>(stack.allocate(block_size / 2u, alignof(int)));
+        second[0]   = 43;
+        REQUIRE(stack.get_allocator().capacity_left() == 2u);
+
+        snapshot = stack.snapshot();
+        REQUIRE(snapshot.no_blocks == 2u);
+        address = stack.get_allocator().memory();
+    }
+    {
+        // restoring at the same address keeps the pointers valid
+        stack_t stack(snapshot, block_size, 4u, path, mmap_options::none, address);
+        REQUIRE(stack.get_allocator().memory() == address);
+        REQUIRE(stack.get_allocator().capacity_left() == 2u);
+        REQUIRE(*node == first);
+        REQUIRE(**node == 42);
+
+        auto top = stack.snapshot();
+        REQUIRE(top.no_blocks == snapshot.no_blocks);
+        REQUIRE(top.top_offset == snapshot.top_offset);
+
+        // new allocations come after the restored ones
+        auto memory = static_cast<char*>(stack.allocate(16u, 1u));
+        REQUIRE(memory > reinterpret_cast<char*>(first) + block_size);
+    }
+    std::remove(path);
+}
+#endif
@@ -0,0 +1,501 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <unistd.h>
+#define FOONATHAN_MEMORY_IMPL_HAS_RUSAGE 1
+#endif
+
+#include <foonathan/memory/allocator_traits.hpp>
+#include <foonathan/memory/heap_allocator.hpp>
+#include <foonathan/memory/memory_pool.hpp>
+#include <foonathan/memory/memory_pool_collection.hpp>
+#include <foonathan/memory/memory_stack.hpp>
+#include <foonathan/memory/namespace_alias.hpp>
+
+const char* const exe_name = "footprint";
+const std::string exe_spaces(std::strlen(exe_name), ' ');
+
+struct footprint_options
+{
+    std::size_t count      = 10000u;
+    std::size_t block_size = 64u * 1024u;
+    double      threshold  = 5.0;
+    const char* baseline   = nullptr;
+    const char* output     = nullptr;
+};
+
+// the metrics of a scenario, lower is better for all of them
+struct footprint_result
+{
+    std::string name;
+    // the bytes allocated from the heap per allocation at the peak that exceed the requested ones
+    double overhead;
+    // the peak of the bytes allocated from the heap, in KiB
+    double peak;
+    // the part of the bytes allocated from the heap that is not requested after the churn,
+    // in percent
+    double fragmentation;
+    // the growth of the resident set size until the peak, in KiB, only informational
+    double rss;
+};
+
+// the current resident set size of the process in bytes, 0 if unknown
+std::size_t current_rss()
+{
+#if defined(__linux__)
+    auto file = std::fopen("/proc/self/statm", "r");
+    if (!file)
+        return 0u;
+    unsigned long size = 0u, resident = 0u;
+    auto          read = std::fscanf(file, "%lu %lu", &size, &resident);
+    std::fclose(file);
+    return read == 2 ? std::size_t(resident) * std::size_t(sysconf(_SC_PAGESIZE)) : 0u;
+#else
+    return 0u;
+#endif
+}
+
+// the peak resident set size of the process in bytes, 0 if unknown
+std::size_t peak_rss()
+{
+#if defined(FOONATHAN_MEMORY_IMPL_HAS_RUSAGE)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0u;
+#if defined(__APPLE__)
+    return std::size_t(usage.ru_maxrss);
+#else
+    return std::size_t(usage.ru_maxrss) * 1024u;
+#endif
+#else
+    return 0u;
+#endif
+}
+
+// a RawAllocator for the blocks of the measured allocators,
+// it counts the bytes it gets from the heap
+struct counting_allocator
+{
+    using is_stateful = std::false_type;
+
+    static std::size_t current, peak;
+
+    static void reset() noexcept
+    {
+        current = peak = 0u;
+    }
+
+    void* allocate_node(std::size_t size, std::size_t alignment)
+    {
+        auto memory = memory::heap_allocator().allocate_node(size, alignment);
+        current += size;
+        if (current > peak)
+            peak = current;
+        return memory;
+    }
+
+    void deallocate_node(void* ptr, std::size_t size, std::size_t alignment) noexcept
+    {
+        current -= size;
+        memory::heap_allocator().deallocate_node(ptr, size, alignment);
+    }
+};
+
+std::size_t counting_allocator::current = 0u;
+std::size_t counting_allocator::peak    = 0u;
+
+// a deterministic random number generator,
+// the distributions of the standard library differ between implementations
+class random_generator
+{
+public:
+    std::size_t operator()(std::size_t min, std::size_t max) noexcept
+    {
+        state_ = state_ * 6364136223846793005u + 1442695040888963407u;
+        return min + std::size_t(state_ >> 33u) % (max - min + 1u);
+    }
+
+private:
+    std::uint64_t state_ = 42u;
+};
+
+struct allocation
+{
+    void*       memory;
+    std::size_t count, size;
+};
+
+struct churn_state
+{
+    std::vector<allocation> live;
+    std::size_t             live_bytes = 0u, peak_live_bytes = 0u, peak_count = 0u;
+};
+
+// the single node or array allocations of a pool scenario
+template <class RawAllocator>
+void allocate(RawAllocator& alloc, churn_state& state, std::size_t count, std::size_t size)
+{
+    using traits = memory::allocator_traits<RawAllocator>;
+    auto memory  = count == 1u ? traits::allocate_node(alloc, size, 1u)
+                               : traits::allocate_array(alloc, count, size, 1u);
+    state.live.push_back({memory, count, size});
+    state.live_bytes += count * size;
+}
+
+template <class RawAllocator>
+void deallocate(RawAllocator& alloc, churn_state& state, std::size_t index)
+{
+    using traits = memory::allocator_traits<RawAllocator>;
+    auto& a      = state.live[index];
+    if (a.count == 1u)
+        traits::deallocate_node(alloc, a.memory, a.size, 1u);
+    else
+        traits::deallocate_array(alloc, a.memory, a.count, a.size, 1u);
+    state.live_bytes -= a.count * a.size;
+    state.live[index] = state.live.back();
+    state.live.pop_back();
+}
+
+void record_peak(churn_state& state)
+{
+    state.peak_live_bytes = state.live_bytes;
+    state.peak_count      = state.live.size();
+}
+
+footprint_result make_result(const char* name, const churn_state& state, std::size_t rss_before,
+                             std::size_t rss_peak)
+{
+    auto overhead = double(counting_allocator::peak) - double(state.peak_live_bytes);
+
+    footprint_result result;
+    result.name          = name;
+    result.overhead      = overhead / double(state.peak_count);
+    result.peak          = double(counting_allocator::peak) / 1024.0;
+    result.fragmentation = counting_allocator::current == 0u ?
+                               0.0 :
+                               100.0 * (1.0 - double(state.live_bytes)
+                                                  / double(counting_allocator::current));
+    result.rss           = rss_peak > rss_before ? double(rss_peak - rss_before) / 1024.0 : 0.0;
+    return result;
+}
+
+// allocates count allocations, deallocates a random half of them, allocates a quarter again
+// and measures the peak after the first step and the fragmentation at the end
+// the sizes are given by the generator
+template <class RawAllocator, typename Sizes>
+footprint_result churn(const char* name, RawAllocator& alloc, std::size_t count, Sizes sizes)
+{
+    random_generator random;
+    churn_state      state;
+    state.live.reserve(count);
+    auto rss_before = current_rss();
+
+    for (auto i = std::size_t(0u); i != count; ++i)
+    {
+        auto size = sizes(random);
+        allocate(alloc, state, size.first, size.second);
+    }
+    record_peak(state);
+    auto rss_peak = current_rss();
+
+    for (auto i = std::size_t(0u); i != count / 2u; ++i)
+        deallocate(alloc, state, random(0u, state.live.size() - 1u));
+    for (auto i = std::size_t(0u); i != count / 4u; ++i)
+    {
+        auto size = sizes(random);
+        allocate(alloc, state, size.first, size.second);
+    }
+
+    auto result = make_result(name, state, rss_before, rss_peak);
+    while (!state.live.empty())
+        deallocate(alloc, state, state.live.size() - 1u);
+    return result;
+}
+
+template <class PoolType>
+footprint_result pool_scenario(const char* name, const footprint_options& options,
+                               std::size_t node_size, std::size_t max_array)
+{
+    counting_allocator::reset();
+    memory::memory_pool<PoolType, counting_allocator> pool(node_size, options.block_size);
+    return churn(name, pool, options.count, [&](random_generator& random) {
+        return std::make_pair(random(1u, max_array), node_size);
+    });
+}
+
+template <class BucketDistribution>
+footprint_result collection_scenario(const char* name, const footprint_options& options)
+{
+    counting_allocator::reset();
+    memory::memory_pool_collection<memory::node_pool, BucketDistribution, counting_allocator>
+        pools(256u, options.block_size);
+    return churn(name, pools, options.count, [&](random_generator& random) {
+        return std::make_pair(std::size_t(1u), random(1u, 256u));
+    });
+}
+
+// a stack cannot deallocate in random order,
+// so the churn unwinds to the middle instead
+footprint_result stack_scenario(const footprint_options& options)
+{
+    counting_allocator::reset();
+    memory::memory_stack<counting_allocator> stack(options.block_size);
+
+    random_generator random;
+    churn_state      state;
+    auto             rss_before = current_rss();
+
+    auto        middle       = stack.top();
+    std::size_t middle_bytes = 0u;
+    for (auto i = std::size_t(0u); i != options.count; ++i)
+    {
+        if (i == options.count / 2u)
+        {
+            middle       = stack.top();
+            middle_bytes = state.live_bytes;
+        }
+        auto size = random(1u, 64u);
+        stack.allocate(size, 8u);
+        state.live_bytes += size;
+        state.live.push_back({nullptr, 1u, size});
+    }
+    record_peak(state);
+    auto rss_peak = current_rss();
+
+    stack.unwind(middle);
+    state.live_bytes = middle_bytes;
+    for (auto i = std::size_t(0u); i != options.count / 4u; ++i)
+    {
+        auto size = random(1u, 64u);
+        stack.allocate(size, 8u);
+        state.live_bytes += size;
+    }
+
+    return make_result("memory_stack", state, rss_before, rss_peak);
+}
+
+std::vector<footprint_result> run(const footprint_options& options)
+{
+    using namespace memory;
+
+    std::vector<footprint_result> results;
+    results.push_back(pool_scenario<small_node_pool>("small_node_pool", options, 4u, 1u));
+    results.push_back(pool_scenario<node_pool>("node_pool", options, 16u, 1u));
+    results.push_back(pool_scenario<array_pool>("array_pool", options, 16u, 4u));
+    results.push_back(
+        collection_scenario<identity_buckets>("memory_pool_collection<identity_buckets>", options));
+    results.push_back(
+        collection_scenario<log2_buckets>("memory_pool_collection<log2_buckets>", options));
+    results.push_back(collection_scenario<geometric_buckets>(
+        "memory_pool_collection<geometric_buckets>", options));
+    results.push_back(stack_scenario(options));
+    return results;
+}
+
+void print_results(std::ostream& out, const std::vector<footprint_result>& results)
+{
+    out << std::left << std::setw(44) << "scenario" << std::right << std::setw(16)
+        << "overhead/alloc" << std::setw(12) << "peak KiB" << std::setw(16) << "fragmentation"
+        << std::setw(16) << "RSS growth KiB" << '\n';
+    for (auto& result : results)
+        out << std::left << std::setw(44) << result.name << std::right << std::fixed
+            << std::setprecision(2) << std::setw(16) << result.overhead << std::setw(12)
+            << result.peak << std::setw(15) << result.fragmentation << '%' << std::setw(16)
+            << result.rss << '\n';
+
+    if (auto peak = peak_rss())
+        out << "peak RSS: " << peak / 1024u << " KiB\n";
+}
+
+bool write_baseline(const char* path, const std::vector<footprint_result>& results)
+{
+    std::ofstream file(path);
+    file << std::fixed << std::setprecision(2);
+    for (auto& result : results)
+        file << result.name << " overhead " << result.overhead << '\n'
+             << result.name << " peak " << result.peak << '\n'
+             << result.name << " fragmentation " << result.fragmentation << '\n';
+    return bool(file);
+}
+
+// returns the number of metrics exceeding the baseline by more than the threshold,
+// or -1 if the baseline cannot be read
+int compare_baseline(std::ostream& out, const footprint_options& options,
+                     const std::vector<footprint_result>& results)
+{
+    std::ifstream file(options.baseline);
+    if (!file)
+        return -1;
+
+    auto        regressions = 0;
+    std::string name, metric;
+    double      expected;
+    while (file >> name >> metric >> expected)
+    {
+        for (auto& result : results)
+        {
+            if (result.name != name)
+                continue;
+
+            auto actual = metric == "overhead" ? result.overhead :
+                          metric == "peak"     ? result.peak :
+                          metric == "fragmentation" ? result.fragmentation :
+                                                      expected;
+            // the baseline is rounded to two decimal places
+            if (actual > expected * (1.0 + options.threshold / 100.0) + 0.005)
+            {
+                out << exe_name << ": regression: " << name << ' ' << metric << " is "
+                    << std::fixed << std::setprecision(2) << actual << ", baseline " << expected
+                    << '\n';
+                ++regressions;
+            }
+        }
+    }
+    return file.eof() ? regressions : -1;
+}
+
+void print_help(std::ostream& out)
+{
+    out << "Usage: " << exe_name << " [--version][--help]\n";
+    out << "       " << exe_spaces
+        << " [--count n] [--block-size bytes] [--baseline file [--threshold percent]] "
+           "[--write-baseline file]\n";
+    out << "Measures the memory footprint of the allocators after standard churn patterns.\n";
+    out << '\n';
+    out << "   --count\tthe number of allocations of each scenario, default is 10000\n";
+    out << "   --block-size\tthe initial block size of the allocators, default is 65536\n";
+    out << "   --baseline\ta file written by --write-baseline to compare against\n";
+    out << "   --threshold\tthe increase in percent of a metric over the baseline "
+           "that is a regression, default is 5\n";
+    out << "   --write-baseline\twrite the results to the file\n";
+    out << "   --help\tdisplay this help and exit\n";
+    out << "   --version\toutput version information and exit\n";
+    out << '\n';
+    out << "Each scenario allocates, deallocates a random half and allocates a quarter again.\n"
+        << "The overhead are the bytes allocated from the heap at the peak per allocation "
+           "that exceed the requested ones,\n"
+        << "the fragmentation the part of the heap memory that is not requested at the end.\n"
+        << "The RSS growth depends on the heap and is not compared against the baseline.\n"
+        << "The exit status is 1 if a metric exceeds the baseline by more than the threshold,\n"
+        << "a baseline only fits the build configuration it was written with.\n";
+}
+
+void print_version(std::ostream& out)
+{
+    out << exe_name << " version " << VERSION << '\n';
+}
+
+int print_invalid_option(std::ostream& out, const char* option)
+{
+    out << exe_name << ": invalid option -- '";
+    while (*option == '-')
+        ++option;
+    out << option << "'\n";
+    out << "Try '" << exe_name << " --help' for more information.\n";
+    return 2;
+}
+
+int print_invalid_argument(std::ostream& out, const char* option)
+{
+    out << exe_name << ": invalid argument for option -- '" << option << "'\n";
+    out << "Try '" << exe_name << " --help' for more information.\n";
+    return 2;
+}
+
+bool parse_size(const char* str, std::size_t& result)
+{
+    if (!str)
+        return false;
+    char* end;
+    auto  value = std::strtoull(str, &end, 10);
+    if (end == str || *end || value == 0u)
+        return false;
+    result = std::size_t(value);
+    return true;
+}
+
+bool parse_percent(const char* str, double& result)
+{
+    if (!str)
+        return false;
+    char* end;
+    auto  value = std::strtod(str, &end);
+    if (end == str || *end || value < 0.0)
+        return false;
+    result = value;
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && argv[1] == std::string("--help"))
+    {
+        print_help(std::cout);
+        return 0;
+    }
+    else if (argc > 1 && argv[1] == std::string("--version"))
+    {
+        print_version(std::cout);
+        return 0;
+    }
+
+    footprint_options options;
+    for (auto cur = &argv[1]; *cur; ++cur)
+    {
+        if (*cur == std::string("--count"))
+        {
+            if (!parse_size(*++cur, options.count) || options.count < 4u)
+                return print_invalid_argument(std::cerr, "--count");
+        }
+        else if (*cur == std::string("--block-size"))
+        {
+            if (!parse_size(*++cur, options.block_size))
+                return print_invalid_argument(std::cerr, "--block-size");
+        }
+        else if (*cur == std::string("--threshold"))
+        {
+            if (!parse_percent(*++cur, options.threshold))
+                return print_invalid_argument(std::cerr, "--threshold");
+        }
+        else if (*cur == std::string("--baseline"))
+        {
+            if (!*++cur)
+                return print_invalid_argument(std::cerr, "--baseline");
+            options.baseline = *cur;
+        }
+        else if (*cur == std::string("--write-baseline"))
+        {
+            if (!*++cur)
+                return print_invalid_argument(std::cerr, "--write-baseline");
+            options.output = *cur;
+        }
+        else
+            return print_invalid_option(std::cerr, *cur);
+    }
+
+    auto results = run(options);
+    print_results(std::cout, results);
+
+    if (options.output && !write_baseline(options.output, results))
+        return print_invalid_argument(std::cerr, "--write-baseline");
+    if (options.baseline)
+    {
+        auto regressions = compare_baseline(std::cerr, options, results);
+        if (regressions < 0)
+            return print_invalid_argument(std::cerr, "--baseline");
+        else if (regressions > 0)
+            return 1;
+    }
+}
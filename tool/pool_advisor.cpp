@@ -0,0 +1,499 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <foonathan/memory/memory_pool.hpp>
+#include <foonathan/memory/memory_stack.hpp>
+#include <foonathan/memory/namespace_alias.hpp>
+#include <foonathan/memory/statistics_tracker.hpp>
+#include <foonathan/memory/trace_recorder.hpp>
+
+const char* const exe_name = "pool_advisor";
+const std::string exe_spaces(std::strlen(exe_name), ' ');
+
+struct advisor_options
+{
+    std::size_t headroom  = 25u;
+    std::size_t page_size = 4096u;
+    const char* header    = nullptr;
+    std::string name      = "pool_sizes";
+};
+
+// the allocations of one size
+struct size_profile
+{
+    std::size_t size;
+    std::size_t allocations;
+    // the highest number of allocations of the size that were live at the same time
+    std::size_t peak_live;
+};
+
+// the allocation profile of a program, from a trace or from statistics
+struct allocation_profile
+{
+    // sorted by size
+    std::vector<size_profile> sizes;
+    std::size_t               allocations = 0u;
+    std::size_t               peak_bytes = 0u, final_bytes = 0u;
+    std::size_t               growths = 0u;
+    // whether the sizes are exact or the upper bounds of the size classes of the statistics
+    bool exact = true;
+};
+
+struct recommendation
+{
+    // memory_pool for the most frequent size
+    std::size_t node_size = 0u, node_share = 0u, node_reserve = 0u, node_block_size = 0u;
+
+    // memory_pool_collection for the sizes up to the maximum node size
+    bool        identity_buckets = false;
+    std::size_t max_node_size = 0u, collection_share = 0u, collection_block_size = 0u;
+    // the node size of a bucket and the number of nodes to reserve in it
+    std::vector<std::pair<std::size_t, std::size_t>> collection_reserve;
+
+    // memory_stack and temporary_stack
+    std::size_t stack_size = 0u;
+
+    float growth_factor = 2.f;
+    bool  bursty        = false;
+};
+
+// the sizes are tracked exactly, the events of all threads are treated as one sequence
+allocation_profile profile_trace(const std::vector<memory::trace_event>& events)
+{
+    using kind = memory::trace_event_kind;
+
+    struct counters
+    {
+        std::size_t allocations = 0u, live = 0u, peak_live = 0u;
+    };
+    std::map<std::size_t, counters> sizes;
+
+    allocation_profile result;
+    std::size_t        live_bytes = 0u;
+    for (auto& event : events)
+    {
+        auto bytes = std::size_t(event.size) * event.count;
+        if (event.kind == kind::allocate_node || event.kind == kind::allocate_array)
+        {
+            auto& c = sizes[bytes];
+            ++c.allocations;
+            c.peak_live = std::max(c.peak_live, ++c.live);
+            ++result.allocations;
+
+            live_bytes += bytes;
+            result.peak_bytes = std::max(result.peak_bytes, live_bytes);
+        }
+        else if (event.kind == kind::deallocate_node || event.kind == kind::deallocate_array)
+        {
+            // the memory might have been allocated before the recording started
+            auto& c = sizes[bytes];
+            if (c.live == 0u)
+                continue;
+            --c.live;
+            live_bytes -= bytes;
+        }
+        else if (event.kind == kind::allocator_growth)
+            ++result.growths;
+    }
+    result.final_bytes = live_bytes;
+
+    for (auto& s : sizes)
+        if (s.second.allocations != 0u)
+            result.sizes.push_back({s.first, s.second.allocations, s.second.peak_live});
+    return result;
+}
+
+// the statistics only have the number of allocations per size class and the total peak,
+// so the peak of each size class is estimated assuming the same part of each class is live
+allocation_profile profile_statistics(const memory::allocation_statistics_snapshot& snapshot)
+{
+    allocation_profile result;
+    result.allocations = snapshot.allocations;
+    result.peak_bytes  = snapshot.peak_bytes;
+    result.final_bytes = snapshot.live_bytes;
+    result.growths     = snapshot.growths;
+    result.exact       = false;
+
+    auto live_ratio = snapshot.bytes_allocated == 0u
+                          ? 0.0
+                          : double(snapshot.peak_bytes) / double(snapshot.bytes_allocated);
+    for (std::size_t i = 0u; i != memory::allocation_histogram_size; ++i)
+    {
+        auto count = snapshot.histogram[i];
+        if (count == 0u)
+            continue;
+        auto peak = std::size_t(double(count) * live_ratio + 0.999);
+        peak      = std::min(std::max(peak, std::size_t(1)), count);
+        result.sizes.push_back({std::size_t(1) << i, count, peak});
+    }
+    return result;
+}
+
+std::size_t round_up(std::size_t value, std::size_t multiple)
+{
+    return (value + multiple - 1u) / multiple * multiple;
+}
+
+std::size_t round_up_pow2(std::size_t value)
+{
+    std::size_t result = 1u;
+    while (result < value)
+        result *= 2u;
+    return result;
+}
+
+std::size_t with_headroom(std::size_t value, const advisor_options& options)
+{
+    return std::max(value + value * options.headroom / 100u, std::size_t(1));
+}
+
+// the share of the allocations in per mille
+std::size_t share(std::size_t part, std::size_t total)
+{
+    return total == 0u ? 0u : part * 1000u / total;
+}
+
+recommendation recommend(const allocation_profile& profile, const advisor_options& options)
+{
+    using pool_type  = memory::memory_pool<memory::node_pool>;
+    using stack_type = memory::memory_stack<>;
+
+    recommendation result;
+    if (profile.sizes.empty())
+        return result;
+
+    // a node pool for the most frequent size, big enough for its peak from the start
+    auto most_frequent =
+        std::max_element(profile.sizes.begin(), profile.sizes.end(),
+                         [](const size_profile& a, const size_profile& b)
+                         { return a.allocations < b.allocations; });
+    result.node_size    = std::max(most_frequent->size, pool_type::min_node_size);
+    result.node_share   = share(most_frequent->allocations, profile.allocations);
+    result.node_reserve = with_headroom(most_frequent->peak_live, options);
+    result.node_block_size =
+        round_up(pool_type::min_block_size(result.node_size, result.node_reserve),
+                 options.page_size);
+
+    // a pool collection for the sizes of 99% of the allocations, bigger ones go to the heap,
+    // but at most 4096 bytes, so the pools do not get too big
+    const std::size_t max_collection_size = 4096u;
+    std::size_t       covered = 0u, largest = 0u;
+    for (auto& s : profile.sizes)
+    {
+        if (s.size > max_collection_size || covered * 100u >= profile.allocations * 99u)
+            break;
+        covered += s.allocations;
+        largest = s.size;
+    }
+    result.collection_share = share(covered, profile.allocations);
+
+    // identity buckets if log2 buckets would waste more than an eighth of the memory,
+    // unless there would be too many free lists
+    std::size_t requested = 0u, wasted = 0u;
+    for (auto& s : profile.sizes)
+        if (s.size <= largest)
+        {
+            requested += s.size * s.allocations;
+            wasted += (round_up_pow2(s.size) - s.size) * s.allocations;
+        }
+    result.identity_buckets = profile.exact && largest <= 512u && wasted * 8u > requested;
+    result.max_node_size    = result.identity_buckets ? largest : round_up_pow2(largest);
+
+    std::map<std::size_t, std::size_t> buckets;
+    for (auto& s : profile.sizes)
+        if (s.size != 0u && s.size <= largest)
+        {
+            auto node_size = result.identity_buckets ? s.size : round_up_pow2(s.size);
+            // the peaks of different sizes might not coincide, so this is an upper bound
+            buckets[node_size] += s.peak_live;
+        }
+    std::size_t bucket_bytes = 0u;
+    for (auto& b : buckets)
+    {
+        auto capacity = with_headroom(b.second, options);
+        result.collection_reserve.emplace_back(b.first, capacity);
+        bucket_bytes += std::max(b.first, sizeof(void*)) * capacity;
+    }
+    result.collection_block_size =
+        round_up(stack_type::min_block_size(bucket_bytes), options.page_size);
+
+    // a stack that holds the peak of the live memory without growing,
+    // each allocation might need to be aligned
+    result.stack_size =
+        round_up(stack_type::min_block_size(with_headroom(profile.peak_bytes, options)),
+                 options.page_size);
+
+    // a workload whose memory drops far below the peak benefits from blocks that shrink again
+    result.bursty        = profile.final_bytes * 2u < profile.peak_bytes;
+    result.growth_factor = result.bursty ? 2.f : 1.5f;
+    return result;
+}
+
+void print_share(std::ostream& out, std::size_t per_mille)
+{
+    out << " (" << per_mille / 10u << '.' << per_mille % 10u << "% of the allocations)\n";
+}
+
+void print_recommendation(std::ostream& out, const char* input, const allocation_profile& profile,
+                          const recommendation& result)
+{
+    out << "input:            " << input << " (" << profile.allocations << " allocations, "
+        << profile.sizes.size() << (profile.exact ? " sizes" : " size classes") << ")\n";
+    out << "peak live memory: " << profile.peak_bytes << " bytes\n";
+    out << "growths:          " << profile.growths << '\n';
+    if (profile.sizes.empty())
+    {
+        out << "no allocations to recommend sizes for\n";
+        return;
+    }
+
+    out << '\n' << "memory_pool<node_pool>\n";
+    out << "  node size:      " << result.node_size;
+    print_share(out, result.node_share);
+    out << "  reserve:        " << result.node_reserve << " nodes\n";
+    out << "  block size:     " << result.node_block_size << " bytes\n";
+
+    out << '\n' << "memory_pool_collection\n";
+    out << "  buckets:        "
+        << (result.identity_buckets ? "identity_buckets" : "log2_buckets") << '\n';
+    out << "  max node size:  " << result.max_node_size;
+    print_share(out, result.collection_share);
+    out << "  block size:     " << result.collection_block_size << " bytes\n";
+    for (auto& r : result.collection_reserve)
+        out << "  reserve:        " << r.second << " nodes of " << r.first << " bytes\n";
+
+    out << '\n' << "memory_stack and temporary_stack\n";
+    out << "  initial size:   " << result.stack_size << " bytes\n";
+
+    out << '\n' << "block growth\n";
+    out << "  growth factor:  " << result.growth_factor
+        << (result.bursty ? " (bursty, use an adaptive_block_allocator to shrink again)\n"
+                          : " (steady)\n");
+}
+
+bool write_header(const char* path, const advisor_options& options, const char* input,
+                  const recommendation& result)
+{
+    std::ofstream out(path);
+    if (!out)
+        return false;
+
+    std::string guard;
+    for (auto c : options.name)
+        guard += char(std::toupper(static_cast<unsigned char>(c)));
+    guard += "_HPP_INCLUDED";
+
+    out << "// Generated by " << exe_name << " version " << VERSION << " from " << input
+        << ", do not edit.\n\n";
+    out << "#ifndef " << guard << '\n';
+    out << "#define " << guard << "\n\n";
+    out << "#include <cstddef>\n\n";
+    out << "#include <foonathan/memory/memory_pool_collection.hpp>\n\n";
+    out << "namespace " << options.name << "\n{\n";
+    out << "    // memory_pool<node_pool>(node_pool_node_size, node_pool_block_size)\n";
+    out << "    constexpr std::size_t node_pool_node_size  = " << result.node_size << "u;\n";
+    out << "    constexpr std::size_t node_pool_block_size = " << result.node_block_size
+        << "u;\n";
+    out << "    constexpr std::size_t node_pool_reserve    = " << result.node_reserve << "u;\n\n";
+
+    out << "    // memory_pool_collection<node_pool, collection_buckets>(\n";
+    out << "    //     collection_max_node_size, collection_block_size)\n";
+    out << "    using collection_buckets = foonathan::memory::"
+        << (result.identity_buckets ? "identity_buckets" : "log2_buckets") << ";\n";
+    out << "    constexpr std::size_t collection_max_node_size = " << result.max_node_size
+        << "u;\n";
+    out << "    constexpr std::size_t collection_block_size    = " << result.collection_block_size
+        << "u;\n";
+    out << "    // the node size and capacity for each call to reserve()\n";
+    out << "    constexpr std::size_t collection_reserve[][2] = {\n";
+    for (auto& r : result.collection_reserve)
+        out << "        {" << r.first << "u, " << r.second << "u},\n";
+    if (result.collection_reserve.empty())
+        out << "        {0u, 0u},\n";
+    out << "    };\n\n";
+
+    out << "    // memory_stack<>(stack_initial_size)\n";
+    out << "    // or reserve_temporary_stacks(thread_count, stack_initial_size)\n";
+    out << "    constexpr std::size_t stack_initial_size = " << result.stack_size << "u;\n\n";
+    out << "    // block_growth_policy(std::size_t(-1), growth_factor)\n";
+    out << "    constexpr float growth_factor = " << std::fixed << std::setprecision(1)
+        << result.growth_factor << "f;\n";
+    out << "} // namespace " << options.name << "\n\n";
+    out << "#endif // " << guard << '\n';
+    return bool(out);
+}
+
+void print_help(std::ostream& out)
+{
+    out << "Usage: " << exe_name << " [--version][--help]\n";
+    out << "       " << exe_spaces
+        << " [--headroom percent] [--page-size bytes] [--header file [--namespace name]]\n";
+    out << "       " << exe_spaces << " (--trace tracefile | --statistics statisticsfile)\n";
+    out << "Recommends the constructor parameters of pools and stacks for a recorded workload.\n";
+    out << '\n';
+    out << "   --trace\ta trace written by foonathan::memory::allocation_trace\n";
+    out << "   --statistics\ta snapshot written by foonathan::memory::write_statistics()\n";
+    out << "   --headroom\tthe percentage added to the peaks, default is 25\n";
+    out << "   --page-size\tthe multiple the block sizes are rounded up to, default is 4096\n";
+    out << "   --header\twrite the recommendations as constants to a C++ header\n";
+    out << "   --namespace\tthe namespace of the constants, default is pool_sizes\n";
+    out << "   --help\tdisplay this help and exit\n";
+    out << "   --version\toutput version information and exit\n";
+    out << '\n';
+    out << "A trace gives the exact peak of each size, the statistics only the number of "
+           "allocations per power of two,\n"
+        << "so the peak of each size class is estimated from the peak of the live memory.\n"
+        << "The reserved capacities are upper bounds, the peaks of different sizes might not "
+           "coincide.\n";
+}
+
+void print_version(std::ostream& out)
+{
+    out << exe_name << " version " << VERSION << '\n';
+}
+
+int print_invalid_option(std::ostream& out, const char* option)
+{
+    out << exe_name << ": invalid option -- '";
+    while (*option == '-')
+        ++option;
+    out << option << "'\n";
+    out << "Try '" << exe_name << " --help' for more information.\n";
+    return 2;
+}
+
+int print_invalid_argument(std::ostream& out, const char* option)
+{
+    out << exe_name << ": invalid argument for option -- '" << option << "'\n";
+    out << "Try '" << exe_name << " --help' for more information.\n";
+    return 2;
+}
+
+bool parse_size(const char* str, std::size_t& result)
+{
+    if (!str)
+        return false;
+    char* end;
+    auto  value = std::strtoull(str, &end, 10);
+    if (end == str || *end)
+        return false;
+    result = std::size_t(value);
+    return true;
+}
+
+bool is_identifier(const std::string& str)
+{
+    if (str.empty() || std::isdigit(static_cast<unsigned char>(str[0])))
+        return false;
+    for (auto c : str)
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_')
+            return false;
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc <= 1)
+    {
+        print_help(std::cerr);
+        return 2;
+    }
+    else if (argv[1] == std::string("--help"))
+    {
+        print_help(std::cout);
+        return 0;
+    }
+    else if (argv[1] == std::string("--version"))
+    {
+        print_version(std::cout);
+        return 0;
+    }
+
+    advisor_options options;
+    const char*     trace      = nullptr;
+    const char*     statistics = nullptr;
+    for (auto cur = &argv[1]; *cur; ++cur)
+    {
+        if (*cur == std::string("--trace"))
+        {
+            if (!(trace = *++cur))
+                return print_invalid_argument(std::cerr, "--trace");
+        }
+        else if (*cur == std::string("--statistics"))
+        {
+            if (!(statistics = *++cur))
+                return print_invalid_argument(std::cerr, "--statistics");
+        }
+        else if (*cur == std::string("--headroom"))
+        {
+            if (!parse_size(*++cur, options.headroom))
+                return print_invalid_argument(std::cerr, "--headroom");
+        }
+        else if (*cur == std::string("--page-size"))
+        {
+            if (!parse_size(*++cur, options.page_size) || options.page_size == 0u)
+                return print_invalid_argument(std::cerr, "--page-size");
+        }
+        else if (*cur == std::string("--header"))
+        {
+            if (!(options.header = *++cur))
+                return print_invalid_argument(std::cerr, "--header");
+        }
+        else if (*cur == std::string("--namespace"))
+        {
+            if (!*++cur || !is_identifier(*cur))
+                return print_invalid_argument(std::cerr, "--namespace");
+            options.name = *cur;
+        }
+        else
+            return print_invalid_option(std::cerr, *cur);
+    }
+    if (!trace == !statistics)
+        return print_invalid_argument(std::cerr, trace ? "--statistics" : "--trace");
+
+    allocation_profile profile;
+    auto               input = trace ? trace : statistics;
+    auto               file  = std::fopen(input, trace ? "rb" : "r");
+    if (!file)
+        return print_invalid_argument(std::cerr, trace ? "--trace" : "--statistics");
+    auto valid = true;
+    if (trace)
+    {
+        std::vector<memory::trace_event> events;
+        if (!memory::allocation_trace::read(file, events))
+            std::cerr << exe_name << ": warning: trace file is truncated or invalid\n";
+        profile = profile_trace(events);
+    }
+    else
+    {
+        memory::allocation_statistics_snapshot snapshot;
+        valid   = memory::read_statistics(file, snapshot);
+        profile = profile_statistics(snapshot);
+        if (valid && snapshot.peak_bytes < memory::allocation_statistics::peak_granularity)
+            std::cerr << exe_name << ": warning: the peak is below the granularity of "
+                      << "allocation_statistics and might be too low\n";
+    }
+    std::fclose(file);
+    if (!valid)
+        return print_invalid_argument(std::cerr, "--statistics");
+
+    auto result = recommend(profile, options);
+    print_recommendation(std::cout, input, profile, result);
+    if (options.header && !write_header(options.header, options, input, result))
+    {
+        std::cerr << exe_name << ": cannot write header '" << options.header << "'\n";
+        return 1;
+    }
+}
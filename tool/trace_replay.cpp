@@ -0,0 +1,369 @@
+// Copyright (C) 2015-2023 Jonathan Müller and foonathan/memory contributors
+// SPDX-License-Identifier: Zlib
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <unistd.h>
+#define FOONATHAN_MEMORY_IMPL_HAS_RUSAGE 1
+#endif
+
+#include <foonathan/memory/allocator_traits.hpp>
+#include <foonathan/memory/heap_allocator.hpp>
+#include <foonathan/memory/memory_pool.hpp>
+#include <foonathan/memory/memory_pool_collection.hpp>
+#include <foonathan/memory/namespace_alias.hpp>
+#include <foonathan/memory/new_allocator.hpp>
+#include <foonathan/memory/segregator.hpp>
+#include <foonathan/memory/trace_recorder.hpp>
+
+const char* const exe_name = "trace_replay";
+const std::string exe_spaces(std::strlen(exe_name), ' ');
+
+struct replay_options
+{
+    std::string allocator     = "heap";
+    std::size_t block_size    = 64u * 1024u;
+    std::size_t max_node_size = 256u;
+};
+
+struct replay_result
+{
+    std::size_t allocations = 0u, deallocations = 0u, failures = 0u, unmatched = 0u;
+    std::size_t peak_live = 0u;
+    double      seconds   = 0.0;
+};
+
+// the peak resident set size of the process in bytes, 0 if unknown
+std::size_t peak_rss()
+{
+#if defined(FOONATHAN_MEMORY_IMPL_HAS_RUSAGE)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0u;
+#if defined(__APPLE__)
+    return std::size_t(usage.ru_maxrss);
+#else
+    return std::size_t(usage.ru_maxrss) * 1024u;
+#endif
+#else
+    return 0u;
+#endif
+}
+
+// the current resident set size of the process in bytes, 0 if unknown
+std::size_t current_rss()
+{
+#if defined(__linux__)
+    auto file = std::fopen("/proc/self/statm", "r");
+    if (!file)
+        return 0u;
+    unsigned long size = 0u, resident = 0u;
+    auto          read = std::fscanf(file, "%lu %lu", &size, &resident);
+    std::fclose(file);
+    return read == 2 ? std::size_t(resident) * std::size_t(sysconf(_SC_PAGESIZE)) : 0u;
+#else
+    return 0u;
+#endif
+}
+
+// the index of the matching allocation for each deallocation event,
+// so the replay does not need a lookup that allocates itself
+std::vector<std::size_t> match_events(const std::vector<memory::trace_event>& events)
+{
+    using kind = memory::trace_event_kind;
+
+    std::vector<std::size_t>                       matches(events.size(), std::size_t(-1));
+    std::unordered_map<std::uint64_t, std::size_t> live;
+    for (auto i = std::size_t(0u); i != events.size(); ++i)
+    {
+        auto& event = events[i];
+        if (event.kind == kind::allocate_node || event.kind == kind::allocate_array)
+            live[event.address] = i;
+        else if (event.kind == kind::deallocate_node || event.kind == kind::deallocate_array)
+        {
+            auto iter = live.find(event.address);
+            if (iter != live.end())
+            {
+                matches[i] = iter->second;
+                live.erase(iter);
+            }
+        }
+    }
+    return matches;
+}
+
+// replays the events in order against the allocator,
+// the events of multiple threads are replayed sequentially by the calling thread
+template <class RawAllocator>
+replay_result replay_events(RawAllocator& alloc, const std::vector<memory::trace_event>& events,
+                            const std::vector<std::size_t>& matches)
+{
+    using traits = memory::allocator_traits<RawAllocator>;
+    using clock  = std::chrono::steady_clock;
+    using kind   = memory::trace_event_kind;
+
+    replay_result      result;
+    std::vector<void*> memory(events.size(), nullptr);
+    std::size_t        live_bytes = 0u;
+
+    auto start = clock::now();
+    for (auto i = std::size_t(0u); i != events.size(); ++i)
+    {
+        auto& event = events[i];
+        auto  bytes = std::size_t(event.size) * event.count;
+        if (event.kind == kind::allocate_node || event.kind == kind::allocate_array)
+        {
+            ++result.allocations;
+            try
+            {
+                memory[i] = event.kind == kind::allocate_node
+                                ? traits::allocate_node(alloc, std::size_t(event.size),
+                                                        event.alignment())
+                                : traits::allocate_array(alloc, event.count,
+                                                         std::size_t(event.size),
+                                                         event.alignment());
+                live_bytes += bytes;
+                if (live_bytes > result.peak_live)
+                    result.peak_live = live_bytes;
+            }
+            catch (std::bad_alloc&)
+            {
+                ++result.failures;
+            }
+        }
+        else if (event.kind == kind::deallocate_node || event.kind == kind::deallocate_array)
+        {
+            ++result.deallocations;
+            auto ptr = matches[i] == std::size_t(-1) ? nullptr : memory[matches[i]];
+            if (!ptr)
+            {
+                // allocated before the recording started or the allocation failed
+                ++result.unmatched;
+                continue;
+            }
+
+            if (event.kind == kind::deallocate_node)
+                traits::deallocate_node(alloc, ptr, std::size_t(event.size), event.alignment());
+            else
+                traits::deallocate_array(alloc, ptr, event.count, std::size_t(event.size),
+                                         event.alignment());
+            live_bytes -= bytes;
+        }
+        // growth and shrinking is done by the replayed allocator itself
+    }
+    result.seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    // the memory that was still allocated at the end of the trace is leaked,
+    // the allocator might not support deallocation in arbitrary order
+    return result;
+}
+
+replay_result replay(const replay_options& options, const std::vector<memory::trace_event>& events,
+                     const std::vector<std::size_t>& matches)
+{
+    using namespace memory;
+    if (options.allocator == "heap")
+    {
+        heap_allocator alloc;
+        return replay_events(alloc, events, matches);
+    }
+    else if (options.allocator == "new")
+    {
+        new_allocator alloc;
+        return replay_events(alloc, events, matches);
+    }
+    else if (options.allocator == "pool")
+    {
+        auto alloc = make_segregator(threshold(options.max_node_size,
+                                               memory_pool_collection<node_pool, log2_buckets>(
+                                                   options.max_node_size, options.block_size)),
+                                     heap_allocator{});
+        return replay_events(alloc, events, matches);
+    }
+    else if (options.allocator == "segregator")
+    {
+        auto alloc =
+            make_segregator(threshold(8u, memory_pool<small_node_pool>(8u, options.block_size)),
+                            threshold(options.max_node_size,
+                                      memory_pool_collection<node_pool, identity_buckets>(
+                                          options.max_node_size, options.block_size)),
+                            heap_allocator{});
+        return replay_events(alloc, events, matches);
+    }
+    else
+        std::abort();
+}
+
+void print_result(std::ostream& out, const replay_options& options, const replay_result& result,
+                  std::size_t rss_before, std::size_t rss_after)
+{
+    auto operations = result.allocations + result.deallocations;
+    out << "allocator:        " << options.allocator << '\n';
+    out << "operations:       " << operations << " (" << result.allocations << " allocations, "
+        << result.deallocations << " deallocations)\n";
+    out << "failures:         " << result.failures << '\n';
+    out << "unmatched:        " << result.unmatched << '\n';
+    out << "time:             " << std::fixed << std::setprecision(3) << result.seconds * 1000.0
+        << " ms\n";
+    if (result.seconds > 0.0)
+        out << "throughput:       " << std::setprecision(3)
+            << double(operations) / result.seconds / 1e6 << " Mops/s\n";
+    out << "peak live memory: " << result.peak_live << " bytes\n";
+    if (rss_after == 0u)
+    {
+        out << "peak RSS:         unknown\n";
+        return;
+    }
+
+    auto growth = rss_after > rss_before ? rss_after - rss_before : 0u;
+    out << "peak RSS:         " << rss_after / 1024u << " KiB (+" << growth / 1024u
+        << " KiB during replay)\n";
+    // the growth can be smaller than the live memory if memory freed before the replay is reused
+    if (growth > 0u)
+        out << "fragmentation:    " << std::setprecision(1)
+            << (growth > result.peak_live
+                    ? 100.0 * (1.0 - double(result.peak_live) / double(growth))
+                    : 0.0)
+            << "%\n";
+}
+
+void print_help(std::ostream& out)
+{
+    out << "Usage: " << exe_name << " [--version][--help]\n";
+    out << "       " << exe_spaces
+        << " [--allocator name] [--block-size bytes] [--max-node-size bytes] tracefile\n";
+    out << "Replays an allocation trace written by foonathan::memory::allocation_trace.\n";
+    out << '\n';
+    out << "   --allocator\tthe allocator to replay against, one of:\n";
+    out << "              \t  heap        heap_allocator (the default)\n";
+    out << "              \t  new         new_allocator\n";
+    out << "              \t  pool        memory_pool_collection with log2_buckets, heap_allocator "
+           "above the maximum node size\n";
+    out << "              \t  segregator  memory_pool for nodes up to 8 bytes, "
+           "memory_pool_collection with identity_buckets, heap_allocator\n";
+    out << "   --block-size\tthe block size of the pools, default is 65536\n";
+    out << "   --max-node-size\tthe maximum node size of the pool collections, default is 256\n";
+    out << "   --help\tdisplay this help and exit\n";
+    out << "   --version\toutput version information and exit\n";
+    out << '\n';
+    out << "The events of all threads are replayed in order by a single thread.\n"
+        << "The fragmentation is the part of the growth of the peak resident set size "
+           "that is not covered by the peak live memory,\n"
+        << "so only one allocator is replayed per invocation.\n";
+}
+
+void print_version(std::ostream& out)
+{
+    out << exe_name << " version " << VERSION << '\n';
+}
+
+int print_invalid_option(std::ostream& out, const char* option)
+{
+    out << exe_name << ": invalid option -- '";
+    while (*option == '-')
+        ++option;
+    out << option << "'\n";
+    out << "Try '" << exe_name << " --help' for more information.\n";
+    return 2;
+}
+
+int print_invalid_argument(std::ostream& out, const char* option)
+{
+    out << exe_name << ": invalid argument for option -- '" << option << "'\n";
+    out << "Try '" << exe_name << " --help' for more information.\n";
+    return 2;
+}
+
+bool parse_size(const char* str, std::size_t& result)
+{
+    if (!str)
+        return false;
+    char* end;
+    auto  value = std::strtoull(str, &end, 10);
+    if (end == str || *end || value == 0u)
+        return false;
+    result = std::size_t(value);
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc <= 1)
+    {
+        print_help(std::cerr);
+        return 2;
+    }
+    else if (argv[1] == std::string("--help"))
+    {
+        print_help(std::cout);
+        return 0;
+    }
+    else if (argv[1] == std::string("--version"))
+    {
+        print_version(std::cout);
+        return 0;
+    }
+
+    replay_options options;
+    const char*    path = nullptr;
+    for (auto cur = &argv[1]; *cur; ++cur)
+    {
+        if (*cur == std::string("--allocator"))
+        {
+            ++cur;
+            if (!*cur
+                || (*cur != std::string("heap") && *cur != std::string("new")
+                    && *cur != std::string("pool") && *cur != std::string("segregator")))
+                return print_invalid_argument(std::cerr, "--allocator");
+            options.allocator = *cur;
+        }
+        else if (*cur == std::string("--block-size"))
+        {
+            if (!parse_size(*++cur, options.block_size))
+                return print_invalid_argument(std::cerr, "--block-size");
+        }
+        else if (*cur == std::string("--max-node-size"))
+        {
+            if (!parse_size(*++cur, options.max_node_size))
+                return print_invalid_argument(std::cerr, "--max-node-size");
+        }
+        else if (cur[0][0] == '-' || path)
+            return print_invalid_option(std::cerr, *cur);
+        else
+            path = *cur;
+    }
+    if (!path)
+        return print_invalid_argument(std::cerr, "tracefile");
+
+    std::vector<memory::trace_event> events;
+    auto                             file = std::fopen(path, "rb");
+    if (!file)
+        return print_invalid_argument(std::cerr, "tracefile");
+    auto complete = memory::allocation_trace::read(file, events);
+    std::fclose(file);
+    if (!complete)
+        std::cerr << exe_name << ": warning: trace file is truncated or invalid\n";
+
+    // failures are counted instead
+    memory::out_of_memory::set_handler([](const memory::allocator_info&, std::size_t) {});
+    memory::bad_allocation_size::set_handler(
+        [](const memory::allocator_info&, std::size_t, std::size_t) {});
+
+    auto matches = match_events(events);
+    // the peak so far might be higher than the current usage, e.g. because of the matching
+    auto rss_before = current_rss();
+    if (rss_before == 0u)
+        rss_before = peak_rss();
+    auto result = replay(options, events, matches);
+    print_result(std::cout, options, result, rss_before, peak_rss());
+}